@@ -0,0 +1,89 @@
+#ifndef ALLOC_GUARD_H
+#define ALLOC_GUARD_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/**
+ * Steady-state allocation guard for AI Teddy Bear ESP32 (debug builds)
+ *
+ * Once streaming has run for ALLOC_GUARD_WARMUP_MS (arenas sized, pools
+ * warm), the capture, streamer and network paths are expected to stop
+ * touching the heap. The guard wraps malloc/calloc/realloc at link time
+ * (-Wl,--wrap) and, while armed, records every allocation made from a
+ * watched context: a whole task (allocGuardWatchTask) or a section of a
+ * shared task (AllocGuardScope). Each distinct call stack is kept once with
+ * its hit count and bytes; handleAllocGuard() prints new ones as
+ * "Backtrace:" lines that the esp32_exception_decoder monitor filter
+ * resolves to file:line.
+ *
+ * Enabled with -DALLOC_GUARD_ENABLED=1 plus the wrap flags (see the
+ * esp32dev-local environment); otherwise every call compiles to nothing.
+ */
+
+#ifndef ALLOC_GUARD_ENABLED
+#define ALLOC_GUARD_ENABLED 0
+#endif
+
+// Guard configuration
+#define ALLOC_GUARD_WARMUP_MS       2000   // Streaming time before the guard arms
+#define ALLOC_GUARD_MAX_CONTEXTS    6      // Watched tasks plus active scopes
+#define ALLOC_GUARD_MAX_SITES       16     // Distinct offending call stacks kept
+#define ALLOC_GUARD_STACK_DEPTH     4      // Frames recorded per site
+#define ALLOC_GUARD_REPORT_INTERVAL 5000   // Minimum spacing of violation prints (ms)
+
+struct AllocGuardSite {
+  uint32_t pcs[ALLOC_GUARD_STACK_DEPTH];
+  const char* context;    // Watched task or scope label
+  uint32_t count;
+  uint32_t bytes;
+  bool reported;
+};
+
+#if ALLOC_GUARD_ENABLED
+
+bool initAllocGuard();
+void handleAllocGuard();
+
+// Arm after the warm-up when streaming starts; disarm when it stops
+void armAllocGuard(uint32_t warmupMs = ALLOC_GUARD_WARMUP_MS);
+void disarmAllocGuard();
+bool isAllocGuardArmed();
+
+// Watch the calling task for its lifetime (dedicated hot-path tasks)
+void allocGuardWatchTask(const char* label);
+void allocGuardUnwatchTask();
+
+uint32_t getAllocGuardViolations();
+void printAllocGuardReport();
+
+// Watches the calling task while in scope (hot sections of shared tasks)
+class AllocGuardScope {
+public:
+  explicit AllocGuardScope(const char* label);
+  ~AllocGuardScope();
+private:
+  bool entered;
+};
+
+#else
+
+inline bool initAllocGuard() { return true; }
+inline void handleAllocGuard() {}
+inline void armAllocGuard(uint32_t = ALLOC_GUARD_WARMUP_MS) {}
+inline void disarmAllocGuard() {}
+inline bool isAllocGuardArmed() { return false; }
+inline void allocGuardWatchTask(const char*) {}
+inline void allocGuardUnwatchTask() {}
+inline uint32_t getAllocGuardViolations() { return 0; }
+inline void printAllocGuardReport() {}
+
+class AllocGuardScope {
+public:
+  explicit AllocGuardScope(const char*) {}
+};
+
+#endif // ALLOC_GUARD_ENABLED
+
+#endif // ALLOC_GUARD_H
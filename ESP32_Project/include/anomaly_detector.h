@@ -0,0 +1,149 @@
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+#include <Arduino.h>
+
+/**
+ * Streaming anomaly detection for AI Teddy Bear ESP32
+ *
+ * Fixed thresholds (RSSI bands, heap floor, connection score cutoffs) only
+ * fire once something has already failed. These detectors learn each
+ * signal's own baseline and flag departures from it early:
+ *
+ *   EWMA      exponentially weighted mean and variance. A sample more than
+ *             ANOMALY_Z_NOTICE standard deviations on the bad side is an
+ *             outlier (NOTICE).
+ *   CUSUM     one-sided cumulative sum of the standardized residuals minus
+ *             a slack of ANOMALY_CUSUM_SLACK. A small but persistent shift
+ *             accumulates to WARNING, then CRITICAL.
+ *   Slope     least-squares line through the last ANOMALY_HEAP_WINDOW heap
+ *             samples. A decline of at least ANOMALY_HEAP_LEAK_WARNING that
+ *             is ANOMALY_HEAP_MIN_T standard errors below zero is a leak
+ *             (WARNING); one that reaches MEM_BUDGET_FREE_CRITICAL within
+ *             ANOMALY_HEAP_CRITICAL_HORIZON is CRITICAL.
+ *
+ * Latency signals are the per-second p50 of the registry histograms, read
+ * with getHistogramWindow(); seconds without observations are skipped.
+ * Residuals are clipped to ANOMALY_Z_CLIP before they reach the CUSUM or
+ * the baseline, so a single spike cannot raise an alarm or drag the
+ * baseline along.
+ *
+ * Each rise in a signal's severity is published as EVENT_HEALTH_ANOMALY;
+ * the WebSocket handler reacts with a chunk downshift, an early reconnect
+ * while idle, or an arena flush. scripts/anomaly_eval.py replays recorded
+ * and synthetic traces through the same detectors and parameters.
+ */
+
+// Sampling
+#define ANOMALY_SAMPLE_INTERVAL       1000    // ms
+#define ANOMALY_HEAP_SAMPLE_INTERVAL  30000   // ms, max free heap of each interval
+
+// EWMA baseline
+#define ANOMALY_EWMA_ALPHA            0.05f   // ~20-sample memory
+#define ANOMALY_WARMUP_SAMPLES        30      // Baseline samples before scoring
+#define ANOMALY_Z_NOTICE              4.0f
+#define ANOMALY_Z_CLIP                4.0f    // Residual limit for CUSUM and baseline
+#define ANOMALY_NOTICE_HOLD           60000   // Minimum spacing of NOTICEs per signal (ms)
+
+// CUSUM (in standard deviations)
+#define ANOMALY_CUSUM_SLACK           0.5f    // k: shifts below 1 sigma are ignored
+#define ANOMALY_CUSUM_WARNING         8.0f    // h
+#define ANOMALY_CUSUM_CRITICAL        16.0f
+
+// Heap slope
+#define ANOMALY_HEAP_WINDOW           60      // Samples (30 minutes)
+#define ANOMALY_HEAP_LEAK_WARNING     4096    // Bytes lost per hour
+#define ANOMALY_HEAP_MIN_T            4.0f    // Slope / standard error needed to call a trend
+#define ANOMALY_HEAP_CRITICAL_HORIZON 7200    // Seconds until the critical floor
+
+// Actions
+#define ANOMALY_RECONNECT_COOLDOWN    300000  // Between proactive reconnects (ms)
+
+enum AnomalySignal {
+  ANOMALY_SIGNAL_WS_RTT,          // ms
+  ANOMALY_SIGNAL_WS_SEND,         // us per audio chunk
+  ANOMALY_SIGNAL_AUDIO_LATENCY,   // ms
+  ANOMALY_SIGNAL_WIFI_RSSI,       // dBm
+  ANOMALY_SIGNAL_HEAP,            // bytes
+  ANOMALY_SIGNAL_COUNT
+};
+
+enum AnomalyDetectorKind {
+  ANOMALY_DETECTOR_EWMA,
+  ANOMALY_DETECTOR_CUSUM,
+  ANOMALY_DETECTOR_SLOPE
+};
+
+enum AnomalySeverity {
+  ANOMALY_NONE,
+  ANOMALY_NOTICE,
+  ANOMALY_WARNING,
+  ANOMALY_CRITICAL
+};
+
+// Mean and variance with exponential forgetting
+class EwmaDetector {
+public:
+  EwmaDetector(float alpha, float minSigma);
+
+  // Residual of x against the baseline before x, in sigmas (positive = worse)
+  float score(float x) const;
+  // Updates the baseline with x, limited to ANOMALY_Z_CLIP sigmas from it
+  void update(float x);
+  void reset();
+
+  bool warmedUp() const { return samples >= ANOMALY_WARMUP_SAMPLES; }
+  float mean() const { return average; }
+  float sigma() const;
+
+private:
+  float alpha;
+  float minSigma;
+  float average;
+  float variance;
+  uint32_t samples;
+};
+
+// One-sided CUSUM over standardized residuals
+class CusumDetector {
+public:
+  CusumDetector() : sum(0.0f) {}
+
+  float update(float z);
+  void reset() { sum = 0.0f; }
+  float value() const { return sum; }
+
+private:
+  float sum;
+};
+
+// Least-squares trend over a sliding window of equally spaced samples
+class SlopeDetector {
+public:
+  SlopeDetector() : head(0), count(0) {}
+
+  void add(float value);
+  bool full() const { return count == ANOMALY_HEAP_WINDOW; }
+  // Slope per sample and its t statistic (slope / standard error); false until 3 samples
+  bool fit(float& slope, float& t) const;
+  void reset() { head = 0; count = 0; }
+
+private:
+  float values[ANOMALY_HEAP_WINDOW];
+  uint16_t head;
+  uint16_t count;
+};
+
+// Lifecycle (main loop)
+bool initAnomalyDetection();
+void handleAnomalyDetection();
+
+// State
+AnomalySeverity getAnomalySeverity(AnomalySignal signal);
+const char* getAnomalySignalName(AnomalySignal signal);
+const char* getAnomalySeverityName(AnomalySeverity severity);
+const char* getAnomalyDetectorName(AnomalyDetectorKind detector);
+float getHeapSlopePerHour();
+void printAnomalyStatus();
+
+#endif // ANOMALY_DETECTOR_H
@@ -0,0 +1,96 @@
+#ifndef AUDIO_FRAME_H
+#define AUDIO_FRAME_H
+
+#include <Arduino.h>
+#include <atomic>
+
+/**
+ * Refcounted audio frames for AI Teddy Bear ESP32
+ *
+ * An AudioFrame is a handle to one pooled buffer. Copying the handle shares
+ * the buffer (capture, DSP, taps and transport all see the same bytes);
+ * the buffer returns to the pool when the last handle goes away.
+ *
+ * Writes are copy-on-write: mutableData() clones the buffer first if any
+ * other handle still refers to it, so a consumer holding a frame never sees
+ * it change underneath. A frame owned by a single handle is written in place.
+ *
+ * Each buffer reserves headroom in front of the payload so a transport can
+ * add its framing without moving the payload: a text frame allocated with
+ * AUDIO_FRAME_WS_HEADROOM is sent with sendTXT(..., headerToPayload = true)
+ * and the WebSocket header is written into the headroom.
+ *
+ * The stats count bytes copied per second of captured audio, including the
+ * copies that remain outside the frame (ring buffers, base64).
+ */
+
+#define AUDIO_FRAME_WS_HEADROOM        14              // WEBSOCKETS_MAX_HEADER_SIZE
+#define AUDIO_FRAME_BYTES_PER_SECOND   (16000 * 2)     // PCM s16le mono at 16 kHz
+
+struct AudioFrameBuffer {
+  std::atomic<uint16_t> refs;
+  uint16_t headroom;
+  uint32_t capacity;      // Payload bytes available after the headroom
+  uint32_t length;        // Payload bytes in use
+
+  uint8_t* payload() { return reinterpret_cast<uint8_t*>(this + 1) + headroom; }
+};
+
+class AudioFrame {
+public:
+  AudioFrame() : buffer(nullptr) {}
+  AudioFrame(const AudioFrame& other);
+  AudioFrame(AudioFrame&& other) : buffer(other.buffer) { other.buffer = nullptr; }
+  ~AudioFrame() { release(); }
+
+  AudioFrame& operator=(const AudioFrame& other);
+  AudioFrame& operator=(AudioFrame&& other);
+
+  // Pooled buffer with room for capacity payload bytes; invalid on failure
+  static AudioFrame allocate(size_t capacity, size_t headroom = 0);
+
+  bool isValid() const { return buffer != nullptr; }
+  explicit operator bool() const { return isValid(); }
+  bool isShared() const { return buffer && buffer->refs.load() > 1; }
+
+  const uint8_t* data() const { return buffer ? buffer->payload() : nullptr; }
+  size_t length() const { return buffer ? buffer->length : 0; }
+  size_t capacity() const { return buffer ? buffer->capacity : 0; }
+  size_t headroom() const { return buffer ? buffer->headroom : 0; }
+
+  // Copy-on-write access; nullptr if a needed clone could not be allocated
+  uint8_t* mutableData();
+  uint8_t* mutableHeadroom();   // Start of the headroom (transport framing)
+  bool setLength(size_t length);
+
+  void release();
+
+  // Raw handoff through fixed-size carriers (event queues): detach() gives up
+  // the handle without dropping its reference, adopt() takes one over
+  AudioFrameBuffer* detach();
+  static AudioFrame adopt(AudioFrameBuffer* buffer) { return AudioFrame(buffer); }
+
+private:
+  explicit AudioFrame(AudioFrameBuffer* b) : buffer(b) {}
+  bool makeExclusive();
+
+  AudioFrameBuffer* buffer;
+};
+
+struct AudioFrameStats {
+  uint32_t allocated;
+  uint32_t allocFailures;
+  uint32_t shares;          // Handle copies that avoided a buffer copy
+  uint32_t cowCopies;
+  uint32_t bytesCopied;     // Clones plus noted copies
+  uint32_t bytesCaptured;   // PCM bytes that entered the pipeline
+};
+
+// Copy accounting for paths that still copy outside a frame
+void noteAudioCopy(size_t bytes);
+void noteAudioCaptured(size_t bytes);
+
+AudioFrameStats getAudioFrameStats();
+void printAudioFrameStats();
+
+#endif // AUDIO_FRAME_H
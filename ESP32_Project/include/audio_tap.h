@@ -0,0 +1,91 @@
+#ifndef AUDIO_TAP_H
+#define AUDIO_TAP_H
+
+#include <Arduino.h>
+#include "feature_config.h"
+
+/**
+ * Audio pipeline debug taps for AI Teddy Bear ESP32 (debug builds)
+ *
+ * Named tap points mirror 16-bit mono PCM from a pipeline stage into a ring
+ * that keeps the most recent audio of that stage:
+ *
+ *   capture    adc_capture_task output, as published to the WebSocket task
+ *   send       chunks the WebSocket task got onto the socket; gaps against
+ *              capture are frames dropped in the queue or by a failed send
+ *   playback   server audio handed to playAudioResponse()
+ *
+ * Taps are armed at runtime (console "tap on ...", enableAudioTaps()). Arming
+ * splits AUDIO_TAP_BUDGET_BYTES between the chosen taps; disarming frees it.
+ * A disarmed tap costs the stage one load and branch (audioTapEnabled), and
+ * with FEATURE_AUDIO_TAPS off every call compiles to nothing.
+ *
+ * A tap is exported as a WAV file whose LIST/INFO comment carries the stage
+ * metadata ("tap=send stage=1 rate=16000 total=... end_us=..."): streamed
+ * by /debug/tap?name=... or saved to SPIFFS as /tap_<name>.wav. The tap is
+ * paused while it is read, so the export is one consistent snapshot.
+ * scripts/tap_diff.py aligns two exports and reports gain, lag, clipping and
+ * where they diverge.
+ */
+
+// Tap configuration
+#define AUDIO_TAP_BUDGET_BYTES    (48 * 1024)   // Shared by all armed taps
+#define AUDIO_TAP_MIN_BYTES       (4 * 1024)    // Per tap, or arming fails
+#define AUDIO_TAP_SAMPLE_RATE     16000
+#define AUDIO_TAP_FILE_PREFIX     "/tap_"
+#define AUDIO_TAP_READ_SAMPLES    256           // Samples per export write
+
+enum AudioTapPoint {
+  AUDIO_TAP_CAPTURE,
+  AUDIO_TAP_SEND,
+  AUDIO_TAP_PLAYBACK,
+  AUDIO_TAP_COUNT
+};
+
+#define AUDIO_TAP_ALL ((1u << AUDIO_TAP_COUNT) - 1)
+
+struct AudioTapInfo {
+  const char* name;
+  bool armed;
+  uint32_t capacity;     // Samples the ring holds
+  uint32_t total;        // Samples written since arming
+  uint32_t endUs;        // micros() at the newest sample
+};
+
+// Receives the exported WAV piece by piece; returns false to abort
+typedef bool (*AudioTapSink)(void* context, const uint8_t* data, size_t length);
+
+#if FEATURE_AUDIO_TAPS
+
+extern volatile uint32_t audioTapMask;
+
+inline bool audioTapEnabled(AudioTapPoint tap) { return (audioTapMask & (1u << tap)) != 0; }
+
+// Copies bytes of s16le PCM into the tap's ring (stage side)
+void audioTapWrite(AudioTapPoint tap, const void* pcm, size_t bytes);
+
+// Arms exactly the taps in mask (0 disarms all); false if the budget cannot be allocated
+bool enableAudioTaps(uint32_t mask);
+uint32_t getEnabledAudioTaps();
+bool findAudioTap(const char* name, AudioTapPoint& tap);
+const char* getAudioTapName(AudioTapPoint tap);
+AudioTapInfo getAudioTapInfo(AudioTapPoint tap);
+
+// Export the ring as WAV
+bool exportAudioTap(AudioTapPoint tap, AudioTapSink sink, void* context);
+bool saveAudioTap(AudioTapPoint tap);
+
+#else
+
+inline bool audioTapEnabled(AudioTapPoint) { return false; }
+inline void audioTapWrite(AudioTapPoint, const void*, size_t) {}
+inline bool enableAudioTaps(uint32_t) { return false; }
+inline uint32_t getEnabledAudioTaps() { return 0; }
+
+#endif // FEATURE_AUDIO_TAPS
+
+// Stage-side hook: nothing but the mask test unless the tap is armed
+#define AUDIO_TAP(tap, pcm, bytes) \
+  do { if (audioTapEnabled(tap)) audioTapWrite((tap), (pcm), (bytes)); } while (0)
+
+#endif // AUDIO_TAP_H
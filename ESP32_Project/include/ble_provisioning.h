@@ -21,13 +21,14 @@
 #include <stddef.h>
 #include "esp_err.h"
 #include "esp_gatt_defs.h"
+#include "ble_transport.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 // Constants
-#define BLE_MAX_PAYLOAD_SIZE        512     // Maximum encrypted payload size
+#define BLE_MAX_PAYLOAD_SIZE        512     // Maximum encrypted payload size (single packet; larger messages use ble_transport.h)
 #define BLE_MAX_RESPONSE_SIZE       64      // Maximum response size
 #define BLE_MTU_SIZE               247      // Minimum MTU for 512-byte payloads
 #define BLE_PROVISIONING_TIMEOUT_MS (10 * 60 * 1000)  // 10 minutes
@@ -110,6 +111,29 @@ bool startBLEProvisioning(const uint8_t* pop_key, size_t key_len,
  */
 void handleBLEProvisioningData(uint8_t* data, size_t length);
 
+/**
+ * Attach a GATT Link
+ * Called by the GATT layer once the ATT MTU exchange is done. Messages are
+ * sealed with the PoP key and carried by ble_transport: notifications go out
+ * through send_frame, written frames come in by handleBLEProvisioningData().
+ *
+ * @param send_frame Queues one notification, false when the stack is full
+ * @param context Passed to send_frame
+ * @param att_mtu Negotiated ATT MTU
+ */
+void connectBLEProvisioning(ble_transport_send_frame_t send_frame, void* context, uint16_t att_mtu);
+
+/**
+ * Detach the GATT Link (client disconnected)
+ */
+void disconnectBLEProvisioning(void);
+
+/**
+ * Run Provisioning Timers
+ * Transport retransmits and the provisioning timeout; call from the loop
+ */
+void handleBLEProvisioning(void);
+
 /**
  * Decrypt BLE Provisioning Payload
  * Decrypts AES-256-GCM encrypted JSON payload
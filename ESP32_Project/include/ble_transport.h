@@ -0,0 +1,261 @@
+/*
+ * BLE Provisioning Transport for AI Teddy Bear ESP32
+ * Windowed fragmentation and reassembly over GATT write/notify
+ *
+ * Features:
+ * - Messages up to BLE_TRANSPORT_MAX_MESSAGE bytes (certificates, tokens,
+ *   config blobs) split into sequenced fragments sized to the ATT MTU
+ * - Sliding window of unacknowledged fragments (write without response),
+ *   selective acknowledgement and selective retransmit
+ * - HELLO exchange of ATT MTU, receive window and session nonce
+ * - Reassembly into pooled message buffers
+ * - One AES-256-GCM seal per message instead of per packet
+ * - Replay protection: a message is accepted once, in counter order
+ *
+ * Frames (all integers little endian):
+ *   HELLO  type, version, ATT MTU (u16), window, flags, session nonce (8)
+ *   DATA   type, message id, sequence (u16, top bit on the last fragment),
+ *          message length (u16), bytes
+ *   ACK    type, message id, next missing sequence (u16),
+ *          bitmap (u32) - bit i set when sequence next + 1 + i arrived
+ *   NAK    type, message id, reason
+ *
+ * A message is nonce (12) | tag (16) | ciphertext, the ble_packet_t layout
+ * of ble_provisioning.h, sealed with the PoP key. Each side draws a fresh
+ * session nonce on connect and numbers its messages with a 32-bit counter
+ * from 1; the GCM nonce is the sender's session nonce and the counter, so it
+ * never repeats under the key. The additional data binds the direction, both
+ * session nonces and the counter: a message from another connection or the
+ * other direction fails authentication, and one whose counter is not above
+ * the last accepted is refused as a replay. The message id in the frames is
+ * the counter's low byte and only tells fragments of neighbouring messages
+ * apart. Messages can be sent once the peer's HELLO has arrived.
+ *
+ * The GATT link delivers in order, so a fragment still missing when a
+ * later one is acknowledged was dropped and is resent at once; only a lost
+ * acknowledgement waits for BLE_TRANSPORT_RTO_MS.
+ */
+
+#ifndef BLE_TRANSPORT_H
+#define BLE_TRANSPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Constants
+#define BLE_TRANSPORT_VERSION          2
+#define BLE_TRANSPORT_MAX_MESSAGE      4096    // Sealed message bytes (nonce + tag + ciphertext)
+#define BLE_TRANSPORT_KEY_SIZE         32      // AES-256 PoP key
+#define BLE_TRANSPORT_NONCE_SIZE       12
+#define BLE_TRANSPORT_TAG_SIZE         16
+#define BLE_TRANSPORT_SESSION_SIZE     8       // Session nonce, the first 8 bytes of every GCM nonce
+#define BLE_TRANSPORT_DEFAULT_MTU      23      // ATT default before the MTU exchange
+#define BLE_TRANSPORT_MAX_MTU          517
+#define BLE_TRANSPORT_ATT_OVERHEAD     3       // Opcode and handle
+#define BLE_TRANSPORT_DATA_HEADER      6
+#define BLE_TRANSPORT_WINDOW           16      // Fragments in flight, at most BLE_TRANSPORT_MAX_WINDOW
+#define BLE_TRANSPORT_MAX_WINDOW       24      // Below the 32 send slots, so slots never alias
+#define BLE_TRANSPORT_DEFAULT_WINDOW   4       // Until the peer's HELLO arrives
+#define BLE_TRANSPORT_ACK_EVERY        4       // In-order fragments per ACK
+#define BLE_TRANSPORT_ACK_DELAY_MS     20      // ACK a partial run after this long
+#define BLE_TRANSPORT_RTO_MS           300     // Resend the oldest fragment without an ACK
+#define BLE_TRANSPORT_MAX_RETRIES      8       // Timeouts without progress before a send fails
+
+#define BLE_TRANSPORT_MAX_PLAINTEXT \
+    (BLE_TRANSPORT_MAX_MESSAGE - BLE_TRANSPORT_NONCE_SIZE - BLE_TRANSPORT_TAG_SIZE)
+#define BLE_TRANSPORT_MAX_FRAGMENTS \
+    ((BLE_TRANSPORT_MAX_MESSAGE + BLE_TRANSPORT_DEFAULT_MTU - BLE_TRANSPORT_ATT_OVERHEAD - \
+      BLE_TRANSPORT_DATA_HEADER - 1) / \
+     (BLE_TRANSPORT_DEFAULT_MTU - BLE_TRANSPORT_ATT_OVERHEAD - BLE_TRANSPORT_DATA_HEADER))
+#define BLE_TRANSPORT_BITMAP_WORDS     ((BLE_TRANSPORT_MAX_FRAGMENTS + 31) / 32)
+#define BLE_TRANSPORT_SEND_SLOTS       32
+
+// Message buffers shared by all endpoints: one receive and one send at a time
+#ifndef BLE_TRANSPORT_POOL_BUFFERS
+#define BLE_TRANSPORT_POOL_BUFFERS     2
+#endif
+
+// NAK reasons
+typedef enum {
+    BLE_TRANSPORT_NAK_TOO_LARGE = 1,    // Longer than BLE_TRANSPORT_MAX_MESSAGE
+    BLE_TRANSPORT_NAK_NO_BUFFER,        // Message pool exhausted
+    BLE_TRANSPORT_NAK_AUTH_FAILED,      // GCM tag did not verify
+    BLE_TRANSPORT_NAK_REPLAY            // Counter not above the last accepted message
+} ble_transport_nak_t;
+
+typedef enum {
+    BLE_TRANSPORT_ROLE_DEVICE = 0,      // GATT server, sends by notify
+    BLE_TRANSPORT_ROLE_APP              // GATT client, sends by write without response
+} ble_transport_role_t;
+
+// Queues one frame (at most ATT MTU - 3 bytes) on the link; false when the
+// stack's queue is full, and the frame is offered again later
+typedef bool (*ble_transport_send_frame_t)(void* context, const uint8_t* frame, size_t length);
+
+// A complete, authenticated message. The data is valid during the call only.
+typedef void (*ble_transport_message_t)(void* context, const uint8_t* data, size_t length);
+
+// The message passed to ble_transport_send() was acknowledged, or given up
+typedef void (*ble_transport_sent_t)(void* context, bool delivered);
+
+typedef struct {
+    ble_transport_role_t role;
+    uint8_t key[BLE_TRANSPORT_KEY_SIZE];
+    ble_transport_send_frame_t send_frame;
+    ble_transport_message_t on_message;
+    ble_transport_sent_t on_sent;       // Optional
+    void* context;
+} ble_transport_config_t;
+
+typedef struct {
+    uint32_t frames_sent;
+    uint32_t frames_received;
+    uint32_t retransmits;
+    uint32_t acks_sent;
+    uint32_t invalid_frames;
+    uint32_t messages_sent;
+    uint32_t messages_received;
+    uint32_t send_failures;             // Messages given up or refused by the peer
+    uint32_t auth_failures;
+    uint32_t replays;                   // Authentic messages refused for an old counter
+} ble_transport_stats_t;
+
+// One endpoint of the link. Fields are private to ble_transport.cpp.
+typedef struct {
+    ble_transport_config_t config;
+    ble_transport_stats_t stats;
+    uint8_t frame[BLE_TRANSPORT_MAX_MTU - BLE_TRANSPORT_ATT_OVERHEAD];
+
+    // Link parameters
+    uint8_t session[BLE_TRANSPORT_SESSION_SIZE];        // Ours, drawn on connect
+    uint8_t peer_session[BLE_TRANSPORT_SESSION_SIZE];   // From the peer's HELLO
+    uint16_t local_mtu;
+    uint16_t peer_mtu;
+    uint8_t peer_window;
+    bool hello_pending;                 // Peer's HELLO not seen yet
+    uint8_t hello_retries;
+    uint32_t hello_sent_at;
+
+    // Receive
+    uint8_t* rx_buffer;
+    uint8_t rx_message;
+    uint16_t rx_length;
+    uint16_t rx_fragment;
+    uint16_t rx_count;
+    uint16_t rx_next;                   // First missing fragment
+    uint32_t rx_have[BLE_TRANSPORT_BITMAP_WORDS];
+    uint8_t rx_since_ack;
+    bool rx_gap_reported;
+    bool rx_ack_due;
+    uint32_t rx_ack_at;
+    bool rx_done_valid;                 // Last accepted message, re-acknowledged on repeats
+    uint8_t rx_done_message;
+    uint16_t rx_done_count;
+    uint32_t rx_accepted;               // Counter of the newest accepted message, 0 for none
+
+    // Send
+    uint8_t* tx_buffer;
+    bool tx_active;
+    uint32_t tx_counter;                // Counter of the current or next message
+    uint8_t tx_message;                 // Its low byte, the id in the frames
+    uint16_t tx_length;
+    uint16_t tx_fragment;
+    uint16_t tx_count;
+    uint16_t tx_base;                   // First unacknowledged fragment
+    uint16_t tx_next;                   // Next fragment never sent
+    uint8_t tx_window;
+    uint8_t tx_retries;
+    uint32_t tx_acked[BLE_TRANSPORT_BITMAP_WORDS];
+    uint32_t tx_sent_at[BLE_TRANSPORT_SEND_SLOTS];
+    uint32_t tx_stamp[BLE_TRANSPORT_SEND_SLOTS];   // Send order, for loss detection
+    uint32_t tx_sends;
+} ble_transport_t;
+
+/**
+ * Initialize a transport endpoint
+ *
+ * @param transport Endpoint to set up
+ * @param config Role, PoP key and callbacks (copied)
+ * @return true if the configuration is usable
+ */
+bool ble_transport_init(ble_transport_t* transport, const ble_transport_config_t* config);
+
+/**
+ * Start a connection once the ATT MTU exchange is done
+ * Draws a new session nonce, restarts the message counter and sends HELLO
+ * with the MTU, receive window and session nonce
+ *
+ * @param transport Endpoint
+ * @param att_mtu Negotiated ATT MTU (23..517)
+ */
+void ble_transport_connect(ble_transport_t* transport, uint16_t att_mtu);
+
+/**
+ * Handle a frame from the peer (GATT write or notification)
+ *
+ * @param transport Endpoint
+ * @param frame Frame bytes
+ * @param length Frame length
+ */
+void ble_transport_receive(ble_transport_t* transport, const uint8_t* frame, size_t length);
+
+/**
+ * Check for the peer's HELLO
+ * Messages are sealed to the peer's session nonce, so none can be sent
+ * before it.
+ *
+ * @param transport Endpoint
+ * @return true once the link parameters are negotiated
+ */
+bool ble_transport_ready(const ble_transport_t* transport);
+
+/**
+ * Seal and send one message
+ *
+ * @param transport Endpoint
+ * @param data Plaintext (at most BLE_TRANSPORT_MAX_PLAINTEXT bytes)
+ * @param length Plaintext length
+ * @return false before the peer's HELLO, if a message is still in flight,
+ *         too long, or no buffer is free
+ */
+bool ble_transport_send(ble_transport_t* transport, const uint8_t* data, size_t length);
+
+/**
+ * Run timers: delayed ACKs, retransmits, HELLO retries, frames the stack
+ * refused earlier. Call every few milliseconds while connected.
+ *
+ * @param transport Endpoint
+ */
+void ble_transport_tick(ble_transport_t* transport);
+
+/**
+ * Check for a message still being sent
+ *
+ * @param transport Endpoint
+ * @return true while ble_transport_send() would refuse a new message
+ */
+bool ble_transport_busy(const ble_transport_t* transport);
+
+/**
+ * Drop partial messages and return their buffers (disconnect)
+ *
+ * @param transport Endpoint
+ */
+void ble_transport_reset(ble_transport_t* transport);
+
+/**
+ * Free the message pool memory (provisioning finished)
+ * Buffers still in use are kept.
+ */
+void ble_transport_pool_free(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLE_TRANSPORT_H */
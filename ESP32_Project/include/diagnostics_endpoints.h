@@ -0,0 +1,80 @@
+#ifndef DIAGNOSTICS_ENDPOINTS_H
+#define DIAGNOSTICS_ENDPOINTS_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+/**
+ * Local diagnostics endpoints for AI Teddy Bear ESP32
+ *
+ * Served by the development web server (ota_manager.cpp):
+ *   /metrics           Prometheus text exposition of the metrics registry
+ *   /debug             index of the pages below
+ *   /debug/tasks       per-task CPU, priority and stack margin
+ *   /debug/heap        heap regions, pools, JSON arenas and memory pressure
+ *   /debug/latency     percentiles of every registry histogram
+ *   /debug/connection  WebSocket health and connection statistics (JSON)
+ *   /debug/taps        audio tap state (FEATURE_AUDIO_TAPS)
+ *   /debug/tap         ?name=<tap> ring as WAV; &saved=1 for the SPIFFS copy
+ *
+ * Pages are rendered line by line into a ResponseStream, which buffers
+ * DIAG_CHUNK_SIZE bytes and hands each full buffer to its sink. For the web
+ * server the sink sends an HTTP chunk, so no page ever exists as a whole in
+ * RAM. Renderers read registry snapshots and never allocate.
+ *
+ * Counters are exported as "<name>_total", histograms as summaries with
+ * p50/p90/p99/p99.9 quantiles (NaN until the first observation). Dots in
+ * registry names become underscores, names get a "teddy_" prefix and the
+ * unit as suffix ("ws.rtt" in ms -> teddy_ws_rtt_ms).
+ */
+
+// Endpoint configuration
+#define DIAG_CHUNK_SIZE          512    // Bytes per HTTP chunk
+#define DIAG_METRIC_PREFIX       "teddy_"
+#define DIAG_PROMETHEUS_TYPE     "text/plain; version=0.0.4; charset=utf-8"
+
+// Receives each filled buffer; returns false once the peer is gone
+typedef bool (*ResponseSink)(void* context, const char* data, size_t length);
+
+class ResponseStream {
+public:
+  ResponseStream(ResponseSink sink, void* context);
+  ~ResponseStream();
+
+  // Print-style interface (also used by serializeJson)
+  size_t write(uint8_t c);
+  size_t write(const uint8_t* data, size_t length);
+  void print(const char* text);
+  void printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+  bool flush();
+  bool failed() const { return sinkFailed; }
+
+  // Prevent copying
+  ResponseStream(const ResponseStream&) = delete;
+  ResponseStream& operator=(const ResponseStream&) = delete;
+
+private:
+  ResponseSink sink;
+  void* context;
+  char buffer[DIAG_CHUNK_SIZE];
+  size_t used;
+  bool sinkFailed;
+};
+
+// Registers /metrics and /debug/* on the given server
+void registerDiagnosticsEndpoints(WebServer& server);
+
+// Streams a page rendered by render() as a chunked response
+void streamResponse(WebServer& server, const char* contentType, void (*render)(ResponseStream&));
+
+// Renderers (usable with any sink)
+void renderPrometheusMetrics(ResponseStream& out);
+void renderDebugIndex(ResponseStream& out);
+void renderDebugTasks(ResponseStream& out);
+void renderDebugHeap(ResponseStream& out);
+void renderDebugLatency(ResponseStream& out);
+void renderDebugConnection(ResponseStream& out);
+void renderDebugTaps(ResponseStream& out);
+
+#endif // DIAGNOSTICS_ENDPOINTS_H
@@ -2,27 +2,66 @@
 #define ENCODING_SERVICE_H
 
 #include <Arduino.h>
-#include <vector>
 
 /**
- * @brief Professional Encoding Service - Clean Interface
- * Solves ODR violations by providing single translation unit for base64 operations
+ * @brief Base64 codec shared by JWT, audio and config code
+ *
+ * - Encodes 12 bytes to 16 characters and decodes 16 characters to 12
+ *   bytes per step with 32-bit loads and stores; partial blocks, padding
+ *   and whitespace take a byte-at-a-time path
+ * - Standard and URL-safe (JWT) alphabets, optional padding
+ * - Decoding in place: the output never overtakes the input
+ * - Streaming state for input that arrives in pieces
+ *
+ * The codec never allocates and never logs; callers report failures.
+ * Decoding ignores the unused low bits of the last character.
  */
 
-// Decoding functions
-unsigned int decodeBase64(const char* encoded, unsigned char* output, size_t output_size);
-std::vector<uint8_t> decodeBase64ToVector(const String& encoded);
+// Flags
+#define BASE64_URL          0x01    // '-' and '_' instead of '+' and '/'
+#define BASE64_NO_PAD       0x02    // Encode without '='; decode accepts it missing
+#define BASE64_WHITESPACE   0x04    // Decode skips spaces, tabs and line breaks
 
-// Encoding functions  
-unsigned int calculateBase64EncodedSize(size_t input_length);
-unsigned int encodeBase64(const unsigned char* data, size_t length, unsigned char* output, size_t output_size);
-String encodeBase64ToString(const unsigned char* data, size_t length);
+// Encoding or decoding state carried between pieces of a stream
+struct Base64Stream {
+    uint32_t bits;      // Pending input bytes (encode) or sextets (decode)
+    uint8_t count;      // How many are pending
+    uint8_t flags;
+    uint8_t padding;    // '=' characters seen (decode)
+    bool failed;
+};
 
-// Validation functions
-bool isValidBase64(const String& encoded);
+// Characters for length bytes, without the NUL
+size_t base64EncodedLength(size_t length, uint8_t flags = 0);
 
-// Statistics functions
-void getEncodingStats(unsigned long& operations_count, unsigned long& errors_count);
-void resetEncodingStats();
+// Upper bound on the bytes length characters decode to
+size_t base64DecodedLength(size_t length);
 
-#endif // ENCODING_SERVICE_H
\ No newline at end of file
+// One-shot encode; out receives base64EncodedLength() characters and a NUL
+bool base64Encode(const uint8_t* data, size_t length, char* out, size_t outSize,
+                  size_t* outLength, uint8_t flags = 0);
+
+// One-shot decode; fails on invalid input or when outSize is too small
+bool base64Decode(const char* text, size_t length, uint8_t* out, size_t outSize,
+                  size_t* outLength, uint8_t flags = 0);
+
+// Decodes text over itself; the bytes start at text
+bool base64DecodeInPlace(char* text, size_t length, size_t* outLength, uint8_t flags = 0);
+
+// Streaming: begin, any number of updates, finish
+void base64StreamBegin(Base64Stream& stream, uint8_t flags = 0);
+
+// out needs room for ((length + 2) / 3) * 4 characters; returns how many were written
+size_t base64EncodeUpdate(Base64Stream& stream, const uint8_t* data, size_t length, char* out);
+
+// Writes the last group (up to 4 characters, no NUL); returns how many
+size_t base64EncodeFinish(Base64Stream& stream, char* out);
+
+// Appends decoded bytes at out; *outLength is the number written by this call
+bool base64DecodeUpdate(Base64Stream& stream, const char* text, size_t length,
+                        uint8_t* out, size_t outSize, size_t* outLength);
+
+// Flushes an unpadded last group (up to 2 bytes) and checks the stream ended cleanly
+bool base64DecodeFinish(Base64Stream& stream, uint8_t* out, size_t outSize, size_t* outLength);
+
+#endif // ENCODING_SERVICE_H
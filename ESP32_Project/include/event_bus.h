@@ -0,0 +1,111 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include "audio_frame.h"
+
+/**
+ * Typed event bus for AI Teddy Bear ESP32
+ *
+ * Subsystems publish fixed-size events instead of calling into each other
+ * or sharing globals across cores. Each subscriber owns one queue per
+ * priority and drains them on its own task with dispatchEvents(), so a
+ * handler always runs in the subscriber's context, never the publisher's.
+ *
+ * Every event type has a fixed priority and overflow policy (see the type
+ * table in event_bus.cpp). When a subscriber queue is full, DROP_NEWEST
+ * rejects the new event and DROP_OLDEST evicts the head of the queue to make
+ * room. dispatchEvents() drains high before normal before low; events of
+ * one priority are delivered in publish order.
+ *
+ * Publishing never allocates: events are copied into queues created at
+ * registration. Audio events carry an AudioFrame share rather than the
+ * samples, and the bus releases the share if the event is dropped.
+ *
+ * Subscribers register during init, before any task publishes.
+ */
+
+// Bus configuration
+#define EVENT_MAX_SUBSCRIBERS     6
+#define EVENT_QUEUE_DEPTH_HIGH    4
+#define EVENT_QUEUE_DEPTH_NORMAL  8
+#define EVENT_QUEUE_DEPTH_LOW     4
+#define EVENT_TEXT_CAPACITY       48
+#define EVENT_DISPATCH_BUDGET     8     // Events handled per dispatchEvents() call
+
+enum EventType {
+  EVENT_WS_CONNECTED,
+  EVENT_WS_DISCONNECTED,
+  EVENT_AUTH_REFRESH_REQUEST,   // text: refresh proof
+  EVENT_AUDIO_CHUNK,            // frame: captured PCM s16le
+  EVENT_HEALTH_ANOMALY,         // anomaly: graded detector finding
+  EVENT_TYPE_COUNT
+};
+
+enum EventPriority {
+  EVENT_PRIORITY_HIGH,
+  EVENT_PRIORITY_NORMAL,
+  EVENT_PRIORITY_LOW,
+  EVENT_PRIORITY_COUNT
+};
+
+enum EventOverflowPolicy {
+  EVENT_DROP_NEWEST,
+  EVENT_DROP_OLDEST
+};
+
+// Health anomaly finding (see anomaly_detector.h for the enums)
+struct AnomalyPayload {
+  uint8_t signal;       // AnomalySignal
+  uint8_t detector;     // AnomalyDetectorKind
+  uint8_t severity;     // AnomalySeverity
+  float value;          // Sample (or heap slope in bytes/hour) that raised it
+  float baseline;       // Expected value at that time
+};
+
+// Event flags
+#define EVENT_FLAG_FINAL          0x01  // Last audio chunk of an utterance
+
+struct Event {
+  EventType type;
+  uint8_t flags;
+  uint32_t publishedUs;
+  union {
+    char text[EVENT_TEXT_CAPACITY];
+    AudioFrameBuffer* frame;    // Owned share, see eventFrame()
+    AnomalyPayload anomaly;
+  };
+};
+
+typedef void (*EventHandler)(const Event& event);
+
+// Subscriber handle (index into the subscriber table, -1 when registration failed)
+typedef int8_t EventSubscriberId;
+#define EVENT_SUBSCRIBER_INVALID ((EventSubscriberId)-1)
+
+// Lifecycle
+bool initEventBus();
+
+// Registration (init time only; allocates the subscriber's queues)
+EventSubscriberId registerEventSubscriber(const char* name);
+bool subscribeEvent(EventSubscriberId subscriber, EventType type, EventHandler handler);
+
+// Publishing (any task; returns false if no subscriber accepted the event)
+bool publishEvent(EventType type);
+bool publishEvent(EventType type, const char* text);
+bool publishEvent(EventType type, const AudioFrame& frame, uint8_t flags = 0);
+bool publishEvent(EventType type, const AnomalyPayload& anomaly);
+
+// Delivery on the calling (subscriber's) task; returns events handled
+uint8_t dispatchEvents(EventSubscriberId subscriber, uint8_t maxEvents = EVENT_DISPATCH_BUDGET);
+
+// Shared handle to an event's frame, valid beyond the handler
+AudioFrame eventFrame(const Event& event);
+
+// Introspection
+const char* getEventTypeName(EventType type);
+void printEventBusStats();
+
+#endif // EVENT_BUS_H
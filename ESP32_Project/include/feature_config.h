@@ -68,9 +68,11 @@ PRIORITY LEVELS:
 #ifdef DEBUG_BUILD
   #define FEATURE_PERFORMANCE_MONITOR   1    // Performance debugging
   #define FEATURE_PERFORMANCE_COMMANDS  1    // Debug commands
+  #define FEATURE_AUDIO_TAPS            1    // PCM taps on pipeline stages
 #else
   #define FEATURE_PERFORMANCE_MONITOR   0
   #define FEATURE_PERFORMANCE_COMMANDS  0
+  #define FEATURE_AUDIO_TAPS            0
 #endif
 
 // ==== FEATURE DEPENDENCIES ====
@@ -104,7 +106,7 @@ PRIORITY LEVELS:
 #endif
 
 // ==== FEATURE STATUS REPORTING ====
-void printFeatureConfiguration() {
+inline void printFeatureConfiguration() {
   Serial.println("=== 🔵 Feature Configuration ===");
   Serial.println("CORE FEATURES (P1):");
   Serial.printf("  WiFi Manager: %s\n", FEATURE_WIFI_MANAGER ? "✅" : "❌");
@@ -0,0 +1,202 @@
+#ifndef FIXED_STRING_H
+#define FIXED_STRING_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+/**
+ * Fixed-capacity strings for AI Teddy Bear ESP32
+ *
+ * Allocation-free replacements for Arduino String on hot paths:
+ *
+ *   StringView        - non-owning (pointer, length); binds to literals,
+ *                       char buffers and String without copying
+ *   FixedString<N>    - inline buffer of N bytes (including the NUL) with
+ *                       append/appendf/appendHex; never touches the heap
+ *
+ * Overflow never writes past the buffer. The truncation policy decides what
+ * the caller sees: FS_TRUNCATE keeps the prefix that fits, FS_ELLIPSIS also
+ * replaces the tail with "..." so log lines show they were cut. Either way
+ * isTruncated() reports it.
+ */
+
+enum FixedStringOverflow : uint8_t {
+  FS_TRUNCATE,
+  FS_ELLIPSIS
+};
+
+// =============================================================================
+// STRING VIEW
+// =============================================================================
+
+class StringView {
+public:
+  StringView() : ptr(""), len(0) {}
+  StringView(const char* s) : ptr(s ? s : ""), len(s ? strlen(s) : 0) {}
+  StringView(const char* s, size_t n) : ptr(s ? s : ""), len(s ? n : 0) {}
+  StringView(const String& s) : ptr(s.c_str()), len(s.length()) {}
+
+  const char* data() const { return ptr; }
+  size_t length() const { return len; }
+  bool isEmpty() const { return len == 0; }
+  char operator[](size_t i) const { return ptr[i]; }
+
+  bool equals(StringView other) const {
+    return len == other.len && memcmp(ptr, other.ptr, len) == 0;
+  }
+
+  bool equalsIgnoreCase(StringView other) const {
+    if (len != other.len) return false;
+    for (size_t i = 0; i < len; i++) {
+      if (tolower((unsigned char)ptr[i]) != tolower((unsigned char)other.ptr[i])) return false;
+    }
+    return true;
+  }
+
+  bool containsIgnoreCase(StringView needle) const {
+    if (needle.len > len) return false;
+    for (size_t i = 0; i + needle.len <= len; i++) {
+      if (substr(i, needle.len).equalsIgnoreCase(needle)) return true;
+    }
+    return false;
+  }
+
+  bool startsWith(StringView prefix) const {
+    return len >= prefix.len && memcmp(ptr, prefix.ptr, prefix.len) == 0;
+  }
+
+  StringView trim() const {
+    size_t start = 0;
+    size_t end = len;
+    while (start < end && isspace((unsigned char)ptr[start])) start++;
+    while (end > start && isspace((unsigned char)ptr[end - 1])) end--;
+    return StringView(ptr + start, end - start);
+  }
+
+  StringView substr(size_t pos, size_t n = SIZE_MAX) const {
+    if (pos > len) pos = len;
+    if (n > len - pos) n = len - pos;
+    return StringView(ptr + pos, n);
+  }
+
+  bool operator==(StringView other) const { return equals(other); }
+  bool operator!=(StringView other) const { return !equals(other); }
+
+private:
+  const char* ptr;   // Not necessarily NUL-terminated: print with "%.*s"
+  size_t len;
+};
+
+// =============================================================================
+// FIXED STRING
+// =============================================================================
+
+template <size_t N, FixedStringOverflow Policy = FS_TRUNCATE>
+class FixedString {
+  static_assert(N >= 4, "FixedString needs room for at least \"...\" and NUL");
+
+public:
+  FixedString() : len(0), truncated(false) { buf[0] = '\0'; }
+  FixedString(StringView s) : FixedString() { append(s); }
+
+  const char* c_str() const { return buf; }
+  size_t length() const { return len; }
+  static constexpr size_t capacity() { return N - 1; }
+  bool isEmpty() const { return len == 0; }
+  bool isTruncated() const { return truncated; }
+  StringView view() const { return StringView(buf, len); }
+  operator StringView() const { return view(); }
+
+  void clear() {
+    len = 0;
+    truncated = false;
+    buf[0] = '\0';
+  }
+
+  FixedString& assign(StringView s) {
+    clear();
+    return append(s);
+  }
+
+  FixedString& append(StringView s) {
+    size_t room = capacity() - len;
+    size_t n = s.length() <= room ? s.length() : room;
+    memcpy(buf + len, s.data(), n);
+    len += n;
+    buf[len] = '\0';
+    if (n < s.length()) markTruncated();
+    return *this;
+  }
+
+  FixedString& append(char c) {
+    if (len < capacity()) {
+      buf[len++] = c;
+      buf[len] = '\0';
+    } else {
+      markTruncated();
+    }
+    return *this;
+  }
+
+  FixedString& appendf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, fmt);
+    appendv(fmt, args);
+    va_end(args);
+    return *this;
+  }
+
+  FixedString& appendv(const char* fmt, va_list args) {
+    size_t room = N - len;
+    int written = vsnprintf(buf + len, room, fmt, args);
+    if (written < 0) {
+      buf[len] = '\0';
+      return *this;
+    }
+    if ((size_t)written >= room) {
+      len = capacity();
+      markTruncated();
+    } else {
+      len += written;
+    }
+    return *this;
+  }
+
+  // Lower-case hex, two characters per byte
+  FixedString& appendHex(const uint8_t* data, size_t n) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < n; i++) {
+      if (len + 2 > capacity()) {
+        markTruncated();
+        break;
+      }
+      buf[len++] = digits[data[i] >> 4];
+      buf[len++] = digits[data[i] & 0x0F];
+    }
+    buf[len] = '\0';
+    return *this;
+  }
+
+  FixedString& operator+=(StringView s) { return append(s); }
+  FixedString& operator+=(char c) { return append(c); }
+  FixedString& operator=(StringView s) { return assign(s); }
+
+  bool operator==(StringView other) const { return view().equals(other); }
+  bool operator!=(StringView other) const { return !view().equals(other); }
+
+private:
+  char buf[N];
+  size_t len;
+  bool truncated;
+
+  void markTruncated() {
+    truncated = true;
+    if (Policy == FS_ELLIPSIS) {
+      len = capacity();
+      memcpy(buf + len - 3, "...", 3);
+      buf[len] = '\0';
+    }
+  }
+};
+
+#endif // FIXED_STRING_H
@@ -0,0 +1,78 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/**
+ * Arena-backed JSON documents for AI Teddy Bear ESP32
+ *
+ * A JsonArenaScope binds a bump arena to the calling task; every
+ * ArenaJsonDocument created inside the scope takes its memory pool from
+ * that arena instead of the heap, and the arena is reset when the
+ * outermost scope ends (or, if a document outlived it, when that document is
+ * freed). Declare the scope before the documents so they are destroyed first.
+ *
+ * Arena size is learned: when a message needed more than the arena held
+ * (the excess came from the heap), the arena grows at the next reset, up to
+ * JSON_ARENA_MAX_SIZE. Idle arenas are reused by other tasks, so short-lived
+ * tasks do not pin memory. Documents created outside any scope, or larger
+ * than the arena, fall back to the heap.
+ *
+ * estimateJsonCapacity() sizes inbound documents as the message length plus
+ * the per-message overhead observed on previous messages.
+ */
+
+// Arena configuration
+#define JSON_ARENA_SLOTS          3       // Loop task, audio capture, realtime streamer
+#define JSON_ARENA_INITIAL_SIZE   3072    // Bytes
+#define JSON_ARENA_MAX_SIZE       16384   // Larger messages use the heap
+#define JSON_CAPACITY_MIN         256
+#define JSON_CAPACITY_SLACK       128
+
+// ArduinoJson allocator interface
+struct JsonArenaAllocator {
+  void* allocate(size_t size);
+  void deallocate(void* ptr);
+  void* reallocate(void* ptr, size_t newSize);
+};
+
+typedef BasicJsonDocument<JsonArenaAllocator> ArenaJsonDocument;
+
+// RAII scope: binds (and on exit resets) the calling task's arena
+class JsonArenaScope {
+public:
+  JsonArenaScope();
+  ~JsonArenaScope();
+
+  // Prevent copying
+  JsonArenaScope(const JsonArenaScope&) = delete;
+  JsonArenaScope& operator=(const JsonArenaScope&) = delete;
+
+private:
+  int slot;
+};
+
+struct JsonArenaStats {
+  uint32_t scopes;          // Outermost scopes closed (≈ messages handled)
+  uint32_t arenaAllocs;
+  uint32_t heapFallbacks;   // Allocations the arena could not hold
+  uint32_t resizes;
+  size_t peakUsage;         // Largest per-scope demand seen (bytes)
+  size_t reservedBytes;     // Sum of all arena capacities
+};
+
+// Capacity learning for inbound documents
+size_t estimateJsonCapacity(size_t inputLength);
+void recordJsonUsage(size_t inputLength, size_t memoryUsage);
+
+// Free arenas no task is using; they are re-reserved at the initial size on next use
+size_t releaseIdleJsonArenas();
+
+// Statistics
+JsonArenaStats getJsonArenaStats();
+void printJsonArenaStats();
+
+#endif // JSON_ARENA_H
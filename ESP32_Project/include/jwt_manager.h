@@ -39,6 +39,8 @@ extern "C" {
 #define JWT_MAX_RETRY_COUNT         5       // Maximum retry attempts
 #define JWT_HTTP_TIMEOUT_MS         10000   // HTTP request timeout
 #define JWT_OPERATION_TIMEOUT_MS    5000    // Mutex timeout
+#define JWT_REFRESH_TASK_STACK      4096    // Refresh task stack (bytes)
+#define JWT_REFRESH_RESPONSE_MS     10000   // Wait for the auth response to a refresh request
 #define JWT_NVS_NAMESPACE           "jwt_mgr"
 #define JWT_TOKEN_KEY               "token"
 #define JWT_EXPIRY_KEY              "expiry"
@@ -117,8 +119,9 @@ public:
     // Core functionality
     bool init();
     bool authenticateDevice(const String& pairingCode, const String& devicePub = "", const String& nonce = "");
-    bool refreshToken();
+    bool refreshToken();                      // True once the request is handed off, not answered
     bool handleRefreshResponse(const String& response);
+    void noteRefreshSendFailed();             // WebSocket task could not send the request
     bool isTokenValid();
     void clearToken();
     
@@ -177,6 +180,8 @@ private:
     uint32_t tokenExpiry;
     bool autoRefreshEnabled;
     bool refreshInProgress;
+    volatile bool refreshAwaitingResponse;    // Request sent, no auth response yet
+    volatile bool refreshConfirmed;           // auth/ok arrived for the last request
     uint8_t retryCount;
     uint32_t lastRefreshAttempt;
     uint32_t totalRefreshes;
@@ -196,6 +201,7 @@ private:
     HTTPClient* httpClient;
     
     // Private methods
+    bool waitForRefreshResponse();
     bool performDeviceAuthentication(const String& pairingCode, const String& devicePub, const String& nonce);
     bool parseAuthenticationResponse(const String& response);
     void loadTokenFromNVS();
@@ -214,6 +220,7 @@ private:
     // Static callbacks
     static void autoRefreshTimerCallback(void* arg);
     static void refreshTokenTask(void* parameter);
+    static void startRefreshTask(JWTManager* jwt);   // No-op while refreshTaskHandle is set
 };
 
 /*
@@ -438,7 +445,8 @@ if (!jwt->init()) {
     return;
 }
 
-// Set WebSocket refresh callback
+// Optional: override the default path, which publishes EVENT_AUTH_REFRESH_REQUEST
+// for the WebSocket task to send
 jwt->setRefreshCallback([](const String& refreshMessage) -> bool {
     // Send refreshMessage via WebSocket
     return webSocketClient.sendText(refreshMessage);
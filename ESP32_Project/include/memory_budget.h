@@ -0,0 +1,86 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <Arduino.h>
+
+/**
+ * Memory budget manager for AI Teddy Bear ESP32
+ *
+ * Watches total free heap and the largest free block, plus per-subsystem
+ * budgets, and responds to pressure by shedding load one step at a time in
+ * a fixed order:
+ *
+ *   1. flush_caches        - release idle JSON arenas
+ *   2. pause_telemetry     - stop metrics uploads
+ *   3. cap_audio_chunks    - smaller capture chunks and WebSocket chunk size
+ *   4. shrink_audio_buffer - cut audio_buffer to MEM_BUDGET_AUDIO_BUFFER_MIN
+ *                            (not while recording)
+ *   5. close_portal        - stop a setup portal left open after connecting
+ *
+ * Steps 1, 4 and 5 release memory and count as shed only when they freed
+ * bytes; the log reports how many. Steps 2 and 3 limit new allocations and
+ * count once they changed a live setting.
+ *
+ * Steps are restored in reverse order once the heap has stayed healthy for
+ * MEM_BUDGET_RESTORE_HOLD. A restart is the last rung: it needs every step
+ * shed, the heap below MEM_BUDGET_RESTART_FREE for MEM_BUDGET_RESTART_GRACE,
+ * and no conversation in progress. Only MEM_BUDGET_HARD_FLOOR restarts
+ * mid-conversation.
+ *
+ * A subsystem over its own budget has its step shed even when the heap as a
+ * whole is healthy.
+ */
+
+// Pressure thresholds (bytes)
+#define MEM_BUDGET_FREE_WARN        (60 * 1024)
+#define MEM_BUDGET_LARGEST_WARN     (16 * 1024)
+#define MEM_BUDGET_FREE_CRITICAL    (32 * 1024)
+#define MEM_BUDGET_LARGEST_CRITICAL (8 * 1024)
+#define MEM_BUDGET_RECOVER_MARGIN   (16 * 1024)  // Hysteresis above the warn levels
+#define MEM_BUDGET_RESTART_FREE     (20 * 1024)
+#define MEM_BUDGET_HARD_FLOOR       (8 * 1024)
+
+// Timing (ms)
+#define MEM_BUDGET_CHECK_INTERVAL   1000
+#define MEM_BUDGET_STEP_INTERVAL    3000   // Between sheds while elevated; critical sheds every check
+#define MEM_BUDGET_RESTORE_HOLD     30000
+#define MEM_BUDGET_RESTART_GRACE    10000
+
+// Per-subsystem budgets (bytes)
+#define MEM_BUDGET_JSON_ARENAS      (24 * 1024)
+#define MEM_BUDGET_AUDIO_TRACKED    (48 * 1024)
+
+// Shed settings
+#define MEM_BUDGET_CAPTURE_CHUNK    2048          // Capture and WebSocket chunk cap (bytes)
+#define MEM_BUDGET_AUDIO_BUFFER_MIN (12 * 1024)   // audio_buffer while shed
+
+enum MemoryPressure {
+  MEM_PRESSURE_NONE,
+  MEM_PRESSURE_ELEVATED,
+  MEM_PRESSURE_CRITICAL
+};
+
+enum DegradationStep {
+  DEGRADE_FLUSH_CACHES,
+  DEGRADE_PAUSE_TELEMETRY,
+  DEGRADE_CAP_AUDIO_CHUNKS,
+  DEGRADE_SHRINK_AUDIO_BUFFER,
+  DEGRADE_CLOSE_PORTAL,
+  DEGRADE_STEP_COUNT
+};
+
+// Lifecycle
+bool initMemoryBudget();
+void handleMemoryBudget();
+
+// Evaluate one reading; handleMemoryBudget() feeds it live heap figures
+void evaluateMemoryBudget(size_t freeHeap, size_t largestBlock, unsigned long now);
+
+// State
+MemoryPressure getMemoryPressure();
+uint8_t getDegradationLevel();             // Steps currently shed
+bool isDegradationStepActive(DegradationStep step);
+const char* getDegradationStepName(DegradationStep step);
+void printMemoryBudget();
+
+#endif // MEMORY_BUDGET_H
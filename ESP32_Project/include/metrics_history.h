@@ -0,0 +1,93 @@
+#ifndef METRICS_HISTORY_H
+#define METRICS_HISTORY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * Round-robin metrics history for AI Teddy Bear ESP32
+ *
+ * A few health signals are kept at three resolutions, RRD style: one point
+ * per second for the last HISTORY_SECONDS, per minute for the last
+ * HISTORY_MINUTES and per hour for the last HISTORY_HOURS. Each finished
+ * minute is consolidated from its seconds and each finished hour from its
+ * minutes. A point keeps the average and the worst value: lowest for heap
+ * and RSSI, highest for latency and CPU. A point with fewer than
+ * HISTORY_MIN_KNOWN_PERCENT of its inputs known (WiFi down, loop blocked)
+ * is stored as unknown; latency series only need one observation, since
+ * seconds without pings or utterances are normal.
+ *
+ * Values are int16 in per-series units (heap in 16-byte steps), so the
+ * whole store is a few KB of static memory and never allocates. Latency
+ * series are percentiles of the observations within each second, read from
+ * the registry histograms with getHistogramWindow().
+ *
+ * The minute and hour archives are saved to NVS when an hour point closes
+ * and before planned restarts, and restored at boot. A save identical to the
+ * last one is skipped. One ~3.5 KB blob an hour is ~84 KB of NVS writes a
+ * day, spread by NVS wear levelling. Once the clock is synced
+ * again, the time spent off is filled with unknown minutes so the series
+ * stay aligned with wall time.
+ *
+ * Queried with the "history" server message (one "metrics_history" reply
+ * per series) or through exportHistorySeries().
+ */
+
+// History configuration
+#define HISTORY_SECONDS             60      // 1 s points (1 minute)
+#define HISTORY_MINUTES             60      // 1 min points (1 hour)
+#define HISTORY_HOURS               48      // 1 h points (2 days)
+#define HISTORY_MIN_KNOWN_PERCENT   50      // Inputs needed for a known point
+#define HISTORY_MAX_GAP_MINUTES     (HISTORY_HOURS * 60)
+#define HISTORY_NVS_NAMESPACE       "metrics_hist"
+#define HISTORY_FORMAT_VERSION      1
+#define HISTORY_UNKNOWN             INT16_MIN
+
+// Document capacity for one exported series (plus a message envelope)
+#define HISTORY_JSON_CAPACITY       (2 * JSON_ARRAY_SIZE(HISTORY_MINUTES) + JSON_OBJECT_SIZE(2) + \
+                                     JSON_OBJECT_SIZE(8) + 64)
+
+enum HistorySeries {
+  HISTORY_HEAP_FREE,          // bytes
+  HISTORY_HEAP_LARGEST,       // bytes
+  HISTORY_WIFI_RSSI,          // dBm
+  HISTORY_WS_RTT_P50,         // ms
+  HISTORY_WS_RTT_P99,         // ms
+  HISTORY_AUDIO_LATENCY_P50,  // ms
+  HISTORY_AUDIO_LATENCY_P99,  // ms
+  HISTORY_CPU,                // % of both cores
+  HISTORY_SERIES_COUNT
+};
+
+enum HistoryResolution {
+  HISTORY_RES_SECOND,
+  HISTORY_RES_MINUTE,
+  HISTORY_RES_HOUR,
+  HISTORY_RES_COUNT
+};
+
+// Consolidated point, in stored units
+struct HistoryPoint {
+  int16_t avg;
+  int16_t worst;
+};
+
+// Lifecycle
+bool initMetricsHistory();
+void handleMetricsHistory();
+bool saveMetricsHistory();
+
+// Queries (index 0 is the oldest point)
+uint16_t getHistoryPointCount(HistoryResolution res);
+bool getHistoryPoint(HistoryResolution res, HistorySeries series, uint16_t index, HistoryPoint& out);
+int32_t historyToUnits(HistorySeries series, int16_t stored);
+int findHistorySeries(const char* name);
+int findHistoryResolution(const char* name);
+const char* getHistorySeriesName(HistorySeries series);
+
+// Export
+void exportHistorySeries(JsonObject& out, HistoryResolution res, HistorySeries series);
+bool sendMetricsHistory(HistoryResolution res, int series = -1);   // -1: every series
+void printMetricsHistory();
+
+#endif // METRICS_HISTORY_H
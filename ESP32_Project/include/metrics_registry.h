@@ -0,0 +1,118 @@
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * Central Metrics Registry for AI Teddy Bear ESP32
+ *
+ * Features:
+ * - Named counters, gauges and log-linear (HDR-style) histograms
+ * - Fixed tables; histogram buckets are allocated once at registration,
+ *   never on the update path
+ * - Per-core shards so audio (core 0) and loop (core 1) never contend
+ * - Snapshot export to JSON for health reports
+ *
+ * Histogram buckets are linear below 2^METRICS_HIST_SUB_BITS and then split
+ * every power of two into 2^METRICS_HIST_SUB_BITS equal sub-buckets, so the
+ * relative error of any reported percentile stays below 1/2^SUB_BITS.
+ * The board has no PSRAM, so histograms cost internal DRAM: 88 buckets x
+ * 4 bytes x 2 shards = 704 bytes each.
+ */
+
+// Registry configuration
+#define METRICS_MAX_COUNTERS     32
+#define METRICS_FIXED_GAUGES     16    // heap.*, cpu.*, loop.*, mem.*, stack.* (15 registered today)
+#define METRICS_TASK_GAUGES      20    // One task.<name>.cpu gauge per tracked task
+#define METRICS_MAX_GAUGES       (METRICS_FIXED_GAUGES + METRICS_TASK_GAUGES)
+#define METRICS_MAX_HISTOGRAMS   20    // ~0.7KB of buckets each, allocated on registration
+#define METRICS_NUM_SHARDS       2     // One shard per CPU core
+#define METRICS_HIST_SUB_BITS    2     // 4 sub-buckets per octave (~25% width, midpoint within 12.5%)
+#define METRICS_HIST_MAX_BITS    23    // Values >= 2^23 land in the last bucket
+#define METRICS_HIST_SUB_COUNT   (1 << METRICS_HIST_SUB_BITS)
+#define METRICS_HIST_BUCKETS     ((METRICS_HIST_MAX_BITS - METRICS_HIST_SUB_BITS + 1) * METRICS_HIST_SUB_COUNT)
+#define METRICS_REPORT_INTERVAL  60000 // Snapshot upload interval (ms)
+
+// Metric handle (index into the per-type table, -1 when registration failed)
+typedef int16_t MetricId;
+#define METRIC_INVALID ((MetricId)-1)
+
+enum MetricType {
+  METRIC_COUNTER,
+  METRIC_GAUGE,
+  METRIC_HISTOGRAM
+};
+
+// Merged view of one histogram, produced on demand
+struct HistogramSnapshot {
+  uint32_t count;
+  uint64_t sum;
+  uint32_t min;
+  uint32_t max;
+  uint32_t p50;
+  uint32_t p90;
+  uint32_t p99;
+  uint32_t p999;
+};
+
+// Caller-owned baseline for windowed percentiles (zero-initialize before first use)
+struct HistogramWindow {
+  uint32_t baseline[METRICS_HIST_BUCKETS];
+};
+
+// Registry initialization
+bool initMetricsRegistry();
+void resetMetricsRegistry();
+
+// Registration (idempotent: same name returns the same handle)
+MetricId registerCounter(const char* name, const char* unit = "");
+MetricId registerGauge(const char* name, const char* unit = "");
+MetricId registerHistogram(const char* name, const char* unit = "");
+
+// Hot-path updates, safe from any task on either core. Counters, gauges and
+// histogram buckets are atomic; metricObserve() also adds to a 64-bit sum
+// under a per-core spinlock (Xtensa has no 64-bit atomics).
+void metricIncrement(MetricId id, uint32_t delta = 1);
+void metricSetGauge(MetricId id, int32_t value);
+void metricAddGauge(MetricId id, int32_t delta);
+void metricObserve(MetricId id, uint32_t value);
+
+// Scoped timer that records elapsed microseconds into a histogram
+class MetricTimer {
+public:
+  explicit MetricTimer(MetricId histogram) : id(histogram), start(micros()) {}
+  ~MetricTimer() { metricObserve(id, (uint32_t)(micros() - start)); }
+
+  MetricTimer(const MetricTimer&) = delete;
+  MetricTimer& operator=(const MetricTimer&) = delete;
+
+private:
+  MetricId id;
+  uint32_t start;
+};
+
+// Reads and snapshots
+uint32_t getCounterValue(MetricId id);
+int32_t getGaugeValue(MetricId id);
+bool getHistogramSnapshot(MetricId id, HistogramSnapshot& out);
+uint32_t getHistogramPercentile(MetricId id, float percentile);
+// Percentiles of the observations since the previous call with the same window;
+// returns how many there were (results are 0 when none)
+uint32_t getHistogramWindow(MetricId id, HistogramWindow& window,
+                            const float* percentiles, uint32_t* results, uint8_t n);
+size_t getMetricCount(MetricType type);
+const char* getMetricName(MetricType type, MetricId id);
+const char* getMetricUnit(MetricType type, MetricId id);
+MetricId findMetric(MetricType type, const char* name);
+
+// Export
+void exportMetricsSnapshot(JsonObject& out);
+void printMetricsRegistry();
+
+// Bucket math (exposed for host-side verification tools)
+uint16_t histogramBucketIndex(uint32_t value);
+uint32_t histogramBucketLowerBound(uint16_t index);
+uint32_t histogramBucketUpperBound(uint16_t index);
+
+#endif // METRICS_REGISTRY_H
@@ -96,6 +96,7 @@ SystemHealth getSystemHealth();
 void logError(ErrorType type, const String& message, const String& context = "", int severity = 3);
 void sendErrorReport();
 void sendHealthReport();
+void setTelemetryPaused(bool paused);  // Memory budget: skip uploads under pressure
 bool performHealthCheck();
 void initWatchdog();
 void feedWatchdog();
@@ -0,0 +1,52 @@
+#ifndef OTA_DELTA_H
+#define OTA_DELTA_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "ota_pipeline.h"
+
+/**
+ * Delta OTA updates for AI Teddy Bear ESP32
+ *
+ * A patch (scripts/ota_delta.py) rebuilds the new application image from
+ * the one running now, so a small fix downloads a small patch instead of
+ * the whole image. The new image is produced block by block as the patch
+ * streams in and feeds the same pipeline as a full download
+ * (installOtaImageFrom), so it is erased, written, hashed and
+ * signature-checked exactly like one.
+ *
+ * Patch layout (little-endian):
+ *
+ *   header   "TBDP", version, window bits, 2 reserved bytes,
+ *            old size, new size, SHA-256 of old image, SHA-256 of new image
+ *   body     raw deflate stream of records, each
+ *              diff length, extra length, old seek (signed)
+ *              diff bytes   new = old + diff (mod 256), reading the old image
+ *              extra bytes  copied as is
+ *            after a record the old position moves by its seek
+ *
+ * This is the bsdiff scheme: recompiled code mostly differs by shifted
+ * addresses, so diff bytes are nearly all zero and deflate well. Decoding
+ * uses the ROM inflater with a (1 << window bits) byte dictionary; RAM stays
+ * bounded regardless of image size.
+ *
+ * Before anything is written, the running partition is hashed and must
+ * match the patch's old image. The reconstructed image must hash to the
+ * patch's new image and to the manifest checksum, both checked before the
+ * boot switch.
+ */
+
+// Delta configuration
+#define OTA_DELTA_MAGIC            "TBDP"
+#define OTA_DELTA_VERSION          1
+#define OTA_DELTA_HEADER_SIZE      80
+#define OTA_DELTA_MAX_WINDOW_BITS  15          // 32 KB dictionary at most
+#define OTA_DELTA_INPUT_SIZE       1024        // Compressed bytes per network read
+
+// Downloads the patch (patchSize bytes) from source and installs the image
+// it rebuilds from the running partition. expected.size and expected.sha256
+// describe the new image; the signature is checked over it as usual.
+bool installOtaDelta(Client& source, size_t patchSize, const OtaExpectedImage& expected,
+                     OtaPipelineStats& stats);
+
+#endif // OTA_DELTA_H
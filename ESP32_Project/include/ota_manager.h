@@ -9,7 +9,6 @@
 #include <HTTPClient.h>
 #include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
-#include <esp_https_ota.h>
 
 // OTA Configuration
 #define OTA_PORT 3232
@@ -18,35 +17,41 @@
 #define UPDATE_CHECK_INTERVAL 3600000  // 1 hour
 #define WEB_SERVER_PORT 80
 
+// Local HTTP server (/status, /history, /metrics, /debug/*): development
+// builds set ENABLE_DEBUG_HTTP; ElegantOTA needs the server too
+#if defined(ENABLE_ELEGANT_OTA) && !defined(ENABLE_DEBUG_HTTP)
+#define ENABLE_DEBUG_HTTP 1
+#endif
+
 // Update server configuration
 struct FirmwareInfo {
   String version;
   String download_url;
-  String checksum;
+  String checksum;        // Hex SHA-256 of the image
+  String signature;       // Base64 DER signature over that digest
   String release_notes;
   bool force_update;
-  size_t file_size;
+  size_t file_size;       // Image size
+  size_t download_size;   // Bytes at download_url: file_size, or less when packed
+  String delta_url;       // Optional patch from delta_from to this version
+  String delta_from;
+  size_t delta_size;
 };
 
 // Function declarations
 bool initOTA();
 void handleOTA();
 bool checkForUpdates();
-bool downloadAndInstallUpdate(const String& url);
+bool downloadAndInstallUpdate(const FirmwareInfo& firmware);
 void onOTAStart();
 void onOTAProgress(unsigned int progress, unsigned int total);
 void onOTAEnd();
 void onOTAError(ota_error_t error);
-bool validateFirmware(const String& checksum);
 String getCurrentVersion();
 void startWebServer();
 void handleWebRequests();
 FirmwareInfo parseUpdateResponse(const String& response);
 
-#ifdef PRODUCTION_BUILD
-bool performSecureOTAUpdate(const String& url);
-#endif
-
 // Global instances
 extern WebServer webServer;
 extern unsigned long lastUpdateCheck;
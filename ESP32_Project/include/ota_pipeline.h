@@ -0,0 +1,89 @@
+#ifndef OTA_PIPELINE_H
+#define OTA_PIPELINE_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <mbedtls/sha256.h>
+
+/**
+ * Pipelined OTA image installer for AI Teddy Bear ESP32
+ *
+ * The calling task is the network reader: it fills one of
+ * OTA_PIPELINE_BUFFERS buffers from the connection and hashes it (SHA-256)
+ * while a writer task erases and writes the previous buffer to the next OTA
+ * partition. Flash is erased in OTA_ERASE_BLOCK units (a 64 KB block erase
+ * costs a fraction of sixteen 4 KB sector erases, which is what Update.write
+ * does), and whenever the writer has nothing to write it erases up to
+ * OTA_ERASE_AHEAD bytes past the write position, so erase overlaps network
+ * receive instead of following it.
+ *
+ * Verification needs no second pass: once the last buffer is written the
+ * streamed digest is compared with the manifest checksum and, when
+ * OTA_SIGNING_PUBLIC_KEY_PEM is compiled in, the manifest signature (DER,
+ * ECDSA or RSA over the SHA-256 digest) is checked against that key; an
+ * unsigned image is then rejected. Only a verified image is made bootable,
+ * and esp_ota_set_boot_partition() still checks the image structure and its
+ * appended hash.
+ */
+
+// Pipeline configuration
+#define OTA_PIPELINE_BUFFERS      2
+#define OTA_PIPELINE_BUFFER_SIZE  (16 * 1024)
+#define OTA_ERASE_BLOCK           (64 * 1024)   // Erase unit: one flash block erase instead of 16 sector erases
+#define OTA_ERASE_AHEAD           (128 * 1024)  // Erased beyond the write position while idle
+#define OTA_READ_TIMEOUT_MS       15000         // No data for this long aborts the download
+#define OTA_WRITER_STACK_SIZE     4096
+#define OTA_WRITER_PRIORITY       3
+#define OTA_SHA256_SIZE           32
+#define OTA_SIGNATURE_MAX         512           // DER signature, up to RSA-4096
+
+struct OtaExpectedImage {
+  size_t size;
+  const uint8_t* sha256;        // nullptr: digest not compared
+  const uint8_t* signature;     // nullptr: unsigned
+  size_t signatureLength;
+};
+
+struct OtaPipelineStats {
+  uint32_t bytes;
+  uint32_t totalMs;
+  uint32_t readMs;          // Reader producing data (network, patch decoding)
+  uint32_t stallMs;         // Reader waiting for a free buffer (flash behind network)
+  uint32_t eraseMs;         // All erases, including...
+  uint32_t eraseAheadMs;    // ...those done while the writer was idle
+  uint32_t writeMs;
+  uint32_t verifyMs;
+};
+
+// Fills data with the next length bytes of the image; fewer only on failure
+typedef size_t (*OtaImageReader)(void* context, uint8_t* data, size_t length);
+
+// Told each time more of the image is in flash: [0, offset) is written and
+// sha is the digest state after it
+typedef void (*OtaDurableCallback)(void* context, size_t offset, const mbedtls_sha256_context& sha);
+
+// Continues an interrupted install (ota_resume.h) and reports its progress
+struct OtaResume {
+  size_t offset;                  // Image bytes already in the partition (sector aligned)
+  mbedtls_sha256_context sha;     // Digest state after them
+  OtaDurableCallback durable;
+  void* context;
+};
+
+// Streams expected.size bytes from source into the next OTA partition and
+// verifies them; on success that partition boots next (the caller restarts)
+bool installOtaImage(Client& source, const OtaExpectedImage& expected, OtaPipelineStats& stats);
+// Same, with the image produced by reader (e.g. a delta patch, ota_delta.h);
+// with resume, reading starts at resume->offset instead of 0
+bool installOtaImageFrom(OtaImageReader reader, void* context, const OtaExpectedImage& expected,
+                         OtaPipelineStats& stats, OtaResume* resume = nullptr);
+const OtaPipelineStats& getLastOtaStats();
+void printOtaStats(const OtaPipelineStats& stats);
+
+// Reads length bytes from the connection; short only on timeout or close
+size_t readOtaStream(Client& source, uint8_t* data, size_t length);
+
+// Manifest "checksum" field: 64 hex digits
+bool parseSha256Hex(const char* hex, uint8_t* digest);
+
+#endif // OTA_PIPELINE_H
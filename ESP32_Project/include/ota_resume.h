@@ -0,0 +1,67 @@
+#ifndef OTA_RESUME_H
+#define OTA_RESUME_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "ota_pipeline.h"
+
+/**
+ * Resumable, compressed OTA downloads for AI Teddy Bear ESP32
+ *
+ * A dropped connection no longer restarts the image from byte zero:
+ *  - within an attempt the download reconnects with an HTTP Range request
+ *    at the exact byte it stopped at (OTA_RESUME_RETRIES times, backing off)
+ *  - across attempts and reboots a checkpoint in NVS records how much of
+ *    the image is in flash and where the download continues. It is saved
+ *    every OTA_RESUME_INTERVAL bytes, once the writer has them in flash.
+ *
+ * The checkpoint keeps the SHA-256 of the written prefix rather than the
+ * raw hash context (the ESP32 SHA engine holds its state in hardware).
+ * Resuming re-hashes that prefix from flash, which both rebuilds the
+ * incremental state and proves the partition still holds those bytes.
+ * Checkpoints are keyed by the target image digest, size and partition, so
+ * a different update starts over.
+ *
+ * The download is either the raw image or a packed container
+ * (scripts/ota_pack.py), detected by its magic:
+ *
+ *   header   "TBIZ", version, window bits, 2 reserved bytes, image size,
+ *            block size, SHA-256 of the image
+ *   blocks   compressed length, then raw deflate data for block size image
+ *            bytes (less for the last block)
+ *
+ * Blocks are compressed independently, so a packed download can resume at
+ * any block boundary. Blocks inflate with the ROM inflater through a
+ * (1 << window bits) byte dictionary, as delta patches do (ota_delta.h).
+ */
+
+// Resume configuration
+#define OTA_RESUME_NVS_NAMESPACE   "ota_resume"
+#define OTA_RESUME_NVS_KEY         "checkpoint"
+#define OTA_RESUME_MAGIC           0x4F544152    // "OTAR"
+#define OTA_RESUME_VERSION         1
+#define OTA_RESUME_INTERVAL        (64 * 1024)   // Image bytes between checkpoints
+#define OTA_RESUME_RETRIES         5             // Reconnects per attempt
+#define OTA_RESUME_BACKOFF_MS      1000          // Doubles with each retry
+#define OTA_RESUME_HASH_CHUNK      4096          // Flash read size when re-hashing the prefix
+
+// Packed container
+#define OTA_PACKED_MAGIC           "TBIZ"
+#define OTA_PACKED_VERSION         1
+#define OTA_PACKED_HEADER_SIZE     48
+#define OTA_PACKED_MAX_WINDOW_BITS 15
+#define OTA_PACKED_INPUT_SIZE      1024
+
+// Opens the download at offset (an HTTP Range request when offset > 0) and
+// returns its stream; nullptr when it cannot, including a server that
+// ignores the range
+typedef Client* (*OtaConnectCallback)(void* context, size_t offset);
+
+// Installs expected (size and, for checkpoints, sha256 required) from a
+// download of downloadSize bytes, resuming a matching checkpoint if one is
+// saved. An interrupted download keeps its checkpoint for the next attempt.
+bool installResumableOta(OtaConnectCallback connect, void* context, size_t downloadSize,
+                         const OtaExpectedImage& expected, OtaPipelineStats& stats);
+void clearOtaCheckpoint();
+
+#endif // OTA_RESUME_H
@@ -0,0 +1,62 @@
+#ifndef PERF_CONSOLE_H
+#define PERF_CONSOLE_H
+
+#include <Arduino.h>
+#include "feature_config.h"
+
+/**
+ * Serial performance console for AI Teddy Bear ESP32 (debug builds)
+ *
+ * handlePerfConsole() drains whatever Serial has buffered into a line
+ * buffer and returns; it never waits for input. A complete line is split
+ * into whitespace-separated words and dispatched through a static command
+ * table:
+ *
+ *   help                          list commands
+ *   tasks | heap | lat            task/stack, heap/pool and latency tables
+ *   audio                         stage timings of the latest utterance
+ *   metrics | history | bus       registry, history and event bus dumps
+ *   anomaly                       detector baselines and heap trend
+ *   tap [on NAMES|off|save]       arm, disarm or save audio taps
+ *   net [rssi N|loss P|delay MS|off]   force network conditions
+ *   knob [name [value]]           list, read or change a tuning knob
+ *   bench [name|all] [iterations] run microbenchmarks
+ *
+ * Enabled by FEATURE_PERFORMANCE_COMMANDS (DEBUG_BUILD); otherwise every
+ * call compiles to nothing and no table or buffer is linked in.
+ */
+
+// Console configuration
+#define PERF_CONSOLE_LINE_MAX        96    // Longest accepted command line
+#define PERF_CONSOLE_MAX_ARGS        6     // Words per line, command included
+#define PERF_CONSOLE_MAX_READ        64    // Bytes consumed per loop iteration
+#define PERF_BENCH_DEFAULT_ITERATIONS 200
+#define PERF_BENCH_MAX_ITERATIONS    5000
+#define PERF_BENCH_PAYLOAD_BYTES     4096  // One audio chunk
+
+typedef void (*PerfCommandHandler)(int argc, char** argv);
+
+struct PerfCommand {
+  const char* name;
+  const char* usage;
+  PerfCommandHandler handler;
+};
+
+#if FEATURE_PERFORMANCE_COMMANDS
+
+void initPerfConsole();
+void handlePerfConsole();
+
+// Parsing and dispatch (split from the Serial side)
+int splitCommandLine(char* line, char** argv, int maxArgs);
+const PerfCommand* findPerfCommand(const char* name);
+bool executePerfCommand(char* line);
+
+#else
+
+inline void initPerfConsole() {}
+inline void handlePerfConsole() {}
+
+#endif // FEATURE_PERFORMANCE_COMMANDS
+
+#endif // PERF_CONSOLE_H
@@ -228,6 +228,7 @@ extern ProductionValidator* productionValidator;
 
 // Constants
 #define PRODUCTION_CHECK_INTERVAL_MS 60000  // 1 minute
+#define PRODUCTION_MONITOR_STACK_SIZE 8192
 #define PRODUCTION_REPORT_INTERVAL_MS 300000  // 5 minutes
 #define PRODUCTION_MIN_SECURITY_SCORE 85
 #define PRODUCTION_MIN_PERFORMANCE_SCORE 80
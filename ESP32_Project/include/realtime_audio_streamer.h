@@ -4,6 +4,7 @@
 #include "config.h"
 #include "audio_handler.h"
 #include "websocket_handler.h"
+#include "event_bus.h"
 #include <driver/i2s.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -112,6 +113,11 @@ public:
     void setSilenceThreshold(uint16_t threshold) { silenceThreshold = threshold; }
     void setChunkSize(size_t size);
     
+    // Memory budget controls
+    void setMaxChunkSize(size_t size);
+    bool setRingBufferSize(size_t size);   // Fails while streaming
+    size_t getRingBufferSize() const { return ringBufferSize; }
+    
     // Cleanup
     void cleanup();
 
@@ -119,6 +125,7 @@ private:
     // Core streaming implementation
     void audioStreamingTask();
     static void audioStreamingTaskWrapper(void* parameter);
+    static void onConnectionEvent(const Event& event);
     
     // Audio processing
     bool detectVoiceActivity(int16_t* samples, size_t count);
@@ -126,7 +133,7 @@ private:
     bool applyRealTimeEnhancements(int16_t* samples, size_t count);
     
     // Network transmission
-    void sendAudioChunk(uint8_t* chunk, size_t size);
+    void sendAudioChunk(const AudioFrame& chunk);
     void handleServerAudioResponse(uint8_t* audioData, size_t length);
     bool sendChunkWithRetry(const AudioChunk& chunk, uint8_t maxRetries = 3);
     
@@ -188,6 +195,9 @@ private:
     // Network adaptation
     NetworkState networkState;
     uint32_t networkCheckInterval;
+    size_t maxChunkSize;            // Adaptive growth ceiling (lowered under memory pressure)
+    EventSubscriberId eventSubscriber;
+    bool linkUp;                    // WebSocket state as seen from the streaming task
     
     // Performance tracking
     RTSMetrics metrics;
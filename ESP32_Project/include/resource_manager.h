@@ -4,12 +4,17 @@
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <atomic>
 
 // Resource tracking configuration
 #define MAX_TRACKED_RESOURCES 100
-#define POOL_ALLOCATION_THRESHOLD 512  // Use pool for allocations <= 512 bytes
+#define POOL_ALLOCATION_THRESHOLD 6144   // Larger requests bypass the pools (largest size class)
+#define POOL_PSRAM_MIN_BLOCK 4096        // Size classes from here up prefer PSRAM when present
 #define LOW_MEMORY_THRESHOLD 10000     // Consider memory low below 10KB
-#define MEMORY_LEAK_THRESHOLD 300000   // 5 minutes in milliseconds
+#define MEMORY_LEAK_THRESHOLD 300000   // Age reported as "aged" (5 minutes); not a leak signal
+#define MAX_ALLOCATION_SITES 32        // Distinct (name, caller) pairs tracked; idle ones are recycled
+#define LEAK_CHECK_INTERVAL 60000      // Leak scan period (ms)
+#define LEAK_GROWTH_CHECKS 3           // Consecutive growing scans before a site is flagged
 
 // Resource tracking structure
 struct ResourceTracker {
@@ -19,6 +24,32 @@ struct ResourceTracker {
   char name[32];
 };
 
+// Compact per-allocation record (24 bytes)
+struct AllocationRecord {
+  void* ptr;
+  uint32_t size;
+  uint32_t timestamp;   // millis() at allocation
+  char task[8];         // Allocating task (truncated name)
+  uint8_t site;         // Index into the site table
+  bool carved;          // Allocation shrank the largest free block
+};
+
+// Aggregated statistics per allocation site
+struct AllocationSite {
+  const char* name;         // Label passed to trackMalloc
+  uint32_t caller;          // Return address of the trackMalloc caller
+  uint32_t liveCount;
+  uint32_t liveBytes;
+  uint32_t peakBytes;
+  uint32_t totalAllocs;
+  uint32_t totalFrees;
+  uint32_t carvedBytes;     // Live bytes that were cut from the largest free block
+  uint32_t agedCount;       // Live allocations older than MEMORY_LEAK_THRESHOLD (informational)
+  uint32_t bytesAtLastCheck;
+  uint8_t growthStreak;     // Consecutive leak scans with growing liveBytes
+  bool suspectedLeak;
+};
+
 // Resource statistics structure
 struct ResourceStats {
     uint32_t heapFragmentation;
@@ -49,9 +80,15 @@ void trackFree(void* ptr, const char* name = nullptr);
 bool addResourceTracker(void* ptr, size_t size, const char* name);
 bool removeResourceTracker(void* ptr);
 
+// Allocation-site tracking
+size_t getAllocationSiteCount();
+const AllocationSite* getAllocationSite(size_t index);
+size_t getTrackedBytesForSite(const char* name);
+void dumpAllocationSnapshot();
+
 // Memory management functions
 void printResourceStatus();
-void detectMemoryLeaks();
+int detectMemoryLeaks();
 void forceGarbageCollection();
 size_t getAvailableMemory();
 size_t getTotalAllocatedMemory();
@@ -113,26 +150,66 @@ public:
 };
 
 // Memory pool management
+//
+// Fixed-block allocator: one size class, a bitmap of used blocks updated with
+// compare-and-swap, so allocate()/deallocate() take no lock and are safe from
+// any task. Storage (blocks + bitmap) is reserved on first use and kept, so a
+// steady stream of equally sized buffers never touches the heap.
+struct MemoryPoolStats {
+  size_t blockSize;
+  size_t totalBlocks;
+  size_t usedBlocks;
+  size_t highWater;         // Most blocks in use at once
+  uint32_t allocations;
+  uint32_t exhausted;       // allocate() calls that found no free block
+  bool inPsram;
+};
+
 class MemoryPool {
 private:
-  uint8_t* pool;
+  std::atomic<uint8_t*> pool;
   size_t size;
-  size_t used;
-  bool* allocation_map;
+  std::atomic<uint32_t> used;
   size_t block_size;
   size_t num_blocks;
-  
+  bool prefer_psram;
+  bool in_psram;
+  std::atomic<uint32_t> high_water;
+  std::atomic<uint32_t> allocations;
+  std::atomic<uint32_t> exhausted;
+
+  bool reserve();
+  std::atomic<uint32_t>* allocationMap(uint8_t* base) const;  // One bit per block, set = in use
+
 public:
-  MemoryPool(size_t poolSize, size_t blockSize);
+  MemoryPool(size_t poolSize, size_t blockSize, bool preferPsram = false);
   ~MemoryPool();
   
   void* allocate();
   void deallocate(void* ptr);
+  bool owns(const void* ptr) const;
+  size_t getBlockSize() const { return block_size; }
   size_t getFreeBlocks();
   size_t getUsedBlocks();
+  MemoryPoolStats getStats();
   void printStatus();
+
+  // Prevent copying
+  MemoryPool(const MemoryPool&) = delete;
+  MemoryPool& operator=(const MemoryPool&) = delete;
 };
 
+// Size-classed pool front end: a request is served by the smallest class it
+// fits, and only when it fills more than half a block. Anything else, or a
+// request whose class is exhausted, goes to malloc (counted as pool.fallback);
+// classes never lend blocks to each other. poolFree() accepts either.
+void* poolAlloc(size_t size);
+void poolFree(void* ptr);
+size_t getMemoryPoolCount();
+bool getMemoryPoolStats(size_t index, MemoryPoolStats& out);
+uint32_t getPoolFallbackCount();
+void printMemoryPools();
+
 // Helper functions for memory monitoring
 void setupMemoryMonitoring();
 void handleMemoryWarning();
@@ -0,0 +1,49 @@
+#ifndef SAMPLING_PROFILER_H
+#define SAMPLING_PROFILER_H
+
+#include <Arduino.h>
+
+/**
+ * Sampling CPU Profiler for AI Teddy Bear ESP32
+ *
+ * A hardware timer interrupt on each core records the interrupted PC, its
+ * caller (windowed a0) and the running task into a per-core ring. Rings are
+ * only allocated while a profile is active, so an idle profiler costs no RAM.
+ *
+ * Dump format "TPRF" v1 (little-endian), sent base64-encoded in 57-byte
+ * lines (Serial: "[PROF] ..." between [PROF][BEGIN]/[PROF][END]; WebSocket:
+ * "profile_chunk" messages). scripts/profile_symbolize.py decodes it.
+ *
+ *   header  : "TPRF" u8 version, u8 cores, u16 hz, u32 samples, u32 dropped,
+ *             u16 task_count, u16 reserved
+ *   tasks   : task_count x { u32 handle, char name[16] }
+ *   samples : samples x { u32 pc, u32 caller, u32 task }
+ */
+
+// Profiler configuration
+#define PROFILER_DEFAULT_HZ        997    // Prime rate avoids locking onto periodic work
+#define PROFILER_MAX_HZ            5000
+#define PROFILER_SAMPLES_PER_CORE  512    // 12 bytes each
+#define PROFILER_TIMER_BASE        2      // Hardware timers 2 and 3 (0/1 left to the app)
+#define PROFILER_FORMAT_VERSION    1
+
+struct ProfileSample {
+  uint32_t pc;
+  uint32_t caller;
+  uint32_t task;
+};
+
+// Control (durationMs > 0 stops and uploads automatically via handleProfiler)
+bool startProfiler(uint32_t sampleHz = PROFILER_DEFAULT_HZ, uint32_t durationMs = 0);
+void stopProfiler();
+bool isProfilerRunning();
+void handleProfiler();
+
+// Results
+uint32_t getProfilerSampleCount();
+uint32_t getProfilerDroppedCount();
+void dumpProfile();              // To Serial
+bool sendProfileReport();        // To server over WebSocket
+void releaseProfile();
+
+#endif // SAMPLING_PROFILER_H
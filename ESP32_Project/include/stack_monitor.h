@@ -0,0 +1,76 @@
+#ifndef STACK_MONITOR_H
+#define STACK_MONITOR_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/**
+ * Stack high-water monitoring for AI Teddy Bear ESP32
+ *
+ * Tasks register their stack size when created; every STACK_MONITOR_INTERVAL
+ * the monitor reads uxTaskGetStackHighWaterMark() and keeps the lowest free
+ * margin each task has ever had, across restarts of the same task name
+ * (adc_capture_task runs once per utterance). A task ending on its own calls
+ * noteTaskStackExit() so its final mark is kept after the handle goes away.
+ *
+ * A warning is printed once per task when its margin drops below
+ * STACK_WARN_FREE_BYTES or STACK_WARN_USED_PERCENT, and again at
+ * STACK_CRITICAL_FREE_BYTES. printStackReport() lists peak use and a
+ * suggested size per task, plus [STACK][TASK] lines that
+ * scripts/stack_report.py merges with the -fstack-usage output of the build
+ * to flag functions with large frames.
+ *
+ * With STACK_MONITOR_ISR the per-core interrupt stacks are painted at init
+ * and scanned for their watermark too (debug builds). Each core paints its
+ * own stack with interrupts masked, from its IPC task.
+ *
+ * The perf console "stack" command prints the report.
+ */
+
+// Monitor configuration
+#define STACK_MONITOR_MAX_TASKS     12
+#define STACK_MONITOR_INTERVAL      5000   // Sampling period (ms)
+#define STACK_WARN_FREE_BYTES       1024
+#define STACK_WARN_USED_PERCENT     85
+#define STACK_CRITICAL_FREE_BYTES   384
+#define STACK_SIZING_MARGIN_PERCENT 25     // Headroom on top of peak use
+#define STACK_SIZING_MIN_MARGIN     1024   // ...but at least this many bytes
+#define STACK_SIZING_GRANULARITY    512
+
+#ifndef STACK_MONITOR_ISR
+#ifdef DEBUG_BUILD
+#define STACK_MONITOR_ISR 1
+#else
+#define STACK_MONITOR_ISR 0
+#endif
+#endif
+
+struct StackUsageEntry {
+  char name[configMAX_TASK_NAME_LEN];
+  TaskHandle_t handle;      // nullptr while the task is not running
+  uint32_t stackSize;       // Bytes, as passed to xTaskCreate
+  uint32_t minFree;         // Lowest high-water mark seen (bytes)
+  uint32_t lastFree;
+  uint8_t warnLevel;        // 0 none, 1 warned, 2 critical
+  int8_t isrCore;           // Interrupt stack of this core, -1 for tasks
+};
+
+// Lifecycle
+bool initStackMonitor();
+void handleStackMonitor();
+
+// Registration (call right after xTaskCreate, or from the task itself)
+void registerTaskStack(TaskHandle_t task, const char* name, uint32_t stackBytes);
+void registerCurrentTaskStack(const char* name, uint32_t stackBytes);
+void noteTaskStackExit();   // From the task, just before vTaskDelete(NULL)
+void forgetTaskStack(TaskHandle_t task);   // Before deleting another task
+
+// Queries
+void sampleStackUsage();
+uint32_t getStackSuggestion(const StackUsageEntry& entry);
+size_t getStackEntryCount();
+const StackUsageEntry* getStackEntryAt(size_t index);
+void printStackReport();
+
+#endif // STACK_MONITOR_H
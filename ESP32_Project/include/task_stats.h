@@ -0,0 +1,65 @@
+#ifndef TASK_STATS_H
+#define TASK_STATS_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "metrics_registry.h"
+
+/**
+ * Per-task CPU Accounting for AI Teddy Bear ESP32
+ *
+ * Samples uxTaskGetSystemState() every TASK_STATS_INTERVAL and derives, per
+ * FreeRTOS task: CPU share of its core, the largest run time seen in one
+ * window, and how often it was runnable but not running (contention).
+ * Core load comes from the per-core idle tasks. Results are published as
+ * registry gauges ("cpu.core0", "task.<name>.cpu", ...).
+ *
+ * When the kernel is built without run-time stats, CPU usage falls back to
+ * the main-loop busy fraction measured by recordLoopIteration().
+ */
+
+// Task stats configuration
+#define TASK_STATS_MAX_TASKS     METRICS_TASK_GAUGES   // Each task gets a cpu gauge
+#define TASK_STATS_INTERVAL      5000   // Sampling window (ms)
+#define LOOP_STALL_THRESHOLD_MS  100    // Loop iterations slower than this count as stalls
+
+#if defined(configUSE_TRACE_FACILITY) && defined(configGENERATE_RUN_TIME_STATS) && \
+    configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+#define TASK_STATS_RUNTIME_AVAILABLE 1
+#else
+#define TASK_STATS_RUNTIME_AVAILABLE 0
+#endif
+
+struct TaskStatsEntry {
+  char name[configMAX_TASK_NAME_LEN];
+  char metricName[configMAX_TASK_NAME_LEN + 10];  // "task.<name>.cpu"
+  TaskHandle_t handle;
+  uint32_t lastRunTime;       // Run-time counter at previous sample
+  uint32_t maxWindowRunTime;  // Largest per-window run time (us)
+  uint32_t readyObservations; // Samples where the task was runnable but not running
+  uint32_t stackHighWater;    // Bytes
+  float cpuPercent;           // Share of one core over the last window
+  UBaseType_t priority;
+  int8_t core;                // -1 when not pinned
+  MetricId cpuGauge;
+  bool seen;                  // Present in the latest sample
+};
+
+// Initialization and periodic sampling
+bool initTaskStats();
+void handleTaskStats();
+void sampleTaskStats();
+
+// Main loop timing (called once per loop iteration, excluding the idle delay)
+void recordLoopIteration(uint32_t busyUs);
+
+// Queries
+float getCoreCpuPercent(int core);
+float getTotalCpuPercent();
+const TaskStatsEntry* getTaskStats(const char* name);
+size_t getTaskStatsCount();
+const TaskStatsEntry* getTaskStatsAt(size_t index);
+void printTaskStats();
+
+#endif // TASK_STATS_H
@@ -0,0 +1,91 @@
+#ifndef UTTERANCE_TRACE_H
+#define UTTERANCE_TRACE_H
+
+#include <Arduino.h>
+
+/**
+ * Utterance Latency Tracing for AI Teddy Bear ESP32
+ *
+ * Records lightweight spans (capture, encode, send, decode, playback) tagged
+ * with a per-utterance correlation id into a fixed ring buffer. The id is
+ * carried in audio_start / audio_chunk / audio_end so server spans can be
+ * joined with device spans.
+ *
+ * Dump format (one line per event, consumed by scripts/trace_export.py):
+ *   [TRACE][SYNC] {"utt":..,"dev_us":..,"epoch_ms":..}
+ *   [TRACE][EVT] {"utt":..,"span":"..","ph":"X","ts":..,"dur":..,"arg":..}
+ *
+ * Event timestamps are the low 32 bits of esp_timer_get_time(); the host
+ * unwraps them against the 64-bit SYNC anchor taken when the utterance began.
+ */
+
+// Trace configuration
+#define TRACE_RING_CAPACITY   256   // 16 bytes per event
+#define TRACE_DUMP_ON_COMPLETE 1    // Dump to Serial after playback (non-production)
+
+enum TraceSpan : uint8_t {
+  TRACE_SPAN_UTTERANCE,     // Button press → playback finished
+  TRACE_SPAN_CAPTURE,       // One ADC chunk captured
+  TRACE_SPAN_ENCODE,        // HMAC + base64 + JSON for one chunk
+  TRACE_SPAN_SEND,          // webSocket.sendTXT for one chunk
+  TRACE_SPAN_AUDIO_END,     // audio_end sent (instant)
+  TRACE_SPAN_RESPONSE,      // audio_response received (instant)
+  TRACE_SPAN_DECODE,        // base64 decode of the response
+  TRACE_SPAN_PLAYBACK,      // playAudioResponse
+  TRACE_SPAN_COUNT
+};
+
+struct TraceEvent {
+  uint32_t ts_us;           // Low 32 bits of esp_timer_get_time()
+  uint32_t dur_us;          // 0 for instant events
+  uint32_t utterance;       // Correlation id
+  uint16_t arg;             // Span-specific: bytes or chunk index, saturated by traceArg()
+  uint8_t span;             // TraceSpan
+  uint8_t phase;            // 'X' complete, 'i' instant
+};
+
+// Utterance lifecycle
+uint32_t beginUtteranceTrace();
+void endUtteranceTrace();
+uint32_t getCurrentUtteranceId();
+
+// Recording (safe from any task on either core)
+uint32_t traceNow();
+static inline uint16_t traceArg(size_t value) {
+  return value > UINT16_MAX ? UINT16_MAX : (uint16_t)value;
+}
+void traceComplete(TraceSpan span, uint32_t startUs, uint16_t arg = 0);
+void traceInstant(TraceSpan span, uint16_t arg = 0);
+
+// Scoped span, recorded when the scope exits
+class TraceScope {
+public:
+  explicit TraceScope(TraceSpan traceSpan, uint16_t traceArg = 0)
+    : span(traceSpan), arg(traceArg), start(traceNow()) {}
+  ~TraceScope() { traceComplete(span, start, arg); }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+  TraceSpan span;
+  uint16_t arg;
+  uint32_t start;
+};
+
+// Per-stage totals of one utterance (complete spans only)
+struct TraceStageStats {
+  uint16_t count;
+  uint32_t totalUs;
+  uint32_t maxUs;
+};
+
+// Export
+const char* getTraceSpanName(TraceSpan span);
+uint32_t getTraceStageStats(TraceStageStats stats[TRACE_SPAN_COUNT]);   // Latest utterance, 0 if none
+void printTraceStageSummary();
+size_t getTraceEventCount();
+void dumpUtteranceTrace(uint32_t utterance);
+void clearUtteranceTrace();
+
+#endif // UTTERANCE_TRACE_H
@@ -0,0 +1,37 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+/**
+ * Precompressed web pages for AI Teddy Bear ESP32
+ *
+ * The captive portal and OTA status pages are built from web/ by
+ * scripts/web_assets.py into gzip blobs in flash (src/web_assets_data.h).
+ * They are sent as-is with Content-Encoding: gzip straight from flash, so
+ * serving a page allocates nothing beyond the response headers - which
+ * matters most in AP mode, when the heap is at its most fragile.
+ *
+ * Each asset carries an ETag; a request whose If-None-Match matches gets an
+ * empty 304. Pages are static: per-device values come from /status.
+ */
+
+#define WEB_ASSET_CACHE_CONTROL "no-cache"   // Cache, but revalidate (firmware updates change pages)
+
+struct WebAsset {
+  const char* name;          // File name under web/
+  const char* contentType;
+  const uint8_t* data;       // gzip, in flash
+  size_t length;
+  const char* etag;          // Quoted, as sent
+};
+
+const WebAsset* findWebAsset(const char* name);
+
+// Sends name as a 200 (or 304 on a matching If-None-Match); 404 if unknown.
+// The server must collect If-None-Match (see collectWebAssetHeaders).
+bool sendWebAsset(WebServer& server, const char* name);
+void collectWebAssetHeaders(WebServer& server);
+
+#endif // WEB_ASSETS_H
@@ -4,6 +4,8 @@
 #include <WebSocketsClient.h>
 #include <ArduinoJson.h>
 #include "config.h"
+#include "feature_config.h"
+#include "audio_frame.h"
 
 extern WebSocketsClient webSocket;
 extern bool isConnected;
@@ -11,7 +13,7 @@ extern bool isConnected;
 // WebSocket functions
 void initWebSocket();
 void webSocketEvent(WStype_t type, uint8_t * payload, size_t length);
-void handleIncomingMessage(String message);
+void handleIncomingMessage(const char* message, size_t length);
 void reconnectWebSocket();
 void connectWebSocket();
 
@@ -23,10 +25,15 @@ void sendButtonEvent();
 void sendResponse(String status, String message, String requestId = "");
 void sendDeviceStatus();
 void sendAudioData(uint8_t* audioData, size_t length);
+void sendAudioDataWebSocket(const uint8_t* audioData, size_t length, bool finalChunk = false);
+
+// Pooled text frames with WebSocket header headroom (audio hot path)
+#define AUDIO_TEXT_PREFIX_LENGTH 15   // {"audio_data":"
+AudioFrame buildAudioTextFrame(const uint8_t* pcm, size_t length, JsonDocument& meta);
+bool sendTextFrame(AudioFrame& frame);
 // Audio session helpers
 void sendAudioStartSession();
 void sendAudioEndSession();
-void markNextChunkFinal();
 
 // Command handlers
 void handleLEDCommand(JsonObject params);
@@ -41,10 +48,29 @@ void logMessage(String direction, String message);
 
 // Network performance optimization
 size_t getOptimalChunkSize();
+size_t getAdaptiveChunkSize();
+void setAdaptiveChunkSize(size_t bytes);
 void adjustChunkSizeDown();
 void adjustChunkSizeUp();
 void printNetworkStats();
 
+// Smallest capture chunk a link anomaly shrinks to (32 ms at 16 kHz)
+#define WS_LINK_DOWNSHIFT_MIN_CHUNK 1024
+
+#if FEATURE_PERFORMANCE_COMMANDS
+// Forced network conditions for testing the adaptation paths (debug builds)
+#define WS_FORCED_DELAY_MAX_MS 1000
+
+struct ForcedNetworkConditions {
+  int8_t rssi;            // dBm seen by chunk sizing and scoring; 0 = measured
+  uint8_t lossPercent;    // Audio chunks dropped instead of sent
+  uint16_t delayMs;       // Added before each audio chunk send
+};
+
+void setForcedNetworkConditions(const ForcedNetworkConditions& conditions);
+ForcedNetworkConditions getForcedNetworkConditions();
+#endif
+
 // Connection health monitoring
 void updateConnectionQuality();
 void sendPingFrame();
@@ -61,16 +87,18 @@ void scheduleReconnection(unsigned long delayMs);
 
 // Enhanced connection management
 void handleWebSocketLoop();
+void initWebSocketEvents();     // Subscribe to bus events (idempotent)
+void flushWebSocketEvents();    // Deliver everything queued for the socket now
 void sendConnectionHealthReport();
 bool isConnectionHealthy();
 void resetConnectionStats();
 
 // New server protocol handlers
-void handleWelcomeMessage(DynamicJsonDocument& doc);
-void handlePolicyUpdate(DynamicJsonDocument& doc);
-void handleSecurityAlert(DynamicJsonDocument& doc);
-void handleAuthenticationResponse(DynamicJsonDocument& doc, bool success);
+void handleWelcomeMessage(JsonDocument& doc);
+void handlePolicyUpdate(JsonDocument& doc);
+void handleSecurityAlert(JsonDocument& doc);
+void handleAuthenticationResponse(JsonDocument& doc, bool success);
 void handleIncomingAudioFrame(uint8_t* audioData, size_t length);
-bool handleJWTRefreshMessage(const String& refreshMessage);
+bool handleJWTRefreshMessage(const char* refreshMessage);
 
 #endif
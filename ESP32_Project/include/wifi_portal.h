@@ -13,7 +13,6 @@ bool isConfigurationComplete();
 
 // Internal Functions
 void setupPortalRoutes();
-String generatePortalHTML();
 void handlePortalRoot();
 void handleNetworkScan();
 void handleWiFiConnect();
@@ -0,0 +1,52 @@
+#ifndef WIFI_SCAN_CACHE_H
+#define WIFI_SCAN_CACHE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+/**
+ * Background WiFi scan cache for the setup portal
+ *
+ * A blocking WiFi.scanNetworks() stalls the portal's HTTP and captive DNS
+ * handling for seconds. Instead scans run asynchronously from the portal
+ * loop: one when the portal starts, then every WIFI_SCAN_INTERVAL_MS, and
+ * sooner when a request finds the results older than WIFI_SCAN_FRESH_MS.
+ *
+ * Requests are answered at once from the cache (stale-while-revalidate):
+ * stale results are still served, flagged, while the rescan they triggered
+ * runs. Results are deduplicated by SSID (strongest access point kept),
+ * hidden networks dropped, and sorted by signal.
+ */
+
+// Scan configuration
+#define WIFI_SCAN_MAX_RESULTS    20
+#define WIFI_SCAN_FRESH_MS       15000   // Younger results are served without a rescan
+#define WIFI_SCAN_INTERVAL_MS    60000   // Background rescan period
+#define WIFI_SCAN_RETRY_MS       5000    // Minimum gap after a failed or abandoned scan
+#define WIFI_SCAN_TIMEOUT_MS     10000   // A scan running longer is abandoned
+#define WIFI_SCAN_CHANNEL_MS     120     // Active dwell per channel (AP clients wait meanwhile)
+
+struct WifiScanEntry {
+  char ssid[33];
+  int8_t rssi;
+  uint8_t channel;
+  wifi_auth_mode_t auth;
+};
+
+struct WifiScanSnapshot {
+  const WifiScanEntry* entries;   // Strongest first; valid until the next updateWifiScanCache()
+  uint8_t count;
+  bool valid;                     // A scan has completed
+  bool stale;                     // Older than WIFI_SCAN_FRESH_MS
+  bool scanning;                  // A rescan is running
+  uint32_t ageMs;
+};
+
+void beginWifiScanCache();
+void updateWifiScanCache();       // Call from the loop that serves the portal
+void stopWifiScanCache();
+
+// Never blocks; stale or missing results schedule a rescan
+WifiScanSnapshot getWifiScanResults();
+
+#endif // WIFI_SCAN_CACHE_H
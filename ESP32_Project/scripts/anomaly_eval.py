@@ -0,0 +1,340 @@
+#!/usr/bin/env python3
+"""
+Anomaly Detector Evaluation for AI Teddy Bear
+Replays metric traces through host copies of the on-device detectors (EWMA
+outliers, CUSUM shifts, heap slope) and reports when each grade is raised.
+Parameters are read from include/anomaly_detector.h, the sigma floors from
+src/anomaly_detector.cpp, so the replay follows the firmware as it is tuned.
+
+Synthetic scenarios have a known change point; each is run with several
+noise seeds and scored for detection rate, delay and false alarms before
+the change. Recorded traces can be a /history JSON export or a CSV of
+"seconds,value" rows.
+
+Usage:
+  anomaly_eval.py                                  # all synthetic scenarios
+  anomaly_eval.py --scenario rtt_step --runs 50
+  anomaly_eval.py --trace history.json             # series taken from the file
+  anomaly_eval.py --trace rtt.csv --signal ws.rtt --change-at 900
+"""
+
+import re
+import sys
+import csv
+import json
+import math
+import random
+import argparse
+from pathlib import Path
+
+PROJECT_DIR = Path(__file__).resolve().parent.parent
+HEADER = PROJECT_DIR / "include" / "anomaly_detector.h"
+SOURCE = PROJECT_DIR / "src" / "anomaly_detector.cpp"
+BUDGET_HEADER = PROJECT_DIR / "include" / "memory_budget.h"
+
+SEVERITY_NAMES = ["none", "notice", "warning", "critical"]
+NONE, NOTICE, WARNING, CRITICAL = range(4)
+
+# Signals whose drop (not rise) is bad, as in SIGNALS[] on the device
+LOW_IS_WORSE = {"wifi.rssi", "heap.free"}
+
+def load_parameters():
+    """ANOMALY_* defines, sigma floors and the critical heap floor"""
+    params = {}
+    for name, value in re.findall(r"#define\s+(ANOMALY_\w+)\s+([-\d.]+)f?\b", HEADER.read_text()):
+        params[name] = float(value)
+    floors = {}
+    for value, signal in re.findall(r"EwmaDetector\(ANOMALY_EWMA_ALPHA,\s*([\d.]+)f\),\s*//\s*(\S+)",
+                                    SOURCE.read_text()):
+        floors[signal] = float(value)
+    match = re.search(r"#define\s+MEM_BUDGET_FREE_CRITICAL\s+\(([\d\s*]+)\)", BUDGET_HEADER.read_text())
+    params["MEM_BUDGET_FREE_CRITICAL"] = eval(match.group(1)) if match else 32 * 1024
+    return params, floors
+
+# =============================================================================
+# DETECTORS (mirror src/anomaly_detector.cpp)
+# =============================================================================
+
+class Ewma:
+    def __init__(self, p, min_sigma):
+        self.p = p
+        self.min_sigma = min_sigma
+        self.mean = 0.0
+        self.var = 0.0
+        self.samples = 0
+
+    def warmed_up(self):
+        return self.samples >= self.p["ANOMALY_WARMUP_SAMPLES"]
+
+    def sigma(self):
+        return max(math.sqrt(self.var), self.min_sigma)
+
+    def score(self, x):
+        return (x - self.mean) / self.sigma()
+
+    def update(self, x):
+        alpha = self.p["ANOMALY_EWMA_ALPHA"]
+        if self.samples == 0:
+            self.mean, self.var = x, 0.0
+        else:
+            limit = self.p["ANOMALY_Z_CLIP"] * self.sigma()
+            d = min(max(x - self.mean, -limit), limit)
+            self.mean += alpha * d
+            self.var = (1.0 - alpha) * (self.var + alpha * d * d)
+        self.samples += 1
+
+class Cusum:
+    def __init__(self, p):
+        self.p = p
+        self.sum = 0.0
+
+    def update(self, z):
+        clip = self.p["ANOMALY_Z_CLIP"]
+        z = min(max(z, -clip), clip)
+        self.sum = max(0.0, self.sum + z - self.p["ANOMALY_CUSUM_SLACK"])
+        return self.sum
+
+def fit_slope(values):
+    """Slope per sample and its t statistic"""
+    n = len(values)
+    mean_x = (n - 1) / 2.0
+    mean_y = sum(values) / n
+    sxx = sum((i - mean_x) ** 2 for i in range(n))
+    sxy = sum((i - mean_x) * (v - mean_y) for i, v in enumerate(values))
+    syy = sum((v - mean_y) ** 2 for v in values)
+    slope = sxy / sxx
+    residual = max(syy - slope * sxy, 0.0) / (n - 2)
+    stderr = math.sqrt(residual / sxx)
+    t = slope / stderr if stderr > 0 else math.copysign(math.inf, slope)
+    return slope, t
+
+def run_baseline_signal(p, min_sigma, low_is_worse, samples, step_s):
+    """[(seconds, severity, detector)] for a latency/RSSI series; None = no sample"""
+    ewma, cusum = Ewma(p, min_sigma), Cusum(p)
+    severity = NONE
+    last_notice = None
+    events = []
+    for i, x in enumerate(samples):
+        if x is None:
+            continue
+        t = i * step_s
+        if not ewma.warmed_up():
+            ewma.update(x)
+            continue
+        z = ewma.score(x)
+        if low_is_worse:
+            z = -z
+        s = cusum.update(z)
+        ewma.update(x)
+
+        level = CRITICAL if s >= p["ANOMALY_CUSUM_CRITICAL"] else WARNING if s >= p["ANOMALY_CUSUM_WARNING"] else NONE
+        if level > severity:
+            events.append((t, level, "cusum"))
+            severity = level
+        elif level == NONE and s == 0.0:
+            severity = NONE
+
+        hold_s = p["ANOMALY_NOTICE_HOLD"] / 1000.0
+        if severity < WARNING and z >= p["ANOMALY_Z_NOTICE"] and (last_notice is None or t - last_notice >= hold_s):
+            last_notice = t
+            events.append((t, NOTICE, "ewma"))
+    return events
+
+def run_heap(p, samples, step_s):
+    """[(seconds, severity, detector)] for a free-heap series"""
+    interval_s = p["ANOMALY_HEAP_SAMPLE_INTERVAL"] / 1000.0
+    per_sample = max(1, int(round(interval_s / step_s)))
+    window = int(p["ANOMALY_HEAP_WINDOW"])
+    points, events = [], []
+    severity = NONE
+    for start in range(0, len(samples) - per_sample + 1, per_sample):
+        chunk = [v for v in samples[start:start + per_sample] if v is not None]
+        if not chunk:
+            continue
+        free = max(chunk)   # Highest level of the interval, as on the device
+        points = (points + [free])[-window:]
+        if len(points) < window:
+            continue
+        slope, t = fit_slope(points)
+        per_hour = slope * 3600.0 / (per_sample * step_s)
+        level = NONE
+        if per_hour <= -p["ANOMALY_HEAP_LEAK_WARNING"] and t <= -p["ANOMALY_HEAP_MIN_T"]:
+            level = WARNING
+            headroom = free - p["MEM_BUDGET_FREE_CRITICAL"]
+            if headroom <= 0 or headroom / -per_hour * 3600.0 < p["ANOMALY_HEAP_CRITICAL_HORIZON"]:
+                level = CRITICAL
+        if level > severity:
+            events.append(((start + per_sample) * step_s, level, "slope"))
+            severity = level
+        elif level == NONE:
+            severity = NONE
+    return events
+
+def run_signal(p, floors, signal, samples, step_s):
+    if signal == "heap.free":
+        return run_heap(p, samples, step_s)
+    if signal not in floors:
+        raise SystemExit(f"❌ Unknown signal {signal} (known: {', '.join(sorted(floors))}, heap.free)")
+    return run_baseline_signal(p, floors[signal], signal in LOW_IS_WORSE, samples, step_s)
+
+# =============================================================================
+# SYNTHETIC SCENARIOS
+# =============================================================================
+
+def scenario_rtt_step(rng):
+    return "ws.rtt", 1.0, 900, [40 + rng.gauss(0, 4) + (15 if t >= 900 else 0) for t in range(1800)]
+
+def scenario_rtt_ramp(rng):
+    return "ws.rtt", 1.0, 900, [40 + rng.gauss(0, 4) + max(0, t - 900) * 0.2 for t in range(1800)]
+
+def scenario_rtt_drift(rng):
+    # 3 ms per minute: the baseline lags by slope / alpha = 1 ms and follows it
+    return "ws.rtt", 1.0, 900, [40 + rng.gauss(0, 4) + max(0, t - 900) * 0.05 for t in range(1800)]
+
+def scenario_rtt_spikes(rng):
+    # Isolated retransmission spikes: notices at most, no shift
+    return "ws.rtt", 1.0, None, [40 + rng.gauss(0, 4) + (250 if rng.random() < 0.01 else 0) for t in range(1800)]
+
+def scenario_rtt_sparse_step(rng):
+    # Keepalive pings only: one RTT sample every 20 s
+    return "ws.rtt", 1.0, 7200, [(60 + rng.gauss(0, 6) + (25 if t >= 7200 else 0)) if t % 20 == 0 else None
+                                 for t in range(14400)]
+
+def scenario_send_step(rng):
+    return "ws.audio_send", 1.0, 600, [4000 + rng.gauss(0, 400) + (2500 if t >= 600 else 0) for t in range(1200)]
+
+def scenario_rssi_drop(rng):
+    return "wifi.rssi", 1.0, 900, [round(-55 + rng.gauss(0, 2) - (10 if t >= 900 else 0)) for t in range(1800)]
+
+def scenario_heap_leak(rng):
+    # Flat for an hour, then 8 KB/h lost; transient buffers below the level
+    return "heap.free", 1.0, 3600, [150000 - max(0, t - 3600) * 8192 / 3600.0 - abs(rng.gauss(0, 3000))
+                                    for t in range(4 * 3600)]
+
+def scenario_heap_flat(rng):
+    return "heap.free", 1.0, None, [150000 - abs(rng.gauss(0, 3000)) - (20000 if (t // 300) % 2 else 0)
+                                    for t in range(4 * 3600)]
+
+SCENARIOS = {
+    "rtt_step": scenario_rtt_step,
+    "rtt_ramp": scenario_rtt_ramp,
+    "rtt_drift": scenario_rtt_drift,
+    "rtt_spikes": scenario_rtt_spikes,
+    "rtt_sparse_step": scenario_rtt_sparse_step,
+    "send_step": scenario_send_step,
+    "rssi_drop": scenario_rssi_drop,
+    "heap_leak": scenario_heap_leak,
+    "heap_flat": scenario_heap_flat,
+}
+
+# Changes the detectors are not meant to catch (reported, not failed)
+UNDETECTABLE = {"rtt_drift"}
+
+def score_events(events, change_at):
+    """False alarms (warning+ before the change) and delay to warning/critical"""
+    false_alarms = sum(1 for t, level, _ in events if level >= WARNING and (change_at is None or t < change_at))
+    notices = sum(1 for _, level, _ in events if level == NOTICE)
+    delays = {}
+    if change_at is not None:
+        for level in (WARNING, CRITICAL):
+            hits = [t - change_at for t, lv, _ in events if lv >= level and t >= change_at]
+            delays[level] = hits[0] if hits else None
+    return false_alarms, notices, delays
+
+def evaluate_scenarios(p, floors, names, runs, seed):
+    print(f"  {'Scenario':<16} {'Signal':<14} {'Detected':>9} {'Warn delay':>11} {'Crit delay':>11} "
+          f"{'False':>6} {'Notices':>8}")
+    failures = 0
+    for name in names:
+        detected, false_total, notice_total = 0, 0, 0
+        warn_delays, crit_delays = [], []
+        change_at = None
+        for run in range(runs):
+            signal, step_s, change_at, samples = SCENARIOS[name](random.Random(seed + run))
+            events = run_signal(p, floors, signal, samples, step_s)
+            false_alarms, notices, delays = score_events(events, change_at)
+            false_total += false_alarms
+            notice_total += notices
+            if change_at is not None and delays[WARNING] is not None:
+                detected += 1
+                warn_delays.append(delays[WARNING])
+                if delays[CRITICAL] is not None:
+                    crit_delays.append(delays[CRITICAL])
+
+        def median(values):
+            return f"{sorted(values)[len(values) // 2]:.0f} s" if values else "-"
+
+        rate = f"{detected}/{runs}" if change_at is not None else "n/a"
+        print(f"  {name:<16} {signal:<14} {rate:>9} {median(warn_delays):>11} {median(crit_delays):>11} "
+              f"{false_total:>6} {notice_total:>8}")
+        missed = change_at is not None and detected < runs and name not in UNDETECTABLE
+        if false_total > 0 or missed:
+            failures += 1
+    return failures
+
+# =============================================================================
+# RECORDED TRACES
+# =============================================================================
+
+def load_trace(path, signal):
+    """(signal, step_s, samples) from a /history JSON export or a CSV"""
+    text = Path(path).read_text(encoding="utf-8", errors="replace")
+    if text.lstrip().startswith("{"):
+        doc = json.loads(text)
+        series = doc.get("series", signal)
+        if signal is None:
+            # History series names carry the percentile; detectors watch p50
+            signal = re.sub(r"\.p50$", "", series)
+        return signal, float(doc.get("step_s", 1)), doc.get("avg", [])
+
+    rows = [r for r in csv.reader(text.splitlines()) if r and not r[0].startswith("#")]
+    if rows and not re.match(r"^-?[\d.]+$", rows[0][0]):
+        rows = rows[1:]   # Header
+    times = [float(r[0]) for r in rows]
+    step_s = (times[-1] - times[0]) / (len(times) - 1) if len(times) > 1 else 1.0
+    samples = [float(r[1]) if len(r) > 1 and r[1] not in ("", "null") else None for r in rows]
+    if signal is None:
+        raise SystemExit("❌ --signal is required for CSV traces")
+    return signal, step_s, samples
+
+def main():
+    """Main function"""
+    parser = argparse.ArgumentParser(description="Evaluate the on-device anomaly detectors on traces")
+    parser.add_argument("--scenario", choices=sorted(SCENARIOS), action="append",
+                        help="Synthetic scenario (repeatable, default: all)")
+    parser.add_argument("--runs", type=int, default=20, help="Noise seeds per scenario")
+    parser.add_argument("--seed", type=int, default=1, help="First noise seed")
+    parser.add_argument("--trace", help="Recorded trace: /history JSON or CSV of seconds,value")
+    parser.add_argument("--signal", help="Signal of a CSV trace (ws.rtt, ws.audio_send, audio.latency, wifi.rssi, heap.free)")
+    parser.add_argument("--change-at", type=float, help="Known change point of the trace (seconds)")
+    args = parser.parse_args()
+
+    params, floors = load_parameters()
+    if not floors:
+        print(f"❌ No sigma floors found in {SOURCE}", file=sys.stderr)
+        sys.exit(1)
+
+    if args.trace:
+        signal, step_s, samples = load_trace(args.trace, args.signal)
+        events = run_signal(params, floors, signal, samples, step_s)
+        print(f"🔎 {signal}: {len(samples)} samples, {step_s:g} s apart")
+        for t, level, detector in events:
+            print(f"  {t:>8.0f} s  {SEVERITY_NAMES[level]:<8} ({detector})")
+        if args.change_at is not None:
+            false_alarms, _, delays = score_events(events, args.change_at)
+            warn = delays[WARNING]
+            print(f"\n  Change at {args.change_at:.0f} s: warning after "
+                  f"{'-' if warn is None else f'{warn:.0f} s'}, {false_alarms} false alarm(s)")
+        if not events:
+            print("✅ No anomalies")
+        return
+
+    names = args.scenario or list(SCENARIOS)
+    failures = evaluate_scenarios(params, floors, names, args.runs, args.seed)
+    if failures:
+        print(f"\n⚠️ {failures} scenario(s) missed a change or raised false alarms")
+        sys.exit(1)
+    print("\n✅ Every change detected without false alarms")
+
+if __name__ == "__main__":
+    main()
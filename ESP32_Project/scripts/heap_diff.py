@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+Heap Snapshot Diff for AI Teddy Bear
+Compares two allocation-site snapshots printed by dumpAllocationSnapshot()
+([HEAP][SNAP] / [HEAP][SITE] / [HEAP][LIVE] / [HEAP][END] lines) and reports
+per-site growth, so a leak shows up as a site whose live bytes keep rising.
+
+Usage:
+  heap_diff.py serial.log                      # first vs last snapshot
+  heap_diff.py serial.log --from 2 --to 7      # by snapshot seq
+  heap_diff.py serial.log -e firmware.elf      # resolve caller addresses
+"""
+
+import sys
+import json
+import shutil
+import argparse
+import subprocess
+from pathlib import Path
+
+DEFAULT_ADDR2LINE = "xtensa-esp32-elf-addr2line"
+
+def parse_snapshots(path):
+    """Collect every complete snapshot in a serial log"""
+    snapshots = []
+    current = None
+    for line in Path(path).read_text(encoding="utf-8", errors="replace").splitlines():
+        pos = line.find("[HEAP][")
+        if pos < 0:
+            continue
+        tag_end = line.find("]", pos + 7)
+        tag = line[pos + 7:tag_end]
+        payload = line[tag_end + 1:].strip()
+
+        try:
+            if tag == "SNAP":
+                current = {"header": json.loads(payload), "sites": {}, "live": []}
+            elif tag == "SITE" and current is not None:
+                site = json.loads(payload)
+                current["sites"][(site["site"], site["caller"])] = site
+            elif tag == "LIVE" and current is not None:
+                current["live"].append(json.loads(payload))
+            elif tag == "END" and current is not None:
+                snapshots.append(current)
+                current = None
+        except json.JSONDecodeError:
+            # Line interleaved with other output; drop the partial snapshot
+            current = None
+    return snapshots
+
+def pick_snapshot(snapshots, seq, default_index):
+    """Select a snapshot by seq, or by position when seq is not given"""
+    if seq is None:
+        return snapshots[default_index]
+    for snap in snapshots:
+        if snap["header"]["seq"] == seq:
+            return snap
+    raise ValueError(f"snapshot seq {seq} not found")
+
+def symbolize(callers, elf, addr2line):
+    """Map caller addresses to function names"""
+    if elf is None or not callers:
+        return {}
+    addrs = sorted(callers)
+    out = subprocess.run([addr2line, "-f", "-C", "-e", str(elf)] + addrs,
+                         capture_output=True, text=True, check=True).stdout.splitlines()
+    return {addr: func for addr, func in zip(addrs, out[0::2]) if func and func != "??"}
+
+def diff_sites(before, after):
+    """Per-site deltas, largest growth first"""
+    rows = []
+    for key in set(before["sites"]) | set(after["sites"]):
+        old = before["sites"].get(key, {})
+        new = after["sites"].get(key, {})
+        rows.append({
+            "site": key[0],
+            "caller": key[1],
+            "bytes": new.get("bytes", 0),
+            "delta_bytes": new.get("bytes", 0) - old.get("bytes", 0),
+            "delta_live": new.get("live", 0) - old.get("live", 0),
+            "allocs": new.get("allocs", 0) - old.get("allocs", 0),
+            "frees": new.get("frees", 0) - old.get("frees", 0),
+            "aged": new.get("aged", 0),
+            "leak": new.get("leak", False),
+        })
+    rows.sort(key=lambda r: r["delta_bytes"], reverse=True)
+    return rows
+
+def main():
+    """Main function"""
+    parser = argparse.ArgumentParser(description="Diff two on-device heap snapshots")
+    parser.add_argument("log", help="Serial log containing [HEAP] snapshot lines")
+    parser.add_argument("--from", dest="from_seq", type=int, help="Baseline snapshot seq (default: first)")
+    parser.add_argument("--to", dest="to_seq", type=int, help="Compared snapshot seq (default: last)")
+    parser.add_argument("-e", "--elf", help="Firmware ELF for resolving caller addresses")
+    parser.add_argument("--addr2line", default=DEFAULT_ADDR2LINE, help="addr2line binary for the target")
+    parser.add_argument("--all", action="store_true", help="Also list sites that did not change")
+    args = parser.parse_args()
+
+    snapshots = parse_snapshots(args.log)
+    if len(snapshots) < 2:
+        print(f"❌ Need at least two snapshots, found {len(snapshots)}", file=sys.stderr)
+        sys.exit(1)
+
+    try:
+        before = pick_snapshot(snapshots, args.from_seq, 0)
+        after = pick_snapshot(snapshots, args.to_seq, -1)
+    except ValueError as e:
+        print(f"❌ {e}", file=sys.stderr)
+        sys.exit(1)
+
+    elf = Path(args.elf) if args.elf else None
+    if elf is not None and shutil.which(args.addr2line) is None:
+        print(f"⚠️ {args.addr2line} not found, leaving callers unresolved", file=sys.stderr)
+        elf = None
+
+    rows = diff_sites(before, after)
+    names = symbolize({r["caller"] for r in rows}, elf, args.addr2line)
+
+    b, a = before["header"], after["header"]
+    elapsed = (a["uptime_ms"] - b["uptime_ms"]) / 1000.0
+    print(f"📸 Snapshot {b['seq']} -> {a['seq']} over {elapsed:.0f} s")
+    print(f"   free {b['free']} -> {a['free']} ({a['free'] - b['free']:+d}), "
+          f"largest {b['largest']} -> {a['largest']} ({a['largest'] - b['largest']:+d}), "
+          f"tracked {b['tracked_bytes']} -> {a['tracked_bytes']} ({a['tracked_bytes'] - b['tracked_bytes']:+d})")
+
+    print(f"\n  {'Site':<24} {'Caller':<32} {'Bytes':>8} {'ΔBytes':>8} {'ΔLive':>6} {'Allocs':>6} {'Frees':>6}")
+    growing = 0
+    for r in rows:
+        if not args.all and r["delta_bytes"] == 0 and r["delta_live"] == 0:
+            continue
+        flag = ""
+        if r["leak"]:
+            flag = "  ⚠️ leak?"
+        elif r["delta_bytes"] > 0:
+            flag = "  ⬆"
+        if r["delta_bytes"] > 0:
+            growing += 1
+        caller = names.get(r["caller"], r["caller"])
+        print(f"  {r['site']:<24} {caller:<32} {r['bytes']:>8} {r['delta_bytes']:>+8} "
+              f"{r['delta_live']:>+6} {r['allocs']:>6} {r['frees']:>6}{flag}")
+
+    if growing == 0:
+        print("\n✅ No tracked site grew between snapshots")
+    else:
+        print(f"\n⚠️ {growing} site(s) grew between snapshots")
+
+if __name__ == "__main__":
+    main()
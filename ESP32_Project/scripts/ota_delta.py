@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+"""
+Delta OTA Patch Tool for AI Teddy Bear
+Makes the patches installOtaDelta() applies on the device (ota_delta.h):
+bsdiff-style records (diff bytes against the old image, extra bytes, seek)
+in one raw deflate stream behind a header carrying both image sizes and
+SHA-256 digests. "apply" rebuilds the new image exactly as the device does
+and checks both digests, so every patch can be verified before publishing.
+
+The window bits bound the device's inflate dictionary (2^bits bytes).
+
+Usage:
+  ota_delta.py diff old.bin new.bin -o update.tbdp       # make a patch
+  ota_delta.py diff old.bin new.bin -o update.tbdp --from-version 1.2.0 --url https://...
+  ota_delta.py apply old.bin update.tbdp -o rebuilt.bin  # rebuild and verify
+  ota_delta.py info update.tbdp
+"""
+
+import sys
+import json
+import zlib
+import struct
+import hashlib
+import argparse
+from pathlib import Path
+
+MAGIC = b"TBDP"
+VERSION = 1
+HEADER = struct.Struct("<4sBBHII32s32s")   # 80 bytes, as OTA_DELTA_HEADER_SIZE
+RECORD = struct.Struct("<IIi")             # diff length, extra length, old seek
+DEFAULT_WINDOW_BITS = 12                   # 4 KB dictionary on the device
+MAX_WINDOW_BITS = 15                       # OTA_DELTA_MAX_WINDOW_BITS
+
+SEED = 16          # Bytes hashed to find a match candidate
+INDEX_STEP = 8     # Old image indexed every this many bytes
+MIN_MATCH = 32     # Shorter exact matches are not worth a record
+CANDIDATES = 4     # Old positions kept per seed
+
+# =============================================================================
+# MATCHING
+# =============================================================================
+
+def index_old(old):
+    index = {}
+    for pos in range(0, len(old) - SEED + 1, INDEX_STEP):
+        slots = index.setdefault(old[pos:pos + SEED], [])
+        if len(slots) < CANDIDATES:
+            slots.append(pos)
+    return index
+
+def match_forward(old, o, new, n, limit):
+    """Length of old[o:] == new[n:], at most limit"""
+    length = 0
+    step = 256
+    while length < limit:
+        size = min(step, limit - length)
+        if old[o + length:o + length + size] == new[n + length:n + length + size]:
+            length += size
+            step = min(step * 2, 1 << 16)
+        elif size > 1:
+            step = max(1, size // 4)
+        else:
+            break
+    return length
+
+def match_backward(old, o, new, n, limit):
+    """Matching bytes just before old[o] and new[n], at most limit"""
+    length = 0
+    while length < limit and old[o - length - 1] == new[n - length - 1]:
+        length += 1
+    return length
+
+def find_matches(old, new):
+    """Non-overlapping exact matches (new start, old start, length), in new order"""
+    index = index_old(old)
+    matches = []
+    i = 0
+    covered = 0        # New bytes before this are already matched
+    delta = 0          # Alignment of the last match, tried first
+    while i + SEED <= len(new):
+        best = (0, 0, 0)
+        candidates = index.get(new[i:i + SEED], [])
+        if 0 <= i + delta and i + delta + SEED <= len(old):
+            candidates = [i + delta] + candidates
+        for o in candidates:
+            back = match_backward(old, o, new, i, min(o, i - covered))
+            fwd = match_forward(old, o, new, i, min(len(old) - o, len(new) - i))
+            if back + fwd > best[2]:
+                best = (i - back, o - back, back + fwd)
+        if best[2] >= MIN_MATCH:
+            matches.append(best)
+            covered = i = best[0] + best[2]
+            delta = best[1] - best[0]
+        else:
+            i += 1
+    return matches
+
+# =============================================================================
+# PATCH FORMAT
+# =============================================================================
+
+def build_records(old, new, matches):
+    """Records and body bytes; consecutive matches with the same alignment
+    become one diff region, the rest of new is extra bytes"""
+    regions = []
+    for n, o, length in matches:
+        if regions and regions[-1][1] - regions[-1][0] == o - n:
+            regions[-1][2] = n + length - regions[-1][0]
+        else:
+            regions.append([n, o, length])
+
+    body = bytearray()
+    old_pos = 0
+    new_pos = 0
+
+    def emit(diff_from, diff_len, extra_end, next_old):
+        nonlocal old_pos, new_pos
+        diff = bytes((new[new_pos + k] - old[diff_from + k]) & 0xFF for k in range(diff_len))
+        extra = new[new_pos + diff_len:extra_end]
+        seek = next_old - (diff_from + diff_len)
+        body.extend(RECORD.pack(diff_len, len(extra), seek))
+        body.extend(diff)
+        body.extend(extra)
+        old_pos = diff_from + diff_len + seek
+        new_pos = extra_end
+
+    if not regions or regions[0][0] > 0:
+        emit(0, 0, regions[0][0] if regions else len(new), regions[0][1] if regions else 0)
+    for k, (n, o, length) in enumerate(regions):
+        following = regions[k + 1] if k + 1 < len(regions) else None
+        emit(o, length, following[0] if following else len(new), following[1] if following else o + length)
+    return body, len(regions)
+
+def make_patch(old, new, window_bits):
+    matches = find_matches(old, new)
+    body, regions = build_records(old, new, matches)
+    packer = zlib.compressobj(9, zlib.DEFLATED, -window_bits, 9)
+    compressed = packer.compress(bytes(body)) + packer.flush()
+    header = HEADER.pack(MAGIC, VERSION, window_bits, 0, len(old), len(new),
+                         hashlib.sha256(old).digest(), hashlib.sha256(new).digest())
+    stats = {"matches": len(matches), "regions": regions,
+             "matched": sum(m[2] for m in matches), "body": len(body)}
+    return header + compressed, stats
+
+def read_header(patch):
+    if len(patch) <= HEADER.size:
+        raise SystemExit("❌ Patch is shorter than its header")
+    magic, version, window_bits, _, old_size, new_size, old_sha, new_sha = HEADER.unpack_from(patch)
+    if magic != MAGIC or version != VERSION or not 9 <= window_bits <= MAX_WINDOW_BITS:
+        raise SystemExit(f"❌ Not a version {VERSION} patch (magic {magic!r}, version {version}, window {window_bits})")
+    return {"window_bits": window_bits, "old_size": old_size, "new_size": new_size,
+            "old_sha256": old_sha, "new_sha256": new_sha}
+
+def apply_patch(old, patch):
+    """Rebuilds the new image the way the device decoder does"""
+    header = read_header(patch)
+    if len(old) < header["old_size"] or hashlib.sha256(old[:header["old_size"]]).digest() != header["old_sha256"]:
+        raise SystemExit("❌ Old image does not match the patch base")
+    old = old[:header["old_size"]]
+    body = zlib.decompressobj(-header["window_bits"]).decompress(patch[HEADER.size:])
+    out = bytearray()
+    pos = 0
+    old_pos = 0
+    while len(out) < header["new_size"]:
+        if pos + RECORD.size > len(body):
+            raise SystemExit("❌ Patch data ends early")
+        diff_len, extra_len, seek = RECORD.unpack_from(body, pos)
+        pos += RECORD.size
+        if old_pos + diff_len > len(old) or len(out) + diff_len + extra_len > header["new_size"]:
+            raise SystemExit(f"❌ Record out of range at {len(out)}")
+        out.extend((body[pos + k] + old[old_pos + k]) & 0xFF for k in range(diff_len))
+        pos += diff_len
+        out.extend(body[pos:pos + extra_len])
+        pos += extra_len
+        old_pos += diff_len + seek
+        if not 0 <= old_pos <= len(old):
+            raise SystemExit(f"❌ Seek outside the old image at {len(out)}")
+    if hashlib.sha256(out).digest() != header["new_sha256"]:
+        raise SystemExit("❌ Rebuilt image does not match the patch SHA-256")
+    return bytes(out)
+
+# =============================================================================
+# COMMANDS
+# =============================================================================
+
+def cmd_diff(args):
+    old = Path(args.old).read_bytes()
+    new = Path(args.new).read_bytes()
+    if not 9 <= args.window_bits <= MAX_WINDOW_BITS:
+        raise SystemExit(f"❌ Window bits must be 9..{MAX_WINDOW_BITS}")
+    patch, stats = make_patch(old, new, args.window_bits)
+    if apply_patch(old, patch) != new:
+        raise SystemExit("❌ Patch does not rebuild the new image")
+    Path(args.output).write_bytes(patch)
+
+    full = len(zlib.compress(new, 9))
+    print(f"🧩 {args.output}: {len(patch)} bytes, {len(patch) * 100 / len(new):.1f}% of the image "
+          f"({len(patch) * 100 / full:.1f}% of the deflated image)")
+    print(f"  Old {len(old)} bytes, new {len(new)} bytes")
+    print(f"  {stats['matches']} matches in {stats['regions']} diff regions cover "
+          f"{stats['matched'] * 100 / max(1, len(new)):.1f}% of the new image")
+    print(f"  Device dictionary {1 << args.window_bits} bytes; verified by applying")
+    if args.from_version or args.url:
+        manifest = {"checksum": hashlib.sha256(new).hexdigest(), "file_size": len(new),
+                    "delta_from": args.from_version or "", "delta_url": args.url or "",
+                    "delta_size": len(patch)}
+        print("  Manifest fields:")
+        print("  " + json.dumps(manifest, indent=2).replace("\n", "\n  "))
+
+def cmd_apply(args):
+    old = Path(args.old).read_bytes()
+    new = apply_patch(old, Path(args.patch).read_bytes())
+    Path(args.output).write_bytes(new)
+    print(f"✅ {args.output}: {len(new)} bytes, SHA-256 {hashlib.sha256(new).hexdigest()}")
+
+def cmd_info(args):
+    patch = Path(args.patch).read_bytes()
+    header = read_header(patch)
+    print(f"🧩 {args.patch}: {len(patch)} bytes, window {header['window_bits']} bits")
+    print(f"  Old {header['old_size']} bytes, SHA-256 {header['old_sha256'].hex()}")
+    print(f"  New {header['new_size']} bytes, SHA-256 {header['new_sha256'].hex()}")
+
+def main():
+    """Main function"""
+    parser = argparse.ArgumentParser(description="Make and verify delta OTA patches")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    diff = commands.add_parser("diff", help="Make a patch from old.bin to new.bin")
+    diff.add_argument("old")
+    diff.add_argument("new")
+    diff.add_argument("-o", "--output", required=True)
+    diff.add_argument("--window-bits", type=int, default=DEFAULT_WINDOW_BITS,
+                      help="Deflate window, sets the device dictionary size")
+    diff.add_argument("--from-version", help="Version of old.bin, for the manifest fields")
+    diff.add_argument("--url", help="Where the patch is published, for the manifest fields")
+    diff.set_defaults(func=cmd_diff)
+
+    apply = commands.add_parser("apply", help="Rebuild new.bin from old.bin and a patch")
+    apply.add_argument("old")
+    apply.add_argument("patch")
+    apply.add_argument("-o", "--output", required=True)
+    apply.set_defaults(func=cmd_apply)
+
+    info = commands.add_parser("info", help="Show a patch header")
+    info.add_argument("patch")
+    info.set_defaults(func=cmd_info)
+
+    args = parser.parse_args()
+    args.func(args)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""
+OTA Image Packer for AI Teddy Bear
+Compresses an application image into the packed container the device
+inflates while it downloads (ota_resume.h): a header with the image size,
+block size and SHA-256, then independently deflated blocks, each behind its
+compressed length. Independent blocks are what let an interrupted download
+resume from a block boundary with an HTTP Range request.
+
+Publish the .tbiz at the manifest download_url with "download_size" set to
+its size; "file_size" and "checksum" still describe the image itself.
+
+Usage:
+  ota_pack.py pack firmware.bin -o firmware.tbiz          # 64 KB blocks, 4 KB window
+  ota_pack.py pack firmware.bin -o firmware.tbiz --block-kb 32 --window-bits 15
+  ota_pack.py unpack firmware.tbiz -o firmware.bin        # inflate and verify
+  ota_pack.py info firmware.tbiz
+"""
+
+import json
+import zlib
+import struct
+import hashlib
+import argparse
+from pathlib import Path
+
+MAGIC = b"TBIZ"
+VERSION = 1
+HEADER = struct.Struct("<4sBBHII32s")   # 48 bytes, as OTA_PACKED_HEADER_SIZE
+BLOCK = struct.Struct("<I")             # Compressed length of the block
+BUFFER_SIZE = 16 * 1024                 # OTA_PIPELINE_BUFFER_SIZE; blocks are multiples of it
+DEFAULT_BLOCK_KB = 64
+DEFAULT_WINDOW_BITS = 12                # 4 KB dictionary on the device
+MAX_WINDOW_BITS = 15                    # OTA_PACKED_MAX_WINDOW_BITS
+
+def pack(image, block_size, window_bits):
+    out = bytearray(HEADER.pack(MAGIC, VERSION, window_bits, 0, len(image), block_size,
+                                hashlib.sha256(image).digest()))
+    for pos in range(0, len(image), block_size):
+        packer = zlib.compressobj(9, zlib.DEFLATED, -window_bits, 9)
+        block = packer.compress(image[pos:pos + block_size]) + packer.flush()
+        out += BLOCK.pack(len(block)) + block
+    return bytes(out)
+
+def read_header(packed):
+    if len(packed) < HEADER.size:
+        raise SystemExit("❌ Shorter than the packed header")
+    magic, version, window_bits, _, image_size, block_size, sha = HEADER.unpack_from(packed)
+    if magic != MAGIC or version != VERSION or not 9 <= window_bits <= MAX_WINDOW_BITS \
+            or block_size == 0 or block_size % BUFFER_SIZE:
+        raise SystemExit(f"❌ Not a version {VERSION} packed image (magic {magic!r}, version {version})")
+    return {"window_bits": window_bits, "image_size": image_size, "block_size": block_size, "sha256": sha}
+
+def unpack(packed):
+    """Inflates block by block with the device's checks"""
+    header = read_header(packed)
+    image = bytearray()
+    pos = HEADER.size
+    while len(image) < header["image_size"]:
+        if pos + BLOCK.size > len(packed):
+            raise SystemExit(f"❌ Packed data ends at image byte {len(image)}")
+        (length,) = BLOCK.unpack_from(packed, pos)
+        pos += BLOCK.size
+        if length == 0 or pos + length > len(packed):
+            raise SystemExit(f"❌ Block at image byte {len(image)} has a bad length ({length})")
+        inflater = zlib.decompressobj(-header["window_bits"])
+        block = inflater.decompress(packed[pos:pos + length])
+        expected = min(header["block_size"], header["image_size"] - len(image))
+        if len(block) != expected or not inflater.eof or inflater.unused_data:
+            raise SystemExit(f"❌ Block at image byte {len(image)} does not match the block size")
+        image += block
+        pos += length
+    if pos != len(packed):
+        raise SystemExit(f"❌ {len(packed) - pos} trailing bytes")
+    if hashlib.sha256(image).digest() != header["sha256"]:
+        raise SystemExit("❌ Unpacked image does not match the SHA-256")
+    return bytes(image)
+
+def cmd_pack(args):
+    image = Path(args.image).read_bytes()
+    if not 9 <= args.window_bits <= MAX_WINDOW_BITS:
+        raise SystemExit(f"❌ Window bits must be 9..{MAX_WINDOW_BITS}")
+    block_size = args.block_kb * 1024
+    if block_size % BUFFER_SIZE:
+        raise SystemExit(f"❌ Block size must be a multiple of {BUFFER_SIZE // 1024} KB")
+    packed = pack(image, block_size, args.window_bits)
+    if unpack(packed) != image:
+        raise SystemExit("❌ Packed image does not unpack to the original")
+    Path(args.output).write_bytes(packed)
+
+    blocks = (len(image) + block_size - 1) // block_size
+    print(f"🗜️ {args.output}: {len(packed)} bytes, {len(packed) * 100 / len(image):.1f}% of {len(image)} "
+          f"({blocks} x {args.block_kb} KB blocks, window {args.window_bits} bits)")
+    print(f"  Device decoder dictionary {1 << args.window_bits} bytes; verified by unpacking")
+    print("  Manifest fields:")
+    manifest = {"checksum": hashlib.sha256(image).hexdigest(), "file_size": len(image),
+                "download_size": len(packed)}
+    print("  " + json.dumps(manifest, indent=2).replace("\n", "\n  "))
+
+def cmd_unpack(args):
+    image = unpack(Path(args.packed).read_bytes())
+    Path(args.output).write_bytes(image)
+    print(f"✅ {args.output}: {len(image)} bytes, SHA-256 {hashlib.sha256(image).hexdigest()}")
+
+def cmd_info(args):
+    packed = Path(args.packed).read_bytes()
+    header = read_header(packed)
+    print(f"🗜️ {args.packed}: {len(packed)} bytes, {header['block_size'] // 1024} KB blocks, "
+          f"window {header['window_bits']} bits")
+    print(f"  Image {header['image_size']} bytes, SHA-256 {header['sha256'].hex()}")
+
+def main():
+    """Main function"""
+    parser = argparse.ArgumentParser(description="Pack application images for compressed OTA")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    pack_cmd = commands.add_parser("pack", help="Compress an image")
+    pack_cmd.add_argument("image")
+    pack_cmd.add_argument("-o", "--output", required=True)
+    pack_cmd.add_argument("--block-kb", type=int, default=DEFAULT_BLOCK_KB,
+                          help="Resume granularity, a multiple of 16 KB")
+    pack_cmd.add_argument("--window-bits", type=int, default=DEFAULT_WINDOW_BITS,
+                          help="Deflate window, sets the device dictionary size")
+    pack_cmd.set_defaults(func=cmd_pack)
+
+    unpack_cmd = commands.add_parser("unpack", help="Inflate and verify a packed image")
+    unpack_cmd.add_argument("packed")
+    unpack_cmd.add_argument("-o", "--output", required=True)
+    unpack_cmd.set_defaults(func=cmd_unpack)
+
+    info_cmd = commands.add_parser("info", help="Show a packed image header")
+    info_cmd.add_argument("packed")
+    info_cmd.set_defaults(func=cmd_info)
+
+    args = parser.parse_args()
+    args.func(args)
+
+if __name__ == "__main__":
+    main()
@@ -132,7 +132,6 @@ lib_deps =
 	fastled/FastLED@3.6.0
 	bblanchon/ArduinoJson@6.21.4
 	Links2004/WebSockets@2.4.1
-	densaugeo/base64@1.4.0
 	ayushsharma82/ElegantOTA@2.2.9
 	arduino-libraries/NTPClient@3.2.1
 	bblanchon/StreamUtils@1.7.3
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""
+Sampling Profile Symbolizer for AI Teddy Bear
+Decodes TPRF profiles captured by the on-device sampling profiler, resolves
+PCs against the firmware ELF with addr2line and writes folded stacks
+(task;caller;function count) for flamegraph.pl, speedscope or inferno.
+
+Accepted inputs:
+  - Serial logs containing [PROF][BEGIN] / [PROF] ... / [PROF][END]
+  - JSON lines of "profile_chunk" WebSocket messages
+  - Raw .bin dumps
+"""
+
+import sys
+import json
+import base64
+import shutil
+import struct
+import argparse
+import subprocess
+from collections import Counter
+from pathlib import Path
+
+HEADER = struct.Struct("<4sBBHIIHH")
+TASK = struct.Struct("<I16s")
+SAMPLE = struct.Struct("<III")
+DEFAULT_ADDR2LINE = "xtensa-esp32-elf-addr2line"
+
+def load_profile_bytes(path):
+    """Extract the raw TPRF blob from a log, JSON lines or binary file"""
+    raw = Path(path).read_bytes()
+    if raw[:4] == b"TPRF":
+        return raw
+
+    text = raw.decode("utf-8", errors="replace")
+    lines = []
+    chunks = {}
+    capturing = False
+    for line in text.splitlines():
+        line = line.strip()
+        if line.startswith("{") and '"profile_chunk"' in line:
+            msg = json.loads(line)
+            chunks[msg["seq"]] = msg["data"]
+            continue
+        pos = line.find("[PROF]")
+        if pos < 0:
+            continue
+        payload = line[pos + len("[PROF]"):].strip()
+        if payload == "[BEGIN]":
+            lines, capturing = [], True
+        elif payload == "[END]":
+            capturing = False
+        elif capturing and payload:
+            lines.append(payload)
+
+    if chunks:
+        encoded = "".join(chunks[seq] for seq in sorted(chunks))
+    else:
+        encoded = "".join(lines)
+    if not encoded:
+        raise ValueError(f"no profile data found in {path}")
+    return base64.b64decode(encoded)
+
+def parse_profile(blob):
+    """Parse a TPRF v1 blob into header, task names and samples"""
+    magic, version, cores, hz, count, dropped, task_count, _ = HEADER.unpack_from(blob, 0)
+    if magic != b"TPRF":
+        raise ValueError("not a TPRF profile")
+    if version != 1:
+        raise ValueError(f"unsupported TPRF version {version}")
+
+    offset = HEADER.size
+    tasks = {}
+    for _ in range(task_count):
+        handle, name = TASK.unpack_from(blob, offset)
+        tasks[handle] = name.split(b"\0", 1)[0].decode("ascii", errors="replace")
+        offset += TASK.size
+
+    samples = []
+    for _ in range(count):
+        if offset + SAMPLE.size > len(blob):
+            break
+        samples.append(SAMPLE.unpack_from(blob, offset))
+        offset += SAMPLE.size
+
+    header = {"cores": cores, "hz": hz, "samples": count, "dropped": dropped}
+    return header, tasks, samples
+
+def symbolize(addresses, elf, addr2line):
+    """Map addresses to function names, batching calls to addr2line"""
+    names = {}
+    addresses = sorted(set(a for a in addresses if a))
+    if elf is None:
+        return {a: f"0x{a:08x}" for a in addresses}
+
+    batch = 500
+    for i in range(0, len(addresses), batch):
+        part = addresses[i:i + batch]
+        out = subprocess.run([addr2line, "-f", "-C", "-e", str(elf)] + [f"0x{a:08x}" for a in part],
+                             capture_output=True, text=True, check=True).stdout.splitlines()
+        # addr2line prints function and file:line for every address
+        for addr, func in zip(part, out[0::2]):
+            names[addr] = func if func and func != "??" else f"0x{addr:08x}"
+    return names
+
+def fold_samples(tasks, samples, names, with_caller=True):
+    """Collapse samples into folded stack counts"""
+    folded = Counter()
+    for pc, caller, task in samples:
+        frames = [tasks.get(task, f"task_{task:08x}")]
+        if with_caller and caller:
+            frames.append(names.get(caller, f"0x{caller:08x}"))
+        frames.append(names.get(pc, f"0x{pc:08x}"))
+        folded[";".join(frames)] += 1
+    return folded
+
+def print_top(samples, names, tasks, limit):
+    """Print the hottest functions and tasks"""
+    total = len(samples) or 1
+    by_func = Counter(names.get(pc, f"0x{pc:08x}") for pc, _, _ in samples)
+    by_task = Counter(tasks.get(task, f"task_{task:08x}") for _, _, task in samples)
+
+    print(f"\n🔥 Top {limit} functions ({len(samples)} samples)")
+    for func, n in by_func.most_common(limit):
+        print(f"  {n * 100.0 / total:6.2f}%  {n:6d}  {func}")
+    print("\n🧵 Samples by task")
+    for task, n in by_task.most_common():
+        print(f"  {n * 100.0 / total:6.2f}%  {n:6d}  {task}")
+
+def main():
+    """Main function"""
+    parser = argparse.ArgumentParser(description="Symbolize on-device CPU profiles into folded stacks")
+    parser.add_argument("profile", help="Serial log, profile_chunk JSON lines or raw .bin")
+    parser.add_argument("-e", "--elf", help="Firmware ELF (e.g. .pio/build/esp32dev-release/firmware.elf)")
+    parser.add_argument("-o", "--output", help="Folded stacks output (default: stdout)")
+    parser.add_argument("--addr2line", default=DEFAULT_ADDR2LINE, help="addr2line binary for the target")
+    parser.add_argument("--no-caller", action="store_true", help="Fold on the sampled PC only")
+    parser.add_argument("--top", type=int, default=15, help="Show the N hottest functions")
+    args = parser.parse_args()
+
+    try:
+        header, tasks, samples = parse_profile(load_profile_bytes(args.profile))
+    except (ValueError, OSError, struct.error) as e:
+        print(f"❌ {e}", file=sys.stderr)
+        sys.exit(1)
+
+    elf = Path(args.elf) if args.elf else None
+    if elf is not None and shutil.which(args.addr2line) is None:
+        print(f"⚠️ {args.addr2line} not found, leaving addresses unresolved", file=sys.stderr)
+        elf = None
+
+    addresses = [pc for pc, _, _ in samples] + [caller for _, caller, _ in samples]
+    names = symbolize(addresses, elf, args.addr2line)
+    folded = fold_samples(tasks, samples, names, with_caller=not args.no_caller)
+
+    lines = [f"{stack} {count}" for stack, count in folded.most_common()]
+    if args.output:
+        Path(args.output).write_text("\n".join(lines) + "\n", encoding="utf-8")
+        print(f"✅ Wrote {len(lines)} folded stacks to {args.output}", file=sys.stderr)
+        print(f"📈 flamegraph.pl {args.output} > profile.svg", file=sys.stderr)
+    else:
+        print("\n".join(lines))
+
+    print(f"📊 {header['samples']} samples at {header['hz']} Hz on {header['cores']} cores, "
+          f"{header['dropped']} overwritten", file=sys.stderr)
+    if args.output:
+        print_top(samples, names, tasks, args.top)
+
+if __name__ == "__main__":
+    main()
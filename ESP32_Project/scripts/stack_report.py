@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""
+Stack Usage Report for AI Teddy Bear
+Reads the per-function frame sizes GCC writes with -fstack-usage (*.su files
+next to the objects of a build) and flags functions whose frame alone is
+large, or whose frame size is not fixed (dynamic: VLAs, alloca). With a
+serial log, also prints the per-task right-sizing table from the
+[STACK][TASK] lines emitted by printStackReport().
+
+Usage:
+  stack_report.py                               # .pio/build/esp32dev-local
+  stack_report.py -b .pio/build/esp32dev-local --threshold 512
+  stack_report.py --log serial.log              # add task right-sizing
+"""
+
+import sys
+import json
+import argparse
+from pathlib import Path
+
+DEFAULT_BUILD_DIR = ".pio/build/esp32dev-local"
+
+def parse_su_files(build_dir, include_libs):
+    """Collect (location, function, bytes, qualifier) from every .su file"""
+    frames = []
+    for su in sorted(Path(build_dir).rglob("*.su")):
+        # Only our sources unless asked: framework and libdeps dominate otherwise
+        if not include_libs and "src" not in su.relative_to(build_dir).parts:
+            continue
+        for line in su.read_text(encoding="utf-8", errors="replace").splitlines():
+            parts = line.rsplit("\t", 2)
+            if len(parts) != 3:
+                continue
+            where, size, qualifier = parts
+            # "file:line:col:function" - the function may itself contain colons
+            fields = where.split(":", 3)
+            function = fields[3] if len(fields) == 4 else where
+            location = ":".join(fields[:2]) if len(fields) == 4 else su.name
+            try:
+                frames.append((location, function, int(size), qualifier))
+            except ValueError:
+                continue
+    return frames
+
+def parse_task_lines(path):
+    """Latest [STACK][TASK] line per stack name"""
+    tasks = {}
+    for line in Path(path).read_text(encoding="utf-8", errors="replace").splitlines():
+        pos = line.find("[STACK][TASK]")
+        if pos < 0:
+            continue
+        try:
+            entry = json.loads(line[pos + len("[STACK][TASK]"):].strip())
+        except json.JSONDecodeError:
+            continue
+        tasks[entry["name"]] = entry
+    return tasks
+
+def print_frames(frames, threshold, limit):
+    """Largest and non-static frames"""
+    flagged = [f for f in frames if f[2] >= threshold or f[3] != "static"]
+    flagged.sort(key=lambda f: f[2], reverse=True)
+
+    print(f"📐 {len(frames)} functions, {len(flagged)} with frames >= {threshold} bytes or dynamic")
+    if not flagged:
+        return 0
+    print(f"\n  {'Bytes':>6}  {'Kind':<16} {'Function':<48} Location")
+    for location, function, size, qualifier in flagged[:limit]:
+        flag = "  ⚠️" if qualifier.startswith("dynamic") and "bounded" not in qualifier else ""
+        print(f"  {size:>6}  {qualifier:<16} {function[:48]:<48} {location}{flag}")
+    if len(flagged) > limit:
+        print(f"  ... {len(flagged) - limit} more")
+    return len(flagged)
+
+def print_tasks(tasks):
+    """Right-sizing table from the device report"""
+    print(f"\n  {'Stack':<16} {'Size':>6} {'Peak':>6} {'MinFree':>8} {'Suggest':>8}  Action")
+    tight = 0
+    for name, t in sorted(tasks.items()):
+        peak = t["size"] - t["min_free"]
+        if t["suggest"] > t["size"]:
+            action = f"grow by {t['suggest'] - t['size']}"
+            tight += 1
+        elif t["suggest"] < t["size"]:
+            action = f"can shrink by {t['size'] - t['suggest']}"
+        else:
+            action = "ok"
+        if t.get("isr"):
+            action += " (configISR_STACK_SIZE)"
+        print(f"  {name:<16} {t['size']:>6} {peak:>6} {t['min_free']:>8} {t['suggest']:>8}  {action}")
+    return tight
+
+def main():
+    """Main function"""
+    parser = argparse.ArgumentParser(description="Report large stack frames and task stack sizing")
+    parser.add_argument("-b", "--build-dir", default=DEFAULT_BUILD_DIR, help="Build directory with .su files")
+    parser.add_argument("--threshold", type=int, default=1024, help="Flag frames at least this large (bytes)")
+    parser.add_argument("--limit", type=int, default=40, help="Maximum functions listed")
+    parser.add_argument("--libs", action="store_true", help="Include framework and library objects")
+    parser.add_argument("--log", help="Serial log containing [STACK][TASK] lines")
+    args = parser.parse_args()
+
+    build_dir = Path(args.build_dir)
+    if not build_dir.is_dir():
+        print(f"❌ Build directory {build_dir} not found", file=sys.stderr)
+        sys.exit(1)
+
+    frames = parse_su_files(build_dir, args.libs)
+    if not frames:
+        print(f"❌ No .su files under {build_dir} (build with -fstack-usage)", file=sys.stderr)
+        sys.exit(1)
+    flagged = print_frames(frames, args.threshold, args.limit)
+
+    tight = 0
+    if args.log:
+        tasks = parse_task_lines(args.log)
+        if not tasks:
+            print(f"⚠️ No [STACK][TASK] lines in {args.log}", file=sys.stderr)
+        else:
+            tight = print_tasks(tasks)
+
+    if flagged == 0 and tight == 0:
+        print("\n✅ No large frames or undersized stacks")
+    else:
+        print(f"\n⚠️ {flagged} large frame(s), {tight} undersized stack(s)")
+
+if __name__ == "__main__":
+    main()
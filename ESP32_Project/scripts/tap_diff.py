@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""
+Audio Tap Diff for AI Teddy Bear
+Reads WAV exports of the audio debug taps (/debug/tap?name=... or the
+/tap_<name>.wav files saved by "tap save"), prints level statistics for each
+and compares consecutive pipeline stages: the later tap is aligned to the
+earlier one by cross-correlation, then gain, residual SNR, clipping and the
+windows where the two diverge most are reported.
+
+The tap metadata (LIST/INFO comment) orders the files by stage and gives a
+first estimate of their relative delay; the correlation search is centered
+on it.
+
+Usage:
+  tap_diff.py tap_capture.wav                        # statistics only
+  tap_diff.py tap_capture.wav tap_send.wav
+  tap_diff.py a.wav b.wav --max-lag 2.0 --no-hint    # search +-2 s around 0
+  tap_diff.py a.wav b.wav --residual diff.wav        # write b - gain * a
+"""
+
+import sys
+import math
+import wave
+import struct
+import operator
+import argparse
+from array import array
+from pathlib import Path
+
+FULL_SCALE = 32767
+COARSE_FACTOR = 16       # Decimation of the coarse lag search
+COARSE_CANDIDATES = 32   # Coarse peaks refined per sample at most
+COARSE_KEEP = 0.8        # Peaks within this fraction of the best (periodic audio aliases)
+MIN_OVERLAP = 0.5        # Fraction of the shorter tap two lags must share
+WINDOW_MS = 20           # Divergence window
+
+def read_tap(path):
+    """Samples and metadata of a mono s16le tap WAV"""
+    data = Path(path).read_bytes()
+    if data[:4] != b"RIFF" or data[8:12] != b"WAVE":
+        raise SystemExit(f"❌ {path}: not a WAV file")
+    meta = {"name": Path(path).stem, "rate": 16000}
+    samples = None
+    pos = 12
+    while pos + 8 <= len(data):
+        tag, size = struct.unpack_from("<4sI", data, pos)
+        body = data[pos + 8:pos + 8 + size]
+        if tag == b"fmt ":
+            fmt, channels, rate, _, _, bits = struct.unpack_from("<HHIIHH", body)
+            if fmt != 1 or channels != 1 or bits != 16:
+                raise SystemExit(f"❌ {path}: expected mono 16-bit PCM")
+            meta["rate"] = rate
+        elif tag == b"LIST" and body[:4] == b"INFO":
+            sub = 4
+            while sub + 8 <= len(body):
+                key, length = struct.unpack_from("<4sI", body, sub)
+                if key == b"ICMT":
+                    text = body[sub + 8:sub + 8 + length].split(b"\0")[0].decode(errors="replace")
+                    for field in text.split():
+                        k, _, v = field.partition("=")
+                        meta[k] = int(v) if v.isdigit() else v
+                sub += 8 + length + (length & 1)
+        elif tag == b"data":
+            samples = array("h")
+            samples.frombytes(body[:len(body) & ~1])
+            if sys.byteorder != "little":
+                samples.byteswap()
+        pos += 8 + size + (size & 1)
+    if samples is None:
+        raise SystemExit(f"❌ {path}: no data chunk")
+    if "tap" in meta:
+        meta["name"] = meta["tap"]
+    return samples, meta
+
+def write_wav(path, samples, rate):
+    with wave.open(str(path), "wb") as out:
+        out.setnchannels(1)
+        out.setsampwidth(2)
+        out.setframerate(rate)
+        out.writeframes(array("h", samples).tobytes())
+
+def dbfs(value):
+    return 20 * math.log10(value / FULL_SCALE) if value > 0 else -math.inf
+
+def level_stats(samples):
+    n = len(samples) or 1
+    dc = sum(samples) / n
+    rms = math.sqrt(sum(s * s for s in samples) / n)
+    peak = max((abs(s) for s in samples), default=0)
+    clipped = sum(1 for s in samples if s >= FULL_SCALE or s <= -FULL_SCALE)
+    return dc, rms, peak, clipped
+
+def print_stats(items):
+    print(f"  {'Tap':<10} {'Stage':>5} {'Seconds':>8} {'DC':>8} {'RMS dBFS':>9} {'Peak dBFS':>10} {'Clipped':>8}")
+    for samples, meta in items:
+        dc, rms, peak, clipped = level_stats(samples)
+        print(f"  {meta['name']:<10} {str(meta.get('stage', '-')):>5} {len(samples) / meta['rate']:>8.2f} "
+              f"{dc:>8.1f} {dbfs(rms):>9.1f} {dbfs(peak):>10.1f} {clipped:>8}")
+
+# =============================================================================
+# ALIGNMENT
+# =============================================================================
+
+def hint_lag(ref_meta, ref_len, test_meta, test_len):
+    """Lag (samples) of test behind ref from the export timestamps, if known"""
+    if "end_us" not in ref_meta or "end_us" not in test_meta:
+        return 0
+    rate = ref_meta["rate"]
+    # Signed 32-bit difference: micros() wraps every ~71 minutes
+    end_delta = ((test_meta["end_us"] - ref_meta["end_us"] + 2**31) % 2**32) - 2**31
+    start_delta_s = end_delta / 1e6 - (test_len - ref_len) / rate
+    return round(-start_delta_s * rate)
+
+def correlation(ref, test, lag):
+    """Normalized correlation of ref[i] with test[i + lag] over the overlap"""
+    start = max(0, -lag)
+    end = min(len(ref), len(test) - lag)
+    if end - start < max(64, min(len(ref), len(test)) * MIN_OVERLAP):
+        return -1.0
+    x = ref[start:end]
+    y = test[start + lag:end + lag]
+    xy = sum(map(operator.mul, x, y))
+    xx = sum(map(operator.mul, x, x))
+    yy = sum(map(operator.mul, y, y))
+    return xy / math.sqrt(xx * yy) if xx > 0 and yy > 0 else -1.0
+
+def decimate(samples, factor):
+    mean = sum(samples) / (len(samples) or 1)
+    return [sum(samples[i:i + factor]) / factor - mean for i in range(0, len(samples) - factor + 1, factor)]
+
+def align(ref, test, center, max_lag):
+    """Lag maximizing the correlation: coarse on decimated audio, then per sample"""
+    coarse_ref = decimate(ref, COARSE_FACTOR)
+    coarse_test = decimate(test, COARSE_FACTOR)
+    span = max(1, max_lag // COARSE_FACTOR)
+    base = round(center / COARSE_FACTOR)
+    lags = list(range(base - span, base + span + 1))
+    scores = [correlation(coarse_ref, coarse_test, l) for l in lags]
+    # Local maxima only, so one broad peak cannot take every candidate slot
+    peaks = [(scores[i], lags[i]) for i in range(len(lags))
+             if (i == 0 or scores[i] >= scores[i - 1]) and (i == len(lags) - 1 or scores[i] >= scores[i + 1])]
+    peaks.sort(reverse=True)
+    coarse = [p for p in peaks[:COARSE_CANDIDATES] if p[0] >= peaks[0][0] * COARSE_KEEP]
+
+    ref_list, test_list = list(ref), list(test)
+    lags = set()
+    for _, l in coarse:
+        lags.update(range((l - 1) * COARSE_FACTOR, (l + 1) * COARSE_FACTOR + 1))
+    corr, lag = max((correlation(ref_list, test_list, l), l) for l in lags)
+    return lag, corr
+
+# =============================================================================
+# DIFF
+# =============================================================================
+
+def diff_pair(ref, ref_meta, test, test_meta, args):
+    rate = ref_meta["rate"]
+    center = 0 if args.no_hint else hint_lag(ref_meta, len(ref), test_meta, len(test))
+    lag, corr = align(ref, test, center, int(args.max_lag * rate))
+
+    start = max(0, -lag)
+    end = min(len(ref), len(test) - lag)
+    x = list(ref[start:end])
+    y = list(test[start + lag:end + lag])
+    xx = sum(map(operator.mul, x, x))
+    gain = sum(map(operator.mul, x, y)) / xx if xx else 0.0
+    residual = [b - gain * a for a, b in zip(x, y)]
+    yy = sum(map(operator.mul, y, y))
+    rr = sum(r * r for r in residual)
+    snr = 10 * math.log10(yy / rr) if rr > 0 and yy > 0 else math.inf
+
+    print(f"\n🔀 {ref_meta['name']} -> {test_meta['name']}")
+    print(f"  Lag:          {lag:+d} samples ({lag * 1000 / rate:+.2f} ms, hint {center:+d})")
+    print(f"  Correlation:  {corr:.4f}")
+    print(f"  Gain:         {gain:.3f} ({20 * math.log10(abs(gain)) if gain else -math.inf:+.1f} dB)")
+    print(f"  Residual SNR: {snr:.1f} dB over {len(x) / rate:.2f} s")
+    clipped_in = sum(1 for s in x if abs(s) >= FULL_SCALE)
+    clipped_out = sum(1 for s in y if abs(s) >= FULL_SCALE)
+    if clipped_out > clipped_in:
+        print(f"  ⚠️ Clipping introduced: {clipped_out - clipped_in} samples")
+
+    # Local gain and residual per window show AGC moves, gating and glitches
+    window = max(1, rate * WINDOW_MS // 1000)
+    windows = []
+    for i in range(0, len(x) - window + 1, window):
+        wx, wy, wr = x[i:i + window], y[i:i + window], residual[i:i + window]
+        ex = sum(v * v for v in wx)
+        ey = sum(v * v for v in wy)
+        er = sum(v * v for v in wr)
+        local_gain = sum(map(operator.mul, wx, wy)) / ex if ex else 0.0
+        local_snr = 10 * math.log10(ey / er) if er > 0 and ey > 0 else math.inf
+        windows.append(((start + i) / rate, local_gain, local_snr, er))
+    if windows:
+        gains = [w[1] for w in windows if w[1] != 0.0]
+        if gains:
+            print(f"  Window gain:  {min(gains):.3f} .. {max(gains):.3f} ({WINDOW_MS} ms windows)")
+        worst = sorted(windows, key=lambda w: -w[3])[:args.top]
+        print(f"  Worst windows (time in {ref_meta['name']}):")
+        for t, g, s, _ in sorted(worst):
+            print(f"    {t:8.3f} s  gain {g:7.3f}  SNR {s:6.1f} dB")
+
+    if args.residual:
+        out = Path(args.residual)
+        if args.residual_count > 1:
+            out = out.with_name(f"{out.stem}_{ref_meta['name']}_{test_meta['name']}{out.suffix}")
+        write_wav(out, [max(-32768, min(32767, round(r))) for r in residual], rate)
+        print(f"  💾 Residual written to {out}")
+
+def main():
+    """Main function"""
+    parser = argparse.ArgumentParser(description="Align and diff audio tap WAV exports")
+    parser.add_argument("taps", nargs="+", help="Tap WAV files (ordered by stage metadata)")
+    parser.add_argument("--max-lag", type=float, default=0.5, help="Lag search range around the hint (s)")
+    parser.add_argument("--no-hint", action="store_true", help="Ignore export timestamps, search around 0")
+    parser.add_argument("--top", type=int, default=5, help="Worst windows to list per pair")
+    parser.add_argument("--residual", help="Write the aligned residual of each pair as WAV")
+    args = parser.parse_args()
+
+    items = [read_tap(path) for path in args.taps]
+    items.sort(key=lambda item: item[1].get("stage", 0))
+    rates = {meta["rate"] for _, meta in items}
+    if len(rates) > 1:
+        print(f"❌ Taps have different sample rates: {sorted(rates)}", file=sys.stderr)
+        sys.exit(1)
+
+    print(f"🎙️ {len(items)} tap(s)")
+    print_stats(items)
+
+    args.residual_count = len(items) - 1
+    for (ref, ref_meta), (test, test_meta) in zip(items, items[1:]):
+        diff_pair(ref, ref_meta, test, test_meta, args)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""
+Utterance Trace Exporter for AI Teddy Bear
+Merges device serial trace dumps ([TRACE][SYNC] / [TRACE][EVT] lines) with
+optional server-side spans and writes Chrome/Perfetto trace JSON.
+
+Open the output in https://ui.perfetto.dev or chrome://tracing.
+"""
+
+import sys
+import json
+import argparse
+from pathlib import Path
+
+DEVICE_PID = 1
+SERVER_PID = 2
+
+# Device spans are laid out on separate tracks so overlaps stay readable
+DEVICE_TRACKS = {
+    "utterance": 1,
+    "capture": 2,
+    "encode": 3,
+    "send": 3,
+    "audio_end": 4,
+    "response": 4,
+    "decode": 5,
+    "playback": 5,
+}
+
+def parse_device_log(path):
+    """Parse a serial log into {utterance: {"sync": {...}, "events": [...]}}"""
+    utterances = {}
+    with open(path, 'r', encoding='utf-8', errors='replace') as f:
+        for line in f:
+            for tag, key in (("[TRACE][SYNC]", "sync"), ("[TRACE][EVT]", "events")):
+                pos = line.find(tag)
+                if pos < 0:
+                    continue
+                try:
+                    record = json.loads(line[pos + len(tag):].strip())
+                except json.JSONDecodeError:
+                    continue
+                entry = utterances.setdefault(record["utt"], {"sync": None, "events": []})
+                if key == "sync":
+                    entry["sync"] = record
+                else:
+                    entry["events"].append(record)
+    return utterances
+
+def parse_server_trace(path):
+    """Load server spans (Chrome trace JSON, or JSON lines with ts_ms/dur_ms)"""
+    text = Path(path).read_text(encoding='utf-8')
+    spans = []
+    try:
+        data = json.loads(text)
+    except json.JSONDecodeError:
+        data = None
+
+    if isinstance(data, list) or (isinstance(data, dict) and "traceEvents" in data):
+        events = data["traceEvents"] if isinstance(data, dict) else data
+        for e in events:
+            utt = e.get("args", {}).get("utterance_id")
+            if utt is None or e.get("ph") not in ("X", "i"):
+                continue
+            spans.append({"utt": int(utt), "name": e["name"], "ts_us": float(e["ts"]),
+                          "dur_us": float(e.get("dur", 0)), "ph": e["ph"]})
+    else:
+        for line in text.splitlines():
+            line = line.strip()
+            if not line:
+                continue
+            e = json.loads(line)
+            spans.append({"utt": int(e["utterance_id"]), "name": e["name"],
+                          "ts_us": float(e["ts_ms"]) * 1000.0,
+                          "dur_us": float(e.get("dur_ms", 0)) * 1000.0,
+                          "ph": "X" if e.get("dur_ms") else "i"})
+    return spans
+
+def unwrap_device_ts(ts_low, anchor_us):
+    """Expand a 32-bit event timestamp using the 64-bit sync anchor"""
+    delta = (ts_low - (anchor_us & 0xFFFFFFFF) + (1 << 31)) % (1 << 32) - (1 << 31)
+    return anchor_us + delta
+
+def device_events_to_chrome(utt, entry):
+    """Convert one utterance's device events; returns (events, synced, first instants)"""
+    sync = entry["sync"]
+    if sync is None:
+        anchor = min(e["ts"] for e in entry["events"])
+        sync = {"dev_us": anchor, "epoch_ms": 0}
+    dev_us = int(sync["dev_us"])
+    epoch_us = int(sync["epoch_ms"]) * 1000
+    # Without NTP the device timeline starts at zero
+    offset = epoch_us - dev_us if epoch_us > 0 else -dev_us
+
+    out = []
+    instants = {}
+    for e in entry["events"]:
+        ts = unwrap_device_ts(int(e["ts"]), dev_us) + offset
+        chrome = {"name": e["span"], "cat": "device", "ph": e["ph"], "ts": ts,
+                  "pid": DEVICE_PID, "tid": DEVICE_TRACKS.get(e["span"], 9),
+                  "args": {"utterance_id": utt, "arg": e.get("arg", 0)}}
+        if e["ph"] == "X":
+            chrome["dur"] = int(e["dur"])
+        else:
+            chrome["s"] = "t"
+            instants.setdefault(e["span"], ts)
+        out.append(chrome)
+
+    # Time the device spent waiting on network + server
+    if "audio_end" in instants and "response" in instants:
+        start = instants["audio_end"]
+        out.append({"name": "network+server", "cat": "device", "ph": "X", "ts": start,
+                    "dur": max(0, instants["response"] - start), "pid": DEVICE_PID,
+                    "tid": DEVICE_TRACKS["audio_end"], "args": {"utterance_id": utt}})
+    return out, epoch_us > 0, instants
+
+def build_trace(device_logs, server_traces, only_utterance=None):
+    """Merge device and server sources into a Chrome trace document"""
+    utterances = {}
+    for path in device_logs:
+        for utt, entry in parse_device_log(path).items():
+            merged = utterances.setdefault(utt, {"sync": None, "events": []})
+            merged["sync"] = merged["sync"] or entry["sync"]
+            merged["events"].extend(entry["events"])
+
+    server_spans = []
+    for path in server_traces:
+        server_spans.extend(parse_server_trace(path))
+
+    events = [
+        {"name": "process_name", "ph": "M", "pid": DEVICE_PID, "args": {"name": "ESP32 device"}},
+        {"name": "process_name", "ph": "M", "pid": SERVER_PID, "args": {"name": "Server"}},
+    ]
+    for utt, entry in sorted(utterances.items()):
+        if only_utterance is not None and utt != only_utterance:
+            continue
+        if not entry["events"]:
+            continue
+        device_events, synced, instants = device_events_to_chrome(utt, entry)
+        events.extend(device_events)
+
+        spans = [s for s in server_spans if s["utt"] == utt]
+        if spans and not synced:
+            print(f"⚠️ Utterance {utt}: device clock not NTP-synced, "
+                  "server spans aligned to audio_end", file=sys.stderr)
+            shift = instants.get("audio_end", 0) - min(s["ts_us"] for s in spans)
+        else:
+            shift = 0
+        for s in spans:
+            chrome = {"name": s["name"], "cat": "server", "ph": s["ph"], "ts": s["ts_us"] + shift,
+                      "pid": SERVER_PID, "tid": 1, "args": {"utterance_id": utt}}
+            if s["ph"] == "X":
+                chrome["dur"] = s["dur_us"]
+            else:
+                chrome["s"] = "t"
+            events.append(chrome)
+
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+def main():
+    """Main function"""
+    parser = argparse.ArgumentParser(description="Export utterance traces as Chrome/Perfetto JSON")
+    parser.add_argument("device_logs", nargs="+", help="Serial log file(s) containing [TRACE] lines")
+    parser.add_argument("-s", "--server", action="append", default=[],
+                        help="Server trace (Chrome JSON, or the JSON lines esp32_chat_server "
+                             "writes to ESP32_TRACE_FILE)")
+    parser.add_argument("-u", "--utterance", type=int, help="Only export this utterance id")
+    parser.add_argument("-o", "--output", default="utterance_trace.json", help="Output trace file")
+    args = parser.parse_args()
+
+    trace = build_trace(args.device_logs, args.server, args.utterance)
+    spans = sum(1 for e in trace["traceEvents"] if e["ph"] != "M")
+    if spans == 0:
+        print("❌ No trace events found")
+        sys.exit(1)
+
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump(trace, f)
+
+    print(f"✅ Wrote {spans} events to {args.output}")
+    print("📈 Open in https://ui.perfetto.dev or chrome://tracing")
+
+if __name__ == "__main__":
+    main()
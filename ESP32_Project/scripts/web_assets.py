@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""
+Web Asset Builder for AI Teddy Bear
+Compresses the captive portal and OTA pages in web/ into gzip blobs that the
+firmware serves straight from flash (web_assets.h), so no page is assembled
+in RAM per request. Each blob gets an ETag from its SHA-256; browsers
+revalidate with If-None-Match and get a 304 when nothing changed.
+
+Runs before every PlatformIO build (extra_scripts = pre:scripts/web_assets.py)
+and rewrites src/web_assets_data.h only when an asset changed. Per-device
+values are not in the pages; they load /status once displayed.
+
+Usage:
+  web_assets.py            # regenerate src/web_assets_data.h
+  web_assets.py --check    # fail if the generated header is stale
+"""
+
+import gzip
+import hashlib
+import argparse
+from pathlib import Path
+
+SOURCES = "web"
+OUTPUT = "src/web_assets_data.h"
+CONTENT_TYPES = {".html": "text/html", ".css": "text/css", ".js": "application/javascript",
+                 ".json": "application/json", ".svg": "image/svg+xml"}
+
+def minify(text):
+    """Drops indentation, blank lines and whole-line // comments; keeps line
+    breaks so inline scripts never depend on semicolon insertion changes"""
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line and not line.startswith("//")) + "\n"
+
+def build_asset(path):
+    raw = path.read_bytes()
+    if path.suffix in (".html", ".css", ".js"):
+        raw = minify(raw.decode("utf-8")).encode("utf-8")
+    # mtime=0 keeps the blob, and so the ETag, stable across builds
+    packed = gzip.compress(raw, compresslevel=9, mtime=0)
+    etag = '"' + hashlib.sha256(packed).hexdigest()[:16] + '"'
+    return {"name": path.name, "type": CONTENT_TYPES.get(path.suffix, "application/octet-stream"),
+            "raw": len(raw), "data": packed, "etag": etag}
+
+def symbol(name):
+    return "WEB_" + "".join(c if c.isalnum() else "_" for c in name).upper() + "_GZ"
+
+def render_header(assets):
+    out = ["// Generated by scripts/web_assets.py from web/ - do not edit",
+           "// Included only by web_assets.cpp", ""]
+    for asset in assets:
+        out.append(f"// {asset['name']}: {asset['raw']} bytes, {len(asset['data'])} gzipped")
+        out.append(f"static const uint8_t {symbol(asset['name'])}[] PROGMEM = {{")
+        data = asset["data"]
+        for pos in range(0, len(data), 16):
+            out.append("  " + ", ".join(f"0x{b:02x}" for b in data[pos:pos + 16]) + ",")
+        out.append("};")
+        out.append("")
+    out.append("static const WebAsset WEB_ASSETS[] = {")
+    for asset in assets:
+        etag = asset["etag"].replace('"', '\\"')
+        out.append(f"  {{\"{asset['name']}\", \"{asset['type']}\", {symbol(asset['name'])}, "
+                   f"sizeof({symbol(asset['name'])}), \"{etag}\"}},")
+    out.append("};")
+    return "\n".join(out) + "\n"
+
+def generate(project_dir, check=False):
+    root = Path(project_dir)
+    sources = sorted(p for p in (root / SOURCES).iterdir() if p.is_file())
+    assets = [build_asset(p) for p in sources]
+    header = render_header(assets)
+    target = root / OUTPUT
+    current = target.read_text(encoding="utf-8") if target.exists() else None
+    if current == header:
+        return True
+    if check:
+        print(f"❌ {OUTPUT} is stale, run scripts/web_assets.py")
+        return False
+    target.write_text(header, encoding="utf-8")
+    for asset in assets:
+        print(f"🗜️ {asset['name']}: {asset['raw']} -> {len(asset['data'])} bytes "
+              f"({len(asset['data']) * 100 / asset['raw']:.0f}%), ETag {asset['etag']}")
+    print(f"✅ Wrote {OUTPUT}")
+    return True
+
+def main():
+    """Main function"""
+    parser = argparse.ArgumentParser(description="Build gzipped web assets for flash")
+    parser.add_argument("--check", action="store_true", help="Only verify the header is current")
+    args = parser.parse_args()
+    if not generate(Path(__file__).parent.parent, args.check):
+        raise SystemExit(1)
+
+try:
+    Import("env")  # noqa: F821 - provided when PlatformIO runs this as an extra script
+    generate(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        main()
@@ -0,0 +1,250 @@
+#include "alloc_guard.h"
+
+#if ALLOC_GUARD_ENABLED
+
+#include "metrics_registry.h"
+#include <esp_debug_helpers.h>
+#include <esp_timer.h>
+#include <atomic>
+
+// Everything below the wrappers runs inside malloc: no allocation, no
+// printing, no blocking. Shared state is guarded by a spinlock.
+
+struct GuardContext {
+  TaskHandle_t task;
+  const char* label;
+};
+
+static GuardContext contexts[ALLOC_GUARD_MAX_CONTEXTS];
+static AllocGuardSite sites[ALLOC_GUARD_MAX_SITES];
+static uint8_t siteCount = 0;
+static portMUX_TYPE guardMux = portMUX_INITIALIZER_UNLOCKED;
+
+static std::atomic<int64_t> armAtUs(0);     // 0 = disarmed
+static std::atomic<uint32_t> violations(0);
+static std::atomic<uint32_t> sitesOverflowed(0);
+static unsigned long lastReport = 0;
+static MetricId metricViolations = METRIC_INVALID;
+
+// =============================================================================
+// CONTEXTS
+// =============================================================================
+
+static const char* findContext(TaskHandle_t task) {
+  for (uint8_t i = 0; i < ALLOC_GUARD_MAX_CONTEXTS; i++) {
+    if (contexts[i].task == task) return contexts[i].label;
+  }
+  return nullptr;
+}
+
+static bool addContext(TaskHandle_t task, const char* label) {
+  bool added = false;
+  portENTER_CRITICAL(&guardMux);
+  if (findContext(task) == nullptr) {
+    for (uint8_t i = 0; i < ALLOC_GUARD_MAX_CONTEXTS; i++) {
+      if (contexts[i].task == nullptr) {
+        contexts[i].label = label;
+        contexts[i].task = task;
+        added = true;
+        break;
+      }
+    }
+  }
+  portEXIT_CRITICAL(&guardMux);
+  return added;
+}
+
+static void removeContext(TaskHandle_t task) {
+  portENTER_CRITICAL(&guardMux);
+  for (uint8_t i = 0; i < ALLOC_GUARD_MAX_CONTEXTS; i++) {
+    if (contexts[i].task == task) {
+      contexts[i].task = nullptr;
+      contexts[i].label = nullptr;
+    }
+  }
+  portEXIT_CRITICAL(&guardMux);
+}
+
+void allocGuardWatchTask(const char* label) {
+  addContext(xTaskGetCurrentTaskHandle(), label);
+}
+
+void allocGuardUnwatchTask() {
+  removeContext(xTaskGetCurrentTaskHandle());
+}
+
+AllocGuardScope::AllocGuardScope(const char* label)
+  : entered(addContext(xTaskGetCurrentTaskHandle(), label)) {}
+
+AllocGuardScope::~AllocGuardScope() {
+  if (entered) {
+    removeContext(xTaskGetCurrentTaskHandle());
+  }
+}
+
+// =============================================================================
+// RECORDING
+// =============================================================================
+
+// Return address to call-site PC (windowed ABI keeps the window in the top bits)
+static inline uint32_t callSitePc(uint32_t pc) {
+  if (pc & 0x80000000) {
+    pc = (pc & 0x3fffffff) | 0x40000000;
+  }
+  return pc - 3;
+}
+
+// Must stay a real frame (and checkAllocation must not be one) for the skip
+// below: recordViolation -> __wrap_* -> allocating code
+static void __attribute__((noinline)) recordViolation(const char* context, size_t size) {
+  uint32_t pcs[ALLOC_GUARD_STACK_DEPTH] = {0};
+
+  // Skip the wrapper's own frame so the stack starts at the allocating code
+  esp_backtrace_frame_t frame;
+  esp_backtrace_get_start(&frame.pc, &frame.sp, &frame.next_pc);
+  bool more = esp_backtrace_get_next_frame(&frame);
+  for (uint8_t i = 0; i < ALLOC_GUARD_STACK_DEPTH && more; i++) {
+    more = esp_backtrace_get_next_frame(&frame);
+    pcs[i] = callSitePc(frame.pc);
+  }
+
+  violations++;
+
+  portENTER_CRITICAL(&guardMux);
+  AllocGuardSite* site = nullptr;
+  for (uint8_t i = 0; i < siteCount; i++) {
+    if (sites[i].context == context && memcmp(sites[i].pcs, pcs, sizeof(pcs)) == 0) {
+      site = &sites[i];
+      break;
+    }
+  }
+  if (site == nullptr && siteCount < ALLOC_GUARD_MAX_SITES) {
+    site = &sites[siteCount++];
+    memcpy(site->pcs, pcs, sizeof(pcs));
+    site->context = context;
+    site->count = 0;
+    site->bytes = 0;
+    site->reported = false;
+  }
+  if (site != nullptr) {
+    site->count++;
+    site->bytes += size;
+  }
+  portEXIT_CRITICAL(&guardMux);
+
+  if (site == nullptr) {
+    sitesOverflowed++;
+  }
+}
+
+static inline __attribute__((always_inline)) void checkAllocation(size_t size) {
+  int64_t armAt = armAtUs.load(std::memory_order_relaxed);
+  if (armAt == 0 || xPortInIsrContext() || esp_timer_get_time() < armAt) {
+    return;
+  }
+  const char* context = findContext(xTaskGetCurrentTaskHandle());
+  if (context != nullptr) {
+    recordViolation(context, size);
+  }
+}
+
+// Link-time heap wrappers (-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc)
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  checkAllocation(size);
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  checkAllocation(count * size);
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  checkAllocation(size);
+  return __real_realloc(ptr, size);
+}
+}
+
+// =============================================================================
+// CONTROL AND REPORTING
+// =============================================================================
+
+bool initAllocGuard() {
+  metricViolations = registerGauge("mem.hot_path_allocs");
+  Serial.printf("🛡️ Allocation guard ready (warm-up %u ms, %u sites)\n",
+                ALLOC_GUARD_WARMUP_MS, ALLOC_GUARD_MAX_SITES);
+  return true;
+}
+
+void armAllocGuard(uint32_t warmupMs) {
+  armAtUs.store(esp_timer_get_time() + (int64_t)warmupMs * 1000);
+}
+
+void disarmAllocGuard() {
+  armAtUs.store(0);
+}
+
+bool isAllocGuardArmed() {
+  int64_t armAt = armAtUs.load();
+  return armAt != 0 && esp_timer_get_time() >= armAt;
+}
+
+uint32_t getAllocGuardViolations() {
+  return violations.load();
+}
+
+static void printSite(const AllocGuardSite& site) {
+  Serial.printf("🚨 Hot-path allocation in %s: %u times, %u bytes\n",
+                site.context, site.count, site.bytes);
+  Serial.print("Backtrace:");
+  for (uint8_t i = 0; i < ALLOC_GUARD_STACK_DEPTH && site.pcs[i] != 0; i++) {
+    Serial.printf(" 0x%08x:0x00000000", site.pcs[i]);
+  }
+  Serial.println();
+}
+
+void handleAllocGuard() {
+  metricSetGauge(metricViolations, (int32_t)violations.load());
+  if (millis() - lastReport < ALLOC_GUARD_REPORT_INTERVAL) return;
+  lastReport = millis();
+
+  // Copy new sites out under the lock, print outside it
+  AllocGuardSite fresh[ALLOC_GUARD_MAX_SITES];
+  uint8_t freshCount = 0;
+  portENTER_CRITICAL(&guardMux);
+  for (uint8_t i = 0; i < siteCount; i++) {
+    if (!sites[i].reported) {
+      sites[i].reported = true;
+      fresh[freshCount++] = sites[i];
+    }
+  }
+  portEXIT_CRITICAL(&guardMux);
+
+  for (uint8_t i = 0; i < freshCount; i++) {
+    printSite(fresh[i]);
+  }
+}
+
+void printAllocGuardReport() {
+  AllocGuardSite snapshot[ALLOC_GUARD_MAX_SITES];
+  portENTER_CRITICAL(&guardMux);
+  uint8_t count = siteCount;
+  memcpy(snapshot, sites, sizeof(AllocGuardSite) * count);
+  portEXIT_CRITICAL(&guardMux);
+
+  Serial.println("=== 🛡️ Allocation Guard ===");
+  Serial.printf("  Armed: %s, violations: %u, sites: %u (overflowed: %u)\n",
+                isAllocGuardArmed() ? "YES" : "NO", violations.load(), count,
+                sitesOverflowed.load());
+  for (uint8_t i = 0; i < count; i++) {
+    printSite(snapshot[i]);
+  }
+  Serial.println("===========================");
+}
+
+#endif // ALLOC_GUARD_ENABLED
@@ -0,0 +1,336 @@
+#include "anomaly_detector.h"
+#include "metrics_registry.h"
+#include "memory_budget.h"
+#include "event_bus.h"
+#include <WiFi.h>
+#include <math.h>
+
+// =============================================================================
+// DETECTORS
+// =============================================================================
+
+EwmaDetector::EwmaDetector(float smoothing, float sigmaFloor)
+  : alpha(smoothing), minSigma(sigmaFloor), average(0.0f), variance(0.0f), samples(0) {}
+
+float EwmaDetector::sigma() const {
+  return max(sqrtf(variance), minSigma);
+}
+
+float EwmaDetector::score(float x) const {
+  return (x - average) / sigma();
+}
+
+void EwmaDetector::update(float x) {
+  if (samples == 0) {
+    average = x;
+    variance = 0.0f;
+  } else {
+    float limit = ANOMALY_Z_CLIP * sigma();
+    float d = constrain(x - average, -limit, limit);
+    average += alpha * d;
+    variance = (1.0f - alpha) * (variance + alpha * d * d);
+  }
+  if (samples < UINT32_MAX) samples++;
+}
+
+void EwmaDetector::reset() {
+  average = 0.0f;
+  variance = 0.0f;
+  samples = 0;
+}
+
+float CusumDetector::update(float z) {
+  z = constrain(z, -ANOMALY_Z_CLIP, ANOMALY_Z_CLIP);
+  sum = max(0.0f, sum + z - ANOMALY_CUSUM_SLACK);
+  return sum;
+}
+
+void SlopeDetector::add(float value) {
+  values[head] = value;
+  head = (head + 1) % ANOMALY_HEAP_WINDOW;
+  if (count < ANOMALY_HEAP_WINDOW) count++;
+}
+
+bool SlopeDetector::fit(float& slope, float& t) const {
+  if (count < 3) return false;
+
+  // Two passes around the means keep float precision with heap-sized values
+  uint16_t start = (head + ANOMALY_HEAP_WINDOW - count) % ANOMALY_HEAP_WINDOW;
+  float meanX = (count - 1) / 2.0f;
+  float meanY = 0.0f;
+  for (uint16_t i = 0; i < count; i++) {
+    meanY += values[(start + i) % ANOMALY_HEAP_WINDOW];
+  }
+  meanY /= count;
+
+  float sxx = 0.0f, sxy = 0.0f, syy = 0.0f;
+  for (uint16_t i = 0; i < count; i++) {
+    float dx = i - meanX;
+    float dy = values[(start + i) % ANOMALY_HEAP_WINDOW] - meanY;
+    sxx += dx * dx;
+    sxy += dx * dy;
+    syy += dy * dy;
+  }
+  slope = sxy / sxx;
+  float residual = max(syy - slope * sxy, 0.0f) / (count - 2);
+  float standardError = sqrtf(residual / sxx);
+  t = standardError > 0.0f ? slope / standardError : (slope < 0.0f ? -INFINITY : INFINITY);
+  return true;
+}
+
+// =============================================================================
+// SIGNALS
+// =============================================================================
+
+struct SignalInfo {
+  const char* name;
+  const char* histogram;   // Registry histogram read as per-second p50; nullptr if sampled
+  bool lowIsWorse;
+};
+
+static const SignalInfo SIGNALS[ANOMALY_SIGNAL_COUNT] = {
+  {"ws.rtt",        "ws.rtt",        false},
+  {"ws.audio_send", "ws.audio_send", false},
+  {"audio.latency", "audio.latency", false},
+  {"wifi.rssi",     nullptr,         true},
+  {"heap.free",     nullptr,         true},
+};
+
+// Baselines of the EWMA/CUSUM signals; the sigma floor keeps a very steady
+// signal from turning measurement jitter into alarms
+static EwmaDetector baselines[ANOMALY_SIGNAL_HEAP] = {
+  EwmaDetector(ANOMALY_EWMA_ALPHA, 5.0f),     // ws.rtt (ms)
+  EwmaDetector(ANOMALY_EWMA_ALPHA, 500.0f),   // ws.audio_send (us)
+  EwmaDetector(ANOMALY_EWMA_ALPHA, 50.0f),    // audio.latency (ms)
+  EwmaDetector(ANOMALY_EWMA_ALPHA, 2.0f),     // wifi.rssi (dBm)
+};
+static CusumDetector shifts[ANOMALY_SIGNAL_HEAP];
+
+struct SignalState {
+  MetricId histogram;
+  HistogramWindow window;
+  AnomalySeverity severity;    // Current CUSUM or slope grade
+  float lastValue;
+  unsigned long lastNotice;
+};
+
+static SignalState states[ANOMALY_SIGNAL_COUNT];
+
+static SlopeDetector heapTrend;
+static uint32_t heapIntervalMax = 0;
+static float heapSlopePerHour = 0.0f;
+static float heapSlopeT = 0.0f;
+
+static bool anomalyInitialized = false;
+static unsigned long nextSampleMs = 0;
+static unsigned long nextHeapSampleMs = 0;
+
+static MetricId metricNotices = METRIC_INVALID;
+static MetricId metricWarnings = METRIC_INVALID;
+static MetricId metricCritical = METRIC_INVALID;
+static MetricId metricHeapSlope = METRIC_INVALID;
+
+static const char* const severityNames[] = {"none", "notice", "warning", "critical"};
+static const char* const detectorNames[] = {"ewma", "cusum", "slope"};
+
+// =============================================================================
+// EVENTS
+// =============================================================================
+
+static void raiseAnomaly(AnomalySignal signal, AnomalyDetectorKind detector,
+                         AnomalySeverity severity, float value, float baseline) {
+  Serial.printf("%s Anomaly: %s %s (%s) value=%.1f baseline=%.1f\n",
+                severity == ANOMALY_CRITICAL ? "🚨" : "⚠️", SIGNALS[signal].name,
+                severityNames[severity], detectorNames[detector], value, baseline);
+  metricIncrement(severity == ANOMALY_CRITICAL ? metricCritical
+                : severity == ANOMALY_WARNING ? metricWarnings : metricNotices);
+
+  AnomalyPayload payload;
+  payload.signal = (uint8_t)signal;
+  payload.detector = (uint8_t)detector;
+  payload.severity = (uint8_t)severity;
+  payload.value = value;
+  payload.baseline = baseline;
+  publishEvent(EVENT_HEALTH_ANOMALY, payload);
+}
+
+// Severity only escalates through events; a return to NONE is logged
+static void setSeverity(AnomalySignal signal, AnomalyDetectorKind detector,
+                        AnomalySeverity severity, float value, float baseline) {
+  SignalState& s = states[signal];
+  if (severity > s.severity) {
+    raiseAnomaly(signal, detector, severity, value, baseline);
+  } else if (severity == ANOMALY_NONE && s.severity != ANOMALY_NONE) {
+    Serial.printf("✅ Anomaly cleared: %s back to baseline (%.1f)\n", SIGNALS[signal].name, baseline);
+  } else if (severity != ANOMALY_NONE) {
+    return;   // Still elevated: keep the highest grade until it clears
+  }
+  s.severity = severity;
+}
+
+// =============================================================================
+// EVALUATION
+// =============================================================================
+
+static void evaluateSample(AnomalySignal signal, float x, unsigned long now) {
+  EwmaDetector& baseline = baselines[signal];
+  SignalState& s = states[signal];
+  s.lastValue = x;
+
+  if (!baseline.warmedUp()) {
+    baseline.update(x);
+    return;
+  }
+
+  float expected = baseline.mean();
+  float z = baseline.score(x);
+  if (SIGNALS[signal].lowIsWorse) z = -z;
+  float cusum = shifts[signal].update(z);
+  baseline.update(x);
+
+  AnomalySeverity level = cusum >= ANOMALY_CUSUM_CRITICAL ? ANOMALY_CRITICAL
+                        : cusum >= ANOMALY_CUSUM_WARNING ? ANOMALY_WARNING : ANOMALY_NONE;
+  if (level != ANOMALY_NONE || cusum == 0.0f) {
+    setSeverity(signal, ANOMALY_DETECTOR_CUSUM, level, x, expected);
+  }
+
+  // Isolated outliers while no shift is established
+  if (s.severity < ANOMALY_WARNING && z >= ANOMALY_Z_NOTICE &&
+      (s.lastNotice == 0 || now - s.lastNotice >= ANOMALY_NOTICE_HOLD)) {
+    s.lastNotice = now;
+    raiseAnomaly(signal, ANOMALY_DETECTOR_EWMA, ANOMALY_NOTICE, x, expected);
+  }
+}
+
+static void evaluateHeapTrend(uint32_t freeHeap) {
+  heapTrend.add((float)freeHeap);
+  float slopePerSample, t;
+  if (!heapTrend.fit(slopePerSample, t)) return;
+
+  heapSlopePerHour = slopePerSample * (3600000.0f / ANOMALY_HEAP_SAMPLE_INTERVAL);
+  heapSlopeT = t;
+  metricSetGauge(metricHeapSlope, (int32_t)lroundf(heapSlopePerHour));
+  if (!heapTrend.full()) return;   // Too short a window to call a trend
+
+  AnomalySeverity level = ANOMALY_NONE;
+  if (heapSlopePerHour <= -ANOMALY_HEAP_LEAK_WARNING && t <= -ANOMALY_HEAP_MIN_T) {
+    level = ANOMALY_WARNING;
+    float headroom = (float)freeHeap - MEM_BUDGET_FREE_CRITICAL;
+    if (headroom <= 0.0f || headroom / -heapSlopePerHour * 3600.0f < ANOMALY_HEAP_CRITICAL_HORIZON) {
+      level = ANOMALY_CRITICAL;
+    }
+  }
+  setSeverity(ANOMALY_SIGNAL_HEAP, ANOMALY_DETECTOR_SLOPE, level, heapSlopePerHour, (float)freeHeap);
+}
+
+// p50 of the observations since the previous sample
+static bool windowMedian(AnomalySignal signal, float& value) {
+  static const float kMedian[] = {50.0f};
+  SignalState& s = states[signal];
+  if (s.histogram == METRIC_INVALID) {
+    s.histogram = findMetric(METRIC_HISTOGRAM, SIGNALS[signal].histogram);
+    if (s.histogram == METRIC_INVALID) return false;
+    getHistogramWindow(s.histogram, s.window, nullptr, nullptr, 0);   // Start the window now
+    return false;
+  }
+  uint32_t p50;
+  if (getHistogramWindow(s.histogram, s.window, kMedian, &p50, 1) == 0) return false;
+  value = (float)p50;
+  return true;
+}
+
+// =============================================================================
+// LIFECYCLE
+// =============================================================================
+
+bool initAnomalyDetection() {
+  if (anomalyInitialized) return true;
+
+  for (uint8_t i = 0; i < ANOMALY_SIGNAL_COUNT; i++) {
+    states[i].histogram = METRIC_INVALID;
+    states[i].severity = ANOMALY_NONE;
+    states[i].lastValue = 0.0f;
+    states[i].lastNotice = 0;
+  }
+  metricNotices = registerCounter("anomaly.notices");
+  metricWarnings = registerCounter("anomaly.warnings");
+  metricCritical = registerCounter("anomaly.critical");
+  metricHeapSlope = registerGauge("heap.slope", "bytes/h");
+
+  nextSampleMs = millis() + ANOMALY_SAMPLE_INTERVAL;
+  nextHeapSampleMs = millis() + ANOMALY_HEAP_SAMPLE_INTERVAL;
+  anomalyInitialized = true;
+  Serial.printf("✅ Anomaly detection ready (%u signals, heap window %u min)\n",
+                ANOMALY_SIGNAL_COUNT,
+                (unsigned)(ANOMALY_HEAP_WINDOW * ANOMALY_HEAP_SAMPLE_INTERVAL / 60000));
+  return true;
+}
+
+void handleAnomalyDetection() {
+  if (!anomalyInitialized) return;
+  unsigned long now = millis();
+  if ((long)(now - nextSampleMs) < 0) return;
+  nextSampleMs += ANOMALY_SAMPLE_INTERVAL;
+  if ((long)(now - nextSampleMs) >= 0) {
+    nextSampleMs = now + ANOMALY_SAMPLE_INTERVAL;   // Loop was blocked: skip, don't burst
+  }
+
+  for (uint8_t i = 0; i < ANOMALY_SIGNAL_COUNT; i++) {
+    float value;
+    if (SIGNALS[i].histogram != nullptr && windowMedian((AnomalySignal)i, value)) {
+      evaluateSample((AnomalySignal)i, value, now);
+    }
+  }
+  if (WiFi.status() == WL_CONNECTED) {
+    evaluateSample(ANOMALY_SIGNAL_WIFI_RSSI, (float)WiFi.RSSI(), now);
+  }
+
+  // Heap: the highest free level of each interval, so transient buffers
+  // don't read as a trend
+  heapIntervalMax = max(heapIntervalMax, ESP.getFreeHeap());
+  if ((long)(now - nextHeapSampleMs) >= 0) {
+    nextHeapSampleMs = now + ANOMALY_HEAP_SAMPLE_INTERVAL;
+    states[ANOMALY_SIGNAL_HEAP].lastValue = (float)heapIntervalMax;
+    evaluateHeapTrend(heapIntervalMax);
+    heapIntervalMax = 0;
+  }
+}
+
+// =============================================================================
+// STATE
+// =============================================================================
+
+AnomalySeverity getAnomalySeverity(AnomalySignal signal) {
+  return signal < ANOMALY_SIGNAL_COUNT ? states[signal].severity : ANOMALY_NONE;
+}
+
+const char* getAnomalySignalName(AnomalySignal signal) {
+  return signal < ANOMALY_SIGNAL_COUNT ? SIGNALS[signal].name : "unknown";
+}
+
+const char* getAnomalySeverityName(AnomalySeverity severity) {
+  return severity <= ANOMALY_CRITICAL ? severityNames[severity] : "unknown";
+}
+
+const char* getAnomalyDetectorName(AnomalyDetectorKind detector) {
+  return detector <= ANOMALY_DETECTOR_SLOPE ? detectorNames[detector] : "unknown";
+}
+
+float getHeapSlopePerHour() {
+  return heapSlopePerHour;
+}
+
+void printAnomalyStatus() {
+  Serial.println("=== 🔎 Anomaly Detection ===");
+  Serial.println("Signal          Last       Mean      Sigma   CUSUM  State");
+  for (uint8_t i = 0; i < ANOMALY_SIGNAL_HEAP; i++) {
+    const EwmaDetector& b = baselines[i];
+    Serial.printf("%-14s %6.1f %10.1f %10.1f %7.2f  %s%s\n", SIGNALS[i].name, states[i].lastValue,
+                  b.mean(), b.sigma(), shifts[i].value(), severityNames[states[i].severity],
+                  b.warmedUp() ? "" : " (warming up)");
+  }
+  Serial.printf("%-14s %6.0f  slope %+.0f bytes/h, t %.1f  %s%s\n", SIGNALS[ANOMALY_SIGNAL_HEAP].name,
+                states[ANOMALY_SIGNAL_HEAP].lastValue, heapSlopePerHour, heapSlopeT,
+                severityNames[states[ANOMALY_SIGNAL_HEAP].severity],
+                heapTrend.full() ? "" : " (filling window)");
+}
@@ -0,0 +1,150 @@
+#include "audio_frame.h"
+#include "resource_manager.h"
+#include <new>
+
+// Updated from the capture, streaming and WebSocket tasks
+static std::atomic<uint32_t> statAllocated(0);
+static std::atomic<uint32_t> statAllocFailures(0);
+static std::atomic<uint32_t> statShares(0);
+static std::atomic<uint32_t> statCowCopies(0);
+static std::atomic<uint32_t> statBytesCopied(0);
+static std::atomic<uint32_t> statBytesCaptured(0);
+
+// =============================================================================
+// FRAME HANDLE
+// =============================================================================
+
+AudioFrame AudioFrame::allocate(size_t capacity, size_t headroom) {
+  if (capacity == 0 || headroom > UINT16_MAX) {
+    statAllocFailures++;
+    return AudioFrame();
+  }
+
+  void* block = poolAlloc(sizeof(AudioFrameBuffer) + headroom + capacity);
+  if (block == nullptr) {
+    statAllocFailures++;
+    return AudioFrame();
+  }
+
+  AudioFrameBuffer* b = new (block) AudioFrameBuffer;
+  b->refs.store(1);
+  b->headroom = (uint16_t)headroom;
+  b->capacity = (uint32_t)capacity;
+  b->length = 0;
+  statAllocated++;
+  return AudioFrame(b);
+}
+
+AudioFrame::AudioFrame(const AudioFrame& other) : buffer(other.buffer) {
+  if (buffer) {
+    buffer->refs++;
+    statShares++;
+  }
+}
+
+AudioFrame& AudioFrame::operator=(const AudioFrame& other) {
+  if (buffer != other.buffer) {
+    release();
+    buffer = other.buffer;
+    if (buffer) {
+      buffer->refs++;
+      statShares++;
+    }
+  }
+  return *this;
+}
+
+AudioFrame& AudioFrame::operator=(AudioFrame&& other) {
+  if (this != &other) {
+    release();
+    buffer = other.buffer;
+    other.buffer = nullptr;
+  }
+  return *this;
+}
+
+void AudioFrame::release() {
+  if (buffer == nullptr) return;
+  if (buffer->refs.fetch_sub(1) == 1) {
+    buffer->~AudioFrameBuffer();
+    poolFree(buffer);
+  }
+  buffer = nullptr;
+}
+
+AudioFrameBuffer* AudioFrame::detach() {
+  AudioFrameBuffer* b = buffer;
+  buffer = nullptr;
+  return b;
+}
+
+// Clone the buffer if another handle can still read it
+bool AudioFrame::makeExclusive() {
+  if (buffer == nullptr) return false;
+  if (buffer->refs.load() == 1) return true;
+
+  AudioFrame clone = allocate(buffer->capacity, buffer->headroom);
+  if (!clone) return false;
+
+  memcpy(clone.buffer->payload(), buffer->payload(), buffer->length);
+  clone.buffer->length = buffer->length;
+  statCowCopies++;
+  statBytesCopied += buffer->length;
+
+  *this = static_cast<AudioFrame&&>(clone);
+  return true;
+}
+
+uint8_t* AudioFrame::mutableData() {
+  return makeExclusive() ? buffer->payload() : nullptr;
+}
+
+uint8_t* AudioFrame::mutableHeadroom() {
+  return makeExclusive() ? buffer->payload() - buffer->headroom : nullptr;
+}
+
+bool AudioFrame::setLength(size_t length) {
+  if (length > capacity() || !makeExclusive()) return false;
+  buffer->length = (uint32_t)length;
+  return true;
+}
+
+// =============================================================================
+// COPY ACCOUNTING
+// =============================================================================
+
+void noteAudioCopy(size_t bytes) {
+  statBytesCopied += (uint32_t)bytes;
+}
+
+void noteAudioCaptured(size_t bytes) {
+  statBytesCaptured += (uint32_t)bytes;
+}
+
+AudioFrameStats getAudioFrameStats() {
+  AudioFrameStats stats;
+  stats.allocated = statAllocated.load();
+  stats.allocFailures = statAllocFailures.load();
+  stats.shares = statShares.load();
+  stats.cowCopies = statCowCopies.load();
+  stats.bytesCopied = statBytesCopied.load();
+  stats.bytesCaptured = statBytesCaptured.load();
+  return stats;
+}
+
+void printAudioFrameStats() {
+  AudioFrameStats stats = getAudioFrameStats();
+  float audioSeconds = (float)stats.bytesCaptured / AUDIO_FRAME_BYTES_PER_SECOND;
+
+  Serial.println("=== 🎞️ Audio Frames ===");
+  Serial.printf("  Allocated: %u (failures: %u), shared: %u, copy-on-write: %u\n",
+                stats.allocated, stats.allocFailures, stats.shares, stats.cowCopies);
+  Serial.printf("  Captured: %u bytes (%.1f s), copied: %u bytes\n",
+                stats.bytesCaptured, audioSeconds, stats.bytesCopied);
+  if (audioSeconds > 0.0f) {
+    Serial.printf("  Copied per second of audio: %.0f bytes (%.2fx the PCM rate)\n",
+                  stats.bytesCopied / audioSeconds,
+                  (float)stats.bytesCopied / stats.bytesCaptured);
+  }
+  Serial.println("=======================");
+}
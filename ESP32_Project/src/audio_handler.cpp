@@ -6,6 +6,13 @@
 #include "monitoring.h"
 #include "system_monitor.h"  // For production system monitoring
 #include "comprehensive_logging.h"  // Comprehensive logging system
+#include "utterance_trace.h"  // Per-utterance latency spans
+#include "resource_manager.h"  // Tracked allocations
+#include "event_bus.h"  // Captured chunks go to the WebSocket task as events
+#include "alloc_guard.h"  // Steady-state allocation checks (debug builds)
+#include "stack_monitor.h"  // Stack high-water tracking
+#include "audio_tap.h"  // Debug PCM taps
+#include "metrics_registry.h"  // Dropped-sample counter
 #include <driver/adc.h>       // ADC for analog microphone (HW-164)
 #include <WiFi.h>
 #include <math.h>
@@ -22,6 +29,7 @@
   
 // Production FreeRTOS priorities for audio
 #define AUDIO_CAPTURE_PRIORITY   (configMAX_PRIORITIES - 2)  // Highest for audio capture
+#define AUDIO_CAPTURE_STACK_SIZE 4096
 #define AUDIO_PLAYBACK_PRIORITY  (configMAX_PRIORITIES - 3)  // High for audio playback  
 #define WEBSOCKET_SEND_PRIORITY  (configMAX_PRIORITIES - 4)  // Medium for network
 
@@ -34,6 +42,7 @@ AudioState currentAudioState = AUDIO_IDLE;
 static uint8_t* audioBuffer = nullptr;
 size_t audioBufferSize = 0;
 size_t audioBufferIndex = 0;
+static volatile size_t captureChunkSize = AUDIO_CHUNK_SIZE;
 bool recordingActive = false;
 volatile bool audioInitialized = false;
 
@@ -78,9 +87,6 @@ static volatile bool     streamingActive = false;
 static int               adcBaseline = 2048; // DC offset for 12-bit ADC
 static adc1_channel_t    micChannel = ADC1_CHANNEL_6; // Default for GPIO34
 
-// Forward declaration to send over WebSocket JSON protocol
-extern void sendAudioDataWebSocket(uint8_t* audioData, size_t length);
-
 // Map MIC_PIN to ADC1 channel (GPIOs valid for ADC1)
 static adc1_channel_t pinToAdc1Channel(int pin) {
   switch (pin) {
@@ -107,16 +113,49 @@ static void adc_calibrate_baseline() {
   adcBaseline = (int)(sum / N);
 }
 
+// Hand a filled frame to the WebSocket task (JSON + Base64 with HMAC)
+static void publishAudioChunk(AudioFrame& chunk, size_t length, bool finalChunk) {
+  noteAudioCaptured(length);
+  AUDIO_TAP(AUDIO_TAP_CAPTURE, chunk.data(), length);
+  chunk.setLength(length);
+  if (!publishEvent(EVENT_AUDIO_CHUNK, chunk, finalChunk ? EVENT_FLAG_FINAL : 0)) {
+    Serial.println("⚠️ Audio chunk dropped: WebSocket queue unavailable");
+  }
+  chunk.release();
+}
+
+// Samples are written straight into a pooled frame that is handed to the
+// WebSocket task as an event, so capture never blocks on the network
 static void adc_capture_task(void* pv) {
   const uint32_t target_us = 1000000UL / SAMPLE_RATE; // ~62.5us at 16kHz
-  static uint8_t chunkBuf[AUDIO_CHUNK_SIZE];
+  AudioFrame chunk;
+  uint8_t* chunkBuf = nullptr;
+  size_t chunkBytes = 0;
   size_t index = 0;
   const size_t bytesPerSample = 2;
 
+  registerCurrentTaskStack("adc_capture_task", AUDIO_CAPTURE_STACK_SIZE);
+  allocGuardWatchTask("capture");
+  MetricId metricDroppedSamples = registerCounter("audio.dropped_samples");
+
   // Calibrate baseline at task start
   adc_calibrate_baseline();
+  uint32_t chunkStartUs = traceNow();
 
   while (streamingActive) {
+    if (chunkBuf == nullptr) {
+      chunkBytes = captureChunkSize;
+      chunk = AudioFrame::allocate(chunkBytes);
+      chunkBuf = chunk.mutableData();
+      if (chunkBuf == nullptr) {
+        // No frame memory (pool and heap): skip samples until one frees, and count them
+        uint32_t stalledUs = micros();
+        vTaskDelay(pdMS_TO_TICKS(5));
+        metricIncrement(metricDroppedSamples, (micros() - stalledUs) / target_us);
+        continue;
+      }
+    }
+
     uint32_t raw = (uint32_t)adc1_get_raw(micChannel); // 0..4095
     // Slow moving average to track DC drift
     adcBaseline = (adcBaseline * 99 + (int)raw) / 100;
@@ -130,9 +169,12 @@ static void adc_capture_task(void* pv) {
     chunkBuf[index++] = (uint8_t)(s16 & 0xFF);
     chunkBuf[index++] = (uint8_t)((s16 >> 8) & 0xFF);
 
-    if (index >= AUDIO_CHUNK_SIZE) {
-      sendAudioData(chunkBuf, index);
+    if (index >= chunkBytes) {
+      traceComplete(TRACE_SPAN_CAPTURE, chunkStartUs, traceArg(index));
+      publishAudioChunk(chunk, index, false);
+      chunkBuf = nullptr;
       index = 0;
+      chunkStartUs = traceNow();
     }
 
     // Pace to target sample rate
@@ -142,8 +184,12 @@ static void adc_capture_task(void* pv) {
 
   // Flush any remaining samples
   if (index > 0) {
-    sendAudioData(chunkBuf, index);
+    traceComplete(TRACE_SPAN_CAPTURE, chunkStartUs, traceArg(index));
+    publishAudioChunk(chunk, index, true);
   }
+  chunk.release();
+  allocGuardUnwatchTask();
+  noteTaskStackExit();
 
   // Mark handle as cleared before self-delete to avoid double delete
   audio_capture_task_handle = nullptr;
@@ -153,17 +199,15 @@ static void adc_capture_task(void* pv) {
 // Memory management functions
 static bool allocateAudioBuffer() {
   if (audioBuffer != nullptr) {
-    free(audioBuffer);
+    TRACK_FREE(audioBuffer, "audio_buffer");
     audioBuffer = nullptr;
   }
   
   {
     size_t target = SAMPLE_RATE * RECORD_TIME * 2; // 16-bit samples
-    // Limit buffer temporarily to reduce TLS pressure during handshake
-    const size_t AUDIO_BUFFER_BYTES = 48000; // temporary cap
     audioBufferSize = (target > AUDIO_BUFFER_BYTES) ? AUDIO_BUFFER_BYTES : target;
   }
-  audioBuffer = (uint8_t*)malloc(audioBufferSize);
+  audioBuffer = (uint8_t*)TRACK_MALLOC(audioBufferSize, "audio_buffer");
   
   if (audioBuffer == nullptr) {
     Serial.println("Ã¢Â'Å' Failed to allocate audio buffer!");
@@ -178,13 +222,51 @@ static bool allocateAudioBuffer() {
 
 static void deallocateAudioBuffer() {
   if (audioBuffer != nullptr) {
-    free(audioBuffer);
+    TRACK_FREE(audioBuffer, "audio_buffer");
     audioBuffer = nullptr;
   }
   audioBufferSize = 0;
   audioBufferIndex = 0;
 }
 
+size_t getAudioBufferSize() {
+  return audioBufferSize;
+}
+
+// Shrinking frees first so the smaller block can reuse the space; growing
+// allocates first so a failure keeps the current buffer
+bool setAudioBufferSize(size_t bytes) {
+  if (!audioInitialized || recordingActive || bytes == 0) return false;
+  if (bytes > AUDIO_BUFFER_BYTES) bytes = AUDIO_BUFFER_BYTES;
+  if (bytes == audioBufferSize) return true;
+
+  if (bytes < audioBufferSize) {
+    TRACK_FREE(audioBuffer, "audio_buffer");
+    audioBuffer = nullptr;
+  }
+  uint8_t* resized = (uint8_t*)TRACK_MALLOC(bytes, "audio_buffer");
+  if (resized == nullptr) {
+    if (audioBuffer == nullptr) audioBufferSize = 0;
+    return false;
+  }
+  if (audioBuffer != nullptr) {
+    TRACK_FREE(audioBuffer, "audio_buffer");
+  }
+  audioBuffer = resized;
+  audioBufferSize = bytes;
+  audioBufferIndex = 0;
+  Serial.printf("Audio buffer resized: %u bytes\n", (unsigned)bytes);
+  return true;
+}
+
+size_t getCaptureChunkSize() {
+  return captureChunkSize;
+}
+
+void setCaptureChunkSize(size_t bytes) {
+  captureChunkSize = constrain(bytes, (size_t)512, (size_t)AUDIO_CHUNK_SIZE) & ~(size_t)1;
+}
+
 bool initAudio() {
   if (audioInitialized) {
     Serial.println("Audio already initialized");
@@ -333,6 +415,7 @@ void playAudioResponse(uint8_t* audioData, size_t length) {
     updateAudioFlowState(AUDIO_FLOW_COMPLETE);
     return;
   }
+  AUDIO_TAP(AUDIO_TAP_PLAYBACK, audioData, length);
   logAudioEvent("Audio playback started", "PCM s16le via DAC (if enabled)");
 #if AUDIO_USE_DAC
   // Play PCM s16le mono at SAMPLE_RATE using 8-bit DAC on GPIO25
@@ -375,18 +458,21 @@ void startRealTimeStreaming() {
   updateAudioFlowState(AUDIO_FLOW_RECORDING);
   logAudioEvent("Real-time streaming started", "ADC 16kHz mono s16le");
 
-  // Notify server: start audio session
+  // Notify server: start audio session (carries the new utterance id)
+  beginUtteranceTrace();
   sendAudioStartSession();
+  armAllocGuard();
 
   // Spawn high-priority capture task
   if (audio_capture_task_handle) {
+    forgetTaskStack(audio_capture_task_handle);
     vTaskDelete(audio_capture_task_handle);
     audio_capture_task_handle = nullptr;
   }
   xTaskCreatePinnedToCore(
     adc_capture_task,
     "adc_capture_task",
-    4096,
+    AUDIO_CAPTURE_STACK_SIZE,
     nullptr,
     AUDIO_CAPTURE_PRIORITY,
     &audio_capture_task_handle,
@@ -399,8 +485,8 @@ void stopRealTimeStreaming() {
   if (!streamingActive) {
     return;
   }
-  // Mark next outgoing chunk as final, then stop capture loop
-  markNextChunkFinal();
+  // Stop the capture loop; it marks its last chunk final
+  disarmAllocGuard();
   streamingActive = false;
   // Wait for capture task to exit on its own (max ~500ms)
   const int maxWaitIters = 50;
@@ -409,8 +495,11 @@ void stopRealTimeStreaming() {
     vTaskDelay(10 / portTICK_PERIOD_MS);
     taskYIELD();
   }
+  // Send queued chunks before ending the session
+  flushWebSocketEvents();
   // Notify server: end audio session
   sendAudioEndSession();
+  traceInstant(TRACE_SPAN_AUDIO_END);
   setAudioState(AUDIO_IDLE);
   updateAudioFlowState(AUDIO_FLOW_COMPLETE);
   logAudioEvent("Real-time streaming stopped", "ADC capture ended");
@@ -451,12 +540,20 @@ bool isRecording() {
 
 void sendAudioData(uint8_t* audioData, size_t length) {
   if (!audioData || length == 0) return;
-  // Forward to WebSocket sender (JSON + Base64 with HMAC)
-  sendAudioDataWebSocket(audioData, length);
+  AudioFrame chunk = AudioFrame::allocate(length);
+  uint8_t* data = chunk.mutableData();
+  if (data == nullptr) {
+    Serial.println("❌ No frame for audio chunk");
+    return;
+  }
+  memcpy(data, audioData, length);
+  noteAudioCopy(length);
+  publishAudioChunk(chunk, length, false);
 }
 
 void handleAudioResponse(JsonObject params) {
   logAudioEvent("Handling audio response", "Simple implementation");
+  traceInstant(TRACE_SPAN_RESPONSE);
   
   String text = params["text"] | "";
   String format = params["format"] | "pcm_s16le";
@@ -465,7 +562,11 @@ void handleAudioResponse(JsonObject params) {
   logAudioEvent("Audio response received", "Text: " + text + ", Format: " + format + ", Rate: " + String(audioRate));
   
   // Simulate audio playback
-  playAudioResponse(nullptr, 0);
+  {
+    TraceScope playbackSpan(TRACE_SPAN_PLAYBACK);
+    playAudioResponse(nullptr, 0);
+  }
+  endUtteranceTrace();
 }
 
 String calculateAudioHMAC(uint8_t* audioData, size_t length, const String& chunkId, const String& sessionId) {
@@ -9,6 +9,7 @@
 #define SAMPLE_RATE 16000
 #define RECORD_TIME 3  // seconds
 #define AUDIO_CHUNK_SIZE 4096
+#define AUDIO_BUFFER_BYTES 48000  // Record buffer cap, limits TLS pressure during handshake
 
 // Audio states
 typedef enum {
@@ -54,6 +55,12 @@ void startRealTimeStreaming();
 void stopRealTimeStreaming();
 void playTone(int frequency, int duration);
 
+// Memory budget hooks
+size_t getAudioBufferSize();
+bool setAudioBufferSize(size_t bytes);     // Refused while recording
+size_t getCaptureChunkSize();
+void setCaptureChunkSize(size_t bytes);    // Applies from the next chunk; 512..AUDIO_CHUNK_SIZE
+
 // Audio processing functions
 String calculateAudioHMAC(uint8_t* audioData, size_t length, const String& chunkId, const String& sessionId);
 
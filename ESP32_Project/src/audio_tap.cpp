@@ -0,0 +1,278 @@
+#include "audio_tap.h"
+
+#if FEATURE_AUDIO_TAPS
+
+#include <SPIFFS.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+
+volatile uint32_t audioTapMask = 0;
+
+struct TapRing {
+  int16_t* samples;
+  uint32_t capacity;
+  uint32_t head;       // Next write position
+  uint32_t total;      // Samples written since arming
+  uint32_t armedUs;
+  uint32_t endUs;
+};
+
+static const char* const TAP_NAMES[AUDIO_TAP_COUNT] = {
+  "capture", "send", "playback"
+};
+
+static TapRing rings[AUDIO_TAP_COUNT];
+
+// Held by writers for the whole copy, so clearing a mask bit under it
+// guarantees the ring is no longer being written
+static portMUX_TYPE tapLock = portMUX_INITIALIZER_UNLOCKED;
+
+// =============================================================================
+// STAGE SIDE
+// =============================================================================
+
+void audioTapWrite(AudioTapPoint tap, const void* pcm, size_t bytes) {
+  const int16_t* in = static_cast<const int16_t*>(pcm);
+  uint32_t count = bytes / sizeof(int16_t);
+
+  portENTER_CRITICAL(&tapLock);
+  TapRing& ring = rings[tap];
+  if (audioTapEnabled(tap) && ring.samples != nullptr && count > 0) {
+    if (count > ring.capacity) {
+      // Only the newest capacity samples survive anyway
+      ring.total += count - ring.capacity;
+      in += count - ring.capacity;
+      count = ring.capacity;
+    }
+    uint32_t first = min(count, ring.capacity - ring.head);
+    memcpy(ring.samples + ring.head, in, first * sizeof(int16_t));
+    memcpy(ring.samples, in + first, (count - first) * sizeof(int16_t));
+    ring.head = (ring.head + count) % ring.capacity;
+    ring.total += count;
+    ring.endUs = micros();
+  }
+  portEXIT_CRITICAL(&tapLock);
+}
+
+// =============================================================================
+// ARMING
+// =============================================================================
+
+static void releaseRings() {
+  portENTER_CRITICAL(&tapLock);
+  audioTapMask = 0;
+  portEXIT_CRITICAL(&tapLock);
+
+  for (int i = 0; i < AUDIO_TAP_COUNT; i++) {
+    if (rings[i].samples != nullptr) {
+      heap_caps_free(rings[i].samples);
+    }
+    rings[i] = TapRing{};
+  }
+}
+
+bool enableAudioTaps(uint32_t mask) {
+  mask &= AUDIO_TAP_ALL;
+  releaseRings();
+  if (mask == 0) {
+    return true;
+  }
+
+  uint32_t bytes = (AUDIO_TAP_BUDGET_BYTES / __builtin_popcount(mask)) & ~1u;
+  if (bytes < AUDIO_TAP_MIN_BYTES) {
+    Serial.printf("❌ Audio taps: %u bytes per tap is below the %u byte minimum\n", bytes, AUDIO_TAP_MIN_BYTES);
+    return false;
+  }
+
+  uint32_t now = micros();
+  for (int i = 0; i < AUDIO_TAP_COUNT; i++) {
+    if (!(mask & (1u << i))) continue;
+    // PSRAM when fitted keeps the rings out of internal RAM
+    int16_t* samples = (int16_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (samples == nullptr) {
+      samples = (int16_t*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (samples == nullptr) {
+      Serial.printf("❌ Audio taps: no memory for %s (%u bytes)\n", TAP_NAMES[i], bytes);
+      releaseRings();
+      return false;
+    }
+    rings[i].samples = samples;
+    rings[i].capacity = bytes / sizeof(int16_t);
+    rings[i].armedUs = now;
+  }
+
+  portENTER_CRITICAL(&tapLock);
+  audioTapMask = mask;
+  portEXIT_CRITICAL(&tapLock);
+
+  Serial.printf("🎙️ Audio taps armed: %u x %u KB (%.1f s each)\n", __builtin_popcount(mask), bytes / 1024,
+                (float)(bytes / sizeof(int16_t)) / AUDIO_TAP_SAMPLE_RATE);
+  return true;
+}
+
+uint32_t getEnabledAudioTaps() {
+  return audioTapMask;
+}
+
+bool findAudioTap(const char* name, AudioTapPoint& tap) {
+  for (int i = 0; i < AUDIO_TAP_COUNT; i++) {
+    if (strcmp(name, TAP_NAMES[i]) == 0) {
+      tap = (AudioTapPoint)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* getAudioTapName(AudioTapPoint tap) {
+  return tap < AUDIO_TAP_COUNT ? TAP_NAMES[tap] : "unknown";
+}
+
+AudioTapInfo getAudioTapInfo(AudioTapPoint tap) {
+  portENTER_CRITICAL(&tapLock);
+  const TapRing& ring = rings[tap];
+  AudioTapInfo info = {TAP_NAMES[tap], audioTapEnabled(tap), ring.capacity, ring.total, ring.endUs};
+  portEXIT_CRITICAL(&tapLock);
+  return info;
+}
+
+// =============================================================================
+// WAV EXPORT
+// =============================================================================
+
+static uint8_t* putTag(uint8_t* p, const char* tag) {
+  memcpy(p, tag, 4);
+  return p + 4;
+}
+
+static uint8_t* put32(uint8_t* p, uint32_t value) {
+  p[0] = value; p[1] = value >> 8; p[2] = value >> 16; p[3] = value >> 24;
+  return p + 4;
+}
+
+static uint8_t* put16(uint8_t* p, uint16_t value) {
+  p[0] = value; p[1] = value >> 8;
+  return p + 2;
+}
+
+// RIFF header, fmt chunk, LIST/INFO/ICMT with the stage metadata, data header
+static size_t buildWavHeader(uint8_t* out, AudioTapPoint tap, const TapRing& ring, uint32_t samples) {
+  char comment[96];
+  int len = snprintf(comment, sizeof(comment), "tap=%s stage=%d rate=%d total=%u armed_us=%u end_us=%u",
+                     TAP_NAMES[tap], (int)tap, AUDIO_TAP_SAMPLE_RATE, ring.total, ring.armedUs, ring.endUs);
+  uint32_t textSize = len + 1;                 // NUL terminated
+  uint32_t textPadded = (textSize + 1) & ~1u;  // Chunks are word aligned
+  uint32_t listSize = 4 + 8 + textPadded;
+  uint32_t dataSize = samples * sizeof(int16_t);
+
+  uint8_t* p = out;
+  p = putTag(p, "RIFF");
+  p = put32(p, 4 + (8 + 16) + (8 + listSize) + (8 + dataSize));
+  p = putTag(p, "WAVE");
+
+  p = putTag(p, "fmt ");
+  p = put32(p, 16);
+  p = put16(p, 1);                             // PCM
+  p = put16(p, 1);                             // Mono
+  p = put32(p, AUDIO_TAP_SAMPLE_RATE);
+  p = put32(p, AUDIO_TAP_SAMPLE_RATE * sizeof(int16_t));
+  p = put16(p, sizeof(int16_t));
+  p = put16(p, 16);
+
+  p = putTag(p, "LIST");
+  p = put32(p, listSize);
+  p = putTag(p, "INFO");
+  p = putTag(p, "ICMT");
+  p = put32(p, textSize);
+  memset(p, 0, textPadded);
+  memcpy(p, comment, len);
+  p += textPadded;
+
+  p = putTag(p, "data");
+  p = put32(p, dataSize);
+  return p - out;
+}
+
+bool exportAudioTap(AudioTapPoint tap, AudioTapSink sink, void* context) {
+  if (tap >= AUDIO_TAP_COUNT) return false;
+  const uint32_t bit = 1u << tap;
+
+  // Pause the tap; once the bit is clear under the lock no writer is inside
+  portENTER_CRITICAL(&tapLock);
+  bool wasArmed = (audioTapMask & bit) != 0;
+  audioTapMask &= ~bit;
+  portEXIT_CRITICAL(&tapLock);
+
+  const TapRing& ring = rings[tap];
+  if (ring.samples == nullptr) {
+    return false;
+  }
+
+  uint32_t count = min(ring.total, ring.capacity);
+  uint32_t pos = (ring.head + ring.capacity - count) % ring.capacity;
+
+  uint8_t header[160];   // Fixed chunks plus the longest comment
+  size_t headerSize = buildWavHeader(header, tap, ring, count);
+  bool ok = sink(context, header, headerSize);
+
+  // Ring is little-endian s16 already; hand it over in slices
+  while (ok && count > 0) {
+    uint32_t slice = min(count, min((uint32_t)AUDIO_TAP_READ_SAMPLES, ring.capacity - pos));
+    ok = sink(context, (const uint8_t*)(ring.samples + pos), slice * sizeof(int16_t));
+    pos = (pos + slice) % ring.capacity;
+    count -= slice;
+  }
+
+  if (wasArmed) {
+    portENTER_CRITICAL(&tapLock);
+    audioTapMask |= bit;
+    portEXIT_CRITICAL(&tapLock);
+  }
+  return ok;
+}
+
+static bool fileSink(void* context, const uint8_t* data, size_t length) {
+  return static_cast<File*>(context)->write(data, length) == length;
+}
+
+bool saveAudioTap(AudioTapPoint tap) {
+  AudioTapInfo info = getAudioTapInfo(tap);
+  if (info.capacity == 0) {
+    Serial.printf("❌ Audio tap %s is not armed\n", info.name);
+    return false;
+  }
+  if (!SPIFFS.begin(true)) {
+    Serial.println("❌ Failed to initialize SPIFFS");
+    return false;
+  }
+
+  char path[32];
+  snprintf(path, sizeof(path), AUDIO_TAP_FILE_PREFIX "%s.wav", info.name);
+  SPIFFS.remove(path);
+
+  size_t needed = min(info.total, info.capacity) * sizeof(int16_t) + 256;
+  if (SPIFFS.totalBytes() - SPIFFS.usedBytes() < needed) {
+    Serial.printf("❌ SPIFFS: %u bytes needed for %s, %u free\n", needed, path,
+                  SPIFFS.totalBytes() - SPIFFS.usedBytes());
+    return false;
+  }
+
+  File file = SPIFFS.open(path, FILE_WRITE);
+  if (!file) {
+    Serial.printf("❌ Failed to create %s\n", path);
+    return false;
+  }
+  bool ok = exportAudioTap(tap, fileSink, &file);
+  size_t size = file.size();
+  file.close();
+  if (!ok) {
+    SPIFFS.remove(path);
+    Serial.printf("❌ Failed to write %s\n", path);
+    return false;
+  }
+  Serial.printf("💾 Saved %s (%u bytes)\n", path, size);
+  return true;
+}
+
+#endif // FEATURE_AUDIO_TAPS
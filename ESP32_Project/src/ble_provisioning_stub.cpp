@@ -1,9 +1,145 @@
 /**
- * BLE provisioning stubs for release builds
- * BLE functionality has been removed from production builds
+ * BLE provisioning for release builds
+ * The BLE stack (GATT server, advertising) has been removed from production
+ * builds. The provisioning protocol is kept: whatever GATT layer is linked in
+ * attaches with connectBLEProvisioning() and hands written frames to
+ * handleBLEProvisioningData(); messages travel over ble_transport.
  */
 
-// Stub for removed BLE provisioning
-extern "C" bool isBLEProvisioningActive() { 
-    return false; 
-}
\ No newline at end of file
+#include "ble_provisioning.h"
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+static bool provisioningActive = false;
+static bool linkAttached = false;
+static uint8_t popKey[BLE_TRANSPORT_KEY_SIZE];
+static ble_provisioning_callback_t provisioningCallback = nullptr;
+static unsigned long provisioningStartedAt = 0;
+static ble_transport_t provisioningLink;
+
+// Provisioning JSON -> provisioning_data_t; false on a missing or invalid field
+static bool parseProvisioningData(const uint8_t* data, size_t length, provisioning_data_t& out) {
+  StaticJsonDocument<512> doc;
+  DeserializationError err = deserializeJson(doc, (const char*)data, length);
+  if (err) {
+    Serial.printf("❌ BLE provisioning: JSON parse error: %s\n", err.c_str());
+    return false;
+  }
+
+  const char* ssid = doc["ssid"];
+  const char* password = doc["password"];
+  const char* childId = doc["child_id"];
+  const char* pairingCode = doc["pairing_code"] | "";
+  if (!IS_VALID_SSID(ssid) || !IS_VALID_WIFI_PASSWORD(password) || !IS_VALID_UUID(childId) ||
+      strlen(pairingCode) >= sizeof(out.pairing_code)) {
+    return false;
+  }
+
+  memset(&out, 0, sizeof(out));
+  strlcpy(out.ssid, ssid, sizeof(out.ssid));
+  strlcpy(out.password, password, sizeof(out.password));
+  strlcpy(out.child_id, childId, sizeof(out.child_id));
+  strlcpy(out.pairing_code, pairingCode, sizeof(out.pairing_code));
+  out.child_age = doc["child_age"] | -1;
+  return out.child_age >= -1 && out.child_age <= 18;
+}
+
+// An authenticated, in-order message from the app
+static void onProvisioningMessage(void*, const uint8_t* data, size_t length) {
+  provisioning_data_t received;
+  bool valid = parseProvisioningData(data, length, received);
+  sendBLEResponse(valid ? BLE_RESPONSE_OK : BLE_RESPONSE_INVALID_CREDS);
+
+  // The response is still in flight: the callback must leave stopping to the loop
+  if (provisioningCallback != nullptr) {
+    provisioningCallback(valid ? BLE_PROV_SUCCESS : BLE_PROV_INVALID_DATA, valid ? &received : nullptr);
+  }
+  memset(&received, 0, sizeof(received));
+}
+
+bool initBLEProvisioning(void) {
+  provisioningActive = false;
+  linkAttached = false;
+  return true;
+}
+
+bool startBLEProvisioning(const uint8_t* pop_key, size_t key_len, ble_provisioning_callback_t callback) {
+  if (provisioningActive || !setBLEPoP(pop_key, key_len)) {
+    return false;
+  }
+  provisioningCallback = callback;
+  provisioningStartedAt = millis();
+  provisioningActive = true;
+  Serial.println("📶 BLE provisioning started, waiting for a link");
+  return true;
+}
+
+bool setBLEPoP(const uint8_t* pop_key, size_t key_len) {
+  if (!IS_VALID_POP_KEY(pop_key, key_len)) {
+    return false;
+  }
+  memcpy(popKey, pop_key, BLE_TRANSPORT_KEY_SIZE);   // Used from the next connection
+  return true;
+}
+
+void connectBLEProvisioning(ble_transport_send_frame_t send_frame, void* context, uint16_t att_mtu) {
+  if (!provisioningActive) return;
+
+  ble_transport_config_t config = {};
+  config.role = BLE_TRANSPORT_ROLE_DEVICE;
+  memcpy(config.key, popKey, BLE_TRANSPORT_KEY_SIZE);
+  config.send_frame = send_frame;
+  config.on_message = onProvisioningMessage;
+  config.context = context;
+  linkAttached = ble_transport_init(&provisioningLink, &config);
+  memset(config.key, 0, sizeof(config.key));
+  if (linkAttached) {
+    ble_transport_connect(&provisioningLink, att_mtu);
+  }
+}
+
+void disconnectBLEProvisioning(void) {
+  if (!linkAttached) return;
+  ble_transport_reset(&provisioningLink);
+  linkAttached = false;
+}
+
+void handleBLEProvisioningData(uint8_t* data, size_t length) {
+  if (linkAttached) {
+    ble_transport_receive(&provisioningLink, data, length);
+  }
+}
+
+void sendBLEResponse(const char* response) {
+  if (!linkAttached || !ble_transport_send(&provisioningLink, (const uint8_t*)response, strlen(response))) {
+    Serial.println("⚠️ BLE provisioning: response not sent");
+  }
+}
+
+void handleBLEProvisioning(void) {
+  if (!provisioningActive) return;
+
+  if (millis() - provisioningStartedAt >= BLE_PROVISIONING_TIMEOUT_MS) {
+    Serial.println("⏰ BLE provisioning timed out");
+    ble_provisioning_callback_t callback = provisioningCallback;
+    stopBLEProvisioning();
+    if (callback != nullptr) callback(BLE_PROV_TIMEOUT, nullptr);
+    return;
+  }
+  if (linkAttached) {
+    ble_transport_tick(&provisioningLink);
+  }
+}
+
+void stopBLEProvisioning(void) {
+  disconnectBLEProvisioning();
+  ble_transport_pool_free();
+  memset(popKey, 0, sizeof(popKey));
+  memset(&provisioningLink, 0, sizeof(provisioningLink));   // Holds a copy of the key
+  provisioningCallback = nullptr;
+  provisioningActive = false;
+}
+
+extern "C" bool isBLEProvisioningActive() {
+  return provisioningActive;
+}
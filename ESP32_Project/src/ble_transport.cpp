@@ -0,0 +1,605 @@
+#include "ble_transport.h"
+#include "resource_manager.h"
+#include <Arduino.h>
+#include <esp_system.h>
+#include <mbedtls/gcm.h>
+
+#define FRAME_HELLO 0x01
+#define FRAME_DATA  0x02
+#define FRAME_ACK   0x03
+#define FRAME_NAK   0x04
+
+#define HELLO_SIZE  (6 + BLE_TRANSPORT_SESSION_SIZE)
+#define ACK_SIZE    8
+#define NAK_SIZE    3
+
+#define HELLO_FLAG_REPLY 0x01   // Sender has not seen our HELLO yet
+#define SEQ_LAST         0x8000 // Sequence flag on the final fragment
+
+#define MESSAGE_OVERHEAD (BLE_TRANSPORT_NONCE_SIZE + BLE_TRANSPORT_TAG_SIZE)
+#define AAD_SIZE         (3 + 2 * BLE_TRANSPORT_SESSION_SIZE + 4)
+
+static void put16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static uint16_t get16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+static uint32_t get32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool testBit(const uint32_t* bits, uint16_t i) {
+  return (bits[i / 32] >> (i % 32)) & 1;
+}
+
+static void setBit(uint32_t* bits, uint16_t i) {
+  bits[i / 32] |= 1UL << (i % 32);
+}
+
+// =============================================================================
+// MESSAGE POOL
+// =============================================================================
+
+struct PoolSlot {
+  uint8_t* data;   // Allocated on first use, kept until ble_transport_pool_free()
+  bool used;
+};
+
+static PoolSlot pool[BLE_TRANSPORT_POOL_BUFFERS];
+
+static uint8_t* acquireBuffer() {
+  for (PoolSlot& slot : pool) {
+    if (slot.used) continue;
+    if (slot.data == nullptr) {
+      slot.data = (uint8_t*)TRACK_MALLOC(BLE_TRANSPORT_MAX_MESSAGE, "ble_transport_message");
+      if (slot.data == nullptr) return nullptr;
+    }
+    slot.used = true;
+    return slot.data;
+  }
+  return nullptr;
+}
+
+static void releaseBuffer(uint8_t* data) {
+  for (PoolSlot& slot : pool) {
+    if (slot.data == data) slot.used = false;
+  }
+}
+
+void ble_transport_pool_free(void) {
+  for (PoolSlot& slot : pool) {
+    if (!slot.used && slot.data != nullptr) {
+      TRACK_FREE(slot.data, "ble_transport_message");
+      slot.data = nullptr;
+    }
+  }
+}
+
+// =============================================================================
+// MESSAGE SEALING
+// =============================================================================
+
+// Additional data: direction, sender and receiver session nonces, counter
+static void makeAad(uint8_t* aad, ble_transport_role_t sender, const uint8_t* senderSession,
+                    const uint8_t* receiverSession, uint32_t counter) {
+  aad[0] = 'T';
+  aad[1] = 'B';
+  aad[2] = (uint8_t)sender;
+  memcpy(aad + 3, senderSession, BLE_TRANSPORT_SESSION_SIZE);
+  memcpy(aad + 3 + BLE_TRANSPORT_SESSION_SIZE, receiverSession, BLE_TRANSPORT_SESSION_SIZE);
+  put32(aad + 3 + 2 * BLE_TRANSPORT_SESSION_SIZE, counter);
+}
+
+// out = nonce | tag | ciphertext, nonce = our session nonce | counter
+static bool sealMessage(const ble_transport_t* t, uint32_t counter, const uint8_t* data, size_t length,
+                        uint8_t* out) {
+  uint8_t aad[AAD_SIZE];
+  makeAad(aad, t->config.role, t->session, t->peer_session, counter);
+  memcpy(out, t->session, BLE_TRANSPORT_SESSION_SIZE);
+  put32(out + BLE_TRANSPORT_SESSION_SIZE, counter);
+
+  mbedtls_gcm_context gcm;
+  mbedtls_gcm_init(&gcm);
+  int ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, t->config.key, BLE_TRANSPORT_KEY_SIZE * 8);
+  if (ret == 0) {
+    ret = mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, length,
+                                    out, BLE_TRANSPORT_NONCE_SIZE, aad, sizeof(aad),
+                                    data, out + MESSAGE_OVERHEAD,
+                                    BLE_TRANSPORT_TAG_SIZE, out + BLE_TRANSPORT_NONCE_SIZE);
+  }
+  mbedtls_gcm_free(&gcm);
+  if (ret != 0) {
+    Serial.printf("❌ BLE transport: seal failed: -0x%04x\n", -ret);
+  }
+  return ret == 0;
+}
+
+// Decrypts in place; the plaintext starts at message + MESSAGE_OVERHEAD.
+// The counter comes from the nonce, which must carry the peer's session nonce
+// and agree with the frame's message id.
+static bool openMessage(const ble_transport_t* t, uint8_t id, uint8_t* message, size_t length,
+                        uint32_t& counter) {
+  counter = get32(message + BLE_TRANSPORT_SESSION_SIZE);
+  if (memcmp(message, t->peer_session, BLE_TRANSPORT_SESSION_SIZE) != 0 || (uint8_t)counter != id) {
+    return false;
+  }
+  ble_transport_role_t sender = t->config.role == BLE_TRANSPORT_ROLE_DEVICE ? BLE_TRANSPORT_ROLE_APP
+                                                                            : BLE_TRANSPORT_ROLE_DEVICE;
+  uint8_t aad[AAD_SIZE];
+  makeAad(aad, sender, t->peer_session, t->session, counter);
+
+  mbedtls_gcm_context gcm;
+  mbedtls_gcm_init(&gcm);
+  int ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, t->config.key, BLE_TRANSPORT_KEY_SIZE * 8);
+  if (ret == 0) {
+    ret = mbedtls_gcm_auth_decrypt(&gcm, length - MESSAGE_OVERHEAD,
+                                   message, BLE_TRANSPORT_NONCE_SIZE, aad, sizeof(aad),
+                                   message + BLE_TRANSPORT_NONCE_SIZE, BLE_TRANSPORT_TAG_SIZE,
+                                   message + MESSAGE_OVERHEAD, message + MESSAGE_OVERHEAD);
+  }
+  mbedtls_gcm_free(&gcm);
+  return ret == 0;
+}
+
+// =============================================================================
+// FRAMES
+// =============================================================================
+
+static bool sendFrame(ble_transport_t* t, size_t length) {
+  if (!t->config.send_frame(t->config.context, t->frame, length)) {
+    return false;
+  }
+  t->stats.frames_sent++;
+  return true;
+}
+
+static void sendHello(ble_transport_t* t) {
+  t->frame[0] = FRAME_HELLO;
+  t->frame[1] = BLE_TRANSPORT_VERSION;
+  put16(t->frame + 2, t->local_mtu);
+  t->frame[4] = BLE_TRANSPORT_WINDOW;
+  t->frame[5] = t->hello_pending ? HELLO_FLAG_REPLY : 0;
+  memcpy(t->frame + 6, t->session, BLE_TRANSPORT_SESSION_SIZE);
+  sendFrame(t, HELLO_SIZE);
+  t->hello_sent_at = millis();
+}
+
+static void sendNak(ble_transport_t* t, uint8_t message, uint8_t reason) {
+  t->frame[0] = FRAME_NAK;
+  t->frame[1] = message;
+  t->frame[2] = reason;
+  sendFrame(t, NAK_SIZE);
+}
+
+// Cumulative next plus which of the 32 fragments after it already arrived
+static void sendAck(ble_transport_t* t, uint8_t message, uint16_t next, const uint32_t* have, uint16_t count) {
+  uint32_t bitmap = 0;
+  for (uint16_t i = 0; i < 32 && next + 1 + i < count; i++) {
+    if (testBit(have, next + 1 + i)) bitmap |= 1UL << i;
+  }
+  t->frame[0] = FRAME_ACK;
+  t->frame[1] = message;
+  put16(t->frame + 2, next);
+  put32(t->frame + 4, bitmap);
+  if (sendFrame(t, ACK_SIZE)) {
+    t->stats.acks_sent++;
+    t->rx_since_ack = 0;
+    t->rx_ack_due = false;
+  } else {
+    t->rx_ack_due = true;   // Stack queue full: retry from tick
+    t->rx_ack_at = millis();
+  }
+}
+
+static void sendReceiveAck(ble_transport_t* t) {
+  sendAck(t, t->rx_message, t->rx_next, t->rx_have, t->rx_count);
+}
+
+// Repeats the final ACK of an accepted message, in case it was lost
+static void sendDoneAck(ble_transport_t* t) {
+  sendAck(t, t->rx_done_message, t->rx_done_count, t->rx_have, 0);
+}
+
+// =============================================================================
+// RECEIVE
+// =============================================================================
+
+static void dropReceive(ble_transport_t* t) {
+  if (t->rx_buffer != nullptr) {
+    releaseBuffer(t->rx_buffer);
+    t->rx_buffer = nullptr;
+  }
+  t->rx_ack_due = false;
+}
+
+// Only accepted messages are remembered: a refused one (forged, replayed,
+// from another session) must not claim its id, or the genuine message that
+// next uses it would be answered with the refusal
+static void refuseReceive(ble_transport_t* t, uint8_t nak) {
+  sendNak(t, t->rx_message, nak);
+  dropReceive(t);
+}
+
+static void completeMessage(ble_transport_t* t) {
+  uint32_t counter;
+  if (!openMessage(t, t->rx_message, t->rx_buffer, t->rx_length, counter)) {
+    Serial.printf("❌ BLE transport: message %u failed authentication\n", t->rx_message);
+    t->stats.auth_failures++;
+    refuseReceive(t, BLE_TRANSPORT_NAK_AUTH_FAILED);
+    return;
+  }
+  if (counter <= t->rx_accepted) {
+    Serial.printf("❌ BLE transport: message %u replayed (last accepted %u)\n",
+                  (unsigned)counter, (unsigned)t->rx_accepted);
+    t->stats.replays++;
+    refuseReceive(t, BLE_TRANSPORT_NAK_REPLAY);
+    return;
+  }
+  t->rx_accepted = counter;
+  t->stats.messages_received++;
+  t->rx_done_valid = true;
+  t->rx_done_message = t->rx_message;
+  t->rx_done_count = t->rx_count;
+  sendDoneAck(t);
+  // The buffer is held through the callback; a reply takes the other one
+  t->config.on_message(t->config.context, t->rx_buffer + MESSAGE_OVERHEAD, t->rx_length - MESSAGE_OVERHEAD);
+  dropReceive(t);
+}
+
+// Fragment size from whichever frame arrives first: all but the last
+// fragment are full, the last holds the remainder. 0 for an impossible frame.
+static uint16_t fragmentSizeOf(uint16_t seq, bool last, uint16_t length, size_t n) {
+  if (!last) {
+    return (size_t)(seq + 1) * n < length ? n : 0;
+  }
+  if (seq == 0) {
+    return n == length ? n : 0;
+  }
+  size_t before = length - n;
+  if (n > length || before % seq != 0 || before / seq < n) {
+    return 0;
+  }
+  return before / seq;
+}
+
+static bool startReceive(ble_transport_t* t, uint8_t message, uint16_t seq, bool last, uint16_t length,
+                         size_t n) {
+  if (length <= MESSAGE_OVERHEAD || length > BLE_TRANSPORT_MAX_MESSAGE) {
+    sendNak(t, message, BLE_TRANSPORT_NAK_TOO_LARGE);
+    return false;
+  }
+  uint16_t fragment = fragmentSizeOf(seq, last, length, n);
+  uint16_t count = fragment > 0 ? (length + fragment - 1) / fragment : 0;
+  if (count == 0 || count > BLE_TRANSPORT_MAX_FRAGMENTS) {
+    t->stats.invalid_frames++;
+    return false;
+  }
+
+  dropReceive(t);   // A new message id: the sender gave up on the old one
+  t->rx_buffer = acquireBuffer();
+  if (t->rx_buffer == nullptr) {
+    Serial.println("⚠️ BLE transport: no message buffer free");
+    sendNak(t, message, BLE_TRANSPORT_NAK_NO_BUFFER);
+    return false;
+  }
+  t->rx_message = message;
+  t->rx_length = length;
+  t->rx_fragment = fragment;
+  t->rx_count = count;
+  t->rx_next = 0;
+  memset(t->rx_have, 0, sizeof(t->rx_have));
+  t->rx_since_ack = 0;
+  t->rx_gap_reported = false;
+  t->rx_ack_due = false;
+  return true;
+}
+
+static void handleData(ble_transport_t* t, const uint8_t* frame, size_t length) {
+  uint8_t message = frame[1];
+  uint16_t seq = get16(frame + 2) & ~SEQ_LAST;
+  bool last = get16(frame + 2) & SEQ_LAST;
+  uint16_t messageLength = get16(frame + 4);
+  const uint8_t* payload = frame + BLE_TRANSPORT_DATA_HEADER;
+  size_t n = length - BLE_TRANSPORT_DATA_HEADER;
+
+  bool receiving = t->rx_buffer != nullptr && t->rx_message == message;
+  if (!receiving && t->rx_done_valid && t->rx_done_message == message) {
+    sendDoneAck(t);
+    return;
+  }
+  if (!receiving && !startReceive(t, message, seq, last, messageLength, n)) {
+    return;
+  }
+
+  uint16_t expected = seq + 1 == t->rx_count ? t->rx_length - seq * t->rx_fragment : t->rx_fragment;
+  if (messageLength != t->rx_length || seq >= t->rx_count || last != (seq + 1 == t->rx_count) ||
+      n != expected) {
+    t->stats.invalid_frames++;
+    return;
+  }
+  if (testBit(t->rx_have, seq)) {
+    sendReceiveAck(t);   // Repeat: our ACK was probably lost
+    return;
+  }
+
+  memcpy(t->rx_buffer + (size_t)seq * t->rx_fragment, payload, n);
+  setBit(t->rx_have, seq);
+  uint16_t previous = t->rx_next;
+  while (t->rx_next < t->rx_count && testBit(t->rx_have, t->rx_next)) {
+    t->rx_next++;
+  }
+
+  if (t->rx_next == t->rx_count) {
+    completeMessage(t);
+  } else if (t->rx_next == previous) {
+    // Beyond a gap: report it once so the sender resends at once
+    if (!t->rx_gap_reported) {
+      t->rx_gap_reported = true;
+      sendReceiveAck(t);
+    }
+  } else if (seq != previous) {
+    t->rx_gap_reported = false;   // A resend filled a gap
+    sendReceiveAck(t);
+  } else if (++t->rx_since_ack >= BLE_TRANSPORT_ACK_EVERY) {
+    sendReceiveAck(t);
+  } else if (!t->rx_ack_due) {
+    t->rx_ack_due = true;
+    t->rx_ack_at = millis() + BLE_TRANSPORT_ACK_DELAY_MS;
+  }
+}
+
+// =============================================================================
+// SEND
+// =============================================================================
+
+static bool sendFragment(ble_transport_t* t, uint16_t seq) {
+  size_t offset = (size_t)seq * t->tx_fragment;
+  size_t n = min((size_t)t->tx_fragment, (size_t)t->tx_length - offset);
+  t->frame[0] = FRAME_DATA;
+  t->frame[1] = t->tx_message;
+  put16(t->frame + 2, seq + 1 == t->tx_count ? seq | SEQ_LAST : seq);
+  put16(t->frame + 4, t->tx_length);
+  memcpy(t->frame + BLE_TRANSPORT_DATA_HEADER, t->tx_buffer + offset, n);
+  if (!sendFrame(t, BLE_TRANSPORT_DATA_HEADER + n)) {
+    return false;
+  }
+  uint8_t slot = seq % BLE_TRANSPORT_SEND_SLOTS;
+  t->tx_sent_at[slot] = millis();
+  t->tx_stamp[slot] = ++t->tx_sends;
+  return true;
+}
+
+static void finishSend(ble_transport_t* t, bool delivered) {
+  releaseBuffer(t->tx_buffer);
+  t->tx_buffer = nullptr;
+  t->tx_active = false;
+  t->tx_counter++;
+  t->tx_message = (uint8_t)t->tx_counter;
+  if (delivered) {
+    t->stats.messages_sent++;
+  } else {
+    t->stats.send_failures++;
+  }
+  if (t->config.on_sent != nullptr) {
+    t->config.on_sent(t->config.context, delivered);
+  }
+}
+
+// Sends new fragments while the window allows and the stack accepts them
+static void pumpSend(ble_transport_t* t) {
+  while (t->tx_active && t->tx_next < t->tx_count && t->tx_next < t->tx_base + t->tx_window) {
+    if (!sendFragment(t, t->tx_next)) return;
+    t->tx_next++;
+  }
+}
+
+static void handleAck(ble_transport_t* t, uint8_t message, uint16_t next, uint32_t bitmap) {
+  if (!t->tx_active || message != t->tx_message || next > t->tx_next || next < t->tx_base) {
+    return;
+  }
+
+  for (uint16_t seq = t->tx_base; seq < next; seq++) {
+    setBit(t->tx_acked, seq);
+  }
+  int32_t highest = (int32_t)next - 1;
+  for (uint8_t i = 0; i < 32; i++) {
+    uint32_t seq = next + 1 + i;
+    if ((bitmap >> i) & 1 && seq < t->tx_next) {
+      setBit(t->tx_acked, seq);
+      highest = seq;
+    }
+  }
+  if (next > t->tx_base) {
+    t->tx_retries = 0;
+  }
+  t->tx_base = next;
+  if (t->tx_base == t->tx_count) {
+    finishSend(t, true);
+    return;
+  }
+
+  // In-order link: anything sent before the highest acknowledged fragment
+  // and still missing was dropped
+  if (highest >= (int32_t)t->tx_base) {
+    uint32_t stamp = t->tx_stamp[highest % BLE_TRANSPORT_SEND_SLOTS];
+    for (uint16_t seq = t->tx_base; seq < highest; seq++) {
+      if (testBit(t->tx_acked, seq) || t->tx_stamp[seq % BLE_TRANSPORT_SEND_SLOTS] > stamp) continue;
+      if (!sendFragment(t, seq)) break;
+      t->stats.retransmits++;
+    }
+  }
+  pumpSend(t);
+}
+
+static void handleNak(ble_transport_t* t, uint8_t message, uint8_t reason) {
+  if (!t->tx_active || message != t->tx_message) {
+    return;
+  }
+  Serial.printf("❌ BLE transport: peer refused message %u (reason %u)\n", message, reason);
+  finishSend(t, false);
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+bool ble_transport_init(ble_transport_t* transport, const ble_transport_config_t* config) {
+  if (transport == nullptr || config == nullptr || config->send_frame == nullptr ||
+      config->on_message == nullptr) {
+    return false;
+  }
+  memset(transport, 0, sizeof(*transport));
+  transport->config = *config;
+  transport->local_mtu = BLE_TRANSPORT_DEFAULT_MTU;
+  transport->peer_mtu = BLE_TRANSPORT_DEFAULT_MTU;
+  transport->peer_window = BLE_TRANSPORT_DEFAULT_WINDOW;
+  // Not connected: nothing can be sealed and no HELLO is retried until connect
+  transport->hello_pending = true;
+  transport->hello_retries = BLE_TRANSPORT_MAX_RETRIES;
+  return true;
+}
+
+void ble_transport_connect(ble_transport_t* transport, uint16_t att_mtu) {
+  ble_transport_reset(transport);
+  transport->local_mtu = constrain(att_mtu, BLE_TRANSPORT_DEFAULT_MTU, BLE_TRANSPORT_MAX_MTU);
+  transport->peer_mtu = BLE_TRANSPORT_DEFAULT_MTU;
+  transport->peer_window = BLE_TRANSPORT_DEFAULT_WINDOW;
+  transport->hello_pending = true;
+  transport->hello_retries = 0;
+  esp_fill_random(transport->session, BLE_TRANSPORT_SESSION_SIZE);
+  memset(transport->peer_session, 0, BLE_TRANSPORT_SESSION_SIZE);
+  transport->rx_accepted = 0;
+  transport->tx_counter = 1;
+  transport->tx_message = 1;
+  sendHello(transport);
+}
+
+void ble_transport_receive(ble_transport_t* t, const uint8_t* frame, size_t length) {
+  if (frame == nullptr || length == 0) return;
+  t->stats.frames_received++;
+
+  switch (frame[0]) {
+    case FRAME_HELLO:
+      if (length < HELLO_SIZE || frame[1] != BLE_TRANSPORT_VERSION) break;
+      if (memcmp(frame + 6, t->peer_session, BLE_TRANSPORT_SESSION_SIZE) != 0) {
+        // The peer (re)connected: its counter restarts, and anything sealed
+        // to its previous session nonce can no longer be opened
+        ble_transport_reset(t);
+        memcpy(t->peer_session, frame + 6, BLE_TRANSPORT_SESSION_SIZE);
+        t->rx_accepted = 0;
+      }
+      t->peer_mtu = constrain(get16(frame + 2), BLE_TRANSPORT_DEFAULT_MTU, BLE_TRANSPORT_MAX_MTU);
+      t->peer_window = constrain(frame[4], 1, BLE_TRANSPORT_MAX_WINDOW);
+      t->hello_pending = false;
+      if (frame[5] & HELLO_FLAG_REPLY) {
+        sendHello(t);
+      }
+      return;
+    case FRAME_DATA:
+      if (length <= BLE_TRANSPORT_DATA_HEADER) break;
+      // The peer's HELLO was lost: its session nonce is needed to open the
+      // message, so let the fragments be resent after our HELLO retry
+      if (t->hello_pending) return;
+      handleData(t, frame, length);
+      return;
+    case FRAME_ACK:
+      if (length < ACK_SIZE) break;
+      handleAck(t, frame[1], get16(frame + 2), get32(frame + 4));
+      return;
+    case FRAME_NAK:
+      if (length < NAK_SIZE) break;
+      handleNak(t, frame[1], frame[2]);
+      return;
+  }
+  t->stats.invalid_frames++;
+}
+
+bool ble_transport_send(ble_transport_t* t, const uint8_t* data, size_t length) {
+  if (t->hello_pending || t->tx_active || length == 0 || length > BLE_TRANSPORT_MAX_PLAINTEXT) {
+    return false;
+  }
+  t->tx_buffer = acquireBuffer();
+  if (t->tx_buffer == nullptr) {
+    Serial.println("⚠️ BLE transport: no message buffer free");
+    return false;
+  }
+  if (!sealMessage(t, t->tx_counter, data, length, t->tx_buffer)) {
+    releaseBuffer(t->tx_buffer);
+    t->tx_buffer = nullptr;
+    return false;
+  }
+
+  // Fragment size and window are fixed for the message; a HELLO repeated midway
+  // does not change them
+  uint16_t mtu = min(t->local_mtu, t->peer_mtu);
+  t->tx_active = true;
+  t->tx_length = length + MESSAGE_OVERHEAD;
+  t->tx_fragment = mtu - BLE_TRANSPORT_ATT_OVERHEAD - BLE_TRANSPORT_DATA_HEADER;
+  t->tx_count = (t->tx_length + t->tx_fragment - 1) / t->tx_fragment;
+  t->tx_window = min((uint8_t)BLE_TRANSPORT_WINDOW, t->peer_window);
+  t->tx_base = 0;
+  t->tx_next = 0;
+  t->tx_retries = 0;
+  memset(t->tx_acked, 0, sizeof(t->tx_acked));
+  pumpSend(t);
+  return true;
+}
+
+void ble_transport_tick(ble_transport_t* t) {
+  uint32_t now = millis();
+
+  if (t->rx_ack_due && (int32_t)(now - t->rx_ack_at) >= 0 && t->rx_buffer != nullptr) {
+    sendReceiveAck(t);
+  }
+
+  if (t->hello_pending && now - t->hello_sent_at >= BLE_TRANSPORT_RTO_MS &&
+      t->hello_retries < BLE_TRANSPORT_MAX_RETRIES) {
+    t->hello_retries++;
+    sendHello(t);
+  }
+
+  if (!t->tx_active) return;
+  pumpSend(t);
+
+  // Oldest fragment in flight without an ACK: its ACK, or it, was lost
+  for (uint16_t seq = t->tx_base; seq < t->tx_next; seq++) {
+    if (testBit(t->tx_acked, seq)) continue;
+    if (now - t->tx_sent_at[seq % BLE_TRANSPORT_SEND_SLOTS] < BLE_TRANSPORT_RTO_MS) break;
+    if (t->tx_retries >= BLE_TRANSPORT_MAX_RETRIES) {
+      Serial.printf("❌ BLE transport: message %u timed out at fragment %u of %u\n",
+                    t->tx_message, seq, t->tx_count);
+      finishSend(t, false);
+      return;
+    }
+    // Only a resend the stack accepted counts against the retries
+    if (sendFragment(t, seq)) {
+      t->tx_retries++;
+      t->stats.retransmits++;
+    }
+    break;
+  }
+}
+
+bool ble_transport_ready(const ble_transport_t* transport) {
+  return !transport->hello_pending;
+}
+
+bool ble_transport_busy(const ble_transport_t* transport) {
+  return transport->tx_active;
+}
+
+void ble_transport_reset(ble_transport_t* t) {
+  dropReceive(t);
+  t->rx_done_valid = false;
+  if (t->tx_active) {
+    finishSend(t, false);
+  }
+}
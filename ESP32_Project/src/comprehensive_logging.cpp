@@ -4,131 +4,131 @@
 // 🔄 FLOW STATE TRACKING VARIABLES
 // ========================================
 
-String currentAudioFlowState = AUDIO_FLOW_IDLE;
-String currentWebSocketFlowState = WS_FLOW_DISCONNECTED;
-String currentAuthFlowState = AUTH_FLOW_NONE;
-String currentSystemState = "INITIALIZING";
+FlowStateName currentAudioFlowState(AUDIO_FLOW_IDLE);
+FlowStateName currentWebSocketFlowState(WS_FLOW_DISCONNECTED);
+FlowStateName currentAuthFlowState(AUTH_FLOW_NONE);
+FlowStateName currentSystemState("INITIALIZING");
 
 // ========================================
 // 🎯 MAIN EVENT LOGGING FUNCTIONS
 // ========================================
 
-void logAudioEvent(const String& event, const String& details) {
-    String timestamp = String(millis());
-    Serial.printf("%s %s Audio Event: %s", LOG_AUDIO, timestamp.c_str(), event.c_str());
+void logAudioEvent(StringView event, StringView details) {
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu Audio Event: %.*s", LOG_AUDIO, timestamp, (int)event.length(), event.data());
     if (details.length() > 0) {
-        Serial.printf(" - %s", details.c_str());
+        Serial.printf(" - %.*s", (int)details.length(), details.data());
     }
     Serial.println();
 }
 
-void logAudioFlowState(const String& state, const String& info) {
+void logAudioFlowState(StringView state, StringView info) {
     currentAudioFlowState = state;
-    String timestamp = String(millis());
-    Serial.printf("%s %s Audio Flow: %s", LOG_AUDIO, timestamp.c_str(), state.c_str());
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu Audio Flow: %.*s", LOG_AUDIO, timestamp, (int)state.length(), state.data());
     if (info.length() > 0) {
-        Serial.printf(" - %s", info.c_str());
+        Serial.printf(" - %.*s", (int)info.length(), info.data());
     }
     Serial.println();
 }
 
-void logAudioData(const String& operation, size_t bytes, const String& format) {
-    String timestamp = String(millis());
-    Serial.printf("%s %s Audio Data: %s %d bytes", LOG_AUDIO, timestamp.c_str(), operation.c_str(), bytes);
+void logAudioData(StringView operation, size_t bytes, StringView format) {
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu Audio Data: %.*s %d bytes", LOG_AUDIO, timestamp, (int)operation.length(), operation.data(), bytes);
     if (format.length() > 0) {
-        Serial.printf(" (%s)", format.c_str());
+        Serial.printf(" (%.*s)", (int)format.length(), format.data());
     }
     Serial.println();
 }
 
-void logWebSocketEvent(const String& event, const String& details) {
-    String timestamp = String(millis());
-    Serial.printf("%s %s WebSocket Event: %s", LOG_WS, timestamp.c_str(), event.c_str());
+void logWebSocketEvent(StringView event, StringView details) {
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu WebSocket Event: %.*s", LOG_WS, timestamp, (int)event.length(), event.data());
     if (details.length() > 0) {
-        Serial.printf(" - %s", details.c_str());
+        Serial.printf(" - %.*s", (int)details.length(), details.data());
     }
     Serial.println();
 }
 
-void logWebSocketFlowState(const String& state, const String& info) {
+void logWebSocketFlowState(StringView state, StringView info) {
     currentWebSocketFlowState = state;
-    String timestamp = String(millis());
-    Serial.printf("%s %s WebSocket Flow: %s", LOG_WS, timestamp.c_str(), state.c_str());
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu WebSocket Flow: %.*s", LOG_WS, timestamp, (int)state.length(), state.data());
     if (info.length() > 0) {
-        Serial.printf(" - %s", info.c_str());
+        Serial.printf(" - %.*s", (int)info.length(), info.data());
     }
     Serial.println();
 }
 
-void logWebSocketMessage(const String& direction, const String& type, size_t size) {
-    String timestamp = String(millis());
-    Serial.printf("%s %s WebSocket Message: %s %s", LOG_WS, timestamp.c_str(), direction.c_str(), type.c_str());
+void logWebSocketMessage(StringView direction, StringView type, size_t size) {
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu WebSocket Message: %.*s %.*s", LOG_WS, timestamp, (int)direction.length(), direction.data(), (int)type.length(), type.data());
     if (size > 0) {
         Serial.printf(" (%d bytes)", size);
     }
     Serial.println();
 }
 
-void logAuthEvent(const String& event, const String& details) {
-    String timestamp = String(millis());
-    Serial.printf("%s %s Auth Event: %s", LOG_AUTH, timestamp.c_str(), event.c_str());
+void logAuthEvent(StringView event, StringView details) {
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu Auth Event: %.*s", LOG_AUTH, timestamp, (int)event.length(), event.data());
     if (details.length() > 0) {
-        Serial.printf(" - %s", details.c_str());
+        Serial.printf(" - %.*s", (int)details.length(), details.data());
     }
     Serial.println();
 }
 
-void logAuthFlowState(const String& state, const String& info) {
+void logAuthFlowState(StringView state, StringView info) {
     currentAuthFlowState = state;
-    String timestamp = String(millis());
-    Serial.printf("%s %s Auth Flow: %s", LOG_AUTH, timestamp.c_str(), state.c_str());
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu Auth Flow: %.*s", LOG_AUTH, timestamp, (int)state.length(), state.data());
     if (info.length() > 0) {
-        Serial.printf(" - %s", info.c_str());
+        Serial.printf(" - %.*s", (int)info.length(), info.data());
     }
     Serial.println();
 }
 
-void logAuthToken(const String& operation, const String& status) {
-    String timestamp = String(millis());
-    Serial.printf("%s %s Token %s: %s", LOG_AUTH, timestamp.c_str(), operation.c_str(), status.c_str());
+void logAuthToken(StringView operation, StringView status) {
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu Token %.*s: %.*s", LOG_AUTH, timestamp, (int)operation.length(), operation.data(), (int)status.length(), status.data());
     Serial.println();
 }
 
-void logSystemEvent(const String& event, const String& details) {
-    String timestamp = String(millis());
-    Serial.printf("%s %s System Event: %s", LOG_SYSTEM, timestamp.c_str(), event.c_str());
+void logSystemEvent(StringView event, StringView details) {
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu System Event: %.*s", LOG_SYSTEM, timestamp, (int)event.length(), event.data());
     if (details.length() > 0) {
-        Serial.printf(" - %s", details.c_str());
+        Serial.printf(" - %.*s", (int)details.length(), details.data());
     }
     Serial.println();
 }
 
-void logButtonEvent(const String& action, const String& result) {
-    String timestamp = String(millis());
-    Serial.printf("%s %s Button %s: %s", LOG_BUTTON, timestamp.c_str(), action.c_str(), result.c_str());
+void logButtonEvent(StringView action, StringView result) {
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu Button %.*s: %.*s", LOG_BUTTON, timestamp, (int)action.length(), action.data(), (int)result.length(), result.data());
     Serial.println();
 }
 
-void logSensorEvent(const String& sensor, const String& value) {
-    String timestamp = String(millis());
-    Serial.printf("%s %s Sensor %s: %s", LOG_SENSOR, timestamp.c_str(), sensor.c_str(), value.c_str());
+void logSensorEvent(StringView sensor, StringView value) {
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu Sensor %.*s: %.*s", LOG_SENSOR, timestamp, (int)sensor.length(), sensor.data(), (int)value.length(), value.data());
     Serial.println();
 }
 
-void logError(const String& component, const String& error, const String& details) {
-    String timestamp = String(millis());
-    Serial.printf("%s %s ERROR in %s: %s", LOG_ERROR, timestamp.c_str(), component.c_str(), error.c_str());
+void logError(StringView component, StringView error, StringView details) {
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu ERROR in %.*s: %.*s", LOG_ERROR, timestamp, (int)component.length(), component.data(), (int)error.length(), error.data());
     if (details.length() > 0) {
-        Serial.printf(" - %s", details.c_str());
+        Serial.printf(" - %.*s", (int)details.length(), details.data());
     }
     Serial.println();
 }
 
-void logSuccess(const String& component, const String& success, const String& details) {
-    String timestamp = String(millis());
-    Serial.printf("%s %s SUCCESS in %s: %s", LOG_SUCCESS, timestamp.c_str(), component.c_str(), success.c_str());
+void logSuccess(StringView component, StringView success, StringView details) {
+    unsigned long timestamp = millis();
+    Serial.printf("%s %lu SUCCESS in %.*s: %.*s", LOG_SUCCESS, timestamp, (int)component.length(), component.data(), (int)success.length(), success.data());
     if (details.length() > 0) {
-        Serial.printf(" - %s", details.c_str());
+        Serial.printf(" - %.*s", (int)details.length(), details.data());
     }
     Serial.println();
 }
@@ -137,29 +137,29 @@ void logSuccess(const String& component, const String& success, const String& de
 // 🔄 COMPLETE FLOW TRACKING
 // ========================================
 
-void logCompleteAudioFlow(const String& phase, const String& status, const String& details) {
-    String timestamp = String(millis());
-    Serial.printf("🎵 %s AUDIO FLOW - Phase: %s | Status: %s", timestamp.c_str(), phase.c_str(), status.c_str());
+void logCompleteAudioFlow(StringView phase, StringView status, StringView details) {
+    unsigned long timestamp = millis();
+    Serial.printf("🎵 %lu AUDIO FLOW - Phase: %.*s | Status: %.*s", timestamp, (int)phase.length(), phase.data(), (int)status.length(), status.data());
     if (details.length() > 0) {
-        Serial.printf(" | Details: %s", details.c_str());
+        Serial.printf(" | Details: %.*s", (int)details.length(), details.data());
     }
     Serial.println();
 }
 
-void logCompleteAuthFlow(const String& phase, const String& status, const String& details) {
-    String timestamp = String(millis());
-    Serial.printf("🔐 %s AUTH FLOW - Phase: %s | Status: %s", timestamp.c_str(), phase.c_str(), status.c_str());
+void logCompleteAuthFlow(StringView phase, StringView status, StringView details) {
+    unsigned long timestamp = millis();
+    Serial.printf("🔐 %lu AUTH FLOW - Phase: %.*s | Status: %.*s", timestamp, (int)phase.length(), phase.data(), (int)status.length(), status.data());
     if (details.length() > 0) {
-        Serial.printf(" | Details: %s", details.c_str());
+        Serial.printf(" | Details: %.*s", (int)details.length(), details.data());
     }
     Serial.println();
 }
 
-void logCompleteWebSocketFlow(const String& phase, const String& status, const String& details) {
-    String timestamp = String(millis());
-    Serial.printf("🌐 %s WEBSOCKET FLOW - Phase: %s | Status: %s", timestamp.c_str(), phase.c_str(), status.c_str());
+void logCompleteWebSocketFlow(StringView phase, StringView status, StringView details) {
+    unsigned long timestamp = millis();
+    Serial.printf("🌐 %lu WEBSOCKET FLOW - Phase: %.*s | Status: %.*s", timestamp, (int)phase.length(), phase.data(), (int)status.length(), status.data());
     if (details.length() > 0) {
-        Serial.printf(" | Details: %s", details.c_str());
+        Serial.printf(" | Details: %.*s", (int)details.length(), details.data());
     }
     Serial.println();
 }
@@ -169,30 +169,30 @@ void logCompleteWebSocketFlow(const String& phase, const String& status, const S
 // ========================================
 
 void logAudioStats(size_t bytesRecorded, size_t bytesSent, size_t bytesReceived, size_t bytesPlayed) {
-    String timestamp = String(millis());
-    Serial.printf("📊 %s AUDIO STATS - Recorded: %d bytes | Sent: %d bytes | Received: %d bytes | Played: %d bytes", 
-                  timestamp.c_str(), bytesRecorded, bytesSent, bytesReceived, bytesPlayed);
+    unsigned long timestamp = millis();
+    Serial.printf("📊 %lu AUDIO STATS - Recorded: %d bytes | Sent: %d bytes | Received: %d bytes | Played: %d bytes", 
+                  timestamp, bytesRecorded, bytesSent, bytesReceived, bytesPlayed);
     Serial.println();
 }
 
 void logAudioQuality(float rmsLevel, int16_t peakLevel, bool voiceDetected) {
-    String timestamp = String(millis());
-    Serial.printf("🎯 %s AUDIO QUALITY - RMS: %.2f dBFS | Peak: %d | Voice: %s", 
-                  timestamp.c_str(), rmsLevel, peakLevel, voiceDetected ? "YES" : "NO");
+    unsigned long timestamp = millis();
+    Serial.printf("🎯 %lu AUDIO QUALITY - RMS: %.2f dBFS | Peak: %d | Voice: %s", 
+                  timestamp, rmsLevel, peakLevel, voiceDetected ? "YES" : "NO");
     Serial.println();
 }
 
-void logNetworkStats(const String& operation, unsigned long duration, size_t bytes, bool success) {
-    String timestamp = String(millis());
-    Serial.printf("🌐 %s NETWORK - %s | Duration: %lu ms | Bytes: %d | Success: %s", 
-                  timestamp.c_str(), operation.c_str(), duration, bytes, success ? "YES" : "NO");
+void logNetworkStats(StringView operation, unsigned long duration, size_t bytes, bool success) {
+    unsigned long timestamp = millis();
+    Serial.printf("🌐 %lu NETWORK - %.*s | Duration: %lu ms | Bytes: %d | Success: %s", 
+                  timestamp, (int)operation.length(), operation.data(), duration, bytes, success ? "YES" : "NO");
     Serial.println();
 }
 
 void logSystemStats(unsigned long uptime, size_t freeHeap, float cpuUsage) {
-    String timestamp = String(millis());
-    Serial.printf("💻 %s SYSTEM - Uptime: %lu s | Free Heap: %d bytes | CPU: %.1f%%", 
-                  timestamp.c_str(), uptime, freeHeap, cpuUsage);
+    unsigned long timestamp = millis();
+    Serial.printf("💻 %lu SYSTEM - Uptime: %lu s | Free Heap: %d bytes | CPU: %.1f%%", 
+                  timestamp, uptime, freeHeap, cpuUsage);
     Serial.println();
 }
 
@@ -200,24 +200,24 @@ void logSystemStats(unsigned long uptime, size_t freeHeap, float cpuUsage) {
 // 🎭 USER INTERACTION LOGGING
 // ========================================
 
-void logButtonInteraction(const String& action, const String& context, const String& result) {
-    String timestamp = String(millis());
-    Serial.printf("🔘 %s BUTTON - Action: %s | Context: %s | Result: %s", 
-                  timestamp.c_str(), action.c_str(), context.c_str(), result.c_str());
+void logButtonInteraction(StringView action, StringView context, StringView result) {
+    unsigned long timestamp = millis();
+    Serial.printf("🔘 %lu BUTTON - Action: %.*s | Context: %.*s | Result: %.*s", 
+                  timestamp, (int)action.length(), action.data(), (int)context.length(), context.data(), (int)result.length(), result.data());
     Serial.println();
 }
 
-void logLEDAnimation(const String& animation, const String& color, int duration) {
-    String timestamp = String(millis());
-    Serial.printf("💡 %s LED - Animation: %s | Color: %s | Duration: %d ms", 
-                  timestamp.c_str(), animation.c_str(), color.c_str(), duration);
+void logLEDAnimation(StringView animation, StringView color, int duration) {
+    unsigned long timestamp = millis();
+    Serial.printf("💡 %lu LED - Animation: %.*s | Color: %.*s | Duration: %d ms", 
+                  timestamp, (int)animation.length(), animation.data(), (int)color.length(), color.data(), duration);
     Serial.println();
 }
 
-void logAudioPlayback(const String& audioType, int volume, int duration, bool success) {
-    String timestamp = String(millis());
-    Serial.printf("🔊 %s PLAYBACK - Type: %s | Volume: %d%% | Duration: %d ms | Success: %s", 
-                  timestamp.c_str(), audioType.c_str(), volume, duration, success ? "YES" : "NO");
+void logAudioPlayback(StringView audioType, int volume, int duration, bool success) {
+    unsigned long timestamp = millis();
+    Serial.printf("🔊 %lu PLAYBACK - Type: %.*s | Volume: %d%% | Duration: %d ms | Success: %s", 
+                  timestamp, (int)audioType.length(), audioType.data(), volume, duration, success ? "YES" : "NO");
     Serial.println();
 }
 
@@ -225,28 +225,28 @@ void logAudioPlayback(const String& audioType, int volume, int duration, bool su
 // 🔧 DEBUGGING HELPERS
 // ========================================
 
-void logJSONParse(const String& operation, bool success, const String& error) {
-    String timestamp = String(millis());
-    Serial.printf("📝 %s JSON - Operation: %s | Success: %s", 
-                  timestamp.c_str(), operation.c_str(), success ? "YES" : "NO");
+void logJSONParse(StringView operation, bool success, StringView error) {
+    unsigned long timestamp = millis();
+    Serial.printf("📝 %lu JSON - Operation: %.*s | Success: %s", 
+                  timestamp, (int)operation.length(), operation.data(), success ? "YES" : "NO");
     if (!success && error.length() > 0) {
-        Serial.printf(" | Error: %s", error.c_str());
+        Serial.printf(" | Error: %.*s", (int)error.length(), error.data());
     }
     Serial.println();
 }
 
-void logMemoryOperation(const String& operation, size_t bytes, bool success) {
-    String timestamp = String(millis());
-    Serial.printf("💾 %s MEMORY - Operation: %s | Bytes: %d | Success: %s", 
-                  timestamp.c_str(), operation.c_str(), bytes, success ? "YES" : "NO");
+void logMemoryOperation(StringView operation, size_t bytes, bool success) {
+    unsigned long timestamp = millis();
+    Serial.printf("💾 %lu MEMORY - Operation: %.*s | Bytes: %d | Success: %s", 
+                  timestamp, (int)operation.length(), operation.data(), bytes, success ? "YES" : "NO");
     Serial.println();
 }
 
-void logTiming(const String& operation, unsigned long startTime, unsigned long endTime) {
-    String timestamp = String(millis());
+void logTiming(StringView operation, unsigned long startTime, unsigned long endTime) {
+    unsigned long timestamp = millis();
     unsigned long duration = endTime - startTime;
-    Serial.printf("⏱️ %s TIMING - Operation: %s | Duration: %lu ms", 
-                  timestamp.c_str(), operation.c_str(), duration);
+    Serial.printf("⏱️ %lu TIMING - Operation: %.*s | Duration: %lu ms", 
+                  timestamp, (int)operation.length(), operation.data(), duration);
     Serial.println();
 }
 
@@ -254,37 +254,46 @@ void logTiming(const String& operation, unsigned long startTime, unsigned long e
 // 📋 FLOW STATE MANAGEMENT
 // ========================================
 
-void updateAudioFlowState(const String& newState) {
+void updateAudioFlowState(StringView newState) {
     if (currentAudioFlowState != newState) {
-        logAudioFlowState(newState, "State changed from " + currentAudioFlowState);
+        FixedString<64> info("State changed from ");
+        info += currentAudioFlowState;
+        logAudioFlowState(newState, info);
         currentAudioFlowState = newState;
     }
 }
 
-void updateWebSocketFlowState(const String& newState) {
+void updateWebSocketFlowState(StringView newState) {
     if (currentWebSocketFlowState != newState) {
-        logWebSocketFlowState(newState, "State changed from " + currentWebSocketFlowState);
+        FixedString<64> info("State changed from ");
+        info += currentWebSocketFlowState;
+        logWebSocketFlowState(newState, info);
         currentWebSocketFlowState = newState;
     }
 }
 
-void updateAuthFlowState(const String& newState) {
+void updateAuthFlowState(StringView newState) {
     if (currentAuthFlowState != newState) {
-        logAuthFlowState(newState, "State changed from " + currentAuthFlowState);
+        FixedString<64> info("State changed from ");
+        info += currentAuthFlowState;
+        logAuthFlowState(newState, info);
         currentAuthFlowState = newState;
     }
 }
 
-void updateSystemState(const String& newState) {
+void updateSystemState(StringView newState) {
     if (currentSystemState != newState) {
-        logSystemEvent("State changed", currentSystemState + " -> " + newState);
+        FixedString<64> details(currentSystemState);
+        details += " -> ";
+        details += newState;
+        logSystemEvent("State changed", details);
         currentSystemState = newState;
     }
 }
 
 void logCurrentFlowStates() {
-    String timestamp = String(millis());
-    Serial.printf("📋 %s CURRENT FLOW STATES:", timestamp.c_str());
+    unsigned long timestamp = millis();
+    Serial.printf("📋 %lu CURRENT FLOW STATES:", timestamp);
     Serial.println();
     Serial.printf("   🎵 Audio: %s", currentAudioFlowState.c_str());
     Serial.println();
@@ -2,6 +2,7 @@
 #define COMPREHENSIVE_LOGGING_H
 
 #include <Arduino.h>
+#include "fixed_string.h"
 
 // ========================================
 // 🧸 AI TEDDY BEAR - COMPREHENSIVE LOGGING
@@ -54,41 +55,41 @@
 // ========================================
 
 // Audio Event Logging
-void logAudioEvent(const String& event, const String& details = "");
-void logAudioFlowState(const String& state, const String& info = "");
-void logAudioData(const String& operation, size_t bytes, const String& format = "");
+void logAudioEvent(StringView event, StringView details = "");
+void logAudioFlowState(StringView state, StringView info = "");
+void logAudioData(StringView operation, size_t bytes, StringView format = "");
 
 // WebSocket Event Logging
-void logWebSocketEvent(const String& event, const String& details = "");
-void logWebSocketFlowState(const String& state, const String& info = "");
-void logWebSocketMessage(const String& direction, const String& type, size_t size = 0);
+void logWebSocketEvent(StringView event, StringView details = "");
+void logWebSocketFlowState(StringView state, StringView info = "");
+void logWebSocketMessage(StringView direction, StringView type, size_t size = 0);
 
 // Authentication Event Logging
-void logAuthEvent(const String& event, const String& details = "");
-void logAuthFlowState(const String& state, const String& info = "");
-void logAuthToken(const String& operation, const String& status = "");
+void logAuthEvent(StringView event, StringView details = "");
+void logAuthFlowState(StringView state, StringView info = "");
+void logAuthToken(StringView operation, StringView status = "");
 
 // System Event Logging
-void logSystemEvent(const String& event, const String& details = "");
-void logButtonEvent(const String& action, const String& result = "");
-void logSensorEvent(const String& sensor, const String& value = "");
+void logSystemEvent(StringView event, StringView details = "");
+void logButtonEvent(StringView action, StringView result = "");
+void logSensorEvent(StringView sensor, StringView value = "");
 
 // Error and Success Logging
-void logError(const String& component, const String& error, const String& details = "");
-void logSuccess(const String& component, const String& success, const String& details = "");
+void logError(StringView component, StringView error, StringView details = "");
+void logSuccess(StringView component, StringView success, StringView details = "");
 
 // ========================================
 // 🔄 COMPLETE FLOW TRACKING
 // ========================================
 
 // Complete Audio Interaction Flow
-void logCompleteAudioFlow(const String& phase, const String& status, const String& details = "");
+void logCompleteAudioFlow(StringView phase, StringView status, StringView details = "");
 
 // Complete Authentication Flow
-void logCompleteAuthFlow(const String& phase, const String& status, const String& details = "");
+void logCompleteAuthFlow(StringView phase, StringView status, StringView details = "");
 
 // Complete WebSocket Flow
-void logCompleteWebSocketFlow(const String& phase, const String& status, const String& details = "");
+void logCompleteWebSocketFlow(StringView phase, StringView status, StringView details = "");
 
 // ========================================
 // 📊 STATISTICS AND METRICS
@@ -99,7 +100,7 @@ void logAudioStats(size_t bytesRecorded, size_t bytesSent, size_t bytesReceived,
 void logAudioQuality(float rmsLevel, int16_t peakLevel, bool voiceDetected);
 
 // Network Statistics
-void logNetworkStats(const String& operation, unsigned long duration, size_t bytes, bool success);
+void logNetworkStats(StringView operation, unsigned long duration, size_t bytes, bool success);
 
 // System Statistics
 void logSystemStats(unsigned long uptime, size_t freeHeap, float cpuUsage);
@@ -109,42 +110,43 @@ void logSystemStats(unsigned long uptime, size_t freeHeap, float cpuUsage);
 // ========================================
 
 // Button Interactions
-void logButtonInteraction(const String& action, const String& context, const String& result);
+void logButtonInteraction(StringView action, StringView context, StringView result);
 
 // LED Animations
-void logLEDAnimation(const String& animation, const String& color, int duration);
+void logLEDAnimation(StringView animation, StringView color, int duration);
 
 // Audio Playback
-void logAudioPlayback(const String& audioType, int volume, int duration, bool success);
+void logAudioPlayback(StringView audioType, int volume, int duration, bool success);
 
 // ========================================
 // 🔧 DEBUGGING HELPERS
 // ========================================
 
 // JSON Parsing
-void logJSONParse(const String& operation, bool success, const String& error = "");
+void logJSONParse(StringView operation, bool success, StringView error = "");
 
 // Memory Management
-void logMemoryOperation(const String& operation, size_t bytes, bool success);
+void logMemoryOperation(StringView operation, size_t bytes, bool success);
 
 // Timing Information
-void logTiming(const String& operation, unsigned long startTime, unsigned long endTime);
+void logTiming(StringView operation, unsigned long startTime, unsigned long endTime);
 
 // ========================================
 // 📋 FLOW STATE TRACKING
 // ========================================
 
-// Global flow state variables (extern)
-extern String currentAudioFlowState;
-extern String currentWebSocketFlowState;
-extern String currentAuthFlowState;
-extern String currentSystemState;
+// Global flow state variables (extern); fixed buffers so state changes never allocate
+typedef FixedString<32> FlowStateName;
+extern FlowStateName currentAudioFlowState;
+extern FlowStateName currentWebSocketFlowState;
+extern FlowStateName currentAuthFlowState;
+extern FlowStateName currentSystemState;
 
 // Flow state management
-void updateAudioFlowState(const String& newState);
-void updateWebSocketFlowState(const String& newState);
-void updateAuthFlowState(const String& newState);
-void updateSystemState(const String& newState);
+void updateAudioFlowState(StringView newState);
+void updateWebSocketFlowState(StringView newState);
+void updateAuthFlowState(StringView newState);
+void updateSystemState(StringView newState);
 
 // Flow state logging
 void logCurrentFlowStates();
@@ -0,0 +1,357 @@
+#include "diagnostics_endpoints.h"
+#include "config.h"
+#include "metrics_registry.h"
+#include "task_stats.h"
+#include "stack_monitor.h"
+#include "resource_manager.h"
+#include "memory_budget.h"
+#include "json_arena.h"
+#include "connection_stats.h"
+#include "websocket_handler.h"
+#include "audio_tap.h"
+#include <ArduinoJson.h>
+#include <esp_heap_caps.h>
+#include <stdarg.h>
+#if FEATURE_AUDIO_TAPS
+#include <SPIFFS.h>
+#endif
+
+// =============================================================================
+// RESPONSE STREAM
+// =============================================================================
+
+ResponseStream::ResponseStream(ResponseSink sinkFn, void* sinkContext)
+  : sink(sinkFn), context(sinkContext), used(0), sinkFailed(false) {}
+
+ResponseStream::~ResponseStream() {
+  flush();
+}
+
+bool ResponseStream::flush() {
+  if (used > 0 && !sinkFailed) {
+    sinkFailed = !sink(context, buffer, used);
+  }
+  used = 0;
+  return !sinkFailed;
+}
+
+size_t ResponseStream::write(uint8_t c) {
+  if (used == sizeof(buffer)) {
+    flush();
+  }
+  buffer[used++] = (char)c;
+  return 1;
+}
+
+size_t ResponseStream::write(const uint8_t* data, size_t length) {
+  size_t remaining = length;
+  while (remaining > 0) {
+    if (used == sizeof(buffer)) {
+      flush();
+    }
+    size_t n = min(remaining, sizeof(buffer) - used);
+    memcpy(buffer + used, data, n);
+    used += n;
+    data += n;
+    remaining -= n;
+  }
+  return length;
+}
+
+void ResponseStream::print(const char* text) {
+  write((const uint8_t*)text, strlen(text));
+}
+
+// Formats in place; a line that does not fit flushes the buffer and retries
+void ResponseStream::printf(const char* format, ...) {
+  for (uint8_t attempt = 0; attempt < 2; attempt++) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + used, sizeof(buffer) - used, format, args);
+    va_end(args);
+    if (n < 0) return;
+    if ((size_t)n < sizeof(buffer) - used) {
+      used += n;
+      return;
+    }
+    if (used == 0) {
+      used = sizeof(buffer) - 1;   // Longer than a whole chunk: keep it truncated
+      size_t fmtLen = strlen(format);
+      if (fmtLen > 0 && format[fmtLen - 1] == '\n') {
+        buffer[used - 1] = '\n';   // ...but still line-terminated
+      }
+      return;
+    }
+    flush();
+  }
+}
+
+// =============================================================================
+// PROMETHEUS EXPOSITION
+// =============================================================================
+
+// "ws.rtt" + "ms" -> "teddy_ws_rtt_ms"; anything outside [a-zA-Z0-9_] becomes '_'
+static void exportName(char* out, size_t size, const char* name, const char* unit) {
+  const char* suffix = (strcmp(unit, "%") == 0) ? "percent" : unit;
+  int n = snprintf(out, size, DIAG_METRIC_PREFIX "%s%s%s", name, suffix[0] ? "_" : "", suffix);
+  size_t len = (n < 0) ? 0 : min((size_t)n, size - 1);
+  for (size_t i = 0; i < len; i++) {
+    char c = out[i];
+    if (!isalnum((unsigned char)c) && c != '_') {
+      out[i] = '_';
+    }
+  }
+}
+
+void renderPrometheusMetrics(ResponseStream& out) {
+  char name[64];
+
+  out.print("# TYPE " DIAG_METRIC_PREFIX "build_info gauge\n");
+  out.printf(DIAG_METRIC_PREFIX "build_info{version=\"%s\"} 1\n", FIRMWARE_VERSION);
+  out.print("# TYPE " DIAG_METRIC_PREFIX "uptime_seconds gauge\n");
+  out.printf(DIAG_METRIC_PREFIX "uptime_seconds %lu\n", (unsigned long)(millis() / 1000));
+
+  for (size_t i = 0; i < getMetricCount(METRIC_COUNTER); i++) {
+    MetricId id = (MetricId)i;
+    exportName(name, sizeof(name), getMetricName(METRIC_COUNTER, id), getMetricUnit(METRIC_COUNTER, id));
+    out.printf("# TYPE %s_total counter\n%s_total %u\n", name, name, getCounterValue(id));
+  }
+
+  for (size_t i = 0; i < getMetricCount(METRIC_GAUGE); i++) {
+    MetricId id = (MetricId)i;
+    exportName(name, sizeof(name), getMetricName(METRIC_GAUGE, id), getMetricUnit(METRIC_GAUGE, id));
+    out.printf("# TYPE %s gauge\n%s %d\n", name, name, (int)getGaugeValue(id));
+  }
+
+  for (size_t i = 0; i < getMetricCount(METRIC_HISTOGRAM); i++) {
+    MetricId id = (MetricId)i;
+    HistogramSnapshot snap;
+    if (!getHistogramSnapshot(id, snap)) continue;
+    exportName(name, sizeof(name), getMetricName(METRIC_HISTOGRAM, id), getMetricUnit(METRIC_HISTOGRAM, id));
+    out.printf("# TYPE %s summary\n", name);
+    // Quantiles of nothing observed yet are NaN, not 0, as client libraries export them
+    const char* const quantiles[] = {"0.5", "0.9", "0.99", "0.999"};
+    const uint32_t values[] = {snap.p50, snap.p90, snap.p99, snap.p999};
+    for (uint8_t q = 0; q < 4; q++) {
+      if (snap.count == 0) {
+        out.printf("%s{quantile=\"%s\"} NaN\n", name, quantiles[q]);
+      } else {
+        out.printf("%s{quantile=\"%s\"} %u\n", name, quantiles[q], values[q]);
+      }
+    }
+    out.printf("%s_sum %llu\n%s_count %u\n", name, (unsigned long long)snap.sum, name, snap.count);
+  }
+}
+
+// =============================================================================
+// DEBUG PAGES
+// =============================================================================
+
+void renderDebugIndex(ResponseStream& out) {
+  out.print("AI Teddy Bear diagnostics\n\n"
+            "/metrics           Prometheus metrics\n"
+            "/debug/tasks       tasks, CPU and stacks\n"
+            "/debug/heap        heap regions, pools and arenas\n"
+            "/debug/latency     latency histograms\n"
+            "/debug/connection  connection health (JSON)\n"
+#if FEATURE_AUDIO_TAPS
+            "/debug/taps        audio taps (/debug/tap?name=... for WAV)\n"
+#endif
+            "/history           metrics history (?series=&resolution=)\n");
+}
+
+void renderDebugTasks(ResponseStream& out) {
+  out.printf("Uptime %lu s, CPU core0 %.1f%%, core1 %.1f%%\n\n",
+             (unsigned long)(millis() / 1000), getCoreCpuPercent(0), getCoreCpuPercent(1));
+
+  out.print("Task             Core Prio   CPU%  MaxRun(us)  Ready  StackFree\n");
+  for (size_t i = 0; i < getTaskStatsCount(); i++) {
+    const TaskStatsEntry* t = getTaskStatsAt(i);
+    if (t == nullptr || !t->seen) continue;
+    char core[12];
+    snprintf(core, sizeof(core), "%d", t->core);
+    out.printf("%-16s %4s %4u %6.1f %11u %6u %10u\n", t->name, t->core < 0 ? "-" : core,
+               (unsigned)t->priority, t->cpuPercent, t->maxWindowRunTime,
+               t->readyObservations, t->stackHighWater);
+  }
+
+  out.print("\nStack            Size  PeakUsed  MinFree  Suggest\n");
+  for (size_t i = 0; i < getStackEntryCount(); i++) {
+    const StackUsageEntry* e = getStackEntryAt(i);
+    if (e == nullptr) continue;
+    out.printf("%-16s %5u %9u %8u %8u%s\n", e->name, e->stackSize, e->stackSize - e->minFree,
+               e->minFree, getStackSuggestion(*e),
+               e->handle || e->isrCore >= 0 ? "" : " (exited)");
+  }
+}
+
+static void renderHeapRegion(ResponseStream& out, const char* label, uint32_t caps) {
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, caps);
+  size_t total = info.total_free_bytes + info.total_allocated_bytes;
+  if (total == 0) return;
+  unsigned frag = info.total_free_bytes == 0 ? 0
+                : 100 - (unsigned)(info.largest_free_block * 100 / info.total_free_bytes);
+  out.printf("%-9s %8u %8u %8u %8u %7u %7u %5u%%\n", label, (unsigned)total,
+             (unsigned)info.total_free_bytes, (unsigned)info.largest_free_block,
+             (unsigned)info.minimum_free_bytes, (unsigned)info.allocated_blocks,
+             (unsigned)info.free_blocks, frag);
+}
+
+void renderDebugHeap(ResponseStream& out) {
+  static const char* const pressureNames[] = {"none", "elevated", "critical"};
+
+  out.print("Region       Total     Free  Largest  MinFree  Allocs   Frees  Frag\n");
+  renderHeapRegion(out, "internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  renderHeapRegion(out, "dma", MALLOC_CAP_DMA);
+  renderHeapRegion(out, "spiram", MALLOC_CAP_SPIRAM);
+
+  MemoryPressure pressure = getMemoryPressure();
+  out.printf("\nPressure: %s, degradation level %u\n",
+             pressure <= MEM_PRESSURE_CRITICAL ? pressureNames[pressure] : "?",
+             getDegradationLevel());
+
+  out.print("\nPool   Block  Used/Total  HighWater   Allocs  Exhausted\n");
+  for (size_t i = 0; i < getMemoryPoolCount(); i++) {
+    MemoryPoolStats s;
+    if (!getMemoryPoolStats(i, s)) continue;
+    out.printf("%4u %7u %5u/%-5u %10u %8u %10u%s\n", (unsigned)i, (unsigned)s.blockSize,
+               (unsigned)s.usedBlocks, (unsigned)s.totalBlocks, (unsigned)s.highWater,
+               s.allocations, s.exhausted, s.inPsram ? " psram" : "");
+  }
+  out.printf("Pool fallbacks to malloc: %u\n", getPoolFallbackCount());
+
+  JsonArenaStats arena = getJsonArenaStats();
+  out.printf("\nJSON arenas: %u bytes reserved, peak %u, %u scopes, %u heap fallbacks, %u resizes\n",
+             (unsigned)arena.reservedBytes, (unsigned)arena.peakUsage, arena.scopes,
+             arena.heapFallbacks, arena.resizes);
+}
+
+void renderDebugLatency(ResponseStream& out) {
+  out.print("Histogram                Unit     Count      Min      p50      p90      p99    p99.9      Max\n");
+  for (size_t i = 0; i < getMetricCount(METRIC_HISTOGRAM); i++) {
+    MetricId id = (MetricId)i;
+    HistogramSnapshot s;
+    if (!getHistogramSnapshot(id, s)) continue;
+    out.printf("%-24s %-4s %9u %8u %8u %8u %8u %8u %8u\n", getMetricName(METRIC_HISTOGRAM, id),
+               getMetricUnit(METRIC_HISTOGRAM, id), s.count, s.min, s.p50, s.p90, s.p99, s.p999, s.max);
+  }
+}
+
+void renderDebugConnection(ResponseStream& out) {
+  StaticJsonDocument<1024> doc;
+  JsonObject health = doc.createNestedObject("websocket");
+  getConnectionHealth(health);
+
+  ConnectionStats stats = getConnectionStats();
+  JsonObject totals = doc.createNestedObject("totals");
+  totals["boots"] = stats.totalBootCount;
+  totals["wifi_attempts"] = stats.wifiConnectAttempts;
+  totals["wifi_successes"] = stats.wifiConnectSuccesses;
+  totals["wifi_disconnections"] = stats.wifiDisconnections;
+  totals["ws_attempts"] = stats.websocketConnectAttempts;
+  totals["ws_successes"] = stats.websocketConnectSuccesses;
+  totals["ws_disconnections"] = stats.websocketDisconnections;
+  totals["jwt_refresh_attempts"] = stats.jwtRefreshAttempts;
+  totals["jwt_refresh_successes"] = stats.jwtRefreshSuccesses;
+  totals["recoveries"] = stats.systemRecoveries;
+  totals["last_reset_reason"] = (int)stats.lastResetReason;
+
+  serializeJson(doc, out);
+  out.print("\n");
+}
+
+void renderDebugTaps(ResponseStream& out) {
+#if FEATURE_AUDIO_TAPS
+  out.print("Tap        Armed  Ring (s)  Held (s)  Written (s)  Last write (ms ago)\n");
+  uint32_t now = micros();
+  for (int i = 0; i < AUDIO_TAP_COUNT; i++) {
+    AudioTapInfo info = getAudioTapInfo((AudioTapPoint)i);
+    float held = (float)min(info.total, info.capacity) / AUDIO_TAP_SAMPLE_RATE;
+    out.printf("%-10s %-6s %8.1f  %8.1f  %11.1f  ", info.name, info.armed ? "yes" : "no",
+               (float)info.capacity / AUDIO_TAP_SAMPLE_RATE, held, (float)info.total / AUDIO_TAP_SAMPLE_RATE);
+    if (info.total > 0) {
+      out.printf("%u\n", (now - info.endUs) / 1000);
+    } else {
+      out.print("-\n");
+    }
+  }
+#else
+  out.print("Audio taps not compiled in (FEATURE_AUDIO_TAPS)\n");
+#endif
+}
+
+// =============================================================================
+// WEB SERVER
+// =============================================================================
+
+static bool webServerSink(void* context, const char* data, size_t length) {
+  WebServer* server = static_cast<WebServer*>(context);
+  if (!server->client().connected()) {
+    return false;
+  }
+  server->sendContent(data, length);
+  return true;
+}
+
+void streamResponse(WebServer& server, const char* contentType, void (*render)(ResponseStream&)) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, contentType, "");
+  {
+    ResponseStream out(webServerSink, &server);
+    render(out);
+  }
+  server.sendContent("");   // Final empty chunk
+}
+
+#if FEATURE_AUDIO_TAPS
+static bool webServerTapSink(void* context, const uint8_t* data, size_t length) {
+  return webServerSink(context, (const char*)data, length);
+}
+
+// Ring snapshot streamed as it is read, or the copy saved by "tap save"
+static void sendAudioTap(WebServer& server) {
+  AudioTapPoint tap;
+  if (!findAudioTap(server.arg("name").c_str(), tap)) {
+    server.send(404, "text/plain", "Unknown tap (see /debug/taps)\n");
+    return;
+  }
+  char filename[32];
+  snprintf(filename, sizeof(filename), AUDIO_TAP_FILE_PREFIX "%s.wav", getAudioTapName(tap));
+
+  if (server.arg("saved") == "1") {
+    File file = SPIFFS.begin(true) ? SPIFFS.open(filename, FILE_READ) : File();
+    if (!file) {
+      server.send(404, "text/plain", "Not saved\n");
+      return;
+    }
+    server.streamFile(file, "audio/wav");
+    file.close();
+    return;
+  }
+
+  if (getAudioTapInfo(tap).capacity == 0) {
+    server.send(409, "text/plain", "Tap not armed\n");
+    return;
+  }
+  server.sendHeader("Content-Disposition", String("attachment; filename=") + (filename + 1));
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "audio/wav", "");
+  exportAudioTap(tap, webServerTapSink, &server);
+  server.sendContent("");   // Final empty chunk
+}
+#endif
+
+void registerDiagnosticsEndpoints(WebServer& server) {
+  WebServer* s = &server;
+  server.on("/metrics", HTTP_GET, [s]() { streamResponse(*s, DIAG_PROMETHEUS_TYPE, renderPrometheusMetrics); });
+  server.on("/debug", HTTP_GET, [s]() { streamResponse(*s, "text/plain", renderDebugIndex); });
+  server.on("/debug/tasks", HTTP_GET, [s]() { streamResponse(*s, "text/plain", renderDebugTasks); });
+  server.on("/debug/heap", HTTP_GET, [s]() { streamResponse(*s, "text/plain", renderDebugHeap); });
+  server.on("/debug/latency", HTTP_GET, [s]() { streamResponse(*s, "text/plain", renderDebugLatency); });
+  server.on("/debug/connection", HTTP_GET, [s]() { streamResponse(*s, "application/json", renderDebugConnection); });
+#if FEATURE_AUDIO_TAPS
+  server.on("/debug/taps", HTTP_GET, [s]() { streamResponse(*s, "text/plain", renderDebugTaps); });
+  server.on("/debug/tap", HTTP_GET, [s]() { sendAudioTap(*s); });
+#endif
+}
@@ -8,7 +8,7 @@
 // Static configuration storage
 static Preferences dynamicPrefs;
 static DynamicJsonDocument currentConfig(2048);
-static DynamicJsonDocument backupConfig(2048);
+static DynamicJsonDocument backupConfig(0);  // Sized on first backup, then trimmed
 static ConfigMetadata configMetadata;
 static String configFilePath = "/config/teddy_config.json";
 
@@ -345,6 +345,7 @@ bool DynamicConfig::applyConfiguration() {
   
   // Create backup before applying
   backupConfig = currentConfig;
+  backupConfig.shrinkToFit();  // Read-only until rollback; keep only what it uses
   
   // Apply environment-specific defaults
   applyEnvironmentDefaults();
@@ -371,7 +372,7 @@ bool DynamicConfig::applyConfiguration() {
 
 void DynamicConfig::rollbackConfiguration() {
   Serial.println("🔄 Rolling back configuration...");
-  currentConfig = backupConfig;
+  currentConfig.set(backupConfig);  // Copy content, keep currentConfig's capacity
   applyConfiguration();
 }
 
@@ -1,170 +1,372 @@
 #include "encoding_service.h"
-#include <mbedtls/base64.h>
-
-// Service statistics
-static unsigned long totalOperations = 0;
-static unsigned long totalErrors = 0;
-
-// Internal helpers
-namespace {
-    bool validateAndTrack(bool condition) {
-        totalOperations++;
-        if (!condition) {
-            totalErrors++;
-            Serial.println("❌ Encoding service: Invalid parameters");
-        }
-        return condition;
-    }
-    
-    size_t calculateDecodedSize(const char* encoded) {
-        if (!encoded) return 0;
-        size_t len = strlen(encoded);
-        if (len == 0) return 0;
-        
-        // Remove padding for calculation
-        while (len > 0 && encoded[len - 1] == '=') {
-            len--;
-        }
-        
-        return (len * 3) / 4;
-    }
+
+// =============================================================================
+// TABLES
+// =============================================================================
+
+static const char STANDARD_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char URL_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// Character to sextet. Anything at or above DECODE_PAD leaves the word
+// kernel for the byte-at-a-time path.
+#define DECODE_PAD      0x40    // '='
+#define DECODE_SPACE    0x41    // Space, tab, CR, LF
+#define DECODE_INVALID  0x80
+#define DECODE_SPECIAL  (DECODE_PAD | DECODE_INVALID)
+
+static const uint8_t STANDARD_DECODE[256] = {
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x41, 0x41, 0x80, 0x80, 0x41, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x41, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3E, 0x80, 0x80, 0x80, 0x3F,
+  0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x80, 0x80, 0x80, 0x40, 0x80, 0x80,
+  0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+  0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+};
+
+static const uint8_t URL_DECODE[256] = {
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x41, 0x41, 0x80, 0x80, 0x41, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x41, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3E, 0x80, 0x80,
+  0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x80, 0x80, 0x80, 0x40, 0x80, 0x80,
+  0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+  0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x3F,
+  0x80, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+};
+
+static inline const char* alphabetFor(uint8_t flags) {
+  return (flags & BASE64_URL) ? URL_ALPHABET : STANDARD_ALPHABET;
 }
 
-// Implementation
-unsigned int decodeBase64(const char* encoded, unsigned char* output, size_t output_size) {
-    if (!validateAndTrack(encoded != nullptr && output != nullptr && output_size > 0)) {
-        return 0;
-    }
-    
-    size_t expectedSize = calculateDecodedSize(encoded);
-    if (expectedSize == 0 || expectedSize > output_size) {
-        totalErrors++;
-        Serial.printf("❌ Encoding service: Buffer too small. Expected: %d, Available: %d\n", 
-                     expectedSize, output_size);
-        return 0;
-    }
-    
-    try {
-        size_t decodedLength = 0;
-        int ret = mbedtls_base64_decode(output, output_size, &decodedLength, 
-                                       (const unsigned char*)encoded, strlen(encoded));
-        if (ret != 0 || decodedLength == 0) {
-            totalErrors++;
-            Serial.println("❌ Encoding service: Base64 decoding failed");
-            return 0;
-        }
-        return (unsigned int)decodedLength;
-    } catch (...) {
-        totalErrors++;
-        Serial.println("❌ Encoding service: Exception during base64 decoding");
-        return 0;
-    }
+static inline const uint8_t* decodeTableFor(uint8_t flags) {
+  return (flags & BASE64_URL) ? URL_DECODE : STANDARD_DECODE;
 }
 
-std::vector<uint8_t> decodeBase64ToVector(const String& encoded) {
-    std::vector<uint8_t> result;
-    
-    if (!validateAndTrack(!encoded.isEmpty())) {
-        return result;
-    }
-    
-    size_t expectedSize = calculateDecodedSize(encoded.c_str());
-    if (expectedSize == 0) {
-        totalErrors++;
-        return result;
-    }
-    
-    std::vector<uint8_t> buffer(expectedSize + 4);
-    unsigned int decodedLength = decodeBase64(encoded.c_str(), buffer.data(), buffer.size());
-    
-    if (decodedLength > 0) {
-        result.assign(buffer.begin(), buffer.begin() + decodedLength);
-    }
-    
-    return result;
+// =============================================================================
+// WORD KERNELS
+// =============================================================================
+
+// Byte i of a word in memory order, and the word holding four bytes
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define WORD_BYTE(w, i)   (((w) >> (24 - 8 * (i))) & 0xFF)
+#define BYTES_WORD(b0, b1, b2, b3) \
+  (((uint32_t)(b0) << 24) | ((uint32_t)(b1) << 16) | ((uint32_t)(b2) << 8) | (uint32_t)(b3))
+#else
+#define WORD_BYTE(w, i)   (((w) >> (8 * (i))) & 0xFF)
+#define BYTES_WORD(b0, b1, b2, b3) \
+  ((uint32_t)(b0) | ((uint32_t)(b1) << 8) | ((uint32_t)(b2) << 16) | ((uint32_t)(b3) << 24))
+#endif
+
+// Aligned words compile to single loads and stores; the Xtensa core traps
+// on unaligned ones, so those are assembled from bytes
+template <bool Aligned>
+static inline uint32_t loadWord(const void* p) {
+  uint32_t w;
+  if (Aligned) {
+    memcpy(&w, __builtin_assume_aligned(p, 4), 4);
+  } else {
+    memcpy(&w, p, 4);
+  }
+  return w;
+}
+
+template <bool Aligned>
+static inline void storeWord(void* p, uint32_t w) {
+  if (Aligned) {
+    memcpy(__builtin_assume_aligned(p, 4), &w, 4);
+  } else {
+    memcpy(p, &w, 4);
+  }
+}
+
+// Four characters for a 24-bit group, in memory order
+static inline uint32_t encodeGroupWord(const char* alphabet, uint32_t g) {
+  return BYTES_WORD((uint8_t)alphabet[g >> 18], (uint8_t)alphabet[(g >> 12) & 63],
+                    (uint8_t)alphabet[(g >> 6) & 63], (uint8_t)alphabet[g & 63]);
 }
 
-unsigned int calculateBase64EncodedSize(size_t input_length) {
-    if (!validateAndTrack(input_length > 0)) {
-        return 0;
+// 12 bytes to 16 characters per step
+template <bool AlignedIn, bool AlignedOut>
+static void encodeBlocks(const char* alphabet, const uint8_t* in, size_t blocks, char* out) {
+  for (size_t i = 0; i < blocks; i++, in += 12, out += 16) {
+    uint32_t w0 = loadWord<AlignedIn>(in);
+    uint32_t w1 = loadWord<AlignedIn>(in + 4);
+    uint32_t w2 = loadWord<AlignedIn>(in + 8);
+    uint32_t g0 = (WORD_BYTE(w0, 0) << 16) | (WORD_BYTE(w0, 1) << 8) | WORD_BYTE(w0, 2);
+    uint32_t g1 = (WORD_BYTE(w0, 3) << 16) | (WORD_BYTE(w1, 0) << 8) | WORD_BYTE(w1, 1);
+    uint32_t g2 = (WORD_BYTE(w1, 2) << 16) | (WORD_BYTE(w1, 3) << 8) | WORD_BYTE(w2, 0);
+    uint32_t g3 = (WORD_BYTE(w2, 1) << 16) | (WORD_BYTE(w2, 2) << 8) | WORD_BYTE(w2, 3);
+    storeWord<AlignedOut>(out, encodeGroupWord(alphabet, g0));
+    storeWord<AlignedOut>(out + 4, encodeGroupWord(alphabet, g1));
+    storeWord<AlignedOut>(out + 8, encodeGroupWord(alphabet, g2));
+    storeWord<AlignedOut>(out + 12, encodeGroupWord(alphabet, g3));
+  }
+}
+
+static void encodeBulk(const char* alphabet, const uint8_t* in, size_t blocks, char* out) {
+  bool alignedIn = ((uintptr_t)in & 3) == 0;
+  bool alignedOut = ((uintptr_t)out & 3) == 0;
+  if (alignedIn && alignedOut) {
+    encodeBlocks<true, true>(alphabet, in, blocks, out);
+  } else if (alignedIn) {
+    encodeBlocks<true, false>(alphabet, in, blocks, out);
+  } else if (alignedOut) {
+    encodeBlocks<false, true>(alphabet, in, blocks, out);
+  } else {
+    encodeBlocks<false, false>(alphabet, in, blocks, out);
+  }
+}
+
+// 24-bit group for the four characters of a word; ORs the table entries
+// into special so one test per block catches padding, whitespace and junk
+static inline uint32_t decodeGroupWord(const uint8_t* table, uint32_t w, uint32_t& special) {
+  uint32_t a = table[WORD_BYTE(w, 0)];
+  uint32_t b = table[WORD_BYTE(w, 1)];
+  uint32_t c = table[WORD_BYTE(w, 2)];
+  uint32_t d = table[WORD_BYTE(w, 3)];
+  special |= a | b | c | d;
+  return (a << 18) | (b << 12) | (c << 6) | d;
+}
+
+// 16 characters to 12 bytes per step. Stops at the first block that needs
+// the byte-at-a-time path; nothing of that block is written, so decoding in
+// place can still read it. Returns the blocks decoded.
+template <bool AlignedIn, bool AlignedOut>
+static size_t decodeBlocks(const uint8_t* table, const char* in, size_t blocks, uint8_t* out) {
+  size_t done = 0;
+  for (; done < blocks; done++, in += 16, out += 12) {
+    uint32_t special = 0;
+    uint32_t g0 = decodeGroupWord(table, loadWord<AlignedIn>(in), special);
+    uint32_t g1 = decodeGroupWord(table, loadWord<AlignedIn>(in + 4), special);
+    uint32_t g2 = decodeGroupWord(table, loadWord<AlignedIn>(in + 8), special);
+    uint32_t g3 = decodeGroupWord(table, loadWord<AlignedIn>(in + 12), special);
+    if (special & DECODE_SPECIAL) break;
+    storeWord<AlignedOut>(out, BYTES_WORD(g0 >> 16, (g0 >> 8) & 0xFF, g0 & 0xFF, g1 >> 16));
+    storeWord<AlignedOut>(out + 4, BYTES_WORD((g1 >> 8) & 0xFF, g1 & 0xFF, g2 >> 16, (g2 >> 8) & 0xFF));
+    storeWord<AlignedOut>(out + 8, BYTES_WORD(g2 & 0xFF, g3 >> 16, (g3 >> 8) & 0xFF, g3 & 0xFF));
+  }
+  return done;
+}
+
+static size_t decodeBulk(const uint8_t* table, const char* in, size_t blocks, uint8_t* out) {
+  bool alignedIn = ((uintptr_t)in & 3) == 0;
+  bool alignedOut = ((uintptr_t)out & 3) == 0;
+  if (alignedIn && alignedOut) return decodeBlocks<true, true>(table, in, blocks, out);
+  if (alignedIn) return decodeBlocks<true, false>(table, in, blocks, out);
+  if (alignedOut) return decodeBlocks<false, true>(table, in, blocks, out);
+  return decodeBlocks<false, false>(table, in, blocks, out);
+}
+
+// =============================================================================
+// STREAMING
+// =============================================================================
+
+void base64StreamBegin(Base64Stream& stream, uint8_t flags) {
+  stream.bits = 0;
+  stream.count = 0;
+  stream.flags = flags;
+  stream.padding = 0;
+  stream.failed = false;
+}
+
+size_t base64EncodeUpdate(Base64Stream& stream, const uint8_t* data, size_t length, char* out) {
+  const char* alphabet = alphabetFor(stream.flags);
+  char* start = out;
+
+  // Complete the group left over from the last piece
+  while (stream.count > 0 && length > 0) {
+    stream.bits = (stream.bits << 8) | *data++;
+    length--;
+    if (++stream.count == 3) {
+      storeWord<false>(out, encodeGroupWord(alphabet, stream.bits));
+      out += 4;
+      stream.bits = 0;
+      stream.count = 0;
     }
-    return ((input_length + 2) / 3) * 4 + 1;
+  }
+
+  size_t blocks = length / 12;
+  if (blocks > 0) {
+    encodeBulk(alphabet, data, blocks, out);
+    data += blocks * 12;
+    out += blocks * 16;
+    length -= blocks * 12;
+  }
+  for (; length >= 3; data += 3, length -= 3, out += 4) {
+    storeWord<false>(out, encodeGroupWord(alphabet, ((uint32_t)data[0] << 16) | (data[1] << 8) | data[2]));
+  }
+  while (length > 0) {
+    stream.bits = (stream.bits << 8) | *data++;
+    stream.count++;
+    length--;
+  }
+  return out - start;
 }
 
-unsigned int encodeBase64(const unsigned char* data, size_t length, unsigned char* output, size_t output_size) {
-    if (!validateAndTrack(data != nullptr && output != nullptr && length > 0)) {
-        return 0;
+size_t base64EncodeFinish(Base64Stream& stream, char* out) {
+  if (stream.count == 0) return 0;
+
+  const char* alphabet = alphabetFor(stream.flags);
+  uint32_t g = stream.bits << (8 * (3 - stream.count));
+  size_t n = 0;
+  out[n++] = alphabet[g >> 18];
+  out[n++] = alphabet[(g >> 12) & 63];
+  if (stream.count == 2) out[n++] = alphabet[(g >> 6) & 63];
+  if (!(stream.flags & BASE64_NO_PAD)) {
+    while (n < 4) out[n++] = '=';
+  }
+  stream.bits = 0;
+  stream.count = 0;
+  return n;
+}
+
+// Writes the count - 1 bytes of a group closed by padding or the end of input
+static bool flushPartialGroup(Base64Stream& stream, uint8_t* out, size_t room, size_t& written) {
+  size_t bytes = stream.count - 1;
+  if (room < bytes) return false;
+  uint32_t g = stream.bits << (6 * (4 - stream.count));
+  out[written++] = g >> 16;
+  if (bytes == 2) out[written++] = (g >> 8) & 0xFF;
+  stream.bits = 0;
+  stream.count = 0;
+  return true;
+}
+
+bool base64DecodeUpdate(Base64Stream& stream, const char* text, size_t length,
+                        uint8_t* out, size_t outSize, size_t* outLength) {
+  const uint8_t* table = decodeTableFor(stream.flags);
+  const char* end = text + length;
+  const char* slowUntil = text;   // Past the block the kernel last stopped at
+  size_t written = 0;
+
+  while (text < end && !stream.failed) {
+    if (stream.count == 0 && stream.padding == 0 && text >= slowUntil) {
+      size_t blocks = min((size_t)(end - text) / 16, (outSize - written) / 12);
+      size_t done = blocks > 0 ? decodeBulk(table, text, blocks, out + written) : 0;
+      text += done * 16;
+      written += done * 12;
+      if (done < blocks) slowUntil = text + 16;
+      if (text == end) break;
     }
-    
-    try {
-        size_t encodedLength = 0;
-        int ret = mbedtls_base64_encode(output, output_size, &encodedLength, 
-                                       data, length);
-        if (ret != 0 || encodedLength == 0) {
-            totalErrors++;
-            Serial.println("❌ Encoding service: Base64 encoding failed");
-            return 0;
+
+    uint8_t v = table[(uint8_t)*text++];
+    if (v < 64) {
+      if (stream.padding > 0) {
+        stream.failed = true;   // Data after '='
+        break;
+      }
+      stream.bits = (stream.bits << 6) | v;
+      if (++stream.count == 4) {
+        if (outSize - written < 3) {
+          stream.failed = true;
+          break;
         }
-        return (unsigned int)encodedLength;
-    } catch (...) {
-        totalErrors++;
-        Serial.println("❌ Encoding service: Exception during base64 encoding");
-        return 0;
+        out[written++] = stream.bits >> 16;
+        out[written++] = (stream.bits >> 8) & 0xFF;
+        out[written++] = stream.bits & 0xFF;
+        stream.bits = 0;
+        stream.count = 0;
+      }
+    } else if (v == DECODE_PAD) {
+      // Only after two or three characters of a group, and only to complete it
+      if (stream.count < 2) {
+        stream.failed = true;
+        break;
+      }
+      if (stream.count + ++stream.padding == 4 &&
+          !flushPartialGroup(stream, out, outSize - written, written)) {
+        stream.failed = true;
+        break;
+      }
+    } else if (v != DECODE_SPACE || !(stream.flags & BASE64_WHITESPACE)) {
+      stream.failed = true;
+      break;
     }
+  }
+
+  if (outLength) *outLength = written;
+  return !stream.failed;
 }
 
-String encodeBase64ToString(const unsigned char* data, size_t length) {
-    String result = "";
-    
-    if (!validateAndTrack(data != nullptr && length > 0)) {
-        return result;
-    }
-    
-    unsigned int bufferSize = calculateBase64EncodedSize(length);
-    if (bufferSize == 0) {
-        return result;
+bool base64DecodeFinish(Base64Stream& stream, uint8_t* out, size_t outSize, size_t* outLength) {
+  size_t written = 0;
+  if (!stream.failed && stream.count > 0) {
+    // A group cut short: legal only unpadded and with at least two characters
+    if (stream.padding > 0 || stream.count == 1 || !(stream.flags & BASE64_NO_PAD) ||
+        !flushPartialGroup(stream, out, outSize, written)) {
+      stream.failed = true;
     }
-    
-    std::vector<unsigned char> buffer(bufferSize);
-    unsigned int encodedLength = encodeBase64(data, length, buffer.data(), buffer.size());
-    
-    if (encodedLength > 0) {
-        buffer[encodedLength] = '\0';
-        result = String((char*)buffer.data());
-    }
-    
-    return result;
+  }
+  if (outLength) *outLength = written;
+  return !stream.failed;
 }
 
-bool isValidBase64(const String& encoded) {
-    if (!validateAndTrack(!encoded.isEmpty())) {
-        return false;
-    }
-    
-    const char* str = encoded.c_str();
-    size_t len = encoded.length();
-    
-    if (len % 4 != 0) return false;
-    
-    for (size_t i = 0; i < len; i++) {
-        char c = str[i];
-        if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || 
-              (c >= '0' && c <= '9') || c == '+' || c == '/' || c == '=')) {
-            return false;
-        }
-        if (c == '=' && i < len - 2) return false;
-    }
-    
-    return true;
+// =============================================================================
+// ONE-SHOT
+// =============================================================================
+
+size_t base64EncodedLength(size_t length, uint8_t flags) {
+  if (flags & BASE64_NO_PAD) {
+    size_t tail = length % 3;
+    return (length / 3) * 4 + (tail > 0 ? tail + 1 : 0);
+  }
+  return ((length + 2) / 3) * 4;
 }
 
-void getEncodingStats(unsigned long& operations_count, unsigned long& errors_count) {
-    operations_count = totalOperations;
-    errors_count = totalErrors;
+size_t base64DecodedLength(size_t length) {
+  return (length / 4) * 3 + (length % 4 > 1 ? length % 4 - 1 : 0);
 }
 
-void resetEncodingStats() {
-    totalOperations = 0;
-    totalErrors = 0;
-    Serial.println("🔄 Encoding service statistics reset");
-}
\ No newline at end of file
+bool base64Encode(const uint8_t* data, size_t length, char* out, size_t outSize,
+                  size_t* outLength, uint8_t flags) {
+  if (outLength) *outLength = 0;
+  if (out == nullptr || (data == nullptr && length > 0) ||
+      outSize < base64EncodedLength(length, flags) + 1) {
+    return false;
+  }
+
+  Base64Stream stream;
+  base64StreamBegin(stream, flags);
+  size_t n = base64EncodeUpdate(stream, data, length, out);
+  n += base64EncodeFinish(stream, out + n);
+  out[n] = '\0';
+  if (outLength) *outLength = n;
+  return true;
+}
+
+bool base64Decode(const char* text, size_t length, uint8_t* out, size_t outSize,
+                  size_t* outLength, uint8_t flags) {
+  if (outLength) *outLength = 0;
+  if ((text == nullptr && length > 0) || (out == nullptr && outSize > 0)) return false;
+
+  Base64Stream stream;
+  base64StreamBegin(stream, flags);
+  size_t written = 0;
+  size_t tail = 0;
+  bool ok = base64DecodeUpdate(stream, text, length, out, outSize, &written) &&
+            base64DecodeFinish(stream, out + written, outSize - written, &tail);
+  if (ok && outLength) *outLength = written + tail;
+  return ok;
+}
+
+bool base64DecodeInPlace(char* text, size_t length, size_t* outLength, uint8_t flags) {
+  return base64Decode(text, length, (uint8_t*)text, length, outLength, flags);
+}
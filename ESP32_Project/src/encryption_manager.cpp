@@ -6,12 +6,12 @@ extern "C" {
 #include <mbedtls/gcm.h>
 #include <mbedtls/entropy.h>
 #include <mbedtls/ctr_drbg.h>
-#include <mbedtls/base64.h>  // mbedTLS base64 for secure encryption operations
 #include <mbedtls/md.h>
 #ifdef __cplusplus
 }
 #endif
 #include <Preferences.h>
+#include "encoding_service.h"
 
 // Forward declarations for used functions
 // mbedtls types forward declarations
@@ -184,8 +184,7 @@ String encryptData(const String& plaintext, const String& context) {
   
   // Base64 encode
   size_t totalLen = AES_IV_SIZE + inputLen + AES_TAG_SIZE;
-  size_t base64Len;
-  mbedtls_base64_encode(nullptr, 0, &base64Len, combined, totalLen);
+  size_t base64Len = base64EncodedLength(totalLen);
   
   char* base64Output = (char*)malloc(base64Len + 1);
   if (!base64Output) {
@@ -193,16 +192,12 @@ String encryptData(const String& plaintext, const String& context) {
     return "";
   }
   
-  ret = mbedtls_base64_encode((unsigned char*)base64Output, base64Len + 1, 
-                             &base64Len, combined, totalLen);
-  
-  if (ret != 0) {
-    Serial.printf("❌ Base64 encoding failed: -0x%04x\n", -ret);
+  if (!base64Encode(combined, totalLen, base64Output, base64Len + 1, &base64Len)) {
+    Serial.println("❌ Base64 encoding failed");
     free(base64Output);
     return "";
   }
   
-  base64Output[base64Len] = '\0';
   String result = String(base64Output);
   free(base64Output);
   
@@ -217,28 +212,16 @@ String decryptData(const String& ciphertext, const String& context) {
   }
   
   // Base64 decode
-  size_t decodedLen;
-  int ret = mbedtls_base64_decode(nullptr, 0, &decodedLen, 
-                                 (const unsigned char*)ciphertext.c_str(), 
-                                 ciphertext.length());
-  
-  if (ret != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL) {
-    Serial.println("❌ Base64 decode size calculation failed");
-    return "";
-  }
-  
+  size_t decodedLen = base64DecodedLength(ciphertext.length());
   uint8_t* decoded = (uint8_t*)malloc(decodedLen);
   if (!decoded) {
     Serial.println("❌ Failed to allocate decode buffer");
     return "";
   }
   
-  ret = mbedtls_base64_decode(decoded, decodedLen, &decodedLen,
-                             (const unsigned char*)ciphertext.c_str(),
-                             ciphertext.length());
-  
-  if (ret != 0) {
-    Serial.printf("❌ Base64 decode failed: -0x%04x\n", -ret);
+  if (!base64Decode(ciphertext.c_str(), ciphertext.length(), decoded, decodedLen, &decodedLen,
+                    BASE64_WHITESPACE)) {
+    Serial.println("❌ Base64 decode failed");
     free(decoded);
     return "";
   }
@@ -261,7 +244,7 @@ String decryptData(const String& ciphertext, const String& context) {
   mbedtls_gcm_context gcm;
   mbedtls_gcm_init(&gcm);
   
-  ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, storageKey, 256);
+  int ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, storageKey, 256);
   if (ret != 0) {
     Serial.printf("❌ Failed to set decryption key: -0x%04x\n", -ret);
     mbedtls_gcm_free(&gcm);
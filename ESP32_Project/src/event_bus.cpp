@@ -0,0 +1,269 @@
+#include "event_bus.h"
+#include "metrics_registry.h"
+#include <atomic>
+
+// =============================================================================
+// EVENT TYPES
+// =============================================================================
+
+struct EventTypeInfo {
+  const char* name;
+  EventPriority priority;
+  EventOverflowPolicy overflow;
+  bool carriesFrame;
+};
+
+// Indexed by EventType. Connection state keeps the latest transitions; a
+// pending refresh request makes a second one redundant; audio favours fresh
+// chunks so a stalled consumer does not add latency once it catches up;
+// anomaly findings are advisory and only the latest ones matter.
+static const EventTypeInfo eventTypes[EVENT_TYPE_COUNT] = {
+  {"ws_connected",          EVENT_PRIORITY_HIGH,   EVENT_DROP_OLDEST, false},
+  {"ws_disconnected",       EVENT_PRIORITY_HIGH,   EVENT_DROP_OLDEST, false},
+  {"auth_refresh_request",  EVENT_PRIORITY_HIGH,   EVENT_DROP_NEWEST, false},
+  {"audio_chunk",           EVENT_PRIORITY_NORMAL, EVENT_DROP_OLDEST, true},
+  {"health_anomaly",        EVENT_PRIORITY_LOW,    EVENT_DROP_OLDEST, false},
+};
+
+static const uint8_t queueDepths[EVENT_PRIORITY_COUNT] = {
+  EVENT_QUEUE_DEPTH_HIGH, EVENT_QUEUE_DEPTH_NORMAL, EVENT_QUEUE_DEPTH_LOW
+};
+
+// =============================================================================
+// SUBSCRIBER TABLE
+// =============================================================================
+
+struct Subscriber {
+  const char* name;
+  QueueHandle_t queues[EVENT_PRIORITY_COUNT];
+  EventHandler handlers[EVENT_TYPE_COUNT];
+  std::atomic<uint32_t> dropped;
+};
+
+static Subscriber subscribers[EVENT_MAX_SUBSCRIBERS];
+static std::atomic<uint8_t> subscriberCount(0);
+
+static std::atomic<uint32_t> statPublished(0);
+static std::atomic<uint32_t> statUnrouted(0);
+
+static MetricId metricPublished = METRIC_INVALID;
+static MetricId metricDropped = METRIC_INVALID;
+static MetricId metricDispatchLatency = METRIC_INVALID;
+
+bool initEventBus() {
+  metricPublished = registerCounter("bus.published");
+  metricDropped = registerCounter("bus.dropped");
+  metricDispatchLatency = registerHistogram("bus.dispatch_latency", "us");
+
+  Serial.printf("✅ Event bus ready (%u subscribers max, %u-byte events)\n",
+                EVENT_MAX_SUBSCRIBERS, (unsigned)sizeof(Event));
+  return true;
+}
+
+EventSubscriberId registerEventSubscriber(const char* name) {
+  uint8_t index = subscriberCount.load();
+  if (index >= EVENT_MAX_SUBSCRIBERS) {
+    Serial.printf("❌ Event bus full, cannot register %s\n", name);
+    return EVENT_SUBSCRIBER_INVALID;
+  }
+
+  Subscriber& s = subscribers[index];
+  s.name = name;
+  for (uint8_t p = 0; p < EVENT_PRIORITY_COUNT; p++) {
+    s.queues[p] = xQueueCreate(queueDepths[p], sizeof(Event));
+    if (s.queues[p] == nullptr) {
+      Serial.printf("❌ Failed to create event queues for %s\n", name);
+      for (uint8_t q = 0; q < p; q++) {
+        vQueueDelete(s.queues[q]);
+        s.queues[q] = nullptr;
+      }
+      return EVENT_SUBSCRIBER_INVALID;
+    }
+  }
+  for (uint8_t t = 0; t < EVENT_TYPE_COUNT; t++) {
+    s.handlers[t] = nullptr;
+  }
+  s.dropped.store(0);
+
+  // Publish the slot only once it is complete
+  subscriberCount.store(index + 1);
+  return (EventSubscriberId)index;
+}
+
+bool subscribeEvent(EventSubscriberId subscriber, EventType type, EventHandler handler) {
+  if (subscriber < 0 || subscriber >= subscriberCount.load() || type >= EVENT_TYPE_COUNT) {
+    return false;
+  }
+  subscribers[subscriber].handlers[type] = handler;
+  return true;
+}
+
+// =============================================================================
+// PUBLISHING
+// =============================================================================
+
+static void releaseEventFrame(Event& event) {
+  if (eventTypes[event.type].carriesFrame) {
+    AudioFrame::adopt(event.frame).release();
+    event.frame = nullptr;
+  }
+}
+
+static void noteDropped(Subscriber& s) {
+  s.dropped++;
+  metricIncrement(metricDropped);
+}
+
+// Queue one copy of the event, applying the type's overflow policy
+static bool enqueue(Subscriber& s, Event& event) {
+  const EventTypeInfo& info = eventTypes[event.type];
+  QueueHandle_t queue = s.queues[info.priority];
+
+  if (xQueueSend(queue, &event, 0) == pdTRUE) {
+    return true;
+  }
+
+  if (info.overflow == EVENT_DROP_OLDEST) {
+    Event oldest;
+    if (xQueueReceive(queue, &oldest, 0) == pdTRUE) {
+      releaseEventFrame(oldest);
+      noteDropped(s);
+    }
+    if (xQueueSend(queue, &event, 0) == pdTRUE) {
+      return true;
+    }
+  }
+
+  releaseEventFrame(event);
+  noteDropped(s);
+  return false;
+}
+
+// Fan the event out to every subscriber with a handler for its type. Frame
+// events take one share per subscriber; the publisher's handle is untouched.
+static bool publish(Event& event, const AudioFrame* frame) {
+  event.publishedUs = micros();
+  statPublished++;
+  metricIncrement(metricPublished);
+
+  bool accepted = false;
+  bool routed = false;
+  uint8_t count = subscriberCount.load();
+  for (uint8_t i = 0; i < count; i++) {
+    Subscriber& s = subscribers[i];
+    if (s.handlers[event.type] == nullptr) continue;
+    routed = true;
+
+    if (frame != nullptr) {
+      AudioFrame share(*frame);
+      event.frame = share.detach();
+    }
+    if (enqueue(s, event)) {
+      accepted = true;
+    }
+  }
+
+  if (!routed) {
+    statUnrouted++;
+  }
+  return accepted;
+}
+
+bool publishEvent(EventType type) {
+  if (type >= EVENT_TYPE_COUNT || eventTypes[type].carriesFrame) return false;
+  Event event;
+  event.type = type;
+  event.flags = 0;
+  event.text[0] = '\0';
+  return publish(event, nullptr);
+}
+
+bool publishEvent(EventType type, const char* text) {
+  if (type >= EVENT_TYPE_COUNT || eventTypes[type].carriesFrame) return false;
+  Event event;
+  event.type = type;
+  event.flags = 0;
+  strlcpy(event.text, text ? text : "", sizeof(event.text));
+  return publish(event, nullptr);
+}
+
+bool publishEvent(EventType type, const AnomalyPayload& anomaly) {
+  if (type >= EVENT_TYPE_COUNT || eventTypes[type].carriesFrame) return false;
+  Event event;
+  event.type = type;
+  event.flags = 0;
+  event.anomaly = anomaly;
+  return publish(event, nullptr);
+}
+
+bool publishEvent(EventType type, const AudioFrame& frame, uint8_t flags) {
+  if (type >= EVENT_TYPE_COUNT || !eventTypes[type].carriesFrame || !frame) return false;
+  Event event;
+  event.type = type;
+  event.flags = flags;
+  event.frame = nullptr;
+  return publish(event, &frame);
+}
+
+// =============================================================================
+// DELIVERY
+// =============================================================================
+
+uint8_t dispatchEvents(EventSubscriberId subscriber, uint8_t maxEvents) {
+  if (subscriber < 0 || subscriber >= subscriberCount.load()) {
+    return 0;
+  }
+
+  Subscriber& s = subscribers[subscriber];
+  uint8_t handled = 0;
+  Event event;
+
+  // Strict priority: a lower queue is only read while the higher ones are empty
+  while (handled < maxEvents) {
+    bool received = false;
+    for (uint8_t p = 0; p < EVENT_PRIORITY_COUNT && !received; p++) {
+      received = xQueueReceive(s.queues[p], &event, 0) == pdTRUE;
+    }
+    if (!received) break;
+
+    metricObserve(metricDispatchLatency, (uint32_t)(micros() - event.publishedUs));
+
+    EventHandler handler = s.handlers[event.type];
+    if (handler) {
+      handler(event);
+    }
+    releaseEventFrame(event);
+    handled++;
+  }
+  return handled;
+}
+
+AudioFrame eventFrame(const Event& event) {
+  if (event.type >= EVENT_TYPE_COUNT || !eventTypes[event.type].carriesFrame) {
+    return AudioFrame();
+  }
+  // Borrow the event's reference just long enough to copy it
+  AudioFrame borrowed = AudioFrame::adopt(event.frame);
+  AudioFrame share(borrowed);
+  borrowed.detach();
+  return share;
+}
+
+const char* getEventTypeName(EventType type) {
+  return type < EVENT_TYPE_COUNT ? eventTypes[type].name : "unknown";
+}
+
+void printEventBusStats() {
+  Serial.println("=== 📬 Event Bus ===");
+  Serial.printf("  Published: %u, unrouted: %u\n", statPublished.load(), statUnrouted.load());
+  uint8_t count = subscriberCount.load();
+  for (uint8_t i = 0; i < count; i++) {
+    Subscriber& s = subscribers[i];
+    Serial.printf("  %-12s pending: %u/%u/%u, dropped: %u\n", s.name,
+                  (unsigned)uxQueueMessagesWaiting(s.queues[EVENT_PRIORITY_HIGH]),
+                  (unsigned)uxQueueMessagesWaiting(s.queues[EVENT_PRIORITY_NORMAL]),
+                  (unsigned)uxQueueMessagesWaiting(s.queues[EVENT_PRIORITY_LOW]),
+                  s.dropped.load());
+  }
+  Serial.println("====================");
+}
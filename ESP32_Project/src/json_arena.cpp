@@ -0,0 +1,299 @@
+#include "json_arena.h"
+#include <esp_heap_caps.h>
+
+// Every block carries its size so deallocate/reallocate need no lookup
+#define JSON_ARENA_ALIGN   sizeof(void*)
+#define JSON_ARENA_HEADER  JSON_ARENA_ALIGN
+
+struct JsonArena {
+  TaskHandle_t owner;
+  uint8_t* base;
+  size_t capacity;
+  size_t top;
+  size_t peak;          // Highest top within the current scope
+  size_t overflow;      // Bytes that went to the heap within the current scope
+  uint16_t depth;       // Nested scopes on the owner task (0 = idle)
+  uint16_t live;        // Arena blocks not yet deallocated
+};
+
+// arenaMux guards slot binding, every arena's top/live (a document may be
+// freed by another task after its scope ended) and arenaStats
+static JsonArena arenas[JSON_ARENA_SLOTS];
+static portMUX_TYPE arenaMux = portMUX_INITIALIZER_UNLOCKED;
+static JsonArenaStats arenaStats = {};
+
+// Learned document bytes beyond the message length (tree nodes, copied keys)
+static size_t learnedOverhead = 512;
+
+static inline size_t alignUp(size_t n) {
+  return (n + JSON_ARENA_ALIGN - 1) & ~(JSON_ARENA_ALIGN - 1);
+}
+
+static inline size_t& blockSize(void* ptr) {
+  return *(size_t*)((uint8_t*)ptr - JSON_ARENA_HEADER);
+}
+
+// Arena bound to the calling task, if a scope is active on it
+static JsonArena* currentArena() {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  for (int i = 0; i < JSON_ARENA_SLOTS; i++) {
+    if (arenas[i].owner == self && arenas[i].depth > 0) {
+      return arenas[i].base ? &arenas[i] : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+static JsonArena* arenaOwning(void* ptr) {
+  for (int i = 0; i < JSON_ARENA_SLOTS; i++) {
+    JsonArena& a = arenas[i];
+    if (a.base && (uint8_t*)ptr >= a.base && (uint8_t*)ptr < a.base + a.capacity) {
+      return &a;
+    }
+  }
+  return nullptr;
+}
+
+// =============================================================================
+// ALLOCATOR
+// =============================================================================
+
+void* JsonArenaAllocator::allocate(size_t size) {
+  JsonArena* arena = currentArena();
+  size_t need = JSON_ARENA_HEADER + alignUp(size);
+  uint8_t* block = nullptr;
+
+  portENTER_CRITICAL(&arenaMux);
+  if (arena != nullptr && arena->top + need <= arena->capacity) {
+    block = arena->base + arena->top + JSON_ARENA_HEADER;
+    arena->top += need;
+    arena->live++;
+    if (arena->top > arena->peak) arena->peak = arena->top;
+    blockSize(block) = alignUp(size);
+    arenaStats.arenaAllocs++;
+  } else {
+    if (arena != nullptr) {
+      arena->overflow += need;
+    }
+    arenaStats.heapFallbacks++;
+  }
+  portEXIT_CRITICAL(&arenaMux);
+
+  return block != nullptr ? block : malloc(size);
+}
+
+void JsonArenaAllocator::deallocate(void* ptr) {
+  if (ptr == nullptr) return;
+
+  JsonArena* arena = arenaOwning(ptr);
+  if (arena == nullptr) {
+    free(ptr);
+    return;
+  }
+
+  // The most recent block is popped; others are reclaimed when the scope
+  // ends, or when the last one goes if a document outlived its scope
+  uint8_t* header = (uint8_t*)ptr - JSON_ARENA_HEADER;
+  portENTER_CRITICAL(&arenaMux);
+  if ((uint8_t*)ptr + blockSize(ptr) == arena->base + arena->top) {
+    arena->top = header - arena->base;
+  }
+  if (--arena->live == 0) {
+    arena->top = 0;
+    if (arena->depth == 0) arena->peak = 0;
+  }
+  portEXIT_CRITICAL(&arenaMux);
+}
+
+void* JsonArenaAllocator::reallocate(void* ptr, size_t newSize) {
+  if (ptr == nullptr) return allocate(newSize);
+
+  JsonArena* arena = arenaOwning(ptr);
+  if (arena == nullptr) {
+    return realloc(ptr, newSize);
+  }
+
+  // Top block resizes in place (shrinkToFit is the common caller)
+  size_t oldSize = blockSize(ptr);
+  size_t offset = (uint8_t*)ptr - arena->base;
+  bool resized = false;
+  portENTER_CRITICAL(&arenaMux);
+  if (offset + oldSize == arena->top && offset + alignUp(newSize) <= arena->capacity) {
+    blockSize(ptr) = alignUp(newSize);
+    arena->top = offset + alignUp(newSize);
+    if (arena->top > arena->peak) arena->peak = arena->top;
+    resized = true;
+  }
+  portEXIT_CRITICAL(&arenaMux);
+  if (resized) return ptr;
+
+  void* moved = allocate(newSize);
+  if (moved != nullptr) {
+    memcpy(moved, ptr, min(oldSize, newSize));
+    deallocate(ptr);
+  }
+  return moved;
+}
+
+// =============================================================================
+// SCOPES
+// =============================================================================
+
+JsonArenaScope::JsonArenaScope() : slot(-1) {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+  portENTER_CRITICAL(&arenaMux);
+  for (int i = 0; i < JSON_ARENA_SLOTS; i++) {
+    if (arenas[i].owner == self && arenas[i].depth > 0) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot < 0) {
+    // Prefer this task's previous arena, then any idle one
+    for (int i = 0; i < JSON_ARENA_SLOTS && slot < 0; i++) {
+      if (arenas[i].owner == self && arenas[i].depth == 0) slot = i;
+    }
+    for (int i = 0; i < JSON_ARENA_SLOTS && slot < 0; i++) {
+      if (arenas[i].depth == 0 && arenas[i].live == 0) slot = i;
+    }
+    if (slot >= 0) {
+      arenas[slot].owner = self;
+    }
+  }
+  if (slot >= 0) {
+    arenas[slot].depth++;
+  }
+  portEXIT_CRITICAL(&arenaMux);
+
+  if (slot < 0) return;  // All arenas busy: documents use the heap
+
+  JsonArena& arena = arenas[slot];
+  if (arena.base == nullptr && arena.depth == 1) {
+    if (arena.capacity == 0) arena.capacity = JSON_ARENA_INITIAL_SIZE;
+    arena.base = (uint8_t*)heap_caps_malloc(arena.capacity, MALLOC_CAP_8BIT);
+    if (arena.base != nullptr) {
+      portENTER_CRITICAL(&arenaMux);
+      arenaStats.reservedBytes += arena.capacity;
+      portEXIT_CRITICAL(&arenaMux);
+    }
+  }
+}
+
+JsonArenaScope::~JsonArenaScope() {
+  if (slot < 0) return;
+  JsonArena& arena = arenas[slot];
+
+  portENTER_CRITICAL(&arenaMux);
+  if (arena.depth > 1) {
+    arena.depth--;
+    portEXIT_CRITICAL(&arenaMux);
+    return;
+  }
+  size_t demand = arena.peak + arena.overflow;
+  uint16_t live = arena.live;
+  arenaStats.scopes++;
+  if (demand > arenaStats.peakUsage) arenaStats.peakUsage = demand;
+  portEXIT_CRITICAL(&arenaMux);
+
+  if (live > 0) {
+    // A document outlived its scope; the arena resets when it is freed
+    Serial.printf("⚠️ JSON arena %d closed with %u live blocks\n", slot, live);
+  } else if (arena.overflow > 0 && arena.capacity < JSON_ARENA_MAX_SIZE) {
+    size_t grown = min(alignUp(demand + demand / 4), (size_t)JSON_ARENA_MAX_SIZE);
+    uint8_t* larger = (uint8_t*)heap_caps_malloc(grown, MALLOC_CAP_8BIT);
+    if (larger != nullptr) {
+      heap_caps_free(arena.base);
+      portENTER_CRITICAL(&arenaMux);
+      arenaStats.reservedBytes += grown - arena.capacity;
+      arenaStats.resizes++;
+      portEXIT_CRITICAL(&arenaMux);
+      arena.base = larger;
+      arena.capacity = grown;
+    }
+  }
+
+  portENTER_CRITICAL(&arenaMux);
+  if (arena.live == 0) arena.top = 0;
+  arena.peak = arena.top;
+  arena.overflow = 0;
+  arena.depth = 0;
+  portEXIT_CRITICAL(&arenaMux);
+}
+
+// =============================================================================
+// CAPACITY LEARNING
+// =============================================================================
+
+// Strings are copied at most once, so a document needs the message length
+// plus an overhead that depends on the message shape rather than its size
+size_t estimateJsonCapacity(size_t inputLength) {
+  size_t estimate = inputLength + learnedOverhead + JSON_CAPACITY_SLACK;
+  return estimate < JSON_CAPACITY_MIN ? JSON_CAPACITY_MIN : estimate;
+}
+
+void recordJsonUsage(size_t inputLength, size_t memoryUsage) {
+  size_t observed = memoryUsage > inputLength ? memoryUsage - inputLength : 0;
+  // Jump up immediately, decay slowly so one flat message does not undersize the next
+  if (observed > learnedOverhead) {
+    learnedOverhead = observed;
+  } else {
+    learnedOverhead = (learnedOverhead * 15 + observed) / 16;
+  }
+}
+
+// =============================================================================
+// RELEASE
+// =============================================================================
+
+size_t releaseIdleJsonArenas() {
+  size_t released = 0;
+  for (int i = 0; i < JSON_ARENA_SLOTS; i++) {
+    uint8_t* base = nullptr;
+    size_t capacity = 0;
+
+    // Claiming under the lock keeps a scope from binding the arena mid-release
+    portENTER_CRITICAL(&arenaMux);
+    JsonArena& a = arenas[i];
+    if (a.base != nullptr && a.depth == 0 && a.live == 0) {
+      base = a.base;
+      capacity = a.capacity;
+      a.base = nullptr;
+      a.capacity = 0;
+      a.top = 0;
+      a.peak = 0;
+    }
+    portEXIT_CRITICAL(&arenaMux);
+
+    if (base != nullptr) {
+      heap_caps_free(base);
+      portENTER_CRITICAL(&arenaMux);
+      arenaStats.reservedBytes -= capacity;
+      portEXIT_CRITICAL(&arenaMux);
+      released += capacity;
+    }
+  }
+  return released;
+}
+
+JsonArenaStats getJsonArenaStats() {
+  portENTER_CRITICAL(&arenaMux);
+  JsonArenaStats snapshot = arenaStats;
+  portEXIT_CRITICAL(&arenaMux);
+  return snapshot;
+}
+
+void printJsonArenaStats() {
+  JsonArenaStats stats = getJsonArenaStats();
+  Serial.println("=== 🧩 JSON Arenas ===");
+  Serial.printf("  Scopes: %u, arena allocs: %u, heap fallbacks: %u, resizes: %u\n",
+                stats.scopes, stats.arenaAllocs, stats.heapFallbacks, stats.resizes);
+  Serial.printf("  Peak demand: %u bytes, reserved: %u bytes, learned overhead: %u bytes\n",
+                (unsigned)stats.peakUsage, (unsigned)stats.reservedBytes, (unsigned)learnedOverhead);
+  for (int i = 0; i < JSON_ARENA_SLOTS; i++) {
+    const JsonArena& a = arenas[i];
+    if (a.base == nullptr) continue;
+    Serial.printf("  [%d] %5u bytes%s\n", i, (unsigned)a.capacity, a.depth ? " (in use)" : "");
+  }
+  Serial.println("======================");
+}
@@ -22,13 +22,14 @@
 #include "device_id_manager.h"
 #include "test_config.h"
 #include "claim_flow.h"  // For secure generateNonce()
+#include "event_bus.h"  // Refresh requests go to the WebSocket task
+#include "stack_monitor.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_system.h"
 #include "esp_mac.h"
 #include "nvs_flash.h"
 #include "nvs.h"
-#include "mbedtls/base64.h"
 #include "mbedtls/sha256.h"
 #include "mbedtls/md.h"
 #include <HTTPClient.h>
@@ -59,6 +60,8 @@ JWTManager::JWTManager() :
     tokenExpiry(0),
     autoRefreshEnabled(true),
     refreshInProgress(false),
+    refreshAwaitingResponse(false),
+    refreshConfirmed(false),
     retryCount(0),
     lastRefreshAttempt(0),
     totalRefreshes(0),
@@ -689,7 +692,11 @@ bool JWTManager::refreshToken() {
     // Generate proof for refresh (using last 8 characters of current token)
     String proof = currentToken.substring(currentToken.length() - 8);
 
-    // Send refresh request via WebSocket (if callback is set)
+    // Send refresh request via WebSocket: an explicit callback wins, otherwise
+    // the request is published and sent from the WebSocket task. Armed before
+    // sending so a fast response is not missed.
+    refreshConfirmed = false;
+    refreshAwaitingResponse = true;
     if (refreshCallback) {
         // Create refresh request
         DynamicJsonDocument refreshDoc(512);
@@ -702,19 +709,23 @@ bool JWTManager::refreshToken() {
         ESP_LOGI(TAG, "Sending WebSocket auth refresh request");
         success = refreshCallback(refreshMessage);
     } else {
-        ESP_LOGW(TAG, "No refresh callback set, cannot refresh token");
-        success = false;
+        ESP_LOGI(TAG, "Publishing WebSocket auth refresh request");
+        success = publishEvent(EVENT_AUTH_REFRESH_REQUEST, proof.c_str());
+        if (!success) {
+            ESP_LOGW(TAG, "No WebSocket subscriber for refresh request");
+        }
     }
 
     refreshInProgress = false;
     lastRefreshAttempt = getCurrentTimestamp();
 
+    // Only auth/ok (handleRefreshResponse) resets the retry count
+    retryCount++;
     if (!success) {
-        retryCount++;
-        ESP_LOGE(TAG, "Token refresh failed (attempt %d)", retryCount);
+        refreshAwaitingResponse = false;
+        ESP_LOGE(TAG, "Token refresh request failed (attempt %d)", retryCount);
     } else {
-        retryCount = 0;
-        ESP_LOGI(TAG, "Token refresh successful");
+        ESP_LOGI(TAG, "Token refresh requested (attempt %d), awaiting auth response", retryCount);
     }
 
     xSemaphoreGive(mutex);
@@ -741,30 +752,43 @@ bool JWTManager::handleRefreshResponse(const String& response) {
     String type = responseDoc["type"].as<String>();
     
     if (type == "auth/ok") {
-        uint32_t expiresInSec = responseDoc["exp_in_sec"].as<uint32_t>();
-        
-        // Update token expiry (token itself doesn't change in refresh)
-        tokenExpiry = getCurrentTimestamp() + expiresInSec;
-        
-        // Save updated expiry to NVS
-        esp_err_t ret = nvs_set_u32(nvsHandle, JWT_EXPIRY_KEY, tokenExpiry);
-        if (ret == ESP_OK) {
-            ret = nvs_commit(nvsHandle);
-        }
-        
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to save updated token expiry: %s", esp_err_to_name(ret));
+        // Without exp_in_sec the server accepted the token as it is
+        if (responseDoc.containsKey("exp_in_sec")) {
+            uint32_t expiresInSec = responseDoc["exp_in_sec"].as<uint32_t>();
+
+            // Update token expiry (token itself doesn't change in refresh)
+            tokenExpiry = getCurrentTimestamp() + expiresInSec;
+
+            // Save updated expiry to NVS
+            esp_err_t ret = nvs_set_u32(nvsHandle, JWT_EXPIRY_KEY, tokenExpiry);
+            if (ret == ESP_OK) {
+                ret = nvs_commit(nvsHandle);
+            }
+
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to save updated token expiry: %s", esp_err_to_name(ret));
+            }
+
+            // Schedule next auto-refresh
+            scheduleAutoRefresh();
+            ESP_LOGI(TAG, "Token refresh successful, expires in %u seconds", (unsigned)expiresInSec);
+        } else {
+            ESP_LOGI(TAG, "Token confirmed, expiry unchanged");
         }
 
-        // Schedule next auto-refresh
-        scheduleAutoRefresh();
-        
-        ESP_LOGI(TAG, "Token refresh successful, expires in %d seconds", expiresInSec);
+        if (refreshAwaitingResponse) {
+            totalRefreshes++;
+        }
+        retryCount = 0;
+        refreshConfirmed = true;
+        refreshAwaitingResponse = false;
         return true;
         
     } else if (type == "auth/error") {
+        // Counted as a failed refresh by waitForRefreshResponse()
         String reason = responseDoc["reason"].as<String>();
         ESP_LOGE(TAG, "Token refresh failed: %s", reason.c_str());
+        refreshAwaitingResponse = false;
         
         // Clear invalid token
         clearToken();
@@ -775,6 +799,37 @@ bool JWTManager::handleRefreshResponse(const String& response) {
     return false;
 }
 
+/*
+ * The WebSocket task dropped a published refresh request (socket down)
+ */
+void JWTManager::noteRefreshSendFailed() {
+    if (refreshAwaitingResponse) {
+        ESP_LOGW(TAG, "Refresh request was not sent");
+        refreshAwaitingResponse = false;
+    }
+}
+
+/*
+ * Wait until the auth response arrives, the request is reported unsent, or
+ * JWT_REFRESH_RESPONSE_MS passes; true only for auth/ok. The one place a
+ * failed refresh is counted.
+ */
+bool JWTManager::waitForRefreshResponse() {
+    uint32_t waited = 0;
+    while (refreshAwaitingResponse && waited < JWT_REFRESH_RESPONSE_MS) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+        waited += 100;
+    }
+    if (refreshAwaitingResponse) {
+        ESP_LOGW(TAG, "No auth response to refresh request after %u ms", (unsigned)waited);
+        refreshAwaitingResponse = false;
+    }
+    if (!refreshConfirmed) {
+        failedRefreshes++;
+    }
+    return refreshConfirmed;
+}
+
 /*
  * Check if current token is valid
  */
@@ -966,7 +1021,7 @@ void JWTManager::scheduleAutoRefresh() {
     if (refreshTime <= currentTime) {
         // If less than buffer time remaining, refresh immediately
         ESP_LOGI(TAG, "Token expires soon, refreshing immediately");
-        xTaskCreate(refreshTokenTask, "jwt_refresh", 4096, this, 5, &refreshTaskHandle);
+        startRefreshTask(this);
         return;
     }
 
@@ -1328,8 +1383,22 @@ void JWTManager::autoRefreshTimerCallback(void* arg) {
     if (jwt && jwt->autoRefreshEnabled) {
         ESP_LOGI(TAG, "Auto-refresh timer triggered");
         
-        // Create refresh task
-        xTaskCreate(refreshTokenTask, "jwt_refresh", 4096, jwt, 5, &refreshTaskHandle);
+        startRefreshTask(jwt);
+    }
+}
+
+/*
+ * Start the refresh task unless one is running; a refresh confirmed from
+ * inside that task reschedules through here and must not start a second one
+ */
+void JWTManager::startRefreshTask(JWTManager* jwt) {
+    if (refreshTaskHandle != nullptr) {
+        ESP_LOGI(TAG, "Refresh task already running");
+        return;
+    }
+    if (xTaskCreate(refreshTokenTask, "jwt_refresh", JWT_REFRESH_TASK_STACK, jwt, 5, &refreshTaskHandle) != pdPASS) {
+        refreshTaskHandle = nullptr;
+        ESP_LOGE(TAG, "Failed to create refresh task");
     }
 }
 
@@ -1338,9 +1407,10 @@ void JWTManager::autoRefreshTimerCallback(void* arg) {
  */
 void JWTManager::refreshTokenTask(void* parameter) {
     JWTManager* jwt = static_cast<JWTManager*>(parameter);
+    registerCurrentTaskStack("jwt_refresh", JWT_REFRESH_TASK_STACK);
     
     if (jwt) {
-        bool success = jwt->refreshToken();
+        bool success = jwt->refreshToken() && jwt->waitForRefreshResponse();
         
         if (!success && jwt->retryCount < JWT_MAX_RETRY_COUNT) {
             // Schedule retry with exponential backoff
@@ -1348,11 +1418,14 @@ void JWTManager::refreshTokenTask(void* parameter) {
             vTaskDelay(pdMS_TO_TICKS(delay));
             
             // Try again
-            jwt->refreshToken();
+            if (jwt->refreshToken()) {
+                jwt->waitForRefreshResponse();
+            }
         }
     }
     
     // Clean up task
+    noteTaskStackExit();
     refreshTaskHandle = nullptr;
     vTaskDelete(nullptr);
 }
@@ -1388,6 +1461,7 @@ void JWTManager::cleanup() {
     }
     
     if (refreshTaskHandle) {
+        forgetTaskStack(refreshTaskHandle);
         vTaskDelete(refreshTaskHandle);
         refreshTaskHandle = nullptr;
     }
@@ -20,6 +20,12 @@ Production-ready ESP32 with full management features
 #include "device_id_manager.h"  // for getCurrentDeviceId()
 #include "system_monitor.h"
 #include "comprehensive_logging.h"  // Comprehensive logging system
+#include "metrics_registry.h"
+#include "event_bus.h"
+#include "alloc_guard.h"
+#include "stack_monitor.h"
+#include "task_stats.h"
+#include "perf_console.h"
 #include "esp_heap_caps.h"
 #include "esp_task_wdt.h"
 #include <Preferences.h>
@@ -46,6 +52,23 @@ unsigned long lastHeartbeat = 0;
 unsigned long lastButtonPress = 0;
 unsigned long lastSystemCheck = 0;
 
+// Production loop handlers, each timed into its own histogram
+struct LoopHandler {
+  const char* metricName;
+  void (*handler)();
+  MetricId metric;
+};
+
+static LoopHandler productionHandlers[] = {
+  {"loop.wifi_manager",   handleWiFiManager,      METRIC_INVALID},
+  {"loop.ota",            handleOTA,              METRIC_INVALID},
+  {"loop.monitoring",     handleMonitoring,       METRIC_INVALID},
+  {"loop.security",       checkSecurityHealth,    METRIC_INVALID},
+  {"loop.device_mgmt",    handleDeviceManagement, METRIC_INVALID},
+  {"loop.websocket",      handleWebSocketLoop,    METRIC_INVALID},
+};
+static MetricId metricSystemChecks = METRIC_INVALID;
+
 void setup() {
   Serial.begin(115200);
   delay(50);
@@ -80,6 +103,8 @@ void setup() {
 }
 
 void loop() {
+  uint32_t loopStartUs = micros();
+  
   // Feed WDT regularly in main loop
   esp_task_wdt_reset();
   
@@ -89,6 +114,9 @@ void loop() {
   // Handle button with debouncing
   handleButton();
   
+  // Serial performance console (debug builds; compiles to nothing otherwise)
+  handlePerfConsole();
+  
   // Handle WiFi management and internet monitoring
   handleInternetDisconnection();
   
@@ -97,7 +125,10 @@ void loop() {
   
   // Perform periodic system checks
   if (millis() - lastSystemCheck > SYSTEM_CHECK_INTERVAL) {
-    performStartupChecks();
+    {
+      MetricTimer checkTimer(metricSystemChecks);
+      performStartupChecks();
+    }
     lastSystemCheck = millis();
     
     // Print heap status during system check
@@ -114,6 +145,9 @@ void loop() {
   
   // Update LEDs - FastLED removed for I2S compatibility
   
+  // Loop busy time excludes the idle delay below
+  recordLoopIteration(micros() - loopStartUs);
+  
   // Feed WDT before delay
   esp_task_wdt_reset();
   delay(10);
@@ -151,6 +185,15 @@ void initProductionSystems() {
   if (!initMonitoring()) {
     Serial.println("❌ Failed to initialize monitoring system");
   }
+  initEventBus();
+  initAllocGuard();
+  initStackMonitor();
+  registerCurrentTaskStack("loopTask", getArduinoLoopTaskStackSize());
+  for (LoopHandler& h : productionHandlers) {
+    h.metric = registerHistogram(h.metricName, "us");
+  }
+  metricSystemChecks = registerHistogram("loop.system_checks", "us");
+  initPerfConsole();
   
   // Initialize security system
   if (!initSecurity()) {
@@ -237,15 +280,11 @@ void initProductionSystems() {
 }
 
 void handleProductionLoop() {
-  // Handle all production systems
-  handleWiFiManager();
-  handleOTA();
-  handleMonitoring();
-  checkSecurityHealth();
-  handleDeviceManagement();
-  
-  // Handle WebSocket (loop + reconnection policy)
-  handleWebSocketLoop();
+  // Handle all production systems; WebSocket (loop + reconnection policy) runs last
+  for (LoopHandler& h : productionHandlers) {
+    MetricTimer handlerTimer(h.metric);
+    h.handler();
+  }
 }
 
 void performStartupChecks() {
@@ -0,0 +1,376 @@
+#include "memory_budget.h"
+#include "metrics_registry.h"
+#include "monitoring.h"
+#include "json_arena.h"
+#include "resource_manager.h"
+#include "realtime_audio_streamer.h"
+#include "audio_handler.h"
+#include "websocket_handler.h"
+#include "wifi_portal.h"
+#include "system_monitor.h"
+#include <WiFi.h>
+
+// =============================================================================
+// DEGRADATION STEPS
+// =============================================================================
+
+// shed() returns the bytes it freed, 0 for a throttle that took effect, or
+// SHED_NO_EFFECT when nothing changed (the step is retried on the next
+// round). restore() returns false to stay shed.
+#define SHED_NO_EFFECT (-1)
+
+struct LadderStep {
+  const char* name;
+  long (*shed)();
+  bool (*restore)();
+  bool active;
+};
+
+static long shedFlushCaches() {
+  size_t released = releaseIdleJsonArenas();
+  return released > 0 ? (long)released : SHED_NO_EFFECT;
+}
+
+static bool restoreFlushCaches() {
+  return true;  // Arenas are re-reserved on demand
+}
+
+static bool telemetryShed = false;
+
+static long shedPauseTelemetry() {
+  if (telemetryShed) return SHED_NO_EFFECT;
+  setTelemetryPaused(true);
+  telemetryShed = true;
+  return 0;
+}
+
+static bool restorePauseTelemetry() {
+  setTelemetryPaused(false);
+  telemetryShed = false;
+  return true;
+}
+
+// Chunk sizes in effect before the cap, put back on restore
+static size_t savedCaptureChunk = 0;
+static size_t savedWsChunk = 0;
+
+static long shedCapAudioChunks() {
+  size_t capture = getCaptureChunkSize();
+  size_t ws = getAdaptiveChunkSize();
+  if (capture <= MEM_BUDGET_CAPTURE_CHUNK && ws <= MEM_BUDGET_CAPTURE_CHUNK) {
+    return SHED_NO_EFFECT;
+  }
+  savedCaptureChunk = capture;
+  savedWsChunk = ws;
+  setCaptureChunkSize(min(capture, (size_t)MEM_BUDGET_CAPTURE_CHUNK));
+  setAdaptiveChunkSize(min(ws, (size_t)MEM_BUDGET_CAPTURE_CHUNK));
+  return 0;
+}
+
+static bool restoreCapAudioChunks() {
+  if (savedCaptureChunk > 0) setCaptureChunkSize(savedCaptureChunk);
+  if (savedWsChunk > 0) setAdaptiveChunkSize(savedWsChunk);
+  return true;
+}
+
+static long shedShrinkAudioBuffer() {
+  size_t before = getAudioBufferSize();
+  if (before <= MEM_BUDGET_AUDIO_BUFFER_MIN || !setAudioBufferSize(MEM_BUDGET_AUDIO_BUFFER_MIN)) {
+    return SHED_NO_EFFECT;
+  }
+  return (long)(before - getAudioBufferSize());
+}
+
+static bool restoreShrinkAudioBuffer() {
+  return setAudioBufferSize(AUDIO_BUFFER_BYTES);
+}
+
+// Only a portal left open after WiFi connected; closing one mid-setup would
+// strand the device
+static long shedClosePortal() {
+  if (!isPortalActive() || WiFi.status() != WL_CONNECTED) {
+    return SHED_NO_EFFECT;
+  }
+  size_t before = ESP.getFreeHeap();
+  stopWiFiPortal();
+  size_t after = ESP.getFreeHeap();
+  return after > before ? (long)(after - before) : SHED_NO_EFFECT;
+}
+
+static bool restoreClosePortal() {
+  return true;  // Not reopened; the setup flow starts it when needed
+}
+
+// Shed in index order, restored in reverse
+static LadderStep ladder[DEGRADE_STEP_COUNT] = {
+  {"flush_caches",        shedFlushCaches,       restoreFlushCaches,       false},
+  {"pause_telemetry",     shedPauseTelemetry,    restorePauseTelemetry,    false},
+  {"cap_audio_chunks",    shedCapAudioChunks,    restoreCapAudioChunks,    false},
+  {"shrink_audio_buffer", shedShrinkAudioBuffer, restoreShrinkAudioBuffer, false},
+  {"close_portal",        shedClosePortal,       restoreClosePortal,       false},
+};
+
+// =============================================================================
+// SUBSYSTEM BUDGETS
+// =============================================================================
+
+struct SubsystemBudget {
+  const char* name;
+  size_t limit;
+  size_t (*usage)();
+  DegradationStep step;   // Shed when the subsystem is over budget
+};
+
+static size_t jsonArenaUsage() {
+  return getJsonArenaStats().reservedBytes;
+}
+
+static size_t audioTrackedUsage() {
+  return getTrackedBytesForSite("audio_buffer");
+}
+
+static const SubsystemBudget budgets[] = {
+  {"json_arenas", MEM_BUDGET_JSON_ARENAS,   jsonArenaUsage,    DEGRADE_FLUSH_CACHES},
+  {"audio",       MEM_BUDGET_AUDIO_TRACKED, audioTrackedUsage, DEGRADE_SHRINK_AUDIO_BUFFER},
+};
+static const size_t BUDGET_COUNT = sizeof(budgets) / sizeof(budgets[0]);
+
+// =============================================================================
+// STATE
+// =============================================================================
+
+static bool budgetInitialized = false;
+static MemoryPressure pressure = MEM_PRESSURE_NONE;
+static uint8_t degradationLevel = 0;
+static unsigned long lastCheck = 0;
+static unsigned long lastShed = 0;
+static unsigned long healthySince = 0;
+static unsigned long exhaustedSince = 0;
+static bool restartDeferredLogged = false;
+
+static MetricId metricPressure = METRIC_INVALID;
+static MetricId metricLevel = METRIC_INVALID;
+static MetricId metricStepsShed = METRIC_INVALID;
+static MetricId metricStepsRestored = METRIC_INVALID;
+
+static const char* pressureName(MemoryPressure p) {
+  switch (p) {
+    case MEM_PRESSURE_NONE:     return "none";
+    case MEM_PRESSURE_ELEVATED: return "elevated";
+    case MEM_PRESSURE_CRITICAL: return "critical";
+    default:                    return "unknown";
+  }
+}
+
+// Leaving a pressure state needs MEM_BUDGET_RECOVER_MARGIN of headroom so a
+// heap hovering at a threshold does not flap between shed and restore
+static MemoryPressure classifyPressure(size_t freeHeap, size_t largestBlock) {
+  if (freeHeap < MEM_BUDGET_FREE_CRITICAL || largestBlock < MEM_BUDGET_LARGEST_CRITICAL) {
+    return MEM_PRESSURE_CRITICAL;
+  }
+  if (freeHeap < MEM_BUDGET_FREE_WARN || largestBlock < MEM_BUDGET_LARGEST_WARN) {
+    return MEM_PRESSURE_ELEVATED;
+  }
+  if (pressure != MEM_PRESSURE_NONE &&
+      (freeHeap < MEM_BUDGET_FREE_WARN + MEM_BUDGET_RECOVER_MARGIN ||
+       largestBlock < MEM_BUDGET_LARGEST_WARN + MEM_BUDGET_RECOVER_MARGIN / 4)) {
+    return MEM_PRESSURE_ELEVATED;
+  }
+  return MEM_PRESSURE_NONE;
+}
+
+static bool shedStep(int index, const char* reason) {
+  LadderStep& step = ladder[index];
+  if (step.active) return true;
+  long freed = step.shed();
+  if (freed == SHED_NO_EFFECT) return false;
+
+  step.active = true;
+  degradationLevel++;
+  metricIncrement(metricStepsShed);
+  metricSetGauge(metricLevel, degradationLevel);
+  if (freed > 0) {
+    Serial.printf("📉 Memory budget: shed %s (%s, level %u), freed %ld bytes\n",
+                  step.name, reason, degradationLevel, freed);
+  } else {
+    Serial.printf("📉 Memory budget: shed %s (%s, level %u), limits new allocations\n",
+                  step.name, reason, degradationLevel);
+  }
+  return true;
+}
+
+// Shed the first step in ladder order that takes effect
+static bool shedNextStep(const char* reason) {
+  for (int i = 0; i < DEGRADE_STEP_COUNT; i++) {
+    if (!ladder[i].active && shedStep(i, reason)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool isOverBudget(DegradationStep step) {
+  for (size_t i = 0; i < BUDGET_COUNT; i++) {
+    if (budgets[i].step == step && budgets[i].usage() > budgets[i].limit) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Restore the most recently ordered active step whose subsystem fits its budget
+static void restoreLastStep() {
+  for (int i = DEGRADE_STEP_COUNT - 1; i >= 0; i--) {
+    LadderStep& step = ladder[i];
+    if (!step.active || isOverBudget((DegradationStep)i)) continue;
+    if (!step.restore()) return;  // Retry after the next hold period
+
+    step.active = false;
+    degradationLevel--;
+    metricIncrement(metricStepsRestored);
+    metricSetGauge(metricLevel, degradationLevel);
+    Serial.printf("📈 Memory budget: restored %s (level %u)\n", step.name, degradationLevel);
+    return;
+  }
+}
+
+// A subsystem that grows back past its budget while its step is shed has the
+// step re-applied (e.g. arenas re-reserved after a flush)
+static void checkSubsystemBudgets() {
+  for (size_t i = 0; i < BUDGET_COUNT; i++) {
+    const SubsystemBudget& b = budgets[i];
+    size_t used = b.usage();
+    if (used <= b.limit) continue;
+
+    if (ladder[b.step].active) {
+      long freed = ladder[b.step].shed();
+      if (freed > 0) {
+        Serial.printf("📉 Memory budget: re-shed %s, freed %ld bytes\n", ladder[b.step].name, freed);
+      }
+    } else if (shedStep(b.step, b.name)) {
+      Serial.printf("⚠️ %s over budget: %u / %u bytes\n", b.name, (unsigned)used, (unsigned)b.limit);
+    }
+  }
+}
+
+static bool isConversationActive() {
+  return getAudioState() != AUDIO_IDLE || isRealtimeStreaming();
+}
+
+// Last rung: every step is shed (or cannot be) and the heap stays exhausted
+static void checkRestart(size_t freeHeap, unsigned long now, bool ladderExhausted) {
+  if (!ladderExhausted || freeHeap >= MEM_BUDGET_RESTART_FREE) {
+    exhaustedSince = 0;
+    restartDeferredLogged = false;
+    return;
+  }
+
+  if (exhaustedSince == 0) {
+    exhaustedSince = now;
+    Serial.printf("🚨 Memory budget exhausted: %u bytes free, nothing left to shed\n", (unsigned)freeHeap);
+  }
+  if (now - exhaustedSince < MEM_BUDGET_RESTART_GRACE) return;
+
+  if (isConversationActive() && freeHeap >= MEM_BUDGET_HARD_FLOOR) {
+    if (!restartDeferredLogged) {
+      Serial.println("⏳ Restart deferred until the conversation ends");
+      restartDeferredLogged = true;
+    }
+    return;
+  }
+
+  triggerSystemRecovery("Memory budget exhausted");
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+bool initMemoryBudget() {
+  if (budgetInitialized) return true;
+
+  metricPressure = registerGauge("mem.pressure");
+  metricLevel = registerGauge("mem.degradation_level");
+  metricStepsShed = registerCounter("mem.steps_shed");
+  metricStepsRestored = registerCounter("mem.steps_restored");
+
+  budgetInitialized = true;
+  Serial.printf("✅ Memory budget: warn <%u KB free / <%u KB block, critical <%u KB / <%u KB\n",
+                MEM_BUDGET_FREE_WARN / 1024, MEM_BUDGET_LARGEST_WARN / 1024,
+                MEM_BUDGET_FREE_CRITICAL / 1024, MEM_BUDGET_LARGEST_CRITICAL / 1024);
+  return true;
+}
+
+void handleMemoryBudget() {
+  if (!budgetInitialized) return;
+
+  unsigned long now = millis();
+  if (now - lastCheck < MEM_BUDGET_CHECK_INTERVAL) return;
+  lastCheck = now;
+
+  evaluateMemoryBudget(ESP.getFreeHeap(), ESP.getMaxAllocHeap(), now);
+}
+
+void evaluateMemoryBudget(size_t freeHeap, size_t largestBlock, unsigned long now) {
+  MemoryPressure next = classifyPressure(freeHeap, largestBlock);
+  if (next != pressure) {
+    Serial.printf("💾 Memory pressure %s -> %s (free %u, largest %u)\n",
+                  pressureName(pressure), pressureName(next),
+                  (unsigned)freeHeap, (unsigned)largestBlock);
+    pressure = next;
+    metricSetGauge(metricPressure, (int32_t)pressure);
+  }
+
+  checkSubsystemBudgets();
+
+  if (pressure == MEM_PRESSURE_NONE) {
+    if (healthySince == 0) healthySince = now;
+    if (degradationLevel > 0 && now - healthySince >= MEM_BUDGET_RESTORE_HOLD) {
+      restoreLastStep();
+      healthySince = now;  // One step per hold period
+    }
+    checkRestart(freeHeap, now, false);
+    return;
+  }
+
+  healthySince = 0;
+  bool ladderExhausted = false;
+  unsigned long interval = pressure == MEM_PRESSURE_CRITICAL ? 0 : MEM_BUDGET_STEP_INTERVAL;
+  if (lastShed == 0 || now - lastShed >= interval) {
+    if (shedNextStep(pressureName(pressure))) {
+      lastShed = now;
+    } else {
+      ladderExhausted = true;
+    }
+  }
+  checkRestart(freeHeap, now, ladderExhausted);
+}
+
+MemoryPressure getMemoryPressure() {
+  return pressure;
+}
+
+uint8_t getDegradationLevel() {
+  return degradationLevel;
+}
+
+bool isDegradationStepActive(DegradationStep step) {
+  return step < DEGRADE_STEP_COUNT && ladder[step].active;
+}
+
+const char* getDegradationStepName(DegradationStep step) {
+  return step < DEGRADE_STEP_COUNT ? ladder[step].name : "unknown";
+}
+
+void printMemoryBudget() {
+  Serial.println("=== 💾 Memory Budget ===");
+  Serial.printf("  Pressure: %s, level %u/%d\n", pressureName(pressure), degradationLevel, DEGRADE_STEP_COUNT);
+  for (int i = 0; i < DEGRADE_STEP_COUNT; i++) {
+    Serial.printf("  %d. %-20s %s\n", i + 1, ladder[i].name, ladder[i].active ? "SHED" : "-");
+  }
+  for (size_t i = 0; i < BUDGET_COUNT; i++) {
+    Serial.printf("  Budget %-12s %6u / %6u bytes\n", budgets[i].name,
+                  (unsigned)budgets[i].usage(), (unsigned)budgets[i].limit);
+  }
+  Serial.println("========================");
+}
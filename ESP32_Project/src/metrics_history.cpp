@@ -0,0 +1,519 @@
+#include "metrics_history.h"
+#include "metrics_registry.h"
+#include "task_stats.h"
+#include "time_sync.h"
+#include "websocket_handler.h"
+#include "json_arena.h"
+#include <Preferences.h>
+#include <WiFi.h>
+
+// Everything here runs on the loop task (monitoring, WebSocket and web
+// server handlers), so the archives need no lock.
+
+struct SeriesInfo {
+  const char* name;
+  const char* unit;
+  uint8_t scale;      // Stored value = units / scale
+  bool lowIsWorse;    // Which extreme a consolidated point keeps
+  bool sparse;        // Event-driven: empty seconds do not make a minute unknown
+};
+
+static const SeriesInfo SERIES[HISTORY_SERIES_COUNT] = {
+  {"heap.free",          "bytes", 16, true,  false},
+  {"heap.largest_block", "bytes", 16, true,  false},
+  {"wifi.rssi",          "dBm",   1,  true,  false},
+  {"ws.rtt.p50",         "ms",    1,  false, true},
+  {"ws.rtt.p99",         "ms",    1,  false, true},
+  {"audio.latency.p50",  "ms",    1,  false, true},
+  {"audio.latency.p99",  "ms",    1,  false, true},
+  {"cpu.total",          "%",     1,  false, false},
+};
+
+static const char* const RESOLUTION_NAMES[HISTORY_RES_COUNT] = {"second", "minute", "hour"};
+static const uint32_t RESOLUTION_STEP_S[HISTORY_RES_COUNT] = {1, 60, 3600};
+
+#define HISTORY_MAGIC         0x31445252   // "RRD1"
+#define HISTORY_NVS_KEY       "rrd"
+
+// Persisted part: the minute and hour archives
+struct HistoryStore {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t seriesCount;
+  uint16_t minutesIntoHour;     // Minutes pushed since the last hour point
+  uint32_t newestMinuteEpoch;   // Wall clock of the newest minute, 0 if unsynced
+  uint16_t minuteHead;          // Next slot to write
+  uint16_t minuteCount;
+  uint16_t hourHead;
+  uint16_t hourCount;
+  HistoryPoint minutes[HISTORY_MINUTES][HISTORY_SERIES_COUNT];
+  HistoryPoint hours[HISTORY_HOURS][HISTORY_SERIES_COUNT];
+};
+
+static_assert(HISTORY_SECONDS >= 60 && HISTORY_MINUTES >= 60, "archives must hold a full minute and hour");
+// NVS (20 KB) is shared with config, JWT and connection stats
+static_assert(sizeof(HistoryStore) <= 4096, "metrics history too large for NVS");
+
+static HistoryStore store;
+static int16_t seconds[HISTORY_SECONDS][HISTORY_SERIES_COUNT];
+static uint16_t secondHead = 0;
+static uint16_t secondCount = 0;
+static uint16_t secondsIntoMinute = 0;
+
+static MetricId rttHist = METRIC_INVALID;
+static MetricId audioLatencyHist = METRIC_INVALID;
+static HistogramWindow rttWindow;
+static HistogramWindow audioLatencyWindow;
+
+static bool historyInitialized = false;
+static bool restoredFromNvs = false;   // Offline gap not yet accounted for
+static unsigned long nextSampleMs = 0;
+static unsigned long lastPersist = 0;
+static bool persistPending = false;    // An hour point closed since the last save
+static uint32_t savedChecksum = 0;     // Of the store as last loaded or saved
+
+// =============================================================================
+// CONSOLIDATION
+// =============================================================================
+
+// Average of the known inputs plus their worst; unknown when too few are known
+struct Consolidator {
+  int32_t sum;
+  uint16_t known;
+  uint16_t total;
+  int16_t worst;
+  bool lowIsWorse;
+  uint8_t minKnownPercent;
+
+  explicit Consolidator(const SeriesInfo& info)
+    : sum(0), known(0), total(0), worst(HISTORY_UNKNOWN), lowIsWorse(info.lowIsWorse),
+      minKnownPercent(info.sparse ? 0 : HISTORY_MIN_KNOWN_PERCENT) {}
+
+  void add(int16_t avg, int16_t worstValue) {
+    total++;
+    if (avg == HISTORY_UNKNOWN) return;
+    sum += avg;
+    known++;
+    if (worst == HISTORY_UNKNOWN || (lowIsWorse ? worstValue < worst : worstValue > worst)) {
+      worst = worstValue;
+    }
+  }
+
+  HistoryPoint result() const {
+    if (known == 0 || (uint32_t)known * 100 < (uint32_t)total * minKnownPercent) {
+      return {HISTORY_UNKNOWN, HISTORY_UNKNOWN};
+    }
+    int32_t half = known / 2;
+    int32_t avg = sum >= 0 ? (sum + half) / known : -((-sum + half) / known);
+    return {(int16_t)avg, worst};
+  }
+};
+
+static inline uint16_t ringSlot(uint16_t head, uint16_t count, uint16_t capacity, uint16_t index) {
+  return (uint16_t)((head + capacity - count + index) % capacity);
+}
+
+static void fillUnknown(HistoryPoint (&row)[HISTORY_SERIES_COUNT]) {
+  for (uint8_t s = 0; s < HISTORY_SERIES_COUNT; s++) {
+    row[s] = {HISTORY_UNKNOWN, HISTORY_UNKNOWN};
+  }
+}
+
+static void pushHour(const HistoryPoint (&row)[HISTORY_SERIES_COUNT]) {
+  memcpy(store.hours[store.hourHead], row, sizeof(row));
+  store.hourHead = (store.hourHead + 1) % HISTORY_HOURS;
+  if (store.hourCount < HISTORY_HOURS) store.hourCount++;
+}
+
+// The hour just finished is the newest 60 minutes
+static void closeHour() {
+  HistoryPoint hour[HISTORY_SERIES_COUNT];
+  for (uint8_t s = 0; s < HISTORY_SERIES_COUNT; s++) {
+    Consolidator c(SERIES[s]);
+    for (uint16_t k = 0; k < 60; k++) {
+      if (k < store.minuteCount) {
+        uint16_t slot = (store.minuteHead + HISTORY_MINUTES - 1 - k) % HISTORY_MINUTES;
+        c.add(store.minutes[slot][s].avg, store.minutes[slot][s].worst);
+      } else {
+        c.add(HISTORY_UNKNOWN, HISTORY_UNKNOWN);
+      }
+    }
+    hour[s] = c.result();
+  }
+  pushHour(hour);
+  persistPending = true;
+}
+
+static void pushMinute(const HistoryPoint (&row)[HISTORY_SERIES_COUNT]) {
+  memcpy(store.minutes[store.minuteHead], row, sizeof(row));
+  store.minuteHead = (store.minuteHead + 1) % HISTORY_MINUTES;
+  if (store.minuteCount < HISTORY_MINUTES) store.minuteCount++;
+  if (++store.minutesIntoHour >= 60) {
+    store.minutesIntoHour = 0;
+    closeHour();
+  }
+}
+
+// Restored archives end where the device went off. If the clock is synced by
+// the first minute of this boot the offline minutes are filled in; otherwise
+// a single unknown minute marks the reboot.
+static void accountForOfflineGap() {
+  restoredFromNvs = false;
+  HistoryPoint unknown[HISTORY_SERIES_COUNT];
+  fillUnknown(unknown);
+
+  uint32_t gap = 1;
+  if (isTimeSynced() && store.newestMinuteEpoch != 0) {
+    uint32_t now = (uint32_t)getCurrentTimestamp();
+    gap = now > store.newestMinuteEpoch ? (now - store.newestMinuteEpoch) / 60 : 0;
+    gap = gap > 0 ? gap - 1 : 0;   // The minute closing now is not part of it
+    if (gap > HISTORY_MAX_GAP_MINUTES) gap = HISTORY_MAX_GAP_MINUTES;
+  }
+  for (uint32_t i = 0; i < gap; i++) {
+    pushMinute(unknown);
+  }
+  if (gap > 0) {
+    Serial.printf("📉 History: %u offline minute(s) marked unknown\n", gap);
+  }
+}
+
+// The minute just finished is the newest 60 seconds
+static void closeMinute() {
+  HistoryPoint minute[HISTORY_SERIES_COUNT];
+  for (uint8_t s = 0; s < HISTORY_SERIES_COUNT; s++) {
+    Consolidator c(SERIES[s]);
+    for (uint16_t k = 0; k < 60; k++) {
+      if (k < secondCount) {
+        int16_t v = seconds[(secondHead + HISTORY_SECONDS - 1 - k) % HISTORY_SECONDS][s];
+        c.add(v, v);
+      } else {
+        c.add(HISTORY_UNKNOWN, HISTORY_UNKNOWN);
+      }
+    }
+    minute[s] = c.result();
+  }
+
+  if (restoredFromNvs) {
+    accountForOfflineGap();
+  }
+  pushMinute(minute);
+  store.newestMinuteEpoch = isTimeSynced() ? (uint32_t)getCurrentTimestamp() : 0;
+}
+
+static void pushSecond(const int16_t (&row)[HISTORY_SERIES_COUNT]) {
+  memcpy(seconds[secondHead], row, sizeof(row));
+  secondHead = (secondHead + 1) % HISTORY_SECONDS;
+  if (secondCount < HISTORY_SECONDS) secondCount++;
+  if (++secondsIntoMinute >= 60) {
+    secondsIntoMinute = 0;
+    closeMinute();
+  }
+}
+
+// =============================================================================
+// SAMPLING
+// =============================================================================
+
+static int16_t toStored(HistorySeries series, int32_t units) {
+  int32_t v = units / SERIES[series].scale;
+  if (v > INT16_MAX) v = INT16_MAX;
+  if (v <= HISTORY_UNKNOWN) v = HISTORY_UNKNOWN + 1;
+  return (int16_t)v;
+}
+
+// p50/p99 of the observations since the previous second
+static bool windowPercentiles(MetricId& id, const char* name, HistogramWindow& window, uint32_t* results) {
+  static const float kPercentiles[] = {50.0f, 99.0f};
+  if (id == METRIC_INVALID) {
+    id = findMetric(METRIC_HISTOGRAM, name);
+    if (id == METRIC_INVALID) return false;
+    getHistogramWindow(id, window, nullptr, nullptr, 0);  // Window starts now, not at boot
+  }
+  return getHistogramWindow(id, window, kPercentiles, results, 2) > 0;
+}
+
+static void sampleSecond(int16_t (&row)[HISTORY_SERIES_COUNT]) {
+  row[HISTORY_HEAP_FREE] = toStored(HISTORY_HEAP_FREE, (int32_t)ESP.getFreeHeap());
+  row[HISTORY_HEAP_LARGEST] = toStored(HISTORY_HEAP_LARGEST, (int32_t)ESP.getMaxAllocHeap());
+  row[HISTORY_WIFI_RSSI] = WiFi.status() == WL_CONNECTED
+                         ? toStored(HISTORY_WIFI_RSSI, WiFi.RSSI()) : HISTORY_UNKNOWN;
+
+  uint32_t p[2];
+  bool known = windowPercentiles(rttHist, "ws.rtt", rttWindow, p);
+  row[HISTORY_WS_RTT_P50] = known ? toStored(HISTORY_WS_RTT_P50, (int32_t)p[0]) : HISTORY_UNKNOWN;
+  row[HISTORY_WS_RTT_P99] = known ? toStored(HISTORY_WS_RTT_P99, (int32_t)p[1]) : HISTORY_UNKNOWN;
+  known = windowPercentiles(audioLatencyHist, "audio.latency", audioLatencyWindow, p);
+  row[HISTORY_AUDIO_LATENCY_P50] = known ? toStored(HISTORY_AUDIO_LATENCY_P50, (int32_t)p[0]) : HISTORY_UNKNOWN;
+  row[HISTORY_AUDIO_LATENCY_P99] = known ? toStored(HISTORY_AUDIO_LATENCY_P99, (int32_t)p[1]) : HISTORY_UNKNOWN;
+
+  row[HISTORY_CPU] = toStored(HISTORY_CPU, (int32_t)lroundf(getTotalCpuPercent()));
+}
+
+// =============================================================================
+// PERSISTENCE
+// =============================================================================
+
+static void resetStore() {
+  memset(&store, 0, sizeof(store));
+  store.magic = HISTORY_MAGIC;
+  store.version = HISTORY_FORMAT_VERSION;
+  store.seriesCount = HISTORY_SERIES_COUNT;
+}
+
+// FNV-1a over the whole store, to skip saves that would write the same blob
+static uint32_t storeChecksum() {
+  const uint8_t* bytes = (const uint8_t*)&store;
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < sizeof(store); i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static bool loadHistory() {
+  Preferences prefs;
+  if (!prefs.begin(HISTORY_NVS_NAMESPACE, true)) {
+    resetStore();   // Nothing saved yet
+    return false;
+  }
+  bool loaded = prefs.getBytesLength(HISTORY_NVS_KEY) == sizeof(store) &&
+                prefs.getBytes(HISTORY_NVS_KEY, &store, sizeof(store)) == sizeof(store);
+  prefs.end();
+
+  bool valid = loaded && store.magic == HISTORY_MAGIC &&
+               store.version == HISTORY_FORMAT_VERSION &&
+               store.seriesCount == HISTORY_SERIES_COUNT &&
+               store.minuteHead < HISTORY_MINUTES && store.minuteCount <= HISTORY_MINUTES &&
+               store.hourHead < HISTORY_HOURS && store.hourCount <= HISTORY_HOURS &&
+               store.minutesIntoHour < 60;
+  if (!valid) {
+    if (loaded) {
+      Serial.println("⚠️ History: saved archives unreadable, starting empty");
+    }
+    resetStore();
+  }
+  savedChecksum = valid ? storeChecksum() : 0;
+  return valid;
+}
+
+bool saveMetricsHistory() {
+  if (!historyInitialized) return false;
+
+  persistPending = false;
+  uint32_t checksum = storeChecksum();
+  if (checksum == savedChecksum) {
+    return true;   // NVS already holds this blob
+  }
+
+  Preferences prefs;
+  if (!prefs.begin(HISTORY_NVS_NAMESPACE, false)) {
+    Serial.println("❌ History: failed to open NVS");
+    return false;
+  }
+  size_t written = prefs.putBytes(HISTORY_NVS_KEY, &store, sizeof(store));
+  prefs.end();
+  lastPersist = millis();
+  if (written != sizeof(store)) {
+    return false;
+  }
+  savedChecksum = checksum;
+  return true;
+}
+
+// =============================================================================
+// LIFECYCLE
+// =============================================================================
+
+bool initMetricsHistory() {
+  if (historyInitialized) {
+    return true;
+  }
+
+  restoredFromNvs = loadHistory();
+  nextSampleMs = millis() + 1000;
+  lastPersist = millis();
+  historyInitialized = true;
+
+  Serial.printf("📉 Metrics history ready (%us / %umin / %uh, %u bytes)%s\n",
+                HISTORY_SECONDS, HISTORY_MINUTES, HISTORY_HOURS,
+                (unsigned)(sizeof(store) + sizeof(seconds)),
+                restoredFromNvs ? ", restored from NVS" : "");
+  return true;
+}
+
+void handleMetricsHistory() {
+  if (!historyInitialized) return;
+
+  unsigned long now = millis();
+  if ((long)(now - nextSampleMs) < 0) return;
+
+  // Seconds the loop was blocked are unknown, not interpolated
+  uint32_t missed = (now - nextSampleMs) / 1000;
+  if (missed > HISTORY_SECONDS * 60) missed = HISTORY_SECONDS * 60;
+  int16_t row[HISTORY_SERIES_COUNT];
+  for (uint8_t s = 0; s < HISTORY_SERIES_COUNT; s++) row[s] = HISTORY_UNKNOWN;
+  for (uint32_t i = 0; i < missed; i++) {
+    pushSecond(row);
+  }
+
+  sampleSecond(row);
+  pushSecond(row);
+  nextSampleMs = now - (now - nextSampleMs) % 1000 + 1000;
+
+  if (persistPending) {
+    saveMetricsHistory();
+  }
+}
+
+// =============================================================================
+// QUERIES
+// =============================================================================
+
+uint16_t getHistoryPointCount(HistoryResolution res) {
+  switch (res) {
+    case HISTORY_RES_SECOND: return secondCount;
+    case HISTORY_RES_MINUTE: return store.minuteCount;
+    case HISTORY_RES_HOUR:   return store.hourCount;
+    default:                 return 0;
+  }
+}
+
+bool getHistoryPoint(HistoryResolution res, HistorySeries series, uint16_t index, HistoryPoint& out) {
+  if (series >= HISTORY_SERIES_COUNT || index >= getHistoryPointCount(res)) {
+    return false;
+  }
+  switch (res) {
+    case HISTORY_RES_SECOND: {
+      int16_t v = seconds[ringSlot(secondHead, secondCount, HISTORY_SECONDS, index)][series];
+      out = {v, v};
+      return true;
+    }
+    case HISTORY_RES_MINUTE:
+      out = store.minutes[ringSlot(store.minuteHead, store.minuteCount, HISTORY_MINUTES, index)][series];
+      return true;
+    case HISTORY_RES_HOUR:
+      out = store.hours[ringSlot(store.hourHead, store.hourCount, HISTORY_HOURS, index)][series];
+      return true;
+    default:
+      return false;
+  }
+}
+
+int32_t historyToUnits(HistorySeries series, int16_t stored) {
+  return (int32_t)stored * SERIES[series].scale;
+}
+
+int findHistorySeries(const char* name) {
+  if (name == nullptr) return -1;
+  for (uint8_t s = 0; s < HISTORY_SERIES_COUNT; s++) {
+    if (strcmp(SERIES[s].name, name) == 0) return s;
+  }
+  return -1;
+}
+
+int findHistoryResolution(const char* name) {
+  if (name == nullptr) return -1;
+  for (uint8_t r = 0; r < HISTORY_RES_COUNT; r++) {
+    if (strcmp(RESOLUTION_NAMES[r], name) == 0) return r;
+  }
+  return -1;
+}
+
+const char* getHistorySeriesName(HistorySeries series) {
+  return series < HISTORY_SERIES_COUNT ? SERIES[series].name : "";
+}
+
+// =============================================================================
+// EXPORT
+// =============================================================================
+
+static void addValue(JsonArray& array, HistorySeries series, int16_t stored) {
+  if (stored == HISTORY_UNKNOWN) {
+    array.add(nullptr);
+  } else {
+    array.add(historyToUnits(series, stored));
+  }
+}
+
+// Oldest point first; unknown points are null
+void exportHistorySeries(JsonObject& out, HistoryResolution res, HistorySeries series) {
+  uint16_t count = getHistoryPointCount(res);
+  out["series"] = SERIES[series].name;
+  out["unit"] = SERIES[series].unit;
+  out["resolution"] = RESOLUTION_NAMES[res];
+  out["step_s"] = RESOLUTION_STEP_S[res];
+  out["uptime_s"] = millis() / 1000;
+  if (res != HISTORY_RES_SECOND && store.newestMinuteEpoch != 0) {
+    out["newest_minute_epoch"] = store.newestMinuteEpoch;
+  }
+
+  JsonArray avg = out.createNestedArray("avg");
+  JsonArray worst = res == HISTORY_RES_SECOND ? JsonArray() : out.createNestedArray("worst");
+  for (uint16_t i = 0; i < count; i++) {
+    HistoryPoint point = {HISTORY_UNKNOWN, HISTORY_UNKNOWN};
+    getHistoryPoint(res, series, i, point);
+    addValue(avg, series, point.avg);
+    if (!worst.isNull()) {
+      addValue(worst, series, point.worst);
+    }
+  }
+}
+
+// One message per series keeps each document small
+bool sendMetricsHistory(HistoryResolution res, int series) {
+  if (!isConnected || res >= HISTORY_RES_COUNT || series >= HISTORY_SERIES_COUNT) {
+    return false;
+  }
+
+  JsonArenaScope arena;
+  ArenaJsonDocument doc(HISTORY_JSON_CAPACITY);
+  String message;
+  bool sent = true;
+  uint8_t first = series < 0 ? 0 : (uint8_t)series;
+  uint8_t last = series < 0 ? HISTORY_SERIES_COUNT - 1 : (uint8_t)series;
+  for (uint8_t s = first; s <= last; s++) {
+    doc.clear();
+    doc["type"] = "metrics_history";
+    JsonObject data = doc.createNestedObject("data");
+    exportHistorySeries(data, res, (HistorySeries)s);
+    if (doc.overflowed()) {
+      Serial.printf("⚠️ History: %s export truncated\n", SERIES[s].name);
+    }
+    message = "";
+    serializeJson(doc, message);
+    sent = webSocket.sendTXT(message) && sent;
+  }
+  return sent;
+}
+
+static void printPoint(HistorySeries series, HistoryResolution res) {
+  uint16_t count = getHistoryPointCount(res);
+  HistoryPoint point;
+  if (count == 0 || !getHistoryPoint(res, series, count - 1, point) || point.avg == HISTORY_UNKNOWN) {
+    Serial.printf(" %9s %9s", "-", "-");
+    return;
+  }
+  Serial.printf(" %9d %9d", (int)historyToUnits(series, point.avg), (int)historyToUnits(series, point.worst));
+}
+
+void printMetricsHistory() {
+  Serial.println("=== 📉 Metrics History ===");
+  Serial.printf("  Points: %u s, %u min, %u h; %u bytes persisted, last save %lu s ago\n",
+                secondCount, store.minuteCount, store.hourCount, (unsigned)sizeof(store),
+                (millis() - lastPersist) / 1000);
+  Serial.println("  Series                 Now    MinAvg  MinWorst   HourAvg HourWorst");
+  for (uint8_t s = 0; s < HISTORY_SERIES_COUNT; s++) {
+    HistoryPoint now;
+    Serial.printf("  %-18s", SERIES[s].name);
+    if (secondCount > 0 && getHistoryPoint(HISTORY_RES_SECOND, (HistorySeries)s, secondCount - 1, now) &&
+        now.avg != HISTORY_UNKNOWN) {
+      Serial.printf(" %9d", (int)historyToUnits((HistorySeries)s, now.avg));
+    } else {
+      Serial.printf(" %9s", "-");
+    }
+    printPoint((HistorySeries)s, HISTORY_RES_MINUTE);
+    printPoint((HistorySeries)s, HISTORY_RES_HOUR);
+    Serial.println();
+  }
+  Serial.println("==========================");
+}
@@ -0,0 +1,505 @@
+#include "metrics_registry.h"
+#include <atomic>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Registry tables. Names and units must be string literals (never copied).
+struct CounterSlot {
+  const char* name;
+  const char* unit;
+  std::atomic<uint32_t> shards[METRICS_NUM_SHARDS];
+};
+
+struct GaugeSlot {
+  const char* name;
+  const char* unit;
+  std::atomic<int32_t> value;
+};
+
+struct HistogramShard {
+  std::atomic<uint32_t> count;
+  std::atomic<uint32_t> min;
+  std::atomic<uint32_t> max;
+  uint64_t sum;  // Only written by tasks on the owning core, under that core's mux
+  std::atomic<uint32_t>* buckets;
+};
+
+struct HistogramSlot {
+  const char* name;
+  const char* unit;
+  HistogramShard shards[METRICS_NUM_SHARDS];
+};
+
+static CounterSlot counters[METRICS_MAX_COUNTERS];
+static GaugeSlot gauges[METRICS_MAX_GAUGES];
+static HistogramSlot histograms[METRICS_MAX_HISTOGRAMS];
+static volatile uint16_t counterCount = 0;
+static volatile uint16_t gaugeCount = 0;
+static volatile uint16_t histogramCount = 0;
+
+// Registration runs rarely and may race between tasks; updates never take this lock
+static portMUX_TYPE registryMux = portMUX_INITIALIZER_UNLOCKED;
+// 64-bit sums cannot be updated atomically on Xtensa; one mux per core keeps them exact
+static portMUX_TYPE sumMux[METRICS_NUM_SHARDS] = {portMUX_INITIALIZER_UNLOCKED, portMUX_INITIALIZER_UNLOCKED};
+static bool registryInitialized = false;
+
+static inline uint8_t currentShard() {
+  return (uint8_t)(xPortGetCoreID() % METRICS_NUM_SHARDS);
+}
+
+// =============================================================================
+// BUCKET MATH
+// =============================================================================
+
+uint16_t histogramBucketIndex(uint32_t value) {
+  if (value < METRICS_HIST_SUB_COUNT) {
+    return (uint16_t)value;
+  }
+  uint32_t msb = 31 - __builtin_clz(value);
+  if (msb >= METRICS_HIST_MAX_BITS) {
+    return METRICS_HIST_BUCKETS - 1;
+  }
+  uint32_t shift = msb - METRICS_HIST_SUB_BITS;
+  uint32_t octave = msb - METRICS_HIST_SUB_BITS + 1;
+  return (uint16_t)(octave * METRICS_HIST_SUB_COUNT + ((value >> shift) & (METRICS_HIST_SUB_COUNT - 1)));
+}
+
+uint32_t histogramBucketLowerBound(uint16_t index) {
+  if (index < METRICS_HIST_SUB_COUNT) {
+    return index;
+  }
+  uint32_t octave = index / METRICS_HIST_SUB_COUNT;
+  uint32_t sub = index % METRICS_HIST_SUB_COUNT;
+  return (METRICS_HIST_SUB_COUNT + sub) << (octave - 1);
+}
+
+uint32_t histogramBucketUpperBound(uint16_t index) {
+  if (index >= METRICS_HIST_BUCKETS - 1) {
+    return UINT32_MAX;
+  }
+  if (index < METRICS_HIST_SUB_COUNT) {
+    return index;
+  }
+  uint32_t octave = index / METRICS_HIST_SUB_COUNT;
+  return histogramBucketLowerBound(index) + (1UL << (octave - 1)) - 1;
+}
+
+// =============================================================================
+// INITIALIZATION AND REGISTRATION
+// =============================================================================
+
+bool initMetricsRegistry() {
+  if (registryInitialized) {
+    return true;
+  }
+
+  registryInitialized = true;
+  Serial.printf("📈 Metrics registry ready (%d counters, %d gauges, %d histograms x %d buckets)\n",
+                METRICS_MAX_COUNTERS, METRICS_MAX_GAUGES, METRICS_MAX_HISTOGRAMS, METRICS_HIST_BUCKETS);
+  return true;
+}
+
+static void resetHistogramShard(HistogramShard& shard) {
+  shard.count.store(0, std::memory_order_relaxed);
+  shard.min.store(UINT32_MAX, std::memory_order_relaxed);
+  shard.max.store(0, std::memory_order_relaxed);
+  shard.sum = 0;
+  if (shard.buckets != nullptr) {
+    for (uint16_t b = 0; b < METRICS_HIST_BUCKETS; b++) {
+      shard.buckets[b].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+void resetMetricsRegistry() {
+  for (uint16_t i = 0; i < counterCount; i++) {
+    for (uint8_t s = 0; s < METRICS_NUM_SHARDS; s++) {
+      counters[i].shards[s].store(0, std::memory_order_relaxed);
+    }
+  }
+  for (uint16_t i = 0; i < histogramCount; i++) {
+    for (uint8_t s = 0; s < METRICS_NUM_SHARDS; s++) {
+      resetHistogramShard(histograms[i].shards[s]);
+    }
+  }
+  // Gauges describe current state and are intentionally kept
+}
+
+template <typename Slot>
+static MetricId findSlot(Slot* table, uint16_t count, const char* name) {
+  for (uint16_t i = 0; i < count; i++) {
+    if (strcmp(table[i].name, name) == 0) {
+      return (MetricId)i;
+    }
+  }
+  return METRIC_INVALID;
+}
+
+MetricId registerCounter(const char* name, const char* unit) {
+  if (name == nullptr) return METRIC_INVALID;
+
+  portENTER_CRITICAL(&registryMux);
+  MetricId id = findSlot(counters, counterCount, name);
+  if (id == METRIC_INVALID && counterCount < METRICS_MAX_COUNTERS) {
+    id = (MetricId)counterCount;
+    counters[id].name = name;
+    counters[id].unit = unit ? unit : "";
+    for (uint8_t s = 0; s < METRICS_NUM_SHARDS; s++) {
+      counters[id].shards[s].store(0, std::memory_order_relaxed);
+    }
+    counterCount++;
+  }
+  portEXIT_CRITICAL(&registryMux);
+
+  if (id == METRIC_INVALID) {
+    Serial.printf("⚠️ Metrics: counter table full, '%s' not registered\n", name);
+  }
+  return id;
+}
+
+MetricId registerGauge(const char* name, const char* unit) {
+  if (name == nullptr) return METRIC_INVALID;
+
+  portENTER_CRITICAL(&registryMux);
+  MetricId id = findSlot(gauges, gaugeCount, name);
+  if (id == METRIC_INVALID && gaugeCount < METRICS_MAX_GAUGES) {
+    id = (MetricId)gaugeCount;
+    gauges[id].name = name;
+    gauges[id].unit = unit ? unit : "";
+    gauges[id].value.store(0, std::memory_order_relaxed);
+    gaugeCount++;
+  }
+  portEXIT_CRITICAL(&registryMux);
+
+  if (id == METRIC_INVALID) {
+    Serial.printf("⚠️ Metrics: gauge table full, '%s' not registered\n", name);
+  }
+  return id;
+}
+
+MetricId registerHistogram(const char* name, const char* unit) {
+  if (name == nullptr) return METRIC_INVALID;
+
+  portENTER_CRITICAL(&registryMux);
+  MetricId existing = findSlot(histograms, histogramCount, name);
+  portEXIT_CRITICAL(&registryMux);
+  if (existing != METRIC_INVALID) {
+    return existing;
+  }
+
+  // Allocate bucket storage outside the critical section (heap may block)
+  size_t bytes = sizeof(std::atomic<uint32_t>) * METRICS_HIST_BUCKETS;
+  std::atomic<uint32_t>* storage[METRICS_NUM_SHARDS] = {};
+  for (uint8_t s = 0; s < METRICS_NUM_SHARDS; s++) {
+    storage[s] = (std::atomic<uint32_t>*)heap_caps_calloc(1, bytes, MALLOC_CAP_8BIT);
+    if (storage[s] == nullptr) {
+      for (uint8_t f = 0; f < s; f++) heap_caps_free(storage[f]);
+      Serial.printf("❌ Metrics: no memory for histogram '%s'\n", name);
+      return METRIC_INVALID;
+    }
+  }
+
+  portENTER_CRITICAL(&registryMux);
+  MetricId id = findSlot(histograms, histogramCount, name);
+  bool created = false;
+  if (id == METRIC_INVALID && histogramCount < METRICS_MAX_HISTOGRAMS) {
+    id = (MetricId)histogramCount;
+    histograms[id].name = name;
+    histograms[id].unit = unit ? unit : "";
+    for (uint8_t s = 0; s < METRICS_NUM_SHARDS; s++) {
+      histograms[id].shards[s].buckets = storage[s];
+      resetHistogramShard(histograms[id].shards[s]);
+    }
+    histogramCount++;
+    created = true;
+  }
+  portEXIT_CRITICAL(&registryMux);
+
+  if (!created) {
+    // Lost a registration race or the table is full
+    for (uint8_t s = 0; s < METRICS_NUM_SHARDS; s++) heap_caps_free(storage[s]);
+    if (id == METRIC_INVALID) {
+      Serial.printf("⚠️ Metrics: histogram table full, '%s' not registered\n", name);
+    }
+  }
+  return id;
+}
+
+// =============================================================================
+// HOT-PATH UPDATES
+// =============================================================================
+
+void metricIncrement(MetricId id, uint32_t delta) {
+  if (id < 0 || id >= (MetricId)counterCount) return;
+  counters[id].shards[currentShard()].fetch_add(delta, std::memory_order_relaxed);
+}
+
+void metricSetGauge(MetricId id, int32_t value) {
+  if (id < 0 || id >= (MetricId)gaugeCount) return;
+  gauges[id].value.store(value, std::memory_order_relaxed);
+}
+
+void metricAddGauge(MetricId id, int32_t delta) {
+  if (id < 0 || id >= (MetricId)gaugeCount) return;
+  gauges[id].value.fetch_add(delta, std::memory_order_relaxed);
+}
+
+static inline void atomicMin(std::atomic<uint32_t>& target, uint32_t value) {
+  uint32_t current = target.load(std::memory_order_relaxed);
+  while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+static inline void atomicMax(std::atomic<uint32_t>& target, uint32_t value) {
+  uint32_t current = target.load(std::memory_order_relaxed);
+  while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+void metricObserve(MetricId id, uint32_t value) {
+  if (id < 0 || id >= (MetricId)histogramCount) return;
+
+  uint8_t shardIndex = currentShard();
+  HistogramShard& shard = histograms[id].shards[shardIndex];
+  shard.buckets[histogramBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  atomicMin(shard.min, value);
+  atomicMax(shard.max, value);
+
+  portENTER_CRITICAL_SAFE(&sumMux[shardIndex]);
+  shard.sum += value;
+  portEXIT_CRITICAL_SAFE(&sumMux[shardIndex]);
+
+  // Count last so readers never see a count without its bucket
+  shard.count.fetch_add(1, std::memory_order_release);
+}
+
+// =============================================================================
+// READS AND SNAPSHOTS
+// =============================================================================
+
+uint32_t getCounterValue(MetricId id) {
+  if (id < 0 || id >= (MetricId)counterCount) return 0;
+  uint32_t total = 0;
+  for (uint8_t s = 0; s < METRICS_NUM_SHARDS; s++) {
+    total += counters[id].shards[s].load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+int32_t getGaugeValue(MetricId id) {
+  if (id < 0 || id >= (MetricId)gaugeCount) return 0;
+  return gauges[id].value.load(std::memory_order_relaxed);
+}
+
+// Representative value for a bucket: midpoint, clamped to the observed range
+static uint32_t bucketValue(uint16_t index, uint32_t minSeen, uint32_t maxSeen) {
+  uint32_t lower = histogramBucketLowerBound(index);
+  uint32_t upper = histogramBucketUpperBound(index);
+  uint32_t mid = (upper == UINT32_MAX) ? maxSeen : lower + (upper - lower) / 2;
+  if (mid < minSeen) mid = minSeen;
+  if (mid > maxSeen) mid = maxSeen;
+  return mid;
+}
+
+static inline uint32_t mergedBucket(MetricId id, uint16_t b) {
+  uint32_t inBucket = 0;
+  for (uint8_t s = 0; s < METRICS_NUM_SHARDS; s++) {
+    inBucket += histograms[id].shards[s].buckets[b].load(std::memory_order_relaxed);
+  }
+  return inBucket;
+}
+
+// Rank of the percentile, 1-based, rounded up (nearest-rank method)
+static inline uint64_t percentileRank(float percentile, uint32_t total) {
+  uint64_t rank = (uint64_t)ceilf(percentile / 100.0f * (float)total);
+  return rank == 0 ? 1 : rank;
+}
+
+// Walk merged buckets once and resolve several percentiles (ascending order)
+static void resolvePercentiles(MetricId id, uint32_t total, uint32_t minSeen, uint32_t maxSeen,
+                               const float* percentiles, uint32_t* results, uint8_t n) {
+  if (total == 0) {
+    for (uint8_t i = 0; i < n; i++) results[i] = 0;
+    return;
+  }
+
+  uint8_t next = 0;
+  uint64_t seen = 0;
+  for (uint16_t b = 0; b < METRICS_HIST_BUCKETS && next < n; b++) {
+    uint32_t inBucket = mergedBucket(id, b);
+    if (inBucket == 0) continue;
+    seen += inBucket;
+    while (next < n && seen >= percentileRank(percentiles[next], total)) {
+      results[next++] = bucketValue(b, minSeen, maxSeen);
+    }
+  }
+  while (next < n) {
+    results[next++] = maxSeen;
+  }
+}
+
+bool getHistogramSnapshot(MetricId id, HistogramSnapshot& out) {
+  memset(&out, 0, sizeof(out));
+  if (id < 0 || id >= (MetricId)histogramCount) return false;
+
+  uint32_t minSeen = UINT32_MAX;
+  for (uint8_t s = 0; s < METRICS_NUM_SHARDS; s++) {
+    HistogramShard& shard = histograms[id].shards[s];
+    out.count += shard.count.load(std::memory_order_acquire);
+    portENTER_CRITICAL(&sumMux[s]);
+    out.sum += shard.sum;
+    portEXIT_CRITICAL(&sumMux[s]);
+    uint32_t shardMin = shard.min.load(std::memory_order_relaxed);
+    uint32_t shardMax = shard.max.load(std::memory_order_relaxed);
+    if (shardMin < minSeen) minSeen = shardMin;
+    if (shardMax > out.max) out.max = shardMax;
+  }
+  out.min = (out.count > 0) ? minSeen : 0;
+
+  static const float kPercentiles[] = {50.0f, 90.0f, 99.0f, 99.9f};
+  uint32_t results[4];
+  resolvePercentiles(id, out.count, out.min, out.max, kPercentiles, results, 4);
+  out.p50 = results[0];
+  out.p90 = results[1];
+  out.p99 = results[2];
+  out.p999 = results[3];
+  return true;
+}
+
+uint32_t getHistogramPercentile(MetricId id, float percentile) {
+  HistogramSnapshot snap;
+  if (!getHistogramSnapshot(id, snap)) return 0;
+  uint32_t result = 0;
+  resolvePercentiles(id, snap.count, snap.min, snap.max, &percentile, &result, 1);
+  return result;
+}
+
+uint32_t getHistogramWindow(MetricId id, HistogramWindow& window,
+                            const float* percentiles, uint32_t* results, uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) results[i] = 0;
+  if (id < 0 || id >= (MetricId)histogramCount) return 0;
+
+  uint32_t maxSeen = 0;
+  for (uint8_t s = 0; s < METRICS_NUM_SHARDS; s++) {
+    uint32_t shardMax = histograms[id].shards[s].max.load(std::memory_order_relaxed);
+    if (shardMax > maxSeen) maxSeen = shardMax;
+  }
+
+  // First pass sizes the window; observations landing between the passes
+  // only move the baseline forward, they are counted in the next window.
+  // A bucket below its baseline was reset, so all of it is new.
+  uint32_t total = 0;
+  for (uint16_t b = 0; b < METRICS_HIST_BUCKETS; b++) {
+    uint32_t current = mergedBucket(id, b);
+    total += current >= window.baseline[b] ? current - window.baseline[b] : current;
+  }
+
+  uint8_t next = 0;
+  uint64_t seen = 0;
+  for (uint16_t b = 0; b < METRICS_HIST_BUCKETS; b++) {
+    uint32_t current = mergedBucket(id, b);
+    uint32_t inWindow = current >= window.baseline[b] ? current - window.baseline[b] : current;
+    window.baseline[b] = current;
+    if (inWindow == 0 || total == 0) continue;
+    seen += inWindow;
+    while (next < n && seen >= percentileRank(percentiles[next], total)) {
+      results[next++] = bucketValue(b, 0, maxSeen);
+    }
+  }
+  while (total > 0 && next < n) {
+    results[next++] = maxSeen;
+  }
+  return total;
+}
+
+size_t getMetricCount(MetricType type) {
+  switch (type) {
+    case METRIC_COUNTER:   return counterCount;
+    case METRIC_GAUGE:     return gaugeCount;
+    case METRIC_HISTOGRAM: return histogramCount;
+  }
+  return 0;
+}
+
+const char* getMetricName(MetricType type, MetricId id) {
+  if (id < 0 || (size_t)id >= getMetricCount(type)) return "";
+  switch (type) {
+    case METRIC_COUNTER:   return counters[id].name;
+    case METRIC_GAUGE:     return gauges[id].name;
+    case METRIC_HISTOGRAM: return histograms[id].name;
+  }
+  return "";
+}
+
+const char* getMetricUnit(MetricType type, MetricId id) {
+  if (id < 0 || (size_t)id >= getMetricCount(type)) return "";
+  switch (type) {
+    case METRIC_COUNTER:   return counters[id].unit;
+    case METRIC_GAUGE:     return gauges[id].unit;
+    case METRIC_HISTOGRAM: return histograms[id].unit;
+  }
+  return "";
+}
+
+MetricId findMetric(MetricType type, const char* name) {
+  if (name == nullptr) return METRIC_INVALID;
+  switch (type) {
+    case METRIC_COUNTER:   return findSlot(counters, counterCount, name);
+    case METRIC_GAUGE:     return findSlot(gauges, gaugeCount, name);
+    case METRIC_HISTOGRAM: return findSlot(histograms, histogramCount, name);
+  }
+  return METRIC_INVALID;
+}
+
+// =============================================================================
+// EXPORT
+// =============================================================================
+
+void exportMetricsSnapshot(JsonObject& out) {
+  out["uptime_ms"] = millis();
+
+  JsonObject counterObj = out.createNestedObject("counters");
+  for (uint16_t i = 0; i < counterCount; i++) {
+    counterObj[counters[i].name] = getCounterValue(i);
+  }
+
+  JsonObject gaugeObj = out.createNestedObject("gauges");
+  for (uint16_t i = 0; i < gaugeCount; i++) {
+    gaugeObj[gauges[i].name] = getGaugeValue(i);
+  }
+
+  JsonObject histObj = out.createNestedObject("histograms");
+  for (uint16_t i = 0; i < histogramCount; i++) {
+    HistogramSnapshot snap;
+    getHistogramSnapshot(i, snap);
+    JsonObject h = histObj.createNestedObject(histograms[i].name);
+    h["unit"] = histograms[i].unit;
+    h["count"] = snap.count;
+    h["min"] = snap.min;
+    h["max"] = snap.max;
+    h["mean"] = snap.count > 0 ? (uint32_t)(snap.sum / snap.count) : 0;
+    h["p50"] = snap.p50;
+    h["p90"] = snap.p90;
+    h["p99"] = snap.p99;
+    h["p999"] = snap.p999;
+  }
+}
+
+void printMetricsRegistry() {
+  Serial.println("=== 📈 Metrics Registry ===");
+  for (uint16_t i = 0; i < counterCount; i++) {
+    Serial.printf("  %-28s %10u %s\n", counters[i].name, getCounterValue(i), counters[i].unit);
+  }
+  for (uint16_t i = 0; i < gaugeCount; i++) {
+    Serial.printf("  %-28s %10d %s\n", gauges[i].name, getGaugeValue(i), gauges[i].unit);
+  }
+  for (uint16_t i = 0; i < histogramCount; i++) {
+    HistogramSnapshot snap;
+    getHistogramSnapshot(i, snap);
+    Serial.printf("  %-28s n=%u p50=%u p90=%u p99=%u max=%u %s\n",
+                  histograms[i].name, snap.count, snap.p50, snap.p90, snap.p99, snap.max,
+                  histograms[i].unit);
+  }
+  Serial.println("===========================");
+}
@@ -1,5 +1,15 @@
 #include "monitoring.h"
 #include "hardware.h"
+#include "metrics_registry.h"
+#include "task_stats.h"
+#include "resource_manager.h"
+#include "sampling_profiler.h"
+#include "websocket_handler.h"
+#include "memory_budget.h"
+#include "alloc_guard.h"
+#include "stack_monitor.h"
+#include "metrics_history.h"
+#include "anomaly_detector.h"
 #include <WiFi.h>
 
 // 🧸 EMERGENCY SIMPLIFICATION - Monitoring for audio-only teddy bear
@@ -7,13 +17,31 @@
 
 // Simple monitoring state  
 static bool monitoringInitialized = false;
+static bool telemetryPaused = false;
 unsigned long lastHealthCheck = 0;
+unsigned long lastMonitoringReport = 0;
+
+// Registry handles owned by monitoring
+static MetricId metricAudioLatency = METRIC_INVALID;
+static MetricId metricFreeHeap = METRIC_INVALID;
+static MetricId metricMinFreeHeap = METRIC_INVALID;
+static MetricId metricLargestBlock = METRIC_INVALID;
 
 // Basic monitoring init
 bool initMonitoring() {
   if (monitoringInitialized) return true;
   
   Serial.println("📊 Simple monitoring init for teddy bear");
+  initMetricsRegistry();
+  metricAudioLatency = registerHistogram("audio.latency", "ms");
+  metricFreeHeap = registerGauge("heap.free", "bytes");
+  metricMinFreeHeap = registerGauge("heap.min_free", "bytes");
+  metricLargestBlock = registerGauge("heap.largest_block", "bytes");
+  initTaskStats();
+  initResourceManager();
+  initMemoryBudget();
+  initMetricsHistory();
+  initAnomalyDetection();
   monitoringInitialized = true;
   return true;
 }
@@ -23,8 +51,12 @@ bool performHealthCheck() {
   if (millis() - lastHealthCheck < 30000) return true; // 30s interval
   
   Serial.printf("💗 Health: Free memory: %d bytes\n", ESP.getFreeHeap());
+  metricSetGauge(metricFreeHeap, (int32_t)ESP.getFreeHeap());
+  metricSetGauge(metricMinFreeHeap, (int32_t)ESP.getMinFreeHeap());
+  metricSetGauge(metricLargestBlock, (int32_t)ESP.getMaxAllocHeap());
   lastHealthCheck = millis();
-  return ESP.getFreeHeap() > 10000; // Basic memory check
+  // Pressure below critical is handled by shedding load, not by failing health
+  return getMemoryPressure() != MEM_PRESSURE_CRITICAL;
 }
 
 // Simple error logging (no complex storage)
@@ -41,6 +73,41 @@ void logError(ErrorType type, const String& message, const String& context, int
 void handleMonitoring() {
   if (!monitoringInitialized) return;
   performHealthCheck();
+  handleMemoryBudget();
+  handleAllocGuard();
+  handleStackMonitor();
+  handleMetricsHistory();
+  handleAnomalyDetection();
+  handleTaskStats();
+  handleProfiler();
+  resourceManager.performMaintenance();
+
+  if (millis() - lastMonitoringReport >= METRICS_REPORT_INTERVAL) {
+    sendHealthReport();
+    lastMonitoringReport = millis();
+  }
+}
+
+// Upload a metrics registry snapshot to the server
+void sendHealthReport() {
+  if (!isConnected || telemetryPaused) return;
+
+  DynamicJsonDocument doc(4096);
+  doc["type"] = "metrics";
+  JsonObject metrics = doc.createNestedObject("metrics");
+  exportMetricsSnapshot(metrics);
+
+  if (doc.overflowed()) {
+    Serial.println("⚠️ Metrics snapshot truncated");
+  }
+
+  String message;
+  serializeJson(doc, message);
+  webSocket.sendTXT(message);
+}
+
+void setTelemetryPaused(bool paused) {
+  telemetryPaused = paused;
 }
 
 // Simple critical error handler
@@ -63,8 +130,12 @@ void trackMemoryUsage() { /* Simplified */ }
 void monitorNetworkHealth() { /* Simplified */ }
 void checkSystemStability() { /* Simplified */ }
 
-// Audio latency stub
-void recordAudioLatency(unsigned int latency) {
-  // Simple stub for audio_handler compatibility
-  Serial.printf("🎵 Audio latency: %u ms\n", latency);
+// Average load across both cores over the last task stats window
+float getCPUUsage() {
+  return getTotalCpuPercent();
+}
+
+// audio_end sent → first audio response, from websocket_handler (p50/p99 via snapshot)
+void recordAudioLatency(uint32_t latency_ms) {
+  metricObserve(metricAudioLatency, latency_ms);
 }
\ No newline at end of file
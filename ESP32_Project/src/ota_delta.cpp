@@ -0,0 +1,245 @@
+#include "ota_delta.h"
+#include "resource_manager.h"
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+#include "esp32/rom/miniz.h"
+
+#define DELTA_RECORD_SIZE 12
+
+struct DeltaDecoder {
+  Client* source;
+  size_t patchLeft;            // Compressed bytes not yet downloaded
+  const esp_partition_t* base; // Running partition, the old image
+  size_t oldSize;
+  size_t newSize;
+
+  tinfl_decompressor* inflater;
+  uint8_t* input;
+  size_t inputPos;
+  size_t inputLength;
+  uint8_t* dictionary;         // Wrapping inflate output, also the LZ77 window
+  size_t dictionarySize;
+  size_t dictionaryPos;        // Where the next inflate output goes
+  size_t pendingPos;           // Inflated bytes not yet consumed
+  size_t pendingLength;
+  bool streamEnded;
+
+  uint32_t diffLeft;           // Current record
+  uint32_t extraLeft;
+  int32_t seek;
+  size_t oldPos;
+  size_t produced;
+};
+
+static uint32_t get32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// =============================================================================
+// PATCH STREAM
+// =============================================================================
+
+// Runs the inflater once, downloading more of the patch when it needs it
+static bool inflateMore(DeltaDecoder& d) {
+  if (d.streamEnded) {
+    Serial.println("❌ OTA delta: patch data ends early");
+    return false;
+  }
+  if (d.inputPos == d.inputLength && d.patchLeft > 0) {
+    size_t want = min((size_t)OTA_DELTA_INPUT_SIZE, d.patchLeft);
+    if (readOtaStream(*d.source, d.input, want) != want) {
+      Serial.printf("❌ OTA delta: connection lost, %u patch bytes left\n", d.patchLeft);
+      return false;
+    }
+    d.inputPos = 0;
+    d.inputLength = want;
+    d.patchLeft -= want;
+  }
+
+  size_t inBytes = d.inputLength - d.inputPos;
+  size_t outBytes = d.dictionarySize - d.dictionaryPos;
+  tinfl_status status = tinfl_decompress(d.inflater, d.input + d.inputPos, &inBytes,
+                                         d.dictionary, d.dictionary + d.dictionaryPos, &outBytes,
+                                         d.patchLeft > 0 ? TINFL_FLAG_HAS_MORE_INPUT : 0);
+  d.inputPos += inBytes;
+  d.pendingPos = d.dictionaryPos;
+  d.pendingLength = outBytes;
+  d.dictionaryPos = (d.dictionaryPos + outBytes) & (d.dictionarySize - 1);
+  if (status < TINFL_STATUS_DONE) {
+    Serial.printf("❌ OTA delta: corrupt patch data (inflate %d)\n", (int)status);
+    return false;
+  }
+  d.streamEnded = (status == TINFL_STATUS_DONE);
+  return true;
+}
+
+// Next length inflated bytes into out, or added to out (diff bytes)
+static bool inflateInto(DeltaDecoder& d, uint8_t* out, size_t length, bool add) {
+  while (length > 0) {
+    if (d.pendingLength == 0) {
+      if (!inflateMore(d)) return false;
+      continue;
+    }
+    size_t n = min(length, d.pendingLength);
+    const uint8_t* in = d.dictionary + d.pendingPos;
+    if (add) {
+      for (size_t i = 0; i < n; i++) out[i] += in[i];
+    } else {
+      memcpy(out, in, n);
+    }
+    out += n;
+    length -= n;
+    d.pendingPos += n;
+    d.pendingLength -= n;
+  }
+  return true;
+}
+
+// Applies the finished record's seek and reads the next record header
+static bool nextRecord(DeltaDecoder& d) {
+  int64_t oldPos = (int64_t)d.oldPos + d.seek;
+  uint8_t record[DELTA_RECORD_SIZE];
+  if (oldPos < 0 || oldPos > (int64_t)d.oldSize) {
+    Serial.printf("❌ OTA delta: seek to %lld outside the old image\n", (long long)oldPos);
+    return false;
+  }
+  if (!inflateInto(d, record, sizeof(record), false)) {
+    return false;
+  }
+  d.oldPos = (size_t)oldPos;
+  d.diffLeft = get32(record);
+  d.extraLeft = get32(record + 4);
+  d.seek = (int32_t)get32(record + 8);
+  if (d.diffLeft > d.oldSize - d.oldPos ||
+      (uint64_t)d.diffLeft + d.extraLeft > d.newSize - d.produced) {
+    Serial.printf("❌ OTA delta: record (%u + %u bytes) out of range at %u\n",
+                  d.diffLeft, d.extraLeft, d.produced);
+    return false;
+  }
+  return true;
+}
+
+// OtaImageReader: the new image, rebuilt from the old one and the patch
+static size_t deltaReader(void* context, uint8_t* data, size_t length) {
+  DeltaDecoder& d = *static_cast<DeltaDecoder*>(context);
+  size_t filled = 0;
+  while (filled < length) {
+    if (d.diffLeft > 0) {
+      size_t n = min((size_t)d.diffLeft, length - filled);
+      esp_err_t err = esp_partition_read(d.base, d.oldPos, data + filled, n);
+      if (err != ESP_OK) {
+        Serial.printf("❌ OTA delta: reading old image at 0x%x failed: %s\n", d.oldPos, esp_err_to_name(err));
+        break;
+      }
+      if (!inflateInto(d, data + filled, n, true)) break;
+      d.oldPos += n;
+      d.diffLeft -= n;
+      d.produced += n;
+      filled += n;
+    } else if (d.extraLeft > 0) {
+      size_t n = min((size_t)d.extraLeft, length - filled);
+      if (!inflateInto(d, data + filled, n, false)) break;
+      d.extraLeft -= n;
+      d.produced += n;
+      filled += n;
+    } else if (!nextRecord(d)) {
+      break;
+    }
+  }
+  return filled;
+}
+
+// =============================================================================
+// INSTALL
+// =============================================================================
+
+// The patch only rebuilds the right image from the image it was made against
+static bool baseImageMatches(const esp_partition_t* base, size_t size, const uint8_t* sha256,
+                             uint8_t* scratch, size_t scratchSize) {
+  mbedtls_sha256_context sha;
+  mbedtls_sha256_init(&sha);
+  mbedtls_sha256_starts_ret(&sha, 0);
+  bool ok = true;
+  for (size_t pos = 0; pos < size && ok; pos += scratchSize) {
+    size_t n = min(scratchSize, size - pos);
+    ok = esp_partition_read(base, pos, scratch, n) == ESP_OK;
+    mbedtls_sha256_update_ret(&sha, scratch, n);
+  }
+  uint8_t digest[OTA_SHA256_SIZE];
+  mbedtls_sha256_finish_ret(&sha, digest);
+  mbedtls_sha256_free(&sha);
+  return ok && memcmp(digest, sha256, OTA_SHA256_SIZE) == 0;
+}
+
+static void releaseDecoder(DeltaDecoder& d) {
+  if (d.inflater != nullptr) TRACK_FREE(d.inflater, "ota_delta_inflater");
+  if (d.input != nullptr) TRACK_FREE(d.input, "ota_delta_input");
+  if (d.dictionary != nullptr) TRACK_FREE(d.dictionary, "ota_delta_dictionary");
+  d = DeltaDecoder{};
+}
+
+bool installOtaDelta(Client& source, size_t patchSize, const OtaExpectedImage& expected,
+                     OtaPipelineStats& stats) {
+  uint8_t header[OTA_DELTA_HEADER_SIZE];
+  if (patchSize <= sizeof(header) || readOtaStream(source, header, sizeof(header)) != sizeof(header)) {
+    Serial.println("❌ OTA delta: patch header missing");
+    return false;
+  }
+  int windowBits = header[5];
+  if (memcmp(header, OTA_DELTA_MAGIC, 4) != 0 || header[4] != OTA_DELTA_VERSION ||
+      windowBits < 9 || windowBits > OTA_DELTA_MAX_WINDOW_BITS) {
+    Serial.printf("❌ OTA delta: unsupported patch (version %d, window %d bits)\n", header[4], windowBits);
+    return false;
+  }
+  size_t oldSize = get32(header + 8);
+  size_t newSize = get32(header + 12);
+  const uint8_t* oldSha256 = header + 16;
+  const uint8_t* newSha256 = header + 48;
+  if (newSize != expected.size ||
+      (expected.sha256 != nullptr && memcmp(newSha256, expected.sha256, OTA_SHA256_SIZE) != 0)) {
+    Serial.printf("❌ OTA delta: patch builds a different image (%u bytes, manifest %u)\n",
+                  newSize, expected.size);
+    return false;
+  }
+
+  const esp_partition_t* base = esp_ota_get_running_partition();
+  if (base == nullptr || oldSize > base->size) {
+    Serial.println("❌ OTA delta: patch base does not fit the running partition");
+    return false;
+  }
+
+  DeltaDecoder d = {};
+  d.source = &source;
+  d.patchLeft = patchSize - sizeof(header);
+  d.base = base;
+  d.oldSize = oldSize;
+  d.newSize = newSize;
+  d.dictionarySize = (size_t)1 << windowBits;
+  d.inflater = (tinfl_decompressor*)TRACK_MALLOC(sizeof(tinfl_decompressor), "ota_delta_inflater");
+  d.input = (uint8_t*)TRACK_MALLOC(OTA_DELTA_INPUT_SIZE, "ota_delta_input");
+  d.dictionary = (uint8_t*)TRACK_MALLOC(d.dictionarySize, "ota_delta_dictionary");
+  if (d.inflater == nullptr || d.input == nullptr || d.dictionary == nullptr) {
+    Serial.printf("❌ OTA delta: no memory for the decoder (%u bytes)\n",
+                  sizeof(tinfl_decompressor) + OTA_DELTA_INPUT_SIZE + d.dictionarySize);
+    releaseDecoder(d);
+    return false;
+  }
+
+  uint32_t checkStart = millis();
+  if (!baseImageMatches(base, oldSize, oldSha256, d.dictionary, d.dictionarySize)) {
+    Serial.printf("❌ OTA delta: %s does not hold the image this patch was made from\n", base->label);
+    releaseDecoder(d);
+    return false;
+  }
+  Serial.printf("🧩 OTA delta: %u byte patch for a %u byte image (%.1f%%), base %s verified in %lu ms\n",
+                patchSize, newSize, patchSize * 100.0f / newSize, base->label,
+                (unsigned long)(millis() - checkStart));
+
+  tinfl_init(d.inflater);
+  OtaExpectedImage image = expected;
+  image.sha256 = newSha256;
+  bool ok = installOtaImageFrom(deltaReader, &d, image, stats);
+  releaseDecoder(d);
+  return ok;
+}
@@ -13,10 +13,15 @@
 #include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
 #include <WebServer.h>
-#include <esp_https_ota.h>
-#include <esp_http_client.h>
+#include "encoding_service.h"
 #include "security.h"
 #include "time_sync.h"
+#include "metrics_history.h"
+#include "diagnostics_endpoints.h"
+#include "ota_pipeline.h"
+#include "ota_delta.h"
+#include "ota_resume.h"
+#include "web_assets.h"
 #include "security/root_cert.h"
 
 WebServer webServer(80);
@@ -34,9 +39,10 @@ bool initOTA() {
   try {
 #ifndef ENABLE_ELEGANT_OTA
     Serial.println("🔒 [PROD] ElegantOTA disabled for security");
-    // Only enable secure esp_https_ota in production
-#else
-    // Start web server with ElegantOTA only in development
+    // Production updates only through the verified pipeline (ota_pipeline.h)
+#endif
+#ifdef ENABLE_DEBUG_HTTP
+    // Status, history, metrics and debug pages only in development
     startWebServer();
     Serial.printf("🔓 [DEV] Web interface: http://%s/\n", WiFi.localIP().toString().c_str());
 #endif
@@ -53,7 +59,7 @@ bool initOTA() {
 }
 
 void handleOTA() {
-#ifdef ENABLE_ELEGANT_OTA
+#ifdef ENABLE_DEBUG_HTTP
   // Only handle web server in development - no ArduinoOTA to avoid WiFiUDP issues
   webServer.handleClient();
 #endif
@@ -114,7 +120,7 @@ bool checkForUpdates() {
       delay(500);
       clearLEDs();
       
-      if (downloadAndInstallUpdate(firmwareInfo.download_url)) {
+      if (downloadAndInstallUpdate(firmwareInfo)) {
         Serial.println("✅ Update completed successfully!");
         return true;
       } else {
@@ -135,149 +141,135 @@ bool checkForUpdates() {
 FirmwareInfo parseUpdateResponse(const String& response) {
   FirmwareInfo info = {};
   
-  StaticJsonDocument<512> doc;
+  StaticJsonDocument<1536> doc;
   DeserializationError error = deserializeJson(doc, response);
   
   if (!error) {
     info.version = doc["version"].as<String>();
     info.download_url = doc["download_url"].as<String>();
+    info.checksum = doc["checksum"] | "";
+    info.signature = doc["signature"] | "";
     info.force_update = doc["force_update"] | false;
     info.file_size = doc["file_size"] | 0;
+    info.download_size = doc["download_size"] | info.file_size;
+    info.delta_url = doc["delta_url"] | "";
+    info.delta_from = doc["delta_from"] | "";
+    info.delta_size = doc["delta_size"] | 0;
   }
   
   return info;
 }
 
-bool downloadAndInstallUpdate(const String& url) {
-  if (url.length() == 0) {
-    Serial.println("❌ Invalid download URL");
-    return false;
+// Starts an authenticated GET, from offset on with a Range request; returns
+// the content length, or 0 on failure (including a length other than
+// expectedSize, when that is known)
+static int beginUpdateDownload(WiFiClientSecure& client, HTTPClient& http, const String& url,
+                               size_t expectedSize, size_t offset = 0) {
+  if (offset == 0) {
+    Serial.printf("📥 Securely downloading update from: %s\n", url.c_str());
   }
-  
-  Serial.printf("📥 Securely downloading update from: %s\n", url.c_str());
-  
-#ifdef PRODUCTION_BUILD
-  // Use esp_https_ota for secure production updates
-  return performSecureOTAUpdate(url);
-#else
-  // Development fallback - still use secure connection with GTS Root R4
-  WiFiClientSecure client;
   client.setCACert(ROOT_CA_PEM);
-  
-  HTTPClient http;
   http.begin(client, url);
-  
+  http.addHeader("Device-ID", deviceConfig.device_id);
+  http.addHeader("Authorization", String("Bearer ") + DEVICE_SECRET_KEY);
+  if (offset > 0) {
+    http.addHeader("Range", String("bytes=") + offset + "-");
+  }
+
   int httpCode = http.GET();
-  
-  if (httpCode == 200) {
-    int contentLength = http.getSize();
-    
-    if (contentLength <= 0) {
-      Serial.println("❌ Invalid content length");
-      http.end();
-      return false;
-    }
-    
-    Serial.printf("📦 Update size: %d bytes\n", contentLength);
-    
-    if (!Update.begin(contentLength)) {
-      Serial.println("❌ Cannot begin update");
-      http.end();
-      return false;
-    }
-    
-    WiFiClient* client = http.getStreamPtr();
-    size_t written = 0;
-    uint8_t buffer[1024];
-    
-    // Simple LED indication during update
-    setLEDColor("orange", 50);
-    
-    while (http.connected() && written < contentLength) {
-      size_t available = client->available();
-      
-      if (available) {
-        int readBytes = client->readBytes(buffer, 
-                                        ((available > sizeof(buffer)) ? sizeof(buffer) : available));
-        
-        size_t result = Update.write(buffer, readBytes);
-        
-        if (result != readBytes) {
-          Serial.println("❌ Write failed");
-          Update.abort();
-          http.end();
-          return false;
-        }
-        
-        written += readBytes;
-        
-        int progress = (written * 100) / contentLength;
-        if (progress % 10 == 0) {
-          Serial.printf("Progress: %d%%\n", progress);
-          // Simple LED progress indication - no undefined setLEDProgress function
-          if (progress % 20 == 0) {
-            setLEDColor("green", 30);
-            delay(10);
-            clearLEDs();
-            delay(10);
-          }
-        }
-      }
-      delay(1);
-    }
-    
-    if (Update.end(true)) {
-      Serial.println("✅ Update completed successfully!");
-      setLEDColor("green", 100);
-      delay(1000);
-      clearLEDs();
-      
-      Serial.println("🔄 Rebooting...");
-      delay(1000);
-      ESP.restart();
-      return true;
-    } else {
-      Serial.printf("❌ Update failed: %s\n", Update.errorString());
-    }
-  } else {
-    Serial.printf("❌ HTTP error: %d\n", httpCode);
+  if (httpCode != (offset > 0 ? 206 : 200)) {
+    Serial.printf("❌ HTTP error: %d%s\n", httpCode, offset > 0 && httpCode == 200 ? " (range not supported)" : "");
+    return 0;
   }
-  
-  http.end();
-  return false;
-#endif
+  int contentLength = http.getSize();
+  if (contentLength <= 0 || (expectedSize > 0 && (size_t)contentLength != expectedSize)) {
+    Serial.printf("❌ Invalid content length: %d (manifest %u)\n", contentLength, expectedSize);
+    return 0;
+  }
+  return contentLength;
 }
 
+struct UpdateConnection {
+  WiFiClientSecure client;
+  HTTPClient http;
+  String url;
+  size_t downloadSize;
+};
+
+// OtaConnectCallback: (re)opens the image download at offset
+static Client* connectUpdate(void* context, size_t offset) {
+  UpdateConnection& connection = *static_cast<UpdateConnection*>(context);
+  connection.http.end();
+  if (beginUpdateDownload(connection.client, connection.http, connection.url,
+                          connection.downloadSize - offset, offset) == 0) {
+    return nullptr;
+  }
+  return connection.http.getStreamPtr();
+}
+
+bool downloadAndInstallUpdate(const FirmwareInfo& firmware) {
+  if (firmware.download_url.length() == 0) {
+    Serial.println("❌ Invalid download URL");
+    return false;
+  }
+  if (firmware.file_size == 0 || firmware.download_size == 0) {
+    Serial.println("❌ Manifest has no file_size");
+    return false;
+  }
+
+  // Digest and signature are checked as the image streams through
+  uint8_t sha256[OTA_SHA256_SIZE];
+  bool hasChecksum = parseSha256Hex(firmware.checksum.c_str(), sha256);
+  if (!hasChecksum) {
 #ifdef PRODUCTION_BUILD
-bool performSecureOTAUpdate(const String& url) {
-  Serial.println("🔒 Starting secure ESP-HTTPS-OTA update...");
-  
-  // ✅ Configure HTTP client for secure OTA with GTS Root R4 certificate
-  esp_http_client_config_t http_cfg = {};
-  http_cfg.url = url.c_str();
-  http_cfg.cert_pem = ROOT_CA_PEM;
-  http_cfg.timeout_ms = 30000;
-  http_cfg.keep_alive_enable = true;
-  
-  // Add authentication headers
-  String authHeader = String("Bearer ") + DEVICE_SECRET_KEY;
-  String deviceIdHeader = String(deviceConfig.device_id);
-  
-  // Set LED indication
+    Serial.println("❌ Manifest has no valid SHA-256 checksum");
+    return false;
+#else
+    Serial.println("⚠️ Manifest has no valid SHA-256 checksum; digest not compared");
+#endif
+  }
+  uint8_t signature[OTA_SIGNATURE_MAX];
+  size_t signatureLength = 0;
+  if (firmware.signature.length() > 0 &&
+      !base64Decode(firmware.signature.c_str(), firmware.signature.length(), signature, sizeof(signature),
+                    &signatureLength, BASE64_WHITESPACE)) {
+    Serial.println("❌ Manifest signature is not valid base64");
+    return false;
+  }
+
+  // Simple LED indication during update
   setLEDColor("orange", 50);
-  
-  Serial.printf("🔒 Starting secure HTTPS OTA from: %s\n", url.c_str());
-  esp_err_t ret = esp_https_ota(&http_cfg);
-  
-  if (ret == ESP_OK) {
-    Serial.println("✅ Secure OTA update completed successfully!");
-    setLEDColor("green", 100);
-    delay(1000);
-    Serial.println("🔄 Rebooting...");
-    esp_restart();
-    return true;
-  } else {
-    Serial.printf("❌ Secure OTA update failed: %s\n", esp_err_to_name(ret));
+
+  OtaExpectedImage expected = {firmware.file_size, hasChecksum ? sha256 : nullptr,
+                               signatureLength > 0 ? signature : nullptr, signatureLength};
+  OtaPipelineStats stats;
+  bool installed = false;
+
+  // A patch against the running version when the server has one; the full
+  // image is the fallback for anything that goes wrong with it
+  if (firmware.delta_url.length() > 0 && firmware.delta_from == FIRMWARE_VERSION) {
+    WiFiClientSecure client;
+    HTTPClient http;
+    int patchSize = beginUpdateDownload(client, http, firmware.delta_url, firmware.delta_size);
+    if (patchSize > 0) {
+      installed = installOtaDelta(*http.getStreamPtr(), patchSize, expected, stats);
+    }
+    http.end();
+    if (!installed) {
+      Serial.println("⚠️ Delta update failed, downloading the full image");
+    }
+  }
+
+  // Raw or packed image; resumes a checkpointed download and survives drops
+  if (!installed) {
+    UpdateConnection connection;
+    connection.url = firmware.download_url;
+    connection.downloadSize = firmware.download_size;
+    installed = installResumableOta(connectUpdate, &connection, connection.downloadSize, expected, stats);
+    connection.http.end();
+  }
+
+  if (!installed) {
     // Error LED indication
     for (int i = 0; i < 3; i++) {
       setLEDColor("red", 100);
@@ -287,8 +279,18 @@ bool performSecureOTAUpdate(const String& url) {
     }
     return false;
   }
+
+  Serial.println("✅ Update completed successfully!");
+  setLEDColor("green", 100);
+  delay(1000);
+  clearLEDs();
+
+  Serial.println("🔄 Rebooting...");
+  saveMetricsHistory();
+  delay(1000);
+  ESP.restart();
+  return true;
 }
-#endif
 
 void startWebServer() {
 #ifdef ENABLE_ELEGANT_OTA
@@ -296,31 +298,16 @@ void startWebServer() {
   ElegantOTA.begin(&webServer);
 #endif
   
-  // Main page
+  // Main page: gzipped from flash, filled in from /status
   webServer.on("/", HTTP_GET, []() {
-    String html = "<!DOCTYPE html><html><head><title>AI Teddy Bear OTA</title>";
-    html += "<meta charset='UTF-8'><meta name='viewport' content='width=device-width, initial-scale=1.0'>";
-    html += "<style>body { font-family: Arial; text-align: center; background: #f0f0f0; }";
-    html += ".container { max-width: 400px; margin: 50px auto; padding: 20px; background: white; border-radius: 10px; }";
-    html += "h1 { color: #333; }";
-    html += ".info { background: #e8f4fd; padding: 15px; border-radius: 5px; margin: 10px 0; }";
-    html += ".button { background: #007bff; color: white; padding: 12px 25px; border: none; border-radius: 5px; cursor: pointer; margin: 10px; text-decoration: none; display: inline-block; }";
-    html += ".button:hover { background: #0056b3; }</style></head><body>";
-    html += "<div class='container'><h1>AI Teddy Bear</h1><div class='info'>";
-    html += "<p><strong>Device ID:</strong> " + String(DEVICE_ID) + "</p>";
-    html += "<p><strong>Firmware:</strong> " + String(FIRMWARE_VERSION) + "</p>";
-    html += "<p><strong>Free Memory:</strong> " + String(ESP.getFreeHeap()) + " bytes</p>";
-    html += "<p><strong>Uptime:</strong> " + String(millis() / 1000) + " seconds</p></div>";
-    html += "<a href='/update' class='button'>OTA Update</a>";
-    html += "<a href='/restart' class='button'>Restart Device</a>";
-    html += "</div></body></html>";
-    
-    webServer.send(200, "text/html", html);
+    sendWebAsset(webServer, "ota.html");
   });
+  collectWebAssetHeaders(webServer);
   
   // Restart endpoint
   webServer.on("/restart", HTTP_GET, []() {
     webServer.send(200, "text/html", "<h1>Restarting...</h1>");
+    saveMetricsHistory();
     delay(1000);
     ESP.restart();
   });
@@ -342,6 +329,28 @@ void startWebServer() {
     webServer.send(200, "application/json", response);
   });
   
+  // Metrics history: /history?series=heap.free&resolution=minute
+  webServer.on("/history", HTTP_GET, []() {
+    int res = findHistoryResolution(webServer.hasArg("resolution") ? webServer.arg("resolution").c_str() : "minute");
+    int series = findHistorySeries(webServer.arg("series").c_str());
+    if (res < 0 || series < 0) {
+      webServer.send(400, "application/json", "{\"error\":\"unknown series or resolution\"}");
+      return;
+    }
+    
+    DynamicJsonDocument doc(HISTORY_JSON_CAPACITY);
+    JsonObject out = doc.to<JsonObject>();
+    exportHistorySeries(out, (HistoryResolution)res, (HistorySeries)series);
+    
+    String response;
+    serializeJson(doc, response);
+    
+    webServer.send(200, "application/json", response);
+  });
+  
+  // Prometheus /metrics and /debug/* pages
+  registerDiagnosticsEndpoints(webServer);
+  
   webServer.begin();
   Serial.println("✅ Web server started");
 }
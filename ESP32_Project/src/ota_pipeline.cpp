@@ -0,0 +1,378 @@
+#include "ota_pipeline.h"
+#include "resource_manager.h"
+#include "stack_monitor.h"
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <esp_image_format.h>
+#include <esp_spi_flash.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/pk.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+// Buffer handed between reader and writer; length 0 ends the image
+struct OtaBuffer {
+  uint8_t index;
+  uint32_t length;
+};
+
+struct OtaWriter {
+  const esp_partition_t* partition;
+  uint8_t* buffers[OTA_PIPELINE_BUFFERS];
+  QueueHandle_t freeQueue;
+  QueueHandle_t fullQueue;
+  TaskHandle_t reader;
+  size_t eraseLimit;          // Image size rounded up to a sector
+  size_t erased;              // Erased prefix of the partition
+  size_t written;
+  volatile bool failed;
+  uint32_t eraseMs;
+  uint32_t eraseAheadMs;
+  uint32_t writeMs;
+};
+
+static OtaWriter writer;
+static OtaPipelineStats lastStats;
+
+static size_t alignUp(size_t bytes, size_t unit) {
+  return (bytes + unit - 1) & ~(unit - 1);
+}
+
+// =============================================================================
+// WRITER TASK
+// =============================================================================
+
+// Erases whole blocks up to at least end (partitions are block aligned)
+static bool eraseUpTo(size_t end, bool ahead) {
+  end = min(alignUp(end, OTA_ERASE_BLOCK), writer.eraseLimit);
+  if (writer.erased >= end) {
+    return true;
+  }
+  uint32_t start = millis();
+  esp_err_t err = esp_partition_erase_range(writer.partition, writer.erased, end - writer.erased);
+  uint32_t elapsed = millis() - start;
+  writer.eraseMs += elapsed;
+  if (ahead) {
+    writer.eraseAheadMs += elapsed;
+  }
+  if (err != ESP_OK) {
+    Serial.printf("❌ OTA: erase at 0x%x failed: %s\n", writer.erased, esp_err_to_name(err));
+    return false;
+  }
+  writer.erased = end;
+  return true;
+}
+
+static bool writeBuffer(const uint8_t* data, size_t length) {
+  if (writer.written == 0 && data[0] != ESP_IMAGE_HEADER_MAGIC) {
+    Serial.printf("❌ OTA: not an application image (magic 0x%02x)\n", data[0]);
+    return false;
+  }
+  if (!eraseUpTo(writer.written + length, false)) {
+    return false;
+  }
+  uint32_t start = millis();
+  esp_err_t err = esp_partition_write(writer.partition, writer.written, data, length);
+  writer.writeMs += millis() - start;
+  if (err != ESP_OK) {
+    Serial.printf("❌ OTA: write at 0x%x failed: %s\n", writer.written, esp_err_to_name(err));
+    return false;
+  }
+  writer.written += length;
+  return true;
+}
+
+static void otaWriterTask(void*) {
+  registerCurrentTaskStack("ota_writer", OTA_WRITER_STACK_SIZE);
+  OtaBuffer buffer;
+
+  while (true) {
+    // With nothing to write, erase ahead a block at a time; otherwise block
+    bool eraseAhead = !writer.failed && writer.erased < min(writer.written + OTA_ERASE_AHEAD, writer.eraseLimit);
+    if (xQueueReceive(writer.fullQueue, &buffer, eraseAhead ? 0 : portMAX_DELAY) != pdTRUE) {
+      if (!eraseUpTo(writer.erased + OTA_ERASE_BLOCK, true)) {
+        writer.failed = true;
+      }
+      continue;
+    }
+    if (buffer.length == 0) {
+      break;
+    }
+    if (!writer.failed && !writeBuffer(writer.buffers[buffer.index], buffer.length)) {
+      writer.failed = true;
+    }
+    xQueueSend(writer.freeQueue, &buffer, portMAX_DELAY);
+  }
+
+  xTaskNotifyGive(writer.reader);
+  noteTaskStackExit();
+  vTaskDelete(NULL);
+}
+
+static void releaseWriter() {
+  for (int i = 0; i < OTA_PIPELINE_BUFFERS; i++) {
+    if (writer.buffers[i] != nullptr) {
+      TRACK_FREE(writer.buffers[i], "ota_buffer");
+    }
+  }
+  if (writer.freeQueue != nullptr) vQueueDelete(writer.freeQueue);
+  if (writer.fullQueue != nullptr) vQueueDelete(writer.fullQueue);
+  writer = OtaWriter{};
+}
+
+static bool startWriter(const esp_partition_t* partition, size_t imageSize, size_t startOffset) {
+  writer = OtaWriter{};
+  writer.partition = partition;
+  writer.erased = startOffset;      // A resumed image keeps what is already written
+  writer.written = startOffset;
+  writer.eraseLimit = min(alignUp(imageSize, SPI_FLASH_SEC_SIZE), (size_t)partition->size);
+  writer.reader = xTaskGetCurrentTaskHandle();
+  writer.freeQueue = xQueueCreate(OTA_PIPELINE_BUFFERS, sizeof(OtaBuffer));
+  writer.fullQueue = xQueueCreate(OTA_PIPELINE_BUFFERS + 1, sizeof(OtaBuffer));   // + end marker
+  if (writer.freeQueue == nullptr || writer.fullQueue == nullptr) {
+    Serial.println("❌ OTA: failed to create pipeline queues");
+    releaseWriter();
+    return false;
+  }
+  for (int i = 0; i < OTA_PIPELINE_BUFFERS; i++) {
+    writer.buffers[i] = (uint8_t*)TRACK_MALLOC(OTA_PIPELINE_BUFFER_SIZE, "ota_buffer");
+    if (writer.buffers[i] == nullptr) {
+      Serial.printf("❌ OTA: no memory for %d x %d byte buffers\n", OTA_PIPELINE_BUFFERS, OTA_PIPELINE_BUFFER_SIZE);
+      releaseWriter();
+      return false;
+    }
+    OtaBuffer buffer = {(uint8_t)i, 0};
+    xQueueSend(writer.freeQueue, &buffer, 0);
+  }
+
+  // Clear a pending notification so only the writer's exit can satisfy the wait
+  ulTaskNotifyTake(pdTRUE, 0);
+  if (xTaskCreate(otaWriterTask, "ota_writer", OTA_WRITER_STACK_SIZE, nullptr, OTA_WRITER_PRIORITY, nullptr) != pdPASS) {
+    Serial.println("❌ OTA: failed to start writer task");
+    releaseWriter();
+    return false;
+  }
+  return true;
+}
+
+// Sends the end marker and waits until every queued buffer is written
+static bool stopWriter() {
+  OtaBuffer end = {0, 0};
+  xQueueSend(writer.fullQueue, &end, portMAX_DELAY);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  return !writer.failed;
+}
+
+// =============================================================================
+// READER
+// =============================================================================
+
+// Bulk reads of whatever the connection has buffered (Stream::readBytes goes
+// byte by byte)
+size_t readOtaStream(Client& source, uint8_t* data, size_t length) {
+  size_t got = 0;
+  uint32_t lastData = millis();
+  while (got < length) {
+    int available = source.available();
+    if (available > 0) {
+      int n = source.read(data + got, min((size_t)available, length - got));
+      if (n > 0) {
+        got += n;
+        lastData = millis();
+        continue;
+      }
+    }
+    if (!source.connected() || millis() - lastData > OTA_READ_TIMEOUT_MS) {
+      break;
+    }
+    delay(1);
+  }
+  return got;
+}
+
+static size_t clientReader(void* context, uint8_t* data, size_t length) {
+  return readOtaStream(*static_cast<Client*>(context), data, length);
+}
+
+static bool verifySignature(const uint8_t* digest, const OtaExpectedImage& expected) {
+#ifdef OTA_SIGNING_PUBLIC_KEY_PEM
+  if (expected.signature == nullptr || expected.signatureLength == 0) {
+    Serial.println("❌ OTA: unsigned image rejected");
+    return false;
+  }
+  mbedtls_pk_context key;
+  mbedtls_pk_init(&key);
+  int rc = mbedtls_pk_parse_public_key(&key, (const unsigned char*)OTA_SIGNING_PUBLIC_KEY_PEM,
+                                       strlen(OTA_SIGNING_PUBLIC_KEY_PEM) + 1);
+  if (rc == 0) {
+    rc = mbedtls_pk_verify(&key, MBEDTLS_MD_SHA256, digest, OTA_SHA256_SIZE,
+                           expected.signature, expected.signatureLength);
+  }
+  mbedtls_pk_free(&key);
+  if (rc != 0) {
+    Serial.printf("❌ OTA: signature verification failed (-0x%04x)\n", -rc);
+    return false;
+  }
+  Serial.println("🔏 OTA: signature verified");
+#else
+  (void)digest;   // Nothing to check it against
+  if (expected.signature != nullptr) {
+    Serial.println("⚠️ OTA: signature not checked (no signing key in this build)");
+  }
+#endif
+  return true;
+}
+
+bool installOtaImage(Client& source, const OtaExpectedImage& expected, OtaPipelineStats& stats) {
+  return installOtaImageFrom(clientReader, &source, expected, stats);
+}
+
+bool installOtaImageFrom(OtaImageReader reader, void* context, const OtaExpectedImage& expected,
+                         OtaPipelineStats& stats, OtaResume* resume) {
+  stats = OtaPipelineStats{};
+  uint32_t startMs = millis();
+
+  const esp_partition_t* partition = esp_ota_get_next_update_partition(nullptr);
+  if (partition == nullptr) {
+    Serial.println("❌ OTA: no update partition");
+    return false;
+  }
+  if (expected.size == 0 || expected.size > partition->size) {
+    Serial.printf("❌ OTA: image size %u does not fit partition %s (%u bytes)\n",
+                  expected.size, partition->label, partition->size);
+    return false;
+  }
+  size_t startOffset = resume != nullptr ? resume->offset : 0;
+  if (startOffset % SPI_FLASH_SEC_SIZE != 0 || startOffset >= expected.size) {
+    Serial.printf("❌ OTA: cannot resume at %u of %u bytes\n", startOffset, expected.size);
+    return false;
+  }
+  if (!startWriter(partition, expected.size, startOffset)) {
+    return false;
+  }
+  Serial.printf("📦 OTA: %u bytes to %s from %u, %d x %d KB buffers\n", expected.size, partition->label,
+                startOffset, OTA_PIPELINE_BUFFERS, OTA_PIPELINE_BUFFER_SIZE / 1024);
+
+  mbedtls_sha256_context sha;
+  mbedtls_sha256_init(&sha);
+  if (resume != nullptr) {
+    mbedtls_sha256_clone(&sha, &resume->sha);
+  } else {
+    mbedtls_sha256_starts_ret(&sha, 0);
+  }
+
+  // Where each buffer ends and the digest state there, reported once the
+  // writer hands the buffer back (it is in flash by then)
+  size_t bufferEnd[OTA_PIPELINE_BUFFERS] = {};
+  mbedtls_sha256_context bufferSha[OTA_PIPELINE_BUFFERS];
+  for (int i = 0; i < OTA_PIPELINE_BUFFERS; i++) {
+    mbedtls_sha256_init(&bufferSha[i]);
+  }
+
+  size_t received = startOffset;
+  int lastDecile = (int)((uint64_t)received * 10 / expected.size);
+  bool ok = true;
+  while (received < expected.size) {
+    OtaBuffer buffer;
+    uint32_t waitStart = millis();
+    xQueueReceive(writer.freeQueue, &buffer, portMAX_DELAY);
+    stats.stallMs += millis() - waitStart;
+    if (writer.failed) {
+      ok = false;
+      break;
+    }
+    if (resume != nullptr && resume->durable != nullptr && bufferEnd[buffer.index] > 0) {
+      resume->durable(resume->context, bufferEnd[buffer.index], bufferSha[buffer.index]);
+    }
+
+    size_t want = min((size_t)OTA_PIPELINE_BUFFER_SIZE, expected.size - received);
+    uint8_t* data = writer.buffers[buffer.index];
+    uint32_t readStart = millis();
+    size_t got = reader(context, data, want);
+    stats.readMs += millis() - readStart;
+    if (got != want) {
+      Serial.printf("❌ OTA: image stream ended at %u of %u bytes\n", received + got, expected.size);
+      ok = false;
+      break;
+    }
+
+    mbedtls_sha256_update_ret(&sha, data, got);
+    bufferEnd[buffer.index] = received + got;
+    if (resume != nullptr) {
+      mbedtls_sha256_clone(&bufferSha[buffer.index], &sha);
+    }
+    buffer.length = got;
+    xQueueSend(writer.fullQueue, &buffer, portMAX_DELAY);
+    received += got;
+
+    int decile = (int)((uint64_t)received * 10 / expected.size);
+    if (decile != lastDecile) {
+      lastDecile = decile;
+      Serial.printf("Progress: %d%%\n", decile * 10);
+    }
+  }
+
+  uint8_t digest[OTA_SHA256_SIZE];
+  mbedtls_sha256_finish_ret(&sha, digest);
+  mbedtls_sha256_free(&sha);
+  for (int i = 0; i < OTA_PIPELINE_BUFFERS; i++) {
+    mbedtls_sha256_free(&bufferSha[i]);
+  }
+
+  ok = stopWriter() && ok;
+  stats.bytes = writer.written - startOffset;
+  stats.eraseMs = writer.eraseMs;
+  stats.eraseAheadMs = writer.eraseAheadMs;
+  stats.writeMs = writer.writeMs;
+  releaseWriter();
+
+  uint32_t verifyStart = millis();
+  if (ok && expected.sha256 != nullptr && memcmp(digest, expected.sha256, OTA_SHA256_SIZE) != 0) {
+    Serial.println("❌ OTA: SHA-256 mismatch, image rejected");
+    ok = false;
+  }
+  if (ok && !verifySignature(digest, expected)) {
+    ok = false;
+  }
+  if (ok) {
+    esp_err_t err = esp_ota_set_boot_partition(partition);
+    if (err != ESP_OK) {
+      Serial.printf("❌ OTA: image rejected by bootloader check: %s\n", esp_err_to_name(err));
+      ok = false;
+    }
+  }
+  stats.verifyMs = millis() - verifyStart;
+  stats.totalMs = millis() - startMs;
+  lastStats = stats;
+  printOtaStats(stats);
+  return ok;
+}
+
+const OtaPipelineStats& getLastOtaStats() {
+  return lastStats;
+}
+
+void printOtaStats(const OtaPipelineStats& stats) {
+  float seconds = stats.totalMs / 1000.0f;
+  Serial.printf("📦 OTA: %u bytes in %.1f s (%.1f KB/s)\n", stats.bytes, seconds,
+                seconds > 0 ? stats.bytes / 1024.0f / seconds : 0.0f);
+  Serial.printf("  read %u ms, reader stalled %u ms, erase %u ms (%u ms ahead), write %u ms, verify %u ms\n",
+                stats.readMs, stats.stallMs, stats.eraseMs, stats.eraseAheadMs, stats.writeMs, stats.verifyMs);
+}
+
+bool parseSha256Hex(const char* hex, uint8_t* digest) {
+  if (hex == nullptr || strlen(hex) != OTA_SHA256_SIZE * 2) {
+    return false;
+  }
+  for (int i = 0; i < OTA_SHA256_SIZE * 2; i++) {
+    if (!isxdigit((unsigned char)hex[i])) {
+      return false;
+    }
+  }
+  for (int i = 0; i < OTA_SHA256_SIZE; i++) {
+    char byteText[3] = {hex[i * 2], hex[i * 2 + 1], 0};
+    digest[i] = (uint8_t)strtoul(byteText, nullptr, 16);
+  }
+  return true;
+}
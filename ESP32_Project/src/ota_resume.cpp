@@ -0,0 +1,463 @@
+#include "ota_resume.h"
+#include "resource_manager.h"
+#include <Preferences.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <esp_spi_flash.h>
+#include "esp32/rom/miniz.h"
+
+#define RESUME_MARKS (OTA_PIPELINE_BUFFERS + 2)   // Block starts the writer can still be behind
+
+// Saved as one NVS blob
+struct OtaCheckpoint {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t packed;
+  uint8_t windowBits;
+  uint8_t imageSha256[OTA_SHA256_SIZE];    // Identifies the update
+  uint32_t imageSize;
+  uint32_t downloadSize;
+  uint32_t blockSize;
+  uint32_t partitionAddress;
+  uint32_t imageOffset;                    // Image bytes in flash
+  uint32_t downloadOffset;                 // Where the download continues
+  uint8_t prefixSha256[OTA_SHA256_SIZE];   // Digest of those image bytes
+};
+
+// Image offset of a packed block and the download offset of its header
+struct BlockMark {
+  size_t image;
+  size_t download;
+};
+
+struct ResumableDownload {
+  OtaConnectCallback connect;
+  void* connectContext;
+  Client* client;
+  size_t downloadPos;
+  size_t downloadSize;
+  int retries;
+  uint8_t peek[4];             // Format probe of a raw download, handed back as image bytes
+  size_t peekLength;
+  size_t imagePos;             // Image bytes produced
+  size_t imageSize;
+
+  bool packed;
+  size_t blockSize;
+  int windowBits;
+  tinfl_decompressor* inflater;
+  uint8_t* input;
+  size_t inputPos;
+  size_t inputLength;
+  uint8_t* dictionary;         // Wrapping inflate output, also the LZ77 window
+  size_t dictionarySize;
+  size_t dictionaryPos;
+  size_t pendingPos;           // Inflated bytes not yet consumed
+  size_t pendingLength;
+  bool inBlock;
+  bool blockEnded;             // Deflate stream of the block finished
+  size_t blockIn;              // Compressed bytes of the block not yet downloaded
+  size_t blockOut;             // Image bytes of the block not yet produced
+  BlockMark marks[RESUME_MARKS];
+  int markNext;
+
+  bool checkpointing;
+  OtaCheckpoint checkpoint;
+};
+
+static uint32_t get32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// =============================================================================
+// CHECKPOINT STORAGE
+// =============================================================================
+
+static bool loadCheckpoint(OtaCheckpoint& checkpoint) {
+  Preferences prefs;
+  if (!prefs.begin(OTA_RESUME_NVS_NAMESPACE, true)) {
+    return false;   // Nothing saved yet
+  }
+  bool loaded = prefs.getBytesLength(OTA_RESUME_NVS_KEY) == sizeof(checkpoint) &&
+                prefs.getBytes(OTA_RESUME_NVS_KEY, &checkpoint, sizeof(checkpoint)) == sizeof(checkpoint);
+  prefs.end();
+  return loaded && checkpoint.magic == OTA_RESUME_MAGIC && checkpoint.version == OTA_RESUME_VERSION;
+}
+
+static bool saveCheckpoint(const OtaCheckpoint& checkpoint) {
+  Preferences prefs;
+  if (!prefs.begin(OTA_RESUME_NVS_NAMESPACE, false)) {
+    Serial.println("❌ OTA: failed to open NVS for the checkpoint");
+    return false;
+  }
+  size_t written = prefs.putBytes(OTA_RESUME_NVS_KEY, &checkpoint, sizeof(checkpoint));
+  prefs.end();
+  return written == sizeof(checkpoint);
+}
+
+void clearOtaCheckpoint() {
+  Preferences prefs;
+  if (prefs.begin(OTA_RESUME_NVS_NAMESPACE, false)) {
+    prefs.remove(OTA_RESUME_NVS_KEY);
+    prefs.end();
+  }
+}
+
+// A checkpoint only continues the same update into the same partition
+static bool checkpointMatches(const OtaCheckpoint& saved, const esp_partition_t* partition, size_t downloadSize,
+                              const OtaExpectedImage& expected) {
+  bool shapeOk = saved.imageOffset > 0 && saved.imageOffset < saved.imageSize &&
+                 saved.imageOffset % SPI_FLASH_SEC_SIZE == 0 && saved.downloadOffset < saved.downloadSize;
+  if (saved.packed) {
+    shapeOk = shapeOk && saved.windowBits >= 9 && saved.windowBits <= OTA_PACKED_MAX_WINDOW_BITS &&
+              saved.blockSize > 0 && saved.blockSize % OTA_PIPELINE_BUFFER_SIZE == 0;
+  }
+  return shapeOk && saved.imageSize == expected.size && saved.downloadSize == downloadSize &&
+         saved.partitionAddress == partition->address &&
+         memcmp(saved.imageSha256, expected.sha256, OTA_SHA256_SIZE) == 0;
+}
+
+// Re-hashes the written prefix into sha; it must match the checkpoint
+static bool restorePrefix(const esp_partition_t* partition, const OtaCheckpoint& saved, mbedtls_sha256_context& sha) {
+  uint8_t* scratch = (uint8_t*)TRACK_MALLOC(OTA_RESUME_HASH_CHUNK, "ota_resume_scratch");
+  if (scratch == nullptr) {
+    return false;
+  }
+  bool ok = true;
+  for (size_t pos = 0; pos < saved.imageOffset && ok; pos += OTA_RESUME_HASH_CHUNK) {
+    size_t n = min((size_t)OTA_RESUME_HASH_CHUNK, saved.imageOffset - pos);
+    ok = esp_partition_read(partition, pos, scratch, n) == ESP_OK;
+    mbedtls_sha256_update_ret(&sha, scratch, n);
+  }
+  TRACK_FREE(scratch, "ota_resume_scratch");
+
+  uint8_t digest[OTA_SHA256_SIZE];
+  mbedtls_sha256_context prefix;
+  mbedtls_sha256_init(&prefix);
+  mbedtls_sha256_clone(&prefix, &sha);
+  mbedtls_sha256_finish_ret(&prefix, digest);
+  mbedtls_sha256_free(&prefix);
+  return ok && memcmp(digest, saved.prefixSha256, OTA_SHA256_SIZE) == 0;
+}
+
+// OtaDurableCallback: checkpoint when enough new image is in flash and the
+// download can continue from that point
+static void onDurable(void* context, size_t offset, const mbedtls_sha256_context& sha) {
+  ResumableDownload& d = *static_cast<ResumableDownload*>(context);
+  if (!d.checkpointing || offset < d.checkpoint.imageOffset + OTA_RESUME_INTERVAL || offset >= d.imageSize) {
+    return;
+  }
+  size_t downloadOffset = offset;   // Raw download: the image itself
+  if (d.packed) {
+    downloadOffset = 0;
+    for (int i = 0; i < RESUME_MARKS; i++) {
+      if (d.marks[i].download > 0 && d.marks[i].image == offset) {
+        downloadOffset = d.marks[i].download;
+      }
+    }
+    if (downloadOffset == 0) {
+      return;   // Not a block boundary
+    }
+  }
+
+  mbedtls_sha256_context prefix;
+  mbedtls_sha256_init(&prefix);
+  mbedtls_sha256_clone(&prefix, &sha);
+  mbedtls_sha256_finish_ret(&prefix, d.checkpoint.prefixSha256);
+  mbedtls_sha256_free(&prefix);
+  d.checkpoint.imageOffset = offset;
+  d.checkpoint.downloadOffset = downloadOffset;
+  saveCheckpoint(d.checkpoint);
+}
+
+// =============================================================================
+// DOWNLOAD STREAM
+// =============================================================================
+
+static bool reconnect(ResumableDownload& d) {
+  while (d.retries < OTA_RESUME_RETRIES) {
+    uint32_t backoff = (uint32_t)OTA_RESUME_BACKOFF_MS << d.retries;
+    d.retries++;
+    Serial.printf("🔁 OTA: connection lost at %u of %u bytes, retry %d in %lu ms\n",
+                  d.downloadPos, d.downloadSize, d.retries, (unsigned long)backoff);
+    delay(backoff);
+    d.client = d.connect(d.connectContext, d.downloadPos);
+    if (d.client != nullptr) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Next length download bytes, reconnecting at the current offset as needed
+static size_t fetch(ResumableDownload& d, uint8_t* data, size_t length) {
+  size_t got = 0;
+  while (got < length) {
+    size_t n = d.client != nullptr ? readOtaStream(*d.client, data + got, length - got) : 0;
+    got += n;
+    d.downloadPos += n;
+    if (got < length && !reconnect(d)) {
+      break;
+    }
+  }
+  return got;
+}
+
+// OtaImageReader for a raw image download
+static size_t rawReader(void* context, uint8_t* data, size_t length) {
+  ResumableDownload& d = *static_cast<ResumableDownload*>(context);
+  size_t filled = min(length, d.peekLength);
+  memcpy(data, d.peek, filled);
+  memmove(d.peek, d.peek + filled, d.peekLength - filled);
+  d.peekLength -= filled;
+  filled += fetch(d, data + filled, length - filled);
+  d.imagePos += filled;
+  return filled;
+}
+
+// =============================================================================
+// PACKED IMAGE
+// =============================================================================
+
+static bool inflateMore(ResumableDownload& d) {
+  if (d.blockEnded) {
+    Serial.printf("❌ OTA: packed block ends early at image byte %u\n", d.imagePos);
+    return false;
+  }
+  if (d.inputPos == d.inputLength && d.blockIn > 0) {
+    size_t want = min((size_t)OTA_PACKED_INPUT_SIZE, d.blockIn);
+    if (fetch(d, d.input, want) != want) {
+      return false;
+    }
+    d.inputPos = 0;
+    d.inputLength = want;
+    d.blockIn -= want;
+  }
+
+  size_t inBytes = d.inputLength - d.inputPos;
+  size_t outBytes = d.dictionarySize - d.dictionaryPos;
+  tinfl_status status = tinfl_decompress(d.inflater, d.input + d.inputPos, &inBytes,
+                                         d.dictionary, d.dictionary + d.dictionaryPos, &outBytes,
+                                         d.blockIn > 0 ? TINFL_FLAG_HAS_MORE_INPUT : 0);
+  d.inputPos += inBytes;
+  d.pendingPos = d.dictionaryPos;
+  d.pendingLength = outBytes;
+  d.dictionaryPos = (d.dictionaryPos + outBytes) & (d.dictionarySize - 1);
+  if (status < TINFL_STATUS_DONE) {
+    Serial.printf("❌ OTA: corrupt packed block at image byte %u (inflate %d)\n", d.imagePos, (int)status);
+    return false;
+  }
+  d.blockEnded = (status == TINFL_STATUS_DONE);
+  return true;
+}
+
+static bool startBlock(ResumableDownload& d) {
+  d.marks[d.markNext] = {d.imagePos, d.downloadPos};
+  d.markNext = (d.markNext + 1) % RESUME_MARKS;
+
+  uint8_t length[4];
+  if (fetch(d, length, sizeof(length)) != sizeof(length)) {
+    return false;
+  }
+  d.blockIn = get32(length);
+  d.blockOut = min(d.blockSize, d.imageSize - d.imagePos);
+  if (d.blockIn == 0 || d.blockIn > d.downloadSize - d.downloadPos) {
+    Serial.printf("❌ OTA: packed block at image byte %u has a bad length (%u)\n", d.imagePos, d.blockIn);
+    return false;
+  }
+  tinfl_init(d.inflater);
+  d.inputPos = d.inputLength = 0;
+  d.dictionaryPos = 0;
+  d.pendingLength = 0;
+  d.blockEnded = false;
+  d.inBlock = true;
+  return true;
+}
+
+// The block's deflate stream must end exactly with its image bytes
+static bool finishBlock(ResumableDownload& d) {
+  while (d.pendingLength == 0 && !d.blockEnded) {
+    if (!inflateMore(d)) return false;
+  }
+  if (d.pendingLength > 0 || d.blockIn > 0 || d.inputPos < d.inputLength) {
+    Serial.printf("❌ OTA: packed block before image byte %u does not match the block size\n", d.imagePos);
+    return false;
+  }
+  d.inBlock = false;
+  return true;
+}
+
+// OtaImageReader for a packed download
+static size_t packedReader(void* context, uint8_t* data, size_t length) {
+  ResumableDownload& d = *static_cast<ResumableDownload*>(context);
+  size_t filled = 0;
+  while (filled < length) {
+    if (!d.inBlock) {
+      if (!startBlock(d)) break;
+      continue;
+    }
+    if (d.pendingLength == 0) {
+      if (!inflateMore(d)) break;
+      continue;
+    }
+    size_t n = min(min(length - filled, d.pendingLength), d.blockOut);
+    memcpy(data + filled, d.dictionary + d.pendingPos, n);
+    d.pendingPos += n;
+    d.pendingLength -= n;
+    d.blockOut -= n;
+    d.imagePos += n;
+    filled += n;
+    if (d.blockOut == 0 && !finishBlock(d)) break;
+  }
+  return filled;
+}
+
+// Raw image, or the packed header (which must describe the expected image)
+static bool readFormat(ResumableDownload& d, const OtaExpectedImage& expected) {
+  if (fetch(d, d.peek, sizeof(d.peek)) != sizeof(d.peek)) {
+    return false;
+  }
+  if (memcmp(d.peek, OTA_PACKED_MAGIC, sizeof(d.peek)) != 0) {
+    if (d.downloadSize != expected.size) {
+      Serial.printf("❌ OTA: download is %u bytes, image %u\n", d.downloadSize, expected.size);
+      return false;
+    }
+    d.peekLength = sizeof(d.peek);
+    return true;
+  }
+
+  uint8_t header[OTA_PACKED_HEADER_SIZE];
+  memcpy(header, d.peek, sizeof(d.peek));
+  if (fetch(d, header + sizeof(d.peek), sizeof(header) - sizeof(d.peek)) != sizeof(header) - sizeof(d.peek)) {
+    return false;
+  }
+  int windowBits = header[5];
+  size_t blockSize = get32(header + 12);
+  if (header[4] != OTA_PACKED_VERSION || windowBits < 9 || windowBits > OTA_PACKED_MAX_WINDOW_BITS ||
+      blockSize == 0 || blockSize % OTA_PIPELINE_BUFFER_SIZE != 0) {
+    Serial.printf("❌ OTA: unsupported packed image (version %d, window %d bits, %u byte blocks)\n",
+                  header[4], windowBits, blockSize);
+    return false;
+  }
+  if (get32(header + 8) != expected.size ||
+      (expected.sha256 != nullptr && memcmp(header + 16, expected.sha256, OTA_SHA256_SIZE) != 0)) {
+    Serial.printf("❌ OTA: packed image is not the manifest image (%u bytes, manifest %u)\n",
+                  get32(header + 8), expected.size);
+    return false;
+  }
+  d.packed = true;
+  d.windowBits = windowBits;
+  d.blockSize = blockSize;
+  return true;
+}
+
+static void releaseDecoder(ResumableDownload& d) {
+  if (d.inflater != nullptr) TRACK_FREE(d.inflater, "ota_packed_inflater");
+  if (d.input != nullptr) TRACK_FREE(d.input, "ota_packed_input");
+  if (d.dictionary != nullptr) TRACK_FREE(d.dictionary, "ota_packed_dictionary");
+  d.inflater = nullptr;
+  d.input = nullptr;
+  d.dictionary = nullptr;
+}
+
+static bool allocateDecoder(ResumableDownload& d) {
+  d.dictionarySize = (size_t)1 << d.windowBits;
+  d.inflater = (tinfl_decompressor*)TRACK_MALLOC(sizeof(tinfl_decompressor), "ota_packed_inflater");
+  d.input = (uint8_t*)TRACK_MALLOC(OTA_PACKED_INPUT_SIZE, "ota_packed_input");
+  d.dictionary = (uint8_t*)TRACK_MALLOC(d.dictionarySize, "ota_packed_dictionary");
+  if (d.inflater == nullptr || d.input == nullptr || d.dictionary == nullptr) {
+    Serial.printf("❌ OTA: no memory for the packed decoder (%u bytes)\n",
+                  sizeof(tinfl_decompressor) + OTA_PACKED_INPUT_SIZE + d.dictionarySize);
+    releaseDecoder(d);
+    return false;
+  }
+  return true;
+}
+
+// =============================================================================
+// INSTALL
+// =============================================================================
+
+bool installResumableOta(OtaConnectCallback connect, void* context, size_t downloadSize,
+                         const OtaExpectedImage& expected, OtaPipelineStats& stats) {
+  const esp_partition_t* partition = esp_ota_get_next_update_partition(nullptr);
+  if (partition == nullptr || expected.size == 0 || downloadSize == 0) {
+    Serial.println("❌ OTA: update partition, image size and download size are required");
+    return false;
+  }
+
+  ResumableDownload d = {};
+  d.connect = connect;
+  d.connectContext = context;
+  d.downloadSize = downloadSize;
+  d.imageSize = expected.size;
+  d.checkpointing = expected.sha256 != nullptr;   // Without a digest the update has no identity
+
+  OtaResume resume = {};
+  resume.durable = onDurable;
+  resume.context = &d;
+  mbedtls_sha256_init(&resume.sha);
+  mbedtls_sha256_starts_ret(&resume.sha, 0);
+
+  OtaCheckpoint saved;
+  if (d.checkpointing && loadCheckpoint(saved)) {
+    uint32_t start = millis();
+    if (checkpointMatches(saved, partition, downloadSize, expected) && restorePrefix(partition, saved, resume.sha)) {
+      d.checkpoint = saved;
+      d.packed = saved.packed;
+      d.windowBits = saved.windowBits;
+      d.blockSize = saved.blockSize;
+      d.imagePos = resume.offset = saved.imageOffset;
+      d.downloadPos = saved.downloadOffset;
+      Serial.printf("⏯️ OTA: resuming at %u of %u bytes (prefix verified in %lu ms)\n",
+                    saved.imageOffset, saved.imageSize, (unsigned long)(millis() - start));
+    } else {
+      Serial.println("⚠️ OTA: saved checkpoint does not apply, starting over");
+      clearOtaCheckpoint();
+      mbedtls_sha256_starts_ret(&resume.sha, 0);
+    }
+  }
+
+  d.client = connect(context, d.downloadPos);
+  if (d.client == nullptr && resume.offset > 0) {
+    Serial.println("⚠️ OTA: server cannot resume the download, starting over");
+    clearOtaCheckpoint();
+    d.packed = false;
+    d.imagePos = resume.offset = 0;
+    d.downloadPos = 0;
+    mbedtls_sha256_starts_ret(&resume.sha, 0);
+    d.client = connect(context, 0);
+  }
+
+  bool ok = d.client != nullptr && (d.downloadPos > 0 || readFormat(d, expected));
+  if (ok && resume.offset == 0 && d.checkpointing) {
+    d.checkpoint = OtaCheckpoint{};
+    d.checkpoint.magic = OTA_RESUME_MAGIC;
+    d.checkpoint.version = OTA_RESUME_VERSION;
+    d.checkpoint.packed = d.packed;
+    d.checkpoint.windowBits = d.windowBits;
+    memcpy(d.checkpoint.imageSha256, expected.sha256, OTA_SHA256_SIZE);
+    d.checkpoint.imageSize = expected.size;
+    d.checkpoint.downloadSize = downloadSize;
+    d.checkpoint.blockSize = d.blockSize;
+    d.checkpoint.partitionAddress = partition->address;
+  }
+  if (ok && d.packed) {
+    ok = allocateDecoder(d);
+    if (ok) {
+      Serial.printf("🗜️ OTA: packed image, %u byte download for %u bytes (%u KB blocks)\n",
+                    downloadSize, expected.size, d.blockSize / 1024);
+    }
+  }
+  if (ok) {
+    ok = installOtaImageFrom(d.packed ? packedReader : rawReader, &d, expected, stats, &resume);
+  }
+
+  // A complete image has nothing left to resume, whether it verified or not
+  if (ok || d.imagePos >= d.imageSize) {
+    clearOtaCheckpoint();
+  }
+  releaseDecoder(d);
+  mbedtls_sha256_free(&resume.sha);
+  return ok;
+}
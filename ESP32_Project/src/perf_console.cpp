@@ -0,0 +1,544 @@
+#include "perf_console.h"
+
+#if FEATURE_PERFORMANCE_COMMANDS
+
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include <esp_task_wdt.h>
+#include <mbedtls/md.h>
+#include "diagnostics_endpoints.h"
+#include "websocket_handler.h"
+#include "utterance_trace.h"
+#include "sampling_profiler.h"
+#include "metrics_registry.h"
+#include "metrics_history.h"
+#include "event_bus.h"
+#include "audio_frame.h"
+#include "alloc_guard.h"
+#include "resource_manager.h"
+#include "memory_budget.h"
+#include "encoding_service.h"
+#include "anomaly_detector.h"
+#include "audio_tap.h"
+#include "stack_monitor.h"
+
+static char lineBuffer[PERF_CONSOLE_LINE_MAX];
+static uint8_t lineLength = 0;
+static bool lineOverflow = false;
+
+static const PerfCommand* getCommandTable(size_t& count);
+
+// =============================================================================
+// HELPERS
+// =============================================================================
+
+static bool parseInt(const char* text, int32_t& value) {
+  if (text == nullptr || *text == '\0') return false;
+  char* end = nullptr;
+  long parsed = strtol(text, &end, 10);
+  if (*end != '\0') return false;
+  value = (int32_t)parsed;
+  return true;
+}
+
+// Diagnostics pages reused as Serial output
+static bool serialSink(void*, const char* data, size_t length) {
+  Serial.write((const uint8_t*)data, length);
+  return true;
+}
+
+static void renderToSerial(void (*render)(ResponseStream&)) {
+  ResponseStream out(serialSink, nullptr);
+  render(out);
+}
+
+// =============================================================================
+// TUNING KNOBS
+// =============================================================================
+
+struct PerfKnob {
+  const char* name;
+  const char* unit;
+  int32_t minValue;
+  int32_t maxValue;
+  int32_t (*get)();
+  bool (*set)(int32_t value);
+};
+
+static int32_t getCpuMhz() { return (int32_t)getCpuFrequencyMhz(); }
+static bool setCpuMhz(int32_t mhz) {
+  // Only the PLL-derived frequencies keep WiFi running
+  if (mhz != 80 && mhz != 160 && mhz != 240) return false;
+  return setCpuFrequencyMhz((uint32_t)mhz);
+}
+
+static int32_t getWiFiSleep() { return WiFi.getSleep() ? 1 : 0; }
+static bool setWiFiSleep(int32_t on) { return WiFi.setSleep(on != 0); }
+
+static int32_t getWiFiTxPower() { return (int32_t)WiFi.getTxPower(); }
+static bool setWiFiTxPower(int32_t quarterDbm) { return WiFi.setTxPower((wifi_power_t)quarterDbm); }
+
+static int32_t getWsChunk() { return (int32_t)getAdaptiveChunkSize(); }
+static bool setWsChunk(int32_t bytes) { setAdaptiveChunkSize((size_t)bytes); return true; }
+
+static const PerfKnob perfKnobs[] = {
+  {"cpu_mhz",     "MHz",     80,   240, getCpuMhz,      setCpuMhz},
+  {"wifi_sleep",  "0/1",     0,    1,   getWiFiSleep,   setWiFiSleep},
+  {"wifi_tx",     "0.25dBm", 8,    84,  getWiFiTxPower, setWiFiTxPower},
+  {"ws_chunk",    "bytes",   512,  8192, getWsChunk,    setWsChunk},
+};
+
+static const PerfKnob* findKnob(const char* name) {
+  for (const PerfKnob& k : perfKnobs) {
+    if (strcmp(k.name, name) == 0) return &k;
+  }
+  return nullptr;
+}
+
+// =============================================================================
+// MICROBENCHMARKS
+// =============================================================================
+
+#define BENCH_OUTPUT_BYTES (PERF_BENCH_PAYLOAD_BYTES * 4 / 3 + 64)
+
+struct BenchScratch {
+  uint8_t* input;     // PERF_BENCH_PAYLOAD_BYTES of pseudo-random PCM
+  uint8_t* output;    // BENCH_OUTPUT_BYTES
+  char* text;         // The input in base64, BENCH_OUTPUT_BYTES
+  size_t textLength;
+};
+
+struct PerfBenchmark {
+  const char* name;
+  const char* description;
+  void (*run)(BenchScratch& scratch);   // One iteration
+};
+
+static void* volatile benchSink;   // Keeps allocations from being optimized out
+
+static void benchMemcpy(BenchScratch& s) {
+  memcpy(s.output, s.input, PERF_BENCH_PAYLOAD_BYTES);
+}
+
+static void benchMalloc(BenchScratch&) {
+  benchSink = malloc(PERF_BENCH_PAYLOAD_BYTES);
+  free(benchSink);
+}
+
+static void benchPool(BenchScratch&) {
+  benchSink = poolAlloc(PERF_BENCH_PAYLOAD_BYTES);
+  poolFree(benchSink);
+}
+
+static void benchBase64(BenchScratch& s) {
+  size_t n;
+  base64Encode(s.input, PERF_BENCH_PAYLOAD_BYTES, (char*)s.output, BENCH_OUTPUT_BYTES, &n);
+}
+
+static void benchBase64Decode(BenchScratch& s) {
+  size_t n;
+  base64Decode(s.text, s.textLength, s.output, BENCH_OUTPUT_BYTES, &n);
+}
+
+static void benchHmac(BenchScratch& s) {
+  static const uint8_t key[32] = {0x42};
+  mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), key, sizeof(key),
+                  s.input, PERF_BENCH_PAYLOAD_BYTES, s.output);
+}
+
+static void benchJson(BenchScratch& s) {
+  StaticJsonDocument<256> doc;
+  doc["type"] = "audio_chunk";
+  doc["chunk_id"] = "123456_7890";
+  doc["audio_session_id"] = "bench";
+  doc["is_final"] = false;
+  doc["utterance_id"] = 305419896;
+  doc["hmac"] = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+  serializeJson(doc, (char*)s.output, BENCH_OUTPUT_BYTES);
+}
+
+static void benchAudioFrame(BenchScratch& s) {
+  StaticJsonDocument<128> meta;
+  meta["type"] = "audio_chunk";
+  meta["is_final"] = false;
+  AudioFrame frame = buildAudioTextFrame(s.input, PERF_BENCH_PAYLOAD_BYTES, meta);
+}
+
+static const PerfBenchmark perfBenchmarks[] = {
+  {"memcpy", "4 KB memcpy",                          benchMemcpy},
+  {"malloc", "4 KB malloc + free",                   benchMalloc},
+  {"pool",   "4 KB poolAlloc + poolFree",            benchPool},
+  {"base64", "base64 encode 4 KB",                   benchBase64},
+  {"b64dec", "base64 decode to 4 KB",                benchBase64Decode},
+  {"hmac",   "HMAC-SHA256 over 4 KB",                benchHmac},
+  {"json",   "serialize audio_chunk metadata",       benchJson},
+  {"frame",  "build 4 KB audio text frame",          benchAudioFrame},
+};
+
+static void runBenchmark(const PerfBenchmark& bench, BenchScratch& scratch, uint32_t iterations) {
+  bench.run(scratch);   // Warm caches and pools
+  uint32_t worstUs = 0;
+  int64_t start = esp_timer_get_time();
+  for (uint32_t i = 0; i < iterations; i++) {
+    int64_t iterStart = esp_timer_get_time();
+    bench.run(scratch);
+    worstUs = max(worstUs, (uint32_t)(esp_timer_get_time() - iterStart));
+    if ((i & 31) == 31) {
+      esp_task_wdt_reset();
+    }
+  }
+  uint32_t totalUs = (uint32_t)(esp_timer_get_time() - start);
+  Serial.printf("  %-8s %9.2f us/iter  max %6u us  (%u iterations)  %s\n", bench.name,
+                (double)totalUs / iterations, worstUs, iterations, bench.description);
+}
+
+// =============================================================================
+// COMMANDS
+// =============================================================================
+
+static void cmdHelp(int, char**) {
+  size_t count = 0;
+  const PerfCommand* commands = getCommandTable(count);
+  Serial.println("=== 🛠️ Performance Console ===");
+  for (size_t i = 0; i < count; i++) {
+    Serial.printf("  %-8s %s\n", commands[i].name, commands[i].usage);
+  }
+}
+
+static void cmdTasks(int, char**) {
+  renderToSerial(renderDebugTasks);
+}
+
+static void cmdStack(int, char**) {
+  printStackReport();
+}
+
+static void cmdHeap(int, char**) {
+  renderToSerial(renderDebugHeap);
+  printMemoryBudget();
+}
+
+static void cmdLatency(int, char**) {
+  renderToSerial(renderDebugLatency);
+}
+
+static void cmdAudio(int, char**) {
+  printTraceStageSummary();
+  printAudioFrameStats();
+}
+
+static void cmdMetrics(int, char**) {
+  printMetricsRegistry();
+}
+
+static void cmdHistory(int, char**) {
+  printMetricsHistory();
+}
+
+static void cmdBus(int, char**) {
+  printEventBusStats();
+}
+
+static void cmdAlloc(int, char**) {
+  printAllocGuardReport();
+}
+
+static void cmdAnomaly(int, char**) {
+  printAnomalyStatus();
+}
+
+#if FEATURE_AUDIO_TAPS
+// Tap names (or "all") from argv[first] on, as a mask
+static bool parseTapMask(int argc, char** argv, int first, uint32_t& mask) {
+  mask = 0;
+  for (int i = first; i < argc; i++) {
+    AudioTapPoint tap;
+    if (strcmp(argv[i], "all") == 0) {
+      mask = AUDIO_TAP_ALL;
+    } else if (findAudioTap(argv[i], tap)) {
+      mask |= 1u << tap;
+    } else {
+      Serial.printf("❌ Unknown tap: %s\n", argv[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+static void cmdTap(int argc, char** argv) {
+  uint32_t mask = 0;
+  if (argc >= 2 && strcmp(argv[1], "on") == 0) {
+    if (!parseTapMask(argc, argv, 2, mask) || mask == 0) {
+      Serial.println("❌ Usage: tap on <capture|send|playback|all>...");
+      return;
+    }
+    enableAudioTaps(mask);
+  } else if (argc == 2 && strcmp(argv[1], "off") == 0) {
+    enableAudioTaps(0);
+  } else if (argc >= 2 && strcmp(argv[1], "save") == 0) {
+    if (!parseTapMask(argc, argv, 2, mask)) return;
+    mask = (argc == 2 ? AUDIO_TAP_ALL : mask) & getEnabledAudioTaps();
+    for (int i = 0; i < AUDIO_TAP_COUNT; i++) {
+      if (mask & (1u << i)) saveAudioTap((AudioTapPoint)i);
+    }
+    return;
+  } else if (argc != 1) {
+    Serial.println("❌ Usage: tap [on <names|all> | off | save [names]]");
+    return;
+  }
+  renderToSerial(renderDebugTaps);
+}
+#endif
+
+static void cmdFeatures(int, char**) {
+  printFeatureConfiguration();
+}
+
+static void cmdNet(int argc, char** argv) {
+  ForcedNetworkConditions net = getForcedNetworkConditions();
+  if (argc == 2 && strcmp(argv[1], "off") == 0) {
+    net = {0, 0, 0};
+  } else if (argc == 3) {
+    int32_t value;
+    if (!parseInt(argv[2], value)) {
+      Serial.printf("❌ Not a number: %s\n", argv[2]);
+      return;
+    }
+    if (strcmp(argv[1], "rssi") == 0 && value >= -100 && value <= 0) {
+      net.rssi = (int8_t)value;
+    } else if (strcmp(argv[1], "loss") == 0 && value >= 0 && value <= 100) {
+      net.lossPercent = (uint8_t)value;
+    } else if (strcmp(argv[1], "delay") == 0 && value >= 0 && value <= WS_FORCED_DELAY_MAX_MS) {
+      net.delayMs = (uint16_t)value;
+    } else {
+      Serial.println("❌ Usage: net rssi <-100..0> | loss <0..100> | delay <0..1000> | off");
+      return;
+    }
+  } else if (argc != 1) {
+    Serial.println("❌ Usage: net rssi <-100..0> | loss <0..100> | delay <0..1000> | off");
+    return;
+  }
+  setForcedNetworkConditions(net);
+
+  net = getForcedNetworkConditions();
+  if (net.rssi == 0) {
+    Serial.printf("📶 RSSI: measured (%d dBm)", WiFi.RSSI());
+  } else {
+    Serial.printf("📶 RSSI: forced %d dBm", net.rssi);
+  }
+  Serial.printf(", audio loss %u%%, added delay %u ms\n", net.lossPercent, net.delayMs);
+}
+
+static void cmdKnob(int argc, char** argv) {
+  if (argc == 1) {
+    for (const PerfKnob& k : perfKnobs) {
+      Serial.printf("  %-12s %6d %-8s [%d..%d]\n", k.name, k.get(), k.unit, k.minValue, k.maxValue);
+    }
+    return;
+  }
+
+  const PerfKnob* knob = findKnob(argv[1]);
+  if (knob == nullptr) {
+    Serial.printf("❌ Unknown knob '%s' (knob lists them)\n", argv[1]);
+    return;
+  }
+  if (argc >= 3) {
+    int32_t value;
+    if (!parseInt(argv[2], value) || value < knob->minValue || value > knob->maxValue) {
+      Serial.printf("❌ %s takes %d..%d %s\n", knob->name, knob->minValue, knob->maxValue, knob->unit);
+      return;
+    }
+    int32_t previous = knob->get();
+    if (!knob->set(value)) {
+      Serial.printf("❌ %s rejected %d\n", knob->name, value);
+      return;
+    }
+    Serial.printf("🎛️ %s: %d -> %d %s\n", knob->name, previous, knob->get(), knob->unit);
+    return;
+  }
+  Serial.printf("🎛️ %s: %d %s\n", knob->name, knob->get(), knob->unit);
+}
+
+static void cmdBench(int argc, char** argv) {
+  const char* which = argc >= 2 ? argv[1] : "all";
+  int32_t iterations = PERF_BENCH_DEFAULT_ITERATIONS;
+  if (argc >= 3 && (!parseInt(argv[2], iterations) || iterations < 1 ||
+                    iterations > PERF_BENCH_MAX_ITERATIONS)) {
+    Serial.printf("❌ Iterations must be 1..%d\n", PERF_BENCH_MAX_ITERATIONS);
+    return;
+  }
+
+  bool all = strcmp(which, "all") == 0;
+  const PerfBenchmark* selected = nullptr;
+  if (!all) {
+    for (const PerfBenchmark& b : perfBenchmarks) {
+      if (strcmp(b.name, which) == 0) selected = &b;
+    }
+    if (selected == nullptr) {
+      Serial.print("❌ Unknown benchmark. Available:");
+      for (const PerfBenchmark& b : perfBenchmarks) {
+        Serial.printf(" %s", b.name);
+      }
+      Serial.println();
+      return;
+    }
+  }
+
+  BenchScratch scratch;
+  scratch.input = (uint8_t*)malloc(PERF_BENCH_PAYLOAD_BYTES);
+  scratch.output = (uint8_t*)malloc(BENCH_OUTPUT_BYTES);
+  scratch.text = (char*)malloc(BENCH_OUTPUT_BYTES);
+  if (scratch.input == nullptr || scratch.output == nullptr || scratch.text == nullptr) {
+    Serial.println("❌ Not enough memory for benchmark buffers");
+    free(scratch.input);
+    free(scratch.output);
+    free(scratch.text);
+    return;
+  }
+  for (size_t i = 0; i < PERF_BENCH_PAYLOAD_BYTES; i++) {
+    scratch.input[i] = (uint8_t)esp_random();
+  }
+  base64Encode(scratch.input, PERF_BENCH_PAYLOAD_BYTES, scratch.text, BENCH_OUTPUT_BYTES, &scratch.textLength);
+
+  Serial.printf("=== ⏱️ Microbenchmarks (CPU %u MHz) ===\n", getCpuFrequencyMhz());
+  if (all) {
+    for (const PerfBenchmark& b : perfBenchmarks) {
+      runBenchmark(b, scratch, (uint32_t)iterations);
+    }
+  } else {
+    runBenchmark(*selected, scratch, (uint32_t)iterations);
+  }
+
+  free(scratch.input);
+  free(scratch.output);
+  free(scratch.text);
+}
+
+static void cmdProfile(int argc, char** argv) {
+  if (argc >= 2 && strcmp(argv[1], "stop") == 0) {
+    stopProfiler();
+    dumpProfile();
+    releaseProfile();
+    return;
+  }
+  if (argc >= 2 && strcmp(argv[1], "start") == 0) {
+    int32_t hz = PROFILER_DEFAULT_HZ;
+    int32_t durationMs = 0;
+    if ((argc >= 3 && !parseInt(argv[2], hz)) || (argc >= 4 && !parseInt(argv[3], durationMs)) ||
+        hz < 1 || hz > PROFILER_MAX_HZ || durationMs < 0) {
+      Serial.printf("❌ Usage: prof start [1..%d Hz] [duration ms]\n", PROFILER_MAX_HZ);
+      return;
+    }
+    if (startProfiler((uint32_t)hz, (uint32_t)durationMs)) {
+      Serial.printf("🔬 Profiling at %d Hz%s\n", hz, durationMs > 0 ? " (uploads when done)" : "; prof stop to dump");
+    }
+    return;
+  }
+  Serial.printf("🔬 Profiler %s, %u samples, %u dropped\n", isProfilerRunning() ? "running" : "idle",
+                getProfilerSampleCount(), getProfilerDroppedCount());
+}
+
+static const PerfCommand perfCommands[] = {
+  {"help",     "list commands",                                   cmdHelp},
+  {"tasks",    "task CPU, priorities and stack margins",          cmdTasks},
+  {"stack",    "stack peaks, sizing hints, [STACK][TASK] lines",  cmdStack},
+  {"heap",     "heap regions, pools, arenas and budget",          cmdHeap},
+  {"lat",      "latency histogram percentiles",                   cmdLatency},
+  {"audio",    "stage timings of the latest utterance, frames",   cmdAudio},
+  {"metrics",  "metrics registry dump",                           cmdMetrics},
+  {"history",  "metrics history summary",                         cmdHistory},
+  {"bus",      "event bus queues and drops",                      cmdBus},
+  {"alloc",    "steady-state allocation report",                  cmdAlloc},
+  {"anomaly",  "detector baselines, CUSUM sums and heap trend",   cmdAnomaly},
+#if FEATURE_AUDIO_TAPS
+  {"tap",      "[on <names|all> | off | save [names]] audio taps", cmdTap},
+#endif
+  {"features", "compiled feature flags",                          cmdFeatures},
+  {"net",      "[rssi N | loss P | delay MS | off] force network", cmdNet},
+  {"knob",     "[name [value]] list, read or set tuning knobs",   cmdKnob},
+  {"bench",    "[name|all] [iterations] run microbenchmarks",     cmdBench},
+  {"prof",     "[start [hz] [ms] | stop] sampling profiler",      cmdProfile},
+};
+
+static const PerfCommand* getCommandTable(size_t& count) {
+  count = sizeof(perfCommands) / sizeof(perfCommands[0]);
+  return perfCommands;
+}
+
+// =============================================================================
+// PARSER AND DISPATCH
+// =============================================================================
+
+int splitCommandLine(char* line, char** argv, int maxArgs) {
+  int argc = 0;
+  char* p = line;
+  while (*p != '\0' && argc < maxArgs) {
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p == '\0') break;
+    argv[argc++] = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t') p++;
+    if (*p != '\0') *p++ = '\0';
+  }
+  return argc;
+}
+
+const PerfCommand* findPerfCommand(const char* name) {
+  for (const PerfCommand& c : perfCommands) {
+    if (strcmp(c.name, name) == 0) return &c;
+  }
+  return nullptr;
+}
+
+bool executePerfCommand(char* line) {
+  char* argv[PERF_CONSOLE_MAX_ARGS];
+  int argc = splitCommandLine(line, argv, PERF_CONSOLE_MAX_ARGS);
+  if (argc == 0) return true;
+
+  const PerfCommand* command = findPerfCommand(argv[0]);
+  if (command == nullptr) {
+    Serial.printf("❓ Unknown command '%s' (help lists commands)\n", argv[0]);
+    return false;
+  }
+  command->handler(argc, argv);
+  return true;
+}
+
+// =============================================================================
+// SERIAL INPUT
+// =============================================================================
+
+void initPerfConsole() {
+  lineLength = 0;
+  lineOverflow = false;
+  Serial.println("🛠️ Performance console ready (type 'help')");
+}
+
+void handlePerfConsole() {
+  // Bounded per call so a paste never stalls the loop
+  for (uint8_t n = 0; n < PERF_CONSOLE_MAX_READ && Serial.available() > 0; n++) {
+    int c = Serial.read();
+    if (c < 0) break;
+
+    if (c == '\n' || c == '\r') {
+      if (lineOverflow) {
+        Serial.printf("❌ Line longer than %d characters ignored\n", PERF_CONSOLE_LINE_MAX - 1);
+      } else if (lineLength > 0) {
+        lineBuffer[lineLength] = '\0';
+        executePerfCommand(lineBuffer);
+      }
+      lineLength = 0;
+      lineOverflow = false;
+    } else if (c == 0x08 || c == 0x7f) {   // Backspace from interactive terminals
+      if (lineLength > 0) lineLength--;
+    } else if (c >= 32 && c <= 126) {
+      if (lineLength < PERF_CONSOLE_LINE_MAX - 1) {
+        lineBuffer[lineLength++] = (char)c;
+      } else {
+        lineOverflow = true;
+      }
+    }
+  }
+}
+
+#endif // FEATURE_PERFORMANCE_COMMANDS
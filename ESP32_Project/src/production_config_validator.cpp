@@ -25,6 +25,7 @@
 #include "monitoring.h"
 #include "hardware.h"
 #include "websocket_handler.h"
+#include "stack_monitor.h"
 #include <WiFi.h>
 #include <SPIFFS.h>
 #include <esp_task_wdt.h>
@@ -1086,7 +1087,7 @@ void ProductionValidator::startContinuousMonitoring() {
     
     continuousMonitoringActive = true;
     
-    xTaskCreate(continuousMonitoringTask, "prod_monitor", 8192, this, 2, &monitoringTaskHandle);
+    xTaskCreate(continuousMonitoringTask, "prod_monitor", PRODUCTION_MONITOR_STACK_SIZE, this, 2, &monitoringTaskHandle);
     ESP_LOGI(TAG, "📊 Started continuous production monitoring");
 }
 
@@ -1098,6 +1099,7 @@ void ProductionValidator::stopContinuousMonitoring() {
     continuousMonitoringActive = false;
     
     if (monitoringTaskHandle) {
+        forgetTaskStack(monitoringTaskHandle);
         vTaskDelete(monitoringTaskHandle);
         monitoringTaskHandle = nullptr;
     }
@@ -1107,6 +1109,7 @@ void ProductionValidator::stopContinuousMonitoring() {
 
 void ProductionValidator::continuousMonitoringTask(void* parameter) {
     ProductionValidator* validator = static_cast<ProductionValidator*>(parameter);
+    registerCurrentTaskStack("prod_monitor", PRODUCTION_MONITOR_STACK_SIZE);
     
     while (validator->continuousMonitoringActive) {
         // Run lightweight production checks
@@ -1127,6 +1130,7 @@ void ProductionValidator::continuousMonitoringTask(void* parameter) {
         vTaskDelay(pdMS_TO_TICKS(PRODUCTION_CHECK_INTERVAL_MS));
     }
     
+    noteTaskStackExit();
     vTaskDelete(nullptr);
 }
 
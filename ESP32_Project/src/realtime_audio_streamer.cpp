@@ -4,10 +4,18 @@
 #include "monitoring.h"
 #include "encoding_service.h"
 #include "device_id_manager.h"  // Dynamic device ID
+#include "metrics_registry.h"
+#include "resource_manager.h"
+#include "json_arena.h"
+#include "stack_monitor.h"
 #include <WiFi.h>
 #include <ArduinoJson.h>
 #include <math.h>
 
+// Registry handles shared by the streamer instance
+static MetricId metricChunksSent = METRIC_INVALID;
+static MetricId metricChunksDropped = METRIC_INVALID;
+
 // Global instance
 RealtimeAudioStreamer realtimeStreamer;
 
@@ -59,6 +67,9 @@ RealtimeAudioStreamer::RealtimeAudioStreamer() {
     networkState.lastNetworkCheck = 0;
     networkState.adaptiveDelay = 10; // 10ms default
     networkState.canIncreaseChunkSize = true;
+    maxChunkSize = RTS_MAX_CHUNK_SIZE;
+    eventSubscriber = EVENT_SUBSCRIBER_INVALID;
+    linkUp = false;
     
     // Initialize VAD
     memset(&realTimeVAD, 0, sizeof(VADMetrics));
@@ -151,6 +162,16 @@ bool RealtimeAudioStreamer::init() {
     realtimeAGC.attack_time = 0.05f;   // Fast attack for real-time
     realtimeAGC.release_time = 0.95f;  // Slow release
     
+    metricChunksSent = registerCounter("rts.chunks_sent");
+    metricChunksDropped = registerCounter("rts.chunks_dropped");
+    
+    // Connection changes are delivered on the streaming task
+    if (eventSubscriber == EVENT_SUBSCRIBER_INVALID) {
+        eventSubscriber = registerEventSubscriber("rts");
+        subscribeEvent(eventSubscriber, EVENT_WS_CONNECTED, onConnectionEvent);
+        subscribeEvent(eventSubscriber, EVENT_WS_DISCONNECTED, onConnectionEvent);
+    }
+    
     initialized = true;
     setState(RTS_IDLE);
     
@@ -213,6 +234,7 @@ bool RealtimeAudioStreamer::writeToInputBuffer(const uint8_t* data, size_t size)
         metrics.chunksDropped++;
         return false;
     }
+    noteAudioCopy(size);
     
     return true;
 }
@@ -222,21 +244,22 @@ size_t RealtimeAudioStreamer::readFromInputBuffer(uint8_t* data, size_t maxSize)
         return 0;
     }
     
+    // UpTo leaves any excess in the ring; a plain receive would return (and
+    // lose) bytes beyond maxSize
     size_t itemSize = 0;
-    uint8_t* item = (uint8_t*)xRingbufferReceive(inputRingBuffer, &itemSize, pdMS_TO_TICKS(1));
+    uint8_t* item = (uint8_t*)xRingbufferReceiveUpTo(inputRingBuffer, &itemSize, pdMS_TO_TICKS(1), maxSize);
     
     if (item == NULL || itemSize == 0) {
         return 0;
     }
     
-    // Copy data respecting maxSize limit
-    size_t copySize = min(itemSize, maxSize);
-    memcpy(data, item, copySize);
+    memcpy(data, item, itemSize);
+    noteAudioCopy(itemSize);
     
     // Return item to ring buffer
     vRingbufferReturnItem(inputRingBuffer, item);
     
-    return copySize;
+    return itemSize;
 }
 
 bool RealtimeAudioStreamer::isInputBufferEmpty() {
@@ -279,6 +302,12 @@ bool RealtimeAudioStreamer::startStreaming() {
         return false;
     }
     
+    // Seed from the loop task, where isConnected is owned; transitions still
+    // queued are older and are superseded
+    while (dispatchEvents(eventSubscriber) > 0) {
+    }
+    linkUp = true;
+    
     Serial.println("🎤 Starting real-time audio streaming...");
     
     // Reset metrics
@@ -333,6 +362,7 @@ void RealtimeAudioStreamer::stopStreaming() {
         
         // Force delete if not finished
         if (eTaskGetState(streamingTaskHandle) != eDeleted) {
+            forgetTaskStack(streamingTaskHandle);
             vTaskDelete(streamingTaskHandle);
         }
         
@@ -359,19 +389,29 @@ bool RealtimeAudioStreamer::isStreaming() {
 void RealtimeAudioStreamer::audioStreamingTaskWrapper(void* parameter) {
     RealtimeAudioStreamer* streamer = static_cast<RealtimeAudioStreamer*>(parameter);
     streamer->audioStreamingTask();
+    noteTaskStackExit();
     vTaskDelete(NULL); // Self-delete when done
 }
 
+void RealtimeAudioStreamer::onConnectionEvent(const Event& event) {
+    realtimeStreamer.linkUp = (event.type == EVENT_WS_CONNECTED);
+}
+
 void RealtimeAudioStreamer::audioStreamingTask() {
     Serial.println("🎯 Audio streaming task started");
+    registerCurrentTaskStack("RTS_Task", STREAMING_TASK_STACK_SIZE);
     
-    uint8_t* chunkBuffer = (uint8_t*)malloc(networkState.currentChunkSize);
-    if (chunkBuffer == nullptr) {
-        Serial.println("❌ Failed to allocate chunk buffer in task");
-        setState(RTS_ERROR);
+    // I2S read buffer: BUFFER_SIZE is the whole task stack, so it lives off-stack
+    uint8_t* tempBuffer = (uint8_t*)malloc(BUFFER_SIZE);
+    if (tempBuffer == nullptr) {
+        Serial.println("❌ Failed to allocate I2S read buffer");
         return;
     }
     
+    // Sized for the largest adaptive chunk: currentChunkSize may grow mid-session.
+    // A frame still referenced downstream is left to its holders and replaced.
+    AudioFrame chunk;
+    
     uint32_t lastNetworkCheck = 0;
     uint32_t lastSilenceCheck __attribute__((unused)) = 0;
     uint32_t chunkStartTime = 0;
@@ -379,6 +419,8 @@ void RealtimeAudioStreamer::audioStreamingTask() {
     while (streaming && currentState != RTS_STOPPING) {
         uint32_t currentTime = millis();
         
+        dispatchEvents(eventSubscriber);
+        
         // Update network conditions periodically
         if (currentTime - lastNetworkCheck > networkCheckInterval) {
             updateNetworkConditions();
@@ -387,10 +429,10 @@ void RealtimeAudioStreamer::audioStreamingTask() {
         
         // Read audio data from I2S
         chunkStartTime = currentTime;
-        uint8_t tempBuffer[BUFFER_SIZE];
         size_t bytesRead = readAudioData(tempBuffer, BUFFER_SIZE);
         
         if (bytesRead > 0) {
+            noteAudioCaptured(bytesRead);
             // Write to ring buffer for continuous operation
             if (!writeToInputBuffer(tempBuffer, bytesRead)) {
                 Serial.println("⚠️ Ring buffer full, dropping audio data");
@@ -398,17 +440,28 @@ void RealtimeAudioStreamer::audioStreamingTask() {
             }
         }
         
+        if (!chunk || chunk.isShared()) {
+            chunk = AudioFrame::allocate(RTS_MAX_CHUNK_SIZE);
+            if (!chunk) {
+                Serial.println("❌ Failed to allocate audio frame in task");
+                vTaskDelay(pdMS_TO_TICKS(20));
+                continue;
+            }
+        }
+        
         // Process accumulated data in chunks
-        size_t availableData = readFromInputBuffer(chunkBuffer, networkState.currentChunkSize);
+        uint8_t* chunkData = chunk.mutableData();
+        size_t availableData = readFromInputBuffer(chunkData, networkState.currentChunkSize);
+        chunk.setLength(availableData);
         
         if (availableData >= networkState.currentChunkSize || 
             (availableData > 0 && currentTime - lastChunkTime > latencyTarget)) {
             
-            // Process the audio chunk
-            processAudioChunk(chunkBuffer, availableData);
+            // Process the audio chunk (DSP runs in place on the exclusive frame)
+            processAudioChunk(chunkData, availableData);
             
             // Apply real-time enhancements
-            bool hasVoice = applyRealTimeEnhancements((int16_t*)chunkBuffer, availableData / 2);
+            bool hasVoice = applyRealTimeEnhancements((int16_t*)chunkData, availableData / 2);
             
             // Voice activity detection and adaptive streaming
             if (silenceDetectionEnabled) {
@@ -421,7 +474,7 @@ void RealtimeAudioStreamer::audioStreamingTask() {
             
             // Send chunk if we have voice activity or silence detection is disabled
             if (hasVoice || !silenceDetectionEnabled || currentState != RTS_PAUSED_SILENCE) {
-                sendAudioChunk(chunkBuffer, availableData);
+                sendAudioChunk(chunk);
                 
                 // Update performance metrics
                 uint32_t chunkLatency = millis() - chunkStartTime;
@@ -457,7 +510,8 @@ void RealtimeAudioStreamer::audioStreamingTask() {
         taskYIELD();
     }
     
-    free(chunkBuffer);
+    chunk.release();
+    free(tempBuffer);
     Serial.println("🎯 Audio streaming task ended");
 }
 
@@ -579,38 +633,17 @@ bool RealtimeAudioStreamer::detectVoiceActivity(int16_t* samples, size_t count)
 // NETWORK TRANSMISSION AND ADAPTATION
 // =============================================================================
 
-void RealtimeAudioStreamer::sendAudioChunk(uint8_t* chunk, size_t size) {
-    if (chunk == nullptr || size == 0 || !isConnected) {
+void RealtimeAudioStreamer::sendAudioChunk(const AudioFrame& chunk) {
+    size_t size = chunk.length();
+    if (!chunk || size == 0 || !linkUp) {
         return;
     }
     
     uint32_t transmissionStart = millis();
     
-    // Calculate base64 output size
-    unsigned int base64Length = calculateBase64EncodedSize(size);
-    unsigned char* base64Output = new unsigned char[base64Length + 1];
-    
-    if (base64Output == nullptr) {
-        Serial.println("❌ Failed to allocate base64 buffer");
-        metrics.chunksDropped++;
-        return;
-    }
-    
-    // Encode to base64
-    unsigned int encodedLength = encodeBase64(chunk, size, base64Output, base64Length + 1);
-    if (encodedLength == 0) {
-        Serial.println("❌ Base64 encoding failed");
-        delete[] base64Output;
-        metrics.chunksDropped++;
-        return;
-    }
-    
-    base64Output[encodedLength] = '\0';
-    String base64Chunk = String((char*)base64Output);
-    delete[] base64Output;
-    
-    // Create WebSocket message
-    DynamicJsonDocument doc(1024 + base64Chunk.length());
+    // Metadata only: the PCM is base64-encoded straight into the text frame
+    JsonArenaScope arena;
+    ArenaJsonDocument doc(512);
     doc["type"] = "realtime_audio_chunk";
     doc["device_id"] = getCurrentDeviceId();
     doc["timestamp"] = millis();
@@ -621,14 +654,18 @@ void RealtimeAudioStreamer::sendAudioChunk(uint8_t* chunk, size_t size) {
     doc["channels"] = 1;
     doc["has_voice"] = (realTimeVAD.state == VAD_SPEECH);
     doc["chunk_latency"] = millis() - transmissionStart;
-    doc["audio_data"] = base64Chunk;
     
-    String message;
-    serializeJson(doc, message);
+    AudioFrame message = buildAudioTextFrame(chunk.data(), size, doc);
+    if (!message) {
+        Serial.println("❌ Failed to build audio text frame");
+        metrics.chunksDropped++;
+        return;
+    }
     
     // Send with error handling
-    if (webSocket.sendTXT(message)) {
+    if (sendTextFrame(message)) {
         metrics.chunksSent++;
+        metricIncrement(metricChunksSent);
         networkState.consecutiveFailures = 0;
         
         // Adaptive chunk size increase on success
@@ -639,6 +676,7 @@ void RealtimeAudioStreamer::sendAudioChunk(uint8_t* chunk, size_t size) {
         }
     } else {
         metrics.chunksDropped++;
+        metricIncrement(metricChunksDropped);
         networkState.consecutiveFailures++;
         
         Serial.printf("❌ Failed to send audio chunk %d\n", sequenceNumber - 1);
@@ -687,7 +725,7 @@ void RealtimeAudioStreamer::adjustForNetworkConditions() {
         case NETWORK_EXCELLENT:
             networkState.adaptiveDelay = 5;
             networkState.canIncreaseChunkSize = true;
-            if (networkState.currentChunkSize < RTS_MAX_CHUNK_SIZE) {
+            if (networkState.currentChunkSize < maxChunkSize) {
                 adjustChunkSize(true);
             }
             break;
@@ -716,7 +754,40 @@ void RealtimeAudioStreamer::adjustForNetworkConditions() {
 }
 
 size_t RealtimeAudioStreamer::getOptimalChunkSize() {
-    return networkState.currentChunkSize;
+    return min(networkState.currentChunkSize, maxChunkSize);
+}
+
+void RealtimeAudioStreamer::setMaxChunkSize(size_t size) {
+    maxChunkSize = constrain(size, (size_t)RTS_MIN_CHUNK_SIZE, (size_t)RTS_MAX_CHUNK_SIZE);
+    if (networkState.currentChunkSize > maxChunkSize) {
+        networkState.currentChunkSize = maxChunkSize;
+    }
+    Serial.printf("📊 Chunk size ceiling: %d bytes\n", maxChunkSize);
+}
+
+// Ring buffers cannot be swapped under a running streaming task
+bool RealtimeAudioStreamer::setRingBufferSize(size_t size) {
+    if (size == ringBufferSize) {
+        return true;
+    }
+    if (streaming) {
+        return false;
+    }
+    
+    size_t previousSize = ringBufferSize;
+    ringBufferSize = size;
+    if (!initialized) {
+        return true;  // Applied by init()
+    }
+    
+    cleanupRingBuffers();
+    if (initRingBuffers()) {
+        return true;
+    }
+    
+    // Could not fit the new size: fall back to the previous one
+    ringBufferSize = previousSize;
+    return initRingBuffers();
 }
 
 void RealtimeAudioStreamer::adjustChunkSize(bool increase) {
@@ -725,7 +796,7 @@ void RealtimeAudioStreamer::adjustChunkSize(bool increase) {
     if (increase && networkState.canIncreaseChunkSize) {
         networkState.currentChunkSize = min(
             (size_t)(networkState.currentChunkSize * 1.25), 
-            (size_t)RTS_MAX_CHUNK_SIZE
+            maxChunkSize
         );
     } else if (!increase) {
         networkState.currentChunkSize = max(
@@ -1,54 +1,118 @@
 #include "resource_manager.h"
+#include "metrics_registry.h"
 #include <ArduinoJson.h>
+#include <esp_heap_caps.h>
+#include <freertos/task.h>
+#include <new>
 
 // Global instance
 ResourceManager resourceManager;
 
-// ResourceManager implementation stubs for audio-only teddy bear
+// Allocation tracking tables
+static AllocationRecord allocations[MAX_TRACKED_RESOURCES];
+static AllocationSite sites[MAX_ALLOCATION_SITES];
+static size_t siteCount = 0;
+static SemaphoreHandle_t trackerMutex = nullptr;
+
+static uint32_t allocCount = 0;
+static uint32_t untrackedAllocs = 0;   // Table full, allocation not recorded
+static uint32_t evictedSites = 0;      // Idle sites recycled for new ones
+static uint32_t trackedCount = 0;
+static uint32_t trackedBytes = 0;
+static int lastLeakCount = 0;
+static uint32_t snapshotSeq = 0;
+static unsigned long lastLeakCheck = 0;
+static uint32_t gcRunCount = 0;
+static unsigned long lastGC = 0;
+
+static MetricId metricTrackedBytes = METRIC_INVALID;
+static MetricId metricPotentialLeaks = METRIC_INVALID;
+static MetricId metricFragmentation = METRIC_INVALID;
+static MetricId metricPoolFallbacks = METRIC_INVALID;
+
+static inline void lockTracker() {
+  if (trackerMutex) xSemaphoreTake(trackerMutex, portMAX_DELAY);
+}
+
+static inline void unlockTracker() {
+  if (trackerMutex) xSemaphoreGive(trackerMutex);
+}
+
+static uint32_t heapFragmentationPercent() {
+  size_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  if (freeHeap == 0) return 0;
+  return 100 - (uint32_t)((uint64_t)largest * 100 / freeHeap);
+}
+
+// =============================================================================
+// RESOURCE MANAGER
+// =============================================================================
+
 bool ResourceManager::init() {
-  return true;
+  if (trackerMutex == nullptr) {
+    trackerMutex = xSemaphoreCreateMutex();
+  }
+  memset(&stats, 0, sizeof(stats));
+  metricTrackedBytes = registerGauge("heap.tracked_bytes", "bytes");
+  metricPotentialLeaks = registerGauge("heap.potential_leaks");
+  metricFragmentation = registerGauge("heap.fragmentation", "%");
+  metricPoolFallbacks = registerCounter("pool.fallback");
+  lastLeakCheck = millis();
+
+  Serial.printf("🧾 Allocation tracker ready (%d records, %d sites)\n",
+                MAX_TRACKED_RESOURCES, MAX_ALLOCATION_SITES);
+  return trackerMutex != nullptr;
 }
 
 void ResourceManager::cleanup() {
-  // Simplified cleanup for audio-only teddy
+  printStatus();
 }
 
 ResourceStats ResourceManager::getResourceStats() {
-  ResourceStats stats = {0};
-  stats.totalHeap = ESP.getHeapSize();
-  stats.minFreeHeap = ESP.getFreeHeap();
-  stats.gcRunCount = 0;
-  stats.allocCount = 0;
-  stats.trackedAllocations = 0;
-  stats.trackedMemory = 0;
-  stats.lastGC = 0;
-  stats.heapFragmentation = 0;
+  updateStats();
   return stats;
 }
 
 size_t ResourceManager::getTrackedAllocations() {
-  return 0; // Audio-only teddy bear has simplified memory management
+  return trackedCount;
 }
 
 void ResourceManager::performMaintenance() {
-  // Stub implementation
+  if (millis() - lastLeakCheck < LEAK_CHECK_INTERVAL) return;
+  lastLeakCheck = millis();
+
+  int leaks = detectMemoryLeaks();
+  updateStats();
+  metricSetGauge(metricTrackedBytes, (int32_t)trackedBytes);
+  metricSetGauge(metricPotentialLeaks, leaks);
+  metricSetGauge(metricFragmentation, (int32_t)stats.heapFragmentation);
 }
 
 void ResourceManager::printStatus() {
-  Serial.println("🧸 Audio-only teddy bear - simplified resource management");
+  printResourceStatus();
 }
 
 void ResourceManager::updateStats() {
-  // Stub implementation - no complex tracking needed
+  stats.heapFragmentation = heapFragmentationPercent();
+  stats.gcRunCount = gcRunCount;
+  stats.allocCount = allocCount;
+  stats.totalHeap = ESP.getHeapSize();
+  stats.minFreeHeap = ESP.getMinFreeHeap();
+  stats.trackedAllocations = trackedCount;
+  stats.trackedMemory = trackedBytes;
+  stats.lastGC = lastGC;
 }
 
-// Stub implementation for force garbage collection
 void forceGarbageCollection() {
-  // Audio-only teddy bear doesn't need complex garbage collection
-  Serial.println("🧹 Simple memory cleanup for audio-only teddy");
+  // No collector to run: re-scan so leak and fragmentation figures are current
+  gcRunCount++;
+  lastGC = millis();
+  int leaks = detectMemoryLeaks();
+  Serial.printf("🧹 Memory scan: %u tracked bytes, %d potential leaks, %u%% fragmentation\n",
+                trackedBytes, leaks, heapFragmentationPercent());
 }
 
-// Other required stub functions
 bool initResourceManager() {
   return resourceManager.init();
 }
@@ -57,28 +121,263 @@ void cleanupResourceManager() {
   resourceManager.cleanup();
 }
 
+// =============================================================================
+// ALLOCATION TRACKING
+// =============================================================================
+
+// Caller must hold the tracker lock
+static int findOrAddSite(const char* name, uint32_t caller) {
+  const char* label = name ? name : "unnamed";
+  for (size_t i = 0; i < siteCount; i++) {
+    if (sites[i].caller == caller && strcmp(sites[i].name, label) == 0) {
+      return (int)i;
+    }
+  }
+  int index = (int)siteCount;
+  if (siteCount >= MAX_ALLOCATION_SITES) {
+    // Table full: recycle the idle site with the least history. No record
+    // points at a site with nothing live, so the slot can be reused as is.
+    index = -1;
+    for (size_t i = 0; i < siteCount; i++) {
+      if (sites[i].liveCount == 0 && (index < 0 || sites[i].totalAllocs < sites[index].totalAllocs)) {
+        index = (int)i;
+      }
+    }
+    if (index < 0) {
+      return -1;
+    }
+    evictedSites++;
+  } else {
+    siteCount++;
+  }
+  AllocationSite& site = sites[index];
+  memset(&site, 0, sizeof(site));
+  site.name = label;
+  site.caller = caller;
+  return index;
+}
+
+// Caller must hold the tracker lock
+static bool recordAllocation(void* ptr, size_t size, const char* name, uint32_t caller, bool carved) {
+  int siteIndex = findOrAddSite(name, caller);
+  if (siteIndex < 0) {
+    return false;
+  }
+
+  for (size_t i = 0; i < MAX_TRACKED_RESOURCES; i++) {
+    AllocationRecord& rec = allocations[i];
+    if (rec.ptr != nullptr) continue;
+
+    rec.ptr = ptr;
+    rec.size = size;
+    rec.timestamp = millis();
+    rec.site = (uint8_t)siteIndex;
+    rec.carved = carved;
+    const char* taskName = pcTaskGetTaskName(nullptr);
+    strlcpy(rec.task, taskName ? taskName : "?", sizeof(rec.task));
+
+    AllocationSite& site = sites[siteIndex];
+    site.liveCount++;
+    site.liveBytes += size;
+    site.totalAllocs++;
+    if (carved) site.carvedBytes += size;
+    if (site.liveBytes > site.peakBytes) site.peakBytes = site.liveBytes;
+
+    trackedCount++;
+    trackedBytes += size;
+    return true;
+  }
+  return false;
+}
+
+// Caller must hold the tracker lock
+static bool releaseAllocation(void* ptr) {
+  for (size_t i = 0; i < MAX_TRACKED_RESOURCES; i++) {
+    AllocationRecord& rec = allocations[i];
+    if (rec.ptr != ptr) continue;
+
+    AllocationSite& site = sites[rec.site];
+    site.liveCount--;
+    site.liveBytes -= rec.size;
+    site.totalFrees++;
+    if (rec.carved) site.carvedBytes -= rec.size;
+
+    trackedCount--;
+    trackedBytes -= rec.size;
+    memset(&rec, 0, sizeof(rec));
+    return true;
+  }
+  return false;
+}
+
+static void* trackMallocFrom(size_t size, const char* name, uint32_t caller) {
+  size_t largestBefore = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  void* ptr = malloc(size);
+  if (ptr == nullptr) {
+    Serial.printf("❌ trackMalloc: %u bytes for '%s' failed (largest block %u)\n",
+                  (unsigned)size, name ? name : "unnamed", (unsigned)largestBefore);
+    return nullptr;
+  }
+  bool carved = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) < largestBefore;
+
+  lockTracker();
+  allocCount++;
+  if (!recordAllocation(ptr, size, name, caller, carved)) {
+    untrackedAllocs++;
+  }
+  unlockTracker();
+  return ptr;
+}
+
 void* trackMalloc(size_t size, const char* name) {
-  return malloc(size);
+  uint32_t caller = (uint32_t)(uintptr_t)__builtin_return_address(0);
+  return trackMallocFrom(size, name, caller);
 }
 
 void trackFree(void* ptr, const char* name) {
+  if (ptr == nullptr) return;
+  (void)name;
+
+  lockTracker();
+  releaseAllocation(ptr);
+  unlockTracker();
   free(ptr);
 }
 
 bool addResourceTracker(void* ptr, size_t size, const char* name) {
-  return true;
+  if (ptr == nullptr) return false;
+  uint32_t caller = (uint32_t)(uintptr_t)__builtin_return_address(0);
+
+  lockTracker();
+  bool ok = recordAllocation(ptr, size, name, caller, false);
+  unlockTracker();
+  return ok;
 }
 
 bool removeResourceTracker(void* ptr) {
-  return true;
+  lockTracker();
+  bool ok = releaseAllocation(ptr);
+  unlockTracker();
+  return ok;
 }
 
-void printResourceStatus() {
-  Serial.println("🧸 Audio-only teddy bear - simplified resource management");
+size_t getAllocationSiteCount() {
+  return siteCount;
+}
+
+const AllocationSite* getAllocationSite(size_t index) {
+  return index < siteCount ? &sites[index] : nullptr;
+}
+
+// Live bytes across every caller that used this label
+size_t getTrackedBytesForSite(const char* name) {
+  size_t bytes = 0;
+  lockTracker();
+  for (size_t i = 0; i < siteCount; i++) {
+    if (strcmp(sites[i].name, name) == 0) {
+      bytes += sites[i].liveBytes;
+    }
+  }
+  unlockTracker();
+  return bytes;
+}
+
+// =============================================================================
+// LEAK DETECTION AND REPORTING
+// =============================================================================
+
+int detectMemoryLeaks() {
+  unsigned long now = millis();
+  int leaks = 0;
+
+  lockTracker();
+  for (size_t i = 0; i < siteCount; i++) {
+    sites[i].agedCount = 0;
+  }
+
+  // Age is reported only: audio_buffer and the BLE message pool
+  // are meant to live until reboot
+  for (size_t i = 0; i < MAX_TRACKED_RESOURCES; i++) {
+    const AllocationRecord& rec = allocations[i];
+    if (rec.ptr != nullptr && now - rec.timestamp > MEMORY_LEAK_THRESHOLD) {
+      sites[rec.site].agedCount++;
+    }
+  }
+
+  // Leaks by growth: live bytes rising across consecutive scans. A buffer
+  // allocated once grows the site for one scan and then stays flat.
+  for (size_t i = 0; i < siteCount; i++) {
+    AllocationSite& site = sites[i];
+    if (site.liveBytes > site.bytesAtLastCheck) {
+      if (site.growthStreak < 255) site.growthStreak++;
+    } else {
+      site.growthStreak = 0;
+    }
+    site.bytesAtLastCheck = site.liveBytes;
+
+    bool wasSuspected = site.suspectedLeak;
+    site.suspectedLeak = site.growthStreak >= LEAK_GROWTH_CHECKS;
+    if (site.suspectedLeak) {
+      leaks++;
+      if (!wasSuspected) {
+        Serial.printf("🕳️ Possible leak at '%s' (0x%08x): %u live / %u bytes, %u aged, growth x%u\n",
+                      site.name, site.caller, site.liveCount, site.liveBytes,
+                      site.agedCount, site.growthStreak);
+      }
+    }
+  }
+  unlockTracker();
+
+  lastLeakCount = leaks;
+  return leaks;
+}
+
+void dumpAllocationSnapshot() {
+  unsigned long now = millis();
+
+  Serial.printf("[HEAP][SNAP] {\"seq\":%u,\"uptime_ms\":%lu,\"free\":%u,\"largest\":%u,"
+                "\"min_free\":%u,\"tracked\":%u,\"tracked_bytes\":%u,\"untracked\":%u,\"evicted\":%u}\n",
+                snapshotSeq++, now, ESP.getFreeHeap(), ESP.getMaxAllocHeap(), ESP.getMinFreeHeap(),
+                trackedCount, trackedBytes, untrackedAllocs, evictedSites);
+
+  lockTracker();
+  for (size_t i = 0; i < siteCount; i++) {
+    const AllocationSite& s = sites[i];
+    Serial.printf("[HEAP][SITE] {\"site\":\"%s\",\"caller\":\"0x%08x\",\"live\":%u,\"bytes\":%u,"
+                  "\"peak\":%u,\"allocs\":%u,\"frees\":%u,\"carved\":%u,\"aged\":%u,\"leak\":%s}\n",
+                  s.name, s.caller, s.liveCount, s.liveBytes, s.peakBytes, s.totalAllocs,
+                  s.totalFrees, s.carvedBytes, s.agedCount, s.suspectedLeak ? "true" : "false");
+  }
+  for (size_t i = 0; i < MAX_TRACKED_RESOURCES; i++) {
+    const AllocationRecord& rec = allocations[i];
+    if (rec.ptr == nullptr) continue;
+    Serial.printf("[HEAP][LIVE] {\"site\":\"%s\",\"ptr\":\"0x%08x\",\"size\":%u,\"age_ms\":%lu,"
+                  "\"task\":\"%.8s\",\"carved\":%s}\n",
+                  sites[rec.site].name, (uint32_t)(uintptr_t)rec.ptr, rec.size, now - rec.timestamp,
+                  rec.task, rec.carved ? "true" : "false");
+  }
+  unlockTracker();
+  Serial.println("[HEAP][END]");
 }
 
-void detectMemoryLeaks() {
-  // No complex leak detection needed for audio-only teddy
+void printResourceStatus() {
+  Serial.println("=== 🧾 Tracked Allocations ===");
+  Serial.printf("  Live: %u allocations, %u bytes (untracked: %u)\n",
+                trackedCount, trackedBytes, untrackedAllocs);
+  Serial.printf("  Heap: free=%u largest=%u fragmentation=%u%%\n",
+                ESP.getFreeHeap(), ESP.getMaxAllocHeap(), heapFragmentationPercent());
+
+  lockTracker();
+  for (size_t i = 0; i < siteCount; i++) {
+    const AllocationSite& s = sites[i];
+    if (s.totalAllocs == 0) continue;
+    Serial.printf("  %-24s live=%u bytes=%u peak=%u carved=%u%s\n",
+                  s.name, s.liveCount, s.liveBytes, s.peakBytes, s.carvedBytes,
+                  s.suspectedLeak ? " ⚠️ leak?" : "");
+  }
+  unlockTracker();
+  Serial.println("==============================");
+  printMemoryPools();
 }
 
 size_t getAvailableMemory() {
@@ -95,28 +394,31 @@ bool isMemoryLow() {
 
 void emergencyCleanup() {
   Serial.println("🚨 Emergency memory cleanup for teddy bear");
+  dumpAllocationSnapshot();
 }
 
 void setupMemoryMonitoring() {
-  // Simplified monitoring for audio-only teddy
+  initResourceManager();
 }
 
 void handleMemoryWarning() {
   Serial.println("⚠️ Memory warning - teddy bear");
+  printResourceStatus();
 }
 
 void handleMemoryCritical() {
   Serial.println("💥 Memory critical - teddy bear");
+  dumpAllocationSnapshot();
 }
 
 MemoryHealthInfo getMemoryHealth() {
-  MemoryHealthInfo info = {0};
+  MemoryHealthInfo info = {};
   info.free_heap = ESP.getFreeHeap();
   info.min_free_heap = ESP.getMinFreeHeap();
   info.total_heap = ESP.getHeapSize();
-  info.tracked_allocations = 0;
-  info.tracked_memory = 0;
-  info.potential_leaks = 0;
+  info.tracked_allocations = trackedCount;
+  info.tracked_memory = trackedBytes;
+  info.potential_leaks = lastLeakCount;
   info.memory_low = isMemoryLow();
   info.memory_critical = ESP.getFreeHeap() < (LOW_MEMORY_THRESHOLD / 2);
   return info;
@@ -124,32 +426,206 @@ MemoryHealthInfo getMemoryHealth() {
 
 void printMemoryHealth() {
   MemoryHealthInfo info = getMemoryHealth();
-  Serial.printf("🧸 Memory Health: Free=%zu, Total=%zu\n", info.free_heap, info.total_heap);
+  Serial.printf("🧸 Memory Health: Free=%zu, Total=%zu, Tracked=%zu (%zu bytes), Leaks=%d\n",
+                info.free_heap, info.total_heap, info.tracked_allocations,
+                info.tracked_memory, info.potential_leaks);
 }
 
-// MemoryPool stubs (audio-only teddy doesn't need complex pooling)
-MemoryPool::MemoryPool(size_t poolSize, size_t blockSize) 
-  : pool(nullptr), size(0), used(0), allocation_map(nullptr), block_size(blockSize), num_blocks(0) {
+// =============================================================================
+// MEMORY POOLS
+// =============================================================================
+
+// Size classes, smallest first, sized from the live audio path. The board has
+// no PSRAM, so every block is internal DRAM held until reboot (28.7 KB):
+// - AUDIO_CHUNK_SIZE PCM frames: one filling, one or two queued on the bus,
+//   one being encoded
+// - their {"audio_data":...} text frames (~5.8 KB): one built, one sending
+// Deeper bursts (a stalled consumer) spill to the heap and show up in
+// pool.fallback and the "peak" column of printMemoryPools().
+#define POOL_PCM_BLOCK 4112  // AudioFrameBuffer header + one AUDIO_CHUNK_SIZE chunk
+static MemoryPool pools[] = {
+  {POOL_PCM_BLOCK * 4, POOL_PCM_BLOCK, true},
+  {6144 * 2, 6144, true},
+};
+static const size_t POOL_COUNT = sizeof(pools) / sizeof(pools[0]);
+
+static std::atomic<uint32_t> poolFallbacks(0);
+
+MemoryPool::MemoryPool(size_t poolSize, size_t blockSize, bool preferPsram)
+  : pool(nullptr), size(0), used(0),
+    block_size((blockSize + 3) & ~(size_t)3), num_blocks(0),
+    prefer_psram(preferPsram), in_psram(false),
+    high_water(0), allocations(0), exhausted(0) {
+  num_blocks = block_size ? poolSize / block_size : 0;
+  size = num_blocks * block_size;
 }
 
 MemoryPool::~MemoryPool() {
+  heap_caps_free(pool.load());
 }
 
-void* MemoryPool::allocate() { 
-  return nullptr; 
+// The used-block bitmap sits right after the blocks
+std::atomic<uint32_t>* MemoryPool::allocationMap(uint8_t* base) const {
+  return (std::atomic<uint32_t>*)(base + size);
+}
+
+// Blocks and bitmap share one allocation made on first use. Racing callers
+// each build a candidate; the loser frees its copy and uses the winner's.
+bool MemoryPool::reserve() {
+  if (pool.load(std::memory_order_acquire) != nullptr) return true;
+  if (num_blocks == 0) return false;
+
+  size_t words = (num_blocks + 31) / 32;
+  size_t bytes = size + words * sizeof(std::atomic<uint32_t>);
+  bool psram = false;
+  uint8_t* storage = nullptr;
+  if (prefer_psram && psramFound()) {
+    storage = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    psram = storage != nullptr;
+  }
+  if (storage == nullptr) {
+    storage = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  }
+  if (storage == nullptr) return false;
+
+  std::atomic<uint32_t>* map = allocationMap(storage);
+  for (size_t w = 0; w < words; w++) {
+    // Bits past the last block start out "used" so they are never handed out
+    size_t valid = min(num_blocks - w * 32, (size_t)32);
+    new (&map[w]) std::atomic<uint32_t>(valid == 32 ? 0 : ~((1UL << valid) - 1));
+  }
+
+  uint8_t* expected = nullptr;
+  if (!pool.compare_exchange_strong(expected, storage, std::memory_order_acq_rel)) {
+    heap_caps_free(storage);
+    return true;
+  }
+  in_psram = psram;
+  return true;
+}
+
+void* MemoryPool::allocate() {
+  if (!reserve()) return nullptr;
+
+  uint8_t* base = pool.load(std::memory_order_acquire);
+  std::atomic<uint32_t>* map = allocationMap(base);
+  size_t words = (num_blocks + 31) / 32;
+  for (size_t w = 0; w < words; w++) {
+    uint32_t bits = map[w].load(std::memory_order_relaxed);
+    while (bits != 0xFFFFFFFFUL) {
+      uint32_t bit = __builtin_ctz(~bits);
+      if (map[w].compare_exchange_weak(bits, bits | (1UL << bit),
+                                                  std::memory_order_acquire)) {
+        uint32_t inUse = used.fetch_add(1, std::memory_order_relaxed) + 1;
+        uint32_t peak = high_water.load(std::memory_order_relaxed);
+        while (inUse > peak && !high_water.compare_exchange_weak(peak, inUse)) {}
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return base + (w * 32 + bit) * block_size;
+      }
+      // CAS failure reloaded bits; retry within this word
+    }
+  }
+  exhausted.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+bool MemoryPool::owns(const void* ptr) const {
+  const uint8_t* base = pool.load(std::memory_order_acquire);
+  return base != nullptr && (const uint8_t*)ptr >= base && (const uint8_t*)ptr < base + size;
 }
 
 void MemoryPool::deallocate(void* ptr) {
+  if (!owns(ptr)) return;
+
+  uint8_t* base = pool.load(std::memory_order_acquire);
+  size_t offset = (uint8_t*)ptr - base;
+  if (offset % block_size != 0) {
+    Serial.printf("❌ MemoryPool(%u): free of interior pointer %p\n", (unsigned)block_size, ptr);
+    return;
+  }
+  size_t index = offset / block_size;
+  uint32_t mask = 1UL << (index % 32);
+  uint32_t prev = allocationMap(base)[index / 32].fetch_and(~mask, std::memory_order_release);
+  if (!(prev & mask)) {
+    Serial.printf("❌ MemoryPool(%u): double free of block %u\n", (unsigned)block_size, (unsigned)index);
+    return;
+  }
+  used.fetch_sub(1, std::memory_order_relaxed);
 }
 
-size_t MemoryPool::getFreeBlocks() { 
-  return 0; 
+size_t MemoryPool::getFreeBlocks() {
+  return num_blocks - used.load(std::memory_order_relaxed);
 }
 
-size_t MemoryPool::getUsedBlocks() { 
-  return 0; 
+size_t MemoryPool::getUsedBlocks() {
+  return used.load(std::memory_order_relaxed);
+}
+
+MemoryPoolStats MemoryPool::getStats() {
+  MemoryPoolStats out;
+  out.blockSize = block_size;
+  out.totalBlocks = num_blocks;
+  out.usedBlocks = used.load(std::memory_order_relaxed);
+  out.highWater = high_water.load(std::memory_order_relaxed);
+  out.allocations = allocations.load(std::memory_order_relaxed);
+  out.exhausted = exhausted.load(std::memory_order_relaxed);
+  out.inPsram = in_psram;
+  return out;
 }
 
 void MemoryPool::printStatus() {
-  Serial.println("🧸 Memory pool disabled for audio-only teddy");
-}
\ No newline at end of file
+  MemoryPoolStats st = getStats();
+  Serial.printf("  Pool %5u B x %-2u %s used=%u peak=%u allocs=%u exhausted=%u%s\n",
+                (unsigned)st.blockSize, (unsigned)st.totalBlocks,
+                pool.load() ? (st.inPsram ? "[psram]" : "[dram] ") : "[idle] ",
+                (unsigned)st.usedBlocks, (unsigned)st.highWater, st.allocations, st.exhausted,
+                st.highWater == st.totalBlocks && st.exhausted > 0 ? " ⚠️ undersized" : "");
+}
+
+void* poolAlloc(size_t size) {
+  if (size > 0 && size <= POOL_ALLOCATION_THRESHOLD) {
+    for (size_t i = 0; i < POOL_COUNT; i++) {
+      size_t block = pools[i].getBlockSize();
+      if (block < size) continue;
+      // The fitting class only: small requests must not use up the large blocks
+      void* ptr = size > block / 2 ? pools[i].allocate() : nullptr;
+      if (ptr != nullptr) return ptr;
+      break;
+    }
+  }
+  poolFallbacks.fetch_add(1, std::memory_order_relaxed);
+  metricIncrement(metricPoolFallbacks);
+  return malloc(size);
+}
+
+void poolFree(void* ptr) {
+  if (ptr == nullptr) return;
+  for (size_t i = 0; i < POOL_COUNT; i++) {
+    if (pools[i].owns(ptr)) {
+      pools[i].deallocate(ptr);
+      return;
+    }
+  }
+  free(ptr);
+}
+
+size_t getMemoryPoolCount() {
+  return POOL_COUNT;
+}
+
+bool getMemoryPoolStats(size_t index, MemoryPoolStats& out) {
+  if (index >= POOL_COUNT) return false;
+  out = pools[index].getStats();
+  return true;
+}
+
+uint32_t getPoolFallbackCount() {
+  return poolFallbacks.load(std::memory_order_relaxed);
+}
+
+void printMemoryPools() {
+  Serial.printf("=== 🧱 Memory Pools (fallbacks to malloc: %u) ===\n", getPoolFallbackCount());
+  for (size_t i = 0; i < POOL_COUNT; i++) {
+    pools[i].printStatus();
+  }
+}
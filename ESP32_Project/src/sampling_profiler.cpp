@@ -0,0 +1,344 @@
+#include "sampling_profiler.h"
+#include "websocket_handler.h"
+#include <esp_heap_caps.h>
+#include <esp_ipc.h>
+#include "encoding_service.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/xtensa_context.h>
+
+#define PROFILER_LINE_BYTES   57    // Encodes to one 76-char base64 line
+#define PROFILER_MAX_TASKS    24
+#define PROFILER_WS_LINES     16    // Lines per profile_chunk message
+
+struct CoreRing {
+  ProfileSample* samples;
+  volatile uint32_t head;
+  volatile uint32_t total;
+  hw_timer_t* timer;
+};
+
+struct ProfileTaskName {
+  uint32_t handle;
+  char name[16];
+};
+
+static CoreRing rings[portNUM_PROCESSORS];
+static ProfileTaskName* taskNames = nullptr;
+static uint16_t taskNameCount = 0;
+static volatile bool profilerRunning = false;
+static uint32_t profilerHz = 0;
+static unsigned long profilerStartMs = 0;
+static uint32_t profilerDurationMs = 0;
+
+// =============================================================================
+// SAMPLING (ISR)
+// =============================================================================
+
+static void IRAM_ATTR profilerTimerISR() {
+  CoreRing& ring = rings[xPortGetCoreID()];
+  if (ring.samples == nullptr) return;
+
+  // On first-level interrupt entry the port saves the interrupted context on
+  // the task stack and stores that frame in pxTopOfStack (first TCB field).
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  const XtExcFrame* frame = task ? *(const XtExcFrame* const*)task : nullptr;
+
+  ProfileSample& s = ring.samples[ring.head];
+  s.pc = frame ? frame->pc : 0;
+  // Windowed ABI keeps the call increment in the top two bits of a0
+  s.caller = frame ? ((frame->a0 & 0x3FFFFFFF) | 0x40000000) : 0;
+  s.task = (uint32_t)(uintptr_t)task;
+
+  ring.head = (ring.head + 1) % PROFILER_SAMPLES_PER_CORE;
+  ring.total++;
+}
+
+static void armTimerOnCore(void* arg) {
+  uint32_t core = (uint32_t)(uintptr_t)arg;
+  CoreRing& ring = rings[core];
+
+  ring.timer = timerBegin(PROFILER_TIMER_BASE + core, 80, true);  // 1 MHz tick
+  if (ring.timer == nullptr) return;
+  timerAttachInterrupt(ring.timer, &profilerTimerISR, true);
+  timerAlarmWrite(ring.timer, 1000000UL / profilerHz, true);
+  timerAlarmEnable(ring.timer);
+}
+
+static void disarmTimerOnCore(void* arg) {
+  CoreRing& ring = rings[(uintptr_t)arg];
+  if (ring.timer == nullptr) return;
+
+  // Interrupts must be released on the core that allocated them
+  timerAlarmDisable(ring.timer);
+  timerDetachInterrupt(ring.timer);
+  timerEnd(ring.timer);
+  ring.timer = nullptr;
+}
+
+// =============================================================================
+// CONTROL
+// =============================================================================
+
+bool startProfiler(uint32_t sampleHz, uint32_t durationMs) {
+  if (profilerRunning) {
+    Serial.println("⚠️ Profiler already running");
+    return false;
+  }
+  if (sampleHz == 0 || sampleHz > PROFILER_MAX_HZ) {
+    Serial.printf("❌ Profiler rate %u Hz out of range (1-%d)\n", sampleHz, PROFILER_MAX_HZ);
+    return false;
+  }
+
+  releaseProfile();
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    rings[core].samples = (ProfileSample*)heap_caps_malloc(
+        sizeof(ProfileSample) * PROFILER_SAMPLES_PER_CORE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (rings[core].samples == nullptr) {
+      Serial.println("❌ Profiler: not enough memory for sample rings");
+      releaseProfile();
+      return false;
+    }
+    rings[core].head = 0;
+    rings[core].total = 0;
+  }
+
+  profilerHz = sampleHz;
+  profilerDurationMs = durationMs;
+  profilerStartMs = millis();
+  profilerRunning = true;
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    esp_ipc_call_blocking(core, armTimerOnCore, (void*)(uintptr_t)core);
+  }
+
+  Serial.printf("🔬 Profiler started: %u Hz on %d cores (%u bytes)\n", sampleHz, portNUM_PROCESSORS,
+                (unsigned)(sizeof(ProfileSample) * PROFILER_SAMPLES_PER_CORE * portNUM_PROCESSORS));
+  return true;
+}
+
+static void snapshotTaskNames() {
+#if configUSE_TRACE_FACILITY
+  UBaseType_t count = uxTaskGetNumberOfTasks() + 2;
+  TaskStatus_t* status = (TaskStatus_t*)malloc(sizeof(TaskStatus_t) * count);
+  taskNames = (ProfileTaskName*)calloc(PROFILER_MAX_TASKS, sizeof(ProfileTaskName));
+  if (status == nullptr || taskNames == nullptr) {
+    free(status);
+    return;
+  }
+
+  count = uxTaskGetSystemState(status, count, nullptr);
+  taskNameCount = 0;
+  for (UBaseType_t i = 0; i < count && taskNameCount < PROFILER_MAX_TASKS; i++) {
+    taskNames[taskNameCount].handle = (uint32_t)(uintptr_t)status[i].xHandle;
+    strncpy(taskNames[taskNameCount].name, status[i].pcTaskName, sizeof(taskNames[0].name) - 1);
+    taskNameCount++;
+  }
+  free(status);
+#endif
+}
+
+void stopProfiler() {
+  if (!profilerRunning) return;
+
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    esp_ipc_call_blocking(core, disarmTimerOnCore, (void*)(uintptr_t)core);
+  }
+  profilerRunning = false;
+
+  // Names are resolved now, while the sampled tasks most likely still exist
+  snapshotTaskNames();
+  Serial.printf("🔬 Profiler stopped: %u samples kept, %u overwritten\n",
+                getProfilerSampleCount(), getProfilerDroppedCount());
+}
+
+bool isProfilerRunning() {
+  return profilerRunning;
+}
+
+void handleProfiler() {
+  if (!profilerRunning || profilerDurationMs == 0) return;
+  if (millis() - profilerStartMs < profilerDurationMs) return;
+
+  stopProfiler();
+  if (!sendProfileReport()) {
+    dumpProfile();
+  }
+}
+
+uint32_t getProfilerSampleCount() {
+  uint32_t count = 0;
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    count += min((uint32_t)rings[core].total, (uint32_t)PROFILER_SAMPLES_PER_CORE);
+  }
+  return count;
+}
+
+uint32_t getProfilerDroppedCount() {
+  uint32_t dropped = 0;
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    if (rings[core].total > PROFILER_SAMPLES_PER_CORE) {
+      dropped += rings[core].total - PROFILER_SAMPLES_PER_CORE;
+    }
+  }
+  return dropped;
+}
+
+void releaseProfile() {
+  if (profilerRunning) {
+    stopProfiler();
+  }
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    heap_caps_free(rings[core].samples);
+    rings[core].samples = nullptr;
+    rings[core].head = 0;
+    rings[core].total = 0;
+  }
+  free(taskNames);
+  taskNames = nullptr;
+  taskNameCount = 0;
+}
+
+// =============================================================================
+// EXPORT
+// =============================================================================
+
+typedef void (*ProfileLineSink)(const char* line, bool final);
+
+struct ProfileWriter {
+  uint8_t buf[PROFILER_LINE_BYTES];
+  size_t len;
+  ProfileLineSink sink;
+};
+
+static void flushWriterLine(ProfileWriter& w, bool final) {
+  char line[80];
+  size_t outLen = 0;
+  line[0] = '\0';
+  if (w.len > 0) {
+    base64Encode(w.buf, w.len, line, sizeof(line), &outLen);
+  }
+  w.len = 0;
+  if (outLen > 0 || final) {
+    w.sink(line, final);
+  }
+}
+
+static void writeBytes(ProfileWriter& w, const void* data, size_t n) {
+  const uint8_t* p = (const uint8_t*)data;
+  while (n > 0) {
+    size_t take = min(n, PROFILER_LINE_BYTES - w.len);
+    memcpy(w.buf + w.len, p, take);
+    w.len += take;
+    p += take;
+    n -= take;
+    if (w.len == PROFILER_LINE_BYTES) {
+      flushWriterLine(w, false);
+    }
+  }
+}
+
+static void writeProfile(ProfileLineSink sink) {
+  ProfileWriter w;
+  w.len = 0;
+  w.sink = sink;
+
+  uint32_t samples = getProfilerSampleCount();
+  uint32_t dropped = getProfilerDroppedCount();
+  uint8_t version = PROFILER_FORMAT_VERSION;
+  uint8_t cores = portNUM_PROCESSORS;
+  uint16_t hz = (uint16_t)profilerHz;
+  uint16_t reserved = 0;
+
+  writeBytes(w, "TPRF", 4);
+  writeBytes(w, &version, 1);
+  writeBytes(w, &cores, 1);
+  writeBytes(w, &hz, 2);
+  writeBytes(w, &samples, 4);
+  writeBytes(w, &dropped, 4);
+  writeBytes(w, &taskNameCount, 2);
+  writeBytes(w, &reserved, 2);
+
+  for (uint16_t i = 0; i < taskNameCount; i++) {
+    writeBytes(w, &taskNames[i], sizeof(ProfileTaskName));
+  }
+
+  // Oldest first within each core
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    const CoreRing& ring = rings[core];
+    if (ring.samples == nullptr) continue;
+    uint32_t kept = min((uint32_t)ring.total, (uint32_t)PROFILER_SAMPLES_PER_CORE);
+    uint32_t start = (ring.total > PROFILER_SAMPLES_PER_CORE) ? ring.head : 0;
+    for (uint32_t i = 0; i < kept; i++) {
+      writeBytes(w, &ring.samples[(start + i) % PROFILER_SAMPLES_PER_CORE], sizeof(ProfileSample));
+    }
+  }
+  flushWriterLine(w, true);
+}
+
+static void serialLineSink(const char* line, bool final) {
+  if (line[0] != '\0') {
+    Serial.printf("[PROF] %s\n", line);
+  }
+  if (final) {
+    Serial.println("[PROF][END]");
+  }
+}
+
+void dumpProfile() {
+  if (profilerRunning) {
+    stopProfiler();
+  }
+  if (getProfilerSampleCount() == 0) {
+    Serial.println("⚠️ Profiler: no samples to dump");
+    return;
+  }
+  Serial.println("[PROF][BEGIN]");
+  writeProfile(serialLineSink);
+}
+
+// Batches base64 lines into profile_chunk messages
+static char wsChunkBuffer[PROFILER_WS_LINES * 76 + 1];
+static size_t wsChunkLen = 0;
+static uint16_t wsChunkLines = 0;
+static uint16_t wsChunkSeq = 0;
+static bool wsChunkFailed = false;
+
+static void websocketLineSink(const char* line, bool final) {
+  size_t len = strlen(line);
+  memcpy(wsChunkBuffer + wsChunkLen, line, len);
+  wsChunkLen += len;
+  wsChunkBuffer[wsChunkLen] = '\0';
+  wsChunkLines++;
+
+  if (wsChunkLines < PROFILER_WS_LINES && !final) return;
+
+  DynamicJsonDocument doc(256);
+  doc["type"] = "profile_chunk";
+  doc["format"] = "tprf1";
+  doc["seq"] = wsChunkSeq++;
+  doc["final"] = final;
+  doc["data"] = (const char*)wsChunkBuffer;  // Stored by reference, not copied
+
+  String message;
+  serializeJson(doc, message);
+  if (!webSocket.sendTXT(message)) {
+    wsChunkFailed = true;
+  }
+  wsChunkLen = 0;
+  wsChunkLines = 0;
+}
+
+bool sendProfileReport() {
+  if (!isConnected || getProfilerSampleCount() == 0 || profilerRunning) {
+    return false;
+  }
+
+  wsChunkLen = 0;
+  wsChunkLines = 0;
+  wsChunkSeq = 0;
+  wsChunkFailed = false;
+  writeProfile(websocketLineSink);
+
+  Serial.printf("🔬 Profile uploaded in %u chunks%s\n", wsChunkSeq, wsChunkFailed ? " (with errors)" : "");
+  return !wsChunkFailed;
+}
@@ -11,6 +11,7 @@
 #include <WebSocketsClient.h>
 #include "encoding_service.h"
 #include "comprehensive_logging.h"  // Logging levels
+#include "fixed_string.h"
 #include <ArduinoJson.h>
 #include <mbedtls/pk.h>
 #include <mbedtls/entropy.h>
@@ -703,19 +704,9 @@ bool secureWebSocketConnect() {
     }
   }
   
-  // 2. Get JWT Manager instance and configure WebSocket refresh callback
+  // 2. Get JWT Manager instance (token refresh requests reach the WebSocket
+  //    over the event bus, see initWebSocketEvents)
   JWTManager* jwtManager = JWTManager::getInstance();
-  if (jwtManager) {
-    // Set WebSocket refresh callback for automatic token refresh
-    jwtManager->setRefreshCallback([](const String& refreshMessage) -> bool {
-      Serial.printf("🔄 WebSocket token refresh: %s\n", refreshMessage.c_str());
-      // This callback will be handled by the WebSocket client
-      // The actual WebSocket implementation should send this message
-      return true; // Placeholder - actual implementation in websocket_handler.cpp
-    });
-    
-    Serial.println("✅ JWT Manager WebSocket callback configured");
-  }
   
   // 3. Prepare secure WebSocket URL with JWT authentication
   String token = jwtManager ? jwtManager->getCurrentToken() : securityConfig.api_token;
@@ -815,15 +806,6 @@ bool processAuthResponse(const String& response) {
   }
 }
 
-// Convert base64url (JWT) to standard base64 with padding
-static String base64urlToBase64(const String& in) {
-  String s = in;
-  s.replace('-', '+');
-  s.replace('_', '/');
-  while (s.length() % 4 != 0) s += '=';
-  return s;
-}
-
 bool validateJWTToken(const String& token) {
   // JWT tokens have three parts separated by dots
   int firstDot = token.indexOf('.');
@@ -834,16 +816,15 @@ bool validateJWTToken(const String& token) {
     return false;
   }
   
-  // Extract and decode header
-  String header = token.substring(0, firstDot);
-  // Decode header
+  // Decode header (base64url, unpadded)
   unsigned char headerBuffer[256];
-  String headerB64 = base64urlToBase64(header);
-  unsigned int headerLen = decodeBase64(headerB64.c_str(), headerBuffer, sizeof(headerBuffer));
-  String decodedHeader = String((char*)headerBuffer, headerLen);
+  size_t headerLen = 0;
+  bool headerDecoded = base64Decode(token.c_str(), firstDot, headerBuffer, sizeof(headerBuffer),
+                                    &headerLen, BASE64_URL | BASE64_NO_PAD);
   
   StaticJsonDocument<256> headerDoc;
-  if (deserializeJson(headerDoc, decodedHeader) != DeserializationError::Ok) {
+  if (!headerDecoded ||
+      deserializeJson(headerDoc, (const char*)headerBuffer, headerLen) != DeserializationError::Ok) {
     Serial.println("❌ Invalid JWT header");
     return false;
   }
@@ -855,16 +836,16 @@ bool validateJWTToken(const String& token) {
     return false;
   }
   
-  // Extract and decode payload
-  String payload = token.substring(firstDot + 1, secondDot);
   // Decode payload
   unsigned char payloadBuffer[512];
-  String payloadB64 = base64urlToBase64(payload);
-  unsigned int payloadLen = decodeBase64(payloadB64.c_str(), payloadBuffer, sizeof(payloadBuffer));
-  String decodedPayload = String((char*)payloadBuffer, payloadLen);
+  size_t payloadLen = 0;
+  bool payloadDecoded = base64Decode(token.c_str() + firstDot + 1, secondDot - firstDot - 1,
+                                     payloadBuffer, sizeof(payloadBuffer), &payloadLen,
+                                     BASE64_URL | BASE64_NO_PAD);
   
   StaticJsonDocument<512> payloadDoc;
-  if (deserializeJson(payloadDoc, decodedPayload) != DeserializationError::Ok) {
+  if (!payloadDecoded ||
+      deserializeJson(payloadDoc, (const char*)payloadBuffer, payloadLen) != DeserializationError::Ok) {
     Serial.println("❌ Invalid JWT payload");
     return false;
   }
@@ -944,14 +925,11 @@ String generateHMAC(const String& data, const String& key) {
   
   mbedtls_md_free(&ctx);
   
-  // Convert to hex string
-  String result = "";
-  for (int i = 0; i < 32; i++) {
-    if (hmac[i] < 16) result += "0";
-    result += String(hmac[i], HEX);
-  }
+  // Convert to hex string (one allocation for the returned String)
+  FixedString<65> hex;
+  hex.appendHex(hmac, sizeof(hmac));
   
-  return result;
+  return String(hex.c_str());
 }
 
 // ===== ENHANCED AUTHENTICATION HELPER FUNCTIONS =====
@@ -1056,23 +1034,17 @@ namespace {
       return false;
     }
 
-    String encodedPayload(encoded.data());
-    if (!isValidBase64(encodedPayload)) {
+    // Decode over the encoded copy; the JSON is shorter than its base64
+    size_t decodedLength = 0;
+    if (!base64DecodeInPlace(encoded.data(), strlen(encoded.data()), &decodedLength) || decodedLength == 0) {
       Serial.println("Pairing sync: device_data payload is not valid base64");
       nvs_close(nvsHandle);
       return false;
     }
-
-    std::vector<uint8_t> decoded = decodeBase64ToVector(encodedPayload);
-    if (decoded.empty()) {
-      Serial.println("Pairing sync: failed to decode device_data payload");
-      nvs_close(nvsHandle);
-      return false;
-    }
-    decoded.push_back('\0');
+    encoded[decodedLength] = '\0';
 
     StaticJsonDocument<512> doc;
-    DeserializationError jsonErr = deserializeJson(doc, (const char*)decoded.data());
+    DeserializationError jsonErr = deserializeJson(doc, (const char*)encoded.data());
     if (jsonErr) {
       Serial.printf("Pairing sync: JSON parse error: %s\n", jsonErr.c_str());
       nvs_close(nvsHandle);
@@ -1,5 +1,6 @@
 #include "sensors.h"
 #include <WiFi.h>
+#include "fixed_string.h"
 
 void initSensors() {
   Serial.println("📊 Initializing sensors...");
@@ -43,14 +44,11 @@ int getFreeHeap() {
 String sensorsToJson() {
   SensorData data = readAllSensors();
   
-  String json = "{";
-  json += "\"button_pressed\":" + String(data.buttonPressed ? "true" : "false") + ",";
-  json += "\"wifi_strength\":" + String(data.wifiStrength) + ",";
-  json += "\"uptime\":" + String(data.uptime) + ",";
-  json += "\"free_heap\":" + String(data.freeHeap);
-  json += "}";
+  FixedString<128> json;
+  json.appendf("{\"button_pressed\":%s,\"wifi_strength\":%d,\"uptime\":%lu,\"free_heap\":%d}",
+               data.buttonPressed ? "true" : "false", data.wifiStrength, data.uptime, data.freeHeap);
   
-  return json;
+  return String(json.c_str());
 }
 
 void printSensorData(SensorData data) {
@@ -0,0 +1,323 @@
+#include "stack_monitor.h"
+#include "metrics_registry.h"
+#if STACK_MONITOR_ISR
+#include <esp_ipc.h>
+#endif
+
+static StackUsageEntry stackTable[STACK_MONITOR_MAX_TASKS];
+static size_t stackTableCount = 0;
+static portMUX_TYPE stackMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t scanningHandle = nullptr;   // Task whose stack the sampler is reading (guarded by stackMux)
+static bool stackMonitorInitialized = false;
+static unsigned long lastStackSample = 0;
+
+static MetricId metricMinFree = METRIC_INVALID;
+static MetricId metricWarnings = METRIC_INVALID;
+
+// =============================================================================
+// INTERRUPT STACKS
+// =============================================================================
+
+#if STACK_MONITOR_ISR
+#define ISR_STACK_PAINT       0xA5
+#define ISR_STACK_PAINT_BYTES (configISR_STACK_SIZE * 3 / 4)   // Bottom of each stack
+
+extern "C" uint8_t port_IntStack[];
+
+static uint8_t* isrStackBase(int core) {
+  return port_IntStack + (size_t)core * configISR_STACK_SIZE;
+}
+
+// Runs on the core that owns the stack, from its IPC task with interrupts
+// masked, so nothing is on that interrupt stack while it is painted. The top
+// quarter is left alone for the non-maskable levels.
+static void paintOwnIsrStack(void* arg) {
+  uint32_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+  memset(isrStackBase(xPortGetCoreID()), ISR_STACK_PAINT, ISR_STACK_PAINT_BYTES);
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+// Stacks grow down from the top, so the painted bottom stays intact until
+// an interrupt nests that deep
+static void paintIsrStacks() {
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    esp_ipc_call_blocking(core, paintOwnIsrStack, nullptr);
+  }
+}
+
+static uint32_t isrStackFree(int core) {
+  const uint8_t* base = isrStackBase(core);
+  uint32_t untouched = 0;
+  while (untouched < ISR_STACK_PAINT_BYTES && base[untouched] == ISR_STACK_PAINT) {
+    untouched++;
+  }
+  return untouched;
+}
+#endif
+
+// =============================================================================
+// REGISTRATION
+// =============================================================================
+
+// Caller holds stackMux
+static StackUsageEntry* findOrAddEntry(const char* name, uint32_t stackBytes) {
+  for (size_t i = 0; i < stackTableCount; i++) {
+    if (strncmp(stackTable[i].name, name, sizeof(stackTable[i].name) - 1) == 0) {  // Names are stored truncated
+      stackTable[i].stackSize = stackBytes;
+      return &stackTable[i];
+    }
+  }
+  if (stackTableCount >= STACK_MONITOR_MAX_TASKS) {
+    return nullptr;
+  }
+  StackUsageEntry* entry = &stackTable[stackTableCount++];
+  strncpy(entry->name, name, sizeof(entry->name) - 1);
+  entry->name[sizeof(entry->name) - 1] = '\0';
+  entry->handle = nullptr;
+  entry->stackSize = stackBytes;
+  entry->minFree = stackBytes;
+  entry->lastFree = stackBytes;
+  entry->warnLevel = 0;
+  entry->isrCore = -1;
+  return entry;
+}
+
+void registerTaskStack(TaskHandle_t task, const char* name, uint32_t stackBytes) {
+  if (task == nullptr) return;
+  portENTER_CRITICAL(&stackMux);
+  StackUsageEntry* entry = findOrAddEntry(name, stackBytes);
+  if (entry) {
+    entry->handle = task;
+  }
+  portEXIT_CRITICAL(&stackMux);
+}
+
+void registerCurrentTaskStack(const char* name, uint32_t stackBytes) {
+  registerTaskStack(xTaskGetCurrentTaskHandle(), name, stackBytes);
+}
+
+// Caller holds stackMux
+static void recordFree(StackUsageEntry& entry, uint32_t freeBytes) {
+  entry.lastFree = freeBytes;
+  if (freeBytes < entry.minFree) {
+    entry.minFree = freeBytes;
+  }
+}
+
+// Final mark of a task about to be deleted. The task is alive until the
+// caller deletes it, so the stack is read outside the lock; the handle is
+// dropped once the sampler is not reading it.
+static void retireTaskStack(TaskHandle_t task) {
+  uint32_t freeBytes = uxTaskGetStackHighWaterMark(task);  // Bytes on ESP-IDF
+  for (;;) {
+    portENTER_CRITICAL(&stackMux);
+    if (scanningHandle != task) break;
+    portEXIT_CRITICAL(&stackMux);
+    vTaskDelay(1);
+  }
+  for (size_t i = 0; i < stackTableCount; i++) {
+    if (stackTable[i].handle == task) {
+      recordFree(stackTable[i], freeBytes);
+      stackTable[i].handle = nullptr;
+    }
+  }
+  portEXIT_CRITICAL(&stackMux);
+}
+
+void noteTaskStackExit() {
+  retireTaskStack(xTaskGetCurrentTaskHandle());
+}
+
+void forgetTaskStack(TaskHandle_t task) {
+  if (task == nullptr) return;
+  retireTaskStack(task);
+}
+
+// =============================================================================
+// SAMPLING
+// =============================================================================
+
+bool initStackMonitor() {
+  if (stackMonitorInitialized) {
+    return true;
+  }
+
+  metricMinFree = registerGauge("stack.min_free", "bytes");
+  metricWarnings = registerCounter("stack.warnings");
+
+#if STACK_MONITOR_ISR
+  static const char* const isrNames[] = {"isr.core0", "isr.core1"};
+  paintIsrStacks();
+  portENTER_CRITICAL(&stackMux);
+  for (int core = 0; core < portNUM_PROCESSORS && core < 2; core++) {
+    StackUsageEntry* entry = findOrAddEntry(isrNames[core], configISR_STACK_SIZE);
+    if (entry) {
+      entry->isrCore = (int8_t)core;
+    }
+  }
+  portEXIT_CRITICAL(&stackMux);
+#endif
+
+  stackMonitorInitialized = true;
+  Serial.printf("📏 Stack monitor ready (warn below %u bytes / above %u%% used)\n",
+                STACK_WARN_FREE_BYTES, STACK_WARN_USED_PERCENT);
+  return true;
+}
+
+static uint8_t warnLevelFor(const StackUsageEntry& entry) {
+  if (entry.minFree < STACK_CRITICAL_FREE_BYTES) return 2;
+  uint32_t used = entry.stackSize - entry.minFree;
+  if (entry.minFree < STACK_WARN_FREE_BYTES ||
+      used * 100 > entry.stackSize * STACK_WARN_USED_PERCENT) {
+    return 1;
+  }
+  return 0;
+}
+
+// Watermark scans walk up to a whole stack, so they run outside stackMux.
+// Handles are snapshot under the lock; a task is claimed (scanningHandle)
+// while its stack is read, and retireTaskStack() waits for the claim before
+// the task may be deleted.
+static bool scanEntry(size_t index, TaskHandle_t handle, uint32_t& freeBytes) {
+  portENTER_CRITICAL(&stackMux);
+  bool live = stackTable[index].handle == handle;
+  if (live) scanningHandle = handle;
+  portEXIT_CRITICAL(&stackMux);
+  if (!live) return false;
+
+  freeBytes = uxTaskGetStackHighWaterMark(handle);  // Bytes on ESP-IDF
+
+  portENTER_CRITICAL(&stackMux);
+  scanningHandle = nullptr;
+  portEXIT_CRITICAL(&stackMux);
+  return true;
+}
+
+void sampleStackUsage() {
+  StackUsageEntry warned[STACK_MONITOR_MAX_TASKS];
+  TaskHandle_t handles[STACK_MONITOR_MAX_TASKS];
+#if STACK_MONITOR_ISR
+  int8_t isrCores[STACK_MONITOR_MAX_TASKS];
+#endif
+  uint32_t marks[STACK_MONITOR_MAX_TASKS];
+  bool sampled[STACK_MONITOR_MAX_TASKS];
+  size_t warnedCount = 0;
+  uint32_t lowest = UINT32_MAX;
+
+  portENTER_CRITICAL(&stackMux);
+  size_t count = stackTableCount;
+  for (size_t i = 0; i < count; i++) {
+    handles[i] = stackTable[i].handle;
+#if STACK_MONITOR_ISR
+    isrCores[i] = stackTable[i].isrCore;
+#endif
+  }
+  portEXIT_CRITICAL(&stackMux);
+
+  for (size_t i = 0; i < count; i++) {
+    sampled[i] = false;
+#if STACK_MONITOR_ISR
+    if (isrCores[i] >= 0) {
+      marks[i] = isrStackFree(isrCores[i]);
+      sampled[i] = true;
+    }
+#endif
+    if (handles[i] != nullptr) {
+      sampled[i] = scanEntry(i, handles[i], marks[i]);
+    }
+  }
+
+  portENTER_CRITICAL(&stackMux);
+  for (size_t i = 0; i < count; i++) {
+    StackUsageEntry& entry = stackTable[i];
+    if (sampled[i]) {
+      recordFree(entry, marks[i]);
+    }
+    if (entry.minFree < lowest) {
+      lowest = entry.minFree;
+    }
+
+    uint8_t level = warnLevelFor(entry);
+    if (level > entry.warnLevel) {
+      entry.warnLevel = level;
+      warned[warnedCount++] = entry;
+    }
+  }
+  portEXIT_CRITICAL(&stackMux);
+
+  if (lowest != UINT32_MAX) {
+    metricSetGauge(metricMinFree, (int32_t)lowest);
+  }
+  for (size_t i = 0; i < warnedCount; i++) {
+    const StackUsageEntry& e = warned[i];
+    metricIncrement(metricWarnings);
+    Serial.printf("%s Stack %s: %u of %u bytes free at peak (suggest %u)\n",
+                  e.warnLevel >= 2 ? "🚨" : "⚠️", e.name, e.minFree, e.stackSize,
+                  getStackSuggestion(e));
+  }
+}
+
+void handleStackMonitor() {
+  if (!stackMonitorInitialized) return;
+
+  if (millis() - lastStackSample >= STACK_MONITOR_INTERVAL) {
+    sampleStackUsage();
+    lastStackSample = millis();
+  }
+}
+
+// =============================================================================
+// REPORTING
+// =============================================================================
+
+// Peak use plus a proportional margin (with a floor), rounded up
+uint32_t getStackSuggestion(const StackUsageEntry& entry) {
+  uint32_t used = entry.stackSize - entry.minFree;
+  uint32_t margin = used * STACK_SIZING_MARGIN_PERCENT / 100;
+  if (margin < STACK_SIZING_MIN_MARGIN) {
+    margin = STACK_SIZING_MIN_MARGIN;
+  }
+  uint32_t suggested = used + margin;
+  return (suggested + STACK_SIZING_GRANULARITY - 1) / STACK_SIZING_GRANULARITY * STACK_SIZING_GRANULARITY;
+}
+
+size_t getStackEntryCount() {
+  return stackTableCount;
+}
+
+const StackUsageEntry* getStackEntryAt(size_t index) {
+  return index < stackTableCount ? &stackTable[index] : nullptr;
+}
+
+void printStackReport() {
+  sampleStackUsage();
+
+  StackUsageEntry snapshot[STACK_MONITOR_MAX_TASKS];
+  portENTER_CRITICAL(&stackMux);
+  size_t count = stackTableCount;
+  memcpy(snapshot, stackTable, sizeof(StackUsageEntry) * count);
+  portEXIT_CRITICAL(&stackMux);
+
+  Serial.println("=== 📏 Stack Usage ===");
+  Serial.println("  Stack              Size  PeakUsed  MinFree  Suggest  Status");
+  for (size_t i = 0; i < count; i++) {
+    const StackUsageEntry& e = snapshot[i];
+    uint32_t used = e.stackSize - e.minFree;
+    uint32_t suggested = getStackSuggestion(e);
+    const char* status = e.warnLevel >= 2 ? "CRITICAL"
+                       : e.warnLevel == 1 ? "TIGHT"
+                       : suggested < e.stackSize ? "OVERSIZED" : "OK";
+    Serial.printf("  %-16s %6u %9u %8u %8u  %s%s\n", e.name, e.stackSize, used,
+                  e.minFree, suggested, status, e.handle || e.isrCore >= 0 ? "" : " (exited)");
+  }
+
+  // Machine-readable lines for scripts/stack_report.py
+  for (size_t i = 0; i < count; i++) {
+    const StackUsageEntry& e = snapshot[i];
+    Serial.printf("[STACK][TASK] {\"name\":\"%s\",\"size\":%u,\"min_free\":%u,"
+                  "\"suggest\":%u,\"isr\":%s}\n",
+                  e.name, e.stackSize, e.minFree, getStackSuggestion(e),
+                  e.isrCore >= 0 ? "true" : "false");
+  }
+  Serial.println("======================");
+}
@@ -1,6 +1,7 @@
 #include <Arduino.h>  // لـ millis/Serial/delay
 #include "system_monitor.h"
 #include "config.h"
+#include "memory_budget.h"
 #include <esp_task_wdt.h>
 #include <esp_system.h>
 // Prevent CONFIG_LOG_DEFAULT_LEVEL redefinition warning
@@ -184,16 +185,9 @@ void performSystemHealthCheck() {
         const size_t CRITICAL_HEAP_THRESHOLD = 40 * 1024; // 40KB
         
         if (freeHeap < CRITICAL_HEAP_THRESHOLD) {
-            Serial.printf("🚨 CRITICAL: Low heap memory! Free: %d bytes (min: %d)\n", 
-                         freeHeap, minFreeHeap);
-            
-#ifdef PRODUCTION_BUILD
-            // In production, trigger controlled restart if heap is critically low
-            if (freeHeap < 20 * 1024) { // 20KB emergency threshold
-                Serial.println("💥 EMERGENCY: Heap exhaustion, restarting system");
-                ESP.restart();
-            }
-#endif
+            // Load shedding and, as a last resort, the restart are owned by the memory budget
+            Serial.printf("🚨 CRITICAL: Low heap memory! Free: %d bytes (min: %d), degradation level %u\n", 
+                         freeHeap, minFreeHeap, getDegradationLevel());
         } else {
             // Normal heap logging (less frequent in production)
 #ifdef PRODUCTION_BUILD
@@ -0,0 +1,259 @@
+#include "task_stats.h"
+#include <algorithm>
+
+static TaskStatsEntry taskTable[TASK_STATS_MAX_TASKS];
+static size_t taskTableCount = 0;
+static bool taskStatsInitialized = false;
+static unsigned long lastTaskSample = 0;
+
+static float coreCpuPercent[portNUM_PROCESSORS] = {0};
+static MetricId metricCoreCpu[portNUM_PROCESSORS];  // Every entry set in initTaskStats()
+static MetricId metricTotalCpu = METRIC_INVALID;
+static MetricId metricLoopHist = METRIC_INVALID;
+static MetricId metricLoopStalls = METRIC_INVALID;
+static MetricId metricLoopMax = METRIC_INVALID;
+
+// Main loop busy time within the current window (fallback CPU estimate)
+static uint64_t loopBusyUs = 0;
+static uint32_t loopWindowMaxUs = 0;
+static uint32_t loopWindowStartUs = 0;
+
+#if TASK_STATS_RUNTIME_AVAILABLE
+static TaskStatus_t statusBuffer[TASK_STATS_MAX_TASKS + 4];
+static uint32_t lastTotalRunTime = 0;
+#endif
+
+bool initTaskStats() {
+  if (taskStatsInitialized) {
+    return true;
+  }
+
+  static const char* const coreMetricNames[] = {"cpu.core0", "cpu.core1"};
+  std::fill(metricCoreCpu, metricCoreCpu + portNUM_PROCESSORS, METRIC_INVALID);
+  for (int core = 0; core < portNUM_PROCESSORS && core < 2; core++) {
+    metricCoreCpu[core] = registerGauge(coreMetricNames[core], "%");
+  }
+  metricTotalCpu = registerGauge("cpu.total", "%");
+  metricLoopHist = registerHistogram("loop.iteration", "us");
+  metricLoopStalls = registerCounter("loop.stalls");
+  metricLoopMax = registerGauge("loop.max_window", "us");
+
+  loopWindowStartUs = micros();
+  taskStatsInitialized = true;
+
+#if TASK_STATS_RUNTIME_AVAILABLE
+  Serial.println("🧮 Task stats: FreeRTOS run-time accounting enabled");
+#else
+  Serial.println("🧮 Task stats: run-time stats unavailable, using loop busy time");
+#endif
+  return true;
+}
+
+void recordLoopIteration(uint32_t busyUs) {
+  metricObserve(metricLoopHist, busyUs);
+  loopBusyUs += busyUs;
+  if (busyUs > loopWindowMaxUs) {
+    loopWindowMaxUs = busyUs;
+  }
+
+  if (busyUs > LOOP_STALL_THRESHOLD_MS * 1000UL) {
+    metricIncrement(metricLoopStalls);
+    Serial.printf("🐢 Loop stall: %lu ms\n", (unsigned long)(busyUs / 1000));
+  }
+}
+
+#if TASK_STATS_RUNTIME_AVAILABLE
+static TaskStatsEntry* findOrAddTask(const TaskStatus_t& status) {
+  for (size_t i = 0; i < taskTableCount; i++) {
+    if (taskTable[i].handle == status.xHandle) {
+      return &taskTable[i];
+    }
+  }
+
+  // Recreated tasks (e.g. adc_capture_task per utterance) reuse their old slot.
+  // Slots are never renamed: the registry keeps a pointer to metricName.
+  TaskStatsEntry* entry = nullptr;
+  for (size_t i = 0; i < taskTableCount; i++) {
+    if (taskTable[i].handle == nullptr &&
+        strncmp(taskTable[i].name, status.pcTaskName, sizeof(taskTable[i].name)) == 0) {
+      entry = &taskTable[i];
+      break;
+    }
+  }
+  if (entry == nullptr) {
+    if (taskTableCount >= TASK_STATS_MAX_TASKS) {
+      static bool warned = false;
+      if (!warned) {
+        warned = true;
+        Serial.printf("⚠️ Task stats: more than %d tasks, '%s' not tracked\n",
+                      TASK_STATS_MAX_TASKS, status.pcTaskName);
+      }
+      return nullptr;
+    }
+    entry = &taskTable[taskTableCount++];
+    strncpy(entry->name, status.pcTaskName, sizeof(entry->name) - 1);
+    entry->name[sizeof(entry->name) - 1] = '\0';
+    snprintf(entry->metricName, sizeof(entry->metricName), "task.%.*s.cpu",
+             (int)(sizeof(entry->name) - 1), status.pcTaskName);
+    entry->cpuGauge = registerGauge(entry->metricName, "%");
+  }
+
+  entry->handle = status.xHandle;
+  entry->lastRunTime = status.ulRunTimeCounter;
+  entry->maxWindowRunTime = 0;
+  entry->readyObservations = 0;
+  entry->cpuPercent = 0.0f;
+  return entry;
+}
+#endif
+
+void sampleTaskStats() {
+  uint32_t nowUs = micros();
+
+#if TASK_STATS_RUNTIME_AVAILABLE
+  uint32_t totalRunTime = 0;
+  UBaseType_t count = uxTaskGetSystemState(statusBuffer, TASK_STATS_MAX_TASKS + 4, &totalRunTime);
+  if (count == 0) {
+    Serial.println("⚠️ Task stats: too many tasks for sample buffer");
+    return;
+  }
+
+  uint32_t elapsed = totalRunTime - lastTotalRunTime;
+  bool firstSample = (lastTotalRunTime == 0);
+  lastTotalRunTime = totalRunTime;
+
+  for (size_t i = 0; i < taskTableCount; i++) {
+    taskTable[i].seen = false;
+  }
+
+  for (UBaseType_t i = 0; i < count; i++) {
+    const TaskStatus_t& status = statusBuffer[i];
+    TaskStatsEntry* entry = findOrAddTask(status);
+    if (entry == nullptr) continue;
+
+    uint32_t delta = status.ulRunTimeCounter - entry->lastRunTime;
+    entry->lastRunTime = status.ulRunTimeCounter;
+    entry->seen = true;
+    entry->priority = status.uxCurrentPriority;
+    entry->stackHighWater = status.usStackHighWaterMark;
+#if defined(configTASKLIST_INCLUDE_COREID) && configTASKLIST_INCLUDE_COREID
+    entry->core = (status.xCoreID == tskNO_AFFINITY) ? -1 : (int8_t)status.xCoreID;
+#else
+    entry->core = -1;
+#endif
+    if (status.eCurrentState == eReady) {
+      entry->readyObservations++;
+    }
+
+    if (!firstSample && elapsed > 0) {
+      entry->cpuPercent = (float)delta * 100.0f / (float)elapsed;
+      if (delta > entry->maxWindowRunTime) {
+        entry->maxWindowRunTime = delta;
+      }
+      metricSetGauge(entry->cpuGauge, (int32_t)(entry->cpuPercent + 0.5f));
+    }
+  }
+
+  // Forget tasks that were deleted since the last sample
+  for (size_t i = 0; i < taskTableCount; i++) {
+    if (!taskTable[i].seen) {
+      taskTable[i].handle = nullptr;
+      taskTable[i].cpuPercent = 0.0f;
+      metricSetGauge(taskTable[i].cpuGauge, 0);
+    }
+  }
+
+  // Core load is everything the idle task did not get
+  if (!firstSample) {
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+      TaskHandle_t idle = xTaskGetIdleTaskHandleForCPU(core);
+      for (size_t i = 0; i < taskTableCount; i++) {
+        if (taskTable[i].handle == idle) {
+          float load = 100.0f - taskTable[i].cpuPercent;
+          coreCpuPercent[core] = load < 0.0f ? 0.0f : load;
+          break;
+        }
+      }
+    }
+  }
+#else
+  // Only the loop task is measurable: report its busy share on the Arduino core
+  uint32_t windowUs = nowUs - loopWindowStartUs;
+  if (windowUs > 0) {
+    float load = (float)loopBusyUs * 100.0f / (float)windowUs;
+    coreCpuPercent[ARDUINO_RUNNING_CORE] = load > 100.0f ? 100.0f : load;
+  }
+#endif
+
+  for (int core = 0; core < portNUM_PROCESSORS && core < 2; core++) {
+    metricSetGauge(metricCoreCpu[core], (int32_t)(coreCpuPercent[core] + 0.5f));
+  }
+  metricSetGauge(metricTotalCpu, (int32_t)(getTotalCpuPercent() + 0.5f));
+  metricSetGauge(metricLoopMax, (int32_t)loopWindowMaxUs);
+
+  loopBusyUs = 0;
+  loopWindowMaxUs = 0;
+  loopWindowStartUs = nowUs;
+}
+
+void handleTaskStats() {
+  if (!taskStatsInitialized) return;
+
+  if (millis() - lastTaskSample >= TASK_STATS_INTERVAL) {
+    sampleTaskStats();
+    lastTaskSample = millis();
+  }
+}
+
+float getCoreCpuPercent(int core) {
+  if (core < 0 || core >= portNUM_PROCESSORS) return 0.0f;
+  return coreCpuPercent[core];
+}
+
+float getTotalCpuPercent() {
+  float sum = 0.0f;
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    sum += coreCpuPercent[core];
+  }
+  return sum / portNUM_PROCESSORS;
+}
+
+const TaskStatsEntry* getTaskStats(const char* name) {
+  for (size_t i = 0; i < taskTableCount; i++) {
+    if (taskTable[i].handle != nullptr && strcmp(taskTable[i].name, name) == 0) {
+      return &taskTable[i];
+    }
+  }
+  return nullptr;
+}
+
+size_t getTaskStatsCount() {
+  return taskTableCount;
+}
+
+const TaskStatsEntry* getTaskStatsAt(size_t index) {
+  return index < taskTableCount ? &taskTable[index] : nullptr;
+}
+
+void printTaskStats() {
+  Serial.println("=== 🧮 Task CPU Stats ===");
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    Serial.printf("  Core %d load: %.1f%%\n", core, coreCpuPercent[core]);
+  }
+#if TASK_STATS_RUNTIME_AVAILABLE
+  Serial.println("  Task             Core Prio   CPU%  MaxSlice(us) Ready Stack");
+  for (size_t i = 0; i < taskTableCount; i++) {
+    const TaskStatsEntry& t = taskTable[i];
+    if (t.handle == nullptr) continue;
+    Serial.printf("  %-16s %4d %4u %6.1f %13u %5u %5u\n",
+                  t.name, t.core, (unsigned)t.priority, t.cpuPercent,
+                  t.maxWindowRunTime, t.readyObservations, t.stackHighWater);
+  }
+#endif
+  HistogramSnapshot loop;
+  if (getHistogramSnapshot(metricLoopHist, loop) && loop.count > 0) {
+    Serial.printf("  Loop p50/p99/max: %u / %u / %u us, stalls: %u\n",
+                  loop.p50, loop.p99, loop.max, getCounterValue(metricLoopStalls));
+  }
+  Serial.println("=========================");
+}
@@ -0,0 +1,176 @@
+#include "utterance_trace.h"
+#include "time_sync.h"
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <sys/time.h>
+#include <freertos/FreeRTOS.h>
+
+static TraceEvent traceRing[TRACE_RING_CAPACITY];
+static uint16_t traceHead = 0;     // Next write position
+static uint16_t traceCount = 0;    // Valid events (saturates at capacity)
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Active utterance and its clock anchor
+static volatile uint32_t currentUtterance = 0;
+static int64_t syncDeviceUs = 0;
+static int64_t syncEpochMs = 0;
+static uint32_t syncUtterance = 0;
+
+static const char* const spanNames[TRACE_SPAN_COUNT] = {
+  "utterance",
+  "capture",
+  "encode",
+  "send",
+  "audio_end",
+  "response",
+  "decode",
+  "playback"
+};
+
+uint32_t traceNow() {
+  return (uint32_t)esp_timer_get_time();
+}
+
+static void pushEvent(TraceSpan span, uint8_t phase, uint32_t ts, uint32_t dur, uint16_t arg) {
+  uint32_t utterance = currentUtterance;
+  if (utterance == 0) return;  // Not tracing
+
+  portENTER_CRITICAL_SAFE(&traceMux);
+  TraceEvent& e = traceRing[traceHead];
+  e.ts_us = ts;
+  e.dur_us = dur;
+  e.utterance = utterance;
+  e.arg = arg;
+  e.span = (uint8_t)span;
+  e.phase = phase;
+  traceHead = (traceHead + 1) % TRACE_RING_CAPACITY;
+  if (traceCount < TRACE_RING_CAPACITY) traceCount++;
+  portEXIT_CRITICAL_SAFE(&traceMux);
+}
+
+uint32_t beginUtteranceTrace() {
+  // Random non-zero id so ids from different boots never collide server-side
+  uint32_t id;
+  do {
+    id = esp_random();
+  } while (id == 0);
+
+  syncDeviceUs = esp_timer_get_time();
+  syncEpochMs = 0;
+  if (isTimeSynced()) {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    syncEpochMs = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+  }
+  syncUtterance = id;
+  currentUtterance = id;
+  pushEvent(TRACE_SPAN_UTTERANCE, 'i', (uint32_t)syncDeviceUs, 0, 0);
+  return id;
+}
+
+void endUtteranceTrace() {
+  uint32_t utterance = currentUtterance;
+  if (utterance == 0) return;
+
+  if (utterance == syncUtterance) {
+    uint32_t start = (uint32_t)syncDeviceUs;
+    pushEvent(TRACE_SPAN_UTTERANCE, 'X', start, traceNow() - start, 0);
+  }
+
+#if TRACE_DUMP_ON_COMPLETE && !defined(PRODUCTION_BUILD)
+  dumpUtteranceTrace(utterance);
+#endif
+  currentUtterance = 0;
+}
+
+uint32_t getCurrentUtteranceId() {
+  return currentUtterance;
+}
+
+void traceComplete(TraceSpan span, uint32_t startUs, uint16_t arg) {
+  pushEvent(span, 'X', startUs, traceNow() - startUs, arg);
+}
+
+void traceInstant(TraceSpan span, uint16_t arg) {
+  pushEvent(span, 'i', traceNow(), 0, arg);
+}
+
+const char* getTraceSpanName(TraceSpan span) {
+  return span < TRACE_SPAN_COUNT ? spanNames[span] : "unknown";
+}
+
+size_t getTraceEventCount() {
+  return traceCount;
+}
+
+void dumpUtteranceTrace(uint32_t utterance) {
+  if (utterance == syncUtterance) {
+    Serial.printf("[TRACE][SYNC] {\"utt\":%u,\"dev_us\":%lld,\"epoch_ms\":%lld}\n",
+                  utterance, (long long)syncDeviceUs, (long long)syncEpochMs);
+  }
+
+  // Copy out under the lock so Serial never runs inside the critical section
+  uint16_t start = (traceHead + TRACE_RING_CAPACITY - traceCount) % TRACE_RING_CAPACITY;
+  uint16_t total = traceCount;
+  for (uint16_t i = 0; i < total; i++) {
+    TraceEvent e;
+    portENTER_CRITICAL(&traceMux);
+    e = traceRing[(start + i) % TRACE_RING_CAPACITY];
+    portEXIT_CRITICAL(&traceMux);
+
+    if (e.utterance != utterance) continue;
+    Serial.printf("[TRACE][EVT] {\"utt\":%u,\"span\":\"%s\",\"ph\":\"%c\",\"ts\":%u,\"dur\":%u,\"arg\":%u}\n",
+                  e.utterance, getTraceSpanName((TraceSpan)e.span), (char)e.phase,
+                  e.ts_us, e.dur_us, e.arg);
+  }
+}
+
+uint32_t getTraceStageStats(TraceStageStats stats[TRACE_SPAN_COUNT]) {
+  memset(stats, 0, sizeof(TraceStageStats) * TRACE_SPAN_COUNT);
+
+  // Walk newest to oldest; the first event seen names the utterance
+  uint32_t utterance = 0;
+  uint16_t total = traceCount;
+  for (uint16_t i = 0; i < total; i++) {
+    TraceEvent e;
+    portENTER_CRITICAL(&traceMux);
+    e = traceRing[(traceHead + TRACE_RING_CAPACITY - 1 - i) % TRACE_RING_CAPACITY];
+    portEXIT_CRITICAL(&traceMux);
+
+    if (utterance == 0) utterance = e.utterance;
+    if (e.utterance != utterance || e.phase != 'X' || e.span >= TRACE_SPAN_COUNT) continue;
+    TraceStageStats& s = stats[e.span];
+    s.count++;
+    s.totalUs += e.dur_us;
+    s.maxUs = max(s.maxUs, e.dur_us);
+  }
+  return utterance;
+}
+
+void printTraceStageSummary() {
+  TraceStageStats stats[TRACE_SPAN_COUNT];
+  uint32_t utterance = getTraceStageStats(stats);
+  if (utterance == 0) {
+    Serial.println("🎙️ No utterance traced yet");
+    return;
+  }
+
+  Serial.printf("=== 🎙️ Audio Stages (utterance %u) ===\n", utterance);
+  Serial.println("Stage        Count   Total(us)     Avg(us)     Max(us)");
+  for (uint8_t i = 0; i < TRACE_SPAN_COUNT; i++) {
+    const TraceStageStats& s = stats[i];
+    if (s.count == 0) continue;
+    Serial.printf("%-10s %7u %11u %11u %11u\n", getTraceSpanName((TraceSpan)i),
+                  s.count, s.totalUs, s.totalUs / s.count, s.maxUs);
+  }
+  if (utterance == currentUtterance) {
+    Serial.println("(utterance still in progress)");
+  }
+}
+
+void clearUtteranceTrace() {
+  portENTER_CRITICAL(&traceMux);
+  traceHead = 0;
+  traceCount = 0;
+  portEXIT_CRITICAL(&traceMux);
+}
@@ -0,0 +1,36 @@
+#include "web_assets.h"
+#include "web_assets_data.h"
+
+static const char* WEB_ASSET_HEADERS[] = {"If-None-Match"};
+
+const WebAsset* findWebAsset(const char* name) {
+  for (const WebAsset& asset : WEB_ASSETS) {
+    if (strcmp(asset.name, name) == 0) {
+      return &asset;
+    }
+  }
+  return nullptr;
+}
+
+void collectWebAssetHeaders(WebServer& server) {
+  server.collectHeaders(WEB_ASSET_HEADERS, sizeof(WEB_ASSET_HEADERS) / sizeof(WEB_ASSET_HEADERS[0]));
+}
+
+bool sendWebAsset(WebServer& server, const char* name) {
+  const WebAsset* asset = findWebAsset(name);
+  if (asset == nullptr) {
+    server.send(404, "text/plain", "Not found\n");
+    return false;
+  }
+
+  server.sendHeader("ETag", asset->etag);
+  server.sendHeader("Cache-Control", WEB_ASSET_CACHE_CONTROL);
+  if (server.header("If-None-Match") == asset->etag) {
+    server.send(304);
+    return true;
+  }
+  server.sendHeader("Content-Encoding", "gzip");
+  // send_P writes the body from the flash pointer without a heap copy
+  server.send_P(200, asset->contentType, (PGM_P)asset->data, asset->length);
+  return true;
+}
@@ -0,0 +1,192 @@
+// Generated by scripts/web_assets.py from web/ - do not edit
+// Included only by web_assets.cpp
+
+// ota.html: 1573 bytes, 721 gzipped
+static const uint8_t WEB_OTA_HTML_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x7d, 0x55, 0xdb, 0x6e, 0xda, 0x40,
+  0x10, 0x7d, 0xe7, 0x2b, 0xa6, 0xee, 0x43, 0x88, 0x54, 0x6c, 0x48, 0x42, 0x1b, 0xf9, 0x26, 0x25,
+  0x21, 0x51, 0x79, 0xa8, 0x52, 0x55, 0xa4, 0x52, 0x9f, 0xa2, 0xc5, 0x3b, 0xc6, 0xdb, 0xd8, 0xbb,
+  0xd6, 0xee, 0x1a, 0x82, 0xa2, 0xfc, 0x7b, 0xc7, 0x17, 0x5a, 0x43, 0x49, 0xc4, 0xc3, 0xd8, 0x73,
+  0x39, 0xe7, 0x78, 0x66, 0x76, 0x09, 0x3f, 0xcc, 0xee, 0x6f, 0x16, 0xbf, 0xbe, 0xdf, 0x42, 0x66,
+  0x8b, 0x3c, 0x1e, 0x84, 0x3b, 0x83, 0x8c, 0x93, 0x29, 0xd0, 0x32, 0x48, 0x32, 0xa6, 0x0d, 0xda,
+  0xc8, 0x79, 0x58, 0xdc, 0x8d, 0x2e, 0x9d, 0x9d, 0x5b, 0xb2, 0x02, 0x23, 0x67, 0x2d, 0x70, 0x53,
+  0x2a, 0x6d, 0x1d, 0x48, 0x94, 0xb4, 0x28, 0x29, 0x6d, 0x23, 0xb8, 0xcd, 0x22, 0x8e, 0x6b, 0x91,
+  0xe0, 0xa8, 0x79, 0xf9, 0x04, 0x42, 0x0a, 0x2b, 0x58, 0x3e, 0x32, 0x09, 0xcb, 0x31, 0x9a, 0xb8,
+  0xe3, 0x1a, 0xc6, 0x0a, 0x9b, 0x63, 0x7c, 0x35, 0x87, 0x05, 0x72, 0xbe, 0x85, 0x6b, 0x64, 0x1a,
+  0xee, 0x17, 0x57, 0xa1, 0xd7, 0x06, 0x06, 0xa1, 0xb1, 0xdb, 0xda, 0x2e, 0x15, 0x45, 0x5f, 0x20,
+  0x25, 0x82, 0x51, 0xca, 0x0a, 0x91, 0x6f, 0x7d, 0xb8, 0xd2, 0x04, 0x17, 0x80, 0xc5, 0x67, 0x3b,
+  0x62, 0xb9, 0x58, 0x49, 0x1f, 0x12, 0x62, 0x47, 0x1d, 0xc0, 0x92, 0x25, 0x4f, 0x2b, 0xad, 0x2a,
+  0xc9, 0x7d, 0xf8, 0x98, 0x8e, 0xeb, 0x5f, 0x00, 0xaf, 0x03, 0xb7, 0x16, 0xc8, 0x84, 0x44, 0x4d,
+  0x58, 0x05, 0x7b, 0x6e, 0xa5, 0xf9, 0x70, 0x31, 0x1e, 0x97, 0xcf, 0x01, 0x79, 0xf4, 0x4a, 0x10,
+  0xca, 0x94, 0xde, 0x80, 0x55, 0x56, 0x05, 0x50, 0x32, 0xce, 0x85, 0x5c, 0xf9, 0x70, 0xd6, 0x64,
+  0xf4, 0x71, 0x37, 0x99, 0xb0, 0x48, 0x2e, 0xa5, 0x39, 0xea, 0x91, 0x66, 0x5c, 0x54, 0xc6, 0x87,
+  0x49, 0x93, 0xf7, 0x3a, 0xc8, 0x26, 0x44, 0x91, 0xa8, 0x5c, 0x69, 0x52, 0x70, 0x7e, 0x7e, 0xde,
+  0xd0, 0x0b, 0x99, 0x2a, 0x72, 0xef, 0xa9, 0xc3, 0xcb, 0xf4, 0x22, 0xe5, 0x3d, 0xa6, 0xc9, 0xb4,
+  0x61, 0xda, 0x87, 0x9d, 0xf6, 0xf5, 0xd5, 0x1c, 0xd0, 0x7e, 0xd0, 0xb2, 0xb2, 0x56, 0xc9, 0x43,
+  0xcc, 0xf1, 0xf8, 0xcb, 0x32, 0x4d, 0x83, 0x1d, 0x7f, 0xa7, 0xf4, 0x1f, 0xc3, 0x19, 0xd5, 0x9f,
+  0xf5, 0x68, 0x7c, 0x90, 0x4a, 0xe2, 0x71, 0xd2, 0xa4, 0xd2, 0xa6, 0x06, 0x29, 0x95, 0x68, 0x7b,
+  0xdb, 0x57, 0xd1, 0x75, 0x9f, 0x63, 0xa2, 0x34, 0xb3, 0x42, 0xc9, 0x1d, 0x12, 0x17, 0xa6, 0xcc,
+  0x19, 0x0d, 0x49, 0xc8, 0x9c, 0xfa, 0x3d, 0x5a, 0xe6, 0x2a, 0x79, 0xea, 0x29, 0xf6, 0x33, 0xb5,
+  0x6e, 0xa6, 0x70, 0xa0, 0x7b, 0xfa, 0x79, 0xd9, 0xb4, 0x2a, 0xf4, 0xba, 0xc1, 0x87, 0x5e, 0xb7,
+  0x87, 0xf5, 0x06, 0x90, 0xe1, 0x62, 0x0d, 0x49, 0xce, 0x8c, 0x89, 0x9c, 0xbf, 0xc3, 0xac, 0x17,
+  0x29, 0x9b, 0xec, 0x6f, 0x11, 0xd5, 0x4d, 0xf6, 0xd3, 0xeb, 0xe6, 0xd7, 0x99, 0x65, 0x4c, 0x4b,
+  0xa5, 0x95, 0x5c, 0xc5, 0xb3, 0x66, 0x3f, 0x61, 0x3e, 0xf3, 0x6b, 0xba, 0xc6, 0x05, 0xa1, 0x29,
+  0x99, 0x04, 0xc1, 0x23, 0xa7, 0xdd, 0xde, 0x39, 0x77, 0x62, 0xd7, 0x75, 0x29, 0x81, 0xfc, 0x71,
+  0xe8, 0x95, 0x7b, 0x08, 0x77, 0x42, 0x17, 0x1b, 0xa6, 0xf1, 0x28, 0x40, 0xda, 0x05, 0x7f, 0xa2,
+  0x36, 0xd4, 0x9a, 0x77, 0x71, 0x34, 0x22, 0x7c, 0xc3, 0x42, 0xe9, 0xed, 0x71, 0x28, 0x8a, 0x7f,
+  0x45, 0x56, 0xf6, 0x31, 0x60, 0xb9, 0xb5, 0x68, 0x0e, 0x91, 0x1e, 0x4a, 0x2b, 0x8a, 0xe3, 0x7a,
+  0xaa, 0x26, 0xb4, 0x07, 0x61, 0x68, 0x70, 0x92, 0x77, 0x20, 0x1e, 0x35, 0x8b, 0x0c, 0x83, 0x4c,
+  0x63, 0x1a, 0x39, 0x5e, 0x55, 0x72, 0x66, 0xd1, 0xd9, 0xf5, 0xaf, 0x1d, 0x9c, 0x13, 0xd3, 0xf1,
+  0x84, 0x87, 0x26, 0x14, 0x7a, 0xac, 0x9f, 0xaf, 0xd1, 0x58, 0xd6, 0x5c, 0x03, 0xfb, 0x05, 0x3f,
+  0x5a, 0x3f, 0xb4, 0xed, 0x3e, 0x28, 0xe2, 0xb8, 0xac, 0x56, 0xff, 0x95, 0xcc, 0x04, 0x5b, 0x49,
+  0x65, 0xac, 0x48, 0x4c, 0x9b, 0xdf, 0x69, 0x33, 0x89, 0x16, 0xa5, 0x8d, 0x07, 0x29, 0xda, 0x24,
+  0x1b, 0x9e, 0xd0, 0x47, 0x32, 0x5b, 0x99, 0x93, 0x53, 0xd7, 0x66, 0x28, 0x87, 0x24, 0xa0, 0x54,
+  0xd2, 0x20, 0x44, 0x31, 0xec, 0x9e, 0xdd, 0xdf, 0x46, 0xc9, 0xe1, 0x69, 0x97, 0x41, 0xaa, 0x59,
+  0x1d, 0x7d, 0x19, 0x70, 0x95, 0x54, 0x05, 0xdd, 0x16, 0xee, 0x0a, 0xed, 0x6d, 0x8e, 0xf5, 0xe3,
+  0xf5, 0x76, 0xce, 0x87, 0x27, 0xbb, 0xb1, 0xd7, 0xa0, 0xb4, 0xdb, 0x37, 0xed, 0x95, 0x06, 0x11,
+  0xd4, 0xb5, 0x6e, 0x1b, 0x7d, 0x14, 0x3c, 0x78, 0x1b, 0xe1, 0x60, 0xee, 0xc7, 0x81, 0x76, 0x49,
+  0x8f, 0xeb, 0x36, 0xeb, 0x3d, 0xbc, 0x6e, 0xf8, 0x6f, 0x00, 0x51, 0xf4, 0x91, 0xce, 0x48, 0xf9,
+  0x0e, 0x42, 0x3b, 0xf9, 0xe3, 0xf5, 0x6d, 0x2c, 0x18, 0xbc, 0x9e, 0x06, 0xf5, 0xa9, 0xeb, 0x1a,
+  0x1c, 0x7a, 0xdd, 0x79, 0xf3, 0xda, 0x7f, 0x83, 0x3f, 0x64, 0x6a, 0x42, 0xf6, 0x25, 0x06, 0x00,
+  0x00,
+};
+
+// portal.html: 5971 bytes, 2082 gzipped
+static const uint8_t WEB_PORTAL_HTML_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x58, 0x7d, 0x6f, 0xdb, 0x36,
+  0x1a, 0xff, 0xdf, 0x9f, 0x82, 0xf1, 0x70, 0x95, 0x8d, 0xc5, 0x6f, 0x49, 0xbc, 0x74, 0x8e, 0xed,
+  0x21, 0x4d, 0x5a, 0x5c, 0x80, 0xb5, 0x0b, 0x96, 0xf4, 0x0e, 0x07, 0x0c, 0x08, 0x68, 0x91, 0xb2,
+  0x79, 0x95, 0x44, 0x81, 0xa4, 0xe2, 0x1a, 0x59, 0xbe, 0xfb, 0x3d, 0x0f, 0x49, 0xc9, 0x92, 0x2d,
+  0xbb, 0xdd, 0x70, 0x08, 0x02, 0x49, 0xe4, 0xc3, 0xdf, 0xf3, 0xfe, 0x42, 0x4f, 0x4f, 0x6e, 0x7f,
+  0xbb, 0x79, 0xfc, 0xcf, 0xfd, 0x7b, 0xb2, 0x32, 0x49, 0x3c, 0x6f, 0x4d, 0x8b, 0x07, 0xa7, 0x0c,
+  0x1e, 0x09, 0x37, 0x94, 0x84, 0x2b, 0xaa, 0x34, 0x37, 0xb3, 0xf6, 0xe7, 0xc7, 0x0f, 0xbd, 0xb7,
+  0xed, 0x62, 0x39, 0xa5, 0x09, 0x9f, 0xb5, 0x9f, 0x05, 0x5f, 0x67, 0x52, 0x99, 0x36, 0x09, 0x65,
+  0x6a, 0x78, 0x0a, 0x64, 0x6b, 0xc1, 0xcc, 0x6a, 0xc6, 0xf8, 0xb3, 0x08, 0x79, 0xcf, 0x7e, 0x9c,
+  0x12, 0x91, 0x0a, 0x23, 0x68, 0xdc, 0xd3, 0x21, 0x8d, 0xf9, 0x6c, 0xd4, 0x1f, 0x22, 0x8c, 0x11,
+  0x26, 0xe6, 0xf3, 0xeb, 0x3b, 0xf2, 0xc8, 0x19, 0xdb, 0x90, 0x77, 0x9c, 0x2a, 0xf2, 0xc0, 0x4d,
+  0x9e, 0x4d, 0x07, 0x6e, 0xab, 0x35, 0xd5, 0x66, 0x83, 0xcf, 0x85, 0x84, 0xfd, 0x17, 0x12, 0x01,
+  0x8b, 0x5e, 0x44, 0x13, 0x11, 0x6f, 0x26, 0xe4, 0x5a, 0x01, 0xe0, 0x29, 0xd1, 0x34, 0xd5, 0x3d,
+  0xcd, 0x95, 0x88, 0xae, 0x48, 0x42, 0xd5, 0x52, 0xa4, 0x13, 0x72, 0x36, 0xcc, 0xbe, 0x5e, 0x91,
+  0x05, 0x0d, 0xbf, 0x2c, 0x95, 0xcc, 0x53, 0x36, 0x21, 0x3f, 0x44, 0x43, 0xfc, 0xbb, 0x22, 0xaf,
+  0xad, 0x3e, 0x0a, 0x4a, 0x45, 0xca, 0x15, 0x20, 0x26, 0xf4, 0xab, 0x13, 0x71, 0x42, 0x2e, 0x86,
+  0xf6, 0x54, 0x81, 0x31, 0x24, 0x34, 0x37, 0xb2, 0x8e, 0xb2, 0x5e, 0x09, 0xc3, 0xaf, 0x48, 0x46,
+  0x19, 0x13, 0xe9, 0xb2, 0xe4, 0x23, 0x15, 0xe3, 0xaa, 0xa7, 0x28, 0x13, 0xb9, 0x9e, 0x90, 0x91,
+  0x5d, 0x04, 0x3e, 0x68, 0x43, 0xcb, 0xc4, 0xf0, 0xaf, 0xa6, 0x47, 0x63, 0xb1, 0x04, 0xd8, 0x10,
+  0x4c, 0xc4, 0xd5, 0x15, 0x58, 0x2b, 0x96, 0x0a, 0xe4, 0x3a, 0x3f, 0x3f, 0x2f, 0x78, 0xf6, 0x16,
+  0xd2, 0x18, 0x99, 0x14, 0xb0, 0x80, 0xa0, 0x79, 0x68, 0x84, 0x4c, 0xad, 0x9c, 0x0d, 0x14, 0xa5,
+  0x1c, 0xa3, 0xf1, 0xbe, 0xbe, 0x6f, 0xa3, 0x9f, 0x23, 0xba, 0x27, 0xdc, 0xd8, 0x21, 0x8b, 0x34,
+  0xcb, 0x0d, 0xd8, 0x8e, 0xc7, 0xc0, 0x01, 0xe0, 0xbd, 0x09, 0x46, 0xc3, 0xe1, 0x3f, 0xaa, 0xb0,
+  0x35, 0x83, 0xc0, 0x51, 0x32, 0x2c, 0x00, 0x61, 0x13, 0x3e, 0xb5, 0x8c, 0x05, 0x23, 0x3f, 0x30,
+  0xc6, 0x0e, 0x31, 0xea, 0x2f, 0x4c, 0x7a, 0x18, 0xff, 0x6c, 0x4f, 0xec, 0xe1, 0xf0, 0x72, 0x11,
+  0x45, 0xa5, 0x79, 0xbc, 0xc1, 0x0b, 0x9e, 0xa9, 0x4c, 0x79, 0x33, 0xa7, 0x30, 0x57, 0x1a, 0x0f,
+  0x64, 0x52, 0x38, 0xfb, 0xee, 0x48, 0xed, 0x24, 0x99, 0xac, 0xe4, 0xb3, 0xf5, 0xc8, 0x0e, 0xcf,
+  0xf1, 0x4f, 0x8b, 0xf3, 0x82, 0xa6, 0xb7, 0xa6, 0x2a, 0x05, 0xf1, 0x76, 0xa9, 0xa2, 0x28, 0x1c,
+  0x0d, 0x2f, 0xb7, 0x8e, 0x3b, 0x1b, 0x9d, 0x8d, 0xcf, 0x7e, 0x2e, 0x4f, 0xe9, 0x3c, 0x0c, 0xb9,
+  0xd6, 0xbb, 0xa7, 0xce, 0xde, 0xd2, 0xcb, 0x8b, 0xb1, 0x73, 0xa6, 0xa1, 0x26, 0x47, 0x82, 0x03,
+  0xf6, 0xc5, 0xaf, 0xad, 0x81, 0xeb, 0xea, 0x35, 0x45, 0x10, 0x42, 0x36, 0x33, 0x65, 0x17, 0x90,
+  0x4f, 0x74, 0x2b, 0xea, 0x68, 0x3c, 0xbe, 0x3c, 0xbb, 0xb0, 0x27, 0xb8, 0x52, 0x72, 0xcf, 0x00,
+  0xd1, 0x5b, 0x76, 0x59, 0xa5, 0xbf, 0x3c, 0x1b, 0x85, 0x9e, 0x5e, 0xa4, 0x91, 0xdc, 0x83, 0x1f,
+  0xf1, 0x30, 0x1a, 0x6d, 0xc9, 0x87, 0xe1, 0xf8, 0xe2, 0x27, 0x67, 0xe3, 0x94, 0x9b, 0xb5, 0x54,
+  0x5f, 0x7a, 0xb1, 0xd0, 0xc6, 0x67, 0xd7, 0x8a, 0x8b, 0xe5, 0xca, 0x60, 0xc8, 0x5a, 0x6d, 0xd1,
+  0x01, 0x51, 0x2c, 0xd7, 0x3d, 0xc8, 0x60, 0x9f, 0x60, 0x7f, 0x2d, 0xa0, 0x0a, 0x16, 0x10, 0x18,
+  0xc9, 0xbe, 0x31, 0xfd, 0xa1, 0x22, 0x4f, 0x2a, 0x98, 0x9c, 0xf3, 0x86, 0x30, 0xd9, 0x01, 0x6c,
+  0x0e, 0x90, 0x22, 0x97, 0x30, 0xa7, 0x05, 0x63, 0x1c, 0x23, 0x9a, 0x09, 0x9d, 0xc5, 0x74, 0x53,
+  0xc4, 0xe4, 0x6b, 0x6b, 0x3a, 0xf0, 0xb5, 0x6a, 0x3a, 0xf0, 0xc5, 0x13, 0x8b, 0x16, 0x3c, 0x98,
+  0x78, 0x26, 0x61, 0x4c, 0xb5, 0x9e, 0xb5, 0xcb, 0xca, 0xd3, 0xae, 0xaf, 0xbb, 0x4a, 0xd1, 0x9e,
+  0x4f, 0x57, 0xa3, 0x7a, 0x39, 0x04, 0xac, 0xd1, 0x7c, 0x9a, 0xcd, 0xff, 0x2d, 0x3e, 0x08, 0x57,
+  0x1a, 0xc9, 0x3d, 0x14, 0x5b, 0x1a, 0x4f, 0x07, 0xd9, 0x7c, 0x3a, 0x00, 0x88, 0x3a, 0x90, 0x2f,
+  0x18, 0x08, 0xbf, 0x3a, 0x77, 0xa7, 0x6e, 0x64, 0x1a, 0x89, 0x65, 0xae, 0x28, 0x6e, 0x00, 0xde,
+  0x39, 0x4a, 0x96, 0x83, 0x79, 0xd2, 0xe2, 0x10, 0xa6, 0x68, 0x25, 0xf0, 0xdb, 0x44, 0xa6, 0x61,
+  0x2c, 0xc2, 0x2f, 0x00, 0x17, 0xd2, 0xf4, 0x93, 0x33, 0x8f, 0xee, 0x74, 0xdb, 0xf3, 0x07, 0xf8,
+  0x26, 0xc5, 0xc2, 0x74, 0xe0, 0x60, 0xbc, 0x04, 0x82, 0xcd, 0xda, 0xde, 0x94, 0xbf, 0x82, 0xf7,
+  0xdb, 0xa5, 0x6e, 0xd6, 0x62, 0x28, 0x51, 0x4c, 0x17, 0x3c, 0x9e, 0x5f, 0x3f, 0x53, 0x01, 0x6f,
+  0x31, 0x2f, 0x81, 0x26, 0xd3, 0x81, 0xdb, 0xaa, 0xa9, 0x52, 0x0d, 0xa5, 0x76, 0x15, 0x5d, 0x83,
+  0x9d, 0x50, 0x71, 0x14, 0x06, 0xe5, 0xed, 0xf7, 0xfb, 0xce, 0x12, 0x85, 0x3d, 0xfc, 0xc3, 0x61,
+  0x7a, 0x26, 0xe4, 0x13, 0x74, 0x2b, 0xd2, 0x79, 0x78, 0xb8, 0xbb, 0xed, 0x56, 0xf8, 0xd9, 0x3a,
+  0x48, 0xcc, 0x26, 0x83, 0x4e, 0x86, 0x39, 0xe6, 0x18, 0x69, 0x2d, 0x58, 0x9b, 0x80, 0x7b, 0x43,
+  0xbe, 0x92, 0x31, 0x78, 0x66, 0xd6, 0x7e, 0x70, 0x95, 0x32, 0x52, 0x32, 0x21, 0x36, 0xb8, 0x21,
+  0x8b, 0xf0, 0x18, 0x84, 0x78, 0x9a, 0xd3, 0x38, 0xde, 0x6c, 0x15, 0xbc, 0x07, 0xf1, 0x81, 0x25,
+  0x3b, 0xc0, 0x26, 0xf3, 0xdb, 0x8e, 0xd5, 0xf6, 0xab, 0xc6, 0xae, 0x90, 0xba, 0xdc, 0x6e, 0x72,
+  0x5a, 0xc5, 0x51, 0x10, 0x58, 0x29, 0xc8, 0x87, 0x0e, 0x47, 0x3f, 0xdd, 0xb8, 0x4f, 0x62, 0x64,
+  0x61, 0xe4, 0x06, 0x67, 0xad, 0x45, 0x24, 0x1e, 0x6c, 0x4d, 0x6a, 0xef, 0x9a, 0xee, 0x60, 0x44,
+  0xdd, 0xda, 0xa6, 0x4e, 0xee, 0xa0, 0x2a, 0xa8, 0xa4, 0x1a, 0x51, 0x10, 0x8d, 0xda, 0x28, 0x99,
+  0x2e, 0x4b, 0x92, 0xdb, 0x09, 0x66, 0x84, 0x5d, 0x22, 0x53, 0x9d, 0x41, 0xe0, 0x20, 0x53, 0x37,
+  0x15, 0xdc, 0x81, 0x42, 0xd6, 0x6d, 0xb8, 0x3e, 0xc7, 0x58, 0xae, 0x22, 0x7c, 0x10, 0x2a, 0x81,
+  0x58, 0xe4, 0xe4, 0x5f, 0x5c, 0x69, 0x60, 0xd1, 0x08, 0x14, 0x79, 0x22, 0x4f, 0x73, 0x0c, 0xef,
+  0xe3, 0xf5, 0x0d, 0xb9, 0x66, 0x4c, 0x41, 0xa5, 0x6c, 0x84, 0x4a, 0x68, 0xe8, 0xb7, 0xf7, 0x51,
+  0xaa, 0x96, 0x70, 0xf5, 0x1b, 0x2b, 0x62, 0x1b, 0x73, 0xf2, 0x66, 0x25, 0x62, 0x46, 0x32, 0x25,
+  0x23, 0x01, 0xc1, 0xbc, 0x16, 0x71, 0x4c, 0x16, 0x1c, 0xa7, 0x20, 0x9b, 0x6e, 0x9c, 0x91, 0x67,
+  0x41, 0x49, 0x22, 0x17, 0xb8, 0x4b, 0xb3, 0xac, 0x9a, 0xb1, 0xdf, 0x32, 0x33, 0xf8, 0x0f, 0xa4,
+  0x8c, 0x8f, 0x66, 0xab, 0xaf, 0xfd, 0xd5, 0x20, 0x58, 0xf1, 0xf0, 0x8b, 0xf3, 0xa8, 0x0d, 0x02,
+  0xfc, 0x24, 0xee, 0xbb, 0xe2, 0xfe, 0xef, 0xcd, 0x7d, 0xb0, 0x87, 0xa1, 0xca, 0x38, 0x77, 0x22,
+  0xde, 0xef, 0x6e, 0x81, 0xb8, 0x95, 0x0a, 0x62, 0x45, 0x1b, 0x34, 0xe7, 0x92, 0x43, 0x81, 0xa3,
+  0xf1, 0x81, 0xd0, 0xd2, 0xa1, 0x12, 0x99, 0x99, 0xb7, 0xa2, 0x3c, 0x75, 0xb3, 0x4d, 0xad, 0xc6,
+  0x28, 0x6e, 0xd4, 0xa6, 0x4b, 0x5e, 0x5a, 0xf6, 0x85, 0xcc, 0x88, 0x7b, 0xfe, 0xf9, 0x27, 0x34,
+  0xc6, 0x16, 0x93, 0x61, 0x9e, 0x40, 0xf3, 0xeb, 0x2f, 0xb9, 0x79, 0x1f, 0x73, 0x7c, 0x7d, 0xb7,
+  0xb9, 0x63, 0x9d, 0xa0, 0x52, 0x76, 0x82, 0x6e, 0xdf, 0x6a, 0x86, 0xef, 0x7d, 0xc5, 0x13, 0x28,
+  0xe7, 0x9d, 0xc0, 0x95, 0xa0, 0xa0, 0x7b, 0xd5, 0x12, 0x11, 0xe9, 0x78, 0xe8, 0xd9, 0x8c, 0x0c,
+  0xbb, 0xe4, 0x5b, 0x98, 0x1a, 0x00, 0x05, 0x24, 0x93, 0xfa, 0xe7, 0xe3, 0xc7, 0x5f, 0x41, 0x9e,
+  0xa0, 0x52, 0x75, 0x82, 0xab, 0x56, 0xc4, 0x4d, 0xb8, 0xea, 0x04, 0x03, 0x54, 0x02, 0x28, 0xcd,
+  0x8a, 0xa7, 0x80, 0xaf, 0x33, 0x99, 0x6a, 0x4e, 0x66, 0x73, 0x52, 0xbc, 0xf7, 0xff, 0xab, 0x65,
+  0xda, 0xe9, 0x7a, 0x0a, 0x46, 0x61, 0x7c, 0x86, 0xdd, 0x17, 0x2b, 0x0f, 0x7e, 0x15, 0x4d, 0x48,
+  0xf7, 0x63, 0x9e, 0x2e, 0xcd, 0x8a, 0xcc, 0x61, 0xfe, 0x04, 0xad, 0x4f, 0xec, 0xa6, 0xf6, 0x3c,
+  0xbb, 0x45, 0xd7, 0x29, 0xed, 0x55, 0x3b, 0xeb, 0xf5, 0xab, 0x1d, 0x21, 0x6f, 0xde, 0x78, 0x1b,
+  0x4e, 0xc9, 0xb8, 0x0b, 0x03, 0x9f, 0x79, 0x14, 0x09, 0x97, 0xb9, 0xe9, 0x74, 0xba, 0x28, 0xc2,
+  0xbe, 0xf5, 0xc9, 0x8f, 0x64, 0xd4, 0x3d, 0x25, 0xe7, 0xc3, 0xe1, 0x10, 0x00, 0x5f, 0xc1, 0x9e,
+  0x14, 0x75, 0x74, 0x83, 0x83, 0x15, 0xfa, 0x2f, 0xdb, 0xec, 0xbd, 0x3d, 0x5b, 0x8a, 0x54, 0x92,
+  0x21, 0x3c, 0xfc, 0x6f, 0x63, 0x61, 0x57, 0xbd, 0x52, 0x33, 0xe0, 0x0a, 0x89, 0x05, 0x65, 0x77,
+  0x3b, 0xbb, 0xcf, 0xbe, 0xc7, 0x77, 0xce, 0x22, 0xbb, 0xc6, 0xf5, 0xbe, 0xb7, 0x98, 0x0e, 0xad,
+  0x2e, 0xef, 0x27, 0x59, 0xca, 0x08, 0x57, 0x0e, 0x98, 0x01, 0x40, 0x52, 0xb0, 0x4d, 0xae, 0x52,
+  0x94, 0x36, 0xe6, 0xc6, 0x5e, 0x96, 0x90, 0x12, 0x36, 0x4a, 0x70, 0x28, 0x89, 0xef, 0x29, 0x58,
+  0xca, 0x2f, 0x38, 0x5b, 0x59, 0xc2, 0x1f, 0x81, 0xb2, 0xa9, 0xb5, 0xe1, 0xc4, 0x51, 0xed, 0xb6,
+  0xb6, 0xc7, 0x78, 0xe5, 0x3b, 0x7f, 0x04, 0x01, 0xb8, 0xc2, 0x93, 0xf6, 0xb1, 0x25, 0xc1, 0x67,
+  0xf0, 0x47, 0x00, 0x99, 0x08, 0x5c, 0x6b, 0xb8, 0xf3, 0x26, 0x4a, 0xd2, 0xa9, 0xae, 0x2a, 0x58,
+  0xb6, 0xab, 0xec, 0x5d, 0xd2, 0x25, 0xd5, 0x1d, 0x9e, 0x86, 0x6a, 0x93, 0x59, 0xf3, 0xc3, 0xbe,
+  0x4b, 0xd3, 0x1a, 0x83, 0x62, 0x05, 0x7d, 0xd5, 0x6c, 0x30, 0xa4, 0xad, 0xf9, 0xb1, 0xae, 0x09,
+  0x4a, 0xd4, 0x3d, 0x16, 0x37, 0x48, 0x00, 0x31, 0xf3, 0x4c, 0xe3, 0x1c, 0xb2, 0x86, 0xe0, 0x67,
+  0x0d, 0xae, 0xd6, 0xdd, 0xca, 0x50, 0xb0, 0x8a, 0x1e, 0x89, 0x82, 0x2a, 0xea, 0x95, 0x3f, 0x53,
+  0xf4, 0xd3, 0x63, 0xe7, 0x0a, 0x9a, 0xed, 0x59, 0x8c, 0xa1, 0x93, 0x42, 0x0b, 0xbd, 0x92, 0x6b,
+  0x5f, 0x64, 0x83, 0x6d, 0x0b, 0x0d, 0x4e, 0x49, 0x70, 0x1f, 0x73, 0x0a, 0x69, 0xef, 0x2f, 0x55,
+  0x94, 0xd8, 0xf1, 0xcb, 0x9b, 0x19, 0xf7, 0x6d, 0x0a, 0x61, 0x4c, 0x6e, 0x63, 0xe9, 0x30, 0x98,
+  0x6f, 0xe1, 0x98, 0x2f, 0xa6, 0x0c, 0x47, 0x2c, 0x3a, 0xb0, 0x87, 0x2d, 0x08, 0x71, 0x8a, 0xea,
+  0xe3, 0xed, 0x03, 0x5b, 0x2f, 0x2d, 0xb8, 0x9a, 0xaf, 0x24, 0x0c, 0xad, 0xc1, 0xfd, 0x6f, 0x0f,
+  0x8f, 0xc1, 0x69, 0xcb, 0x8d, 0x96, 0x30, 0x3f, 0xbf, 0x58, 0x4c, 0xbc, 0xa1, 0xf7, 0x1e, 0x61,
+  0x10, 0x09, 0x80, 0x04, 0xba, 0x12, 0x44, 0x9e, 0x6d, 0xe3, 0x03, 0xb8, 0x06, 0xaf, 0xd7, 0x3d,
+  0x6c, 0xeb, 0xbd, 0x5c, 0x41, 0x9e, 0x84, 0x92, 0x71, 0x16, 0x90, 0xd7, 0x53, 0x7b, 0xf7, 0x06,
+  0x62, 0xd4, 0x7f, 0x86, 0x81, 0xe3, 0xf6, 0x3e, 0xff, 0x7e, 0x77, 0x23, 0x13, 0x28, 0x6e, 0x00,
+  0xe8, 0x3d, 0x0c, 0xe1, 0xf3, 0xa6, 0x30, 0xde, 0x21, 0xca, 0x62, 0xbf, 0x8b, 0x95, 0xe5, 0xef,
+  0x97, 0x4b, 0xdf, 0xfc, 0x8e, 0xfb, 0xc3, 0x9b, 0x10, 0x3a, 0xb1, 0x27, 0x8f, 0x72, 0x18, 0xd4,
+  0x4e, 0xc8, 0xdd, 0xfd, 0xc4, 0x66, 0x80, 0x45, 0x12, 0x19, 0x50, 0xfa, 0x7d, 0xb4, 0xe9, 0x5e,
+  0x85, 0xac, 0x73, 0xa8, 0x35, 0x37, 0x64, 0xe2, 0xc7, 0x1d, 0x6d, 0x67, 0xf3, 0x10, 0xf4, 0x84,
+  0xf2, 0xc0, 0x4f, 0x88, 0x6f, 0x96, 0xe8, 0x3e, 0x91, 0xc2, 0xdd, 0x04, 0x08, 0xc0, 0x4b, 0x4c,
+  0x7b, 0x0f, 0x1e, 0x63, 0xb8, 0xd3, 0x78, 0x4f, 0xf1, 0xd6, 0xec, 0x6a, 0xf1, 0x29, 0x5e, 0xa2,
+  0xec, 0x1b, 0xe1, 0x31, 0x58, 0xec, 0x3b, 0x94, 0xc7, 0xf4, 0x89, 0x60, 0xe0, 0xe6, 0xac, 0xa2,
+  0x73, 0x02, 0xac, 0xe9, 0x92, 0x57, 0x43, 0xf2, 0xb5, 0xb1, 0xd2, 0x7f, 0x17, 0xbc, 0xc3, 0xa8,
+  0x81, 0xd5, 0xab, 0x7a, 0x2c, 0x29, 0x73, 0xda, 0xe0, 0xdc, 0x68, 0x33, 0xb8, 0xec, 0x9b, 0x0e,
+  0xf0, 0x6f, 0x84, 0xc2, 0xc1, 0xf4, 0x2d, 0x26, 0x4c, 0x04, 0x85, 0x89, 0xde, 0xc7, 0x3c, 0x26,
+  0x3c, 0xaa, 0xee, 0x76, 0x9f, 0xb0, 0xc0, 0x1c, 0x44, 0xd8, 0x19, 0x2d, 0x9b, 0x81, 0x0a, 0xa2,
+  0xa7, 0x67, 0x47, 0x75, 0x04, 0x6f, 0x3b, 0x5f, 0x36, 0x43, 0xc1, 0xfe, 0x13, 0x75, 0x04, 0x7b,
+  0xb6, 0xab, 0xcd, 0x74, 0xff, 0x17, 0xc3, 0x61, 0xfb, 0x72, 0xa7, 0x1f, 0x41, 0x14, 0x6c, 0x62,
+  0x3e, 0x84, 0x1d, 0x97, 0xc9, 0x74, 0xa1, 0xb0, 0xda, 0x57, 0x48, 0xb0, 0x0b, 0x60, 0x2d, 0x73,
+  0x11, 0xe4, 0x12, 0x10, 0xa3, 0xe1, 0x29, 0x2c, 0x13, 0xec, 0x97, 0x4a, 0xb6, 0x05, 0x04, 0x08,
+  0x6f, 0x85, 0x2e, 0x77, 0x03, 0x5b, 0x1a, 0x9a, 0x71, 0x3f, 0x28, 0xce, 0xc9, 0x47, 0x98, 0xd3,
+  0xd4, 0xa6, 0x12, 0xa0, 0x11, 0xac, 0x3e, 0x25, 0x76, 0xd5, 0x36, 0xad, 0xc5, 0xc6, 0x70, 0xdd,
+  0x0c, 0xf0, 0x19, 0x5a, 0x57, 0xc2, 0x2b, 0x67, 0x73, 0xbb, 0x60, 0x8f, 0xf9, 0x9c, 0xc3, 0x43,
+  0x47, 0x52, 0x78, 0x0b, 0x58, 0x29, 0xad, 0xdf, 0xca, 0x86, 0xbd, 0x3a, 0xe0, 0x66, 0x1c, 0xeb,
+  0x2e, 0x4c, 0x7a, 0x5d, 0x6e, 0x1c, 0xca, 0x8a, 0x9d, 0x34, 0xf7, 0xd5, 0xcd, 0x5e, 0x1f, 0x54,
+  0xd2, 0x09, 0xae, 0xe1, 0xfe, 0xb3, 0x91, 0x39, 0x94, 0x2e, 0xff, 0xb2, 0xa6, 0xa9, 0xbd, 0xd0,
+  0xf9, 0x73, 0x04, 0xdc, 0x4a, 0x5c, 0x34, 0xff, 0x12, 0x74, 0xbb, 0xdf, 0x12, 0xaf, 0x52, 0x8f,
+  0xdc, 0xa1, 0x03, 0xad, 0xc4, 0xa3, 0x63, 0x2b, 0x21, 0xf5, 0x56, 0x42, 0x9c, 0xfc, 0xd5, 0x2e,
+  0xbf, 0x65, 0xc8, 0x5d, 0xbc, 0xdf, 0xb1, 0x53, 0x52, 0x16, 0x17, 0xbc, 0xee, 0x6e, 0xbb, 0xb5,
+  0xa7, 0x38, 0xd2, 0x78, 0x4b, 0x0c, 0xe0, 0xe3, 0xdf, 0xeb, 0x63, 0x59, 0xc3, 0x65, 0x0c, 0xbd,
+  0x6e, 0xaf, 0xe1, 0xe0, 0xee, 0xb6, 0x1d, 0x83, 0x3c, 0xfb, 0xda, 0x2c, 0xf3, 0xda, 0x5a, 0x8b,
+  0x94, 0xc9, 0x75, 0x5f, 0xa6, 0x58, 0x8b, 0x00, 0xab, 0xd0, 0xc1, 0xda, 0x7d, 0xb7, 0x3e, 0xd5,
+  0x6a, 0x72, 0x75, 0x40, 0x76, 0xa5, 0x18, 0xcd, 0x70, 0x85, 0x3f, 0xf7, 0xf8, 0x9b, 0x0c, 0xdc,
+  0x84, 0xdc, 0x0f, 0x3d, 0x03, 0xf7, 0xdb, 0xf9, 0xff, 0x00, 0x38, 0xa8, 0x13, 0xbd, 0x53, 0x17,
+  0x00, 0x00,
+};
+
+static const WebAsset WEB_ASSETS[] = {
+  {"ota.html", "text/html", WEB_OTA_HTML_GZ, sizeof(WEB_OTA_HTML_GZ), "\"ef8c99bfe7fca0e0\""},
+  {"portal.html", "text/html", WEB_PORTAL_HTML_GZ, sizeof(WEB_PORTAL_HTML_GZ), "\"e892ab9dac975881\""},
+};
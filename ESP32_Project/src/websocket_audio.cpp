@@ -1,80 +1,8 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <vector>
 
 // هذا السطر المهم:
 void playAudioResponse(const uint8_t* audioData, size_t length);
-// دوال base64 encode/decode اليدوية
-String base64_encode(const uint8_t* data, size_t length) {
-    const char* base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    String result = "";
-    int i = 0, j = 0;
-    uint8_t char_array_3[3];
-    uint8_t char_array_4[4];
-
-    while (length--) {
-        char_array_3[i++] = *(data++);
-        if (i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-            for (i = 0; i < 4; i++)
-                result += base64_chars[char_array_4[i]];
-            i = 0;
-        }
-    }
-    if (i) {
-        for (j = i; j < 3; j++)
-            char_array_3[j] = '\0';
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-        char_array_4[3] = char_array_3[2] & 0x3f;
-        for (j = 0; j < i + 1; j++)
-            result += base64_chars[char_array_4[j]];
-        while ((i++ < 3))
-            result += '=';
-    }
-    return result;
-}
-
-std::vector<uint8_t> base64_decode(const String& encoded_string) {
-    const char* base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    int in_len = encoded_string.length();
-    int i = 0;
-    int in_ = 0;
-    uint8_t char_array_4[4], char_array_3[3];
-    std::vector<uint8_t> ret;
-    auto is_base64 = [](unsigned char c) {
-        return (isalnum(c) || (c == '+') || (c == '/'));
-    };
-    while (in_len-- && (encoded_string[in_] != '=') && is_base64(encoded_string[in_])) {
-        char_array_4[i++] = encoded_string[in_]; in_++;
-        if (i == 4) {
-            for (i = 0; i < 4; i++)
-                char_array_4[i] = strchr(base64_chars, char_array_4[i]) - base64_chars;
-            char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-            char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-            char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-            for (i = 0; i < 3; i++)
-                ret.push_back(char_array_3[i]);
-            i = 0;
-        }
-    }
-    if (i) {
-        for (int j = i; j < 4; j++)
-            char_array_4[j] = 0;
-        for (int j = 0; j < 4; j++)
-            char_array_4[j] = strchr(base64_chars, char_array_4[j]) - base64_chars;
-        char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-        char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-        char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-        for (int j = 0; j < i - 1; j++)
-            ret.push_back(char_array_3[j]);
-    }
-    return ret;
-}
 
 // Functions sendAudioData and handleAudioResponse are now implemented in websocket_handler.cpp
 
@@ -2,7 +2,7 @@
 #include "hardware.h"
 #include "sensors.h"
 #include "audio_handler.h"
-#include "encoding_service.h"  // Professional encoding service
+#include "encoding_service.h"  // Base64 codec
 #include "security.h"  // Security and JWT integration
 #include "jwt_manager.h"  // JWT Manager integration
 #include "time_sync.h"  // Time validation for TLS
@@ -10,25 +10,39 @@
 #include "comprehensive_logging.h"  // Comprehensive logging system
 #include <WiFi.h>
 #include <vector>
-#include <base64.h>  // Base64 encoding library
 #include <mbedtls/md.h>  // For HMAC-SHA256
 #include <mbedtls/sha256.h>
 #include <esp_task_wdt.h>  // For watchdog reset
 #include "config.h"  // For ESP32_SHARED_SECRET
 #include "config_manager.h"  // For ConfigManager/TeddyConfig
 #include "security/tls_roots.h"  // Root CAs for TLS validation
+#include "metrics_registry.h"  // Latency histograms and traffic counters
+#include "utterance_trace.h"  // Correlation id and latency spans
+#include "sampling_profiler.h"  // Remote CPU profiling
+#include "resource_manager.h"  // Pooled per-chunk buffers
+#include "json_arena.h"  // Per-task arenas for message documents
+#include "fixed_string.h"  // Allocation-free strings for the message path
+#include "event_bus.h"  // Audio chunks and auth refresh requests from other tasks
+#include "alloc_guard.h"  // Steady-state allocation checks (debug builds)
+#include "metrics_history.h"  // On-device health time series
+#include "anomaly_detector.h"  // Baseline-relative latency and health alarms
+#include "audio_tap.h"  // Debug PCM taps
+#include "monitoring.h"  // audio.latency histogram
 
 WebSocketsClient webSocket;
 bool isConnected = false;
 static volatile bool wsConnecting = false;
 static String g_audio_session_id;
-static volatile bool g_mark_final_next = false;
+static EventSubscriberId wsEvents = EVENT_SUBSCRIBER_INVALID;
 
 // Telemetry counters for audio TX
 static unsigned long txStartMs = 0;
 static unsigned long txLastReportMs = 0;
 static uint32_t txChunks = 0;
 static uint32_t txBytes = 0;
+// audio_end → first response byte, recorded once per utterance
+static unsigned long audioEndSentMs = 0;
+static bool awaitingFirstResponse = false;
 // Production connection resilience and health monitoring
 struct ConnectionHealth {
   unsigned long lastPingTime = 0;
@@ -57,6 +71,15 @@ struct ConnectionHealth {
 
 static ConnectionHealth connectionHealth;
 
+// Registry handles (registered once in initWebSocket)
+static MetricId metricRttHist = METRIC_INVALID;
+static MetricId metricSendHist = METRIC_INVALID;
+static MetricId metricHmacHist = METRIC_INVALID;
+static MetricId metricPacketsSent = METRIC_INVALID;
+static MetricId metricPacketsLost = METRIC_INVALID;
+static MetricId metricBytesSent = METRIC_INVALID;
+static MetricId metricMessagesReceived = METRIC_INVALID;
+
 // Lightweight audio statistics for logging (PCM s16le)
 inline void computeAudioStats(const uint8_t* pcm, size_t bytes, float& rms_dbfs, int16_t& peak_abs) {
   peak_abs = 0;
@@ -77,6 +100,15 @@ inline void computeAudioStats(const uint8_t* pcm, size_t bytes, float& rms_dbfs,
 
 void initWebSocket() {
   Serial.println("[WS] Initializing WebSocket with JWT authentication...");
+
+  metricRttHist = registerHistogram("ws.rtt", "ms");
+  metricSendHist = registerHistogram("ws.audio_send", "us");
+  metricHmacHist = registerHistogram("crypto.audio_hmac", "us");
+  metricPacketsSent = registerCounter("ws.packets_sent");
+  metricPacketsLost = registerCounter("ws.packets_lost");
+  metricBytesSent = registerCounter("ws.audio_bytes_sent", "bytes");
+  metricMessagesReceived = registerCounter("ws.messages_received");
+  initWebSocketEvents();
   
   // Ensure device is authenticated first (production only)
 #ifdef PRODUCTION_BUILD
@@ -223,12 +255,7 @@ void initWebSocket() {
   // Note: Server validates 'token' HMAC from query when 'device_id' is present.
   // Avoid adding Authorization header that could be misinterpreted as the token.
   
-  // Set JWT refresh callback if JWT Manager is available
-  if (jwtManager) {
-    jwtManager->setRefreshCallback([](const String& refreshMessage) -> bool {
-      return handleJWTRefreshMessage(refreshMessage);
-    });
-  }
+  // JWT refresh requests arrive as EVENT_AUTH_REFRESH_REQUEST (initWebSocketEvents)
 }
 
 static void attemptWebSocketConnect() {
@@ -264,6 +291,7 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
     case WStype_DISCONNECTED:
       Serial.println("❌ WebSocket Disconnected");
       onWebSocketDisconnected();
+      awaitingFirstResponse = false;  // A reply on the next connection is not this utterance's
       // Free audio resources on disconnect to relieve memory pressure
       cleanupAudio();
       break;
@@ -279,16 +307,15 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
       Serial.printf("📨 Received JSON: %s\n", payload);
       onWebSocketMessageReceived();
       {
-        String raw = String((char*)payload);
-        String trimmed = raw; trimmed.trim();
+        StringView trimmed = StringView((const char*)payload, length).trim();
         if (trimmed.equalsIgnoreCase("dev-ok") || trimmed.equalsIgnoreCase("ok")) {
           Serial.println("🔧 Non-JSON ack received; treating as auth/ok for dev mode");
-          DynamicJsonDocument ack(64);
+          StaticJsonDocument<64> ack;
           ack["type"] = "auth/ok";
           handleAuthenticationResponse(ack, true);
           break;
         }
-        handleIncomingMessage(raw);
+        handleIncomingMessage((const char*)payload, length);
       }
       break;
       
@@ -304,6 +331,7 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
       connectionHealth.rtt = connectionHealth.lastPongTime - connectionHealth.lastPingTime;
       connectionHealth.awaitingPong = false;
       connectionHealth.missedPongs = 0; // Reset missed pong counter
+      metricObserve(metricRttHist, (uint32_t)connectionHealth.rtt);
       
       Serial.printf("💗 Pong received - RTT: %lu ms\n", connectionHealth.rtt);
       
@@ -325,100 +353,193 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
   }
 }
 
-void handleIncomingMessage(String message) {
-  logWebSocketMessage("RECEIVE", "message", message.length());
-  DynamicJsonDocument doc(2048);  // Increased size for new server protocol
-  DeserializationError error = deserializeJson(doc, message);
-  
-  if (error) {
-    Serial.printf("❌ JSON Parse Error: %s\n", error.c_str());
-    return;
+// Server message types; SERVER_MESSAGE_TYPES lists their names in enum order
+enum ServerMessageType {
+  MSG_WELCOME,
+  MSG_POLICY,
+  MSG_ALERT,
+  MSG_AUTH_OK,
+  MSG_AUTH_ERROR,
+  MSG_SYSTEM,
+  MSG_STREAM_START,
+  MSG_STREAM_STOP,
+  MSG_AUDIO_RESPONSE,
+  MSG_LED_CONTROL,
+  MSG_ANIMATION,
+  MSG_STATUS_CHECK,
+  MSG_ERROR,
+  MSG_PROFILER,
+  MSG_TEXT_RESPONSE,
+  MSG_HISTORY,
+  MSG_TYPE_COUNT
+};
+
+static const char* const SERVER_MESSAGE_TYPES[MSG_TYPE_COUNT] = {
+  "welcome", "policy", "alert", "auth/ok", "auth/error", "system",
+  "stream_start", "stream_stop", "audio_response", "led_control",
+  "animation", "status_check", "error", "profiler", "text_response",
+  "history"
+};
+
+static int lookupServerMessageType(const char* type) {
+  for (int i = 0; i < MSG_TYPE_COUNT; i++) {
+    if (strcmp(type, SERVER_MESSAGE_TYPES[i]) == 0) return i;
   }
+  return -1;
+}
+
+static void sendStreamAck(const char* status) {
+  ArenaJsonDocument ack(128);
+  ack["type"] = "stream_ack";
+  ack["status"] = status;
+  char msg[64];
+  size_t len = serializeJson(ack, msg, sizeof(msg));
+  webSocket.sendTXT(msg, len);
+}
+
+static void dispatchServerMessage(JsonDocument& doc);
+
+void handleIncomingMessage(const char* message, size_t length) {
+  logWebSocketMessage("RECEIVE", "message", length);
+  JsonArenaScope arena;  // Documents below come from this task's arena, reset on return
   
-  String type = doc["type"] | "";
-  Serial.printf("🎯 Server Message Type: %s\n", type.c_str());
-  
-  // Handle NEW server protocol message types:
-  if (type == "welcome") {
-    handleWelcomeMessage(doc);
-  }
-  else if (type == "policy") {
-    handlePolicyUpdate(doc);
-  }
-  else if (type == "alert") {
-    handleSecurityAlert(doc);
-  }
-  else if (type == "auth/ok") {
-    handleAuthenticationResponse(doc, true);
-  }
-  else if (type == "auth/error") {
-    handleAuthenticationResponse(doc, false);
+  DeserializationError error;
+  {
+    // Capacity follows the document/message size ratio seen so far
+    ArenaJsonDocument doc(estimateJsonCapacity(length));
+    error = deserializeJson(doc, message, length);
+    if (!error) {
+      recordJsonUsage(length, doc.memoryUsage());
+      dispatchServerMessage(doc);
+      return;
+    }
+    if (error == DeserializationError::NoMemory) {
+      // Estimate was short: learn from the miss and parse once more
+      Serial.printf("⚠️ JSON capacity %u too small for %u-byte message, retrying\n",
+                    (unsigned)doc.capacity(), (unsigned)length);
+      recordJsonUsage(length, doc.capacity() * 2);
+    }
+  }  // The short pool is the arena's top block: popped here, not at scope end
+  
+  if (error == DeserializationError::NoMemory) {
+    ArenaJsonDocument retry(estimateJsonCapacity(length));
+    error = deserializeJson(retry, message, length);
+    if (!error) {
+      recordJsonUsage(length, retry.memoryUsage());
+      dispatchServerMessage(retry);
+      return;
+    }
   }
-  else if (type == "system") {
-    // Handle system messages (e.g., audio ACKs from server)
-    JsonVariant data = doc["data"];
-    if (!data.isNull()) {
-      String sysType = data["type"] | "";
-      if (sysType == "audio_ack") {
-        String chunkId = data["chunk_id"] | "";
-        int bytes = data["bytes"] | 0;
-        bool finalChunk = data["final"] | false;
-        Serial.printf("[WS] Audio ACK: chunk=%s bytes=%d final=%s\n",
-                      chunkId.c_str(), bytes, finalChunk ? "true" : "false");
-      } else if (sysType == "audio_start_ack") {
-        g_audio_session_id = (const char*)(data["audio_session_id"] | "");
-        Serial.printf("[WS] Audio session started: %s\n", g_audio_session_id.c_str());
+  Serial.printf("❌ JSON Parse Error: %s\n", error.c_str());
+}
+
+static void dispatchServerMessage(JsonDocument& doc) {
+  const char* type = doc["type"] | "";
+  Serial.printf("🎯 Server Message Type: %s\n", type);
+  
+  switch (lookupServerMessageType(type)) {
+    // NEW server protocol message types
+    case MSG_WELCOME:
+      handleWelcomeMessage(doc);
+      break;
+    case MSG_POLICY:
+      handlePolicyUpdate(doc);
+      break;
+    case MSG_ALERT:
+      handleSecurityAlert(doc);
+      break;
+    case MSG_AUTH_OK:
+      handleAuthenticationResponse(doc, true);
+      break;
+    case MSG_AUTH_ERROR:
+      handleAuthenticationResponse(doc, false);
+      break;
+    case MSG_SYSTEM: {
+      // Handle system messages (e.g., audio ACKs from server)
+      JsonVariant data = doc["data"];
+      if (!data.isNull()) {
+        StringView sysType = data["type"] | "";
+        if (sysType == "audio_ack") {
+          const char* chunkId = data["chunk_id"] | "";
+          int bytes = data["bytes"] | 0;
+          bool finalChunk = data["final"] | false;
+          Serial.printf("[WS] Audio ACK: chunk=%s bytes=%d final=%s\n",
+                        chunkId, bytes, finalChunk ? "true" : "false");
+        } else if (sysType == "audio_start_ack") {
+          g_audio_session_id = (const char*)(data["audio_session_id"] | "");
+          Serial.printf("[WS] Audio session started: %s\n", g_audio_session_id.c_str());
+        }
       }
+      break;
     }
-  }
-  else if (type == "stream_start") {
-    // Start real-time audio streaming without needing a hardware button
-    if (getAudioState() != AUDIO_STREAMING && isConnected) {
-      startRealTimeStreaming();
-      DynamicJsonDocument ack(128);
-      ack["type"] = "stream_ack";
-      ack["status"] = "started";
-      String msg; serializeJson(ack, msg);
-      webSocket.sendTXT(msg);
+    case MSG_STREAM_START:
+      // Start real-time audio streaming without needing a hardware button
+      if (getAudioState() != AUDIO_STREAMING && isConnected) {
+        startRealTimeStreaming();
+        sendStreamAck("started");
+      }
+      break;
+    case MSG_STREAM_STOP:
+      if (getAudioState() == AUDIO_STREAMING) {
+        stopRealTimeStreaming();
+        sendStreamAck("stopped");
+      }
+      break;
+    // Legacy message types for backward compatibility
+    case MSG_AUDIO_RESPONSE:
+      handleAudioResponse(doc["params"]);
+      break;
+    case MSG_LED_CONTROL:
+      handleLEDCommand(doc["params"]);
+      break;
+    case MSG_ANIMATION:
+      handleAnimationCommand(doc["params"]);
+      break;
+    case MSG_STATUS_CHECK:
+      handleStatusRequest();
+      break;
+    case MSG_ERROR: {
+      const char* errorCode = doc["error_code"] | "";
+      const char* errorMessage = doc["error_message"] | "";
+      Serial.printf("❌ Server Error [%s]: %s\n", errorCode, errorMessage);
+      setLEDColor("red", 100);
+      delay(1000);
+      clearLEDs();
+      break;
     }
-  }
-  else if (type == "stream_stop") {
-    if (getAudioState() == AUDIO_STREAMING) {
-      stopRealTimeStreaming();
-      DynamicJsonDocument ack(128);
-      ack["type"] = "stream_ack";
-      ack["status"] = "stopped";
-      String msg; serializeJson(ack, msg);
-      webSocket.sendTXT(msg);
+    case MSG_PROFILER: {
+      // Remote CPU profiling: start (optionally timed), stop, or upload samples
+      StringView action = doc["action"] | "";
+      if (action == "start") {
+        startProfiler(doc["hz"] | PROFILER_DEFAULT_HZ, doc["duration_ms"] | 0);
+      } else if (action == "stop") {
+        stopProfiler();
+      } else if (action == "upload") {
+        stopProfiler();
+        sendProfileReport();
+      } else if (action == "release") {
+        releaseProfile();
+      }
+      break;
     }
-  }
-  // Legacy message types for backward compatibility
-  else if (type == "audio_response") {
-    handleAudioResponse(doc["params"]);
-  }
-  else if (type == "led_control") {
-    handleLEDCommand(doc["params"]);
-  }
-  else if (type == "animation") {
-    handleAnimationCommand(doc["params"]);
-  }
-  else if (type == "status_check") {
-    handleStatusRequest();
-  }
-  else if (type == "error") {
-    String errorCode = doc["error_code"] | "";
-    String errorMessage = doc["error_message"] | "";
-    Serial.printf("❌ Server Error [%s]: %s\n", errorCode.c_str(), errorMessage.c_str());
-    setLEDColor("red", 100);
-    delay(1000);
-    clearLEDs();
-  }
-  else if (type == "text_response") {
-    String txt = doc["text"] | "";
-    Serial.printf("[WS] Text response: %s\n", txt.c_str());
-  }
-  else {
-    Serial.printf("⚠️ Unknown message type: %s\n", type.c_str());
+    case MSG_TEXT_RESPONSE:
+      Serial.printf("[WS] Text response: %s\n", (const char*)(doc["text"] | ""));
+      break;
+    case MSG_HISTORY: {
+      // On-device metrics history: resolution second|minute|hour, one series or all
+      int res = findHistoryResolution(doc["resolution"] | "minute");
+      const char* series = doc["series"] | (const char*)nullptr;
+      int seriesIndex = series ? findHistorySeries(series) : -1;
+      if (res < 0 || (series && seriesIndex < 0)) {
+        Serial.println("⚠️ History request for unknown resolution or series");
+        break;
+      }
+      sendMetricsHistory((HistoryResolution)res, seriesIndex);
+      break;
+    }
+    default:
+      Serial.printf("⚠️ Unknown message type: %s\n", type);
+      break;
   }
 }
 
@@ -584,6 +705,7 @@ void handleStatusRequest() {
 // Connection event handlers
 void onWebSocketConnected() {
   isConnected = true;
+  publishEvent(EVENT_WS_CONNECTED);
   connectionHealth.connectionStartTime = millis();
   connectionHealth.reconnectAttempts = 0;
   connectionHealth.reconnectDelay = 1000; // Reset to initial delay
@@ -604,6 +726,7 @@ void onWebSocketConnected() {
 
 void onWebSocketDisconnected() {
   isConnected = false;
+  publishEvent(EVENT_WS_DISCONNECTED);
   connectionHealth.totalDisconnections++;
   connectionHealth.connectionStable = false;
   connectionHealth.connectionScore = max(connectionHealth.connectionScore - 10.0f, 0.0f);
@@ -633,6 +756,7 @@ void onWebSocketError() {
 }
 
 void onWebSocketMessageReceived() {
+  metricIncrement(metricMessagesReceived);
   // Update connection health on successful message receipt
   connectionHealth.connectionScore = min(connectionHealth.connectionScore + 1.0f, 100.0f);
 }
@@ -700,49 +824,68 @@ String createMessage(String type, JsonObject data) {
   return message;
 }
 
+// Called for every audio response; only the first after audio_end is a latency sample
+static void noteFirstAudioResponse() {
+  if (!awaitingFirstResponse) return;
+  awaitingFirstResponse = false;
+  recordAudioLatency((uint32_t)(millis() - audioEndSentMs));
+}
+
 void handleAudioResponseWebSocket(JsonObject params) {
-  String audioDataB64 = params["audio_data"] | "";
-  String text = params["text"] | "";
-  String format = params["format"] | "pcm_s16le";
+  // Read in place from the message document; only the decoded PCM is copied
+  const char* audioDataB64 = params["audio_data"] | "";
+  const char* text = params["text"] | "";
+  const char* format = params["format"] | "pcm_s16le";
   int audioRate = params["audio_rate"] | 22050;
+  size_t audioDataB64Length = strlen(audioDataB64);
   
-  logWebSocketMessage("RECEIVE", "audio_response", audioDataB64.length());
+  logWebSocketMessage("RECEIVE", "audio_response", audioDataB64Length);
+  traceInstant(TRACE_SPAN_RESPONSE);
+  noteFirstAudioResponse();
   updateAudioFlowState(AUDIO_FLOW_RECEIVING);
-  logAudioEvent("Audio response received", "Text: " + text);
+  FixedString<96, FS_ELLIPSIS> textDetails("Text: ");
+  textDetails += text;
+  logAudioEvent("Audio response received", textDetails);
   
-  if (audioDataB64.length() > 0) {
+  if (audioDataB64Length > 0) {
     // Only PCM s16le is supported on-device without heavy decoders
-    String fmtLower = format; fmtLower.toLowerCase();
-    bool pcmOk = (fmtLower.indexOf("pcm") != -1) || (fmtLower.indexOf("s16") != -1);
+    StringView fmt(format);
+    bool pcmOk = fmt.containsIgnoreCase("pcm") || fmt.containsIgnoreCase("s16");
     if (!pcmOk) {
-      Serial.printf("❌ Unsupported audio format from server: %s (expected pcm_s16le)\n", format.c_str());
+      Serial.printf("❌ Unsupported audio format from server: %s (expected pcm_s16le)\n", format);
       return;
     }
-    Serial.printf("🔊 Received audio response: %s\n", text.c_str());
-    Serial.printf("📊 Format: %s, Rate: %d Hz\n", format.c_str(), audioRate);
+    Serial.printf("🔊 Received audio response: %s\n", text);
+    Serial.printf("📊 Format: %s, Rate: %d Hz\n", format, audioRate);
     
-    // Decode base64 audio
-    std::vector<uint8_t> audioData;
-    if (audioDataB64.length() > 0) {
-      // احسب حجم الـ buffer المطلوب أولاً
-      unsigned int requiredSize = calculateBase64EncodedSize(audioDataB64.length());
-      unsigned char* audioBuffer = new unsigned char[requiredSize];
-      unsigned int audioLen = decodeBase64(audioDataB64.c_str(), audioBuffer, requiredSize);
-      audioData.assign(audioBuffer, audioBuffer + audioLen);
-      delete[] audioBuffer;
+    // Decode base64 audio straight into a pooled frame
+    AudioFrame audioData;
+    {
+      TraceScope decodeSpan(TRACE_SPAN_DECODE);
+      audioData = AudioFrame::allocate(base64DecodedLength(audioDataB64Length));
+      uint8_t* pcm = audioData.mutableData();
+      size_t audioLen = 0;   // Stays 0 when the payload is not valid base64
+      if (pcm) base64Decode(audioDataB64, audioDataB64Length, pcm, audioData.capacity(), &audioLen);
+      audioData.setLength(audioLen);
+      noteAudioCopy(audioLen);
     }
     
-    if (audioData.size() > 0) {
-      logAudioData("Received", audioData.size(), format);
+    if (audioData.length() > 0) {
+      logAudioData("Received", audioData.length(), format);
       updateAudioFlowState(AUDIO_FLOW_PLAYING);
-      logAudioEvent("Starting audio playback", "Size: " + String(audioData.size()) + " bytes, Format: " + format);
+      FixedString<96> playbackDetails;
+      playbackDetails.appendf("Size: %u bytes, Format: %s", (unsigned)audioData.length(), format);
+      logAudioEvent("Starting audio playback", playbackDetails);
       
       // Show speaking animation
       setLEDColor("green", 80);
       logLEDAnimation("speaking", "green", 2500);
       
       // Play the audio (implement actual audio playback here)
-      playAudioResponse(audioData.data(), audioData.size());
+      {
+        TraceScope playbackSpan(TRACE_SPAN_PLAYBACK);
+        playAudioResponse(audioData.mutableData(), audioData.length());
+      }
       
       // Show completion
       playHappyAnimation();
@@ -756,6 +899,9 @@ void handleAudioResponseWebSocket(JsonObject params) {
   } else {
     Serial.println("❌ No audio data received");
   }
+  
+  // Response handled: close the utterance trace
+  endUtteranceTrace();
 }
 
 // Network performance monitoring
@@ -763,13 +909,38 @@ __attribute__((unused)) static unsigned long lastChunkTime = 0;
 static size_t adaptiveChunkSize = 4096; // Start with 4KB chunks
 static int consecutiveTimeouts = 0;
 
+#if FEATURE_PERFORMANCE_COMMANDS
+static ForcedNetworkConditions forcedNetwork = {0, 0, 0};
+
+void setForcedNetworkConditions(const ForcedNetworkConditions& conditions) {
+  forcedNetwork = conditions;
+  forcedNetwork.lossPercent = min(forcedNetwork.lossPercent, (uint8_t)100);
+  forcedNetwork.delayMs = min(forcedNetwork.delayMs, (uint16_t)WS_FORCED_DELAY_MAX_MS);
+}
+
+ForcedNetworkConditions getForcedNetworkConditions() {
+  return forcedNetwork;
+}
+
+// RSSI as seen by the adaptation logic
+static int effectiveRSSI() {
+  return forcedNetwork.rssi != 0 ? forcedNetwork.rssi : WiFi.RSSI();
+}
+#else
+static inline int effectiveRSSI() {
+  return WiFi.RSSI();
+}
+#endif
+
 // Calculate HMAC-SHA256 for audio frame authentication
-String calculateAudioHMACWebSocket(uint8_t* audioData, size_t length, const String& chunkId, const String& sessionId) {
+FixedString<65> calculateAudioHMACWebSocket(const uint8_t* audioData, size_t length, StringView chunkId, StringView sessionId) {
+  MetricTimer hmacTimer(metricHmacHist);
+  
   // Get device secret key for HMAC
   const char* deviceSecret = ESP32_SHARED_SECRET;
   if (!deviceSecret || strlen(deviceSecret) < 32) {
     Serial.println("❌ No device secret for audio HMAC");
-    return "";
+    return FixedString<65>();
   }
   
   // Use secret as raw bytes (no HEX decoding)
@@ -788,8 +959,8 @@ String calculateAudioHMACWebSocket(uint8_t* audioData, size_t length, const Stri
   
   // Update with audio data + metadata
   mbedtls_md_hmac_update(&ctx, audioData, length);
-  mbedtls_md_hmac_update(&ctx, (const uint8_t*)chunkId.c_str(), chunkId.length());
-  mbedtls_md_hmac_update(&ctx, (const uint8_t*)sessionId.c_str(), sessionId.length());
+  mbedtls_md_hmac_update(&ctx, (const uint8_t*)chunkId.data(), chunkId.length());
+  mbedtls_md_hmac_update(&ctx, (const uint8_t*)sessionId.data(), sessionId.length());
   
   // Finish HMAC
   uint8_t hmacResult[32];
@@ -797,16 +968,172 @@ String calculateAudioHMACWebSocket(uint8_t* audioData, size_t length, const Stri
   mbedtls_md_free(&ctx);
   
   // Convert to hex string
-  char hexHmac[65];
-  for (int i = 0; i < 32; i++) {
-    sprintf(&hexHmac[i*2], "%02x", hmacResult[i]);
+  FixedString<65> hexHmac;
+  hexHmac.appendHex(hmacResult, sizeof(hmacResult));
+  return hexHmac;
+}
+
+// =============================================================================
+// BUS EVENTS
+// =============================================================================
+
+// Runs on the loop task: capture publishes chunks from core 0, and the
+// session id, final flag and socket are only touched here
+static void onAudioChunkEvent(const Event& event) {
+  AllocGuardScope guard("ws_audio");
+  AudioFrame chunk = eventFrame(event);
+  sendAudioDataWebSocket(chunk.data(), chunk.length(), event.flags & EVENT_FLAG_FINAL);
+}
+
+static void onAuthRefreshEvent(const Event& event) {
+  FixedString<96> message;
+  message.appendf("{\"type\":\"auth/refresh\",\"proof\":\"%s\"}", event.text);
+  if (!handleJWTRefreshMessage(message.c_str())) {
+    // Lets the refresh task retry now instead of waiting out the response timeout
+    JWTManager::getInstance()->noteRefreshSendFailed();
   }
-  hexHmac[64] = '\0';
-  
-  return String(hexHmac);
 }
 
-void sendAudioDataWebSocket(uint8_t* audioData, size_t length) {
+// Capture chunk size before the first link downshift, and the size it left
+// behind; 0 while no downshift is in effect
+static size_t linkChunkBefore = 0;
+static size_t linkChunkApplied = 0;
+
+// Halves the frames the capture task hands to the socket, so each send is
+// shorter and a stalled link holds less audio
+static void downshiftCaptureChunk() {
+  size_t current = getCaptureChunkSize();
+  size_t reduced = max(current / 2, (size_t)WS_LINK_DOWNSHIFT_MIN_CHUNK);
+  if (reduced >= current) return;
+
+  if (linkChunkBefore == 0) linkChunkBefore = current;
+  setCaptureChunkSize(reduced);
+  linkChunkApplied = getCaptureChunkSize();
+  Serial.printf("🔽 Link degraded, capture chunk %u -> %u bytes\n",
+                (unsigned)current, (unsigned)linkChunkApplied);
+}
+
+// Puts the pre-downshift size back once every link signal is below WARNING.
+// A size changed by someone else since (memory budget) is left alone.
+static void restoreCaptureChunk() {
+  if (linkChunkBefore == 0) return;
+  if (getAnomalySeverity(ANOMALY_SIGNAL_WS_RTT) >= ANOMALY_WARNING ||
+      getAnomalySeverity(ANOMALY_SIGNAL_WS_SEND) >= ANOMALY_WARNING ||
+      getAnomalySeverity(ANOMALY_SIGNAL_WIFI_RSSI) >= ANOMALY_WARNING) {
+    return;
+  }
+
+  if (getCaptureChunkSize() == linkChunkApplied) {
+    setCaptureChunkSize(linkChunkBefore);
+    Serial.printf("🔼 Link recovered, capture chunk back to %u bytes\n", (unsigned)linkChunkBefore);
+  }
+  linkChunkBefore = 0;
+  linkChunkApplied = 0;
+}
+
+// Preemptive responses to detector findings: send smaller chunks when the
+// link degrades, reconnect early on a sustained RTT regression while no
+// conversation is running, and drop idle arenas when the heap trends down
+static void onHealthAnomalyEvent(const Event& event) {
+  static unsigned long lastProactiveReconnect = 0;
+  const AnomalyPayload& anomaly = event.anomaly;
+  if (anomaly.severity < ANOMALY_WARNING) return;
+
+  switch (anomaly.signal) {
+    case ANOMALY_SIGNAL_WS_RTT:
+    case ANOMALY_SIGNAL_WS_SEND:
+    case ANOMALY_SIGNAL_WIFI_RSSI:
+      downshiftCaptureChunk();
+      if (anomaly.signal == ANOMALY_SIGNAL_WS_RTT && anomaly.severity == ANOMALY_CRITICAL &&
+          isConnected && getCurrentUtteranceId() == 0 &&
+          (lastProactiveReconnect == 0 || millis() - lastProactiveReconnect >= ANOMALY_RECONNECT_COOLDOWN)) {
+        lastProactiveReconnect = millis();
+        Serial.printf("🔄 RTT regressed to %.0f ms (baseline %.0f ms), reconnecting early\n",
+                      anomaly.value, anomaly.baseline);
+        connectionHealth.reconnectDelay = 1000;
+        webSocket.disconnect();
+      }
+      break;
+    case ANOMALY_SIGNAL_HEAP: {
+      size_t released = releaseIdleJsonArenas();
+      if (released > 0) {
+        Serial.printf("🧹 Heap trending down, released %u bytes of idle JSON arenas\n", (unsigned)released);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void initWebSocketEvents() {
+  if (wsEvents != EVENT_SUBSCRIBER_INVALID) return;
+
+  wsEvents = registerEventSubscriber("websocket");
+  subscribeEvent(wsEvents, EVENT_AUDIO_CHUNK, onAudioChunkEvent);
+  subscribeEvent(wsEvents, EVENT_AUTH_REFRESH_REQUEST, onAuthRefreshEvent);
+  subscribeEvent(wsEvents, EVENT_HEALTH_ANOMALY, onHealthAnomalyEvent);
+}
+
+void flushWebSocketEvents() {
+  while (dispatchEvents(wsEvents) > 0) {
+  }
+}
+
+// =============================================================================
+// AUDIO TEXT FRAMES
+// =============================================================================
+
+static_assert(AUDIO_FRAME_WS_HEADROOM == WEBSOCKETS_MAX_HEADER_SIZE,
+              "Text frame headroom must match the WebSocket header reserve");
+
+static const char AUDIO_TEXT_PREFIX[] = "{\"audio_data\":\"";
+static_assert(sizeof(AUDIO_TEXT_PREFIX) - 1 == AUDIO_TEXT_PREFIX_LENGTH, "Prefix length mismatch");
+
+// {"audio_data":"<base64>",<members of meta>} in one pooled buffer. The PCM
+// is encoded once, in place, instead of into a scratch buffer that the JSON
+// serializer copies again into a String.
+AudioFrame buildAudioTextFrame(const uint8_t* pcm, size_t length, JsonDocument& meta) {
+  size_t base64Capacity = base64EncodedLength(length) + 1;  // Includes the NUL
+  size_t metaLength = measureJson(meta);
+  if (length == 0) return AudioFrame();
+
+  AudioFrame text = AudioFrame::allocate(AUDIO_TEXT_PREFIX_LENGTH + base64Capacity + metaLength + 1,
+                                         AUDIO_FRAME_WS_HEADROOM);
+  char* out = (char*)text.mutableData();
+  if (out == nullptr) return AudioFrame();
+
+  memcpy(out, AUDIO_TEXT_PREFIX, AUDIO_TEXT_PREFIX_LENGTH);
+  size_t n = AUDIO_TEXT_PREFIX_LENGTH;
+  size_t encoded = 0;
+  if (!base64Encode(pcm, length, out + n, base64Capacity, &encoded)) return AudioFrame();
+  noteAudioCopy(encoded);
+  n += encoded;
+  out[n++] = '"';
+
+  // Splice the metadata object in: its opening brace becomes the separator
+  size_t written = serializeJson(meta, out + n, text.capacity() - n);
+  if (written <= 2) {
+    out[n++] = '}';
+  } else {
+    out[n] = ',';
+    n += written;
+  }
+  text.setLength(n);
+  return text;
+}
+
+// The frame's headroom takes the WebSocket header, so the payload is sent
+// without the library copying it into a combined buffer
+bool sendTextFrame(AudioFrame& frame) {
+  uint8_t* start = frame.mutableHeadroom();
+  if (start == nullptr || frame.headroom() != AUDIO_FRAME_WS_HEADROOM) {
+    return false;
+  }
+  return webSocket.sendTXT(start, frame.length(), true);
+}
+
+void sendAudioDataWebSocket(const uint8_t* audioData, size_t length, bool finalChunk) {
   if (!isConnected || audioData == nullptr || length == 0) {
     logError("Audio", "Cannot send audio", "not connected or invalid data");
     return;
@@ -816,6 +1143,8 @@ void sendAudioDataWebSocket(uint8_t* audioData, size_t length) {
   updateAudioFlowState(AUDIO_FLOW_SENDING);
   
   unsigned long transmissionStart = millis();
+  uint32_t transmissionStartUs = micros();
+  uint32_t encodeStartUs = traceNow();
   
   // Validate audio format expectations
   if (length != 4096 && length % 2 != 0) {
@@ -823,54 +1152,76 @@ void sendAudioDataWebSocket(uint8_t* audioData, size_t length) {
   }
   
   // Generate unique identifiers
-  String chunkId = String(millis()) + "_" + String(random(1000, 9999));
-  String sessionId = String(millis() / 1000);
+  FixedString<24> chunkId;
+  chunkId.appendf("%lu_%ld", millis(), random(1000, 9999));
+  FixedString<12> sessionId;
+  sessionId.appendf("%lu", millis() / 1000);
   
   // Calculate HMAC for audio authentication
-  String audioHmac = calculateAudioHMACWebSocket(audioData, length, chunkId, sessionId);
+  FixedString<65> audioHmac = calculateAudioHMACWebSocket(audioData, length, chunkId, sessionId);
   
   // ✅ الحل: تطابق مع بروتوكول السيرفر - JSON بدلاً من binary
-  String base64Audio = base64::encode(audioData, length);
-  // Allocate JSON capacity based on Base64 size to avoid memory pressure
-  // Base64 expands by ~4/3; add overhead for fields/HMAC
-  DynamicJsonDocument doc(base64Audio.length() + 1024);
+  // Metadata only: the base64 payload is encoded straight into the text frame
+  JsonArenaScope arena;
+  ArenaJsonDocument doc(1024);
   doc["type"] = "audio_chunk";
-  doc["audio_data"] = base64Audio;
-  doc["chunk_id"] = chunkId;
+  doc["chunk_id"] = chunkId.c_str();
   if (g_audio_session_id.length() > 0) {
     doc["audio_session_id"] = g_audio_session_id;
   }
-  bool finalFlag = false;
-  if (g_mark_final_next) { finalFlag = true; g_mark_final_next = false; }
-  doc["is_final"] = finalFlag;
-  // Log a short fingerprint and stats of the audio about to be sent
-  {
-    String b64prefix = base64Audio.substring(0, 16);
-    float rms_db = 0.0f; int16_t peak = 0;
-    computeAudioStats(audioData, length, rms_db, peak);
-    Serial.printf("?? About to send audio: bytes=%d, samples=%d, peak=%d, rms=%.1f dBFS, b64=%.16s...\n",
-                  (int)length, (int)(length/2), (int)peak, (double)rms_db, b64prefix.c_str());
+  doc["is_final"] = finalChunk;
+  uint32_t utteranceId = getCurrentUtteranceId();
+  if (utteranceId != 0) {
+    doc["utterance_id"] = utteranceId;
   }
-  
+
   // 🔒 Add HMAC for production security
   if (!audioHmac.isEmpty()) {
-    doc["hmac"] = audioHmac;
+    doc["hmac"] = audioHmac.c_str();
 #ifdef PRODUCTION_BUILD
     Serial.println("🔒 Audio HMAC added (production)");
 #else
-    Serial.printf("🔒 Audio HMAC: %s...\n", audioHmac.substring(0, 16).c_str());
+    Serial.printf("🔒 Audio HMAC: %.16s...\n", audioHmac.c_str());
 #endif
   } else {
     Serial.println("⚠️ Audio sent without HMAC (security risk)");
   }
   
-  String message;
-  serializeJson(doc, message);
-  bool success = webSocket.sendTXT(message);
+  AudioFrame text = buildAudioTextFrame(audioData, length, doc);
+  if (!text) {
+    Serial.printf("❌ Failed to encode audio chunk (%d bytes)\n", (int)length);
+    return;
+  }
+  traceComplete(TRACE_SPAN_ENCODE, encodeStartUs, traceArg(length));
+  
+  // Log a short fingerprint and stats of the audio about to be sent
+  {
+    float rms_db = 0.0f; int16_t peak = 0;
+    computeAudioStats(audioData, length, rms_db, peak);
+    Serial.printf("?? About to send audio: bytes=%d, samples=%d, peak=%d, rms=%.1f dBFS, b64=%.16s...\n",
+                  (int)length, (int)(length/2), (int)peak, (double)rms_db,
+                  (const char*)text.data() + AUDIO_TEXT_PREFIX_LENGTH);
+  }
+  
+  uint32_t sendStartUs = traceNow();
+#if FEATURE_PERFORMANCE_COMMANDS
+  if (forcedNetwork.delayMs > 0) {
+    delay(forcedNetwork.delayMs);
+  }
+  bool success = (forcedNetwork.lossPercent > 0 && random(100) < forcedNetwork.lossPercent)
+               ? false : sendTextFrame(text);
+#else
+  bool success = sendTextFrame(text);
+#endif
+  traceComplete(TRACE_SPAN_SEND, sendStartUs, traceArg(length));
   
   if (success) {
+    AUDIO_TAP(AUDIO_TAP_SEND, audioData, length);
     connectionHealth.packetsSent++;
     consecutiveTimeouts = 0; // Reset timeout counter on success
+    metricIncrement(metricPacketsSent);
+    metricIncrement(metricBytesSent, (uint32_t)length);
+    metricObserve(metricSendHist, micros() - transmissionStartUs);
     
     unsigned long transmissionTime = millis() - transmissionStart;
     Serial.printf("✅ Secure audio chunk sent: %d bytes in %lu ms\n", length, transmissionTime);
@@ -894,6 +1245,7 @@ void sendAudioDataWebSocket(uint8_t* audioData, size_t length) {
   } else {
     connectionHealth.packetsLost++;
     consecutiveTimeouts++;
+    metricIncrement(metricPacketsLost);
     
     Serial.printf("❌ Failed to send binary audio frame (%d bytes)\n", length);
     
@@ -913,6 +1265,7 @@ void sendAudioStartSession() {
   if (!isConnected) return;
   DynamicJsonDocument doc(128);
   doc["type"] = "audio_start";
+  if (getCurrentUtteranceId() != 0) doc["utterance_id"] = getCurrentUtteranceId();
   String msg; serializeJson(doc, msg);
   webSocket.sendTXT(msg);
 }
@@ -922,18 +1275,17 @@ void sendAudioEndSession() {
   DynamicJsonDocument doc(192);
   doc["type"] = "audio_end";
   if (g_audio_session_id.length() > 0) doc["audio_session_id"] = g_audio_session_id;
+  if (getCurrentUtteranceId() != 0) doc["utterance_id"] = getCurrentUtteranceId();
   String msg; serializeJson(doc, msg);
   webSocket.sendTXT(msg);
-}
-
-void markNextChunkFinal() {
-  g_mark_final_next = true;
+  audioEndSentMs = millis();
+  awaitingFirstResponse = true;
 }
 
 // Adaptive chunk sizing functions
 size_t getOptimalChunkSize() {
   // Adjust based on WiFi signal strength and recent performance
-  int rssi = WiFi.RSSI();
+  int rssi = effectiveRSSI();
   
   if (rssi > -50 && consecutiveTimeouts == 0) {
     // Excellent signal, use larger chunks
@@ -947,6 +1299,14 @@ size_t getOptimalChunkSize() {
   }
 }
 
+size_t getAdaptiveChunkSize() {
+  return adaptiveChunkSize;
+}
+
+void setAdaptiveChunkSize(size_t bytes) {
+  adaptiveChunkSize = constrain(bytes, (size_t)512, (size_t)8192);
+}
+
 void adjustChunkSizeDown() {
   adaptiveChunkSize = max(adaptiveChunkSize / 2, (size_t)512);
   Serial.printf("🔽 Reduced chunk size to %d bytes\n", adaptiveChunkSize);
@@ -975,7 +1335,7 @@ void updateConnectionQuality() {
   float scoreAdjustment = 0;
   
   // WiFi signal strength factor
-  int rssi = WiFi.RSSI();
+  int rssi = effectiveRSSI();
   if (rssi > -50) scoreAdjustment += 10;        // Excellent
   else if (rssi > -60) scoreAdjustment += 5;    // Good
   else if (rssi > -70) scoreAdjustment += 0;    // Fair
@@ -1062,6 +1422,7 @@ void performConnectionHealthCheck() {
     connectionHealth.lastHealthCheck = now;
     
     updateConnectionQuality();
+    restoreCaptureChunk();
     
     // Log health status
     Serial.printf("🏥 Connection Health - Score: %.1f%%, RTT: %lu ms, Pongs: %u/%u\n",
@@ -1137,6 +1498,9 @@ void handleWebSocketLoop() {
   // Handle WebSocket loop
   webSocket.loop();
   
+  // Deliver audio and auth events published by other tasks
+  dispatchEvents(wsEvents);
+  
   // Perform periodic connection health checks
   performConnectionHealthCheck();
   
@@ -1196,7 +1560,7 @@ void resetLocalConnectionStats() {
  * Handle Welcome message from server
  * Format: {"type": "welcome", "audio": {"sample_rate": 16000, "channels": 1, "format": "pcm_s16le"}}
  */
-void handleWelcomeMessage(DynamicJsonDocument& doc) {
+void handleWelcomeMessage(JsonDocument& doc) {
   Serial.println("🎉 Received welcome message from server");
   
   // Extract audio configuration
@@ -1230,7 +1594,7 @@ void handleWelcomeMessage(DynamicJsonDocument& doc) {
  * Handle Policy Update message from server
  * Format: {"type": "policy", "child_id": "uuid", "age": 7, "filters": {"content": "strict", "blocked_topics": ["violence"]}}
  */
-void handlePolicyUpdate(DynamicJsonDocument& doc) {
+void handlePolicyUpdate(JsonDocument& doc) {
   Serial.println("📋 Received policy update from server");
   
   String childId = doc["child_id"] | "";
@@ -1269,7 +1633,7 @@ void handlePolicyUpdate(DynamicJsonDocument& doc) {
  * Handle Security Alert message from server
  * Format: {"type": "alert", "severity": "high", "code": "pii_detected", "message": "Sensitive info detected"}
  */
-void handleSecurityAlert(DynamicJsonDocument& doc) {
+void handleSecurityAlert(JsonDocument& doc) {
   String severity = doc["severity"] | "medium";
   String code = doc["code"] | "unknown";
   String message = doc["message"] | "Security alert";
@@ -1353,22 +1717,26 @@ void handleSecurityAlert(DynamicJsonDocument& doc) {
 /**
  * Handle JWT Authentication Response (auth/ok or auth/error)
  */
-void handleAuthenticationResponse(DynamicJsonDocument& doc, bool success) {
+void handleAuthenticationResponse(JsonDocument& doc, bool success) {
   String type = doc["type"];
+
+  // Every auth reply settles a pending refresh: auth/ok confirms it (with a
+  // new expiry or without), auth/error fails it
+  if (type == "auth/ok" || type == "auth/error") {
+    JWTManager* jwtManager = JWTManager::getInstance();
+    if (jwtManager) {
+      String reply;
+      serializeJson(doc, reply);
+      jwtManager->handleRefreshResponse(reply);
+    }
+  }
   
   if (success && type == "auth/ok") {
     Serial.println("✅ WebSocket JWT authentication successful");
     
-    // Extract new token expiry if provided
     if (doc.containsKey("exp_in_sec")) {
       uint32_t expiresInSec = doc["exp_in_sec"];
       Serial.printf("🔄 Token refreshed, expires in %u seconds\n", expiresInSec);
-      
-      // Update JWT Manager with new expiry
-      JWTManager* jwtManager = JWTManager::getInstance();
-      if (jwtManager) {
-        jwtManager->handleRefreshResponse(doc.as<String>());
-      }
     }
     
     // Show success indication
@@ -1397,6 +1765,8 @@ void handleAuthenticationResponse(DynamicJsonDocument& doc, bool success) {
  */
 void handleIncomingAudioFrame(uint8_t* audioData, size_t length) {
   Serial.printf("🎵 Processing incoming audio frame: %d bytes\n", length);
+  traceInstant(TRACE_SPAN_RESPONSE, traceArg(length));
+  noteFirstAudioResponse();
   
   // Validate audio frame format
   if (length == 4096) {
@@ -1422,16 +1792,16 @@ void handleIncomingAudioFrame(uint8_t* audioData, size_t length) {
 /**
  * Handle JWT refresh messages for WebSocket authentication
  */
-bool handleJWTRefreshMessage(const String& refreshMessage) {
+bool handleJWTRefreshMessage(const char* refreshMessage) {
   if (!isConnected) {
     Serial.println("❌ Cannot send JWT refresh - WebSocket not connected");
     return false;
   }
   
-  Serial.printf("🔄 Sending JWT refresh via WebSocket: %s\n", refreshMessage.c_str());
+  Serial.printf("🔄 Sending JWT refresh via WebSocket: %s\n", refreshMessage);
   
   // Send JWT refresh request as text message
-  bool success = webSocket.sendTXT(refreshMessage.c_str());
+  bool success = webSocket.sendTXT(refreshMessage);
   
   if (success) {
     Serial.println("✅ JWT refresh request sent via WebSocket");
@@ -6,6 +6,8 @@
 #include <ArduinoJson.h>
 #include <Preferences.h>
 #include "config_manager.h"  // Access ConfigManager & TeddyConfig
+#include "web_assets.h"
+#include "wifi_scan_cache.h"
 #include <esp_task_wdt.h>
 
 // Setup mode handler for main loop – يدير بوابة الإعداد إن كانت نشطة
@@ -67,6 +69,9 @@ bool startWiFiPortal() {
     // Setup web server routes
     setupPortalRoutes();
     
+    // Network list is scanned in the background from here on
+    beginWifiScanCache();
+    
     // Start web server
     portalServer.begin();
     
@@ -95,191 +100,38 @@ void setupPortalRoutes() {
     
     // Captive portal - redirect all requests to main page
     portalServer.onNotFound(handlePortalRoot);
+    collectWebAssetHeaders(portalServer);
     
     Serial.println("Portal routes configured");
 }
 
 void handlePortalRoot() {
-    String html = generatePortalHTML();
-    portalServer.send(200, "text/html", html);
-}
-
-String generatePortalHTML() {
-    String html = "<!DOCTYPE html><html><head>";
-    html += "<meta charset='UTF-8'>";
-    html += "<meta name='viewport' content='width=device-width, initial-scale=1.0'>";
-    html += "<title>AI Teddy Bear Setup</title>";
-    html += "<style>";
-    html += "body { font-family: Arial, sans-serif; margin: 20px; background: #f0f0f0; }";
-    html += ".container { max-width: 400px; margin: 0 auto; background: white; padding: 20px; border-radius: 10px; }";
-    html += ".header { text-align: center; color: #333; margin-bottom: 20px; }";
-    html += ".section { margin-bottom: 20px; padding: 15px; background: #f8f9fa; border-radius: 5px; }";
-    html += "input, select { width: 100%; padding: 10px; margin: 5px 0; border: 1px solid #ddd; border-radius: 5px; }";
-    html += ".btn { width: 100%; padding: 12px; background: #007bff; color: white; border: none; border-radius: 5px; cursor: pointer; margin: 5px 0; }";
-    html += ".btn:hover { background: #0056b3; }";
-    html += ".btn-warning { background: #ffc107; color: #212529; }";
-    html += ".btn-success { background: #28a745; }";
-    html += ".status { padding: 10px; margin: 10px 0; border-radius: 5px; text-align: center; }";
-    html += ".success { background: #d4edda; color: #155724; }";
-    html += ".error { background: #f8d7da; color: #721c24; }";
-    html += ".info { background: #d1ecf1; color: #0c5460; }";
-    html += ".network-list { max-height: 200px; overflow-y: auto; border: 1px solid #ddd; border-radius: 5px; }";
-    html += ".network-item { padding: 10px; border-bottom: 1px solid #eee; cursor: pointer; }";
-    html += ".network-item:hover { background: #f8f9fa; }";
-    html += ".hidden { display: none; }";
-    html += "</style></head><body>";
-    
-    html += "<div class='container'>";
-    html += "<div class='header'><h1>AI Teddy Bear</h1><p>WiFi Setup Portal</p></div>";
-    
-    // WiFi Configuration Section
-    html += "<div class='section'>";
-    html += "<h3>WiFi Configuration</h3>";
-    html += "<button class='btn btn-warning' onclick='scanNetworks()'>Scan Networks</button>";
-    html += "<div id='networkList' class='hidden'>";
-    html += "<label>Available Networks:</label>";
-    html += "<div class='network-list' id='networks'><div>Scanning...</div></div>";
-    html += "</div>";
-    html += "<label>Network Name (SSID):</label>";
-    html += "<input type='text' id='ssid' placeholder='Select from list or type manually'>";
-    html += "<label>Password:</label>";
-    html += "<input type='password' id='password' placeholder='Network password'>";
-    html += "<button class='btn' onclick='connectWiFi()'>Connect to Network</button>";
-    html += "<div id='wifiStatus'></div>";
-    html += "</div>";
-    
-    // Device Information Section
-    html += "<div class='section'>";
-    html += "<h3>Device Information</h3>";
-    html += "<p><strong>Device ID:</strong> teddy-001</p>";
-    html += "<p><strong>Firmware Version:</strong> 1.0.0</p>";
-    html += "<p><strong>MAC Address:</strong> " + WiFi.macAddress() + "</p>";
-    html += "<div class='status info'><p>Child profile will be configured via mobile app</p></div>";
-    html += "</div>";
-    
-    // Control Section
-    html += "<div class='section'>";
-    html += "<h3>Control</h3>";
-    html += "<button class='btn btn-success' onclick='checkStatus()'>Check Status</button>";
-    html += "<button class='btn btn-warning' onclick='restartDevice()'>Restart Device</button>";
-    html += "</div>";
-    
-    html += "<div id='generalStatus'></div>";
-    html += "</div>";
-    
-    // JavaScript
-    html += "<script>";
-    html += "function scanNetworks() {";
-    html += "  document.getElementById('networkList').classList.remove('hidden');";
-    html += "  document.getElementById('networks').innerHTML = 'Scanning...';";
-    html += "  fetch('/scan').then(response => response.json()).then(data => {";
-    html += "    displayNetworks(data.networks);";
-    html += "  }).catch(error => {";
-    html += "    document.getElementById('networks').innerHTML = 'Error scanning networks';";
-    html += "  });";
-    html += "}";
-    
-    html += "function displayNetworks(networks) {";
-    html += "  const container = document.getElementById('networks');";
-    html += "  if (networks.length === 0) {";
-    html += "    container.innerHTML = 'No networks found';";
-    html += "    return;";
-    html += "  }";
-    html += "  let html = '';";
-    html += "  networks.forEach(network => {";
-    html += "    html += '<div class=\"network-item\" onclick=\"selectNetwork(\\'' + network.ssid + '\\')\">';";
-    html += "    html += '<div>' + network.ssid + ' (' + network.rssi + ' dBm) ' + network.encryption + '</div>';";
-    html += "    html += '</div>';";
-    html += "  });";
-    html += "  container.innerHTML = html;";
-    html += "}";
-    
-    html += "function selectNetwork(ssid) {";
-    html += "  document.getElementById('ssid').value = ssid;";
-    html += "}";
-    
-    html += "function connectWiFi() {";
-    html += "  const ssid = document.getElementById('ssid').value;";
-    html += "  const password = document.getElementById('password').value;";
-    html += "  if (!ssid) {";
-    html += "    showStatus('wifiStatus', 'Please select a WiFi network', 'error');";
-    html += "    return;";
-    html += "  }";
-    html += "  showStatus('wifiStatus', 'Connecting to network...', 'info');";
-    html += "  fetch('/connect', {";
-    html += "    method: 'POST',";
-    html += "    headers: { 'Content-Type': 'application/x-www-form-urlencoded' },";
-    html += "    body: 'ssid=' + encodeURIComponent(ssid) + '&password=' + encodeURIComponent(password)";
-    html += "  }).then(response => response.json()).then(data => {";
-    html += "    if (data.success) {";
-    html += "      showStatus('wifiStatus', 'Connected successfully! IP: ' + data.ip, 'success');";
-    html += "      setTimeout(() => {";
-    html += "        showStatus('generalStatus', 'Device setup complete! Restarting in 10 seconds...', 'success');";
-    html += "        setTimeout(() => restartDevice(), 10000);";
-    html += "      }, 2000);";
-    html += "    } else {";
-    html += "      showStatus('wifiStatus', 'Connection failed: ' + data.message, 'error');";
-    html += "    }";
-    html += "  }).catch(error => {";
-    html += "    showStatus('wifiStatus', 'Connection error', 'error');";
-    html += "  });";
-    html += "}";
-    
-    html += "function checkStatus() {";
-    html += "  fetch('/status').then(response => response.json()).then(data => {";
-    html += "    let statusText = 'Device Status:<br>';";
-    html += "    statusText += 'WiFi: ' + (data.wifi_connected ? 'Connected' : 'Disconnected') + '<br>';";
-    html += "    statusText += 'Free Memory: ' + data.free_memory + ' bytes<br>';";
-    html += "    statusText += 'Uptime: ' + data.uptime + ' seconds';";
-    html += "    showStatus('generalStatus', statusText, 'info');";
-    html += "  }).catch(error => {";
-    html += "    showStatus('generalStatus', 'Error checking status', 'error');";
-    html += "  });";
-    html += "}";
-    
-    html += "function restartDevice() {";
-    html += "  if (confirm('Are you sure you want to restart the device?')) {";
-    html += "    showStatus('generalStatus', 'Restarting device...', 'info');";
-    html += "    fetch('/restart', { method: 'POST' });";
-    html += "  }";
-    html += "}";
-    
-    html += "function showStatus(elementId, message, type) {";
-    html += "  const element = document.getElementById(elementId);";
-    html += "  element.innerHTML = '<div class=\"status ' + type + '\">' + message + '</div>';";
-    html += "}";
-    
-    html += "window.onload = function() { setTimeout(scanNetworks, 1000); };";
-    html += "</script>";
-    
-    html += "</body></html>";
-    
-    return html;
+    // Gzipped page straight from flash; device details load from /status
+    sendWebAsset(portalServer, "portal.html");
 }
 
 void handleNetworkScan() {
-    Serial.println("Scanning for networks...");
-    
-    WiFi.mode(WIFI_AP_STA);
-    int n = WiFi.scanNetworks();
+    // Cached results, never a blocking scan: the portal and captive DNS stay responsive
+    WifiScanSnapshot scan = getWifiScanResults();
     
     StaticJsonDocument<2048> doc;
     JsonArray networks = doc.createNestedArray("networks");
     
-    for (int i = 0; i < n; i++) {
+    for (uint8_t i = 0; i < scan.count; i++) {
         JsonObject network = networks.createNestedObject();
-        network["ssid"] = WiFi.SSID(i);
-        network["rssi"] = WiFi.RSSI(i);
-        network["encryption"] = getEncryptionType(WiFi.encryptionType(i));
+        network["ssid"] = scan.entries[i].ssid;
+        network["rssi"] = scan.entries[i].rssi;
+        network["channel"] = scan.entries[i].channel;
+        network["encryption"] = getEncryptionType(scan.entries[i].auth);
     }
+    doc["age_ms"] = scan.ageMs;
+    doc["stale"] = scan.stale;
+    doc["scanning"] = scan.scanning;
     
     String response;
     serializeJson(doc, response);
     
     portalServer.send(200, "application/json", response);
-    
-    // Return to AP+STA mode
-    WiFi.mode(WIFI_AP_STA);
 }
 
 String getEncryptionType(wifi_auth_mode_t encryptionType) {
@@ -306,6 +158,9 @@ void handleWiFiConnect() {
     
     Serial.printf("Attempting to connect to: %s\n", ssid.c_str());
     
+    // A background scan would hold the radio off the target channel
+    stopWifiScanCache();
+    
     // Switch to station mode and try to connect
     WiFi.mode(WIFI_AP_STA);
     WiFi.begin(ssid.c_str(), password.c_str());
@@ -361,6 +216,7 @@ void handleWiFiConnect() {
         
         // Keep AP+STA so portal remains visible and STA can retry
         WiFi.mode(WIFI_AP_STA);
+        beginWifiScanCache();
     }
     
     String responseStr;
@@ -450,6 +306,9 @@ void handleWiFiPortal() {
     // Handle web server requests
     portalServer.handleClient();
     
+    // Start or collect background scans
+    updateWifiScanCache();
+    
     // Check for timeout
     if (millis() - portalStartTime > PORTAL_TIMEOUT && !configurationComplete) {
         Serial.println("Portal timeout - stopping portal");
@@ -480,6 +339,7 @@ void stopWiFiPortal() {
     
     Serial.println("Stopping WiFi Portal...");
     
+    stopWifiScanCache();
     portalServer.stop();
     dnsServer.stop();
     WiFi.softAPdisconnect(true);
@@ -0,0 +1,153 @@
+#include "wifi_scan_cache.h"
+#include <esp_wifi.h>
+
+static WifiScanEntry entries[WIFI_SCAN_MAX_RESULTS];
+static uint8_t entryCount = 0;
+static bool active = false;
+static bool scanning = false;
+static bool haveResults = false;
+static bool refreshWanted = false;
+static uint32_t scanStartedAt = 0;
+static uint32_t resultsAt = 0;        // When the cached results were collected
+static uint32_t lastAttemptAt = 0;    // When the last scan ended, successfully or not
+
+// =============================================================================
+// RESULTS
+// =============================================================================
+
+// Keeps the strongest access point per SSID; when full, drops the weakest
+static void addEntry(const wifi_ap_record_t& ap) {
+  const char* ssid = (const char*)ap.ssid;
+  if (ssid[0] == '\0') return;   // Hidden network
+
+  for (uint8_t i = 0; i < entryCount; i++) {
+    if (strcmp(entries[i].ssid, ssid) == 0) {
+      if (ap.rssi > entries[i].rssi) {
+        entries[i].rssi = ap.rssi;
+        entries[i].channel = ap.primary;
+        entries[i].auth = ap.authmode;
+      }
+      return;
+    }
+  }
+
+  uint8_t slot = entryCount;
+  if (entryCount == WIFI_SCAN_MAX_RESULTS) {
+    slot = 0;
+    for (uint8_t i = 1; i < entryCount; i++) {
+      if (entries[i].rssi < entries[slot].rssi) slot = i;
+    }
+    if (ap.rssi <= entries[slot].rssi) return;
+  } else {
+    entryCount++;
+  }
+  strlcpy(entries[slot].ssid, ssid, sizeof(entries[slot].ssid));
+  entries[slot].rssi = ap.rssi;
+  entries[slot].channel = ap.primary;
+  entries[slot].auth = ap.authmode;
+}
+
+static void sortEntries() {
+  for (uint8_t i = 1; i < entryCount; i++) {
+    WifiScanEntry entry = entries[i];
+    int8_t j = i - 1;
+    while (j >= 0 && entries[j].rssi < entry.rssi) {
+      entries[j + 1] = entries[j];
+      j--;
+    }
+    entries[j + 1] = entry;
+  }
+}
+
+static void collectResults(int found) {
+  entryCount = 0;
+  for (int i = 0; i < found; i++) {
+    const wifi_ap_record_t* ap = (const wifi_ap_record_t*)WiFi.getScanInfoByIndex(i);
+    if (ap != nullptr) addEntry(*ap);
+  }
+  sortEntries();
+  WiFi.scanDelete();
+
+  haveResults = true;
+  refreshWanted = false;
+  resultsAt = millis();
+  Serial.printf("📡 WiFi scan: %d access points, %u networks in %lu ms\n",
+                found, entryCount, (unsigned long)(resultsAt - scanStartedAt));
+}
+
+// =============================================================================
+// SCHEDULING
+// =============================================================================
+
+// A wanted refresh stays wanted until a scan completes, so failures retry
+static void startScan() {
+  scanStartedAt = millis();
+  int16_t result = WiFi.scanNetworks(true /*async*/, false /*show_hidden*/, false /*passive*/,
+                                     WIFI_SCAN_CHANNEL_MS);
+  scanning = (result == WIFI_SCAN_RUNNING);
+  if (!scanning) {
+    lastAttemptAt = millis();
+    Serial.println("⚠️ WiFi scan: could not start");
+  }
+}
+
+static void abandonScan() {
+  esp_wifi_scan_stop();
+  WiFi.scanDelete();
+  scanning = false;
+  lastAttemptAt = millis();
+}
+
+void beginWifiScanCache() {
+  active = true;
+  refreshWanted = true;
+  lastAttemptAt = millis() - WIFI_SCAN_RETRY_MS;
+}
+
+void updateWifiScanCache() {
+  if (!active) return;
+  uint32_t now = millis();
+
+  if (scanning) {
+    int16_t result = WiFi.scanComplete();
+    if (result >= 0) {
+      scanning = false;
+      lastAttemptAt = now;
+      collectResults(result);
+    } else if (result == WIFI_SCAN_FAILED) {
+      scanning = false;
+      lastAttemptAt = now;
+      Serial.println("⚠️ WiFi scan: failed");
+    } else if (now - scanStartedAt > WIFI_SCAN_TIMEOUT_MS) {
+      Serial.println("⚠️ WiFi scan: timed out, abandoned");
+      abandonScan();
+    }
+    return;
+  }
+
+  if (now - lastAttemptAt < WIFI_SCAN_RETRY_MS) return;
+  if (refreshWanted || !haveResults || now - resultsAt >= WIFI_SCAN_INTERVAL_MS) {
+    startScan();
+  }
+}
+
+void stopWifiScanCache() {
+  if (scanning) abandonScan();
+  active = false;
+  refreshWanted = false;
+}
+
+WifiScanSnapshot getWifiScanResults() {
+  WifiScanSnapshot snapshot;
+  uint32_t age = millis() - resultsAt;
+  snapshot.entries = entries;
+  snapshot.count = haveResults ? entryCount : 0;
+  snapshot.valid = haveResults;
+  snapshot.stale = !haveResults || age >= WIFI_SCAN_FRESH_MS;
+  snapshot.ageMs = haveResults ? age : 0;
+  if (snapshot.stale && active && !scanning) {
+    refreshWanted = true;   // Revalidate in the background
+  }
+  snapshot.scanning = scanning || refreshWanted;
+  return snapshot;
+}
@@ -0,0 +1,13 @@
+#pragma once
+// Station link state and signal, set by the test
+#include <Arduino.h>
+
+typedef enum { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 } wl_status_t;
+
+struct WiFiStub {
+  wl_status_t linkStatus = WL_CONNECTED;
+  int8_t rssi = -60;
+  wl_status_t status() { return linkStatus; }
+  int8_t RSSI() { return rssi; }
+};
+extern WiFiStub WiFi;
@@ -0,0 +1,262 @@
+// Anomaly detection on synthetic traces with known change points, through
+// the firmware's sampling, histograms and event bus: CUSUM delay on an RSSI
+// step and on a sparse audio latency step, EWMA notices on isolated RTT
+// spikes, heap slope warning on a slow leak and critical on a fast one, and
+// no WARNING/CRITICAL before any change. Each noise seed runs in a child
+// process so the detectors start from scratch, as after a restart.
+//
+//   test_anomaly_detector [trials] [seed]
+// scripts/anomaly_eval.py scores the same scenarios in Python.
+#include <anomaly_detector.h>
+#include <event_bus.h>
+#include <metrics_registry.h>
+#include <resource_manager.h>
+#include <WiFi.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <random>
+#include <vector>
+
+WiFiStub WiFi;
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+// =============================================================================
+// DETECTORS
+// =============================================================================
+
+static void testDetectors() {
+  // A spike moves a settled baseline by at most alpha * ANOMALY_Z_CLIP sigmas
+  EwmaDetector ewma(ANOMALY_EWMA_ALPHA, 5.0f);
+  for (int i = 0; i < ANOMALY_WARMUP_SAMPLES; i++) ewma.update(100.0f);
+  CHECK(ewma.warmedUp() && ewma.mean() == 100.0f && ewma.sigma() == 5.0f);
+  CHECK(ewma.score(120.0f) == 4.0f);
+  ewma.update(1000.0f);
+  CHECK(fabsf(ewma.mean() - (100.0f + ANOMALY_EWMA_ALPHA * ANOMALY_Z_CLIP * 5.0f)) < 1e-3f);
+  ewma.reset();
+  CHECK(!ewma.warmedUp() && ewma.mean() == 0.0f);
+
+  // Residuals within the slack never accumulate; spikes count as ANOMALY_Z_CLIP
+  CusumDetector cusum;
+  for (int i = 0; i < 100; i++) cusum.update(ANOMALY_CUSUM_SLACK);
+  CHECK(cusum.value() == 0.0f);
+  CHECK(cusum.update(50.0f) == ANOMALY_Z_CLIP - ANOMALY_CUSUM_SLACK);
+  CHECK(cusum.update(-50.0f) == 0.0f);
+
+  // Exact line: slope recovered, infinitely significant; flat: no trend
+  SlopeDetector slope;
+  float perSample, t;
+  slope.add(150000.0f);
+  slope.add(149998.0f);
+  CHECK(!slope.fit(perSample, t));
+  for (int i = 2; i < ANOMALY_HEAP_WINDOW + 10; i++) slope.add(150000.0f - 2.0f * i);
+  CHECK(slope.full() && slope.fit(perSample, t));
+  CHECK(fabsf(perSample + 2.0f) < 1e-3f && t < -1000.0f);
+  slope.reset();
+  for (int i = 0; i < ANOMALY_HEAP_WINDOW; i++) slope.add(i % 2 ? 150100.0f : 149900.0f);
+  CHECK(slope.fit(perSample, t) && fabsf(t) < ANOMALY_HEAP_MIN_T);
+}
+
+// =============================================================================
+// SCENARIO
+// =============================================================================
+
+// Four hours, one sample per second, all signals at once:
+//   ws.rtt         40 +- 4 ms, 1% retransmission spikes of +250 ms throughout
+//   wifi.rssi      -55 +- 1.5 dBm, 6 dB weaker from STEP_S
+//   audio.latency  one utterance every 10 s, 800 +- 40 ms, +150 ms from STEP_S
+//   heap.free      150 KB +- 2 KB, leaking 12 KB/h from LEAK_S and 72 KB/h from FAST_LEAK_S
+static const uint32_t DURATION_S = 4 * 3600;
+static const uint32_t STEP_S = 2 * 3600;
+static const uint32_t LEAK_S = 3600;
+static const uint32_t FAST_LEAK_S = 3 * 3600;
+static const uint32_t UTTERANCE_EVERY_S = 10;
+
+struct TrialResult {
+  int32_t rssiDelay;        // s from STEP_S to WARNING, -1 if missed
+  int32_t latencyDelay;     // Utterances from STEP_S to WARNING, -1 if missed
+  int32_t heapWarnDelay;    // s from LEAK_S to WARNING, -1 if missed
+  int32_t heapCritDelay;    // s from FAST_LEAK_S to CRITICAL, -1 if missed
+  uint32_t falseAlarms;     // WARNING/CRITICAL before a change point
+  uint32_t spikeWarnings;   // WARNING/CRITICAL on ws.rtt, which never shifts
+  uint32_t earlyNotices;    // NOTICEs on wifi.rssi and audio.latency before STEP_S
+  uint32_t spikeNotices;    // NOTICEs on ws.rtt
+  uint32_t spikes;
+};
+
+static uint32_t nowS = 0;
+static TrialResult trial;
+
+static void recordFinding(uint32_t changeS, int32_t& delay, AnomalySeverity wanted, const AnomalyPayload& a) {
+  if (nowS < changeS) {
+    trial.falseAlarms++;
+  } else if (a.severity == wanted && delay < 0) {
+    delay = (int32_t)(nowS - changeS);
+  }
+}
+
+static void onAnomaly(const Event& event) {
+  const AnomalyPayload& a = event.anomaly;
+  if (a.severity == ANOMALY_NOTICE) {
+    if (a.signal == ANOMALY_SIGNAL_WS_RTT) trial.spikeNotices++;
+    else if (nowS < STEP_S) trial.earlyNotices++;
+    return;
+  }
+  switch (a.signal) {
+    case ANOMALY_SIGNAL_WIFI_RSSI:
+      recordFinding(STEP_S, trial.rssiDelay, ANOMALY_WARNING, a);
+      break;
+    case ANOMALY_SIGNAL_AUDIO_LATENCY:
+      recordFinding(STEP_S, trial.latencyDelay, ANOMALY_WARNING, a);
+      break;
+    case ANOMALY_SIGNAL_HEAP:
+      if (a.severity == ANOMALY_CRITICAL) recordFinding(FAST_LEAK_S, trial.heapCritDelay, ANOMALY_CRITICAL, a);
+      else recordFinding(LEAK_S, trial.heapWarnDelay, ANOMALY_WARNING, a);
+      break;
+    case ANOMALY_SIGNAL_WS_RTT:
+      trial.spikeWarnings++;
+      break;
+    default:
+      trial.falseAlarms++;
+      break;
+  }
+}
+
+static void runTrial(uint32_t seed) {
+  trial = {-1, -1, -1, -1, 0, 0, 0, 0, 0};
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> noise(0.0f, 1.0f);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+  initMetricsRegistry();
+  initResourceManager();
+  initEventBus();
+  MetricId rtt = registerHistogram("ws.rtt", "ms");             // As the WebSocket handler does
+  MetricId latency = registerHistogram("audio.latency", "ms");  // As initMonitoring() does
+  EventSubscriberId sub = registerEventSubscriber("test");
+  subscribeEvent(sub, EVENT_HEALTH_ANOMALY, onAnomaly);
+  initAnomalyDetection();
+
+  for (nowS = 1; nowS <= DURATION_S; nowS++) {
+    bool spike = uniform(rng) < 0.01f;
+    trial.spikes += spike;
+    metricObserve(rtt, (uint32_t)lroundf(40.0f + 4.0f * noise(rng) + (spike ? 250.0f : 0.0f)));
+
+    WiFi.rssi = (int8_t)lroundf(-55.0f + 1.5f * noise(rng) - (nowS >= STEP_S ? 6.0f : 0.0f));
+
+    float latencyNoise = noise(rng);
+    if (nowS % UTTERANCE_EVERY_S == 0) {
+      metricObserve(latency, (uint32_t)lroundf(800.0f + 40.0f * latencyNoise + (nowS >= STEP_S ? 150.0f : 0.0f)));
+    }
+
+    float leaked = 0.0f;
+    if (nowS >= LEAK_S) leaked += 12288.0f * (nowS - LEAK_S) / 3600.0f;
+    if (nowS >= FAST_LEAK_S) leaked += 61440.0f * (nowS - FAST_LEAK_S) / 3600.0f;
+    hostHeap.freeBytes = (size_t)lroundf(150000.0f + 2000.0f * noise(rng) - leaked);
+
+    simUs += 1000000;
+    handleAnomalyDetection();
+    while (dispatchEvents(sub) > 0) {}
+  }
+  if (trial.latencyDelay >= 0) {
+    trial.latencyDelay = (trial.latencyDelay + UTTERANCE_EVERY_S - 1) / UTTERANCE_EVERY_S;
+  }
+}
+
+// Runs one trial in a child; a trial that cannot report counts as all missed
+static TrialResult runTrialProcess(uint32_t seed) {
+  TrialResult result = {-1, -1, -1, -1, 0, 0, 0, 0, 0};
+  int fds[2];
+  if (pipe(fds) != 0) return result;
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    runTrial(seed);
+    bool sent = write(fds[1], &trial, sizeof(trial)) == sizeof(trial);
+    _exit(sent ? 0 : 1);
+  }
+  close(fds[1]);
+  TrialResult received;
+  bool ok = read(fds[0], &received, sizeof(received)) == sizeof(received);
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (ok && WIFEXITED(status) && WEXITSTATUS(status) == 0) result = received;
+  return result;
+}
+
+static void testScenario(int trials, uint32_t seed) {
+  int32_t worstRssi = 0, worstLatency = 0, worstHeapWarn = 0, worstHeapCrit = 0;
+  int64_t sumRssi = 0, sumLatency = 0, sumHeapWarn = 0, sumHeapCrit = 0;
+  int missed = 0;
+  uint32_t falseAlarms = 0, spikeWarnings = 0, earlyNotices = 0, spikeNotices = 0, spikes = 0;
+
+  for (int i = 0; i < trials; i++) {
+    TrialResult r = runTrialProcess(seed + i);
+    if (r.rssiDelay < 0 || r.latencyDelay < 0 || r.heapWarnDelay < 0 || r.heapCritDelay < 0) {
+      printf("  seed %u missed a change: rssi %d s, latency %d, heap %d s / %d s\n",
+             seed + i, r.rssiDelay, r.latencyDelay, r.heapWarnDelay, r.heapCritDelay);
+      missed++;
+      continue;
+    }
+    worstRssi = max(worstRssi, r.rssiDelay);
+    worstLatency = max(worstLatency, r.latencyDelay);
+    worstHeapWarn = max(worstHeapWarn, r.heapWarnDelay);
+    worstHeapCrit = max(worstHeapCrit, r.heapCritDelay);
+    sumRssi += r.rssiDelay;
+    sumLatency += r.latencyDelay;
+    sumHeapWarn += r.heapWarnDelay;
+    sumHeapCrit += r.heapCritDelay;
+    falseAlarms += r.falseAlarms;
+    spikeWarnings += r.spikeWarnings;
+    earlyNotices += r.earlyNotices;
+    spikeNotices += r.spikeNotices;
+    spikes += r.spikes;
+  }
+  int detected = max(trials - missed, 1);
+
+  CHECK(missed == 0);
+  CHECK(falseAlarms == 0);
+  // 3-sigma steps; the baseline follows a step within ~1/alpha samples, so
+  // much smaller ones are caught only some of the time
+  CHECK(worstRssi <= 10);
+  CHECK(worstLatency <= 12);
+  // 12 KB/h is 6 KB across the 30-minute window; the fast leak is ~78 min from the floor
+  CHECK(worstHeapWarn <= 20 * 60);
+  CHECK(worstHeapCrit <= 20 * 60);
+  // Outliers are noticed, but at most once per ANOMALY_NOTICE_HOLD per signal
+  CHECK(spikeNotices > 0);
+  CHECK(spikeNotices <= (uint32_t)trials * (DURATION_S * 1000 / ANOMALY_NOTICE_HOLD + 1));
+  CHECK(earlyNotices <= (uint32_t)trials);
+  // Per-second p50s are histogram bucket midpoints, 8 ms apart around 40 ms,
+  // so two spikes a few seconds apart can add up to a CUSUM warning: about
+  // one per four hours at one RTT per second with 1% spikes
+  CHECK(spikeWarnings <= (uint32_t)trials * 2);
+
+  printf("BENCH %d trials: rssi step warning after %.1f s (worst %d), latency step after %.1f utterances (worst %d)\n",
+         trials, (double)sumRssi / detected, worstRssi, (double)sumLatency / detected, worstLatency);
+  printf("BENCH heap leak warning after %.1f min (worst %.1f), fast leak critical after %.1f min (worst %.1f)\n",
+         sumHeapWarn / 60.0 / detected, worstHeapWarn / 60.0, sumHeapCrit / 60.0 / detected, worstHeapCrit / 60.0);
+  printf("BENCH false alarms %u, notices before the step %u, rtt notices %u and warnings %u for %u spikes\n",
+         falseAlarms, earlyNotices, spikeNotices, spikeWarnings, spikes);
+}
+
+int main(int argc, char** argv) {
+  int trials = argc > 1 ? atoi(argv[1]) : 10;
+  uint32_t seed = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 0) : 1;
+
+  testDetectors();
+  testScenario(trials, seed);
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
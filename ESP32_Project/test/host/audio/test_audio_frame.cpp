@@ -0,0 +1,244 @@
+// Refcounted audio frames: shared handles over one pooled buffer, copy-on-write
+// leaving other holders' bytes alone, detach/adopt through a raw carrier,
+// the buffer back in its pool on the last release (also across threads),
+// and the WebSocket headroom kept through clones.
+#include <audio_frame.h>
+#include <resource_manager.h>
+#include <metrics_registry.h>
+#include <thread>
+#include <vector>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+static const size_t CHUNK = 4096;   // One capture chunk
+
+static size_t poolBlocksInUse() {
+  size_t used = 0;
+  for (size_t i = 0; i < getMemoryPoolCount(); i++) {
+    MemoryPoolStats st = {};
+    getMemoryPoolStats(i, st);
+    used += st.usedBlocks;
+  }
+  return used;
+}
+
+static AudioFrame pcmFrame(uint8_t seed, size_t headroom = AUDIO_FRAME_WS_HEADROOM) {
+  AudioFrame frame = AudioFrame::allocate(CHUNK, headroom);
+  uint8_t* pcm = frame.mutableData();
+  for (size_t i = 0; i < CHUNK; i++) pcm[i] = (uint8_t)(seed + i);
+  frame.setLength(CHUNK);
+  return frame;
+}
+
+static bool holdsPattern(const AudioFrame& frame, uint8_t seed) {
+  if (frame.length() != CHUNK) return false;
+  for (size_t i = 0; i < CHUNK; i++) {
+    if (frame.data()[i] != (uint8_t)(seed + i)) return false;
+  }
+  return true;
+}
+
+// =============================================================================
+// SHARING AND RELEASE
+// =============================================================================
+
+static void testShareAndRelease() {
+  size_t blocksBefore = poolBlocksInUse();
+  AudioFrameStats before = getAudioFrameStats();
+
+  AudioFrame capture = pcmFrame(1);
+  CHECK(capture.isValid() && !capture.isShared());
+  CHECK(poolBlocksInUse() == blocksBefore + 1);   // A capture chunk plus headroom fits a pool block
+
+  {
+    AudioFrame tap = capture;          // Copies share the buffer
+    AudioFrame transport;
+    transport = capture;
+    CHECK(capture.isShared() && tap.isShared());
+    CHECK(tap.data() == capture.data() && transport.data() == capture.data());
+    CHECK(poolBlocksInUse() == blocksBefore + 1);
+
+    transport = tap;                   // Same buffer: no change in count
+    AudioFrame moved = static_cast<AudioFrame&&>(transport);
+    CHECK(!transport.isValid() && moved.data() == capture.data());
+    CHECK(getAudioFrameStats().shares - before.shares == 2);
+  }
+  CHECK(!capture.isShared());
+  CHECK(poolBlocksInUse() == blocksBefore + 1);
+
+  // Last holder gone: the block is free again
+  AudioFrame last = static_cast<AudioFrame&&>(capture);
+  last.release();
+  CHECK(!last.isValid() && last.data() == nullptr && last.length() == 0);
+  CHECK(poolBlocksInUse() == blocksBefore);
+  last.release();   // Releasing an empty handle is a no-op
+
+  AudioFrameStats after = getAudioFrameStats();
+  CHECK(after.allocated - before.allocated == 1);
+  CHECK(after.cowCopies == before.cowCopies && after.bytesCopied == before.bytesCopied);
+}
+
+// =============================================================================
+// COPY-ON-WRITE
+// =============================================================================
+
+static void testCopyOnWrite() {
+  size_t blocksBefore = poolBlocksInUse();
+  AudioFrameStats before = getAudioFrameStats();
+
+  AudioFrame capture = pcmFrame(7);
+  AudioFrame dsp = capture;
+  const uint8_t* shared = capture.data();
+
+  // The writer gets its own buffer; the reader keeps the original bytes
+  uint8_t* gain = dsp.mutableData();
+  CHECK(gain != nullptr && gain != shared);
+  for (size_t i = 0; i < CHUNK; i++) gain[i] = (uint8_t)(gain[i] * 2);
+  CHECK(holdsPattern(capture, 7));
+  CHECK(capture.data() == shared && !capture.isShared() && !dsp.isShared());
+  CHECK(dsp.length() == CHUNK && dsp.data()[1] == (uint8_t)(2 * 8));
+  CHECK(poolBlocksInUse() == blocksBefore + 2);
+
+  AudioFrameStats cow = getAudioFrameStats();
+  CHECK(cow.cowCopies - before.cowCopies == 1);
+  CHECK(cow.bytesCopied - before.bytesCopied == CHUNK);
+
+  // Exclusive handles write in place
+  CHECK(dsp.mutableData() == gain);
+  CHECK(capture.mutableData() == shared);
+  CHECK(getAudioFrameStats().cowCopies == cow.cowCopies);
+
+  // setLength() is a write too
+  AudioFrame trimmed = capture;
+  CHECK(trimmed.setLength(CHUNK / 2));
+  CHECK(trimmed.data() != shared && trimmed.length() == CHUNK / 2);
+  CHECK(capture.length() == CHUNK);
+  CHECK(!trimmed.setLength(CHUNK + 1));   // Beyond capacity
+  CHECK(trimmed.length() == CHUNK / 2);
+
+  capture.release();
+  dsp.release();
+  trimmed.release();
+  CHECK(poolBlocksInUse() == blocksBefore);
+}
+
+// =============================================================================
+// HEADROOM
+// =============================================================================
+
+static void testHeadroom() {
+  AudioFrame frame = pcmFrame(3);
+  CHECK(frame.headroom() == AUDIO_FRAME_WS_HEADROOM && frame.capacity() == CHUNK);
+
+  // The transport frames in front of the payload without moving it
+  uint8_t* header = frame.mutableHeadroom();
+  CHECK(header + AUDIO_FRAME_WS_HEADROOM == frame.data());
+  memset(header, 0x81, AUDIO_FRAME_WS_HEADROOM);
+  CHECK(holdsPattern(frame, 3));
+
+  // A clone keeps headroom, capacity and length; the payload is copied
+  AudioFrame reader = frame;
+  uint8_t* cloneHeader = frame.mutableHeadroom();
+  CHECK(cloneHeader != header);
+  CHECK(frame.headroom() == AUDIO_FRAME_WS_HEADROOM && frame.capacity() == CHUNK);
+  CHECK(cloneHeader + AUDIO_FRAME_WS_HEADROOM == frame.data());
+  CHECK(holdsPattern(frame, 3) && holdsPattern(reader, 3));
+  CHECK(reader.mutableHeadroom() == header);   // Now exclusive: in place
+
+  // No headroom asked for: the payload starts right after the header struct
+  AudioFrame bare = AudioFrame::allocate(64);
+  CHECK(bare.headroom() == 0 && bare.mutableHeadroom() == bare.data());
+}
+
+// =============================================================================
+// DETACH AND ADOPT
+// =============================================================================
+
+// The event bus carries frames as raw buffer pointers in fixed-size events
+static void testDetachAdopt() {
+  size_t blocksBefore = poolBlocksInUse();
+
+  AudioFrame capture = pcmFrame(9);
+  AudioFrame kept = capture;
+  AudioFrameBuffer* carried = capture.detach();
+  CHECK(!capture.isValid() && carried != nullptr);
+  CHECK(kept.isShared());   // The carrier still holds its reference
+  CHECK(AudioFrame().detach() == nullptr);
+
+  AudioFrame received = AudioFrame::adopt(carried);
+  CHECK(received.data() == kept.data() && holdsPattern(received, 9));
+  kept.release();
+  CHECK(!received.isShared() && poolBlocksInUse() == blocksBefore + 1);
+  received.release();
+  CHECK(poolBlocksInUse() == blocksBefore);
+
+  // Fan-out: one frame, one carried reference per consumer task; whichever
+  // consumer finishes last returns the block
+  const int CONSUMERS = 4;
+  const int FRAMES = 2000;
+  std::atomic<int> corrupt(0);
+  AudioFrameStats before = getAudioFrameStats();
+  for (int n = 0; n < FRAMES; n++) {
+    AudioFrame frame = pcmFrame((uint8_t)n);
+    AudioFrameBuffer* refs[CONSUMERS];
+    for (AudioFrameBuffer*& ref : refs) {
+      AudioFrame copy = frame;
+      ref = copy.detach();
+    }
+    frame.release();
+
+    std::vector<std::thread> consumers;
+    for (AudioFrameBuffer* ref : refs) {
+      consumers.emplace_back([ref, n, &corrupt] {
+        AudioFrame mine = AudioFrame::adopt(ref);
+        if (!holdsPattern(mine, (uint8_t)n)) corrupt++;
+      });
+    }
+    for (std::thread& t : consumers) t.join();
+  }
+  AudioFrameStats after = getAudioFrameStats();
+  CHECK(corrupt == 0);
+  CHECK(poolBlocksInUse() == blocksBefore);
+  CHECK(after.cowCopies == before.cowCopies);
+  CHECK(after.allocated - before.allocated == FRAMES);
+
+  printf("BENCH fan-out to %d consumers, %d frames: %u bytes copied (%u with a copy per consumer)\n",
+         CONSUMERS, FRAMES, after.bytesCopied - before.bytesCopied,
+         (unsigned)(CONSUMERS * FRAMES * CHUNK));
+}
+
+// =============================================================================
+// FAILURES
+// =============================================================================
+
+static void testAllocateFailures() {
+  uint32_t failures = getAudioFrameStats().allocFailures;
+  CHECK(!AudioFrame::allocate(0));
+  CHECK(!AudioFrame::allocate(CHUNK, UINT16_MAX + 1));
+  CHECK(getAudioFrameStats().allocFailures == failures + 2);
+
+  AudioFrame empty;
+  CHECK(empty.mutableData() == nullptr && empty.mutableHeadroom() == nullptr);
+  CHECK(!empty.setLength(0) && !empty.isShared());
+}
+
+int main() {
+  initMetricsRegistry();
+  initResourceManager();
+  testShareAndRelease();
+  testCopyOnWrite();
+  testHeadroom();
+  testDetachAdopt();
+  testAllocateFailures();
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
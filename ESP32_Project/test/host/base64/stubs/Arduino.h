@@ -0,0 +1,8 @@
+#pragma once
+// Arduino core stand-in for the codec host test: the codec needs only the C types
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+using std::min;
+using std::max;
@@ -0,0 +1,460 @@
+// Base64 codec: differential checks against the legacy websocket_audio.cpp
+// codec, OpenSSL and a reference decoder for the documented semantics;
+// fuzzing over hostile input with every flag combination; throughput
+#include <encoding_service.h>
+#include <openssl/evp.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+typedef std::vector<uint8_t> Bytes;
+
+static const char* STANDARD = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// =============================================================================
+// BASELINES
+// =============================================================================
+
+// The codec websocket_audio.cpp used, String replaced by std::string
+static std::string legacyEncode(const uint8_t* data, size_t length) {
+  std::string result;
+  int i = 0;
+  uint8_t in[3], out[4];
+  while (length--) {
+    in[i++] = *(data++);
+    if (i == 3) {
+      out[0] = (in[0] & 0xfc) >> 2;
+      out[1] = ((in[0] & 0x03) << 4) + ((in[1] & 0xf0) >> 4);
+      out[2] = ((in[1] & 0x0f) << 2) + ((in[2] & 0xc0) >> 6);
+      out[3] = in[2] & 0x3f;
+      for (i = 0; i < 4; i++) result += STANDARD[out[i]];
+      i = 0;
+    }
+  }
+  if (i) {
+    for (int j = i; j < 3; j++) in[j] = '\0';
+    out[0] = (in[0] & 0xfc) >> 2;
+    out[1] = ((in[0] & 0x03) << 4) + ((in[1] & 0xf0) >> 4);
+    out[2] = ((in[1] & 0x0f) << 2) + ((in[2] & 0xc0) >> 6);
+    for (int j = 0; j < i + 1; j++) result += STANDARD[out[j]];
+    while (i++ < 3) result += '=';
+  }
+  return result;
+}
+
+static Bytes legacyDecode(const std::string& text) {
+  int length = text.length(), i = 0, pos = 0;
+  uint8_t in[4], out[3];
+  Bytes result;
+  auto isBase64 = [](unsigned char c) { return isalnum(c) || c == '+' || c == '/'; };
+  while (length-- && text[pos] != '=' && isBase64(text[pos])) {
+    in[i++] = text[pos++];
+    if (i == 4) {
+      for (i = 0; i < 4; i++) in[i] = strchr(STANDARD, in[i]) - STANDARD;
+      out[0] = (in[0] << 2) + ((in[1] & 0x30) >> 4);
+      out[1] = ((in[1] & 0xf) << 4) + ((in[2] & 0x3c) >> 2);
+      out[2] = ((in[2] & 0x3) << 6) + in[3];
+      result.insert(result.end(), out, out + 3);
+      i = 0;
+    }
+  }
+  if (i) {
+    for (int j = i; j < 4; j++) in[j] = 'A';
+    for (int j = 0; j < 4; j++) in[j] = strchr(STANDARD, in[j]) - STANDARD;
+    out[0] = (in[0] << 2) + ((in[1] & 0x30) >> 4);
+    out[1] = ((in[1] & 0xf) << 4) + ((in[2] & 0x3c) >> 2);
+    result.insert(result.end(), out, out + i - 1);
+  }
+  return result;
+}
+
+// Byte-at-a-time table codec, the structure of mbedtls_base64_*
+static uint8_t byteTable[256];
+
+static size_t byteEncode(const uint8_t* s, size_t n, char* d) {
+  char* p = d;
+  size_t i;
+  for (i = 0; i + 3 <= n; i += 3) {
+    uint8_t a = s[i], b = s[i + 1], c = s[i + 2];
+    *p++ = STANDARD[a >> 2];
+    *p++ = STANDARD[((a & 3) << 4) | (b >> 4)];
+    *p++ = STANDARD[((b & 15) << 2) | (c >> 6)];
+    *p++ = STANDARD[c & 63];
+  }
+  if (i < n) {
+    uint8_t a = s[i], b = i + 1 < n ? s[i + 1] : 0;
+    *p++ = STANDARD[a >> 2];
+    *p++ = STANDARD[((a & 3) << 4) | (b >> 4)];
+    *p++ = i + 1 < n ? STANDARD[(b & 15) << 2] : '=';
+    *p++ = '=';
+  }
+  *p = 0;
+  return p - d;
+}
+
+static size_t byteDecode(const char* s, size_t n, uint8_t* d) {
+  uint32_t x = 0;
+  int k = 0, pad = 0;
+  uint8_t* p = d;
+  for (size_t i = 0; i < n; i++) {
+    unsigned char c = s[i];
+    if (c == '=') {
+      pad++;
+      x <<= 6;
+    } else {
+      if (byteTable[c] == 0xFF) return (size_t)-1;
+      x = (x << 6) | byteTable[c];
+    }
+    if (++k == 4) {
+      *p++ = x >> 16;
+      if (pad < 2) *p++ = x >> 8;
+      if (pad < 1) *p++ = x;
+      k = 0;
+      x = 0;
+    }
+  }
+  return p - d;
+}
+
+// Reference decoder for the semantics documented in encoding_service.h
+static bool referenceDecode(const std::string& text, uint8_t flags, Bytes& out) {
+  std::string alphabet = (flags & BASE64_URL) ? std::string(STANDARD, 62) + "-_" : std::string(STANDARD);
+  std::string chars;
+  size_t pads = 0;
+  for (char c : text) {
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+      if (flags & BASE64_WHITESPACE) continue;
+      return false;
+    }
+    if (c == '=') {
+      pads++;
+      continue;
+    }
+    if (pads || alphabet.find(c) == std::string::npos) return false;
+    chars += c;
+  }
+  size_t rem = chars.size() % 4;
+  if (rem == 1) return false;
+  if (pads) {
+    if (rem == 0 || rem + pads != 4) return false;
+  } else if (rem && !(flags & BASE64_NO_PAD)) {
+    return false;
+  }
+
+  out.clear();
+  uint32_t x = 0;
+  int k = 0;
+  for (char c : chars) {
+    x = (x << 6) | alphabet.find(c);
+    if (++k == 4) {
+      out.push_back(x >> 16);
+      out.push_back(x >> 8);
+      out.push_back(x);
+      x = 0;
+      k = 0;
+    }
+  }
+  if (k) {
+    x <<= 6 * (4 - k);
+    out.push_back(x >> 16);
+    if (k == 3) out.push_back(x >> 8);
+  }
+  return true;
+}
+
+// =============================================================================
+// HELPERS
+// =============================================================================
+
+static std::mt19937 rng(1234);
+
+static Bytes randomBytes(size_t n) {
+  Bytes bytes(n);
+  for (uint8_t& b : bytes) b = rng();
+  return bytes;
+}
+
+static std::string encode(const Bytes& data, uint8_t flags) {
+  std::string text(base64EncodedLength(data.size(), flags) + 1, 'X');
+  size_t n = 0;
+  CHECK(base64Encode(data.data(), data.size(), &text[0], text.size(), &n, flags));
+  CHECK(n == text.size() - 1 && text[n] == 0);
+  text.resize(n);
+  return text;
+}
+
+static bool decode(const std::string& text, uint8_t flags, Bytes& out) {
+  out.assign(base64DecodedLength(text.size()) + 1, 0);
+  size_t n = 0;
+  bool ok = base64Decode(text.data(), text.size(), out.data(), out.size(), &n, flags);
+  out.resize(ok ? n : 0);
+  return ok;
+}
+
+// One character at a time through the streaming decoder
+static bool streamDecode(const std::string& text, uint8_t flags, Bytes& out) {
+  Base64Stream stream;
+  base64StreamBegin(stream, flags);
+  out.clear();
+  bool ok = true;
+  for (char c : text) {
+    uint8_t bytes[3];
+    size_t n = 0;
+    ok = base64DecodeUpdate(stream, &c, 1, bytes, sizeof(bytes), &n) && ok;
+    out.insert(out.end(), bytes, bytes + n);
+  }
+  uint8_t bytes[3];
+  size_t n = 0;
+  ok = base64DecodeFinish(stream, bytes, sizeof(bytes), &n) && ok;
+  out.insert(out.end(), bytes, bytes + n);
+  return ok;
+}
+
+// MB/s of input over at least 0.3 s
+template <typename F>
+static double throughput(size_t bytes, F codec) {
+  int iterations = 0;
+  double elapsed = 0;
+  auto start = std::chrono::steady_clock::now();
+  do {
+    codec();
+    iterations++;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  } while (elapsed < 0.3);
+  return bytes * (double)iterations / elapsed / 1e6;
+}
+static volatile size_t sink;
+
+// =============================================================================
+// TESTS
+// =============================================================================
+
+// Identical to the legacy codec and OpenSSL at every size and alignment
+static void testEncode() {
+  for (size_t n = 0; n < 600; n++) {
+    for (size_t offset = 0; offset < 4; offset++) {
+      Bytes buffer = randomBytes(n + 8);
+      const uint8_t* p = buffer.data() + offset;
+      std::string ours = encode(Bytes(p, p + n), 0);
+      CHECK(ours == legacyEncode(p, n));
+      Bytes openssl(n * 2 + 8);
+      int length = EVP_EncodeBlock(openssl.data(), p, n);
+      CHECK(ours == std::string((char*)openssl.data(), length));
+
+      std::vector<char> out(ours.size() + 8);
+      size_t k = 0;
+      CHECK(base64Encode(p, n, out.data() + (n % 4), ours.size() + 1, &k));
+      CHECK(std::string(out.data() + (n % 4), k) == ours);
+    }
+  }
+}
+
+// Canonical input through every decoder, in place, streamed at every split;
+// URL-safe, unpadded and line-wrapped forms
+static void testDecode() {
+  for (size_t n = 0; n < 600; n++) {
+    Bytes data = randomBytes(n), out;
+    std::string text = encode(data, 0);
+    CHECK(decode(text, 0, out) && out == data);
+    CHECK(legacyDecode(text) == data);
+    Bytes openssl(text.size() + 4);
+    int length = EVP_DecodeBlock(openssl.data(), (const uint8_t*)text.data(), text.size());
+    size_t pads = std::count(text.begin(), text.end(), '=');
+    CHECK(length - pads == n && memcmp(openssl.data(), data.data(), n) == 0);
+    Bytes bytes(text.size() + 1);
+    CHECK(byteDecode(text.data(), text.size(), bytes.data()) == n && memcmp(bytes.data(), data.data(), n) == 0);
+
+    for (size_t offset = 0; offset < 4; offset++) {
+      std::string buffer = std::string(offset, '#') + text;
+      size_t k = 0;
+      CHECK(base64DecodeInPlace(&buffer[offset], text.size(), &k) && k == n);
+      CHECK(memcmp(&buffer[offset], data.data(), n) == 0);
+    }
+
+    Base64Stream stream;
+    base64StreamBegin(stream);
+    Bytes streamed;
+    for (size_t pos = 0; pos < text.size();) {
+      size_t step = std::min<size_t>(1 + rng() % 23, text.size() - pos);
+      uint8_t piece[64];
+      size_t k = 0;
+      CHECK(base64DecodeUpdate(stream, text.data() + pos, step, piece, sizeof(piece), &k));
+      streamed.insert(streamed.end(), piece, piece + k);
+      pos += step;
+    }
+    uint8_t tail[4];
+    size_t k = 0;
+    CHECK(base64DecodeFinish(stream, tail, sizeof(tail), &k));
+    streamed.insert(streamed.end(), tail, tail + k);
+    CHECK(streamed == data);
+
+    base64StreamBegin(stream);
+    std::string encoded;
+    for (size_t pos = 0; pos < n;) {
+      size_t step = std::min<size_t>(1 + rng() % 29, n - pos);
+      char piece[64];
+      encoded.append(piece, base64EncodeUpdate(stream, data.data() + pos, step, piece));
+      pos += step;
+    }
+    char last[4];
+    encoded.append(last, base64EncodeFinish(stream, last));
+    CHECK(encoded == text);
+
+    std::string url = encode(data, BASE64_URL | BASE64_NO_PAD), expected = text;
+    for (char& c : expected) c = c == '+' ? '-' : c == '/' ? '_' : c;
+    while (!expected.empty() && expected.back() == '=') expected.pop_back();
+    CHECK(url == expected);
+    CHECK(decode(url, BASE64_URL | BASE64_NO_PAD, out) && out == data);
+    if (n % 3) CHECK(!decode(url, BASE64_URL, out));
+
+    std::string wrapped;
+    for (size_t i = 0; i < text.size(); i++) {
+      wrapped += text[i];
+      if (i % 76 == 75) wrapped += "\r\n";
+      if (rng() % 50 == 0) wrapped += ' ';
+    }
+    CHECK(decode(wrapped, BASE64_WHITESPACE, out) && out == data);
+    if (wrapped != text) CHECK(!decode(wrapped, 0, out));
+  }
+}
+
+// A too-small output buffer fails and is never written past
+static void testBounds() {
+  for (size_t n = 1; n < 200; n++) {
+    Bytes data = randomBytes(n);
+    std::string text = encode(data, 0);
+    Bytes out(n + 16, 0xEE);
+    size_t k = 0;
+    CHECK(!base64Decode(text.data(), text.size(), out.data(), n - 1, &k));
+    for (size_t i = n - 1; i < out.size(); i++) CHECK(out[i] == 0xEE);
+    std::vector<char> encoded(text.size() + 1);
+    CHECK(!base64Encode(data.data(), n, encoded.data(), text.size(), &k));
+  }
+}
+
+// Random strings over a hostile alphabet with every flag combination: the
+// one-shot, in-place and streaming decoders agree with the reference; with
+// flags 0 nothing OpenSSL rejects is accepted, and accepted input decodes
+// to OpenSSL's bytes
+static void testFuzz() {
+  const char* pool = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/-_= \r\n\t.!\x80\xff";
+  size_t poolLength = strlen(pool);
+  long cases = 0, accepted = 0, legacyDiffers = 0, opensslOnly = 0;
+  for (int i = 0; i < 400000; i++) {
+    size_t n = rng() % 48;
+    bool mostlyValid = i % 2;
+    std::string text;
+    for (size_t j = 0; j < n; j++) {
+      text += mostlyValid && rng() % 16 ? STANDARD[rng() % 64] : pool[rng() % poolLength];
+    }
+    if (mostlyValid && rng() % 2) {
+      text.resize(text.size() / 4 * 4);
+      if (text.size() && rng() % 2) text.back() = '=';
+      if (text.size() > 1 && rng() % 3 == 0) text[text.size() - 2] = '=';
+    }
+    uint8_t flags = rng() % 8;
+
+    Bytes reference, ours, streamed;
+    bool referenceOk = referenceDecode(text, flags, reference);
+    bool ok = decode(text, flags, ours);
+    CHECK(ok == referenceOk);
+    if (ok && referenceOk) CHECK(ours == reference);
+
+    std::string inPlace = text;
+    size_t k = 0;
+    bool inPlaceOk = base64DecodeInPlace(&inPlace[0], inPlace.size(), &k, flags);
+    CHECK(inPlaceOk == ok);
+    if (inPlaceOk && ok) CHECK(k == ours.size() && memcmp(inPlace.data(), ours.data(), k) == 0);
+
+    bool streamOk = streamDecode(text, flags, streamed);
+    CHECK(streamOk == ok);
+    if (streamOk && ok) CHECK(streamed == ours);
+
+    if (flags == 0 && !text.empty()) {
+      Bytes openssl(text.size() + 4);
+      int length = EVP_DecodeBlock(openssl.data(), (const uint8_t*)text.data(), text.size());
+      if (ok) {
+        CHECK(length >= 0 && (size_t)length >= ours.size() && memcmp(openssl.data(), ours.data(), ours.size()) == 0);
+        if (legacyDecode(text) != ours) legacyDiffers++;
+      } else if (length >= 0) {
+        opensslOnly++;
+      }
+    }
+    cases++;
+    accepted += ok;
+  }
+  printf("BENCH fuzz: %ld cases, %ld accepted\n", cases, accepted);
+  printf("BENCH flags 0: legacy decodes %ld accepted inputs differently; OpenSSL also accepts %ld we reject\n",
+         legacyDiffers, opensslOnly);
+}
+
+static void benchmark() {
+  const size_t N = 4096;   // One PCM chunk
+  Bytes pcm = randomBytes(N);
+  std::string text = encode(pcm, 0), scratch = text;
+  std::vector<char> encoded(text.size() + 8);
+  Bytes decoded(N + 8);
+  size_t k;
+
+  struct Row {
+    const char* name;
+    double encode, decode;
+  };
+  Row rows[] = {
+    {"legacy (websocket_audio.cpp)",
+     throughput(N, [&] { sink = legacyEncode(pcm.data(), N).size(); }),
+     throughput(text.size(), [&] { sink = legacyDecode(text).size(); })},
+    {"byte loop (mbedtls structure)",
+     throughput(N, [&] { sink = byteEncode(pcm.data(), N, encoded.data()); }),
+     throughput(text.size(), [&] { sink = byteDecode(text.data(), text.size(), decoded.data()); })},
+    {"OpenSSL EVP block",
+     throughput(N, [&] { sink = EVP_EncodeBlock((uint8_t*)encoded.data(), pcm.data(), N); }),
+     throughput(text.size(), [&] { sink = EVP_DecodeBlock(decoded.data(), (const uint8_t*)text.data(), text.size()); })},
+    {"word kernel",
+     throughput(N, [&] { base64Encode(pcm.data(), N, encoded.data(), encoded.size(), &k); sink = k; }),
+     throughput(text.size(), [&] { base64Decode(text.data(), text.size(), decoded.data(), decoded.size(), &k); sink = k; })},
+    {"word kernel, unaligned out",
+     throughput(N, [&] { base64Encode(pcm.data(), N, encoded.data() + 1, encoded.size() - 1, &k); sink = k; }),
+     throughput(text.size(), [&] { base64Decode(text.data(), text.size(), decoded.data() + 1, decoded.size() - 1, &k); sink = k; })},
+    {"word kernel, in place", 0,
+     throughput(text.size(), [&] {
+       memcpy(&scratch[0], text.data(), text.size());
+       base64DecodeInPlace(&scratch[0], text.size(), &k);
+       sink = k;
+     })},
+  };
+  printf("BENCH 4 KB PCM, MB/s of input             encode   decode\n");
+  for (const Row& row : rows) {
+    char encodeText[16] = "-";
+    if (row.encode > 0) snprintf(encodeText, sizeof(encodeText), "%.0f", row.encode);
+    printf("BENCH   %-32s %7s  %7.0f\n", row.name, encodeText, row.decode);
+  }
+}
+
+int main(int argc, char** argv) {
+  memset(byteTable, 0xFF, sizeof(byteTable));
+  for (int i = 0; i < 64; i++) byteTable[(uint8_t)STANDARD[i]] = i;
+
+  testEncode();
+  testDecode();
+  testBounds();
+  testFuzz();
+  if (argc < 2 || strcmp(argv[1], "--no-bench") != 0) benchmark();
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
@@ -0,0 +1,4 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+inline void esp_fill_random(void* b, size_t n) { for (size_t i = 0; i < n; i++) ((uint8_t*)b)[i] = rand(); }
@@ -0,0 +1,33 @@
+#pragma once
+// mbedtls GCM API on OpenSSL; gcmCalls counts seal/open operations
+#include <openssl/evp.h>
+#include <cstring>
+#define MBEDTLS_CIPHER_ID_AES 2
+#define MBEDTLS_GCM_ENCRYPT 1
+extern int gcmCalls;
+typedef struct { unsigned char key[32]; } mbedtls_gcm_context;
+inline void mbedtls_gcm_init(mbedtls_gcm_context* c) { memset(c, 0, sizeof(*c)); }
+inline void mbedtls_gcm_free(mbedtls_gcm_context*) {}
+inline int mbedtls_gcm_setkey(mbedtls_gcm_context* c, int, const unsigned char* k, unsigned bits) { memcpy(c->key, k, bits / 8); return 0; }
+inline int gcmRun(bool enc, mbedtls_gcm_context* c, size_t len, const unsigned char* iv, size_t ivLen, const unsigned char* aad, size_t aadLen,
+                  const unsigned char* in, unsigned char* out, unsigned char* tag, size_t tagLen) {
+  gcmCalls++;
+  EVP_CIPHER_CTX* x = EVP_CIPHER_CTX_new(); int n, ok = 1;
+  ok &= EVP_CipherInit_ex(x, EVP_aes_256_gcm(), nullptr, nullptr, nullptr, enc);
+  ok &= EVP_CIPHER_CTX_ctrl(x, EVP_CTRL_GCM_SET_IVLEN, ivLen, nullptr);
+  ok &= EVP_CipherInit_ex(x, nullptr, nullptr, c->key, iv, enc);
+  ok &= EVP_CipherUpdate(x, nullptr, &n, aad, aadLen);
+  ok &= EVP_CipherUpdate(x, out, &n, in, len);
+  if (!enc) ok &= EVP_CIPHER_CTX_ctrl(x, EVP_CTRL_GCM_SET_TAG, tagLen, tag);
+  int f = EVP_CipherFinal_ex(x, out + n, &n); ok &= f;
+  if (enc) ok &= EVP_CIPHER_CTX_ctrl(x, EVP_CTRL_GCM_GET_TAG, tagLen, tag);
+  EVP_CIPHER_CTX_free(x); return ok ? 0 : -0x12;
+}
+inline int mbedtls_gcm_crypt_and_tag(mbedtls_gcm_context* c, int, size_t len, const unsigned char* iv, size_t ivLen, const unsigned char* aad, size_t aadLen,
+                                     const unsigned char* in, unsigned char* out, size_t tagLen, unsigned char* tag) {
+  return gcmRun(true, c, len, iv, ivLen, aad, aadLen, in, out, tag, tagLen);
+}
+inline int mbedtls_gcm_auth_decrypt(mbedtls_gcm_context* c, size_t len, const unsigned char* iv, size_t ivLen, const unsigned char* aad, size_t aadLen,
+                                    const unsigned char* tag, size_t tagLen, const unsigned char* in, unsigned char* out) {
+  return gcmRun(false, c, len, iv, ivLen, aad, aadLen, in, out, (unsigned char*)tag, tagLen);
+}
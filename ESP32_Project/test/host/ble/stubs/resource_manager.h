@@ -0,0 +1,6 @@
+#pragma once
+// Tracked allocation stand-in: counts pool allocations
+#include <cstdlib>
+extern int poolAllocs;
+#define TRACK_MALLOC(size, name) (poolAllocs++, malloc(size))
+#define TRACK_FREE(ptr, name) free(ptr)
@@ -0,0 +1,156 @@
+// BLE provisioning end to end: an app-side transport talks to the
+// provisioning service over an in-order link; credentials are parsed and
+// validated once, replayed frames from this or an earlier session never
+// provision again, and the session times out
+#include <ble_provisioning.h>
+#include <Arduino.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+uint32_t simMs = 0;
+SerialStub Serial;
+int poolAllocs = 0;
+int gcmCalls = 0;
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+#define FRAME_DATA 0x02
+
+typedef std::vector<uint8_t> Frame;
+
+static std::deque<Frame> up, down;
+static std::vector<Frame> recorded;   // App DATA frames as sent
+static std::string reply;
+static int results[8];
+static provisioning_data_t received;
+static ble_transport_t app;
+
+static bool sendUp(void*, const uint8_t* frame, size_t length) {
+  up.emplace_back(frame, frame + length);
+  if (frame[0] == FRAME_DATA) recorded.emplace_back(frame, frame + length);
+  return true;
+}
+static bool sendDown(void*, const uint8_t* frame, size_t length) {
+  down.emplace_back(frame, frame + length);
+  return true;
+}
+static void onReply(void*, const uint8_t* data, size_t length) { reply.assign((const char*)data, length); }
+static void onProvisioning(ble_provisioning_result_t result, const provisioning_data_t* data) {
+  results[result]++;
+  if (data) received = *data;
+}
+
+static void run(uint32_t ms) {
+  for (uint32_t i = 0; i < ms; i++) {
+    simMs++;
+    while (!up.empty()) {
+      Frame frame = up.front();
+      up.pop_front();
+      handleBLEProvisioningData(frame.data(), frame.size());
+    }
+    while (!down.empty()) {
+      Frame frame = down.front();
+      down.pop_front();
+      ble_transport_receive(&app, frame.data(), frame.size());
+    }
+    ble_transport_tick(&app);
+    handleBLEProvisioning();
+  }
+}
+
+static void replay(const std::vector<Frame>& frames) {
+  for (const Frame& frame : frames) {
+    Frame copy = frame;   // The handler takes a mutable buffer
+    handleBLEProvisioningData(copy.data(), copy.size());
+  }
+  run(50);
+}
+
+static void connectBoth(const uint8_t* key) {
+  connectBLEProvisioning(sendDown, nullptr, 185);
+  ble_transport_config_t config = {BLE_TRANSPORT_ROLE_APP, {}, sendUp, onReply, nullptr, nullptr};
+  memcpy(config.key, key, BLE_TRANSPORT_KEY_SIZE);
+  ble_transport_init(&app, &config);
+  ble_transport_connect(&app, 185);
+  run(10);
+}
+
+static bool sendConfig(const char* json) {
+  recorded.clear();
+  bool queued = ble_transport_send(&app, (const uint8_t*)json, strlen(json));
+  run(100);
+  return queued;
+}
+
+int main() {
+  static const uint8_t KEY[BLE_TRANSPORT_KEY_SIZE] = {9, 8, 7};
+  const char* config =
+      "{\"ssid\":\"Home\",\"password\":\"secret123\",\"child_id\":\"12345678-1234-1234-1234-123456789abc\","
+      "\"pairing_code\":\"A1-B2-C3\",\"child_age\":6}";
+
+  initBLEProvisioning();
+  CHECK(startBLEProvisioning(KEY, sizeof(KEY), onProvisioning));
+  CHECK(isBLEProvisioningActive());
+  CHECK(!startBLEProvisioning(KEY, sizeof(KEY), onProvisioning));   // Already running
+  connectBoth(KEY);
+
+  // Valid credentials: parsed, answered OK
+  CHECK(sendConfig(config));
+  CHECK(results[BLE_PROV_SUCCESS] == 1);
+  CHECK(strcmp(received.ssid, "Home") == 0 && strcmp(received.password, "secret123") == 0);
+  CHECK(strcmp(received.pairing_code, "A1-B2-C3") == 0 && received.child_age == 6);
+  CHECK(reply == BLE_RESPONSE_OK);
+  std::vector<Frame> accepted = recorded;
+
+  // Same session: the accepted message again
+  replay(accepted);
+  CHECK(results[BLE_PROV_SUCCESS] == 1);
+
+  // Invalid fields: refused, answered INVALID_CREDS
+  CHECK(sendConfig("{\"ssid\":\"\"}"));
+  CHECK(results[BLE_PROV_INVALID_DATA] == 1 && reply == BLE_RESPONSE_INVALID_CREDS);
+  CHECK(sendConfig("{\"ssid\":\"Home\",\"password\":\"secret123\",\"child_id\":\"12345678-1234-1234-1234-"
+                   "123456789abc\",\"child_age\":40}"));
+  CHECK(results[BLE_PROV_INVALID_DATA] == 2);
+  CHECK(sendConfig("not json"));
+  CHECK(results[BLE_PROV_INVALID_DATA] == 3);
+  replay(accepted);   // Older than the newest accepted message
+  CHECK(results[BLE_PROV_SUCCESS] == 1);
+
+  // Reconnect: frames sealed for the previous session are refused
+  disconnectBLEProvisioning();
+  ble_transport_reset(&app);
+  connectBoth(KEY);
+  replay(accepted);
+  CHECK(results[BLE_PROV_SUCCESS] == 1);
+  CHECK(sendConfig(config));
+  CHECK(results[BLE_PROV_SUCCESS] == 2 && reply == BLE_RESPONSE_OK);
+
+  // An app holding the wrong PoP key gets nothing through
+  static const uint8_t WRONG_KEY[BLE_TRANSPORT_KEY_SIZE] = {1};
+  disconnectBLEProvisioning();
+  ble_transport_reset(&app);
+  connectBoth(WRONG_KEY);
+  reply.clear();
+  sendConfig(config);
+  CHECK(results[BLE_PROV_SUCCESS] == 2 && reply.empty());
+
+  // Timeout stops provisioning and reports it once
+  simMs += BLE_PROVISIONING_TIMEOUT_MS;
+  run(1);
+  CHECK(results[BLE_PROV_TIMEOUT] == 1);
+  CHECK(!isBLEProvisioningActive());
+  run(10);
+  CHECK(results[BLE_PROV_TIMEOUT] == 1);
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
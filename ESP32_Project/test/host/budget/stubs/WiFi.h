@@ -0,0 +1,11 @@
+#pragma once
+// Station link state only
+#include <Arduino.h>
+
+typedef enum { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 } wl_status_t;
+
+struct WiFiStub {
+  wl_status_t linkStatus = WL_CONNECTED;
+  wl_status_t status() { return linkStatus; }
+};
+extern WiFiStub WiFi;
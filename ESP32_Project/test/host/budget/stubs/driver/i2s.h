@@ -0,0 +1,2 @@
+#pragma once
+// audio_handler.h includes the I2S driver; nothing from it is used here
@@ -0,0 +1,3 @@
+#pragma once
+// Telemetry switch the memory budget pauses; the test records the setting
+void setTelemetryPaused(bool paused);
@@ -0,0 +1,4 @@
+#pragma once
+// Realtime streaming state for the restart deferral; set by the test
+#include "audio_handler.h"
+extern "C" bool isRealtimeStreaming();
@@ -0,0 +1,3 @@
+#pragma once
+// Recovery entry point; the test counts restarts instead of rebooting
+void triggerSystemRecovery(const char* reason);
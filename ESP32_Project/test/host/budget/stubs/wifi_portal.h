@@ -0,0 +1,5 @@
+#pragma once
+// Setup portal left open after connecting; closing it returns heap
+#include <WiFi.h>
+void stopWiFiPortal();
+bool isPortalActive();
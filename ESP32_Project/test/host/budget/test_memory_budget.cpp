@@ -0,0 +1,367 @@
+// Memory budget degradation ladder: steps shed in order at the elevated and
+// critical cadences, steps without effect skipped, restore in reverse after
+// the hold period, recovery hysteresis against a heap hovering at the warn
+// level, subsystem budgets, and the deferred restart on the last rung.
+// The subsystems the steps act on are fakes below.
+#include <memory_budget.h>
+#include <metrics_registry.h>
+#include <json_arena.h>
+#include <resource_manager.h>
+#include <audio_handler.h>
+#include <monitoring.h>
+#include <realtime_audio_streamer.h>
+#include <system_monitor.h>
+#include <wifi_portal.h>
+#include <websocket_handler.h>
+#include <string>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+// =============================================================================
+// FAKE SUBSYSTEMS
+// =============================================================================
+
+WiFiStub WiFi;
+
+static bool telemetryPaused = false;
+static size_t captureChunk = AUDIO_CHUNK_SIZE;
+static size_t wsChunk = 4096;
+static size_t audioBuffer = AUDIO_BUFFER_BYTES;
+static AudioState audioState = AUDIO_IDLE;
+static bool streaming = false;
+static bool portalActive = true;
+static int restarts = 0;
+
+void setTelemetryPaused(bool paused) { telemetryPaused = paused; }
+size_t getCaptureChunkSize() { return captureChunk; }
+void setCaptureChunkSize(size_t bytes) { captureChunk = bytes; }
+size_t getAdaptiveChunkSize() { return wsChunk; }
+void setAdaptiveChunkSize(size_t bytes) { wsChunk = bytes; }
+size_t getAudioBufferSize() { return audioBuffer; }
+AudioState getAudioState() { return audioState; }
+extern "C" bool isRealtimeStreaming() { return streaming; }
+bool isPortalActive() { return portalActive; }
+void triggerSystemRecovery(const char*) { restarts++; }
+
+bool setAudioBufferSize(size_t bytes) {
+  if (audioState == AUDIO_RECORDING) return false;
+  audioBuffer = bytes;
+  return true;
+}
+
+// The portal's web server and DNS go with it
+void stopWiFiPortal() {
+  portalActive = false;
+  hostHeap.freeBytes += 9 * 1024;
+}
+
+// =============================================================================
+// HELPERS
+// =============================================================================
+
+static const size_t HEALTHY_FREE = 120 * 1024;
+static const size_t HEALTHY_BLOCK = 80 * 1024;
+
+static unsigned long now = 1000;   // 0 reads as "never" in the budget state
+static std::string budgetLog;
+
+static void check(size_t freeHeap, size_t largestBlock = HEALTHY_BLOCK) {
+  now += MEM_BUDGET_CHECK_INTERVAL;
+  evaluateMemoryBudget(freeHeap, largestBlock, now);
+}
+
+static bool stepActive(int step) {
+  return isDegradationStepActive((DegradationStep)step);
+}
+
+static int countOf(const std::string& text, const char* needle) {
+  int n = 0;
+  for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) n++;
+  return n;
+}
+
+// Healthy readings until every step is restored
+static void settle() {
+  for (int i = 0; i < 400 && (getDegradationLevel() > 0 || getMemoryPressure() != MEM_PRESSURE_NONE); i++) {
+    check(HEALTHY_FREE);
+  }
+  CHECK(getDegradationLevel() == 0 && getMemoryPressure() == MEM_PRESSURE_NONE);
+  portalActive = true;
+}
+
+// An idle arena for flush_caches to release
+static void reserveJsonArena() {
+  JsonArenaScope arena;
+  ArenaJsonDocument doc(256);
+  doc["type"] = "ping";
+}
+
+// =============================================================================
+// SHED ORDER AND CADENCE
+// =============================================================================
+
+static void testShedOrder() {
+  reserveJsonArena();
+  budgetLog.clear();
+  Serial.capture = &budgetLog;
+
+  // Elevated: one step per MEM_BUDGET_STEP_INTERVAL, first one at once
+  check(50 * 1024);
+  CHECK(getMemoryPressure() == MEM_PRESSURE_ELEVATED);
+  CHECK(getDegradationLevel() == 1 && stepActive(DEGRADE_FLUSH_CACHES));
+  CHECK(getJsonArenaStats().reservedBytes == 0);
+
+  for (int step = 1; step < DEGRADE_STEP_COUNT; step++) {
+    for (int i = 1; i < MEM_BUDGET_STEP_INTERVAL / MEM_BUDGET_CHECK_INTERVAL; i++) {
+      check(50 * 1024);
+      CHECK(getDegradationLevel() == step);
+    }
+    check(50 * 1024);
+    CHECK(getDegradationLevel() == step + 1 && stepActive(step));
+  }
+  Serial.capture = nullptr;
+
+  CHECK(telemetryPaused);
+  CHECK(captureChunk == MEM_BUDGET_CAPTURE_CHUNK && wsChunk == MEM_BUDGET_CAPTURE_CHUNK);
+  CHECK(audioBuffer == MEM_BUDGET_AUDIO_BUFFER_MIN);
+  CHECK(!portalActive);
+
+  // The log names each step in ladder order, with bytes for the ones that free
+  size_t at = 0;
+  for (int step = 0; step < DEGRADE_STEP_COUNT; step++) {
+    std::string line = std::string("shed ") + getDegradationStepName((DegradationStep)step) + " (";
+    size_t found = budgetLog.find(line, at);
+    CHECK(found != std::string::npos);
+    at = found == std::string::npos ? at : found;
+  }
+  CHECK(countOf(budgetLog, "freed ") == 3);
+  CHECK(budgetLog.find("freed 35712 bytes") != std::string::npos);   // audio_buffer 48000 -> 12288
+  CHECK(countOf(budgetLog, "limits new allocations") == 2);
+
+  CHECK(getCounterValue(findMetric(METRIC_COUNTER, "mem.steps_shed")) == DEGRADE_STEP_COUNT);
+  CHECK(getGaugeValue(findMetric(METRIC_GAUGE, "mem.degradation_level")) == DEGRADE_STEP_COUNT);
+  CHECK(getGaugeValue(findMetric(METRIC_GAUGE, "mem.pressure")) == MEM_PRESSURE_ELEVATED);
+
+  // Nothing left to shed; the heap is above the restart level
+  check(50 * 1024);
+  CHECK(getDegradationLevel() == DEGRADE_STEP_COUNT && restarts == 0);
+}
+
+// =============================================================================
+// RESTORE
+// =============================================================================
+
+static void testRestoreOrder() {
+  budgetLog.clear();
+  Serial.capture = &budgetLog;
+
+  // Leaving elevated needs the recovery margin; the hold starts there
+  check(MEM_BUDGET_FREE_WARN + MEM_BUDGET_RECOVER_MARGIN);
+  CHECK(getMemoryPressure() == MEM_PRESSURE_NONE);
+  unsigned long healthyAt = now;
+
+  // One step per hold period, most recently shed first
+  for (int step = DEGRADE_STEP_COUNT - 1; step >= 0; step--) {
+    while (now + MEM_BUDGET_CHECK_INTERVAL < healthyAt + MEM_BUDGET_RESTORE_HOLD) {
+      check(HEALTHY_FREE);
+      CHECK(getDegradationLevel() == step + 1);
+    }
+    check(HEALTHY_FREE);
+    CHECK(getDegradationLevel() == step && !stepActive(step));
+    healthyAt = now;
+  }
+  Serial.capture = nullptr;
+
+  size_t at = 0;
+  for (int step = DEGRADE_STEP_COUNT - 1; step >= 0; step--) {
+    std::string line = std::string("restored ") + getDegradationStepName((DegradationStep)step);
+    size_t found = budgetLog.find(line, at);
+    CHECK(found != std::string::npos);
+    at = found == std::string::npos ? at : found;
+  }
+
+  CHECK(!telemetryPaused);
+  CHECK(captureChunk == AUDIO_CHUNK_SIZE && wsChunk == 4096);
+  CHECK(audioBuffer == AUDIO_BUFFER_BYTES);
+  CHECK(!portalActive);   // Not reopened by a restore
+  CHECK(getCounterValue(findMetric(METRIC_COUNTER, "mem.steps_restored")) == DEGRADE_STEP_COUNT);
+  CHECK(getGaugeValue(findMetric(METRIC_GAUGE, "mem.degradation_level")) == 0);
+  settle();
+}
+
+// Pressure during the hold restarts it
+static void testRestoreHoldInterrupted() {
+  check(50 * 1024);
+  CHECK(getDegradationLevel() == 1 && stepActive(DEGRADE_PAUSE_TELEMETRY));   // No arena to flush
+
+  for (int i = 0; i < 20; i++) check(HEALTHY_FREE);
+  check(50 * 1024);   // Below warn again: the step taken now is the next one
+  CHECK(getDegradationLevel() == 2);
+  for (int i = 0; i < MEM_BUDGET_RESTORE_HOLD / MEM_BUDGET_CHECK_INTERVAL; i++) check(HEALTHY_FREE);
+  CHECK(getDegradationLevel() == 2);
+  check(HEALTHY_FREE);
+  CHECK(getDegradationLevel() == 1);
+  settle();
+}
+
+// =============================================================================
+// HYSTERESIS
+// =============================================================================
+
+// A heap hovering around the warn level: one transition in, one out
+static void testHysteresis() {
+  budgetLog.clear();
+  Serial.capture = &budgetLog;
+
+  check(MEM_BUDGET_FREE_WARN + 2048);
+  CHECK(getMemoryPressure() == MEM_PRESSURE_NONE);
+
+  const int CHECKS = 120;
+  int naiveTransitions = 0;
+  bool naiveElevated = false;
+  for (int i = 0; i < CHECKS; i++) {
+    // 58..70 KB, crossing MEM_BUDGET_FREE_WARN every few readings
+    size_t freeHeap = MEM_BUDGET_FREE_WARN + ((i * 7) % 13 - 2) * 1024;
+    bool below = freeHeap < MEM_BUDGET_FREE_WARN;
+    if (below != naiveElevated) naiveTransitions++;
+    naiveElevated = below;
+    check(freeHeap);
+    if (i >= 1) CHECK(getMemoryPressure() == MEM_PRESSURE_ELEVATED);
+  }
+  int transitions = countOf(budgetLog, "Memory pressure");
+  CHECK(transitions == 1);
+  CHECK(naiveTransitions > 20);
+  CHECK(countOf(budgetLog, "restored") == 0);
+
+  // The largest-block side has its own margin
+  check(MEM_BUDGET_FREE_WARN + MEM_BUDGET_RECOVER_MARGIN, MEM_BUDGET_LARGEST_WARN + 2048);
+  CHECK(getMemoryPressure() == MEM_PRESSURE_ELEVATED);
+  check(MEM_BUDGET_FREE_WARN + MEM_BUDGET_RECOVER_MARGIN, MEM_BUDGET_LARGEST_WARN + MEM_BUDGET_RECOVER_MARGIN / 4);
+  CHECK(getMemoryPressure() == MEM_PRESSURE_NONE);
+  CHECK(countOf(budgetLog, "Memory pressure") == 2);
+  Serial.capture = nullptr;
+
+  printf("BENCH heap hovering at the warn level, %d checks: %d pressure transitions, %d without the margin\n",
+         CHECKS, countOf(budgetLog, "Memory pressure"), naiveTransitions);
+  settle();
+}
+
+// =============================================================================
+// CRITICAL
+// =============================================================================
+
+static void testCriticalCadence() {
+  reserveJsonArena();
+  // A small largest block alone is critical; every check sheds
+  for (int step = 0; step < DEGRADE_STEP_COUNT; step++) {
+    check(HEALTHY_FREE, MEM_BUDGET_LARGEST_CRITICAL - 1);
+    CHECK(getMemoryPressure() == MEM_PRESSURE_CRITICAL);
+    CHECK(getDegradationLevel() == step + 1);
+  }
+  CHECK(getGaugeValue(findMetric(METRIC_GAUGE, "mem.pressure")) == MEM_PRESSURE_CRITICAL);
+
+  // Critical to elevated keeps the steps; elevated to none needs the margin
+  check(50 * 1024);
+  CHECK(getMemoryPressure() == MEM_PRESSURE_ELEVATED && getDegradationLevel() == DEGRADE_STEP_COUNT);
+  settle();
+}
+
+// =============================================================================
+// SUBSYSTEM BUDGETS
+// =============================================================================
+
+static void testSubsystemBudget() {
+  budgetLog.clear();
+  Serial.capture = &budgetLog;
+
+  // Healthy heap, audio over its own budget: only its step is shed
+  void* audio = trackMalloc(MEM_BUDGET_AUDIO_TRACKED + 1024, "audio_buffer");
+  check(HEALTHY_FREE);
+  CHECK(getMemoryPressure() == MEM_PRESSURE_NONE);
+  CHECK(getDegradationLevel() == 1 && stepActive(DEGRADE_SHRINK_AUDIO_BUFFER));
+  CHECK(audioBuffer == MEM_BUDGET_AUDIO_BUFFER_MIN);
+  CHECK(budgetLog.find("audio over budget") != std::string::npos);
+
+  // Not restored while still over budget
+  for (int i = 0; i < 2 * MEM_BUDGET_RESTORE_HOLD / MEM_BUDGET_CHECK_INTERVAL; i++) check(HEALTHY_FREE);
+  CHECK(stepActive(DEGRADE_SHRINK_AUDIO_BUFFER));
+
+  trackFree(audio);
+  for (int i = 0; i <= MEM_BUDGET_RESTORE_HOLD / MEM_BUDGET_CHECK_INTERVAL && getDegradationLevel() > 0; i++) {
+    check(HEALTHY_FREE);
+  }
+  CHECK(!stepActive(DEGRADE_SHRINK_AUDIO_BUFFER) && audioBuffer == AUDIO_BUFFER_BYTES);
+  Serial.capture = nullptr;
+  settle();
+}
+
+// =============================================================================
+// RESTART
+// =============================================================================
+
+static void testRestartDeferred() {
+  budgetLog.clear();
+  Serial.capture = &budgetLog;
+
+  // Recording: audio_buffer cannot shrink, the portal is closed already
+  portalActive = false;
+  audioState = AUDIO_RECORDING;
+  const size_t exhausted = MEM_BUDGET_RESTART_FREE - 4096;
+  check(exhausted);
+  check(exhausted);
+  CHECK(getDegradationLevel() == 2);   // pause_telemetry, cap_audio_chunks
+  check(exhausted);
+  CHECK(budgetLog.find("nothing left to shed") != std::string::npos);
+  unsigned long exhaustedAt = now;
+
+  while (now + MEM_BUDGET_CHECK_INTERVAL < exhaustedAt + MEM_BUDGET_RESTART_GRACE) check(exhausted);
+  CHECK(restarts == 0);
+  check(exhausted);
+  CHECK(restarts == 0);   // Mid-conversation: deferred
+  for (int i = 0; i < 5; i++) check(exhausted);
+  CHECK(countOf(budgetLog, "Restart deferred") == 1);
+
+  // Below the hard floor a conversation does not hold it off
+  check(MEM_BUDGET_HARD_FLOOR - 1024);
+  CHECK(restarts == 1);
+
+  // Conversation over: shrink_audio_buffer takes effect, then a fresh grace
+  restarts = 0;
+  audioState = AUDIO_IDLE;
+  check(exhausted);
+  CHECK(getDegradationLevel() == 3);
+  check(exhausted);
+  exhaustedAt = now;
+  while (now + MEM_BUDGET_CHECK_INTERVAL < exhaustedAt + MEM_BUDGET_RESTART_GRACE) check(exhausted);
+  CHECK(restarts == 0);
+  check(exhausted);
+  CHECK(restarts == 1);
+  Serial.capture = nullptr;
+
+  restarts = 0;
+  settle();
+}
+
+int main() {
+  initMetricsRegistry();
+  initResourceManager();
+  CHECK(initMemoryBudget());
+  testShedOrder();
+  testRestoreOrder();
+  testRestoreHoldInterrupted();
+  testHysteresis();
+  testCriticalCadence();
+  testSubsystemBudget();
+  testRestartDeferred();
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
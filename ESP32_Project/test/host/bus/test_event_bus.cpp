@@ -0,0 +1,342 @@
+// Event bus: strict priority with publish order inside a priority, the
+// dispatch budget, DROP_OLDEST and DROP_NEWEST overflow (dropped frame shares
+// released to the pool), per-subscriber fan-out, and dispatch latency, both
+// as recorded in bus.dispatch_latency and across two host threads.
+// Events are stamped with micros(); each publish advances the simulated clock
+// by one, so publishedUs doubles as a sequence number.
+#include <event_bus.h>
+#include <metrics_registry.h>
+#include <resource_manager.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+struct Delivery {
+  EventType type;
+  uint32_t seq;
+};
+
+static std::vector<Delivery> ordered;     // "order" subscriber
+static std::vector<Delivery> overflowed;  // "overflow" subscriber
+static std::vector<AudioFrame> keptFrames;
+
+static void onOrdered(const Event& event) {
+  ordered.push_back({event.type, event.publishedUs});
+}
+
+static char lastText[EVENT_TEXT_CAPACITY + 1];
+
+static void onOverflowed(const Event& event) {
+  overflowed.push_back({event.type, event.publishedUs});
+  if (event.type == EVENT_AUTH_REFRESH_REQUEST) strlcpy(lastText, event.text, sizeof(lastText));
+  if (event.type == EVENT_AUDIO_CHUNK) keptFrames.push_back(eventFrame(event));
+}
+
+static EventSubscriberId orderSub = EVENT_SUBSCRIBER_INVALID;
+static EventSubscriberId overflowSub = EVENT_SUBSCRIBER_INVALID;
+
+static uint32_t tick() {
+  return (uint32_t)++simUs;
+}
+
+static size_t poolBlocksInUse() {
+  size_t used = 0;
+  for (size_t i = 0; i < getMemoryPoolCount(); i++) {
+    MemoryPoolStats st = {};
+    getMemoryPoolStats(i, st);
+    used += st.usedBlocks;
+  }
+  return used;
+}
+
+// Captured PCM: one chunk, no headroom
+static AudioFrame chunk() {
+  AudioFrame frame = AudioFrame::allocate(4096);
+  frame.setLength(4096);
+  return frame;
+}
+
+static void drainAll() {
+  while (dispatchEvents(orderSub) > 0) {}
+  while (dispatchEvents(overflowSub) > 0) {}
+  ordered.clear();
+  overflowed.clear();
+  keptFrames.clear();
+}
+
+static uint32_t droppedTotal() {
+  return getCounterValue(findMetric(METRIC_COUNTER, "bus.dropped"));
+}
+
+// =============================================================================
+// REGISTRATION AND ROUTING
+// =============================================================================
+
+static void testRouting() {
+  // Nobody listens yet
+  tick();
+  CHECK(!publishEvent(EVENT_WS_CONNECTED));
+
+  orderSub = registerEventSubscriber("order");
+  overflowSub = registerEventSubscriber("overflow");
+  CHECK(orderSub == 0 && overflowSub == 1);
+  for (int t = 0; t < EVENT_TYPE_COUNT; t++) {
+    CHECK(subscribeEvent(orderSub, (EventType)t, onOrdered));
+  }
+  CHECK(subscribeEvent(overflowSub, EVENT_AUDIO_CHUNK, onOverflowed));
+  CHECK(subscribeEvent(overflowSub, EVENT_AUTH_REFRESH_REQUEST, onOverflowed));
+  CHECK(!subscribeEvent(5, EVENT_WS_CONNECTED, onOrdered));
+  CHECK(!subscribeEvent(orderSub, EVENT_TYPE_COUNT, onOrdered));
+
+  // Payloads must match the type
+  AudioFrame frame = chunk();
+  CHECK(!publishEvent(EVENT_AUDIO_CHUNK));
+  CHECK(!publishEvent(EVENT_AUDIO_CHUNK, "text"));
+  CHECK(!publishEvent(EVENT_WS_CONNECTED, frame));
+  CHECK(!publishEvent(EVENT_AUDIO_CHUNK, AudioFrame()));
+  CHECK(!publishEvent(EVENT_TYPE_COUNT));
+  CHECK(dispatchEvents(orderSub) == 0 && dispatchEvents(overflowSub) == 0);
+  CHECK(dispatchEvents(EVENT_SUBSCRIBER_INVALID) == 0);
+
+  // Long text is cut to the event's capacity
+  char proof[2 * EVENT_TEXT_CAPACITY];
+  memset(proof, 'p', sizeof(proof) - 1);
+  proof[sizeof(proof) - 1] = '\0';
+  tick();
+  CHECK(publishEvent(EVENT_AUTH_REFRESH_REQUEST, proof));
+  CHECK(dispatchEvents(overflowSub) == 1);
+  CHECK(strlen(lastText) == EVENT_TEXT_CAPACITY - 1 && lastText[0] == 'p');
+  drainAll();
+}
+
+// =============================================================================
+// ORDERING
+// =============================================================================
+
+static void testOrdering() {
+  AnomalyPayload anomaly = {};
+  AudioFrame frame = chunk();
+
+  uint32_t l1 = tick(); publishEvent(EVENT_HEALTH_ANOMALY, anomaly);
+  uint32_t n1 = tick(); publishEvent(EVENT_AUDIO_CHUNK, frame);
+  uint32_t h1 = tick(); publishEvent(EVENT_WS_CONNECTED);
+  uint32_t n2 = tick(); publishEvent(EVENT_AUDIO_CHUNK, frame);
+  uint32_t l2 = tick(); publishEvent(EVENT_HEALTH_ANOMALY, anomaly);
+  uint32_t h2 = tick(); publishEvent(EVENT_AUTH_REFRESH_REQUEST, "proof");
+  uint32_t h3 = tick(); publishEvent(EVENT_WS_DISCONNECTED);
+  uint32_t n3 = tick(); publishEvent(EVENT_AUDIO_CHUNK, frame, EVENT_FLAG_FINAL);
+
+  // The budget caps one call; high drains first, in publish order
+  CHECK(dispatchEvents(orderSub, 4) == 4);
+  CHECK(ordered.size() == 4);
+
+  // A high event published now overtakes the pending normal and low ones
+  uint32_t h4 = tick();
+  publishEvent(EVENT_WS_CONNECTED);
+  CHECK(dispatchEvents(orderSub) == 5);
+  CHECK(dispatchEvents(orderSub) == 0);
+
+  const uint32_t expected[] = {h1, h2, h3, n1, h4, n2, n3, l1, l2};
+  CHECK(ordered.size() == sizeof(expected) / sizeof(expected[0]));
+  for (size_t i = 0; i < ordered.size() && i < sizeof(expected) / sizeof(expected[0]); i++) {
+    CHECK(ordered[i].seq == expected[i]);
+  }
+  CHECK(ordered.size() > 2 && ordered[1].type == EVENT_AUTH_REFRESH_REQUEST);
+
+  // The overflow subscriber only saw its types, by the same rules
+  CHECK(dispatchEvents(overflowSub) == 4);
+  CHECK(overflowed.size() == 4 && overflowed[0].seq == h2 && overflowed[1].seq == n1);
+  CHECK(overflowed.size() == 4 && overflowed[2].seq == n2 && overflowed[3].seq == n3);
+  drainAll();
+}
+
+// =============================================================================
+// OVERFLOW
+// =============================================================================
+
+static void testOverflow() {
+  size_t blocksBefore = poolBlocksInUse();
+  uint32_t droppedBefore = droppedTotal();
+
+  // DROP_OLDEST (audio): the newest EVENT_QUEUE_DEPTH_NORMAL chunks survive,
+  // the evicted events give their frame shares back. More chunks than the
+  // PCM pool holds: the rest spill to the heap.
+  const int CHUNKS = EVENT_QUEUE_DEPTH_NORMAL + 4;
+  const int EVICTED = CHUNKS - EVENT_QUEUE_DEPTH_NORMAL;
+  std::vector<AudioFrame> published;
+  std::vector<uint32_t> seqs;
+  for (int i = 0; i < CHUNKS; i++) {
+    published.push_back(chunk());
+    seqs.push_back(tick());
+    CHECK(publishEvent(EVENT_AUDIO_CHUNK, published.back()));
+  }
+  for (int i = 0; i < CHUNKS; i++) {
+    CHECK(published[i].isShared() == (i >= EVICTED));   // Evicted: the publisher's handle is the last
+  }
+  CHECK(droppedTotal() - droppedBefore == 2 * EVICTED);
+
+  CHECK(dispatchEvents(overflowSub, 255) == EVENT_QUEUE_DEPTH_NORMAL);
+  CHECK(overflowed.size() == EVENT_QUEUE_DEPTH_NORMAL);
+  for (size_t i = 0; i < overflowed.size(); i++) {
+    CHECK(overflowed[i].seq == seqs[CHUNKS - EVENT_QUEUE_DEPTH_NORMAL + i]);
+  }
+  // eventFrame() shares outlive the handler; the queued copies are released
+  CHECK(keptFrames.size() == EVENT_QUEUE_DEPTH_NORMAL && keptFrames[0].length() == 4096);
+  while (dispatchEvents(orderSub) > 0) {}
+  CHECK(published[EVICTED].isShared());
+  keptFrames.clear();
+  for (const AudioFrame& frame : published) CHECK(!frame.isShared());
+  published.clear();
+  CHECK(poolBlocksInUse() == blocksBefore);
+
+  // DROP_NEWEST (refresh requests): the pending ones stay, late ones are refused
+  droppedBefore = droppedTotal();
+  ordered.clear();
+  std::vector<uint32_t> proofs;
+  for (int i = 0; i < EVENT_QUEUE_DEPTH_HIGH + 2; i++) {
+    proofs.push_back(tick());
+    CHECK(publishEvent(EVENT_AUTH_REFRESH_REQUEST, "proof") == (i < EVENT_QUEUE_DEPTH_HIGH));
+  }
+  CHECK(droppedTotal() - droppedBefore == 2 * 2);
+  CHECK(dispatchEvents(orderSub) == EVENT_QUEUE_DEPTH_HIGH);
+  for (size_t i = 0; i < ordered.size(); i++) CHECK(ordered[i].seq == proofs[i]);
+
+  // High queue full does not block lower priorities
+  drainAll();
+  for (int i = 0; i < EVENT_QUEUE_DEPTH_HIGH; i++) {
+    tick();
+    publishEvent(EVENT_WS_CONNECTED);
+  }
+  tick();
+  CHECK(publishEvent(EVENT_AUDIO_CHUNK, chunk()));
+  drainAll();
+  CHECK(poolBlocksInUse() == blocksBefore);
+}
+
+// =============================================================================
+// DISPATCH LATENCY
+// =============================================================================
+
+// Simulated waits between publish and dispatch, read back from the histogram
+static void testRecordedLatency() {
+  MetricId latency = findMetric(METRIC_HISTOGRAM, "bus.dispatch_latency");
+  CHECK(latency != METRIC_INVALID);
+  HistogramWindow window = {};
+  const float percentiles[] = {50, 99};
+  uint32_t results[2];
+  getHistogramWindow(latency, window, percentiles, results, 2);
+
+  // A loop task dispatching every 10 ms: waits spread over 0..10 ms
+  std::vector<uint32_t> waits;
+  AnomalyPayload anomaly = {};
+  for (int i = 0; i < 500; i++) {
+    publishEvent(EVENT_HEALTH_ANOMALY, anomaly);
+    uint32_t wait = (uint32_t)((i * 7919) % 10000);
+    simUs += wait;
+    CHECK(dispatchEvents(orderSub) == 1);
+    waits.push_back(wait);
+  }
+  std::sort(waits.begin(), waits.end());
+
+  CHECK(getHistogramWindow(latency, window, percentiles, results, 2) == waits.size());
+  uint32_t p50 = waits[waits.size() / 2], p99 = waits[waits.size() * 99 / 100];
+  CHECK(results[0] >= p50 * 0.9 && results[0] <= p50 * 1.1);
+  CHECK(results[1] >= p99 * 0.9 && results[1] <= p99 * 1.1);
+  ordered.clear();
+}
+
+// A publisher and a subscriber task on two threads, wall-clock latency per
+// event. The publisher keeps at most a queue's worth in flight, like audio
+// capture against a consumer that keeps up: nothing may be dropped.
+static void testCrossTaskLatency() {
+  const int EVENTS = 20000;
+  static std::chrono::steady_clock::time_point publishedAt[EVENTS];
+  static std::vector<double> latencyNs;
+  static std::vector<int> received;
+  static std::atomic<int> delivered(0);
+  latencyNs.clear();
+  received.clear();
+
+  EventSubscriberId sub = registerEventSubscriber("latency");
+  CHECK(sub == 2);
+  subscribeEvent(sub, EVENT_HEALTH_ANOMALY, [](const Event& event) {
+    int seq = (int)event.anomaly.value;
+    latencyNs.push_back(std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - publishedAt[seq]).count());
+    received.push_back(seq);
+    delivered++;
+  });
+  // Only the latency subscriber listens for anomalies during the run
+  subscribeEvent(orderSub, EVENT_HEALTH_ANOMALY, nullptr);
+
+  std::atomic<bool> done(false);
+  std::thread consumer([&] {
+    hostCoreId = 1;
+    while (!done.load()) {
+      if (dispatchEvents(sub) == 0) std::this_thread::yield();
+    }
+    while (dispatchEvents(sub) > 0) {}
+  });
+  uint32_t droppedBefore = droppedTotal();
+  for (int i = 0; i < EVENTS; i++) {
+    AnomalyPayload anomaly = {};
+    anomaly.value = (float)i;
+    while (i - delivered.load() >= EVENT_QUEUE_DEPTH_LOW) std::this_thread::yield();
+    publishedAt[i] = std::chrono::steady_clock::now();
+    CHECK(publishEvent(EVENT_HEALTH_ANOMALY, anomaly));
+  }
+  done = true;
+  consumer.join();
+
+  // Every event delivered once, in publish order
+  uint32_t dropped = droppedTotal() - droppedBefore;
+  CHECK(dropped == 0);
+  CHECK(received.size() == (size_t)EVENTS);
+  for (size_t i = 0; i < received.size(); i++) {
+    if (received[i] != (int)i) {
+      CHECK(received[i] == (int)i);
+      break;
+    }
+  }
+
+  std::sort(latencyNs.begin(), latencyNs.end());
+  if (!latencyNs.empty()) {
+    printf("BENCH cross-task dispatch, %d events, up to %d in flight: p50 %.0f ns, p99 %.0f ns\n",
+           EVENTS, EVENT_QUEUE_DEPTH_LOW, latencyNs[latencyNs.size() / 2],
+           latencyNs[latencyNs.size() * 99 / 100]);
+  }
+  subscribeEvent(orderSub, EVENT_HEALTH_ANOMALY, onOrdered);
+}
+
+static void testSubscriberLimit() {
+  int registered = 3;
+  while (registerEventSubscriber("extra") != EVENT_SUBSCRIBER_INVALID) registered++;
+  CHECK(registered == EVENT_MAX_SUBSCRIBERS);
+}
+
+int main() {
+  initMetricsRegistry();
+  initResourceManager();
+  CHECK(initEventBus());
+  testRouting();
+  testOrdering();
+  testOverflow();
+  testRecordedLatency();
+  testCrossTaskLatency();
+  testSubscriberLimit();
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
@@ -0,0 +1,19 @@
+// Globals behind the core stubs
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+#include <freertos/task.h>
+#include <websocket_handler.h>
+
+uint64_t simUs = 1000000;
+SerialStub Serial;
+EspClass ESP;
+uint32_t hostCpuMhz = 240;
+HostHeap hostHeap;
+uint32_t hostRandomState = 0x2545F491;
+thread_local int hostCoreId = 1;   // Arduino loop() runs on core 1
+thread_local TaskHandle_t hostCurrentTask = nullptr;
+std::vector<TaskStatus_t> hostTasks;
+hw_timer_t hostTimers[4];
+WebSocketStub webSocket;
+bool isConnected = false;
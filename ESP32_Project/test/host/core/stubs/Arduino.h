@@ -0,0 +1,207 @@
+#pragma once
+// Arduino core stand-in for the monitoring and memory host tests: simulated
+// microsecond clock, quiet Serial
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cstdarg>
+#include <cmath>
+#include <algorithm>
+#include <string>
+using std::min;
+using std::max;
+template <typename T> inline T constrain(T x, T low, T high) { return x < low ? low : x > high ? high : x; }
+
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+
+// Simulated time; tests advance it, delay() does too
+extern uint64_t simUs;
+inline uint32_t millis() { return (uint32_t)(simUs / 1000); }
+inline uint32_t micros() { return (uint32_t)simUs; }
+inline void delay(uint32_t ms) { simUs += (uint64_t)ms * 1000; }
+inline void yield() {}
+
+#define IRAM_ATTR
+
+// Heap figures come from hostHeap; the board has no PSRAM
+struct EspClass {
+  uint32_t getHeapSize() { return 320 * 1024; }
+  uint32_t getFreeHeap() { return (uint32_t)hostHeap.freeBytes; }
+  uint32_t getMinFreeHeap() { return (uint32_t)hostHeap.freeBytes; }
+  uint32_t getMaxAllocHeap() { return (uint32_t)hostHeap.largestBlock; }
+};
+extern EspClass ESP;
+inline bool psramFound() { return false; }
+
+extern uint32_t hostCpuMhz;
+inline uint32_t getCpuFrequencyMhz() { return hostCpuMhz; }
+inline bool setCpuFrequencyMhz(uint32_t mhz) {
+  hostCpuMhz = mhz;
+  return true;
+}
+
+// Hardware timers: attached alarms fire only when the test calls hostFireTimer()
+struct hw_timer_t {
+  void (*isr)();
+  uint64_t alarm;
+  bool enabled;
+  bool begun;
+};
+extern hw_timer_t hostTimers[4];
+inline hw_timer_t* timerBegin(uint8_t num, uint16_t, bool) {
+  hostTimers[num] = {nullptr, 0, false, true};
+  return &hostTimers[num];
+}
+inline void timerAttachInterrupt(hw_timer_t* t, void (*isr)(), bool) { t->isr = isr; }
+inline void timerDetachInterrupt(hw_timer_t* t) { t->isr = nullptr; }
+inline void timerAlarmWrite(hw_timer_t* t, uint64_t alarm, bool) { t->alarm = alarm; }
+inline void timerAlarmEnable(hw_timer_t* t) { t->enabled = true; }
+inline void timerAlarmDisable(hw_timer_t* t) { t->enabled = false; }
+inline void timerEnd(hw_timer_t* t) { t->begun = false; }
+inline bool hostFireTimer(uint8_t num) {
+  hw_timer_t& t = hostTimers[num];
+  if (!t.begun || !t.enabled || t.isr == nullptr) return false;
+  t.isr();
+  return true;
+}
+
+// Output is dropped unless verbose, or collected when capture is set;
+// input is whatever the test queued
+struct SerialStub {
+  bool verbose = false;
+  std::string* capture = nullptr;
+  std::string input;
+  int available() { return (int)input.size(); }
+  int read() {
+    if (input.empty()) return -1;
+    int c = (uint8_t)input[0];
+    input.erase(0, 1);
+    return c;
+  }
+  size_t write(const uint8_t* data, size_t length) {
+    print(std::string((const char*)data, length).c_str());
+    return length;
+  }
+  void print(const char* s) { if (capture) capture->append(s); else if (verbose) fputs(s, stdout); }
+  void println(const char* s = "") { print(s); print("\n"); }
+  void printf(const char* f, ...) {
+    char line[512];
+    va_list a;
+    va_start(a, f);
+    vsnprintf(line, sizeof(line), f, a);
+    va_end(a);
+    print(line);
+  }
+};
+extern SerialStub Serial;
+
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t length = strlen(src);
+  if (size) {
+    size_t n = std::min(length, size - 1);
+    memcpy(dst, src, n);
+    dst[n] = 0;
+  }
+  return length;
+}
+
+#define DEC 10
+#define HEX 16
+
+// Arduino String as the ESP32 core implements it: up to 10 characters are
+// stored inline, longer ones in a heap buffer realloc'd to the exact length
+// on every growth. Heap traffic is counted in hostHeap.
+class String {
+public:
+  String(const char* s = "") { if (s) concat(s, strlen(s)); }
+  String(const String& o) { concat(o.c_str(), o.len); }
+  String(String&& o) { swap(o); }
+  explicit String(char c) { concat(&c, 1); }
+  explicit String(int v) { concatNumber("%d", v); }
+  explicit String(unsigned v) { concatNumber("%u", v); }
+  explicit String(long v) { concatNumber("%ld", v); }
+  explicit String(unsigned long v) { concatNumber("%lu", v); }
+  String(unsigned char v, unsigned char base) { concatNumber(base == HEX ? "%x" : "%u", (unsigned)v); }
+  explicit String(double v, unsigned decimals = 2) { char t[40]; snprintf(t, sizeof(t), "%.*f", (int)decimals, v); concat(t); }
+  ~String() { release(); }
+
+  String& operator=(const String& o) { if (this != &o) { len = 0; terminate(); concat(o.c_str(), o.len); } return *this; }
+  String& operator=(String&& o) { if (this != &o) { release(); swap(o); } return *this; }
+  String& operator=(const char* s) { len = 0; terminate(); if (s) concat(s, strlen(s)); return *this; }
+
+  bool reserve(size_t size) {
+    if (size <= capacity()) return true;
+    char* grown = (char*)(heap ? realloc(ptr, size + 1) : malloc(size + 1));
+    if (grown == nullptr) return false;
+    hostHeap.allocs++;
+    if (!heap) memcpy(grown, sso, len + 1);
+    ptr = grown;
+    cap = size;
+    heap = true;
+    return true;
+  }
+  bool concat(const char* s, size_t n) {
+    if (!reserve(len + n)) return false;
+    memmove(buffer() + len, s, n);
+    len += n;
+    terminate();
+    return true;
+  }
+  bool concat(const char* s) { return s ? concat(s, strlen(s)) : false; }
+  bool concat(const String& o) { return concat(o.c_str(), o.len); }
+  bool concat(char c) { return concat(&c, 1); }
+  bool concat(int v) { return concatNumber("%d", v); }
+  bool concat(unsigned v) { return concatNumber("%u", v); }
+  bool concat(long v) { return concatNumber("%ld", v); }
+  bool concat(unsigned long v) { return concatNumber("%lu", v); }
+
+  template <typename T> String& operator+=(const T& v) { concat(v); return *this; }
+  friend String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+  friend String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+  friend String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+  friend String operator+(const String& a, char b) { String r(a); r += b; return r; }
+
+  const char* c_str() const { return heap ? ptr : sso; }
+  size_t length() const { return len; }
+  bool isEmpty() const { return len == 0; }
+  char operator[](size_t i) const { return i < len ? c_str()[i] : 0; }
+  bool equals(const char* s) const { return strcmp(c_str(), s ? s : "") == 0; }
+  bool operator==(const String& o) const { return len == o.len && equals(o.c_str()); }
+  bool operator==(const char* s) const { return equals(s); }
+  bool operator!=(const String& o) const { return !(*this == o); }
+  bool operator!=(const char* s) const { return !equals(s); }
+  bool startsWith(const char* s) const { return strncmp(c_str(), s, strlen(s)) == 0; }
+  int indexOf(char c) const { const char* p = strchr(c_str(), c); return p ? (int)(p - c_str()) : -1; }
+  int indexOf(const char* s) const { const char* p = strstr(c_str(), s); return p ? (int)(p - c_str()) : -1; }
+  String substring(size_t from, size_t to = (size_t)-1) const {
+    String r;
+    if (to > len) to = len;
+    if (from < to) r.concat(c_str() + from, to - from);
+    return r;
+  }
+  long toInt() const { return atol(c_str()); }
+
+private:
+  static const size_t SSO_SIZE = 11;   // Including the terminator (32-bit layout)
+  char sso[SSO_SIZE] = {0};
+  char* ptr = nullptr;
+  size_t cap = 0;
+  size_t len = 0;
+  bool heap = false;
+
+  size_t capacity() const { return heap ? cap : SSO_SIZE - 1; }
+  char* buffer() { return heap ? ptr : sso; }
+  void terminate() { buffer()[len] = 0; }
+  void release() { if (heap) { hostHeap.frees++; free(ptr); } heap = false; ptr = nullptr; cap = len = 0; sso[0] = 0; }
+  void swap(String& o) {
+    std::swap(sso, o.sso); std::swap(ptr, o.ptr); std::swap(cap, o.cap);
+    std::swap(len, o.len); std::swap(heap, o.heap);
+  }
+  template <typename T> bool concatNumber(const char* format, T v) {
+    char t[24];
+    snprintf(t, sizeof(t), format, v);
+    return concat(t);
+  }
+};
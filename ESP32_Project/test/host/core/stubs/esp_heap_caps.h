@@ -0,0 +1,47 @@
+#pragma once
+// Heap capabilities API on malloc; every call is counted
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+#define MALLOC_CAP_8BIT      (1 << 2)
+#define MALLOC_CAP_DMA       (1 << 3)
+#define MALLOC_CAP_INTERNAL  (1 << 11)
+#define MALLOC_CAP_DEFAULT   (1 << 12)
+#define MALLOC_CAP_SPIRAM    (1 << 10)
+
+struct HostHeap {
+  std::atomic<long> allocs{0};
+  std::atomic<long> frees{0};
+  size_t freeBytes = 200 * 1024;       // What heap_caps_get_free_size() reports
+  size_t largestBlock = 110 * 1024;
+};
+extern HostHeap hostHeap;
+
+inline void* heap_caps_malloc(size_t size, uint32_t) { hostHeap.allocs++; return malloc(size); }
+inline void* heap_caps_calloc(size_t n, size_t size, uint32_t) { hostHeap.allocs++; return calloc(n, size); }
+inline void* heap_caps_realloc(void* p, size_t size, uint32_t) { hostHeap.allocs++; return realloc(p, size); }
+inline void heap_caps_free(void* p) { if (p) hostHeap.frees++; free(p); }
+inline size_t heap_caps_get_free_size(uint32_t) { return hostHeap.freeBytes; }
+inline size_t heap_caps_get_largest_free_block(uint32_t) { return hostHeap.largestBlock; }
+inline size_t heap_caps_get_minimum_free_size(uint32_t) { return hostHeap.freeBytes; }
+
+// Region summary for MALLOC_CAP_INTERNAL only; the board has no PSRAM
+struct multi_heap_info_t {
+  size_t total_free_bytes;
+  size_t total_allocated_bytes;
+  size_t largest_free_block;
+  size_t minimum_free_bytes;
+  size_t allocated_blocks;
+  size_t free_blocks;
+  size_t total_blocks;
+};
+inline void heap_caps_get_info(multi_heap_info_t* info, uint32_t caps) {
+  *info = {};
+  if (caps & MALLOC_CAP_SPIRAM) return;
+  info->total_free_bytes = hostHeap.freeBytes;
+  info->total_allocated_bytes = 320 * 1024 - hostHeap.freeBytes;
+  info->largest_free_block = hostHeap.largestBlock;
+  info->minimum_free_bytes = hostHeap.freeBytes;
+}
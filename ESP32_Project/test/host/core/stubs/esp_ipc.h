@@ -0,0 +1,13 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+typedef void (*esp_ipc_func_t)(void* arg);
+typedef int esp_err_t;
+#define ESP_OK 0
+// Runs the call inline, with the thread's core id switched for its duration
+inline esp_err_t esp_ipc_call_blocking(uint32_t core, esp_ipc_func_t func, void* arg) {
+  int saved = hostCoreId;
+  hostCoreId = (int)core;
+  func(arg);
+  hostCoreId = saved;
+  return ESP_OK;
+}
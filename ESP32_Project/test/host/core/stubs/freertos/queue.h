@@ -0,0 +1,56 @@
+#pragma once
+// Fixed-depth queues of fixed-size items copied in and out, as FreeRTOS does
+#include "FreeRTOS.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+struct QueueStub {
+  size_t depth, item;
+  std::deque<std::vector<uint8_t>> q;
+  std::mutex m;
+  std::condition_variable cv;
+};
+typedef QueueStub* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(size_t depth, size_t item) {
+  QueueStub* q = new QueueStub;
+  q->depth = depth;
+  q->item = item;
+  return q;
+}
+inline void vQueueDelete(QueueHandle_t q) { delete q; }
+
+inline bool queueWait(std::unique_lock<std::mutex>& lock, QueueStub* q, TickType_t ticks, bool send) {
+  auto ready = [&] { return send ? q->q.size() < q->depth : !q->q.empty(); };
+  if (ticks == 0) {
+    return ready();   // Polling: no timed wait
+  }
+  if (ticks == portMAX_DELAY) {
+    q->cv.wait(lock, ready);
+    return true;
+  }
+  return q->cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+inline BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!queueWait(lock, q, ticks, true)) return pdFALSE;
+  q->q.emplace_back((const uint8_t*)item, (const uint8_t*)item + q->item);
+  q->cv.notify_all();
+  return pdTRUE;
+}
+inline BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!queueWait(lock, q, ticks, false)) return pdFALSE;
+  memcpy(item, q->q.front().data(), q->item);
+  q->q.pop_front();
+  q->cv.notify_all();
+  return pdTRUE;
+}
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+  std::lock_guard<std::mutex> lock(q->m);
+  return (UBaseType_t)q->q.size();
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "FreeRTOS.h"
+#include <chrono>
+#include <mutex>
+
+// Mutex semaphores on std::timed_mutex; a timeout of 0 is a try-lock
+struct SemaphoreStub {
+  std::timed_mutex m;
+};
+typedef SemaphoreStub* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new SemaphoreStub; }
+inline void vSemaphoreDelete(SemaphoreHandle_t s) { delete s; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks) {
+  if (ticks == portMAX_DELAY) {
+    s->m.lock();
+    return pdTRUE;
+  }
+  return s->m.try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+  s->m.unlock();
+  return pdTRUE;
+}
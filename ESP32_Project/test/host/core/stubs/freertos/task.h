@@ -0,0 +1,52 @@
+#pragma once
+#include "FreeRTOS.h"
+#include <thread>
+#include <vector>
+
+typedef void* TaskHandle_t;
+extern thread_local TaskHandle_t hostCurrentTask;
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return hostCurrentTask; }
+
+// Tasks the test registers stand in for the scheduler's task list
+#define configUSE_TRACE_FACILITY 1
+typedef enum { eRunning, eReady, eBlocked, eSuspended, eDeleted } eTaskState;
+struct TaskStatus_t {
+  TaskHandle_t xHandle;
+  const char* pcTaskName;
+  UBaseType_t xTaskNumber;
+  eTaskState eCurrentState;
+  UBaseType_t uxCurrentPriority;
+  UBaseType_t uxBasePriority;
+  uint32_t ulRunTimeCounter;
+  uint32_t* pxStackBase;
+  uint32_t usStackHighWaterMark;
+  BaseType_t xCoreID;
+};
+extern std::vector<TaskStatus_t> hostTasks;
+inline const char* pcTaskGetTaskName(TaskHandle_t task) {
+  if (task == nullptr) task = hostCurrentTask;
+  for (const TaskStatus_t& t : hostTasks) {
+    if (t.xHandle == task) return t.pcTaskName;
+  }
+  return "loopTask";   // Unregistered threads stand in for Arduino's loop task
+}
+inline UBaseType_t uxTaskGetNumberOfTasks() { return (UBaseType_t)hostTasks.size(); }
+inline UBaseType_t uxTaskGetSystemState(TaskStatus_t* out, UBaseType_t size, uint32_t* totalRunTime) {
+  UBaseType_t n = 0;
+  for (const TaskStatus_t& t : hostTasks) {
+    if (n == size) return 0;   // FreeRTOS reports nothing when the array is too small
+    out[n++] = t;
+  }
+  if (totalRunTime) *totalRunTime = 0;
+  return n;
+}
+
+// High-water marks (bytes, as on ESP-IDF) come from the registered tasks
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  if (task == nullptr) task = hostCurrentTask;
+  for (const TaskStatus_t& t : hostTasks) {
+    if (t.xHandle == task) return t.usStackHighWaterMark;
+  }
+  return 0;
+}
+inline void vTaskDelay(TickType_t) { std::this_thread::yield(); }
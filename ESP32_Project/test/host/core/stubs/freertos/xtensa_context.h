@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+// Interrupted context as the Xtensa port saves it (leading fields only)
+struct XtExcFrame {
+  uint32_t exit;
+  uint32_t pc;
+  uint32_t ps;
+  uint32_t a0;
+  uint32_t a1;
+};
@@ -0,0 +1,28 @@
+#pragma once
+// WebSocket link stand-in: text frames are collected for the test
+#include <Arduino.h>
+#if __has_include(<ArduinoJson.h>)
+#include <ArduinoJson.h>   // The real header pulls it in for its users
+#endif
+#include <string>
+#include <vector>
+
+struct WebSocketStub {
+  std::vector<std::string> sent;
+  bool fail = false;
+  bool sendTXT(String& message) {
+    if (fail) return false;
+    sent.push_back(message.c_str());
+    return true;
+  }
+};
+extern WebSocketStub webSocket;
+extern bool isConnected;
+
+#if __has_include(<ArduinoJson.h>)
+void getConnectionHealth(JsonObject& healthObj);   // Defined by the tests that use it
+#endif
+
+// Memory budget hooks; defined by the tests that use them
+size_t getAdaptiveChunkSize();
+void setAdaptiveChunkSize(size_t bytes);
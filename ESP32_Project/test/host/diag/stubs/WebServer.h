@@ -0,0 +1,51 @@
+#pragma once
+// Routes and the chunked response as arduino-esp32's WebServer sends them;
+// the peer can hang up after a number of chunks
+#include <Arduino.h>
+#include <functional>
+#include <map>
+#include <string>
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_POST };
+
+struct WiFiClientStub {
+  bool* open;
+  bool connected() { return *open; }
+};
+
+class WebServer {
+public:
+  std::map<std::string, std::function<void()>> routes;
+  std::string contentType, body;
+  int code = 0;
+  size_t contentLength = 0;
+  int chunks = 0;             // Non-empty chunks sent
+  int hangUpAfter = -1;       // Chunks before the peer disconnects; -1 never
+  bool finished = false;      // Final empty chunk sent
+  bool open = true;
+
+  void on(const char* uri, HTTPMethod, std::function<void()> handler) { routes[uri] = handler; }
+  WiFiClientStub client() { return WiFiClientStub{&open}; }
+  void setContentLength(size_t length) { contentLength = length; }
+  void send(int status, const char* type, const String&) {
+    code = status;
+    contentType = type;
+  }
+  void sendContent(const char* data, size_t length) {
+    if (length == 0) {
+      finished = true;
+      return;
+    }
+    body.append(data, length);
+    if (++chunks == hangUpAfter) open = false;
+  }
+  void sendContent(const char* data) { sendContent(data, strlen(data)); }
+
+  void get(const char* uri) {
+    body.clear();
+    chunks = 0;
+    finished = false;
+    routes.at(uri)();
+  }
+};
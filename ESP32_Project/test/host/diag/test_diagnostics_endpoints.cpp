@@ -0,0 +1,321 @@
+// Diagnostics endpoints: /metrics checked line by line against the
+// Prometheus text format (names, TYPE before samples, labels, values),
+// registry names with dots, spaces, units and UTF-8 mapped to valid metric
+// names, long names truncated, summaries of empty histograms; the response
+// stream split into chunks, overlong lines, and a peer hanging up mid-page.
+#include <diagnostics_endpoints.h>
+#include <metrics_registry.h>
+#include <connection_stats.h>
+#include <memory_budget.h>
+#include <task_stats.h>
+#include <websocket_handler.h>
+#include <config.h>
+#include <set>
+#include <string>
+#include <vector>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+// Subsystems the debug pages read
+float getCoreCpuPercent(int) { return 12.5f; }
+size_t getTaskStatsCount() { return 0; }
+const TaskStatsEntry* getTaskStatsAt(size_t) { return nullptr; }
+MemoryPressure getMemoryPressure() { return MEM_PRESSURE_NONE; }
+uint8_t getDegradationLevel() { return 0; }
+ConnectionStats getConnectionStats() { return ConnectionStats(); }
+void getConnectionHealth(JsonObject& healthObj) { healthObj["connected"] = false; }
+
+static bool collect(void* context, const char* data, size_t length) {
+  static_cast<std::vector<std::string>*>(context)->push_back(std::string(data, length));
+  return true;
+}
+
+static std::string render(void (*renderer)(ResponseStream&), size_t* chunks = nullptr) {
+  std::vector<std::string> parts;
+  {
+    ResponseStream out(collect, &parts);
+    renderer(out);
+  }
+  std::string text;
+  for (const std::string& part : parts) text += part;
+  if (chunks) *chunks = parts.size();
+  return text;
+}
+
+static bool contains(const std::string& text, const std::string& line) {
+  return text.find("\n" + line + "\n") != std::string::npos || text.compare(0, line.size() + 1, line + "\n") == 0;
+}
+
+// =============================================================================
+// EXPOSITION FORMAT
+// =============================================================================
+
+static bool validName(const std::string& name) {
+  if (name.empty() || !(isalpha((unsigned char)name[0]) || name[0] == '_' || name[0] == ':')) return false;
+  for (char c : name) {
+    if (!(isalnum((unsigned char)c) || c == '_' || c == ':')) return false;
+  }
+  return true;
+}
+
+// Labels from just after '{'; values may only use the \\, \" and \n escapes
+static bool parseLabels(const std::string& line, size_t& at) {
+  while (at < line.size() && line[at] != '}') {
+    size_t eq = line.find('=', at);
+    if (eq == std::string::npos) return false;
+    std::string label = line.substr(at, eq - at);
+    if (!validName(label) || label.find(':') != std::string::npos) return false;
+    at = eq + 1;
+    if (at >= line.size() || line[at] != '"') return false;
+    for (at++; at < line.size() && line[at] != '"'; at++) {
+      if (line[at] == '\\' && (at + 1 >= line.size() || !strchr("\\\"n", line[++at]))) return false;
+    }
+    if (at >= line.size()) return false;
+    at++;
+    if (at < line.size() && line[at] == ',') at++;
+  }
+  if (at >= line.size()) return false;
+  at++;
+  return true;
+}
+
+// Checks a scrape against the text format, version 0.0.4; returns the first
+// problem or an empty string
+static std::string validateExposition(const std::string& text) {
+  if (text.empty() || text.back() != '\n') return "not newline-terminated";
+  std::set<std::string> families, series;
+  std::string family, type;
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    std::string line = text.substr(start, end - start);
+    start = end + 1;
+    if (line.empty() || line.find('\r') != std::string::npos) return "blank line or CR";
+
+    if (line[0] == '#') {
+      char name[128], kind[32];
+      if (sscanf(line.c_str(), "# TYPE %127s %31s", name, kind) != 2) return "bad comment: " + line;
+      if (!validName(name)) return "bad family name: " + line;
+      static const std::set<std::string> kinds = {"counter", "gauge", "summary", "histogram", "untyped"};
+      if (!kinds.count(kind)) return "bad type: " + line;
+      if (!families.insert(name).second) return "family declared twice: " + line;
+      family = name;
+      type = kind;
+      continue;
+    }
+
+    size_t at = 0;
+    while (at < line.size() && line[at] != '{' && line[at] != ' ') at++;
+    std::string name = line.substr(0, at);
+    if (!validName(name)) return "bad sample name: " + line;
+    bool ofFamily = name == family ||
+                    (type == "summary" && (name == family + "_sum" || name == family + "_count"));
+    if (!ofFamily) return "sample outside its TYPE: " + line;
+    std::string labels;
+    if (at < line.size() && line[at] == '{') {
+      at++;
+      size_t from = at;
+      if (!parseLabels(line, at)) return "bad labels: " + line;
+      labels = line.substr(from, at - from);
+    }
+    if (type == "summary" && name == family && labels.find("quantile=") != 0) return "summary without quantile: " + line;
+    if (at >= line.size() || line[at] != ' ') return "no value: " + line;
+    std::string value = line.substr(at + 1);
+    char* parsed = nullptr;
+    strtod(value.c_str(), &parsed);
+    if (value.empty() || *parsed != '\0') return "bad value: " + line;
+    if (!series.insert(name + "{" + labels).second) return "duplicate series: " + line;
+  }
+  return "";
+}
+
+static void testExpositionFormat() {
+  // The names the firmware registers, plus awkward ones
+  MetricId reconnects = registerCounter("ws.reconnects");
+  MetricId sent = registerCounter("ws.audio_bytes_sent", "bytes");
+  MetricId timer = registerGauge("task.Tmr Svc.cpu", "%");
+  MetricId slope = registerGauge("heap.slope", "bytes/h");
+  MetricId utf8 = registerGauge("t\xc3\xa2" "che.cpu", "%");
+  static const char* longName =
+    "audio.pipeline.stage.resampler.output.underruns.while.streaming.to.server";
+  MetricId truncated = registerCounter(longName);
+  MetricId rtt = registerHistogram("ws.rtt", "ms");
+  registerHistogram("crypto.audio_hmac", "us");   // Nothing observed
+  metricIncrement(reconnects, 3);
+  metricIncrement(sent, 4096);
+  metricSetGauge(timer, 7);
+  metricSetGauge(slope, -4096);
+  metricSetGauge(utf8, 1);
+  metricIncrement(truncated);
+  for (uint32_t v = 1; v <= 1000; v++) metricObserve(rtt, v);
+
+  std::string text = render(renderPrometheusMetrics);
+  std::string problem = validateExposition(text);
+  if (!problem.empty()) printf("  %s\n", problem.c_str());
+  CHECK(problem.empty());
+
+  CHECK(contains(text, "teddy_build_info{version=\"" FIRMWARE_VERSION "\"} 1"));
+  CHECK(contains(text, "# TYPE teddy_ws_reconnects_total counter"));
+  CHECK(contains(text, "teddy_ws_reconnects_total 3"));
+  CHECK(contains(text, "teddy_ws_audio_bytes_sent_bytes_total 4096"));
+  CHECK(contains(text, "teddy_task_Tmr_Svc_cpu_percent 7"));
+  CHECK(contains(text, "teddy_heap_slope_bytes_h -4096"));
+  CHECK(contains(text, "teddy_t__che_cpu_percent 1"));   // One '_' per UTF-8 byte
+
+  // Names are cut to 63 characters before the suffix
+  std::string cut = std::string("teddy_") + longName;
+  cut.resize(63);
+  for (char& c : cut) c = c == '.' ? '_' : c;
+  CHECK(contains(text, cut + "_total 1"));
+
+  HistogramSnapshot snap;
+  CHECK(getHistogramSnapshot(rtt, snap));
+  CHECK(contains(text, "# TYPE teddy_ws_rtt_ms summary"));
+  CHECK(contains(text, "teddy_ws_rtt_ms{quantile=\"0.5\"} " + std::to_string(snap.p50)));
+  CHECK(contains(text, "teddy_ws_rtt_ms{quantile=\"0.999\"} " + std::to_string(snap.p999)));
+  CHECK(contains(text, "teddy_ws_rtt_ms_sum 500500"));
+  CHECK(contains(text, "teddy_ws_rtt_ms_count 1000"));
+  CHECK(contains(text, "teddy_crypto_audio_hmac_us{quantile=\"0.99\"} NaN"));
+  CHECK(contains(text, "teddy_crypto_audio_hmac_us_count 0"));
+
+  printf("BENCH /metrics: %zu bytes for %zu counters, %zu gauges, %zu histograms\n", text.size(),
+         getMetricCount(METRIC_COUNTER), getMetricCount(METRIC_GAUGE), getMetricCount(METRIC_HISTOGRAM));
+}
+
+// The validator itself rejects what Prometheus would
+static void testValidator() {
+  CHECK(validateExposition("# TYPE a gauge\na 1\n").empty());
+  CHECK(validateExposition("# TYPE a summary\na{quantile=\"0.5\"} NaN\na_sum 1\na_count 1\n").empty());
+  CHECK(!validateExposition("# TYPE a gauge\na 1").empty());                 // No final newline
+  CHECK(!validateExposition("a 1\n").empty());                               // No TYPE
+  CHECK(!validateExposition("# TYPE a gauge\nb 1\n").empty());               // Other family
+  CHECK(!validateExposition("# TYPE a gauge\n# TYPE a gauge\na 1\n").empty());
+  CHECK(!validateExposition("# TYPE a.b gauge\na.b 1\n").empty());
+  CHECK(!validateExposition("# TYPE a gauge\na{v=\"x\"y\"} 1\n").empty());   // Unescaped quote
+  CHECK(!validateExposition("# TYPE a gauge\na{v=\"\\t\"} 1\n").empty());    // Unknown escape
+  CHECK(validateExposition("# TYPE a gauge\na{v=\"\\\"\\\\\\n\"} 1\n").empty());
+  CHECK(!validateExposition("# TYPE a gauge\na 1 2x\n").empty());
+  CHECK(!validateExposition("# TYPE a gauge\na 1\na 2\n").empty());          // Duplicate series
+}
+
+// =============================================================================
+// RESPONSE STREAM
+// =============================================================================
+
+struct HangUp {
+  std::vector<std::string> parts;
+  size_t acceptChunks;
+};
+
+static bool hangUpSink(void* context, const char* data, size_t length) {
+  HangUp* h = static_cast<HangUp*>(context);
+  if (h->parts.size() == h->acceptChunks) return false;
+  h->parts.push_back(std::string(data, length));
+  return true;
+}
+
+static void testResponseStream() {
+  // Lines are packed into full chunks; printf never splits a line
+  std::vector<std::string> parts;
+  std::string expected;
+  {
+    ResponseStream out(collect, &parts);
+    for (int i = 0; i < 100; i++) {
+      out.printf("line %03d %s\n", i, "................................");
+      char line[64];
+      snprintf(line, sizeof(line), "line %03d %s\n", i, "................................");
+      expected += line;
+    }
+  }
+  std::string joined;
+  for (const std::string& part : parts) joined += part;
+  CHECK(joined == expected);
+  CHECK(parts.size() > expected.size() / DIAG_CHUNK_SIZE);
+  bool whole = true;
+  for (size_t i = 0; i + 1 < parts.size(); i++) {
+    whole = whole && parts[i].size() <= DIAG_CHUNK_SIZE && parts[i].back() == '\n';
+  }
+  CHECK(whole);
+
+  // write() fills chunks exactly, across any number of them
+  parts.clear();
+  std::string blob(3 * DIAG_CHUNK_SIZE + 7, 'x');
+  {
+    ResponseStream out(collect, &parts);
+    out.write((const uint8_t*)blob.data(), blob.size());
+  }
+  CHECK(parts.size() == 4 && parts[0].size() == DIAG_CHUNK_SIZE && parts[3].size() == 7);
+
+  // A line longer than a chunk is cut, but still ends the line
+  parts.clear();
+  std::string wide(DIAG_CHUNK_SIZE * 2, 'w');
+  {
+    ResponseStream out(collect, &parts);
+    out.print("before\n");
+    out.printf("%s\n", wide.c_str());
+    out.print("after\n");
+  }
+  joined.clear();
+  for (const std::string& part : parts) joined += part;
+  CHECK(parts.size() >= 2 && parts[0] == "before\n");
+  CHECK(joined == "before\n" + std::string(DIAG_CHUNK_SIZE - 2, 'w') + "\nafter\n");
+
+  // Once the sink fails nothing more is sent
+  HangUp h = {{}, 2};
+  {
+    ResponseStream out(hangUpSink, &h);
+    for (int i = 0; i < 200; i++) out.print("0123456789abcdef0123456789abcdef\n");
+    CHECK(out.failed());
+    CHECK(!out.flush());
+  }
+  CHECK(h.parts.size() == 2);
+}
+
+// =============================================================================
+// WEB SERVER
+// =============================================================================
+
+static void testEndpoints() {
+  WebServer server;
+  registerDiagnosticsEndpoints(server);
+  CHECK(server.routes.count("/metrics") && server.routes.count("/debug/connection"));
+
+  server.get("/metrics");
+  CHECK(server.code == 200 && server.contentType == DIAG_PROMETHEUS_TYPE);
+  CHECK(server.contentLength == CONTENT_LENGTH_UNKNOWN && server.finished);
+  CHECK(server.body == render(renderPrometheusMetrics));
+  CHECK(server.chunks > 1);
+
+  // Every page is newline-terminated text (or JSON)
+  for (const char* page : {"/debug", "/debug/tasks", "/debug/heap", "/debug/latency", "/debug/connection"}) {
+    server.get(page);
+    CHECK(server.finished && !server.body.empty() && server.body.back() == '\n');
+  }
+  CHECK(server.body.find("\"websocket\":{\"connected\":false}") != std::string::npos);
+
+  // The peer goes away after the first chunk: the rest is not rendered into it
+  server.hangUpAfter = 1;
+  server.get("/metrics");
+  CHECK(server.chunks == 1 && server.finished);
+  server.open = true;
+  server.hangUpAfter = -1;
+}
+
+int main() {
+  initMetricsRegistry();
+  testValidator();
+  testExpositionFormat();
+  testResponseStream();
+  testEndpoints();
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
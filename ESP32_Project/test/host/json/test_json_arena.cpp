@@ -0,0 +1,186 @@
+// JSON arenas: the short-estimate retry releasing its first pool; a recorded
+// server message stream (server_messages.jsonl) parsed the way
+// handleIncomingMessage() does, counting heap and arena allocations per
+// message and peak arena demand; nested scopes on more tasks than arenas.
+// Host pointers are 64-bit, so documents are larger than on the device.
+#include <json_arena.h>
+#include <esp_heap_caps.h>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+// Heap documents, for comparison
+static std::atomic<long> heapDocAllocs(0);
+struct CountingAllocator {
+  void* allocate(size_t size) { heapDocAllocs++; return malloc(size); }
+  void deallocate(void* ptr) { free(ptr); }
+  void* reallocate(void* ptr, size_t size) { return realloc(ptr, size); }
+};
+
+static int parseRetries = 0;
+
+// The parse path of handleIncomingMessage(): learned estimate, one retry
+// in a second scoped document after NoMemory
+static bool parseMessage(const std::string& message) {
+  JsonArenaScope arena;
+  DeserializationError error;
+  {
+    ArenaJsonDocument doc(estimateJsonCapacity(message.size()));
+    error = deserializeJson(doc, message.data(), message.size());
+    if (!error) {
+      recordJsonUsage(message.size(), doc.memoryUsage());
+      return doc["type"].is<const char*>();
+    }
+    if (error == DeserializationError::NoMemory) {
+      recordJsonUsage(message.size(), doc.capacity() * 2);
+    }
+  }
+  if (error != DeserializationError::NoMemory) return false;
+  parseRetries++;
+  ArenaJsonDocument retry(estimateJsonCapacity(message.size()));
+  error = deserializeJson(retry, message.data(), message.size());
+  if (!error) recordJsonUsage(message.size(), retry.memoryUsage());
+  return !error;
+}
+
+// =============================================================================
+// RECORDED STREAM
+// =============================================================================
+
+static void testRecordedStream(const char* path) {
+  std::vector<std::string> messages;
+  std::ifstream in(path);
+  for (std::string line; std::getline(in, line);) {
+    if (!line.empty()) messages.push_back(line);
+  }
+  CHECK(messages.size() > 30);
+  if (messages.empty()) return;
+
+  // First pass: the arena and the overhead estimate learn the stream
+  for (const std::string& m : messages) CHECK(parseMessage(m));
+  JsonArenaStats warm = getJsonArenaStats();
+  CHECK(warm.resizes >= 1);                         // 3 KB arena grew for audio_response
+  CHECK(warm.reservedBytes <= JSON_ARENA_MAX_SIZE);
+  CHECK(warm.peakUsage <= warm.reservedBytes);
+
+  // Steady state: every document from the arena, no heap traffic at all
+  long heapBefore = hostHeap.allocs;
+  int retriesBefore = parseRetries;
+  size_t bytes = 0;
+  for (const std::string& m : messages) {
+    CHECK(parseMessage(m));
+    bytes += m.size();
+  }
+  JsonArenaStats steady = getJsonArenaStats();
+  long heapAllocs = hostHeap.allocs - heapBefore;
+  uint32_t arenaAllocs = steady.arenaAllocs - warm.arenaAllocs;
+  CHECK(heapAllocs == 0);
+  CHECK(steady.heapFallbacks == warm.heapFallbacks);
+  CHECK(steady.resizes == warm.resizes);
+  CHECK(parseRetries == retriesBefore);
+  CHECK(arenaAllocs == messages.size());   // One pool per message, strings copied into it
+  CHECK(steady.scopes - warm.scopes == messages.size());
+
+  // Same stream through heap documents sized the same way
+  heapDocAllocs = 0;
+  for (const std::string& m : messages) {
+    BasicJsonDocument<CountingAllocator> doc(estimateJsonCapacity(m.size()));
+    CHECK(!deserializeJson(doc, m.data(), m.size()));
+  }
+
+  printf("BENCH %zu messages (%zu bytes): %.2f heap allocs/msg with arenas, %.2f with heap documents; "
+         "%.2f arena allocs/msg\n", messages.size(), bytes, (double)heapAllocs / messages.size(),
+         (double)heapDocAllocs / messages.size(), (double)arenaAllocs / messages.size());
+  printf("BENCH peak arena demand %u bytes, %u reserved, %u resizes, %u warm-up fallbacks\n",
+         (unsigned)steady.peakUsage, (unsigned)steady.reservedBytes, steady.resizes, warm.heapFallbacks);
+}
+
+// =============================================================================
+// RETRY
+// =============================================================================
+
+// A dense message (tree nodes, no strings) overruns the initial estimate;
+// the retry document reuses the arena space of the short one. Runs first,
+// while the peak in the stats is this scope's.
+static void testRetryReleasesFirstPool() {
+  std::string dense = "{\"type\":\"history\",\"points\":[";
+  for (int i = 0; i < 40; i++) dense += (i ? ",0" : "0");
+  dense += "]}";
+
+  size_t firstCapacity = estimateJsonCapacity(dense.size());
+  CHECK(parseMessage(dense));
+  JsonArenaStats after = getJsonArenaStats();
+  CHECK(parseRetries == 1);
+
+  size_t retryCapacity = 2 * firstCapacity + JSON_CAPACITY_SLACK;
+  CHECK(after.scopes == 1 && after.reservedBytes == JSON_ARENA_INITIAL_SIZE);
+  CHECK(firstCapacity + retryCapacity < JSON_ARENA_INITIAL_SIZE);   // Holding both would still fit: the peak tells
+  CHECK(after.heapFallbacks == 0 && after.arenaAllocs == 2);
+  CHECK(after.peakUsage > retryCapacity && after.peakUsage < firstCapacity + retryCapacity);
+  printf("BENCH retry: %zu-byte estimate -> %zu, peak arena demand %u\n",
+         firstCapacity, retryCapacity, (unsigned)after.peakUsage);
+}
+
+// =============================================================================
+// NESTED SCOPES ON SEVERAL TASKS
+// =============================================================================
+
+static void testNestedScopesAcrossTasks() {
+  const int TASKS = JSON_ARENA_SLOTS + 1;   // One more task than arenas
+  const int ROUNDS = 20000;
+  std::atomic<long> failures(0);
+  std::string capture;
+  Serial.capture = &capture;
+
+  std::vector<std::thread> tasks;
+  for (int t = 0; t < TASKS; t++) {
+    tasks.emplace_back([&, t] {
+      hostCurrentTask = (TaskHandle_t)(uintptr_t)(0x1000 + t);
+      for (int round = 0; round < ROUNDS; round++) {
+        JsonArenaScope outer;
+        ArenaJsonDocument reply(256);
+        reply["type"] = "stream_ack";
+        {
+          JsonArenaScope inner;   // Nested: same arena, depth 2
+          ArenaJsonDocument ack(128);
+          ack["seq"] = round;
+          if (ack["seq"] != round) failures++;
+        }
+        if (reply["type"] != "stream_ack") failures++;
+      }
+    });
+  }
+  for (std::thread& task : tasks) task.join();
+  Serial.capture = nullptr;
+
+  CHECK(failures == 0);
+  CHECK(capture.find("live blocks") == std::string::npos);
+  // Every arena is idle again: all of them can be released
+  releaseIdleJsonArenas();
+  CHECK(getJsonArenaStats().reservedBytes == 0);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage: %s server_messages.jsonl\n", argv[0]);
+    return 2;
+  }
+  testRetryReleasesFirstPool();
+  testRecordedStream(argv[1]);
+  testNestedScopesAcrossTasks();
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
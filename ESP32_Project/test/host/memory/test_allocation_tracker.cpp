@@ -0,0 +1,227 @@
+// Allocation-site tracker: per-(label, caller) aggregation, recycling of idle
+// sites once all MAX_ALLOCATION_SITES are taken, and the growth-streak leak
+// detector under a simulated WebSocket reconnect storm. Writes the heap
+// snapshots to heap_snapshots.log for the heap_diff.py check after this test.
+#include <resource_manager.h>
+#include <string>
+#include <vector>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+static std::string snapshotLog;
+
+static const AllocationSite* findSite(const char* name, size_t skip = 0) {
+  for (size_t i = 0; i < getAllocationSiteCount(); i++) {
+    const AllocationSite* site = getAllocationSite(i);
+    if (strcmp(site->name, name) == 0 && skip-- == 0) return site;
+  }
+  return nullptr;
+}
+
+static void snapshot() {
+  Serial.capture = &snapshotLog;
+  dumpAllocationSnapshot();
+  Serial.capture = nullptr;
+}
+
+// Two call sites for the same label. The counters keep the calls out of
+// tail position (the caller would be the test line) and the bodies distinct.
+static volatile int rxCalls = 0;
+static volatile int txCalls = 0;
+__attribute__((noinline)) static void* allocFromRx(size_t size) {
+  void* ptr = trackMalloc(size, "ws_rx");
+  rxCalls = rxCalls + 1;
+  return ptr;
+}
+__attribute__((noinline)) static void* allocFromTx(size_t size) {
+  void* ptr = trackMalloc(size, "ws_rx");
+  txCalls = txCalls + 1;
+  return ptr;
+}
+
+// =============================================================================
+// SITE AGGREGATION
+// =============================================================================
+
+static void testAggregation() {
+  void* a = allocFromRx(1000);
+  void* b = allocFromRx(500);
+  void* c = allocFromTx(200);
+  void* d = trackMalloc(64, "json_doc");
+
+  const AllocationSite* rx = findSite("ws_rx");
+  const AllocationSite* tx = findSite("ws_rx", 1);
+  CHECK(rx && tx && rx->caller != tx->caller);
+  CHECK(rx->liveCount == 2 && rx->liveBytes == 1500 && rx->totalAllocs == 2);
+  CHECK(tx->liveCount == 1 && tx->liveBytes == 200);
+  CHECK(getTrackedBytesForSite("ws_rx") == 1700);   // Summed over both callers
+  CHECK(getTrackedBytesForSite("json_doc") == 64);
+  CHECK(resourceManager.getTrackedAllocations() == 4);
+  CHECK(getMemoryHealth().tracked_memory == 1764);
+
+  trackFree(a);
+  CHECK(rx->liveCount == 1 && rx->liveBytes == 500 && rx->peakBytes == 1500 && rx->totalFrees == 1);
+  trackFree(b);
+  trackFree(c);
+  trackFree(d);
+  CHECK(getTrackedBytesForSite("ws_rx") == 0 && rx->peakBytes == 1500);
+  CHECK(resourceManager.getTrackedAllocations() == 0);
+
+  // Externally owned memory can be tracked and released without a free
+  static uint8_t staticBuffer[256];
+  CHECK(addResourceTracker(staticBuffer, sizeof(staticBuffer), "static_buf"));
+  CHECK(getTrackedBytesForSite("static_buf") == 256);
+  CHECK(removeResourceTracker(staticBuffer));
+  CHECK(!removeResourceTracker(staticBuffer));
+  CHECK(getTrackedBytesForSite("static_buf") == 0);
+
+  // RAII helpers go through the same sites
+  {
+    ScopedResource scoped(128, "scoped");
+    ManagedPtr<uint64_t> managed("managed");
+    CHECK(scoped.isValid() && managed.isValid());
+    CHECK(getTrackedBytesForSite("scoped") == 128 && getTrackedBytesForSite("managed") == 8);
+  }
+  CHECK(getTrackedBytesForSite("scoped") == 0 && getTrackedBytesForSite("managed") == 0);
+}
+
+// =============================================================================
+// LEAK DETECTION
+// =============================================================================
+
+// Per reconnect: receive buffer and JSON document come and go, the TLS
+// session cache keeps one entry it never frees
+static void testReconnectStorm() {
+  void* audioBuffer = trackMalloc(4096, "audio_buffer");   // Lives until reboot
+  snapshot();
+
+  std::vector<void*> sessions;
+  int firstFlaggedScan = -1;
+  const int scans = 8;
+  for (int scan = 0; scan < scans; scan++) {
+    for (int reconnect = 0; reconnect < 5; reconnect++) {
+      void* rx = allocFromRx(2048);
+      void* doc = trackMalloc(768, "json_doc");
+      sessions.push_back(trackMalloc(120, "tls_session"));
+      trackFree(doc);
+      trackFree(rx);
+    }
+    simUs += (uint64_t)LEAK_CHECK_INTERVAL * 1000;
+    int leaks = detectMemoryLeaks();
+    const AllocationSite* tls = findSite("tls_session");
+    if (tls->suspectedLeak && firstFlaggedScan < 0) firstFlaggedScan = scan;
+    CHECK(leaks == (tls->suspectedLeak ? 1 : 0));
+  }
+
+  // Flagged on the LEAK_GROWTH_CHECKS-th growing scan, not before
+  CHECK(firstFlaggedScan == LEAK_GROWTH_CHECKS - 1);
+  CHECK(findSite("tls_session")->liveCount == 5 * scans);
+  CHECK(!findSite("ws_rx")->suspectedLeak && !findSite("json_doc")->suspectedLeak);
+  // Allocated once and kept: one growing scan, then flat; only reported as aged
+  CHECK(!findSite("audio_buffer")->suspectedLeak);
+  CHECK(findSite("audio_buffer")->agedCount == 1);
+  CHECK(getMemoryHealth().potential_leaks == 1);
+  snapshot();
+
+  // The site stops growing: the flag clears on the next scan
+  simUs += (uint64_t)LEAK_CHECK_INTERVAL * 1000;
+  CHECK(detectMemoryLeaks() == 0);
+  for (void* p : sessions) trackFree(p);
+  trackFree(audioBuffer);
+  CHECK(resourceManager.getTrackedAllocations() == 0);
+}
+
+// =============================================================================
+// SITE TABLE EVICTION
+// =============================================================================
+
+static void testSiteEviction() {
+  static char labels[2 * MAX_ALLOCATION_SITES][16];
+  size_t used = getAllocationSiteCount();
+  CHECK(used < MAX_ALLOCATION_SITES);
+
+  // Fill the table: one live allocation per new site, the first one also
+  // with a long history
+  std::vector<void*> live;
+  size_t fill = MAX_ALLOCATION_SITES - used;
+  for (size_t i = 0; i < fill; i++) {
+    snprintf(labels[i], sizeof(labels[i]), "fill_%u", (unsigned)i);
+    live.push_back(trackMalloc(16, labels[i]));
+  }
+  CHECK(getAllocationSiteCount() == MAX_ALLOCATION_SITES);
+
+  // Earlier sites are idle now; the one with the fewest allocations goes first
+  const AllocationSite* fewest = nullptr;
+  for (size_t i = 0; i < used; i++) {
+    const AllocationSite* site = getAllocationSite(i);
+    if (site->liveCount == 0 && (fewest == nullptr || site->totalAllocs < fewest->totalAllocs)) fewest = site;
+  }
+  CHECK(fewest != nullptr);
+  const char* evictedName = fewest ? fewest->name : "";
+  uint32_t evictedCaller = fewest ? fewest->caller : 0;
+
+  snprintf(labels[fill], sizeof(labels[fill]), "late_site");
+  void* late = trackMalloc(32, labels[fill]);
+  CHECK(getAllocationSiteCount() == MAX_ALLOCATION_SITES);
+  CHECK(fewest == findSite("late_site"));   // Same slot, new owner
+  CHECK(findSite("late_site")->liveBytes == 32 && findSite("late_site")->totalAllocs == 1);
+  bool stillThere = false;
+  for (size_t i = 0; i < getAllocationSiteCount(); i++) {
+    const AllocationSite* site = getAllocationSite(i);
+    if (strcmp(site->name, evictedName) == 0 && site->caller == evictedCaller) stillThere = true;
+  }
+  CHECK(!stillThere);
+  live.push_back(late);
+
+  // New labels take over the remaining idle sites one by one
+  for (size_t i = 1; i < used; i++) {
+    snprintf(labels[fill + i], sizeof(labels[fill + i]), "churn_%u", (unsigned)i);
+    live.push_back(trackMalloc(8, labels[fill + i]));
+    CHECK(findSite(labels[fill + i]) != nullptr);
+  }
+  for (size_t i = 0; i < getAllocationSiteCount(); i++) {
+    CHECK(getAllocationSite(i)->liveCount > 0);
+  }
+
+  // Every site live: a new label is allocated but cannot be tracked
+  size_t trackedBefore = resourceManager.getTrackedAllocations();
+  void* overflow = trackMalloc(64, "overflow_site");
+  CHECK(overflow != nullptr);
+  CHECK(findSite("overflow_site") == nullptr);
+  CHECK(resourceManager.getTrackedAllocations() == trackedBefore);
+  free(overflow);   // trackFree would find no record either
+
+  snapshot();
+  char counters[64];
+  snprintf(counters, sizeof(counters), "\"untracked\":1,\"evicted\":%u}", (unsigned)used);
+  CHECK(snapshotLog.find(counters) != std::string::npos);
+
+  for (void* p : live) trackFree(p);
+  CHECK(resourceManager.getTrackedAllocations() == 0);
+}
+
+int main() {
+  initResourceManager();
+  testAggregation();
+  testReconnectStorm();
+  testSiteEviction();
+
+  FILE* f = fopen("heap_snapshots.log", "w");
+  if (f) {
+    fputs(snapshotLog.c_str(), f);
+    fclose(f);
+  }
+  printf("BENCH tracker tables %zu bytes (%d records x %zu, %d sites x %zu)\n",
+         sizeof(AllocationRecord) * MAX_TRACKED_RESOURCES + sizeof(AllocationSite) * MAX_ALLOCATION_SITES,
+         MAX_TRACKED_RESOURCES, sizeof(AllocationRecord), MAX_ALLOCATION_SITES, sizeof(AllocationSite));
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
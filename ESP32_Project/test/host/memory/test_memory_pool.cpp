@@ -0,0 +1,255 @@
+// MemoryPool and the size-classed poolAlloc() front end: bitmap claim and
+// release under contention, the half-block size-class rule, the malloc
+// fallback, double and interior frees, and alloc/free cost against malloc
+#include <resource_manager.h>
+#include <metrics_registry.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+static MemoryPoolStats poolStats(size_t index) {
+  MemoryPoolStats st = {};
+  getMemoryPoolStats(index, st);
+  return st;
+}
+
+// =============================================================================
+// BITMAP
+// =============================================================================
+
+static void testBitmap() {
+  // Block sizes round up to 4 bytes; 33 blocks leave 31 padding bits in word 1
+  MemoryPool pool(33 * 64, 61);
+  CHECK(pool.getBlockSize() == 64);
+  CHECK(pool.getFreeBlocks() == 33);
+  long heapBefore = hostHeap.allocs;
+
+  std::vector<uint8_t*> blocks;
+  for (int i = 0; i < 33; i++) {
+    uint8_t* p = (uint8_t*)pool.allocate();
+    CHECK(p != nullptr && pool.owns(p));
+    blocks.push_back(p);
+  }
+  CHECK(hostHeap.allocs == heapBefore + 1);   // Storage reserved once, on first use
+  CHECK(pool.allocate() == nullptr);           // Padding bits are never handed out
+  CHECK(pool.getFreeBlocks() == 0);
+
+  // Lowest free bit first; every block distinct and block-aligned
+  for (int i = 1; i < 33; i++) CHECK(blocks[i] - blocks[i - 1] == 64);
+
+  pool.deallocate(blocks[5]);
+  pool.deallocate(blocks[32]);
+  CHECK(pool.allocate() == blocks[5]);
+  CHECK(pool.allocate() == blocks[32]);
+
+  for (uint8_t* p : blocks) pool.deallocate(p);
+  MemoryPoolStats st = pool.getStats();
+  CHECK(st.usedBlocks == 0 && st.highWater == 33 && st.allocations == 35 && st.exhausted == 1);
+  CHECK(!st.inPsram);
+  CHECK(!pool.owns(blocks[0] + 33 * 64));
+  CHECK(hostHeap.allocs == heapBefore + 1);
+}
+
+// Every thread stamps the blocks it holds; a block handed out twice shows up
+// as a foreign stamp
+static void testContention() {
+  const int THREADS = 4;
+  const int ROUNDS = 200000;
+  MemoryPool pool(40 * 128, 128);
+  std::atomic<long> claimed(0), failed(0), collisions(0);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; t++) {
+    threads.emplace_back([&, t] {
+      hostCoreId = t & 1;
+      uint8_t* held[12];
+      for (int round = 0; round < ROUNDS; round++) {
+        int n = 1 + round % 12;   // 4 x 12 > 40: the pool runs dry now and then
+        int got = 0;
+        for (int i = 0; i < n; i++) {
+          uint8_t* p = (uint8_t*)pool.allocate();
+          if (p == nullptr) {
+            failed++;
+            continue;
+          }
+          memset(p, t + 1, 128);
+          held[got++] = p;
+        }
+        claimed += got;
+        for (int i = 0; i < got; i++) {
+          if (held[i][0] != t + 1 || held[i][127] != t + 1) collisions++;
+          pool.deallocate(held[i]);
+        }
+      }
+    });
+  }
+  for (std::thread& th : threads) th.join();
+
+  MemoryPoolStats st = pool.getStats();
+  CHECK(collisions == 0);
+  CHECK(st.usedBlocks == 0 && pool.getFreeBlocks() == 40);
+  CHECK(st.allocations == (uint32_t)claimed.load());
+  CHECK(st.exhausted == (uint32_t)failed.load());
+  CHECK(st.highWater <= 40 && st.highWater > 12);
+  printf("BENCH contention %d threads: %ld claims, %ld exhausted, high water %u/40\n",
+         THREADS, claimed.load(), failed.load(), (unsigned)st.highWater);
+}
+
+// =============================================================================
+// SIZE CLASSES AND FALLBACK
+// =============================================================================
+
+static void testSizeClasses() {
+  CHECK(getMemoryPoolCount() == 2);
+  size_t small = poolStats(0).blockSize;
+  size_t large = poolStats(1).blockSize;
+  CHECK(small == 4112 && large == 6144);
+
+  struct Case {
+    size_t size;
+    int pool;   // -1: malloc
+  };
+  const Case cases[] = {
+    {0, -1},
+    {100, -1},
+    {small / 2, -1},        // Exactly half a block: not worth a block
+    {small / 2 + 1, 0},
+    {small, 0},
+    {small + 1, 1},         // Next class up, still more than half of it
+    {large / 2, 0},         // More than half the smallest class that fits it
+    {large, 1},
+    {large + 1, -1},        // Over POOL_ALLOCATION_THRESHOLD
+  };
+  for (const Case& c : cases) {
+    uint32_t fallbacks = getPoolFallbackCount();
+    size_t used0 = poolStats(0).usedBlocks, used1 = poolStats(1).usedBlocks;
+    void* p = poolAlloc(c.size);
+    int served = poolStats(0).usedBlocks > used0 ? 0 : poolStats(1).usedBlocks > used1 ? 1 : -1;
+    CHECK(served == c.pool);
+    CHECK(getPoolFallbackCount() == fallbacks + (served < 0 ? 1 : 0));
+    poolFree(p);
+    CHECK(poolStats(0).usedBlocks == used0 && poolStats(1).usedBlocks == used1);
+  }
+}
+
+// An exhausted class spills to malloc and never borrows the next class
+static void testFallback() {
+  MetricId fallbackMetric = findMetric(METRIC_COUNTER, "pool.fallback");
+  CHECK(fallbackMetric != METRIC_INVALID);
+  uint32_t metricBefore = getCounterValue(fallbackMetric);
+  uint32_t fallbacks = getPoolFallbackCount();
+
+  size_t blocks = poolStats(0).totalBlocks;
+  std::vector<void*> frames;
+  for (size_t i = 0; i < blocks; i++) frames.push_back(poolAlloc(4000));
+  CHECK(poolStats(0).usedBlocks == blocks && getPoolFallbackCount() == fallbacks);
+
+  void* spilled = poolAlloc(4000);
+  CHECK(spilled != nullptr);
+  CHECK(poolStats(1).usedBlocks == 0);
+  CHECK(getPoolFallbackCount() == fallbacks + 1);
+  CHECK(getCounterValue(fallbackMetric) == metricBefore + 1);
+  CHECK(poolStats(0).exhausted >= 1);
+  memset(spilled, 0xAB, 4000);
+  poolFree(spilled);   // Not pool-owned: back to free()
+
+  for (void* p : frames) poolFree(p);
+  CHECK(poolStats(0).usedBlocks == 0);
+  poolFree(nullptr);
+
+  // Steady streaming: one frame in flight at a time never falls back
+  fallbacks = getPoolFallbackCount();
+  for (int i = 0; i < 10000; i++) {
+    void* pcm = poolAlloc(4112);
+    void* text = poolAlloc(5800);
+    poolFree(pcm);
+    poolFree(text);
+  }
+  CHECK(getPoolFallbackCount() == fallbacks);
+}
+
+// =============================================================================
+// INVALID FREES
+// =============================================================================
+
+static void testInvalidFrees() {
+  MemoryPool pool(8 * 32, 32);
+  uint8_t* a = (uint8_t*)pool.allocate();
+  uint8_t* b = (uint8_t*)pool.allocate();
+
+  std::string log;
+  Serial.capture = &log;
+  pool.deallocate(a);
+  CHECK(log.empty());
+  pool.deallocate(a);
+  CHECK(log.find("double free of block 0") != std::string::npos);
+  CHECK(pool.getUsedBlocks() == 1);   // Counted once
+
+  log.clear();
+  pool.deallocate(b + 4);
+  CHECK(log.find("interior pointer") != std::string::npos);
+  CHECK(pool.getUsedBlocks() == 1);   // b stays claimed
+
+  log.clear();
+  int notOurs;
+  pool.deallocate(&notOurs);   // Foreign pointers are ignored
+  CHECK(log.empty());
+  Serial.capture = nullptr;
+
+  pool.deallocate(b);
+  CHECK(pool.getUsedBlocks() == 0 && pool.getFreeBlocks() == 8);
+  CHECK(pool.allocate() == a);
+}
+
+// =============================================================================
+// COST
+// =============================================================================
+
+template <typename Alloc, typename Free>
+static double pairNs(Alloc alloc, Free release, int count) {
+  void* held[3];
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; i++) {
+    for (void*& p : held) {
+      p = alloc();
+      *(volatile uint8_t*)p = (uint8_t)i;
+    }
+    for (void* p : held) release(p);
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (3.0 * count);
+}
+
+static void testCost() {
+  const int N = 300000;
+  uint32_t fallbacks = getPoolFallbackCount();
+  double pool = pairNs([] { return poolAlloc(4112); }, [](void* p) { poolFree(p); }, N);
+  double heap = pairNs([] { return malloc(4112); }, [](void* p) { free(p); }, N);
+  CHECK(getPoolFallbackCount() == fallbacks);
+  printf("BENCH poolAlloc+poolFree %.1f ns, malloc+free %.1f ns (4112 B, 3 in flight)\n", pool, heap);
+}
+
+int main() {
+  initMetricsRegistry();
+  initResourceManager();
+  testBitmap();
+  testContention();
+  testSizeClasses();
+  testFallback();
+  testInvalidFrees();
+  testCost();
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
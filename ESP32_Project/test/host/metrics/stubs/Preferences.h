@@ -0,0 +1,18 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include <cstring>
+// In-memory NVS that survives the simulated reboots of one process
+extern std::map<std::string, std::vector<uint8_t>> nvsStore;
+extern int nvsWrites;
+class Preferences {
+  std::string ns; bool ro = true;
+public:
+  bool begin(const char* n, bool readOnly) { ns = n; ro = readOnly; return true; }
+  void end() {}
+  size_t getBytesLength(const char* k) { auto it = nvsStore.find(ns + "/" + k); return it == nvsStore.end() ? 0 : it->second.size(); }
+  size_t getBytes(const char* k, void* b, size_t n) { auto it = nvsStore.find(ns + "/" + k); if (it == nvsStore.end() || it->second.size() > n) return 0; memcpy(b, it->second.data(), it->second.size()); return it->second.size(); }
+  size_t putBytes(const char* k, const void* b, size_t n) { if (ro) return 0; nvsWrites++; nvsStore[ns + "/" + k].assign((const uint8_t*)b, (const uint8_t*)b + n); return n; }
+  bool remove(const char* k) { return nvsStore.erase(ns + "/" + k) > 0; }
+};
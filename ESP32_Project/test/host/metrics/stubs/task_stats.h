@@ -0,0 +1,4 @@
+#pragma once
+// CPU load is set by the test
+extern float hostCpuPercent;
+inline float getTotalCpuPercent() { return hostCpuPercent; }
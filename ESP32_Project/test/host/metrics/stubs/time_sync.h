@@ -0,0 +1,7 @@
+#pragma once
+// Wall clock and NTP state are set by the test
+#include <ctime>
+extern bool hostTimeSynced;
+extern time_t hostEpoch;
+inline bool isTimeSynced() { return hostTimeSynced; }
+inline time_t getCurrentTimestamp() { return hostTimeSynced ? hostEpoch : 0; }
@@ -0,0 +1,412 @@
+// Metrics history (RRD): seconds consolidated into minutes and minutes into
+// hours (rounded average, worst extreme, the known-input threshold, sparse
+// latency series), blocked-loop seconds, every ring wrapping, the NVS blob
+// size and write count, and restores across restarts with and without a
+// synced clock. Each boot runs in a child process so it starts with fresh
+// statics, as after a restart; the NVS blob is handed to the next one.
+#include <metrics_history.h>
+#include <metrics_registry.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <websocket_handler.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+std::map<std::string, std::vector<uint8_t>> nvsStore;
+int nvsWrites = 0;
+bool hostTimeSynced = true;
+time_t hostEpoch = 1760000000;
+float hostCpuPercent = 0;
+WiFiStub WiFi;
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+static const char* NVS_KEY = HISTORY_NVS_NAMESPACE "/rrd";
+static MetricId audioLatency = METRIC_INVALID;
+
+// Wall clock and uptime move together; one sample per call
+static void advance(uint32_t seconds) {
+  simUs += (uint64_t)seconds * 1000000;
+  hostEpoch += seconds;
+  handleMetricsHistory();
+}
+
+static void tick() {
+  advance(1);
+}
+
+static void setHeapStored(int16_t stored) {
+  hostHeap.freeBytes = (size_t)stored * 16;
+}
+
+static HistoryPoint point(HistoryResolution res, HistorySeries series, uint16_t index) {
+  HistoryPoint p = {HISTORY_UNKNOWN, HISTORY_UNKNOWN};
+  CHECK(getHistoryPoint(res, series, index, p));
+  return p;
+}
+
+static bool pointIs(HistoryResolution res, HistorySeries series, uint16_t index, int16_t avg, int16_t worst) {
+  HistoryPoint p = point(res, series, index);
+  if (p.avg == avg && p.worst == worst) return true;
+  printf("  %s[%u]: got %d/%d, expected %d/%d\n", getHistorySeriesName(series), index, p.avg, p.worst, avg, worst);
+  return false;
+}
+
+static bool isUnknown(HistoryResolution res, HistorySeries series, uint16_t index) {
+  return pointIs(res, series, index, HISTORY_UNKNOWN, HISTORY_UNKNOWN);
+}
+
+static void boot(std::string* log = nullptr) {
+  initMetricsRegistry();
+  audioLatency = registerHistogram("audio.latency", "ms");   // As initMonitoring() does
+  Serial.capture = log;
+  CHECK(initMetricsHistory());
+  Serial.capture = nullptr;
+}
+
+// =============================================================================
+// FIRST BOOT: CONSOLIDATION
+// =============================================================================
+
+static void testSecondsIntoMinute() {
+  // Latency percentiles are bucket midpoints: 175 is exact in [160, 191], 351 in [320, 383]
+  for (int i = 0; i < 60; i++) {
+    setHeapStored((int16_t)(10000 + i));
+    hostHeap.largestBlock = 100000;
+    WiFi.rssi = i % 2 ? -61 : -60;
+    hostCpuPercent = (float)(i % 10);
+    if (i == 10) metricObserve(audioLatency, 175);
+    if (i == 20) {
+      metricObserve(audioLatency, 175);
+      metricObserve(audioLatency, 351);
+    }
+    tick();
+  }
+
+  CHECK(getHistoryPointCount(HISTORY_RES_SECOND) == 60);
+  CHECK(getHistoryPointCount(HISTORY_RES_MINUTE) == 1);
+  CHECK(pointIs(HISTORY_RES_SECOND, HISTORY_HEAP_FREE, 0, 10000, 10000));
+  CHECK(pointIs(HISTORY_RES_SECOND, HISTORY_HEAP_FREE, 59, 10059, 10059));
+  CHECK(historyToUnits(HISTORY_HEAP_FREE, 10059) == 10059 * 16);
+  CHECK(pointIs(HISTORY_RES_SECOND, HISTORY_AUDIO_LATENCY_P99, 20, 351, 351));
+  CHECK(isUnknown(HISTORY_RES_SECOND, HISTORY_AUDIO_LATENCY_P50, 21));   // No observations that second
+
+  // Averages round half away from zero; worst is the lowest heap and RSSI,
+  // the highest CPU and latency
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_HEAP_FREE, 0, 10030, 10000));         // 10029.5
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_HEAP_LARGEST, 0, 6250, 6250));
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_WIFI_RSSI, 0, -61, -61));             // -60.5
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_CPU, 0, 5, 9));                       // 4.5
+  // Sparse: two seconds with observations are enough for a known minute
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_AUDIO_LATENCY_P50, 0, 175, 175));
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_AUDIO_LATENCY_P99, 0, 263, 351));     // (175 + 351) / 2
+  CHECK(isUnknown(HISTORY_RES_MINUTE, HISTORY_WS_RTT_P50, 0));                    // ws.rtt never registered
+}
+
+static void testKnownThreshold() {
+  // Exactly half the seconds known still makes a known minute
+  setHeapStored(10000);
+  hostCpuPercent = 20;
+  for (int i = 0; i < 60; i++) {
+    WiFi.linkStatus = i < 30 ? WL_DISCONNECTED : WL_CONNECTED;
+    WiFi.rssi = -70;
+    tick();
+  }
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_WIFI_RSSI, 1, -70, -70));
+
+  // One more second down and it is unknown
+  for (int i = 0; i < 60; i++) {
+    WiFi.linkStatus = i < 31 ? WL_DISCONNECTED : WL_CONNECTED;
+    tick();
+  }
+  CHECK(isUnknown(HISTORY_RES_MINUTE, HISTORY_WIFI_RSSI, 2));
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_HEAP_FREE, 2, 10000, 10000));
+  WiFi.rssi = -60;
+
+  // Loop blocked for 32 s: 31 seconds are unknown, not interpolated, and
+  // 29 known of 60 is too few
+  for (int i = 0; i < 28; i++) tick();
+  advance(32);
+  CHECK(getHistoryPointCount(HISTORY_RES_MINUTE) == 4);
+  CHECK(isUnknown(HISTORY_RES_MINUTE, HISTORY_HEAP_FREE, 3));
+  CHECK(isUnknown(HISTORY_RES_MINUTE, HISTORY_WIFI_RSSI, 3));
+  CHECK(pointIs(HISTORY_RES_SECOND, HISTORY_HEAP_FREE, 27, 10000, 10000));
+  CHECK(isUnknown(HISTORY_RES_SECOND, HISTORY_HEAP_FREE, 28));
+  CHECK(isUnknown(HISTORY_RES_SECOND, HISTORY_HEAP_FREE, 58));
+  CHECK(pointIs(HISTORY_RES_SECOND, HISTORY_HEAP_FREE, 59, 10000, 10000));
+}
+
+static void testMinutesIntoHour() {
+  // Minutes 5 to 60, with a heap dip in minute 30 and a CPU spike in minute 45
+  for (int m = 4; m < 60; m++) {
+    for (int i = 0; i < 60; i++) {
+      setHeapStored(m == 29 && i == 0 ? 9000 : 10000);
+      hostCpuPercent = m == 44 && i == 0 ? 95.0f : 20.0f;
+      tick();
+    }
+  }
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_HEAP_FREE, 29, 9983, 9000));   // 9983.3
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_CPU, 44, 21, 95));             // 21.25
+
+  // The hour averages the minute averages it has (59 heap, 58 RSSI) and keeps
+  // the worst minute worst
+  CHECK(getHistoryPointCount(HISTORY_RES_HOUR) == 1);
+  CHECK(pointIs(HISTORY_RES_HOUR, HISTORY_HEAP_FREE, 0, 10000, 9000));     // 590013 / 59
+  CHECK(pointIs(HISTORY_RES_HOUR, HISTORY_WIFI_RSSI, 0, -60, -70));        // -3491 / 58
+  CHECK(pointIs(HISTORY_RES_HOUR, HISTORY_CPU, 0, 20, 95));                // 1166 / 59
+  CHECK(pointIs(HISTORY_RES_HOUR, HISTORY_AUDIO_LATENCY_P99, 0, 263, 351));
+  CHECK(isUnknown(HISTORY_RES_HOUR, HISTORY_WS_RTT_P99, 0));
+
+  // The closed hour was saved
+  CHECK(nvsWrites == 1);
+}
+
+static void testExport() {
+  DynamicJsonDocument doc(HISTORY_JSON_CAPACITY);
+  JsonObject out = doc.to<JsonObject>();
+  exportHistorySeries(out, HISTORY_RES_MINUTE, HISTORY_WIFI_RSSI);
+  CHECK(!doc.overflowed());
+  CHECK(strcmp(out["series"] | "", "wifi.rssi") == 0 && out["step_s"] == 60);
+  CHECK(out["avg"].size() == 60 && out["worst"].size() == 60);
+  CHECK(out["avg"][1] == -70 && out["avg"][2].isNull() && out["worst"][0] == -61);
+  CHECK(out["newest_minute_epoch"] == (uint32_t)hostEpoch);
+
+  doc.clear();
+  out = doc.to<JsonObject>();
+  exportHistorySeries(out, HISTORY_RES_SECOND, HISTORY_HEAP_FREE);
+  CHECK(out["avg"][59] == 10000 * 16);
+  CHECK(!out.containsKey("worst") && !out.containsKey("newest_minute_epoch"));
+
+  // One message per series; full minute archives fit the document
+  std::string log;
+  isConnected = true;
+  webSocket.sent.clear();
+  Serial.capture = &log;
+  CHECK(sendMetricsHistory(HISTORY_RES_MINUTE));
+  Serial.capture = nullptr;
+  CHECK(webSocket.sent.size() == HISTORY_SERIES_COUNT);
+  CHECK(log.find("truncated") == std::string::npos);
+  CHECK(webSocket.sent[HISTORY_AUDIO_LATENCY_P50].find("\"series\":\"audio.latency.p50\"") != std::string::npos);
+  CHECK(sendMetricsHistory(HISTORY_RES_HOUR, HISTORY_CPU) && webSocket.sent.size() == HISTORY_SERIES_COUNT + 1);
+  CHECK(!sendMetricsHistory(HISTORY_RES_HOUR, HISTORY_SERIES_COUNT));
+  isConnected = false;
+  CHECK(!sendMetricsHistory(HISTORY_RES_HOUR));
+}
+
+// =============================================================================
+// FIRST BOOT: WRAPAROUND AND NVS FOOTPRINT
+// =============================================================================
+
+// 49 more hours: every ring wraps. CPU is the hour number, heap the minute
+// within the hour.
+static void testWraparound() {
+  WiFi.linkStatus = WL_CONNECTED;
+  for (int h = 1; h < 50; h++) {
+    for (int s = 0; s < 3600; s++) {
+      hostCpuPercent = (float)h;
+      setHeapStored((int16_t)(11000 + (h == 49 && s >= 3540 ? 100 + s % 60 : s / 60)));
+      tick();
+    }
+  }
+
+  CHECK(getHistoryPointCount(HISTORY_RES_SECOND) == HISTORY_SECONDS);
+  CHECK(getHistoryPointCount(HISTORY_RES_MINUTE) == HISTORY_MINUTES);
+  CHECK(getHistoryPointCount(HISTORY_RES_HOUR) == HISTORY_HOURS);
+  bool inOrder = true;
+  for (uint16_t i = 0; i < HISTORY_HOURS; i++) {
+    inOrder = pointIs(HISTORY_RES_HOUR, HISTORY_CPU, i, (int16_t)(i + 2), (int16_t)(i + 2)) && inOrder;
+  }
+  for (uint16_t i = 0; i < HISTORY_MINUTES - 1; i++) {
+    inOrder = pointIs(HISTORY_RES_MINUTE, HISTORY_HEAP_FREE, i, (int16_t)(11000 + i), (int16_t)(11000 + i)) && inOrder;
+  }
+  for (uint16_t i = 0; i < HISTORY_SECONDS; i++) {
+    inOrder = pointIs(HISTORY_RES_SECOND, HISTORY_HEAP_FREE, i, (int16_t)(11100 + i), (int16_t)(11100 + i)) && inOrder;
+  }
+  CHECK(inOrder);   // Index 0 is the oldest point in every ring
+  HistoryPoint out;
+  CHECK(!getHistoryPoint(HISTORY_RES_HOUR, HISTORY_CPU, HISTORY_HOURS, out));
+  CHECK(!getHistoryPoint(HISTORY_RES_HOUR, HISTORY_SERIES_COUNT, 0, out));
+}
+
+static void testNvsFootprint() {
+  // One write per closed hour and none in between
+  CHECK(nvsWrites == 50);
+  size_t blob = nvsStore[NVS_KEY].size();
+  CHECK(blob > 0 && blob <= 4096);
+
+  // Saving again before a restart writes nothing when nothing closed
+  tick();
+  CHECK(saveMetricsHistory());
+  CHECK(nvsWrites == 50);
+
+  printf("BENCH nvs blob %zu bytes, %d writes in 50 h, %.1f KB written per day\n",
+         blob, nvsWrites, blob * 24 / 1024.0);
+}
+
+static void firstBoot() {
+  std::string log;
+  boot(&log);
+  CHECK(log.find("restored") == std::string::npos);
+  CHECK(getHistoryPointCount(HISTORY_RES_MINUTE) == 0 && getHistoryPointCount(HISTORY_RES_HOUR) == 0);
+  testSecondsIntoMinute();
+  testKnownThreshold();
+  testMinutesIntoHour();
+  testExport();
+  testWraparound();
+  testNvsFootprint();
+}
+
+// =============================================================================
+// RESTARTS
+// =============================================================================
+
+// Off for ten minutes with the clock synced: the gap is filled with unknown
+// minutes, so the archive stays aligned with wall time
+static void syncedRestart() {
+  std::string log;
+  boot(&log);
+  CHECK(log.find("restored from NVS") != std::string::npos);
+  CHECK(getHistoryPointCount(HISTORY_RES_SECOND) == 0);
+  CHECK(getHistoryPointCount(HISTORY_RES_MINUTE) == HISTORY_MINUTES);
+  CHECK(pointIs(HISTORY_RES_HOUR, HISTORY_CPU, 0, 2, 2));
+  CHECK(pointIs(HISTORY_RES_HOUR, HISTORY_CPU, HISTORY_HOURS - 1, 49, 49));
+
+  hostCpuPercent = 60;
+  log.clear();
+  Serial.capture = &log;
+  for (int i = 0; i < 60; i++) tick();
+  Serial.capture = nullptr;
+  CHECK(log.find("10 offline minute(s)") != std::string::npos);
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_HEAP_FREE, 48, 11130, 11100));   // Last minute before the restart
+  bool gap = true;
+  for (uint16_t i = 49; i < 59; i++) gap = isUnknown(HISTORY_RES_MINUTE, HISTORY_CPU, i) && gap;
+  CHECK(gap);
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_CPU, 59, 60, 60));
+
+  // The offline minutes count towards the hour: it closes 50 minutes later
+  int writes = nvsWrites;
+  for (int i = 0; i < 48 * 60; i++) tick();
+  CHECK(pointIs(HISTORY_RES_HOUR, HISTORY_CPU, HISTORY_HOURS - 1, 49, 49));
+  for (int i = 0; i < 60; i++) tick();
+  CHECK(nvsWrites == writes + 1);
+  CHECK(pointIs(HISTORY_RES_HOUR, HISTORY_CPU, HISTORY_HOURS - 1, 60, 60));
+  CHECK(pointIs(HISTORY_RES_HOUR, HISTORY_CPU, 0, 3, 3));
+}
+
+// No NTP yet: one unknown minute marks the restart
+static void unsyncedRestart() {
+  hostTimeSynced = false;
+  boot();
+  hostCpuPercent = 70;
+  for (int i = 0; i < 60; i++) tick();
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_CPU, 57, 60, 60));
+  CHECK(isUnknown(HISTORY_RES_MINUTE, HISTORY_CPU, 58));
+  CHECK(pointIs(HISTORY_RES_MINUTE, HISTORY_CPU, 59, 70, 70));
+  CHECK(getHistoryPointCount(HISTORY_RES_HOUR) == HISTORY_HOURS);
+
+  DynamicJsonDocument doc(HISTORY_JSON_CAPACITY);
+  JsonObject out = doc.to<JsonObject>();
+  exportHistorySeries(out, HISTORY_RES_MINUTE, HISTORY_CPU);
+  CHECK(!out.containsKey("newest_minute_epoch"));
+}
+
+static void corruptRestart() {
+  std::string log;
+  boot(&log);
+  CHECK(log.find("unreadable, starting empty") != std::string::npos);
+  CHECK(getHistoryPointCount(HISTORY_RES_MINUTE) == 0 && getHistoryPointCount(HISTORY_RES_HOUR) == 0);
+}
+
+static void truncatedRestart() {
+  boot();
+  CHECK(getHistoryPointCount(HISTORY_RES_MINUTE) == 0 && getHistoryPointCount(HISTORY_RES_HOUR) == 0);
+}
+
+// =============================================================================
+// BOOT HARNESS
+// =============================================================================
+
+struct BootResult {
+  std::vector<uint8_t> nvs;   // The blob left behind
+  time_t epoch;               // Wall clock at the end of the boot
+};
+
+// Runs one boot in a child with the given NVS blob; its failures are added here
+static BootResult runBoot(void (*run)(), const std::vector<uint8_t>& nvs) {
+  BootResult result = {{}, 0};
+  int fds[2];
+  if (pipe(fds) != 0) {
+    CHECK(false);
+    return result;
+  }
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    testFailures = 0;   // Only this boot's are reported back
+    if (!nvs.empty()) nvsStore[NVS_KEY] = nvs;
+    run();
+    const std::vector<uint8_t>& blob = nvsStore[NVS_KEY];
+    uint32_t size = (uint32_t)blob.size();
+    bool sent = write(fds[1], &testFailures, sizeof(testFailures)) == sizeof(testFailures) &&
+                write(fds[1], &hostEpoch, sizeof(hostEpoch)) == sizeof(hostEpoch) &&
+                write(fds[1], &size, sizeof(size)) == sizeof(size) &&
+                write(fds[1], blob.data(), size) == (ssize_t)size;
+    fflush(stdout);
+    _exit(sent ? 0 : 1);
+  }
+  close(fds[1]);
+
+  std::vector<uint8_t> bytes;
+  uint8_t chunk[4096];
+  ssize_t n;
+  while ((n = read(fds[0], chunk, sizeof(chunk))) > 0) bytes.insert(bytes.end(), chunk, chunk + n);
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  const size_t header = sizeof(int) + sizeof(time_t) + sizeof(uint32_t);
+  if (bytes.size() < header) {
+    CHECK(false);
+    return result;
+  }
+  int failures;
+  uint32_t size;
+  memcpy(&failures, bytes.data(), sizeof(failures));
+  memcpy(&result.epoch, bytes.data() + sizeof(int), sizeof(time_t));
+  memcpy(&size, bytes.data() + sizeof(int) + sizeof(time_t), sizeof(size));
+  CHECK(bytes.size() == header + size);
+  result.nvs.assign(bytes.begin() + header, bytes.end());
+  testFailures += failures;
+  return result;
+}
+
+int main() {
+  BootResult first = runBoot(firstBoot, {});
+
+  hostEpoch = first.epoch + 600;
+  BootResult second = runBoot(syncedRestart, first.nvs);
+  CHECK(second.nvs != first.nvs);
+
+  runBoot(unsyncedRestart, second.nvs);
+
+  std::vector<uint8_t> corrupt = second.nvs;
+  if (!corrupt.empty()) corrupt[0] ^= 0xff;   // Magic
+  runBoot(corruptRestart, corrupt);
+  std::vector<uint8_t> truncated(second.nvs.begin(), second.nvs.end() - (second.nvs.empty() ? 0 : 1));
+  runBoot(truncatedRestart, truncated);
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
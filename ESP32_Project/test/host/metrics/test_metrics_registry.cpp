@@ -0,0 +1,228 @@
+// Metrics registry: log-linear bucket math, percentile error against exact
+// nearest-rank percentiles, windowed percentiles, and the cost of an update
+// from one and from two cores
+#include <metrics_registry.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+// Largest relative error of a bucket midpoint (half a sub-bucket)
+static const double MAX_RELATIVE_ERROR = 1.0 / (2 * METRICS_HIST_SUB_COUNT);
+
+// =============================================================================
+// BUCKET MATH
+// =============================================================================
+
+static void testBucketMath() {
+  CHECK(METRICS_HIST_BUCKETS == 88);
+  CHECK(histogramBucketIndex(0) == 0);
+  CHECK(histogramBucketLowerBound(0) == 0);
+
+  // Buckets tile [0, 2^32) with no gaps or overlaps
+  for (uint16_t i = 0; i + 1 < METRICS_HIST_BUCKETS; i++) {
+    CHECK(histogramBucketUpperBound(i) + 1 == histogramBucketLowerBound(i + 1));
+    CHECK(histogramBucketIndex(histogramBucketLowerBound(i)) == i);
+    CHECK(histogramBucketIndex(histogramBucketUpperBound(i)) == i);
+  }
+  CHECK(histogramBucketLowerBound(METRICS_HIST_BUCKETS - 1) == (1UL << METRICS_HIST_MAX_BITS) - (1UL << (METRICS_HIST_MAX_BITS - 1 - METRICS_HIST_SUB_BITS)));
+  CHECK(histogramBucketUpperBound(METRICS_HIST_BUCKETS - 1) == UINT32_MAX);
+  CHECK(histogramBucketIndex(1UL << METRICS_HIST_MAX_BITS) == METRICS_HIST_BUCKETS - 1);
+  CHECK(histogramBucketIndex(UINT32_MAX) == METRICS_HIST_BUCKETS - 1);
+
+  // Every value lands in a bucket that contains it; index is monotonic
+  uint16_t previous = 0;
+  for (uint32_t v = 0; v < (1UL << 20); v++) {
+    uint16_t index = histogramBucketIndex(v);
+    CHECK(index >= previous && index <= previous + 1);
+    CHECK(histogramBucketLowerBound(index) <= v && v <= histogramBucketUpperBound(index));
+    previous = index;
+  }
+  std::mt19937 rng(76);
+  for (int i = 0; i < 1000000; i++) {
+    uint32_t v = rng() >> (rng() % 32);
+    uint16_t index = histogramBucketIndex(v);
+    CHECK(index < METRICS_HIST_BUCKETS);
+    CHECK(histogramBucketLowerBound(index) <= v && v <= histogramBucketUpperBound(index));
+  }
+
+  // Bucket width relative to its lower bound is the sub-bucket resolution
+  double widest = 0;
+  for (uint16_t i = METRICS_HIST_SUB_COUNT; i + 1 < METRICS_HIST_BUCKETS; i++) {
+    double width = histogramBucketUpperBound(i) - histogramBucketLowerBound(i) + 1.0;
+    widest = std::max(widest, width / histogramBucketLowerBound(i));
+  }
+  CHECK(widest <= 2 * MAX_RELATIVE_ERROR + 1e-9);
+  printf("BENCH %d buckets, widest %.1f%% of its lower bound, %zu bytes per histogram\n",
+         METRICS_HIST_BUCKETS, widest * 100, (size_t)METRICS_HIST_BUCKETS * 4 * METRICS_NUM_SHARDS);
+}
+
+// =============================================================================
+// PERCENTILE ERROR
+// =============================================================================
+
+static uint32_t exactPercentile(const std::vector<uint32_t>& sorted, double percentile) {
+  size_t rank = (size_t)ceil(percentile / 100.0 * sorted.size());
+  return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+static double relativeError(uint32_t reported, uint32_t exact) {
+  if (exact < METRICS_HIST_SUB_COUNT) return reported == exact ? 0 : 1;
+  return fabs((double)reported - exact) / exact;
+}
+
+template <typename Dist>
+static void checkDistribution(const char* name, Dist dist, int samples) {
+  MetricId id = registerHistogram(name, "us");
+  CHECK(id != METRIC_INVALID);
+  std::mt19937 rng(1234);
+  std::vector<uint32_t> values;
+  uint64_t sum = 0;
+  for (int i = 0; i < samples; i++) {
+    uint32_t v = dist(rng);
+    hostCoreId = i & 1;   // Spread over both shards
+    metricObserve(id, v);
+    values.push_back(v);
+    sum += v;
+  }
+  hostCoreId = 1;
+  std::sort(values.begin(), values.end());
+
+  HistogramSnapshot snap;
+  CHECK(getHistogramSnapshot(id, snap));
+  CHECK(snap.count == (uint32_t)samples);
+  CHECK(snap.sum == sum);
+  CHECK(snap.min == values.front());
+  CHECK(snap.max == values.back());
+
+  const double percentiles[] = {50, 90, 99, 99.9};
+  const uint32_t reported[] = {snap.p50, snap.p90, snap.p99, snap.p999};
+  double worst = 0;
+  for (int i = 0; i < 4; i++) {
+    double error = relativeError(reported[i], exactPercentile(values, percentiles[i]));
+    CHECK(error <= MAX_RELATIVE_ERROR);
+    worst = std::max(worst, error);
+  }
+  float p75 = 75.0f;
+  double error = relativeError(getHistogramPercentile(id, p75), exactPercentile(values, 75));
+  CHECK(error <= MAX_RELATIVE_ERROR);
+  worst = std::max(worst, error);
+  printf("BENCH %-18s p50=%-8u p99=%-8u worst percentile error %.2f%% (bound %.1f%%)\n",
+         name, snap.p50, snap.p99, worst * 100, MAX_RELATIVE_ERROR * 100);
+}
+
+static void testPercentiles() {
+  checkDistribution("test.uniform", [](std::mt19937& rng) { return (uint32_t)(rng() % 100000); }, 200000);
+  checkDistribution("test.lognormal", [](std::mt19937& rng) {
+    static std::lognormal_distribution<double> d(6.0, 1.2);
+    return (uint32_t)d(rng);
+  }, 200000);
+  checkDistribution("test.small", [](std::mt19937& rng) { return (uint32_t)(rng() % 6); }, 10000);
+  checkDistribution("test.bimodal", [](std::mt19937& rng) {
+    return (uint32_t)((rng() % 10 == 0) ? 400000 + rng() % 50000 : 800 + rng() % 200);
+  }, 100000);
+
+  // Registration is idempotent; an empty histogram reports zeros
+  CHECK(registerHistogram("test.uniform") == findMetric(METRIC_HISTOGRAM, "test.uniform"));
+  MetricId empty = registerHistogram("test.empty", "ms");
+  HistogramSnapshot snap;
+  CHECK(getHistogramSnapshot(empty, snap) && snap.count == 0 && snap.min == 0 && snap.p99 == 0);
+  CHECK(!getHistogramSnapshot(METRIC_INVALID, snap));
+  metricObserve(METRIC_INVALID, 5);   // Ignored
+}
+
+// Windowed percentiles only see observations since the previous call
+static void testWindow() {
+  MetricId id = registerHistogram("test.window", "ms");
+  HistogramWindow window = {};
+  const float percentiles[] = {50.0f, 99.0f};
+  uint32_t results[2];
+
+  for (int i = 0; i < 1000; i++) metricObserve(id, 100);
+  CHECK(getHistogramWindow(id, window, percentiles, results, 2) == 1000);
+  CHECK(relativeError(results[0], 100) <= MAX_RELATIVE_ERROR);
+
+  for (int i = 0; i < 500; i++) metricObserve(id, 5000);
+  CHECK(getHistogramWindow(id, window, percentiles, results, 2) == 500);
+  CHECK(relativeError(results[0], 5000) <= MAX_RELATIVE_ERROR);
+  CHECK(relativeError(results[1], 5000) <= MAX_RELATIVE_ERROR);
+
+  CHECK(getHistogramWindow(id, window, percentiles, results, 2) == 0);
+  CHECK(results[0] == 0 && results[1] == 0);
+
+  // A reset registry restarts the window instead of going negative
+  resetMetricsRegistry();
+  for (int i = 0; i < 10; i++) metricObserve(id, 300);
+  CHECK(getHistogramWindow(id, window, percentiles, results, 2) == 10);
+  CHECK(relativeError(results[0], 300) <= MAX_RELATIVE_ERROR);
+}
+
+// =============================================================================
+// UPDATE COST
+// =============================================================================
+
+static double observeNs(MetricId id, int count, int core) {
+  hostCoreId = core;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; i++) {
+    metricObserve(id, (uint32_t)(i * 2654435761u) >> 12);
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+}
+
+static void testUpdateCost() {
+  const int N = 2000000;
+  MetricId hist = registerHistogram("test.cost", "us");
+  MetricId counter = registerCounter("test.count");
+
+  double single = observeNs(hist, N, 1);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < N; i++) metricIncrement(counter);
+  double incrementNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+
+  // One writer per core: no sample or increment may be lost
+  double perCore[2];
+  std::thread core0([&] { perCore[0] = observeNs(hist, N, 0); for (int i = 0; i < N; i++) metricIncrement(counter); });
+  std::thread core1([&] { perCore[1] = observeNs(hist, N, 1); for (int i = 0; i < N; i++) metricIncrement(counter); });
+  core0.join();
+  core1.join();
+
+  HistogramSnapshot snap;
+  getHistogramSnapshot(hist, snap);
+  CHECK(snap.count == 3u * N);
+  CHECK(getCounterValue(counter) == 3u * N);
+
+  // Updates never touch the heap once registered
+  long allocsBefore = hostHeap.allocs;
+  observeNs(hist, 1000, 0);
+  for (int i = 0; i < 1000; i++) metricIncrement(counter);
+  CHECK(hostHeap.allocs == allocsBefore);
+
+  printf("BENCH metricObserve %.1f ns one core, %.1f / %.1f ns two cores; metricIncrement %.1f ns\n",
+         single, perCore[0], perCore[1], incrementNs);
+}
+
+int main() {
+  initMetricsRegistry();
+  testBucketMath();
+  testPercentiles();
+  testWindow();
+  testUpdateCost();
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
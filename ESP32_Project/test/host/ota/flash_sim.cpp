@@ -0,0 +1,150 @@
+#include "flash_sim.h"
+#include <mutex>
+
+SerialStub Serial;
+double hostDelayScale = 1.0;
+int testFailures = 0;
+
+const FlashTiming FLASH_TIMING_DEVICE = {40, 160, 2.0};
+const FlashTiming FLASH_TIMING_NONE = {0, 0, 0};
+
+FlashSim flashSim = {
+  {0x10000, FLASH_SIM_PARTITION_SIZE, "app1"},
+  {0x190000, FLASH_SIM_PARTITION_SIZE, "app0"},
+  std::vector<uint8_t>(FLASH_SIM_PARTITION_SIZE, 0x5A),
+  std::vector<uint8_t>(FLASH_SIM_PARTITION_SIZE, 0xFF),
+  FLASH_TIMING_NONE,
+  {0},
+  {0},
+};
+
+static std::mutex flashLock;   // One SPI bus
+
+static void busy(double ms) {
+  if (ms > 0) std::this_thread::sleep_for(std::chrono::microseconds((long)(ms * 1000)));
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+  if (partition != &flashSim.update || offset % 4096 || size % 4096 || offset + size > FLASH_SIM_PARTITION_SIZE) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  std::lock_guard<std::mutex> lock(flashLock);
+  memset(flashSim.updateFlash.data() + offset, 0xFF, size);
+  // 64 KB block erase where aligned, sector erase elsewhere
+  size_t p = offset, end = offset + size;
+  while (p < end) {
+    if (p % 65536 == 0 && end - p >= 65536) {
+      busy(flashSim.timing.blockEraseMs);
+      p += 65536;
+    } else {
+      busy(flashSim.timing.sectorEraseMs);
+      p += 4096;
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset, const void* src, size_t size) {
+  if (partition != &flashSim.update || offset + size > FLASH_SIM_PARTITION_SIZE) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  std::lock_guard<std::mutex> lock(flashLock);
+  uint8_t* dst = flashSim.updateFlash.data() + offset;
+  const uint8_t* s = (const uint8_t*)src;
+  for (size_t i = 0; i < size; i++) {
+    if ((dst[i] & s[i]) != s[i]) flashSim.badWrites++;
+    dst[i] &= s[i];
+  }
+  busy(flashSim.timing.writeMsPerKb * size / 1024.0);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* dst, size_t size) {
+  if (offset + size > FLASH_SIM_PARTITION_SIZE) return ESP_ERR_INVALID_SIZE;
+  std::lock_guard<std::mutex> lock(flashLock);
+  const std::vector<uint8_t>& flash = partition == &flashSim.running ? flashSim.runningFlash : flashSim.updateFlash;
+  memcpy(dst, flash.data() + offset, size);
+  return ESP_OK;
+}
+
+const char* esp_err_to_name(esp_err_t code) { return code == ESP_OK ? "ESP_OK" : "ESP_FAIL"; }
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t*) { return &flashSim.update; }
+const esp_partition_t* esp_ota_get_running_partition() { return &flashSim.running; }
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t*) {
+  flashSim.bootSet++;
+  return ESP_OK;
+}
+
+void flashSimWipe() {
+  std::lock_guard<std::mutex> lock(flashLock);
+  std::fill(flashSim.updateFlash.begin(), flashSim.updateFlash.end(), 0x5A);
+  flashSim.bootSet = 0;
+  flashSim.badWrites = 0;
+}
+
+void flashSimSetRunning(const std::vector<uint8_t>& image) {
+  std::fill(flashSim.runningFlash.begin(), flashSim.runningFlash.end(), 0xFF);
+  memcpy(flashSim.runningFlash.data(), image.data(), image.size());
+}
+
+bool flashSimUpdateMatches(const std::vector<uint8_t>& image) {
+  std::lock_guard<std::mutex> lock(flashLock);
+  return memcmp(flashSim.updateFlash.data(), image.data(), image.size()) == 0;
+}
+
+PacedClient::PacedClient(const std::vector<uint8_t>& data, double rateKBs, size_t cutAt)
+    : data(data), rate(rateKBs), cutAt(cutAt ? cutAt : data.size()), last(micros()) {}
+
+void PacedClient::advance() {
+  if (rate <= 0) {
+    inFlight = cutAt - pos;
+    return;
+  }
+  uint32_t now = micros();
+  credit += (now - last) * rate * 1024 / 1e6;
+  last = now;
+  size_t room = std::min(pos + 5744, cutAt);
+  if (pos + (size_t)credit + inFlight > room) credit = room - pos - inFlight;
+  size_t n = (size_t)credit;
+  inFlight += n;
+  credit -= n;
+}
+
+int PacedClient::available() {
+  advance();
+  return (int)inFlight;
+}
+
+int PacedClient::read(uint8_t* buffer, size_t size) {
+  advance();
+  size = std::min(size, inFlight);
+  memcpy(buffer, data.data() + pos, size);
+  pos += size;
+  inFlight -= size;
+  return (int)size;
+}
+
+uint8_t PacedClient::connected() { return pos < cutAt; }
+
+std::vector<uint8_t> randomImage(size_t size, unsigned seed) {
+  std::vector<uint8_t> image(size);
+  srand(seed);
+  for (uint8_t& b : image) b = rand();
+  image[0] = ESP_IMAGE_HEADER_MAGIC;
+  return image;
+}
+
+std::vector<uint8_t> loadFile(const char* path) {
+  std::vector<uint8_t> data;
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    exit(2);
+  }
+  fseek(f, 0, SEEK_END);
+  data.resize(ftell(f));
+  fseek(f, 0, SEEK_SET);
+  if (fread(data.data(), 1, data.size(), f) != data.size()) exit(2);
+  fclose(f);
+  return data;
+}
@@ -0,0 +1,78 @@
+#pragma once
+// Simulated OTA flash for the host tests
+//
+// Two app partitions in memory: the update partition the installers write,
+// and the running image ota_delta reads as its base. Writes follow NOR rules
+// (bits only clear; setting one without an erase is counted in badWrites).
+// Erase and program can be given device timings, so the pipeline's overlap
+// of network and flash shows in wall-clock time.
+#include <Arduino.h>
+#include <Client.h>
+#include <esp_ota_ops.h>
+#include <esp_image_format.h>
+#include <atomic>
+#include <vector>
+
+#define FLASH_SIM_PARTITION_SIZE 0x180000
+
+struct FlashTiming {
+  double sectorEraseMs;   // 4 KB
+  double blockEraseMs;    // 64 KB, aligned
+  double writeMsPerKb;
+};
+
+// ESP32 (W25Q32) typical figures
+extern const FlashTiming FLASH_TIMING_DEVICE;
+extern const FlashTiming FLASH_TIMING_NONE;
+
+struct FlashSim {
+  esp_partition_t update;
+  esp_partition_t running;
+  std::vector<uint8_t> updateFlash;
+  std::vector<uint8_t> runningFlash;
+  FlashTiming timing;
+  std::atomic<int> bootSet;
+  std::atomic<int> badWrites;
+};
+
+extern FlashSim flashSim;
+
+// Fills the update partition with junk, clears the counters
+void flashSimWipe();
+// Puts an image in the running partition (rest erased)
+void flashSimSetRunning(const std::vector<uint8_t>& image);
+bool flashSimUpdateMatches(const std::vector<uint8_t>& image);
+
+// Serves data at rateKBs while the receive window (lwIP TCP_WND, 5744 bytes)
+// has room; rate 0 delivers everything at once. The connection closes at cutAt.
+class PacedClient : public Client {
+public:
+  PacedClient(const std::vector<uint8_t>& data, double rateKBs, size_t cutAt = 0);
+  int available() override;
+  int read(uint8_t* buffer, size_t size) override;
+  uint8_t connected() override;
+
+private:
+  void advance();
+  const std::vector<uint8_t>& data;
+  double rate;
+  size_t cutAt;
+  size_t pos = 0;
+  size_t inFlight = 0;
+  double credit = 0;
+  uint32_t last;
+};
+
+std::vector<uint8_t> randomImage(size_t size, unsigned seed);
+// Whole file; exits when it cannot be read
+std::vector<uint8_t> loadFile(const char* path);
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+extern int testFailures;
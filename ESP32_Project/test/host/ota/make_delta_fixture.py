@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+"""
+Delta OTA test fixture: derives a "next release" from a real firmware image
+the way a small code change does (a few KB inserted, every later code
+address shifted, a handful of constants edited), then makes the patch with
+scripts/ota_delta.py.
+
+Usage:
+  make_delta_fixture.py old.bin out_dir
+"""
+
+import random
+import struct
+import subprocess
+import sys
+from pathlib import Path
+
+INSERT_AT = 1 / 3          # Of the image
+INSERT_SIZE = 4096
+IROM_LOW, IROM_HIGH = 0x400D0000, 0x40400000   # Flash-mapped code addresses
+EDITS = 40
+
+
+def next_release(old):
+    rng = random.Random(95)
+    at = int(len(old) * INSERT_AT) & ~3
+    new = bytearray(old[:at]) + bytearray(rng.randbytes(INSERT_SIZE)) + bytearray(old[at:])
+    for i in range(at + INSERT_SIZE, len(new) - 3, 4):
+        word, = struct.unpack_from("<I", new, i)
+        if IROM_LOW <= word < IROM_HIGH:
+            struct.pack_into("<I", new, i, word + INSERT_SIZE)
+    for _ in range(EDITS):
+        new[rng.randrange(24, len(new))] = rng.randrange(256)
+    return bytes(new)
+
+
+def main():
+    old_path, out_dir = Path(sys.argv[1]), Path(sys.argv[2])
+    out_dir.mkdir(parents=True, exist_ok=True)
+    new_path = out_dir / "delta_new.bin"
+    new_path.write_bytes(next_release(old_path.read_bytes()))
+    tool = Path(__file__).resolve().parents[3] / "scripts" / "ota_delta.py"
+    subprocess.run([sys.executable, str(tool), "diff", str(old_path), str(new_path),
+                    "-o", str(out_dir / "delta.tbdp")], check=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,36 @@
+#pragma once
+// Arduino core stand-in for the OTA host tests: real time, scalable delay()
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <cstdarg>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+using std::min;
+using std::max;
+
+// delay(ms) sleeps ms * hostDelayScale (retry backoffs need not take real time)
+extern double hostDelayScale;
+
+inline uint32_t millis() {
+  static auto t0 = std::chrono::steady_clock::now();
+  return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+inline uint32_t micros() {
+  static auto t0 = std::chrono::steady_clock::now();
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+inline void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::microseconds((long)(ms * 1000 * hostDelayScale)));
+}
+
+struct SerialStub {
+  bool quiet = false;
+  void printf(const char* f, ...) { if (quiet) return; va_list a; va_start(a, f); vprintf(f, a); va_end(a); }
+  void println(const char* s) { if (!quiet) puts(s); }
+  void print(const char* s) { if (!quiet) fputs(s, stdout); }
+};
+extern SerialStub Serial;
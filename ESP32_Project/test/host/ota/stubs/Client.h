@@ -0,0 +1,9 @@
+#pragma once
+#include <Arduino.h>
+class Client {
+public:
+  virtual int available() = 0;
+  virtual int read(uint8_t* buffer, size_t size) = 0;
+  virtual uint8_t connected() = 0;
+  virtual ~Client() {}
+};
@@ -0,0 +1,25 @@
+#pragma once
+// Host stand-in for the ROM tinfl API, backed by zlib raw inflate
+#include <zlib.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+typedef enum { TINFL_STATUS_BAD_PARAM = -3, TINFL_STATUS_ADLER32_MISMATCH = -2, TINFL_STATUS_FAILED = -1,
+  TINFL_STATUS_DONE = 0, TINFL_STATUS_NEEDS_MORE_INPUT = 1, TINFL_STATUS_HAS_MORE_OUTPUT = 2 } tinfl_status;
+#define TINFL_FLAG_HAS_MORE_INPUT 2
+struct tinfl_decompressor { int m_state; z_stream z; uint8_t pad[11000]; };
+#define tinfl_init(r) do { (r)->m_state = 0; } while (0)
+inline tinfl_status tinfl_decompress(tinfl_decompressor* r, const uint8_t* in, size_t* inSize, uint8_t* outStart,
+                                     uint8_t* outNext, size_t* outSize, uint32_t flags) {
+  size_t mask = (outNext - outStart) + *outSize - 1;
+  if (((mask + 1) & mask) || outNext < outStart) return TINFL_STATUS_BAD_PARAM;
+  if (r->m_state == 0) { memset(&r->z, 0, sizeof(r->z)); inflateInit2(&r->z, -15); r->m_state = 1; }
+  if (r->m_state == 2) { *inSize = 0; *outSize = 0; return TINFL_STATUS_DONE; }
+  r->z.next_in = (Bytef*)in; r->z.avail_in = *inSize; r->z.next_out = outNext; r->z.avail_out = *outSize;
+  int rc = inflate(&r->z, Z_NO_FLUSH);
+  *inSize -= r->z.avail_in; *outSize -= r->z.avail_out;
+  if (rc == Z_STREAM_END) { r->m_state = 2; return TINFL_STATUS_DONE; }
+  if (rc != Z_OK && rc != Z_BUF_ERROR) return TINFL_STATUS_FAILED;
+  if (r->z.avail_out == 0) return TINFL_STATUS_HAS_MORE_OUTPUT;
+  return (flags & TINFL_FLAG_HAS_MORE_INPUT) ? TINFL_STATUS_NEEDS_MORE_INPUT : (tinfl_status)-4;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "FreeRTOS.h"
+
+struct TaskStub {
+  std::mutex m;
+  std::condition_variable cv;
+  uint32_t notify = 0;
+};
+typedef TaskStub* TaskHandle_t;
+
+inline TaskHandle_t& currentTask() {
+  thread_local TaskHandle_t task = new TaskStub;
+  return task;
+}
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return currentTask(); }
+inline void xTaskNotifyGive(TaskHandle_t task) {
+  std::lock_guard<std::mutex> lock(task->m);
+  task->notify++;
+  task->cv.notify_all();
+}
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) {
+  TaskHandle_t task = currentTask();
+  std::unique_lock<std::mutex> lock(task->m);
+  if (wait) task->cv.wait(lock, [&] { return task->notify > 0; });
+  uint32_t value = task->notify;
+  if (clear) task->notify = 0;
+  else if (value) task->notify--;
+  return value;
+}
+
+// vTaskDelete(NULL) unwinds the task's thread
+struct TaskExit {};
+inline BaseType_t xTaskCreate(void (*fn)(void*), const char*, uint32_t, void* arg, UBaseType_t, TaskHandle_t*) {
+  std::thread([=] {
+    try {
+      fn(arg);
+    } catch (TaskExit&) {
+    }
+  }).detach();
+  return pdPASS;
+}
+inline void vTaskDelete(void*) { throw TaskExit(); }
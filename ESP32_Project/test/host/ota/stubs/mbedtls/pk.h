@@ -0,0 +1,24 @@
+#pragma once
+// mbedtls public key API on OpenSSL (parse PEM, verify a SHA-256 digest)
+#include <openssl/pem.h>
+#include <openssl/evp.h>
+#include <cstring>
+#define MBEDTLS_MD_SHA256 6
+typedef struct { EVP_PKEY* key; } mbedtls_pk_context;
+inline void mbedtls_pk_init(mbedtls_pk_context* c) { c->key = nullptr; }
+inline void mbedtls_pk_free(mbedtls_pk_context* c) { if (c->key) EVP_PKEY_free(c->key); }
+inline int mbedtls_pk_parse_public_key(mbedtls_pk_context* c, const unsigned char* pem, size_t n) {
+  BIO* bio = BIO_new_mem_buf(pem, (int)n - 1);   // n counts the terminator
+  c->key = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
+  BIO_free(bio);
+  return c->key ? 0 : -0x3d00;
+}
+inline int mbedtls_pk_verify(mbedtls_pk_context* c, int, const unsigned char* hash, size_t hashLen,
+                             const unsigned char* sig, size_t sigLen) {
+  EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(c->key, nullptr);
+  EVP_PKEY_verify_init(ctx);
+  EVP_PKEY_CTX_set_signature_md(ctx, EVP_sha256());
+  int rc = EVP_PKEY_verify(ctx, sig, sigLen, hash, hashLen);
+  EVP_PKEY_CTX_free(ctx);
+  return rc == 1 ? 0 : -0x4e00;
+}
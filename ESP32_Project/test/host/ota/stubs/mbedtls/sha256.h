@@ -0,0 +1,11 @@
+#pragma once
+// mbedtls SHA-256 API on OpenSSL
+#define OPENSSL_SUPPRESS_DEPRECATED   // SHA256_CTX matches the mbedtls context model
+#include <openssl/sha.h>
+typedef SHA256_CTX mbedtls_sha256_context;
+inline void mbedtls_sha256_init(mbedtls_sha256_context*) {}
+inline void mbedtls_sha256_free(mbedtls_sha256_context*) {}
+inline int mbedtls_sha256_starts_ret(mbedtls_sha256_context* c, int) { SHA256_Init(c); return 0; }
+inline int mbedtls_sha256_update_ret(mbedtls_sha256_context* c, const unsigned char* d, size_t n) { SHA256_Update(c, d, n); return 0; }
+inline int mbedtls_sha256_finish_ret(mbedtls_sha256_context* c, unsigned char* out) { SHA256_Final(out, c); return 0; }
+inline void mbedtls_sha256_clone(mbedtls_sha256_context* dst, const mbedtls_sha256_context* src) { *dst = *src; }
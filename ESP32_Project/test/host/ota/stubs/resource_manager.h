@@ -0,0 +1,5 @@
+#pragma once
+// Tracked allocation stand-in: plain malloc/free
+#include <cstdlib>
+#define TRACK_MALLOC(size, name) malloc(size)
+#define TRACK_FREE(ptr, name) free(ptr)
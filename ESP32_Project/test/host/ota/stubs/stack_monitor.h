@@ -0,0 +1,3 @@
+#pragma once
+inline void registerCurrentTaskStack(const char*, uint32_t) {}
+inline void noteTaskStackExit() {}
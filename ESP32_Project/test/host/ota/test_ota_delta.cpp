@@ -0,0 +1,84 @@
+// Delta OTA against the flash simulator: a patch rebuilds the next release
+// from the running image, and a wrong base, a mismatched manifest, a corrupt
+// or truncated patch are all refused before the boot switch
+#include "flash_sim.h"
+#include "ota_delta.h"
+#include <openssl/sha.h>
+#include <unistd.h>
+
+static bool installDelta(const std::vector<uint8_t>& patch, const OtaExpectedImage& expected, double rateKBs = 0,
+                         size_t cutAt = 0) {
+  flashSimWipe();
+  PacedClient client(patch, rateKBs, cutAt);
+  OtaPipelineStats stats;
+  return installOtaDelta(client, patch.size(), expected, stats);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 4) {
+    fprintf(stderr, "usage: test_ota_delta old.bin new.bin patch.tbdp\n");
+    return 2;
+  }
+  Serial.quiet = true;
+  std::vector<uint8_t> oldImage = loadFile(argv[1]), newImage = loadFile(argv[2]), patch = loadFile(argv[3]);
+  flashSimSetRunning(oldImage);
+  uint8_t digest[32];
+  SHA256(newImage.data(), newImage.size(), digest);
+  OtaExpectedImage expected = {newImage.size(), digest, nullptr, 0};
+
+  // Patch vs. full image over the same 300 KB/s link at device flash timings
+  flashSim.timing = FLASH_TIMING_DEVICE;
+  uint32_t start = millis();
+  CHECK(installDelta(patch, expected, 300));
+  uint32_t deltaMs = millis() - start;
+  CHECK(flashSimUpdateMatches(newImage));
+  CHECK(flashSim.bootSet == 1);
+  CHECK(flashSim.badWrites == 0);
+  flashSimWipe();
+  PacedClient full(newImage, 300);
+  OtaPipelineStats stats;
+  start = millis();
+  CHECK(installOtaImage(full, expected, stats));
+  uint32_t fullMs = millis() - start;
+  printf("BENCH patch=%zu image=%zu delta=%ums full=%ums\n", patch.size(), newImage.size(), deltaMs, fullMs);
+  flashSim.timing = FLASH_TIMING_NONE;
+
+  // The patch carries the new digest: a manifest without one still verifies
+  OtaExpectedImage noDigest = expected;
+  noDigest.sha256 = nullptr;
+  CHECK(installDelta(patch, noDigest));
+  CHECK(flashSimUpdateMatches(newImage));
+  CHECK(flashSim.bootSet == 1);
+
+  // Running image is not the patch's base
+  flashSim.runningFlash[oldImage.size() / 2] ^= 1;
+  CHECK(!installDelta(patch, expected));
+  CHECK(flashSim.bootSet == 0);
+  flashSim.runningFlash[oldImage.size() / 2] ^= 1;
+
+  // Manifest names a different image than the patch builds
+  uint8_t otherDigest[32];
+  memcpy(otherDigest, digest, 32);
+  otherDigest[0] ^= 1;
+  OtaExpectedImage other = expected;
+  other.sha256 = otherDigest;
+  CHECK(!installDelta(patch, other));
+  CHECK(flashSim.bootSet == 0);
+
+  // One flipped bit anywhere in the compressed body
+  int accepted = 0;
+  for (int k = 1; k <= 20; k++) {
+    std::vector<uint8_t> corrupt = patch;
+    corrupt[OTA_DELTA_HEADER_SIZE + (corrupt.size() - OTA_DELTA_HEADER_SIZE) * k / 21] ^= 0x10;
+    if (installDelta(corrupt, expected) || flashSim.bootSet) accepted++;
+  }
+  CHECK(accepted == 0);
+
+  // Connection closes 100 bytes short
+  CHECK(!installDelta(patch, expected, 0, patch.size() - 100));
+  CHECK(flashSim.bootSet == 0);
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  fflush(stdout);
+  _exit(testFailures ? 1 : 0);
+}
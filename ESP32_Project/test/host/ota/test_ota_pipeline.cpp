@@ -0,0 +1,143 @@
+// OTA pipeline against the flash simulator: overlap with the network,
+// NOR-correct writes, and every rejection path leaving the boot partition alone
+#include "flash_sim.h"
+#include "ota_pipeline.h"
+#include <esp_image_format.h>
+#include <openssl/sha.h>
+#include <openssl/pem.h>
+#include <openssl/evp.h>
+#include <unistd.h>
+
+// The loop this replaced: 1 KB reads, Update.write erasing each 4 KB sector on first touch
+static uint32_t sequentialBaseline(const std::vector<uint8_t>& image, double rateKBs) {
+  PacedClient client(image, rateKBs);
+  uint32_t start = millis();
+  size_t done = 0, sectorOffset = 0;
+  uint8_t buffer[1024];
+  std::vector<uint8_t> sector;
+  while (done < image.size()) {
+    int available = client.available();
+    if (available > 0) {
+      int n = client.read(buffer, std::min((size_t)available, sizeof(buffer)));
+      sector.insert(sector.end(), buffer, buffer + n);
+      done += n;
+      while (sector.size() >= 4096 || (done == image.size() && !sector.empty())) {
+        size_t length = std::min((size_t)4096, sector.size());
+        esp_partition_erase_range(&flashSim.update, sectorOffset, 4096);
+        esp_partition_write(&flashSim.update, sectorOffset, sector.data(), length);
+        sector.erase(sector.begin(), sector.begin() + length);
+        sectorOffset += 4096;
+      }
+    }
+    delay(1);
+  }
+  return millis() - start;
+}
+
+#ifdef OTA_TEST_SIGNING_PRIVATE_KEY_PEM
+// DER ECDSA signature over the image digest, as the release tooling produces it
+static std::vector<uint8_t> signDigest(const uint8_t* digest) {
+  BIO* bio = BIO_new_mem_buf(OTA_TEST_SIGNING_PRIVATE_KEY_PEM, -1);
+  EVP_PKEY* key = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
+  BIO_free(bio);
+  EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(key, nullptr);
+  EVP_PKEY_sign_init(ctx);
+  EVP_PKEY_CTX_set_signature_md(ctx, EVP_sha256());
+  size_t length = 0;
+  EVP_PKEY_sign(ctx, nullptr, &length, digest, 32);
+  std::vector<uint8_t> signature(length);
+  EVP_PKEY_sign(ctx, signature.data(), &length, digest, 32);
+  signature.resize(length);
+  EVP_PKEY_CTX_free(ctx);
+  EVP_PKEY_free(key);
+  return signature;
+}
+#endif
+
+static bool install(const std::vector<uint8_t>& image, const OtaExpectedImage& expected, double rateKBs,
+                    size_t cutAt = 0) {
+  flashSimWipe();
+  PacedClient client(image, rateKBs, cutAt);
+  OtaPipelineStats stats;
+  return installOtaImage(client, expected, stats);
+}
+
+int main() {
+  Serial.quiet = true;
+  std::vector<uint8_t> image = randomImage(600 * 1024 + 123, 7);
+  uint8_t digest[32];
+  SHA256(image.data(), image.size(), digest);
+  std::vector<uint8_t> signature;
+#ifdef OTA_TEST_SIGNING_PRIVATE_KEY_PEM
+  signature = signDigest(digest);
+#endif
+  OtaExpectedImage good = {image.size(), digest, signature.empty() ? nullptr : signature.data(), signature.size()};
+
+  // Pipelined vs. sequential at device flash timings
+  flashSim.timing = FLASH_TIMING_DEVICE;
+  for (double rate : {300.0, 1000.0}) {
+    flashSimWipe();
+    uint32_t sequentialMs = sequentialBaseline(image, rate);
+    PacedClient client(image, rate);
+    OtaPipelineStats stats;
+    flashSimWipe();
+    bool ok = installOtaImage(client, good, stats);
+    CHECK(ok);
+    CHECK(flashSimUpdateMatches(image));
+    CHECK(flashSim.bootSet == 1);
+    CHECK(flashSim.badWrites == 0);
+    CHECK(stats.totalMs < sequentialMs);
+    printf("BENCH rate=%.0fKB/s pipelined=%ums sequential=%ums erase=%ums stall=%ums\n", rate, stats.totalMs,
+           sequentialMs, stats.eraseMs, stats.stallMs);
+  }
+  flashSim.timing = FLASH_TIMING_NONE;
+
+  // Wrong digest: written, never made bootable
+  uint8_t badDigest[32];
+  memcpy(badDigest, digest, 32);
+  badDigest[5] ^= 1;
+  OtaExpectedImage wrong = good;
+  wrong.sha256 = badDigest;
+  CHECK(!install(image, wrong, 0));
+  CHECK(flashSim.bootSet == 0);
+
+  // Connection closes part way
+  CHECK(!install(image, good, 2000, 200000));
+  CHECK(flashSim.bootSet == 0);
+
+  // Not an app image
+  std::vector<uint8_t> notApp = image;
+  notApp[0] = 0;
+  CHECK(!install(notApp, good, 0));
+  CHECK(flashSim.bootSet == 0);
+
+  OtaExpectedImage unsignedImage = good;
+  unsignedImage.signature = nullptr;
+  unsignedImage.signatureLength = 0;
+#ifdef OTA_SIGNING_PUBLIC_KEY_PEM
+  // A signing key is compiled in: a bad or missing signature is refused
+  std::vector<uint8_t> badSignature = signature;
+  badSignature[badSignature.size() - 3] ^= 1;
+  OtaExpectedImage forged = good;
+  forged.signature = badSignature.data();
+  CHECK(!install(image, forged, 0));
+  CHECK(flashSim.bootSet == 0);
+  CHECK(!install(image, unsignedImage, 0));
+  CHECK(flashSim.bootSet == 0);
+#else
+  CHECK(install(image, unsignedImage, 0));
+  CHECK(flashSim.bootSet == 1);
+#endif
+
+  uint8_t parsed[32];
+  char hex[65];
+  for (int i = 0; i < 32; i++) sprintf(hex + 2 * i, "%02x", digest[i]);
+  CHECK(parseSha256Hex(hex, parsed) && memcmp(parsed, digest, 32) == 0);
+  CHECK(!parseSha256Hex("zz", parsed));
+  hex[10] = 'g';
+  CHECK(!parseSha256Hex(hex, parsed));
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  fflush(stdout);
+  _exit(testFailures ? 1 : 0);   // The writer task is detached
+}
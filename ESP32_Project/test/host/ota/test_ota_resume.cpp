@@ -0,0 +1,195 @@
+// Resumable OTA against the flash simulator: random connection drops and
+// simulated reboots must still end byte-exact, with the download resumed
+// rather than restarted, and a stale or foreign checkpoint must be refused
+//
+//   test_ota_resume image.bin download.bin [trials] [seed]
+// download.bin is the image itself or its packed container (ota_pack.py)
+#include "flash_sim.h"
+#include "ota_resume.h"
+#include <Preferences.h>
+#include <openssl/sha.h>
+#include <memory>
+#include <random>
+#include <unistd.h>
+
+std::map<std::string, std::vector<uint8_t>> nvsStore;
+int nvsWrites = 0;
+
+// Serves data from an offset in random-sized bursts; drops the connection at dropAt
+class DropClient : public Client {
+public:
+  DropClient(const std::vector<uint8_t>& data, size_t from, size_t dropAt, std::mt19937& rng)
+      : data(data), pos(from), dropAt(dropAt), rng(rng) {}
+  int available() override {
+    if (pos >= dropAt) return 0;
+    return (int)std::min<size_t>(dropAt - pos, 1 + rng() % 3000);
+  }
+  int read(uint8_t* buffer, size_t size) override {
+    size = std::min(size, (size_t)available());
+    memcpy(buffer, data.data() + pos, size);
+    pos += size;
+    served += size;
+    return (int)size;
+  }
+  uint8_t connected() override { return pos < dropAt; }
+
+  static size_t served;   // Download bytes sent, over all connections
+
+private:
+  const std::vector<uint8_t>& data;
+  size_t pos, dropAt;
+  std::mt19937& rng;
+};
+size_t DropClient::served = 0;
+
+struct Server {
+  Server(const std::vector<uint8_t>* image, uint32_t seed) : data(image), rng(seed) {}
+
+  const std::vector<uint8_t>* data;
+  std::mt19937 rng;
+  std::unique_ptr<DropClient> client;
+  int dropsLeft = 0;           // Drops this attempt
+  size_t deadAt = SIZE_MAX;    // Network gone for good past this offset (this attempt)
+  bool ignoreRange = false;    // Answers a Range request with 200
+  int connects = 0;
+  std::vector<size_t> resumeOffsets;
+};
+
+static Client* connectServer(void* context, size_t offset) {
+  Server& server = *static_cast<Server*>(context);
+  server.connects++;
+  if (offset > 0) server.resumeOffsets.push_back(offset);
+  if (offset >= server.deadAt) return nullptr;
+  if (offset > 0 && server.ignoreRange) return nullptr;
+
+  size_t size = server.data->size();
+  size_t dropAt = size;
+  if (server.dropsLeft > 0 && size - offset > 64) {
+    server.dropsLeft--;
+    dropAt = offset + 1 + server.rng() % (size - offset - 1);
+  }
+  server.client.reset(new DropClient(*server.data, offset, std::min(dropAt, server.deadAt), server.rng));
+  return server.client.get();
+}
+
+static void reset() {
+  nvsStore.clear();
+  flashSimWipe();
+  DropClient::served = 0;
+}
+
+static bool installedExactly(const std::vector<uint8_t>& image) {
+  return flashSimUpdateMatches(image) && flashSim.bootSet == 1 && flashSim.badWrites == 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: test_ota_resume image.bin download.bin [trials] [seed]\n");
+    return 2;
+  }
+  Serial.quiet = true;
+  hostDelayScale = 0.01;   // Reconnect backoff
+  std::vector<uint8_t> image = loadFile(argv[1]), download = loadFile(argv[2]);
+  int trials = argc > 3 ? atoi(argv[3]) : 20;
+  std::mt19937 rng(argc > 4 ? atoi(argv[4]) : 1);
+
+  uint8_t digest[32];
+  SHA256(image.data(), image.size(), digest);
+  OtaExpectedImage expected = {image.size(), digest, nullptr, 0};
+  OtaPipelineStats stats;
+
+  for (int trial = 0; trial < trials; trial++) {
+    // In-session drops within the retry budget: one attempt, nothing sent twice
+    {
+      reset();
+      Server server(&download, rng());
+      server.dropsLeft = 1 + rng() % OTA_RESUME_RETRIES;
+      CHECK(installResumableOta(connectServer, &server, download.size(), expected, stats));
+      CHECK(installedExactly(image));
+      CHECK(DropClient::served == download.size());
+      CHECK(nvsStore.empty());
+    }
+
+    // Reboots: each attempt loses the network for good at a random offset
+    {
+      reset();
+      int attempts = 0;
+      bool ok = false;
+      while (!ok && attempts < 40) {
+        attempts++;
+        Server server(&download, rng());
+        server.deadAt = attempts < 8 ? 1 + rng() % download.size() : SIZE_MAX;
+        server.dropsLeft = rng() % 2;
+        ok = installResumableOta(connectServer, &server, download.size(), expected, stats);
+      }
+      CHECK(ok);
+      CHECK(installedExactly(image));
+      CHECK(nvsStore.empty());
+      if (trial == 0) {
+        printf("BENCH reboots attempts=%d served=%zu of %zu (%.2fx) nvsWrites=%d\n", attempts, DropClient::served,
+               download.size(), (double)DropClient::served / download.size(), nvsWrites);
+      }
+    }
+
+    // Flash prefix changed between attempts: the checkpoint is refused
+    {
+      reset();
+      Server first(&download, rng());
+      first.deadAt = download.size() * 3 / 4;
+      installResumableOta(connectServer, &first, download.size(), expected, stats);
+      CHECK(!nvsStore.empty());
+      flashSim.updateFlash[4096 + rng() % 60000] ^= 0x01;
+      Server second(&download, rng());
+      DropClient::served = 0;
+      CHECK(installResumableOta(connectServer, &second, download.size(), expected, stats));
+      CHECK(flashSimUpdateMatches(image));
+      CHECK(DropClient::served == download.size());
+    }
+
+    // Server without Range support: start over
+    {
+      reset();
+      Server first(&download, rng());
+      first.deadAt = download.size() / 2;
+      installResumableOta(connectServer, &first, download.size(), expected, stats);
+      Server second(&download, rng());
+      second.ignoreRange = true;
+      DropClient::served = 0;
+      CHECK(installResumableOta(connectServer, &second, download.size(), expected, stats));
+      CHECK(flashSimUpdateMatches(image));
+      CHECK(DropClient::served == download.size());
+    }
+  }
+
+  // A checkpoint for another image is ignored
+  {
+    reset();
+    Server first(&download, 1);
+    first.deadAt = download.size() / 2;
+    installResumableOta(connectServer, &first, download.size(), expected, stats);
+    uint8_t otherDigest[32];
+    memcpy(otherDigest, digest, 32);
+    otherDigest[5] ^= 1;
+    OtaExpectedImage other = expected;
+    other.sha256 = otherDigest;
+    Server second(&download, 2);
+    CHECK(!installResumableOta(connectServer, &second, download.size(), other, stats));
+    CHECK(flashSim.bootSet == 0);
+    CHECK(second.resumeOffsets.empty());
+  }
+
+  // Corrupt download bytes fail verification and leave no checkpoint behind
+  {
+    reset();
+    std::vector<uint8_t> corrupt = download;
+    corrupt[corrupt.size() - 100] ^= 0x40;
+    Server server(&corrupt, 3);
+    CHECK(!installResumableOta(connectServer, &server, corrupt.size(), expected, stats));
+    CHECK(flashSim.bootSet == 0);
+    CHECK(nvsStore.empty());
+  }
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  fflush(stdout);
+  _exit(testFailures ? 1 : 0);
+}
@@ -0,0 +1,23 @@
+#pragma once
+// Station signal, modem sleep and transmit power, set by the test
+#include <Arduino.h>
+
+typedef enum { WIFI_POWER_19_5dBm = 78, WIFI_POWER_8_5dBm = 34, WIFI_POWER_2dBm = 8 } wifi_power_t;
+
+struct WiFiStub {
+  int8_t rssi = -60;
+  bool sleep = true;
+  int8_t txPower = WIFI_POWER_19_5dBm;
+  int8_t RSSI() { return rssi; }
+  bool getSleep() { return sleep; }
+  bool setSleep(bool on) {
+    sleep = on;
+    return true;
+  }
+  wifi_power_t getTxPower() { return (wifi_power_t)txPower; }
+  bool setTxPower(wifi_power_t power) {
+    txPower = (int8_t)power;
+    return true;
+  }
+};
+extern WiFiStub WiFi;
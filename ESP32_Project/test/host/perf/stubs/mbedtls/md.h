@@ -0,0 +1,14 @@
+#pragma once
+// mbedtls message digest API on OpenSSL (HMAC-SHA256 only)
+#include <openssl/hmac.h>
+typedef enum { MBEDTLS_MD_NONE = 0, MBEDTLS_MD_SHA256 = 6 } mbedtls_md_type_t;
+typedef struct { mbedtls_md_type_t type; } mbedtls_md_info_t;
+inline const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t type) {
+  static const mbedtls_md_info_t sha256 = {MBEDTLS_MD_SHA256};
+  return type == MBEDTLS_MD_SHA256 ? &sha256 : nullptr;
+}
+inline int mbedtls_md_hmac(const mbedtls_md_info_t* info, const unsigned char* key, size_t keyLen,
+                           const unsigned char* input, size_t length, unsigned char* output) {
+  if (info == nullptr) return -0x5100;
+  return HMAC(EVP_sha256(), key, (int)keyLen, input, length, output, nullptr) ? 0 : -0x5100;
+}
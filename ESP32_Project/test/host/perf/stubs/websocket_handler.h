@@ -0,0 +1,16 @@
+#pragma once
+// The core link stand-in plus the debug-build hooks the console drives;
+// defined by the test
+#include_next <websocket_handler.h>
+#include <audio_frame.h>
+
+AudioFrame buildAudioTextFrame(const uint8_t* pcm, size_t length, JsonDocument& meta);
+
+#define WS_FORCED_DELAY_MAX_MS 1000
+struct ForcedNetworkConditions {
+  int8_t rssi;
+  uint8_t lossPercent;
+  uint16_t delayMs;
+};
+void setForcedNetworkConditions(const ForcedNetworkConditions& conditions);
+ForcedNetworkConditions getForcedNetworkConditions();
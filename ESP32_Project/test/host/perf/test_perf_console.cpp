@@ -0,0 +1,438 @@
+// Performance console: splitting lines into words, the command table (every
+// entry reachable, listed by help, unique), argument checking of net, knob,
+// bench, prof and tap, and the Serial side (lines split across loop calls,
+// CR/LF, backspace, control bytes, the per-call read bound, overlong lines).
+// Built with DEBUG_BUILD; the subsystems behind the commands are recording fakes.
+#include <perf_console.h>
+#include <websocket_handler.h>
+#include <sampling_profiler.h>
+#include <audio_tap.h>
+#include <metrics_registry.h>
+#include <resource_manager.h>
+#include <diagnostics_endpoints.h>
+#include <WiFi.h>
+#include <set>
+#include <string>
+#include <vector>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+WiFiStub WiFi;
+
+// =============================================================================
+// FAKES
+// =============================================================================
+
+static std::vector<std::string> calls;
+static std::string called() {
+  std::string all;
+  for (const std::string& c : calls) all += (all.empty() ? "" : " ") + c;
+  return all;
+}
+
+void printStackReport() { calls.push_back("printStackReport"); }
+void printMemoryBudget() { calls.push_back("printMemoryBudget"); }
+void printTraceStageSummary() { calls.push_back("printTraceStageSummary"); }
+void printMetricsHistory() { calls.push_back("printMetricsHistory"); }
+void printEventBusStats() { calls.push_back("printEventBusStats"); }
+void printAnomalyStatus() { calls.push_back("printAnomalyStatus"); }
+// Pages go straight to the sink, unbuffered
+ResponseStream::ResponseStream(ResponseSink sinkFn, void* sinkContext)
+  : sink(sinkFn), context(sinkContext), used(0), sinkFailed(false) {}
+ResponseStream::~ResponseStream() {}
+bool ResponseStream::flush() { return !sinkFailed; }
+size_t ResponseStream::write(const uint8_t* data, size_t length) {
+  sinkFailed = sinkFailed || !sink(context, (const char*)data, length);
+  return length;
+}
+void ResponseStream::print(const char* text) { write((const uint8_t*)text, strlen(text)); }
+
+void renderDebugTasks(ResponseStream& out) { calls.push_back("renderDebugTasks"); out.print("tasks\n"); }
+void renderDebugHeap(ResponseStream& out) { calls.push_back("renderDebugHeap"); out.print("heap\n"); }
+void renderDebugLatency(ResponseStream& out) { calls.push_back("renderDebugLatency"); out.print("lat\n"); }
+void renderDebugTaps(ResponseStream& out) { calls.push_back("renderDebugTaps"); out.print("taps\n"); }
+
+static ForcedNetworkConditions forcedNet = {0, 0, 0};
+void setForcedNetworkConditions(const ForcedNetworkConditions& conditions) { forcedNet = conditions; }
+ForcedNetworkConditions getForcedNetworkConditions() { return forcedNet; }
+
+static size_t adaptiveChunk = 4096;
+size_t getAdaptiveChunkSize() { return adaptiveChunk; }
+void setAdaptiveChunkSize(size_t bytes) { adaptiveChunk = bytes; }
+
+AudioFrame buildAudioTextFrame(const uint8_t* pcm, size_t length, JsonDocument&) {
+  AudioFrame frame = AudioFrame::allocate(length);
+  if (frame && frame.mutableData()) {
+    memcpy(frame.mutableData(), pcm, length);
+    frame.setLength(length);
+  }
+  return frame;
+}
+
+static uint32_t profilerHz = 0, profilerMs = 0;
+static bool profilerRunning = false;
+bool startProfiler(uint32_t sampleHz, uint32_t durationMs) {
+  profilerHz = sampleHz;
+  profilerMs = durationMs;
+  profilerRunning = true;
+  return true;
+}
+void stopProfiler() { calls.push_back("stopProfiler"); profilerRunning = false; }
+bool isProfilerRunning() { return profilerRunning; }
+uint32_t getProfilerSampleCount() { return 17; }
+uint32_t getProfilerDroppedCount() { return 2; }
+void dumpProfile() { calls.push_back("dumpProfile"); }
+void releaseProfile() { calls.push_back("releaseProfile"); }
+
+static uint32_t tapMask = 0;
+static uint32_t tapsSaved = 0;
+static const char* const tapNames[AUDIO_TAP_COUNT] = {"capture", "send", "playback"};
+bool enableAudioTaps(uint32_t mask) {
+  tapMask = mask;
+  return true;
+}
+uint32_t getEnabledAudioTaps() { return tapMask; }
+bool findAudioTap(const char* name, AudioTapPoint& tap) {
+  for (int i = 0; i < AUDIO_TAP_COUNT; i++) {
+    if (strcmp(tapNames[i], name) == 0) {
+      tap = (AudioTapPoint)i;
+      return true;
+    }
+  }
+  return false;
+}
+bool saveAudioTap(AudioTapPoint tap) {
+  tapsSaved |= 1u << tap;
+  return true;
+}
+
+// Runs one line and returns what it printed
+static std::string run(const char* line, bool* known = nullptr) {
+  char buffer[PERF_CONSOLE_LINE_MAX];
+  strlcpy(buffer, line, sizeof(buffer));
+  std::string log;
+  calls.clear();
+  Serial.capture = &log;
+  bool ok = executePerfCommand(buffer);
+  Serial.capture = nullptr;
+  if (known) *known = ok;
+  return log;
+}
+
+static bool has(const std::string& log, const char* text) {
+  return log.find(text) != std::string::npos;
+}
+
+// =============================================================================
+// PARSER
+// =============================================================================
+
+static void testSplit() {
+  char* argv[PERF_CONSOLE_MAX_ARGS];
+
+  char empty[] = "";
+  CHECK(splitCommandLine(empty, argv, PERF_CONSOLE_MAX_ARGS) == 0);
+  char blank[] = " \t  \t";
+  CHECK(splitCommandLine(blank, argv, PERF_CONSOLE_MAX_ARGS) == 0);
+
+  char words[] = "  net\trssi   -70  ";
+  CHECK(splitCommandLine(words, argv, PERF_CONSOLE_MAX_ARGS) == 3);
+  CHECK(strcmp(argv[0], "net") == 0 && strcmp(argv[1], "rssi") == 0 && strcmp(argv[2], "-70") == 0);
+
+  // Words past maxArgs are dropped; the last kept one is still terminated
+  char many[] = "a b c d e f g h";
+  CHECK(splitCommandLine(many, argv, PERF_CONSOLE_MAX_ARGS) == PERF_CONSOLE_MAX_ARGS);
+  CHECK(strcmp(argv[PERF_CONSOLE_MAX_ARGS - 1], "f") == 0);
+  char two[] = "tap on capture";
+  CHECK(splitCommandLine(two, argv, 2) == 2);
+  CHECK(strcmp(argv[1], "on") == 0);
+}
+
+static void testCommandTable() {
+  std::string help = run("help");
+  std::set<std::string> names;
+  size_t listed = 0;
+  for (size_t at = help.find("\n  "); at != std::string::npos; at = help.find("\n  ", at + 1)) {
+    char name[16] = {};
+    if (sscanf(help.c_str() + at + 3, "%15s", name) != 1) continue;
+    listed++;
+    names.insert(name);
+    const PerfCommand* c = findPerfCommand(name);
+    CHECK(c != nullptr);
+    CHECK(c && c->handler != nullptr && c->usage[0] != '\0');
+  }
+  CHECK(listed == names.size());   // No name twice
+  for (const char* name : {"help", "tasks", "stack", "heap", "lat", "audio", "metrics", "history",
+                           "bus", "alloc", "anomaly", "tap", "features", "net", "knob", "bench", "prof"}) {
+    CHECK(names.count(name) == 1);
+  }
+  CHECK(listed == 17);
+
+  // Exact, case-sensitive names only
+  CHECK(findPerfCommand("HELP") == nullptr);
+  CHECK(findPerfCommand("he") == nullptr);
+  CHECK(findPerfCommand("helpx") == nullptr);
+  CHECK(findPerfCommand("") == nullptr);
+}
+
+static void testDispatch() {
+  struct Case {
+    const char* line;
+    const char* calls;
+  };
+  const Case cases[] = {
+    {"tasks",   "renderDebugTasks"},
+    {"stack",   "printStackReport"},
+    {"heap",    "renderDebugHeap printMemoryBudget"},
+    {"lat",     "renderDebugLatency"},
+    {"audio",   "printTraceStageSummary"},   // Then the real frame stats
+    {"history", "printMetricsHistory"},
+    {"bus",     "printEventBusStats"},
+    {"anomaly", "printAnomalyStatus"},
+    {"  stack  extra words ", "printStackReport"},
+  };
+  for (const Case& c : cases) {
+    bool known = false;
+    run(c.line, &known);
+    CHECK(known);
+    if (called() != c.calls) printf("  '%s' called '%s'\n", c.line, called().c_str());
+    CHECK(called() == c.calls);
+  }
+
+  // Pages rendered through ResponseStream reach Serial
+  CHECK(run("tasks") == "tasks\n");
+  CHECK(has(run("audio"), "=== 🎞️ Audio Frames ==="));
+
+  bool known = true;
+  std::string log = run("Stack", &known);
+  CHECK(!known && calls.empty());
+  CHECK(has(log, "Unknown command 'Stack'"));
+  known = false;
+  CHECK(run("   ", &known).empty() && known);
+  CHECK(run("metrics", &known).size() > 0 && known);   // The real registry dump
+  run("alloc", &known);
+  CHECK(known);
+  run("features", &known);
+  CHECK(known);
+}
+
+// =============================================================================
+// ARGUMENTS
+// =============================================================================
+
+static void testNet() {
+  std::string log = run("net");
+  CHECK(has(log, "RSSI: measured (-60 dBm)") && has(log, "audio loss 0%, added delay 0 ms"));
+
+  run("net rssi -85");
+  run("net loss 20");
+  log = run("net delay 1000");
+  CHECK(forcedNet.rssi == -85 && forcedNet.lossPercent == 20 && forcedNet.delayMs == 1000);
+  CHECK(has(log, "RSSI: forced -85 dBm") && has(log, "audio loss 20%, added delay 1000 ms"));
+
+  // Out of range, not a number, or malformed: nothing changes
+  const char* rejected[] = {"net rssi 1", "net rssi -101", "net loss 101", "net loss -1",
+                            "net delay 1001", "net jitter 5", "net rssi", "net rssi -70 now"};
+  for (const char* line : rejected) {
+    CHECK(has(run(line), "Usage: net"));
+  }
+  for (const char* line : {"net rssi -70dBm", "net loss ten", "net delay "}) {
+    log = run(line);
+    CHECK(has(log, "Not a number") || has(log, "Usage: net"));
+  }
+  CHECK(forcedNet.rssi == -85 && forcedNet.lossPercent == 20 && forcedNet.delayMs == 1000);
+
+  run("net off");
+  CHECK(forcedNet.rssi == 0 && forcedNet.lossPercent == 0 && forcedNet.delayMs == 0);
+}
+
+static void testKnob() {
+  std::string log = run("knob");
+  for (const char* name : {"cpu_mhz", "wifi_sleep", "wifi_tx", "ws_chunk"}) {
+    CHECK(has(log, name));
+  }
+  CHECK(has(run("knob cpu_mhz"), "cpu_mhz: 240 MHz"));
+
+  log = run("knob cpu_mhz 160");
+  CHECK(getCpuFrequencyMhz() == 160 && has(log, "cpu_mhz: 240 -> 160 MHz"));
+  CHECK(has(run("knob cpu_mhz 100"), "cpu_mhz rejected 100"));   // In range, not a PLL frequency
+  CHECK(has(run("knob cpu_mhz 300"), "cpu_mhz takes 80..240 MHz"));
+  CHECK(has(run("knob cpu_mhz fast"), "cpu_mhz takes 80..240 MHz"));
+  CHECK(getCpuFrequencyMhz() == 160);
+  run("knob cpu_mhz 240");
+
+  run("knob wifi_sleep 0");
+  CHECK(!WiFi.sleep);
+  run("knob wifi_tx 34");
+  CHECK(WiFi.txPower == 34);
+  CHECK(has(run("knob wifi_tx 85"), "takes 8..84"));
+  run("knob ws_chunk 2048");
+  CHECK(adaptiveChunk == 2048);
+  CHECK(has(run("knob ws_chunk 511"), "takes 512..8192"));
+  CHECK(adaptiveChunk == 2048);
+
+  CHECK(has(run("knob turbo 1"), "Unknown knob 'turbo'"));
+}
+
+static void testBench() {
+  std::string log = run("bench memcpy 10");
+  CHECK(has(log, "Microbenchmarks (CPU 240 MHz)"));
+  CHECK(has(log, "memcpy") && has(log, "(10 iterations)"));
+  CHECK(!has(log, "malloc"));
+
+  log = run("bench all 2");
+  size_t lines = 0;
+  for (size_t at = log.find(" us/iter"); at != std::string::npos; at = log.find(" us/iter", at + 1)) lines++;
+  CHECK(lines == 8);
+  CHECK(has(log, "hmac") && has(log, "frame") && has(log, "b64dec"));
+  CHECK(has(run("bench"), "(200 iterations)"));
+
+  char tooMany[32];
+  snprintf(tooMany, sizeof(tooMany), "bench all %d", PERF_BENCH_MAX_ITERATIONS + 1);
+  for (const char* line : {"bench all 0", "bench all -5", "bench all many", (const char*)tooMany}) {
+    log = run(line);
+    CHECK(has(log, "Iterations must be 1..") && !has(log, "us/iter"));
+  }
+  log = run("bench sha1");
+  CHECK(has(log, "Unknown benchmark. Available: memcpy malloc pool base64 b64dec hmac json frame"));
+}
+
+static void testProfile() {
+  CHECK(has(run("prof"), "Profiler idle, 17 samples, 2 dropped"));
+  run("prof start");
+  CHECK(profilerRunning && profilerHz == PROFILER_DEFAULT_HZ && profilerMs == 0);
+  run("prof start 250 3000");
+  CHECK(profilerHz == 250 && profilerMs == 3000);
+  CHECK(has(run("prof"), "Profiler running"));
+
+  profilerHz = 0;
+  for (const char* line : {"prof start 0", "prof start 100000", "prof start 100 -1", "prof start x",
+                           "prof start 100 soon"}) {
+    CHECK(has(run(line), "Usage: prof start"));
+  }
+  CHECK(profilerHz == 0);
+
+  run("prof stop");
+  CHECK(called() == "stopProfiler dumpProfile releaseProfile" && !profilerRunning);
+}
+
+static void testTap() {
+  run("tap on capture playback");
+  CHECK(tapMask == ((1u << AUDIO_TAP_CAPTURE) | (1u << AUDIO_TAP_PLAYBACK)));
+  CHECK(called() == "renderDebugTaps");   // State shown after every change
+  run("tap on all");
+  CHECK(tapMask == AUDIO_TAP_ALL);
+
+  CHECK(has(run("tap on"), "Usage: tap on"));
+  CHECK(has(run("tap on capture mic"), "Unknown tap: mic"));
+  CHECK(tapMask == AUDIO_TAP_ALL);
+
+  run("tap on send");
+  run("tap save");                                   // Saves what is armed
+  CHECK(tapsSaved == (1u << AUDIO_TAP_SEND));
+  tapsSaved = 0;
+  run("tap save capture send");                      // ...and only that
+  CHECK(tapsSaved == (1u << AUDIO_TAP_SEND));
+  tapsSaved = 0;
+  run("tap save bogus");
+  CHECK(tapsSaved == 0);
+
+  run("tap off");
+  CHECK(tapMask == 0);
+  CHECK(has(run("tap off now"), "Usage: tap"));
+  CHECK(has(run("tap dump"), "Usage: tap"));
+  run("tap");
+  CHECK(called() == "renderDebugTaps");
+}
+
+// =============================================================================
+// SERIAL INPUT
+// =============================================================================
+
+static std::string feed(const std::string& bytes) {
+  std::string log;
+  calls.clear();
+  Serial.input += bytes;
+  Serial.capture = &log;
+  handlePerfConsole();
+  Serial.capture = nullptr;
+  return log;
+}
+
+static void testSerialInput() {
+  std::string log;
+  Serial.capture = &log;
+  initPerfConsole();
+  Serial.capture = nullptr;
+  CHECK(has(log, "Performance console ready"));
+
+  // A line arriving over several loop iterations runs once, at its end
+  feed("sta");
+  CHECK(calls.empty());
+  feed("ck");
+  CHECK(calls.empty());
+  feed("\r\n");                                      // CR runs it, the LF is an empty line
+  CHECK(called() == "printStackReport");
+  feed("\n\n\r");
+  CHECK(calls.empty());
+
+  // Backspace and DEL edit; control and non-ASCII bytes are dropped
+  feed("lxx\b\x7f" "at\x01\x1b\xc3\xa9\n");
+  CHECK(called() == "renderDebugLatency");
+  feed("\b\b\bbus\n");                               // Backspace on an empty line is harmless
+  CHECK(called() == "printEventBusStats");
+
+  // At most PERF_CONSOLE_MAX_READ bytes per call, the rest waits for the next
+  std::string burst;
+  for (int i = 0; i < 30; i++) burst += "bus\n";
+  feed(burst);
+  CHECK(Serial.input.size() == burst.size() - PERF_CONSOLE_MAX_READ);
+  CHECK(calls.size() == PERF_CONSOLE_MAX_READ / 4);
+  size_t ran = calls.size();
+  while (Serial.available() > 0) {
+    feed("");
+    ran += calls.size();
+  }
+  CHECK(ran == 30);
+
+  // The longest line that fits runs; one byte more is reported and dropped whole
+  std::string longest = "knob cpu_mhz";
+  longest += std::string(PERF_CONSOLE_LINE_MAX - 1 - longest.size(), ' ');
+  std::string out;
+  for (size_t i = 0; i < longest.size(); i += 32) out += feed(longest.substr(i, 32));
+  out += feed("\n");
+  CHECK(has(out, "cpu_mhz: 240 MHz"));
+  out.clear();
+  std::string overlong = longest + "x";
+  for (size_t i = 0; i < overlong.size(); i += 32) out += feed(overlong.substr(i, 32));
+  out += feed("\n");
+  char expected[64];
+  snprintf(expected, sizeof(expected), "Line longer than %d characters ignored", PERF_CONSOLE_LINE_MAX - 1);
+  CHECK(has(out, expected) && !has(out, "cpu_mhz"));
+  feed("stack\n");                                   // The next line is clean
+  CHECK(called() == "printStackReport");
+}
+
+int main() {
+  initMetricsRegistry();
+  testSplit();
+  testCommandTable();
+  testDispatch();
+  testNet();
+  testKnob();
+  testBench();
+  testProfile();
+  testTap();
+  testSerialInput();
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
@@ -0,0 +1,41 @@
+#!/usr/bin/env python3
+"""
+Runs scripts/profile_symbolize.py on a profile and compares the folded
+stacks it writes with an expected file (order-insensitive).
+
+  check_symbolize.py SYMBOLIZER PROFILE EXPECTED [symbolizer options...]
+"""
+
+import sys
+import subprocess
+import tempfile
+from collections import Counter
+from pathlib import Path
+
+def read_folded(path):
+    """Folded stacks as a Counter of stack -> count"""
+    folded = Counter()
+    for line in Path(path).read_text(encoding="utf-8").splitlines():
+        if line.strip():
+            stack, count = line.rsplit(" ", 1)
+            folded[stack] += int(count)
+    return folded
+
+def main():
+    symbolizer, profile, expected = sys.argv[1:4]
+    with tempfile.TemporaryDirectory() as tmp:
+        output = Path(tmp) / "out.folded"
+        subprocess.run([sys.executable, symbolizer, profile, "-o", str(output)] + sys.argv[4:],
+                       check=True, stdout=subprocess.DEVNULL)
+        got = read_folded(output)
+
+    want = read_folded(expected)
+    if got != want:
+        for stack in sorted(set(got) | set(want)):
+            if got[stack] != want[stack]:
+                print(f"❌ {stack}: got {got[stack]}, expected {want[stack]}")
+        sys.exit(1)
+    print(f"✅ {profile}: {sum(got.values())} samples in {len(got)} stacks as expected")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,28 @@
+#!/usr/bin/env python3
+"""
+addr2line stand-in for the symbolizer checks: resolves addresses against a
+text symbol table ("start end function" per line, hex) given as the "ELF".
+Prints function and file:line for every address, as addr2line -f does.
+"""
+
+import sys
+
+def main():
+    args = sys.argv[1:]
+    table = args[args.index("-e") + 1]
+    addresses = [a for a in args if a.startswith("0x")]
+    symbols = []
+    with open(table, encoding="utf-8") as f:
+        for line in f:
+            if line.strip() and not line.startswith("#"):
+                start, end, name = line.split()
+                symbols.append((int(start, 16), int(end, 16), name))
+
+    for text in addresses:
+        address = int(text, 16)
+        name = next((n for s, e, n in symbols if s <= address < e), "??")
+        print(name)
+        print("??:0")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,287 @@
+// Sampling profiler: timer interrupts on two simulated cores sample fake
+// task contexts; the TPRF dump (Serial lines and profile_chunk messages) is
+// decoded here and must reproduce exactly the samples the rings kept.
+// Writes profile_dump.log, profile_chunks.jsonl and profile_expected.folded
+// for the symbolizer checks that run after this test.
+#include <sampling_profiler.h>
+#include <encoding_service.h>
+#include <websocket_handler.h>
+#include <freertos/task.h>
+#include <freertos/xtensa_context.h>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+// A TCB whose first field is pxTopOfStack, pointing at the saved frame
+struct FakeTask {
+  const XtExcFrame* topOfStack;
+  XtExcFrame frame;
+  const char* name;
+  int core;
+};
+
+static FakeTask tasks[] = {
+  {nullptr, {}, "audio_capture", 0},
+  {nullptr, {}, "IDLE0", 0},
+  {nullptr, {}, "loopTask", 1},
+  {nullptr, {}, "async_tcp", 1},
+  {nullptr, {}, "IDLE1", 1},
+};
+static const int TASK_COUNT = sizeof(tasks) / sizeof(tasks[0]);
+
+// Interrupted PCs and the raw a0 of their callers (call increment in bits 30-31)
+struct Site { uint32_t pc, a0; };
+static const Site sites[] = {
+  {0x400d1024, 0x800d5010},   // i2s_read        <- audio_capture_loop
+  {0x400d2210, 0x800d5040},   // base64Encode    <- sendTextFrame
+  {0x400d3104, 0x800d5040},   // hmac_sha256     <- sendTextFrame
+  {0x40081a0c, 0x80081b00},   // idle hook       <- prvIdleTask
+  {0x400d4400, 0xc00d6020},   // handleWebSocket <- loop
+};
+
+struct Sample { uint32_t pc, caller, task; };
+
+static uint32_t handleOf(const FakeTask& t) { return (uint32_t)(uintptr_t)&t; }
+
+// =============================================================================
+// TPRF DECODING (mirrors scripts/profile_symbolize.py)
+// =============================================================================
+
+struct Profile {
+  uint8_t version = 0, cores = 0;
+  uint16_t hz = 0;
+  uint32_t samples = 0, dropped = 0;
+  std::map<uint32_t, std::string> taskNames;
+  std::vector<Sample> data;
+  bool valid = false;
+};
+
+template <typename T> static T readLe(const std::vector<uint8_t>& blob, size_t& offset) {
+  T value = 0;
+  for (size_t i = 0; i < sizeof(T); i++) value |= (T)blob[offset + i] << (8 * i);
+  offset += sizeof(T);
+  return value;
+}
+
+static Profile parseProfile(const std::vector<uint8_t>& blob) {
+  Profile p;
+  if (blob.size() < 20 || memcmp(blob.data(), "TPRF", 4) != 0) return p;
+  size_t offset = 4;
+  p.version = readLe<uint8_t>(blob, offset);
+  p.cores = readLe<uint8_t>(blob, offset);
+  p.hz = readLe<uint16_t>(blob, offset);
+  p.samples = readLe<uint32_t>(blob, offset);
+  p.dropped = readLe<uint32_t>(blob, offset);
+  uint16_t taskCount = readLe<uint16_t>(blob, offset);
+  offset += 2;
+  if (blob.size() != 20 + taskCount * 20u + p.samples * 12u) return p;
+  for (uint16_t i = 0; i < taskCount; i++) {
+    uint32_t handle = readLe<uint32_t>(blob, offset);
+    p.taskNames[handle] = std::string((const char*)&blob[offset], strnlen((const char*)&blob[offset], 16));
+    offset += 16;
+  }
+  for (uint32_t i = 0; i < p.samples; i++) {
+    Sample s;
+    s.pc = readLe<uint32_t>(blob, offset);
+    s.caller = readLe<uint32_t>(blob, offset);
+    s.task = readLe<uint32_t>(blob, offset);
+    p.data.push_back(s);
+  }
+  p.valid = true;
+  return p;
+}
+
+static std::vector<uint8_t> decodeBase64(const std::string& text) {
+  std::vector<uint8_t> out(base64DecodedLength(text.size()));
+  size_t length = 0;
+  if (!base64Decode(text.c_str(), text.size(), out.data(), out.size(), &length)) return {};
+  out.resize(length);
+  return out;
+}
+
+// Base64 between [PROF][BEGIN] and [PROF][END]; every line at most 76 chars
+static std::vector<uint8_t> decodeSerialDump(const std::string& log, int& lines) {
+  std::string encoded;
+  size_t begin = log.find("[PROF][BEGIN]\n");
+  size_t end = log.find("[PROF][END]\n");
+  lines = 0;
+  if (begin == std::string::npos || end == std::string::npos) return {};
+  size_t pos = begin + 14;
+  while (pos < end) {
+    size_t eol = log.find('\n', pos);
+    std::string line = log.substr(pos, eol - pos);
+    pos = eol + 1;
+    if (line.compare(0, 7, "[PROF] ") != 0) return {};
+    CHECK(line.size() - 7 <= 76 && (line.size() - 7) % 4 == 0);
+    encoded += line.substr(7);
+    lines++;
+  }
+  return decodeBase64(encoded);
+}
+
+// profile_chunk messages: data fields concatenated in seq order
+static std::vector<uint8_t> decodeChunks(const std::vector<std::string>& messages) {
+  std::string encoded;
+  for (size_t i = 0; i < messages.size(); i++) {
+    const std::string& m = messages[i];
+    char expected[64];
+    snprintf(expected, sizeof(expected), "{\"type\":\"profile_chunk\",\"format\":\"tprf1\",\"seq\":%zu,", i);
+    CHECK(m.compare(0, strlen(expected), expected) == 0);
+    bool final = m.find("\"final\":true") != std::string::npos;
+    CHECK(final == (i + 1 == messages.size()));
+    size_t data = m.find("\"data\":\"");
+    if (data == std::string::npos) return {};
+    data += 8;
+    std::string chunk = m.substr(data, m.find('"', data) - data);
+    CHECK(chunk.size() <= 16 * 76);
+    encoded += chunk;
+  }
+  return decodeBase64(encoded);
+}
+
+// =============================================================================
+// SAMPLING
+// =============================================================================
+
+// Fires one timer interrupt on a core while a task runs at a site
+static Sample interrupt(int core, FakeTask& task, const Site& site) {
+  task.frame.pc = site.pc;
+  task.frame.a0 = site.a0;
+  task.topOfStack = &task.frame;
+  hostCoreId = core;
+  hostCurrentTask = &task;
+  CHECK(hostFireTimer(PROFILER_TIMER_BASE + core));
+  hostCurrentTask = nullptr;
+  hostCoreId = 1;
+  return {site.pc, (site.a0 & 0x3FFFFFFF) | 0x40000000, handleOf(task)};
+}
+
+static void writeFile(const char* path, const std::string& text) {
+  FILE* f = fopen(path, "w");
+  if (f == nullptr) return;
+  fputs(text.c_str(), f);
+  fclose(f);
+}
+
+int main() {
+  for (FakeTask& t : tasks) {
+    TaskStatus_t status = {};
+    status.xHandle = &t;
+    status.pcTaskName = t.name;
+    status.xCoreID = t.core;
+    hostTasks.push_back(status);
+  }
+
+  CHECK(!startProfiler(0));
+  CHECK(!startProfiler(PROFILER_MAX_HZ + 1));
+  long allocsBefore = hostHeap.allocs;
+  CHECK(startProfiler(997));
+  CHECK(isProfilerRunning() && !startProfiler(997));
+  CHECK(hostHeap.allocs == allocsBefore + portNUM_PROCESSORS);
+  CHECK(hostTimers[PROFILER_TIMER_BASE].alarm == 1000000 / 997);
+
+  // More interrupts than a core's ring holds: the oldest are overwritten
+  const int perCore[2] = {700, 300};
+  std::vector<Sample> fired[2];
+  std::mt19937 rng(79);
+  for (int core = 0; core < 2; core++) {
+    std::vector<FakeTask*> onCore;
+    for (FakeTask& t : tasks) if (t.core == core) onCore.push_back(&t);
+    for (int i = 0; i < perCore[core]; i++) {
+      FakeTask& task = *onCore[rng() % onCore.size()];
+      fired[core].push_back(interrupt(core, task, sites[rng() % 5]));
+    }
+  }
+  // A core idle in the scheduler (no current task) still takes a sample
+  hostCoreId = 1;
+  CHECK(hostFireTimer(PROFILER_TIMER_BASE + 1));
+  fired[1].push_back({0, 0, 0});
+
+  stopProfiler();
+  CHECK(!isProfilerRunning());
+  CHECK(!hostFireTimer(PROFILER_TIMER_BASE) && !hostFireTimer(PROFILER_TIMER_BASE + 1));
+  CHECK(getProfilerSampleCount() == PROFILER_SAMPLES_PER_CORE + 301);
+  CHECK(getProfilerDroppedCount() == 700 - PROFILER_SAMPLES_PER_CORE);
+
+  // What the rings kept: the newest PROFILER_SAMPLES_PER_CORE per core, oldest first
+  std::vector<Sample> expected;
+  for (int core = 0; core < 2; core++) {
+    size_t keep = std::min(fired[core].size(), (size_t)PROFILER_SAMPLES_PER_CORE);
+    expected.insert(expected.end(), fired[core].end() - keep, fired[core].end());
+  }
+
+  // Serial dump round trip
+  std::string log;
+  Serial.capture = &log;
+  dumpProfile();
+  Serial.capture = nullptr;
+  int lines = 0;
+  Profile serial = parseProfile(decodeSerialDump(log, lines));
+  CHECK(serial.valid);
+  CHECK(serial.version == PROFILER_FORMAT_VERSION && serial.cores == 2 && serial.hz == 997);
+  CHECK(serial.samples == expected.size() && serial.dropped == 700 - PROFILER_SAMPLES_PER_CORE);
+  CHECK(serial.taskNames.size() == (size_t)TASK_COUNT);
+  for (FakeTask& t : tasks) CHECK(serial.taskNames[handleOf(t)] == t.name);
+  CHECK(serial.data.size() == expected.size());
+  for (size_t i = 0; i < serial.data.size() && i < expected.size(); i++) {
+    CHECK(serial.data[i].pc == expected[i].pc);
+    CHECK(serial.data[i].caller == expected[i].caller);
+    CHECK(serial.data[i].task == expected[i].task);
+  }
+
+  // WebSocket upload round trip, byte-identical to the Serial dump
+  isConnected = false;
+  CHECK(!sendProfileReport());
+  isConnected = true;
+  CHECK(sendProfileReport());
+  CHECK(decodeChunks(webSocket.sent) == decodeSerialDump(log, lines));
+  std::vector<std::string> chunks = webSocket.sent;
+  webSocket.sent.clear();
+  webSocket.fail = true;
+  CHECK(!sendProfileReport());
+  webSocket.fail = false;
+
+  // Files for the symbolizer: dump, chunks, and the folded stacks it must produce
+  writeFile("profile_dump.log", "boot noise\n" + log + "more noise\n");
+  std::string jsonLines;
+  for (const std::string& m : chunks) jsonLines += m + "\n";
+  writeFile("profile_chunks.jsonl", jsonLines);
+  std::map<std::string, int> folded;
+  for (const Sample& s : expected) {
+    char stack[96];
+    auto found = serial.taskNames.find(s.task);
+    std::string task = found != serial.taskNames.end() ? found->second : "";
+    if (task.empty()) {
+      snprintf(stack, sizeof(stack), "task_%08x", s.task);
+      task = stack;
+    }
+    if (s.caller) snprintf(stack, sizeof(stack), "%s;0x%08x;0x%08x", task.c_str(), s.caller, s.pc);
+    else snprintf(stack, sizeof(stack), "%s;0x%08x", task.c_str(), s.pc);
+    folded[stack]++;
+  }
+  std::string foldedText;
+  for (const auto& entry : folded) foldedText += entry.first + " " + std::to_string(entry.second) + "\n";
+  writeFile("profile_expected.folded", foldedText);
+
+  // An idle profiler holds no memory
+  long freesBefore = hostHeap.frees;
+  releaseProfile();
+  CHECK(hostHeap.frees == freesBefore + portNUM_PROCESSORS);
+  CHECK(getProfilerSampleCount() == 0);
+
+  printf("BENCH %zu samples -> %zu bytes TPRF, %d Serial lines, %zu profile_chunk messages\n",
+         expected.size(), (size_t)(20 + TASK_COUNT * 20 + expected.size() * 12), lines, chunks.size());
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
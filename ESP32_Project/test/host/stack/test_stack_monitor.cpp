@@ -0,0 +1,254 @@
+// Stack monitor: warn and critical thresholds at their boundaries (free bytes
+// and percent used), one warning per level, the lowest mark kept across
+// restarts of a task name, final marks on exit, sizing suggestions, the
+// report lines, and retirement racing the sampler.
+// High-water marks are set per task in hostTasks.
+#include <stack_monitor.h>
+#include <metrics_registry.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+static TaskHandle_t taskHandle(int n) {
+  return (TaskHandle_t)(uintptr_t)(0x3ffb0000 + n * 0x100);
+}
+
+static TaskHandle_t addTask(int n, const char* name, uint32_t mark) {
+  TaskStatus_t t = {};
+  t.xHandle = taskHandle(n);
+  t.pcTaskName = name;
+  t.usStackHighWaterMark = mark;
+  hostTasks.push_back(t);
+  return t.xHandle;
+}
+
+static void setMark(TaskHandle_t task, uint32_t mark) {
+  for (TaskStatus_t& t : hostTasks) {
+    if (t.xHandle == task) t.usStackHighWaterMark = mark;
+  }
+}
+
+// Matched on the stored, possibly truncated, name as the monitor does
+static const StackUsageEntry* findEntry(const char* name) {
+  for (size_t i = 0; i < getStackEntryCount(); i++) {
+    const StackUsageEntry* e = getStackEntryAt(i);
+    if (strncmp(e->name, name, configMAX_TASK_NAME_LEN - 1) == 0) return e;
+  }
+  return nullptr;
+}
+
+static uint32_t warnings() {
+  return getCounterValue(findMetric(METRIC_COUNTER, "stack.warnings"));
+}
+
+// =============================================================================
+// THRESHOLDS
+// =============================================================================
+
+static void testThresholds() {
+  struct Case {
+    const char* name;
+    uint32_t size;
+    uint32_t mark;
+    uint8_t level;
+  };
+  const Case cases[] = {
+    {"roomy",       4096,  1200, 0},   // 71% used
+    {"free_warn",   4096,  STACK_WARN_FREE_BYTES - 1, 1},
+    {"free_edge",   4096,  STACK_WARN_FREE_BYTES, 0},
+    {"pct_edge",    20000, 3000, 0},   // Exactly STACK_WARN_USED_PERCENT: not above it
+    {"pct_warn",    20000, 2999, 1},   // Plenty of bytes free, but 85.005% used
+    {"crit_edge",   2048,  STACK_CRITICAL_FREE_BYTES, 1},
+    {"critical",    2048,  STACK_CRITICAL_FREE_BYTES - 1, 2},
+  };
+  const int n = sizeof(cases) / sizeof(cases[0]);
+  for (int i = 0; i < n; i++) {
+    registerTaskStack(addTask(i, cases[i].name, cases[i].mark), cases[i].name, cases[i].size);
+  }
+
+  std::string log;
+  Serial.capture = &log;
+  uint32_t before = warnings();
+  sampleStackUsage();
+  Serial.capture = nullptr;
+
+  int expectedWarnings = 0;
+  for (const Case& c : cases) {
+    const StackUsageEntry* e = findEntry(c.name);
+    CHECK(e != nullptr);
+    if (!e) continue;
+    CHECK(e->minFree == c.mark && e->lastFree == c.mark && e->stackSize == c.size);
+    CHECK(e->warnLevel == c.level);
+    bool logged = log.find(std::string("Stack ") + c.name + ":") != std::string::npos;
+    CHECK(logged == (c.level > 0));
+    if (c.level > 0) expectedWarnings++;
+  }
+  CHECK(warnings() - before == (uint32_t)expectedWarnings);
+  CHECK(log.find("🚨 Stack critical:") != std::string::npos);
+  CHECK(log.find("⚠️ Stack pct_warn:") != std::string::npos);
+  CHECK(getGaugeValue(findMetric(METRIC_GAUGE, "stack.min_free")) == STACK_CRITICAL_FREE_BYTES - 1);
+
+  // Once per level: steady marks stay quiet, escalation warns again
+  log.clear();
+  Serial.capture = &log;
+  sampleStackUsage();
+  CHECK(log.empty());
+  setMark(taskHandle(1), STACK_CRITICAL_FREE_BYTES - 100);   // free_warn goes critical
+  setMark(taskHandle(0), 3000);                              // Higher marks never raise the minimum
+  sampleStackUsage();
+  sampleStackUsage();
+  Serial.capture = nullptr;
+  CHECK(findEntry("free_warn")->warnLevel == 2);
+  CHECK(log.find("🚨 Stack free_warn:") != std::string::npos);
+  CHECK(warnings() - before == (uint32_t)expectedWarnings + 1);
+  CHECK(findEntry("roomy")->minFree == 1200 && findEntry("roomy")->lastFree == 3000);
+  CHECK(findEntry("roomy")->warnLevel == 0);
+}
+
+// =============================================================================
+// RESTARTS AND EXIT
+// =============================================================================
+
+// adc_capture_task runs once per utterance: the lowest mark of any run counts
+static void testRestartsByName() {
+  TaskHandle_t first = addTask(20, "adc_capture_task", 2600);
+  hostCurrentTask = first;
+  registerCurrentTaskStack("adc_capture_task", 6144);
+  sampleStackUsage();
+  setMark(first, 2200);       // Deeper after the last sample
+  noteTaskStackExit();        // The final mark is kept
+  hostCurrentTask = nullptr;
+  const StackUsageEntry* e = findEntry("adc_capture_task");
+  CHECK(e && e->handle == nullptr && e->minFree == 2200);
+
+  size_t entries = getStackEntryCount();
+  TaskHandle_t second = addTask(21, "adc_capture_task", 4000);
+  registerTaskStack(second, "adc_capture_task", 6144);
+  CHECK(getStackEntryCount() == entries);   // Same entry, new handle
+  sampleStackUsage();
+  CHECK(e->handle == second && e->minFree == 2200 && e->lastFree == 4000);
+
+  // Deleted by another task
+  forgetTaskStack(second);
+  CHECK(e->handle == nullptr);
+  setMark(second, 100);
+  sampleStackUsage();         // No handle: not read any more
+  CHECK(e->minFree == 2200 && e->warnLevel == 0);
+  forgetTaskStack(nullptr);
+  registerTaskStack(nullptr, "ghost", 4096);
+  CHECK(findEntry("ghost") == nullptr);
+
+  // Names are kept to configMAX_TASK_NAME_LEN - 1 characters and matched on those
+  TaskHandle_t longName = addTask(22, "realtime_streamer_task", 8192);
+  registerTaskStack(longName, "realtime_streamer_task", 8192);
+  CHECK(findEntry("realtime_streamer_task") != nullptr);
+  CHECK(strcmp(findEntry("realtime_streamer_task")->name, "realtime_stream") == 0);
+  entries = getStackEntryCount();
+  registerTaskStack(addTask(23, "realtime_streamer_task2", 8000), "realtime_streamer_task2", 10240);
+  CHECK(getStackEntryCount() == entries);
+}
+
+// =============================================================================
+// SIZING AND REPORT
+// =============================================================================
+
+static void testSuggestions() {
+  StackUsageEntry e = {};
+  e.stackSize = 4096;
+  e.minFree = 1200;           // 2896 used: the 1 KB floor beats 25%
+  CHECK(getStackSuggestion(e) == 4096);
+  e.stackSize = 16384;
+  e.minFree = 6384;           // 10000 used + 2500, rounded up to 512
+  CHECK(getStackSuggestion(e) == 12800);
+  e.minFree = 16384;          // Never ran deep: the margin alone
+  CHECK(getStackSuggestion(e) == STACK_SIZING_MIN_MARGIN);
+}
+
+static void testReport() {
+  std::string log;
+  Serial.capture = &log;
+  printStackReport();
+  Serial.capture = nullptr;
+
+  CHECK(log.find("CRITICAL") != std::string::npos);
+  CHECK(log.find("TIGHT") != std::string::npos);
+  CHECK(log.find("OVERSIZED") != std::string::npos);   // realtime_streamer: 0 used of 10240
+  CHECK(log.find("(exited)") != std::string::npos);    // adc_capture_task
+
+  size_t lines = 0;
+  for (size_t at = log.find("[STACK][TASK] "); at != std::string::npos; at = log.find("[STACK][TASK] ", at + 1)) {
+    lines++;
+  }
+  CHECK(lines == getStackEntryCount());
+  CHECK(log.find("[STACK][TASK] {\"name\":\"pct_warn\",\"size\":20000,\"min_free\":2999,\"suggest\":21504,\"isr\":false}")
+        != std::string::npos);
+}
+
+// The table holds STACK_MONITOR_MAX_TASKS names; later ones are not tracked
+static void testTableFull() {
+  static char names[STACK_MONITOR_MAX_TASKS][configMAX_TASK_NAME_LEN];
+  for (int i = 0; getStackEntryCount() < STACK_MONITOR_MAX_TASKS; i++) {
+    snprintf(names[i], sizeof(names[i]), "extra_%d", i);
+    registerTaskStack(addTask(40 + i, names[i], 2048), names[i], 4096);
+  }
+  registerTaskStack(addTask(60, "one_too_many", 100), "one_too_many", 4096);
+  CHECK(getStackEntryCount() == STACK_MONITOR_MAX_TASKS);
+  CHECK(findEntry("one_too_many") == nullptr);
+}
+
+// =============================================================================
+// RETIRE WHILE SAMPLING
+// =============================================================================
+
+// Tasks exiting while the sampler runs: each final mark lands, no handle is
+// left behind and no exited task is read afterwards
+static void testRetireRace() {
+  const int ROUNDS = 20000;
+  const StackUsageEntry* e = findEntry("extra_0");
+  TaskHandle_t task = e ? e->handle : nullptr;
+  CHECK(task != nullptr);
+  if (!task) return;
+  setMark(task, 1500);
+
+  std::atomic<bool> done(false);
+  std::thread sampler([&] {
+    hostCoreId = 1;
+    while (!done.load()) sampleStackUsage();
+  });
+  int stillRegistered = 0;
+  for (int round = 0; round < ROUNDS; round++) {
+    registerTaskStack(task, "extra_0", 4096);
+    forgetTaskStack(task);
+    if (e->handle != nullptr) stillRegistered++;
+  }
+  done = true;
+  sampler.join();
+
+  CHECK(stillRegistered == 0);
+  CHECK(e->handle == nullptr && e->minFree == 1500);
+}
+
+int main() {
+  initMetricsRegistry();
+  CHECK(initStackMonitor());
+  CHECK(getStackEntryCount() == 0);   // STACK_MONITOR_ISR is off outside debug builds
+  testThresholds();
+  testRestartsByName();
+  testSuggestions();
+  testReport();
+  testTableFull();
+  testRetireRace();
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
@@ -0,0 +1,358 @@
+// Fixed-capacity strings: FS_TRUNCATE and FS_ELLIPSIS overflow, appendv
+// truncation, appendHex at the capacity boundary, StringView substr / trim /
+// containsIgnoreCase, and heap allocations of the converted logging paths
+// against the String versions they replaced (same output, counted in hostHeap)
+#include <fixed_string.h>
+#include <comprehensive_logging.h>
+#include <string>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+// A FixedString followed by a canary: overflow would show in the canary
+template <size_t N, FixedStringOverflow P>
+struct Guarded {
+  FixedString<N, P> s;
+  char canary[8] = {'C', 'A', 'N', 'A', 'R', 'Y', '!', '\0'};
+  bool intact() const { return memcmp(canary, "CANARY!", 8) == 0 && strlen(s.c_str()) == s.length(); }
+};
+
+template <size_t N, FixedStringOverflow P>
+static FixedString<N, P>& appendfv(FixedString<N, P>& s, const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  s.appendv(fmt, args);
+  va_end(args);
+  return s;
+}
+
+// =============================================================================
+// OVERFLOW POLICIES
+// =============================================================================
+
+static void testOverflowPolicies() {
+  Guarded<8, FS_TRUNCATE> t;
+  Guarded<8, FS_ELLIPSIS> e;
+  CHECK(t.s.capacity() == 7);
+
+  t.s.append("abcdefg");   // Exactly full
+  e.s.append("abcdefg");
+  CHECK(t.s == "abcdefg" && !t.s.isTruncated());
+  CHECK(e.s == "abcdefg" && !e.s.isTruncated());
+
+  t.s.append('h');
+  e.s.append('h');
+  CHECK(t.s == "abcdefg" && t.s.isTruncated());
+  CHECK(e.s == "abcd..." && e.s.isTruncated());
+
+  t.s.assign("0123456789");
+  e.s.assign("0123456789");
+  CHECK(t.s == "0123456" && t.s.isTruncated() && t.s.length() == 7);
+  CHECK(e.s == "0123..." && e.s.isTruncated() && e.s.length() == 7);
+
+  // assign() clears the flag; further appends after overflow change nothing
+  t.s.assign("ab");
+  CHECK(t.s == "ab" && !t.s.isTruncated());
+  t.s += StringView("cdefghijk");
+  t.s += "more";
+  t.s += 'x';
+  CHECK(t.s == "abcdefg" && t.s.isTruncated());
+  e.s.assign("ab");
+  e.s += StringView("cdefghijk");
+  e.s += "more";
+  CHECK(e.s == "abcd..." && e.s.isTruncated());
+
+  // Smallest size the ellipsis fits in
+  FixedString<4, FS_ELLIPSIS> tiny("abcd");
+  CHECK(tiny == "..." && tiny.isTruncated());
+
+  // Views that are not NUL-terminated are copied by length only
+  const char raw[] = {'x', 'y', 'z', 'w'};
+  FixedString<8> fromView(StringView(raw, 3));
+  CHECK(fromView == "xyz");
+  FixedString<8> fromNull(StringView((const char*)nullptr));
+  CHECK(fromNull.isEmpty() && fromNull == "");
+
+  CHECK(t.intact() && e.intact());
+}
+
+// =============================================================================
+// APPENDV / APPENDF
+// =============================================================================
+
+static void testAppendv() {
+  Guarded<8, FS_TRUNCATE> t;
+  Guarded<8, FS_ELLIPSIS> e;
+
+  appendfv(t.s, "%d", 1234567);   // 7 characters: fits exactly
+  CHECK(t.s == "1234567" && !t.s.isTruncated());
+  appendfv(t.s, "%s", "");        // Nothing to add at capacity: still not truncated
+  CHECK(!t.s.isTruncated());
+  appendfv(t.s, "%d", 8);
+  CHECK(t.s == "1234567" && t.s.isTruncated());
+
+  t.s.clear();
+  appendfv(t.s, "%d", 12345678);  // One too many
+  CHECK(t.s == "1234567" && t.s.isTruncated() && t.s.length() == 7);
+  appendfv(e.s, "%d", 12345678);
+  CHECK(e.s == "1234..." && e.s.isTruncated());
+
+  // Formatting after existing content, truncated in the middle of an argument
+  t.s.assign("id=");
+  appendfv(t.s, "%s/%u", "ab", 99999u);
+  CHECK(t.s == "id=ab/9" && t.s.isTruncated());
+  e.s.assign("id=");
+  appendfv(e.s, "%s/%u", "ab", 99999u);
+  CHECK(e.s == "id=a..." && e.s.isTruncated());
+
+  // appendf goes through appendv
+  FixedString<16> f;
+  f.appendf("%s:%02x", "k", 0xAu).appendf("|%.*s", 2, "xyz");
+  CHECK(f == "k:0a|xy" && !f.isTruncated());
+  FixedString<6> g;
+  g.appendf("%lu ms", 123456UL);
+  CHECK(g == "12345" && g.isTruncated());
+
+  CHECK(t.intact() && e.intact());
+}
+
+// =============================================================================
+// APPENDHEX
+// =============================================================================
+
+static void testAppendHex() {
+  const uint8_t bytes[] = {0xde, 0xad, 0xbe, 0xef, 0x00, 0xff};
+
+  FixedString<9> exact;             // 8 characters: 4 bytes fit exactly
+  exact.appendHex(bytes, 4);
+  CHECK(exact == "deadbeef" && !exact.isTruncated());
+  exact.appendHex(bytes, 0);        // Nothing to append
+  CHECK(!exact.isTruncated());
+  exact.appendHex(bytes + 4, 1);
+  CHECK(exact == "deadbeef" && exact.isTruncated());
+
+  Guarded<8, FS_TRUNCATE> odd;      // 7 characters: never half a byte
+  odd.s.appendHex(bytes, 4);
+  CHECK(odd.s == "deadbe" && odd.s.length() == 6 && odd.s.isTruncated());
+  Guarded<8, FS_ELLIPSIS> oddEllipsis;
+  oddEllipsis.s.appendHex(bytes, 4);
+  CHECK(oddEllipsis.s == "dead..." && oddEllipsis.s.isTruncated());
+
+  FixedString<8> prefixed("0x");
+  prefixed.appendHex(bytes + 4, 2);
+  CHECK(prefixed == "0x00ff" && !prefixed.isTruncated());
+  prefixed.appendHex(bytes, 1);     // 6 + 2 > 7
+  CHECK(prefixed == "0x00ff" && prefixed.isTruncated());
+
+  // HMAC digest as generateHMAC() builds it
+  uint8_t digest[32];
+  for (int i = 0; i < 32; i++) digest[i] = (uint8_t)(i * 37 + 5);
+  FixedString<65> hex;
+  hex.appendHex(digest, sizeof(digest));
+  CHECK(hex.length() == 64 && !hex.isTruncated());
+  char expected[65];
+  for (int i = 0; i < 32; i++) snprintf(expected + 2 * i, 3, "%02x", digest[i]);
+  CHECK(hex == expected);
+
+  CHECK(odd.intact() && oddEllipsis.intact());
+}
+
+// =============================================================================
+// STRING VIEW
+// =============================================================================
+
+static void testStringView() {
+  StringView s("Hello, Teddy");
+  CHECK(s.substr(7) == "Teddy");
+  CHECK(s.substr(0, 5) == "Hello");
+  CHECK(s.substr(7, 100) == "Teddy");            // Length clamps
+  CHECK(s.substr(12).isEmpty());                 // At the end
+  CHECK(s.substr(50).isEmpty() && s.substr(50, 3).isEmpty());   // Past the end
+  CHECK(s.substr(5, 0).isEmpty());
+
+  CHECK(StringView("  \t ok \r\n").trim() == "ok");
+  CHECK(StringView("ok").trim() == "ok");
+  CHECK(StringView(" \t\r\n ").trim().isEmpty());
+  CHECK(StringView("").trim().isEmpty());
+  CHECK(StringView(" a b ").trim() == "a b");
+  // Trimming a view never looks outside it
+  const char padded[] = "xx  dev-ok  yy";
+  CHECK(StringView(padded + 2, 10).trim() == "dev-ok");
+
+  CHECK(s.containsIgnoreCase("TEDDY"));
+  CHECK(s.containsIgnoreCase("hello"));
+  CHECK(s.containsIgnoreCase(", t"));
+  CHECK(s.containsIgnoreCase(""));
+  CHECK(!s.containsIgnoreCase("bear"));
+  CHECK(!StringView("ted").containsIgnoreCase("teddy"));   // Needle longer than the view
+  CHECK(!StringView(padded, 5).containsIgnoreCase("dev")); // "dev" starts past the view
+  CHECK(StringView(padded, 7).containsIgnoreCase("DEV"));
+
+  CHECK(StringView("OK").equalsIgnoreCase("ok") && !StringView("OK").equalsIgnoreCase("oks"));
+  CHECK(s.startsWith("Hello") && !s.startsWith("hello") && s.startsWith(""));
+  CHECK(StringView(nullptr).isEmpty() && StringView(nullptr, 5).length() == 0);
+
+  String owned("from a String");
+  StringView borrowed(owned);
+  CHECK(borrowed.data() == owned.c_str() && borrowed == "from a String");
+}
+
+// =============================================================================
+// ALLOCATIONS: CONVERTED LOGGING VS STRING
+// =============================================================================
+
+// The String versions these paths replaced, as they were
+namespace legacy {
+String currentAudioFlowState = AUDIO_FLOW_IDLE;
+String currentSystemState = "INITIALIZING";
+
+void logAudioFlowState(const String& state, const String& info = "") {
+  currentAudioFlowState = state;
+  String timestamp = String(millis());
+  Serial.printf("%s %s Audio Flow: %s", LOG_AUDIO, timestamp.c_str(), state.c_str());
+  if (info.length() > 0) {
+    Serial.printf(" - %s", info.c_str());
+  }
+  Serial.println();
+}
+
+void logAudioData(const String& operation, size_t bytes, const String& format = "") {
+  String timestamp = String(millis());
+  Serial.printf("%s %s Audio Data: %s %d bytes", LOG_AUDIO, timestamp.c_str(), operation.c_str(), (int)bytes);
+  if (format.length() > 0) {
+    Serial.printf(" (%s)", format.c_str());
+  }
+  Serial.println();
+}
+
+void logWebSocketMessage(const String& direction, const String& type, size_t size = 0) {
+  String timestamp = String(millis());
+  Serial.printf("%s %s WebSocket Message: %s %s", LOG_WS, timestamp.c_str(), direction.c_str(), type.c_str());
+  if (size > 0) {
+    Serial.printf(" (%d bytes)", (int)size);
+  }
+  Serial.println();
+}
+
+void logSystemEvent(const String& event, const String& details = "") {
+  String timestamp = String(millis());
+  Serial.printf("%s %s System Event: %s", LOG_SYSTEM, timestamp.c_str(), event.c_str());
+  if (details.length() > 0) {
+    Serial.printf(" - %s", details.c_str());
+  }
+  Serial.println();
+}
+
+void updateAudioFlowState(const String& newState) {
+  if (currentAudioFlowState != newState) {
+    logAudioFlowState(newState, "State changed from " + currentAudioFlowState);
+    currentAudioFlowState = newState;
+  }
+}
+
+void updateSystemState(const String& newState) {
+  if (currentSystemState != newState) {
+    logSystemEvent("State changed", currentSystemState + " -> " + newState);
+    currentSystemState = newState;
+  }
+}
+
+String hexDigest(const uint8_t* hmac) {
+  String result = "";
+  for (int i = 0; i < 32; i++) {
+    if (hmac[i] < 16) result += "0";
+    result += String(hmac[i], HEX);
+  }
+  return result;
+}
+}  // namespace legacy
+
+static String hexDigest(const uint8_t* hmac) {
+  FixedString<65> hex;
+  hex.appendHex(hmac, 32);
+  return String(hex.c_str());
+}
+
+// One push-to-talk turn as audio_handler / websocket_handler log it
+template <typename UpdateState, typename Data, typename Message, typename System>
+static void utterance(UpdateState updateState, Data data, Message message, System system) {
+  system("ACTIVE");
+  updateState(AUDIO_FLOW_RECORDING);
+  for (int chunk = 0; chunk < 10; chunk++) {
+    data("Sending", 4096, "PCM 16kHz mono s16le");
+    simUs += 128000;
+  }
+  updateState(AUDIO_FLOW_COMPLETE);
+  message("RECEIVE", "audio_response", 68000);
+  updateState(AUDIO_FLOW_RECEIVING);
+  data("Received", 51000, "pcm_s16le");
+  updateState(AUDIO_FLOW_PLAYING);
+  updateState(AUDIO_FLOW_COMPLETE);
+  message("RECEIVE", "message", 180);
+  system("IDLE");
+}
+
+static void testLoggingAllocations() {
+  const int TURNS = 20;
+  std::string convertedLog, legacyLog;
+  uint64_t start = simUs;
+
+  long before = hostHeap.allocs;
+  Serial.capture = &convertedLog;
+  for (int i = 0; i < TURNS; i++) {
+    utterance([](const char* s) { updateAudioFlowState(s); },
+              [](const char* op, size_t n, const char* f) { logAudioData(op, n, f); },
+              [](const char* d, const char* t, size_t n) { logWebSocketMessage(d, t, n); },
+              [](const char* s) { updateSystemState(s); });
+  }
+  long converted = hostHeap.allocs - before;
+
+  simUs = start;   // Same timestamps, so the logs can be compared
+  before = hostHeap.allocs;
+  Serial.capture = &legacyLog;
+  for (int i = 0; i < TURNS; i++) {
+    utterance([](const char* s) { legacy::updateAudioFlowState(s); },
+              [](const char* op, size_t n, const char* f) { legacy::logAudioData(op, n, f); },
+              [](const char* d, const char* t, size_t n) { legacy::logWebSocketMessage(d, t, n); },
+              [](const char* s) { legacy::updateSystemState(s); });
+  }
+  long withString = hostHeap.allocs - before;
+  Serial.capture = nullptr;
+
+  CHECK(converted == 0);
+  CHECK(withString > 0);
+  CHECK(!convertedLog.empty() && convertedLog == legacyLog);   // Same output, byte for byte
+
+  uint8_t digest[32];
+  for (int i = 0; i < 32; i++) digest[i] = (uint8_t)(i * 13);
+  before = hostHeap.allocs;
+  String fixedHex = hexDigest(digest);
+  long hexConverted = hostHeap.allocs - before;
+  before = hostHeap.allocs;
+  String stringHex = legacy::hexDigest(digest);
+  long hexString = hostHeap.allocs - before;
+  CHECK(fixedHex == stringHex);
+  CHECK(hexConverted == 1);   // The returned String only
+
+  printf("BENCH logging, %d turns: %ld heap allocations converted, %ld with String (%.1f per turn)\n",
+         TURNS, converted, withString, (double)withString / TURNS);
+  printf("BENCH HMAC hex digest: %ld allocation(s) with FixedString, %ld with String\n", hexConverted, hexString);
+}
+
+int main() {
+  testOverflowPolicies();
+  testAppendv();
+  testAppendHex();
+  testStringView();
+  testLoggingAllocations();
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
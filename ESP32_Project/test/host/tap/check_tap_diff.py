@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""
+Checks scripts/tap_diff.py: decimate() and align() on synthetic signals
+with known lags, then the tool on the taps test_audio_tap exported, with
+and without the timestamp hint, against the lags and gains it wrote.
+
+  check_tap_diff.py TAP_DIFF EXPECTED TAP.wav...
+"""
+
+import re
+import sys
+import random
+import subprocess
+import importlib.util
+
+def load(path):
+    spec = importlib.util.spec_from_file_location("tap_diff", path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+def noise(n, seed):
+    """Low-pass noise: enough energy below the coarse band to align on"""
+    rng = random.Random(seed)
+    out, level = [], 0.0
+    for _ in range(n):
+        level = 0.9 * level + rng.uniform(-3000, 3000)
+        out.append(int(level))
+    return out
+
+def check_decimate(tap_diff, failures):
+    samples = [100 + (i % 32) for i in range(1000)]
+    out = tap_diff.decimate(samples, tap_diff.COARSE_FACTOR)
+    if len(out) != 1000 // tap_diff.COARSE_FACTOR:
+        failures.append(f"decimate: {len(out)} outputs")
+    if abs(sum(out) / len(out)) > 1.0:
+        failures.append("decimate: DC not removed")
+    if tap_diff.decimate([5] * 10, tap_diff.COARSE_FACTOR) != []:
+        failures.append("decimate: partial block kept")
+
+def check_align(tap_diff, failures):
+    ref = noise(6000, 1)
+    # Lags off the coarse grid, both signs, with and without a usable hint;
+    # all within the overlap tap_diff requires
+    for lag, center in [(0, 0), (37, 0), (-251, 0), (1601, 0), (-2503, -2400), (4099, 3500)]:
+        extra = noise(abs(lag), 2)
+        test = extra + ref if lag > 0 else ref[-lag:] + extra
+        test = [round(0.7 * s) for s in test]
+        got, corr = tap_diff.align(ref, test, center, 2000)
+        if got != lag or corr < 0.99:
+            failures.append(f"align: lag {lag} (center {center}) found {got}, correlation {corr:.3f}")
+
+def parse_pairs(output):
+    """(ref, test) -> (lag, gain) from the tool's report"""
+    pairs = {}
+    for block in output.split("🔀 ")[1:]:
+        names = re.match(r"(\w+) -> (\w+)", block)
+        lag = re.search(r"Lag:\s+([+-]\d+) samples", block)
+        gain = re.search(r"Gain:\s+(-?[\d.]+)", block)
+        if names and lag and gain:
+            pairs[names.groups()] = (int(lag.group(1)), float(gain.group(1)))
+    return pairs
+
+def main():
+    tool, expected_path, taps = sys.argv[1], sys.argv[2], sys.argv[3:]
+    tap_diff = load(tool)
+    failures = []
+    check_decimate(tap_diff, failures)
+    check_align(tap_diff, failures)
+
+    expected = {}
+    with open(expected_path) as f:
+        for line in f:
+            ref, test, lag, gain = line.split()
+            expected[(ref, test)] = (int(lag), float(gain))
+
+    for extra in ([], ["--no-hint"]):
+        # Any order on the command line: the stage metadata orders them
+        output = subprocess.run([sys.executable, tool] + taps[::-1] + extra,
+                                check=True, capture_output=True, text=True).stdout
+        got = parse_pairs(output)
+        for pair, (lag, gain) in expected.items():
+            if pair not in got:
+                failures.append(f"{' '.join(extra)} {pair}: not reported")
+            elif got[pair][0] != lag or abs(got[pair][1] - gain) > 0.002:
+                failures.append(f"{' '.join(extra)} {pair}: lag {got[pair][0]} gain {got[pair][1]}, "
+                                f"expected {lag} and {gain}")
+        if len(got) != len(expected):
+            failures.append(f"{' '.join(extra)}: {len(got)} pairs reported")
+
+    for failure in failures:
+        print(f"❌ {failure}")
+    if failures:
+        sys.exit(1)
+    print(f"✅ {len(expected)} tap pairs aligned, with and without the timestamp hint")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,46 @@
+#pragma once
+// SPIFFS as a map of path -> bytes with a fixed capacity
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+#define FILE_WRITE "w"
+
+class File {
+public:
+  File() : data(nullptr) {}
+  explicit File(std::string* file) : data(file) {}
+  explicit operator bool() const { return data != nullptr; }
+  size_t write(const uint8_t* bytes, size_t length) {
+    if (data == nullptr || failAfter < length) return 0;
+    failAfter -= length;
+    data->append((const char*)bytes, length);
+    return length;
+  }
+  size_t size() const { return data ? data->size() : 0; }
+  void close() { data = nullptr; }
+  size_t failAfter = (size_t)-1;   // Bytes before writes fail (flash full)
+
+private:
+  std::string* data;
+};
+
+struct SPIFFSStub {
+  std::map<std::string, std::string> files;
+  size_t capacity = 1400 * 1024;
+  size_t failAfter = (size_t)-1;   // Handed to the next opened file
+  bool begin(bool) { return true; }
+  size_t totalBytes() { return capacity; }
+  size_t usedBytes() {
+    size_t used = 0;
+    for (const auto& f : files) used += f.second.size();
+    return used;
+  }
+  bool remove(const char* path) { return files.erase(path) > 0; }
+  File open(const char* path, const char*) {
+    File file(&(files[path] = std::string()));
+    file.failAfter = failAfter;
+    return file;
+  }
+};
+extern SPIFFSStub SPIFFS;
@@ -0,0 +1,437 @@
+// Audio taps: arming splits the budget and frees it again, the ring keeps
+// the newest samples across wraps and oversized writes, the WAV export
+// (header, metadata comment, slices, sink abort) is one consistent snapshot
+// while a stage keeps writing, and "tap save" to SPIFFS.
+// Also writes tap_capture/send/playback.wav with known lags and gains and
+// tap_expected.txt for check_tap_diff.py.
+// Built with DEBUG_BUILD so FEATURE_AUDIO_TAPS is on.
+#include <audio_tap.h>
+#include <SPIFFS.h>
+#include <freertos/FreeRTOS.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+SPIFFSStub SPIFFS;
+
+static const uint32_t BYTES_PER_TAP[AUDIO_TAP_COUNT + 1] = {
+  0, AUDIO_TAP_BUDGET_BYTES, AUDIO_TAP_BUDGET_BYTES / 2, (AUDIO_TAP_BUDGET_BYTES / 3) & ~1u
+};
+
+static void writeRamp(AudioTapPoint tap, uint32_t& next, uint32_t count) {
+  std::vector<int16_t> pcm(count);
+  for (uint32_t i = 0; i < count; i++) pcm[i] = (int16_t)(next++);
+  audioTapWrite(tap, pcm.data(), count * sizeof(int16_t));
+}
+
+// =============================================================================
+// WAV PARSING
+// =============================================================================
+
+struct Wav {
+  bool valid = false;
+  uint16_t format = 0, channels = 0, bits = 0;
+  uint32_t rate = 0;
+  std::string comment;
+  std::vector<int16_t> samples;
+};
+
+static uint32_t get32(const std::string& b, size_t at) {
+  return (uint8_t)b[at] | (uint8_t)b[at + 1] << 8 | (uint8_t)b[at + 2] << 16 | (uint32_t)(uint8_t)b[at + 3] << 24;
+}
+
+static uint16_t get16(const std::string& b, size_t at) {
+  return (uint8_t)b[at] | (uint8_t)b[at + 1] << 8;
+}
+
+// Strict: sizes must add up and chunks must be word aligned
+static Wav parseWav(const std::string& b) {
+  Wav w;
+  if (b.size() < 12 || b.compare(0, 4, "RIFF") != 0 || b.compare(8, 4, "WAVE") != 0) return w;
+  if (get32(b, 4) != b.size() - 8) return w;
+  size_t at = 12;
+  bool data = false;
+  while (at + 8 <= b.size()) {
+    std::string tag = b.substr(at, 4);
+    uint32_t size = get32(b, at + 4);
+    if (at + 8 + size > b.size() || (size & 1)) return w;
+    if (tag == "fmt ") {
+      w.format = get16(b, at + 8);
+      w.channels = get16(b, at + 10);
+      w.rate = get32(b, at + 12);
+      w.bits = get16(b, at + 22);
+    } else if (tag == "LIST" && b.compare(at + 8, 4, "INFO") == 0 && b.compare(at + 12, 4, "ICMT") == 0) {
+      uint32_t length = get32(b, at + 16);
+      if (length == 0 || b[at + 20 + length - 1] != '\0' || 12 + ((length + 1) & ~1u) != size) return w;
+      w.comment = b.substr(at + 20, length - 1);
+    } else if (tag == "data") {
+      w.samples.resize(size / 2);
+      for (size_t i = 0; i < w.samples.size(); i++) w.samples[i] = (int16_t)get16(b, at + 8 + 2 * i);
+      data = true;
+    }
+    at += 8 + size;
+  }
+  w.valid = data && at == b.size();
+  return w;
+}
+
+static uint32_t commentField(const std::string& comment, const char* key) {
+  size_t at = comment.find(std::string(key) + "=");
+  return at == std::string::npos ? UINT32_MAX : (uint32_t)strtoul(comment.c_str() + at + strlen(key) + 1, nullptr, 10);
+}
+
+struct Export {
+  std::string bytes;
+  std::vector<size_t> pieces;
+  int acceptPieces = -1;               // Sink fails after this many; -1 never
+  AudioTapPoint tap = AUDIO_TAP_CAPTURE;
+  bool pausedDuringExport = true;
+};
+
+static bool exportSink(void* context, const uint8_t* data, size_t length) {
+  Export* e = static_cast<Export*>(context);
+  if ((int)e->pieces.size() == e->acceptPieces) return false;
+  e->pieces.push_back(length);
+  e->bytes.append((const char*)data, length);
+  e->pausedDuringExport = e->pausedDuringExport && !audioTapEnabled(e->tap);
+  int16_t late[4] = {1, 2, 3, 4};
+  audioTapWrite(e->tap, late, sizeof(late));   // The stage keeps going: not recorded
+  return true;
+}
+
+static Wav exportTap(AudioTapPoint tap, Export* out = nullptr) {
+  Export local;
+  Export& e = out ? *out : local;
+  e.tap = tap;
+  CHECK(exportAudioTap(tap, exportSink, &e) == (e.acceptPieces < 0));
+  return parseWav(e.bytes);
+}
+
+// =============================================================================
+// ARMING
+// =============================================================================
+
+static void testArming() {
+  CHECK(getEnabledAudioTaps() == 0);
+  for (int i = 0; i < AUDIO_TAP_COUNT; i++) {
+    CHECK(getAudioTapInfo((AudioTapPoint)i).capacity == 0);
+  }
+
+  long allocs = hostHeap.allocs, frees = hostHeap.frees;
+  CHECK(enableAudioTaps(1u << AUDIO_TAP_SEND));
+  CHECK(getEnabledAudioTaps() == (1u << AUDIO_TAP_SEND) && audioTapEnabled(AUDIO_TAP_SEND));
+  CHECK(getAudioTapInfo(AUDIO_TAP_SEND).capacity == BYTES_PER_TAP[1] / 2);
+  CHECK(getAudioTapInfo(AUDIO_TAP_CAPTURE).capacity == 0 && !audioTapEnabled(AUDIO_TAP_CAPTURE));
+
+  // The budget is split between the armed taps; bits past the last tap are ignored
+  CHECK(enableAudioTaps(0xff));
+  CHECK(getEnabledAudioTaps() == AUDIO_TAP_ALL);
+  for (int i = 0; i < AUDIO_TAP_COUNT; i++) {
+    AudioTapInfo info = getAudioTapInfo((AudioTapPoint)i);
+    CHECK(info.armed && info.capacity == BYTES_PER_TAP[3] / 2 && info.total == 0);
+  }
+  CHECK(enableAudioTaps((1u << AUDIO_TAP_CAPTURE) | (1u << AUDIO_TAP_PLAYBACK)));
+  CHECK(getAudioTapInfo(AUDIO_TAP_PLAYBACK).capacity == BYTES_PER_TAP[2] / 2);
+  CHECK(getAudioTapInfo(AUDIO_TAP_SEND).capacity == 0);
+
+  // Disarming frees every ring
+  CHECK(enableAudioTaps(0));
+  CHECK(getEnabledAudioTaps() == 0);
+  CHECK(hostHeap.allocs - allocs == 6 && hostHeap.frees - frees == 6);
+
+  AudioTapPoint tap;
+  CHECK(findAudioTap("playback", tap) && tap == AUDIO_TAP_PLAYBACK);
+  CHECK(!findAudioTap("Playback", tap) && !findAudioTap("", tap) && !findAudioTap("all", tap));
+  CHECK(strcmp(getAudioTapName(AUDIO_TAP_SEND), "send") == 0);
+  CHECK(strcmp(getAudioTapName(AUDIO_TAP_COUNT), "unknown") == 0);
+}
+
+// =============================================================================
+// RING
+// =============================================================================
+
+static void testRing() {
+  CHECK(enableAudioTaps(1u << AUDIO_TAP_CAPTURE));
+  const uint32_t capacity = getAudioTapInfo(AUDIO_TAP_CAPTURE).capacity;
+
+  // Disarmed taps and the hook macro leave nothing behind
+  int16_t pcm[64] = {};
+  audioTapWrite(AUDIO_TAP_SEND, pcm, sizeof(pcm));
+  AUDIO_TAP(AUDIO_TAP_PLAYBACK, pcm, sizeof(pcm));
+  CHECK(getAudioTapInfo(AUDIO_TAP_SEND).total == 0 && getAudioTapInfo(AUDIO_TAP_PLAYBACK).total == 0);
+
+  // Partly filled: only what was written, oldest first
+  uint32_t next = 0;
+  simUs += 1000;
+  writeRamp(AUDIO_TAP_CAPTURE, next, 1000);
+  AudioTapInfo info = getAudioTapInfo(AUDIO_TAP_CAPTURE);
+  CHECK(info.total == 1000 && info.endUs == micros());
+  Wav w = exportTap(AUDIO_TAP_CAPTURE);
+  CHECK(w.valid && w.samples.size() == 1000 && w.samples.front() == 0 && w.samples.back() == 999);
+
+  // Odd and empty writes: whole samples only, no timestamp for nothing
+  uint32_t endUs = info.endUs;
+  simUs += 1000;
+  audioTapWrite(AUDIO_TAP_CAPTURE, pcm, 0);
+  audioTapWrite(AUDIO_TAP_CAPTURE, pcm, 1);
+  CHECK(getAudioTapInfo(AUDIO_TAP_CAPTURE).total == 1000 && getAudioTapInfo(AUDIO_TAP_CAPTURE).endUs == endUs);
+  int16_t odd[3] = {(int16_t)next, (int16_t)(next + 1), 77};
+  audioTapWrite(AUDIO_TAP_CAPTURE, odd, 5);
+  next += 2;
+  CHECK(getAudioTapInfo(AUDIO_TAP_CAPTURE).total == 1002);
+
+  // Many wraps with writes of every size up to a few chunks
+  const uint32_t sizes[] = {1, 7, 160, 511, 512, 2048, 4096, 3333};
+  for (int round = 0; getAudioTapInfo(AUDIO_TAP_CAPTURE).total < 5 * capacity; round++) {
+    writeRamp(AUDIO_TAP_CAPTURE, next, sizes[round % 8]);
+  }
+  w = exportTap(AUDIO_TAP_CAPTURE);
+  bool ramp = w.valid && w.samples.size() == capacity;
+  for (uint32_t i = 0; ramp && i < capacity; i++) {
+    ramp = w.samples[i] == (int16_t)(next - capacity + i);
+  }
+  CHECK(ramp);
+  CHECK(getAudioTapInfo(AUDIO_TAP_CAPTURE).total == next);
+
+  // One write longer than the ring keeps its newest samples, and counts all
+  writeRamp(AUDIO_TAP_CAPTURE, next, capacity + capacity / 3);
+  w = exportTap(AUDIO_TAP_CAPTURE);
+  CHECK(getAudioTapInfo(AUDIO_TAP_CAPTURE).total == next);
+  CHECK(w.samples.size() == capacity && w.samples.front() == (int16_t)(next - capacity) &&
+        w.samples.back() == (int16_t)(next - 1));
+}
+
+// =============================================================================
+// EXPORT
+// =============================================================================
+
+static void testExport() {
+  CHECK(enableAudioTaps(AUDIO_TAP_ALL));
+  const uint32_t capacity = getAudioTapInfo(AUDIO_TAP_SEND).capacity;
+  uint32_t armedUs = micros();
+  uint32_t next = 0;
+  simUs += 250000;
+  writeRamp(AUDIO_TAP_SEND, next, capacity + 100);
+
+  Export e;
+  Wav w = exportTap(AUDIO_TAP_SEND, &e);
+  CHECK(w.valid);
+  CHECK(w.format == 1 && w.channels == 1 && w.bits == 16 && w.rate == AUDIO_TAP_SAMPLE_RATE);
+  CHECK(w.samples.size() == capacity);
+  char expected[96];
+  snprintf(expected, sizeof(expected), "tap=send stage=1 rate=16000 total=%u armed_us=%u end_us=%u", capacity + 100,
+           armedUs, micros());
+  CHECK(w.comment == expected);
+  CHECK(commentField(w.comment, "total") == capacity + 100);
+
+  // Header in one piece, then slices of at most AUDIO_TAP_READ_SAMPLES
+  bool sliced = e.pieces.size() >= 1 + capacity / AUDIO_TAP_READ_SAMPLES;
+  for (size_t i = 1; i < e.pieces.size(); i++) {
+    sliced = sliced && e.pieces[i] <= AUDIO_TAP_READ_SAMPLES * sizeof(int16_t);
+  }
+  CHECK(sliced);
+  CHECK(e.bytes.size() - e.pieces[0] == capacity * sizeof(int16_t));
+
+  // Paused while read: stage writes from inside the sink are dropped, then it re-arms
+  CHECK(e.pausedDuringExport);
+  CHECK(getAudioTapInfo(AUDIO_TAP_SEND).total == capacity + 100);
+  CHECK(audioTapEnabled(AUDIO_TAP_SEND) && getEnabledAudioTaps() == AUDIO_TAP_ALL);
+
+  // Empty ring: a valid WAV with no samples
+  w = exportTap(AUDIO_TAP_PLAYBACK);
+  CHECK(w.valid && w.samples.empty() && commentField(w.comment, "total") == 0);
+
+  // The peer goes away: export stops at once and the tap is armed again
+  Export aborted;
+  aborted.acceptPieces = 3;
+  exportTap(AUDIO_TAP_SEND, &aborted);
+  CHECK(aborted.pieces.size() == 3);
+  CHECK(audioTapEnabled(AUDIO_TAP_SEND));
+  aborted = Export();
+  aborted.acceptPieces = 0;
+  exportTap(AUDIO_TAP_SEND, &aborted);
+  CHECK(aborted.pieces.empty() && audioTapEnabled(AUDIO_TAP_SEND));
+
+  // A tap that is not armed has nothing to export and stays off
+  CHECK(enableAudioTaps(1u << AUDIO_TAP_CAPTURE));
+  Export none;
+  CHECK(!exportAudioTap(AUDIO_TAP_SEND, exportSink, &none));
+  CHECK(none.pieces.empty() && !audioTapEnabled(AUDIO_TAP_SEND));
+  CHECK(!exportAudioTap(AUDIO_TAP_COUNT, exportSink, &none));
+}
+
+// Exports taken while adc_capture_task writes on another core. Each write is
+// one chunk of a single value, the chunk number; writes that land while the
+// tap is paused are dropped. Every export must be whole chunks in order (the
+// oldest cut by the ring edge) matching the total in its own metadata.
+static const uint32_t SNAPSHOT_CHUNK = 160;
+
+static bool wholeChunks(const Wav& w, uint32_t capacity) {
+  uint32_t total = commentField(w.comment, "total");
+  size_t n = w.samples.size();
+  if (!w.valid || n == 0 || total % SNAPSHOT_CHUNK != 0 || n != std::min(total, capacity)) return false;
+  size_t run = 1;
+  bool first = true;
+  for (size_t i = 1; i <= n; i++) {
+    if (i < n && w.samples[i] == w.samples[i - 1]) {
+      run++;
+      continue;
+    }
+    size_t expected = (first && n % SNAPSHOT_CHUNK) ? n % SNAPSHOT_CHUNK : SNAPSHOT_CHUNK;
+    if (run != expected) return false;
+    if (i < n && (int16_t)(w.samples[i] - w.samples[i - 1]) <= 0) return false;
+    run = 1;
+    first = false;
+  }
+  return true;
+}
+
+static void testSnapshotWhileWriting() {
+  CHECK(enableAudioTaps(1u << AUDIO_TAP_CAPTURE));
+  const uint32_t capacity = getAudioTapInfo(AUDIO_TAP_CAPTURE).capacity;
+  std::atomic<bool> done(false);
+  std::atomic<uint32_t> chunks(0);
+  std::thread stage([&] {
+    hostCoreId = 0;
+    int16_t pcm[SNAPSHOT_CHUNK];
+    while (!done.load()) {
+      std::fill(pcm, pcm + SNAPSHOT_CHUNK, (int16_t)(chunks.load() + 1));
+      audioTapWrite(AUDIO_TAP_CAPTURE, pcm, sizeof(pcm));
+      chunks++;
+    }
+  });
+
+  while (chunks.load() == 0) std::this_thread::yield();
+  int exports = 0, consistent = 0, partial = 0;
+  for (; exports < 200; exports++) {
+    Wav w = exportTap(AUDIO_TAP_CAPTURE);
+    if (wholeChunks(w, capacity)) consistent++;
+    if (w.samples.size() < capacity) partial++;
+  }
+  done = true;
+  stage.join();
+  CHECK(consistent == exports);
+  CHECK(audioTapEnabled(AUDIO_TAP_CAPTURE));
+  printf("BENCH tap snapshots: %d exports while writing, %d before the ring filled, %u chunks written\n",
+         exports, partial, chunks.load());
+}
+
+// =============================================================================
+// SAVE
+// =============================================================================
+
+static void testSave() {
+  CHECK(enableAudioTaps((1u << AUDIO_TAP_CAPTURE) | (1u << AUDIO_TAP_SEND)));
+  uint32_t next = 0;
+  writeRamp(AUDIO_TAP_CAPTURE, next, 20000);
+  Export e;
+  exportTap(AUDIO_TAP_CAPTURE, &e);
+
+  std::string log;
+  Serial.capture = &log;
+  CHECK(saveAudioTap(AUDIO_TAP_CAPTURE));
+  CHECK(SPIFFS.files.count("/tap_capture.wav") && SPIFFS.files["/tap_capture.wav"] == e.bytes);
+  CHECK(log.find("Saved /tap_capture.wav") != std::string::npos);
+  CHECK(saveAudioTap(AUDIO_TAP_CAPTURE));                 // Replaces the old copy
+  CHECK(SPIFFS.files.size() == 1 && SPIFFS.files["/tap_capture.wav"] == e.bytes);
+
+  CHECK(!saveAudioTap(AUDIO_TAP_PLAYBACK));               // Not armed
+  CHECK(log.find("Audio tap playback is not armed") != std::string::npos);
+
+  // Not enough room: refused before anything is written
+  SPIFFS.capacity = SPIFFS.usedBytes() + 1000;
+  writeRamp(AUDIO_TAP_SEND, next, 4000);
+  CHECK(!saveAudioTap(AUDIO_TAP_SEND));
+  CHECK(SPIFFS.files.count("/tap_send.wav") == 0);
+  CHECK(log.find("bytes needed for /tap_send.wav") != std::string::npos);
+  SPIFFS.capacity = 1400 * 1024;
+
+  // Flash full part way: the partial file is removed
+  SPIFFS.failAfter = 3000;
+  CHECK(!saveAudioTap(AUDIO_TAP_SEND));
+  CHECK(SPIFFS.files.count("/tap_send.wav") == 0);
+  CHECK(log.find("Failed to write /tap_send.wav") != std::string::npos);
+  CHECK(audioTapEnabled(AUDIO_TAP_SEND));
+  SPIFFS.failAfter = (size_t)-1;
+  Serial.capture = nullptr;
+}
+
+// =============================================================================
+// TAP_DIFF FIXTURE
+// =============================================================================
+
+static bool fileSink(void* context, const uint8_t* data, size_t length) {
+  return fwrite(data, 1, length, static_cast<FILE*>(context)) == length;
+}
+
+// Band-limited noise through the three taps, one 100-sample step per 6.25 ms:
+//   send      the stream 700 samples late, stopped 2000 samples early
+//   playback  the stream at half level, 1033 samples late, to the end
+// so tap_diff.py should find capture -> send at +2700 and send -> playback
+// at -1667, neither a multiple of the coarse search step
+static void writeTapDiffFixture() {
+  const int STEP = 100, STEPS = 120, SEND_LAG = 700, SEND_STOP = 20, PLAYBACK_LAG = 1033;
+  std::vector<int16_t> stream(STEP * STEPS);
+  uint32_t state = 12345;
+  float level = 0;
+  for (size_t i = 0; i < stream.size(); i++) {
+    state = state * 1664525u + 1013904223u;
+    level = 0.9f * level + (float)((int32_t)(state >> 16) - 32768) * 0.1f;
+    stream[i] = (int16_t)constrain((int)(level * 2.0f), -32767, 32767);
+  }
+
+  CHECK(enableAudioTaps(AUDIO_TAP_ALL));
+  int16_t half[STEP];
+  for (int k = 0; k < STEPS; k++) {
+    simUs += STEP * 1000000ull / AUDIO_TAP_SAMPLE_RATE;
+    int at = k * STEP;
+    audioTapWrite(AUDIO_TAP_CAPTURE, &stream[at], STEP * sizeof(int16_t));
+    if (at >= SEND_LAG && k < STEPS - SEND_STOP) {
+      audioTapWrite(AUDIO_TAP_SEND, &stream[at - SEND_LAG], STEP * sizeof(int16_t));
+    }
+    if (at >= PLAYBACK_LAG) {
+      for (int i = 0; i < STEP; i++) half[i] = (int16_t)lroundf(stream[at - PLAYBACK_LAG + i] * 0.5f);
+      audioTapWrite(AUDIO_TAP_PLAYBACK, half, sizeof(half));
+    }
+  }
+
+  for (int i = 0; i < AUDIO_TAP_COUNT; i++) {
+    char path[32];
+    snprintf(path, sizeof(path), "tap_%s.wav", getAudioTapName((AudioTapPoint)i));
+    FILE* f = fopen(path, "wb");
+    CHECK(f != nullptr);
+    if (!f) return;
+    CHECK(exportAudioTap((AudioTapPoint)i, fileSink, f));
+    fclose(f);
+  }
+  FILE* f = fopen("tap_expected.txt", "w");
+  CHECK(f != nullptr);
+  if (!f) return;
+  fprintf(f, "capture send %d 1.000\n", SEND_STOP * STEP + SEND_LAG);
+  fprintf(f, "send playback %d 0.500\n", PLAYBACK_LAG - SEND_LAG - SEND_STOP * STEP);
+  fclose(f);
+  enableAudioTaps(0);
+}
+
+int main() {
+  testArming();
+  testRing();
+  testExport();
+  testSnapshotWhileWriting();
+  testSave();
+  writeTapDiffFixture();
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
@@ -0,0 +1,4 @@
+#pragma once
+// NTP state is set by the test
+extern bool hostTimeSynced;
+inline bool isTimeSynced() { return hostTimeSynced; }
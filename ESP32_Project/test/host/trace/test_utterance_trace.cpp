@@ -0,0 +1,213 @@
+// Utterance trace ring: replays a recorded utterance through the ring and
+// checks the dump format scripts/trace_export.py reads, ring wraparound,
+// 32-bit timestamp wrap, and per-stage totals. Writes the dumps to
+// trace_dump.log for the exporter check that runs after this test.
+#include <utterance_trace.h>
+#include <string>
+#include <vector>
+
+bool hostTimeSynced = false;
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (testFailures < 20) printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+struct DumpedEvent {
+  uint32_t utt, ts, dur, arg;
+  char span[16];
+  char ph;
+};
+
+struct Dump {
+  bool synced = false;
+  uint32_t syncUtt = 0;
+  long long devUs = 0, epochMs = 0;
+  std::vector<DumpedEvent> events;
+  int badLines = 0;
+};
+
+static std::string dumpLog;
+
+// Parses exactly the two line shapes documented in utterance_trace.h
+static Dump dump(uint32_t utterance) {
+  std::string text;
+  Serial.capture = &text;
+  dumpUtteranceTrace(utterance);
+  Serial.capture = nullptr;
+  dumpLog += text;
+
+  Dump out;
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t end = text.find('\n', pos);
+    std::string line = text.substr(pos, end - pos);
+    pos = end + 1;
+    DumpedEvent e = {};
+    int consumed = 0;
+    if (sscanf(line.c_str(), "[TRACE][SYNC] {\"utt\":%u,\"dev_us\":%lld,\"epoch_ms\":%lld}%n",
+               &out.syncUtt, &out.devUs, &out.epochMs, &consumed) == 3 && consumed == (int)line.size()) {
+      CHECK(out.events.empty());   // SYNC comes first
+      out.synced = true;
+    } else if (sscanf(line.c_str(), "[TRACE][EVT] {\"utt\":%u,\"span\":\"%15[a-z_]\",\"ph\":\"%c\",\"ts\":%u,\"dur\":%u,\"arg\":%u}%n",
+                      &e.utt, e.span, &e.ph, &e.ts, &e.dur, &e.arg, &consumed) == 6 && consumed == (int)line.size()) {
+      out.events.push_back(e);
+    } else {
+      out.badLines++;
+    }
+  }
+  return out;
+}
+
+// One push-to-talk turn: per chunk capture → encode → send, then the reply
+static uint32_t replayUtterance(int chunks, uint32_t chunkUs) {
+  uint32_t id = beginUtteranceTrace();
+  for (int i = 0; i < chunks; i++) {
+    uint32_t start = traceNow();
+    simUs += chunkUs;
+    traceComplete(TRACE_SPAN_CAPTURE, start, traceArg(i));
+    start = traceNow();
+    simUs += 900;
+    traceComplete(TRACE_SPAN_ENCODE, start, traceArg(4096));
+    start = traceNow();
+    simUs += 2500;
+    traceComplete(TRACE_SPAN_SEND, start, traceArg(5500));
+  }
+  traceInstant(TRACE_SPAN_AUDIO_END);
+  simUs += 850000;   // Network + server
+  traceInstant(TRACE_SPAN_RESPONSE, traceArg(70000));
+  {
+    TraceScope decode(TRACE_SPAN_DECODE);
+    simUs += 4000;
+  }
+  {
+    TraceScope playback(TRACE_SPAN_PLAYBACK);
+    simUs += 1500000;
+  }
+  endUtteranceTrace();
+  return id;
+}
+
+static void testReplayFormat() {
+  clearUtteranceTrace();
+  hostTimeSynced = true;
+  uint32_t id = replayUtterance(10, 128000);
+  CHECK(id != 0 && getCurrentUtteranceId() == 0);
+
+  Dump d = dump(id);
+  CHECK(d.badLines == 0);
+  CHECK(d.synced && d.syncUtt == id && d.epochMs > 0);
+  // begin instant, 3 spans per chunk, audio_end, response, decode, playback, utterance
+  CHECK(d.events.size() == 1 + 3 * 10 + 5);
+  CHECK(d.events.size() == getTraceEventCount());
+
+  uint32_t previousEnd = 0;
+  int captures = 0;
+  for (const DumpedEvent& e : d.events) {
+    CHECK(e.utt == id);
+    CHECK(e.ph == 'X' || e.ph == 'i');
+    CHECK(e.ph == 'X' || e.dur == 0);
+    if (strcmp(e.span, "utterance") != 0) {
+      CHECK(e.ts >= previousEnd);   // Stages follow each other
+      previousEnd = e.ts + e.dur;
+    }
+    if (strcmp(e.span, "capture") == 0) {
+      CHECK(e.dur == 128000 && e.arg == (uint32_t)captures);
+      captures++;
+    }
+    if (strcmp(e.span, "response") == 0) CHECK(e.arg == UINT16_MAX);   // Saturated
+    if (strcmp(e.span, "playback") == 0) CHECK(e.dur == 1500000);
+  }
+  CHECK(captures == 10);
+  const DumpedEvent& whole = d.events.back();
+  CHECK(strcmp(whole.span, "utterance") == 0 && whole.ph == 'X');
+  CHECK(whole.ts == (uint32_t)d.devUs && whole.dur == previousEnd - whole.ts);
+
+  // Stage totals of the latest utterance
+  TraceStageStats stats[TRACE_SPAN_COUNT];
+  CHECK(getTraceStageStats(stats) == id);
+  CHECK(stats[TRACE_SPAN_CAPTURE].count == 10 && stats[TRACE_SPAN_CAPTURE].totalUs == 1280000);
+  CHECK(stats[TRACE_SPAN_SEND].maxUs == 2500);
+  CHECK(stats[TRACE_SPAN_AUDIO_END].count == 0);   // Instants carry no duration
+
+  // Nothing is recorded outside an utterance
+  traceInstant(TRACE_SPAN_RESPONSE);
+  CHECK(getTraceEventCount() == d.events.size());
+}
+
+// More events than the ring holds: the oldest are overwritten, order kept
+static void testWraparound() {
+  clearUtteranceTrace();
+  hostTimeSynced = false;
+  const int chunks = 120;   // 1 + 360 + 5 events into 256 slots
+  uint32_t id = replayUtterance(chunks, 32000);
+  CHECK(getTraceEventCount() == TRACE_RING_CAPACITY);
+
+  Dump d = dump(id);
+  CHECK(d.badLines == 0);
+  CHECK(d.synced && d.epochMs == 0);   // No NTP: exporter starts the timeline at zero
+  CHECK(d.events.size() == TRACE_RING_CAPACITY);
+  const int total = 1 + 3 * chunks + 5;
+  const int dropped = total - TRACE_RING_CAPACITY;
+  // The first surviving capture is the one the overwrite stopped at
+  int expectedChunk = (dropped - 1) / 3 + ((dropped - 1) % 3 == 0 ? 0 : 1);
+  for (const DumpedEvent& e : d.events) {
+    if (strcmp(e.span, "capture") == 0) {
+      CHECK(e.arg == (uint32_t)expectedChunk);
+      expectedChunk++;
+    }
+  }
+  CHECK(expectedChunk == chunks);
+  CHECK(strcmp(d.events.front().span, "utterance") != 0 || d.events.front().ph == 'X');
+  CHECK(strcmp(d.events.back().span, "utterance") == 0);
+
+  // A second utterance overwrites the first one's oldest events only
+  uint32_t next = replayUtterance(4, 32000);
+  CHECK(next != id);
+  Dump first = dump(id);
+  Dump second = dump(next);
+  CHECK(first.events.size() == TRACE_RING_CAPACITY - second.events.size());
+  CHECK(!first.synced);   // Only the latest utterance keeps its anchor
+  CHECK(second.synced && second.events.size() == 1 + 3 * 4 + 5);
+}
+
+// Event timestamps are the low 32 bits; the SYNC anchor carries the rest
+static void testTimestampWrap() {
+  clearUtteranceTrace();
+  hostTimeSynced = false;
+  simUs = (1ULL << 32) - 200000;   // 71.6 minutes after boot
+  uint32_t id = replayUtterance(3, 128000);
+  Dump d = dump(id);
+  CHECK(d.badLines == 0);
+  CHECK(d.devUs == (long long)(1ULL << 32) - 200000);
+  bool wrapped = false;
+  uint32_t previous = d.events.front().ts;
+  for (const DumpedEvent& e : d.events) {
+    if (e.ts < previous) wrapped = true;
+    previous = e.ts;
+    // Unwrapped the way trace_export.py does it
+    long long delta = (long long)((e.ts - (uint32_t)d.devUs + (1ULL << 31)) % (1ULL << 32)) - (1LL << 31);
+    CHECK(delta >= 0 && delta < 10000000);
+  }
+  CHECK(wrapped);
+}
+
+int main() {
+  testReplayFormat();
+  testWraparound();
+  testTimestampWrap();
+
+  FILE* f = fopen("trace_dump.log", "w");
+  if (f) {
+    fputs(dumpLog.c_str(), f);
+    fclose(f);
+  }
+  printf("BENCH ring %d events x %zu bytes = %zu bytes\n", TRACE_RING_CAPACITY, sizeof(TraceEvent),
+         TRACE_RING_CAPACITY * sizeof(TraceEvent));
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
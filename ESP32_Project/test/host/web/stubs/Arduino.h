@@ -0,0 +1,52 @@
+#pragma once
+// Arduino core stand-in for the web host test: String allocations go
+// through a heap counter so per-request heap use can be measured
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <algorithm>
+using std::min;
+#define PROGMEM
+#define PGM_P const char*
+#define F(s) s
+// Heap accounting for everything the handlers allocate (all of it is String)
+struct HeapStats { long live = 0, peak = 0, allocs = 0, bytes = 0; };
+extern HeapStats heap;
+inline void* trackRealloc(void* p, size_t oldSize, size_t size) {
+  heap.allocs++; heap.bytes += size;
+  // realloc may move: old and new blocks both live for a moment
+  if (heap.live + (long)size > heap.peak) heap.peak = heap.live + size;
+  heap.live += (long)size - (long)oldSize;
+  return realloc(p, size);
+}
+inline void trackFree(void* p, size_t size) { if (p) { heap.live -= size; free(p); } }
+// Arduino String: grows to the exact length on every concat, as the core does
+class String {
+  char* buf = nullptr; size_t len = 0, cap = 0;
+  void reserve(size_t n) { if (buf && cap >= n) return; buf = (char*)trackRealloc(buf, buf ? cap + 1 : 0, n + 1); cap = n; if (!len) buf[0] = 0; }
+  void cat(const char* s, size_t n) { reserve(len + n); memcpy(buf + len, s, n); len += n; buf[len] = 0; }
+public:
+  String() {}
+  String(const char* s) { if (s) cat(s, strlen(s)); }
+  String(const String& o) { if (o.len) cat(o.buf, o.len); }
+  explicit String(long v) { char t[16]; snprintf(t, 16, "%ld", v); cat(t, strlen(t)); }
+  explicit String(int v) : String((long)v) {}
+  explicit String(unsigned v) : String((long)v) {}
+  explicit String(size_t v) : String((long)v) {}
+  explicit String(char c) { cat(&c, 1); }
+  ~String() { trackFree(buf, cap + 1); }
+  String& operator=(const String& o) { if (this != &o) { len = 0; if (buf) buf[0] = 0; if (o.len) cat(o.buf, o.len); } return *this; }
+  String& operator=(const char* s) { len = 0; if (buf) buf[0] = 0; cat(s, strlen(s)); return *this; }
+  String& operator+=(const String& o) { cat(o.buf ? o.buf : "", o.len); return *this; }
+  String& operator+=(const char* s) { cat(s, strlen(s)); return *this; }
+  String& operator+=(char c) { cat(&c, 1); return *this; }
+  friend String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+  friend String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+  friend String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+  friend String operator+(const String& a, char b) { String r(a); r += b; return r; }
+  bool operator==(const char* s) const { return strcmp(c_str(), s) == 0; }
+  const char* c_str() const { return buf ? buf : ""; }
+  size_t length() const { return len; }
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <Arduino.h>
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+// Models arduino-esp32 2.x WebServer response assembly (header Strings included)
+class WebServer {
+public:
+  size_t wireBytes = 0, contentLength = CONTENT_LENGTH_NOT_SET; bool chunked = false;
+  String responseHeaders, requestEtag; int lastCode = 0;
+  std::string body;
+  void write(const char* d, size_t n) { wireBytes += n; body.append(d, n); }
+  void collectHeaders(const char**, size_t) {}
+  String header(const char*) { return requestEtag; }
+  void setContentLength(size_t n) { contentLength = n; }
+  void sendHeader(const String& name, const String& value, bool first = false) {
+    String line = name; line += ": "; line += value; line += "\r\n";
+    if (first) responseHeaders = line + responseHeaders; else responseHeaders += line;
+  }
+  void prepareHeader(String& response, int code, const char* type, size_t length) {
+    response = String("HTTP/1.") + String(1) + ' ' + String(code) + ' ' + "OK" + "\r\n";
+    sendHeader(String("Content-Type"), String(type ? type : "text/html"), true);
+    if (contentLength == CONTENT_LENGTH_NOT_SET) sendHeader(String("Content-Length"), String(length));
+    else if (contentLength == CONTENT_LENGTH_UNKNOWN) { chunked = true; sendHeader(String("Accept-Ranges"), String("none")); sendHeader(String("Transfer-Encoding"), String("chunked")); }
+    sendHeader(String("Connection"), String("close"));
+    response += responseHeaders; response += "\r\n"; responseHeaders = "";
+    lastCode = code;
+  }
+  void send(int code, const char* type = nullptr, const String& content = String()) {
+    String header; prepareHeader(header, code, type, content.length());
+    write(header.c_str(), header.length());
+    if (content.length()) sendContent(content.c_str(), content.length());
+  }
+  void send_P(int code, PGM_P type, PGM_P content, size_t length) {
+    String header; char t[64]; strncpy(t, type, 63); t[63] = 0;
+    prepareHeader(header, code, t, length);
+    write(header.c_str(), header.length());
+    write(content, length);
+  }
+  void sendContent(const char* d, size_t n) {
+    if (chunked) { char c[11]; snprintf(c, 11, "%zx\r\n", n); write(c, strlen(c)); }
+    write(d, n); if (chunked) write("\r\n", 2);
+    if (chunked && n == 0) chunked = false;
+  }
+  void sendContent(const char* d) { sendContent(d, strlen(d)); }
+};
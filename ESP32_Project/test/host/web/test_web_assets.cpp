@@ -0,0 +1,103 @@
+// Web assets through a WebServer model: gzip pages straight from flash,
+// ETag revalidation, 404s, and what one request costs in heap
+#include <web_assets.h>
+#include <chrono>
+#include <string>
+#include <zlib.h>
+
+HeapStats heap;
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+static std::string responseHeaders(const WebServer& server) {
+  return server.body.substr(0, server.body.find("\r\n\r\n") + 4);
+}
+
+static std::string gunzip(const std::string& gz) {
+  std::string out(256 * 1024, 0);
+  z_stream z = {};
+  inflateInit2(&z, 31);
+  z.next_in = (Bytef*)gz.data();
+  z.avail_in = gz.size();
+  z.next_out = (Bytef*)&out[0];
+  z.avail_out = out.size();
+  int rc = inflate(&z, Z_FINISH);
+  out.resize(rc == Z_STREAM_END ? z.total_out : 0);
+  inflateEnd(&z);
+  return out;
+}
+
+// One request through the handler: heap peak, allocations, leak, host time
+static void measure(const char* name, const char* asset, const char* etag) {
+  const int runs = 2000;
+  double us = 0;
+  long peak = 0, allocs = 0;
+  size_t wire = 0;
+  for (int i = 0; i < runs; i++) {
+    heap = HeapStats();
+    {
+      WebServer server;
+      server.requestEtag = etag;
+      auto start = std::chrono::steady_clock::now();
+      sendWebAsset(server, asset);
+      us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      wire = server.wireBytes;
+    }
+    peak = heap.peak;
+    allocs = heap.allocs;
+    CHECK(heap.live == 0);
+  }
+  CHECK(peak < 1024);   // Response headers only, never the page
+  printf("BENCH %-20s peak heap %5ld B  allocations %3ld  wire %5zu B  host %6.2f us\n", name, peak, allocs, wire,
+         us / runs);
+}
+
+int main() {
+  for (const char* name : {"portal.html", "ota.html"}) {
+    const WebAsset* asset = findWebAsset(name);
+    CHECK(asset != nullptr);
+    if (asset == nullptr) continue;
+
+    WebServer server;
+    CHECK(sendWebAsset(server, name));
+    CHECK(server.lastCode == 200);
+    std::string headers = responseHeaders(server);
+    CHECK(headers.find("Content-Encoding: gzip\r\n") != std::string::npos);
+    CHECK(headers.find(std::string("ETag: ") + asset->etag + "\r\n") != std::string::npos);
+    CHECK(headers.find("Cache-Control: " WEB_ASSET_CACHE_CONTROL "\r\n") != std::string::npos);
+    CHECK(headers.find("Content-Length: " + std::to_string(asset->length) + "\r\n") != std::string::npos);
+    std::string body = server.body.substr(headers.size());
+    CHECK(body.size() == asset->length);
+    std::string page = gunzip(body);
+    CHECK(page.find("<html") != std::string::npos && page.find("</html>") != std::string::npos);
+
+    // Revalidation: matching ETag gets an empty 304, a stale one the page
+    WebServer cached;
+    cached.requestEtag = asset->etag;
+    CHECK(sendWebAsset(cached, name));
+    CHECK(cached.lastCode == 304);
+    CHECK(cached.body.size() == responseHeaders(cached).size());
+    WebServer stale;
+    stale.requestEtag = "\"0000000000000000\"";
+    sendWebAsset(stale, name);
+    CHECK(stale.lastCode == 200);
+
+    measure(name, name, "");
+    measure((std::string(name) + " 304").c_str(), name, asset->etag);
+  }
+
+  WebServer missing;
+  CHECK(!sendWebAsset(missing, "missing.html"));
+  CHECK(missing.lastCode == 404);
+  CHECK(findWebAsset("portal.htm") == nullptr);
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
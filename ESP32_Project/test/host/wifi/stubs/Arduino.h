@@ -0,0 +1,27 @@
+#pragma once
+// Arduino core stand-in for the WiFi host test: simulated clock
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdarg>
+#include <algorithm>
+
+extern uint32_t simMs;
+inline uint32_t millis() { return simMs; }
+
+struct SerialStub {
+  bool verbose = false;
+  void println(const char* s) { if (verbose) puts(s); }
+  void printf(const char* f, ...) { if (!verbose) return; va_list a; va_start(a, f); vprintf(f, a); va_end(a); }
+};
+extern SerialStub Serial;
+
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t length = strlen(src);
+  if (size) {
+    size_t n = std::min(length, size - 1);
+    memcpy(dst, src, n);
+    dst[n] = 0;
+  }
+  return length;
+}
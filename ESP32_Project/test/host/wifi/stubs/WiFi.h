@@ -0,0 +1,52 @@
+#pragma once
+// Simulated radio: a scan takes scanMs of simulated time and returns what is on the air
+#include <Arduino.h>
+#include <vector>
+
+typedef enum { WIFI_AUTH_OPEN, WIFI_AUTH_WEP, WIFI_AUTH_WPA_PSK, WIFI_AUTH_WPA2_PSK } wifi_auth_mode_t;
+typedef struct {
+  uint8_t ssid[33];
+  uint8_t primary;
+  int8_t rssi;
+  wifi_auth_mode_t authmode;
+} wifi_ap_record_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+struct WiFiStub {
+  std::vector<wifi_ap_record_t> air, results;
+  uint32_t scanMs = 2600, doneAt = 0;
+  bool running = false;
+  bool failNext = false;   // Next scan fails to start
+  bool hang = false;       // Running scans never complete
+  int scans = 0, stops = 0;
+
+  int16_t scanNetworks(bool async = false, bool = false, bool = false, uint32_t = 300) {
+    scans++;
+    if (failNext) {
+      failNext = false;
+      return WIFI_SCAN_FAILED;
+    }
+    results.clear();
+    running = true;
+    doneAt = simMs + scanMs;
+    if (!async) {
+      simMs = doneAt;
+      running = false;
+      results = air;
+      return results.size();
+    }
+    return WIFI_SCAN_RUNNING;
+  }
+  int16_t scanComplete() {
+    if (running && !hang && simMs >= doneAt) {
+      running = false;
+      results = air;
+    }
+    return running ? WIFI_SCAN_RUNNING : (int16_t)results.size();
+  }
+  void* getScanInfoByIndex(int i) { return i < (int)results.size() ? &results[i] : nullptr; }
+  void scanDelete() { results.clear(); }
+};
+extern WiFiStub WiFi;
@@ -0,0 +1,7 @@
+#pragma once
+#include <WiFi.h>
+inline int esp_wifi_scan_stop() {
+  WiFi.running = false;
+  WiFi.stops++;
+  return 0;
+}
@@ -0,0 +1,154 @@
+// WiFi scan cache on a simulated radio: how long /scan keeps the portal
+// blocked, result shaping, stale-while-revalidate, retries and timeouts
+#include <wifi_scan_cache.h>
+#include <chrono>
+
+uint32_t simMs = 1000;
+SerialStub Serial;
+WiFiStub WiFi;
+static int testFailures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+      testFailures++;                                                 \
+    }                                                                 \
+  } while (0)
+
+static wifi_ap_record_t accessPoint(const char* ssid, int8_t rssi, uint8_t channel = 6) {
+  wifi_ap_record_t record = {};
+  strlcpy((char*)record.ssid, ssid, sizeof(record.ssid));
+  record.rssi = rssi;
+  record.primary = channel;
+  record.authmode = WIFI_AUTH_WPA2_PSK;
+  return record;
+}
+
+// Portal loop: updateWifiScanCache() every 10 ms of simulated time
+static void runFor(uint32_t ms) {
+  for (uint32_t end = simMs + ms; simMs < end; simMs += 10) {
+    updateWifiScanCache();
+  }
+}
+
+// The page polls /scan every 3 s; reports how long each request held the loop
+template <typename F>
+static uint32_t measure(const char* name, F handler) {
+  const int polls = 40;
+  uint32_t worstMs = 0;
+  double totalUs = 0;
+  WiFi.scans = 0;
+  for (int i = 0; i < polls; i++) {
+    uint32_t simStart = simMs;
+    auto start = std::chrono::steady_clock::now();
+    handler();
+    totalUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    worstMs = std::max(worstMs, simMs - simStart);
+    runFor(3000);
+  }
+  printf("BENCH %-26s worst %5u ms blocked, host %.2f us avg, %d scans\n", name, worstMs, totalUs / polls, WiFi.scans);
+  return worstMs;
+}
+
+int main() {
+  // Duplicates (mesh), a hidden network, more networks than fit
+  WiFi.air.push_back(accessPoint("Home", -70, 1));
+  WiFi.air.push_back(accessPoint("Home", -48, 11));
+  WiFi.air.push_back(accessPoint("", -30));
+  WiFi.air.push_back(accessPoint("Cafe", -80));
+  WiFi.air.push_back(accessPoint("Home", -60, 6));
+  for (int i = 0; i < 30; i++) {
+    char ssid[16];
+    snprintf(ssid, sizeof(ssid), "Net%02d", i);
+    WiFi.air.push_back(accessPoint(ssid, -90 + i));
+  }
+
+  // The handler this replaced scanned inside the request
+  uint32_t blockingMs = measure("blocking scan per /scan", [] { WiFi.scanNetworks(); });
+  beginWifiScanCache();
+  uint32_t cachedMs = measure("cached /scan", [] { getWifiScanResults(); });
+  CHECK(blockingMs >= WiFi.scanMs);
+  CHECK(cachedMs == 0);
+
+  // Deduplicated, hidden dropped, strongest kept, sorted, capped
+  WifiScanSnapshot snapshot = getWifiScanResults();
+  CHECK(snapshot.valid && snapshot.count == WIFI_SCAN_MAX_RESULTS);
+  CHECK(strcmp(snapshot.entries[0].ssid, "Home") == 0);
+  CHECK(snapshot.entries[0].rssi == -48 && snapshot.entries[0].channel == 11);
+  int homes = 0;
+  for (int i = 0; i < snapshot.count; i++) {
+    homes += strcmp(snapshot.entries[i].ssid, "Home") == 0;
+    CHECK(snapshot.entries[i].ssid[0] != 0);
+    if (i > 0) CHECK(snapshot.entries[i - 1].rssi >= snapshot.entries[i].rssi);
+  }
+  CHECK(homes == 1);
+  CHECK(strcmp(snapshot.entries[snapshot.count - 1].ssid, "Net11") == 0);   // Home + the 19 strongest NetXX
+
+  // Stale results are served at once and start a rescan
+  stopWifiScanCache();
+  simMs += 100000;
+  beginWifiScanCache();
+  runFor(3000);
+  simMs += WIFI_SCAN_FRESH_MS;
+  snapshot = getWifiScanResults();
+  CHECK(snapshot.valid && snapshot.stale && snapshot.scanning && snapshot.count > 0);
+  CHECK(snapshot.ageMs >= WIFI_SCAN_FRESH_MS);
+  int before = WiFi.scans;
+  runFor(20);
+  CHECK(WiFi.scans == before + 1);
+  snapshot = getWifiScanResults();
+  CHECK(snapshot.stale && snapshot.scanning && snapshot.count > 0);   // Still served during the scan
+  runFor(3000);
+  snapshot = getWifiScanResults();
+  CHECK(!snapshot.stale && !snapshot.scanning && snapshot.ageMs < 1000);
+
+  // Fresh results: requests do not rescan
+  before = WiFi.scans;
+  for (int i = 0; i < 20; i++) {
+    getWifiScanResults();
+    runFor(100);
+  }
+  CHECK(WiFi.scans == before);
+
+  // Background rescan after the interval without any request
+  before = WiFi.scans;
+  runFor(WIFI_SCAN_INTERVAL_MS + 3000);
+  CHECK(WiFi.scans == before + 1);
+
+  // A failed scan is retried after the gap, not in a tight loop
+  simMs += WIFI_SCAN_FRESH_MS;
+  WiFi.failNext = true;
+  getWifiScanResults();
+  before = WiFi.scans;
+  runFor(WIFI_SCAN_RETRY_MS - 100);
+  CHECK(WiFi.scans == before + 1);
+  runFor(3500);
+  CHECK(WiFi.scans == before + 2);
+
+  // A hung scan is abandoned after the timeout; the old results survive
+  WiFi.hang = true;
+  simMs += WIFI_SCAN_FRESH_MS;
+  getWifiScanResults();
+  runFor(WIFI_SCAN_TIMEOUT_MS + 100);
+  CHECK(WiFi.stops >= 1);
+  WiFi.hang = false;
+  snapshot = getWifiScanResults();
+  CHECK(snapshot.valid && snapshot.count > 0);
+
+  // No scans once the portal closes
+  stopWifiScanCache();
+  before = WiFi.scans;
+  runFor(WIFI_SCAN_INTERVAL_MS * 2);
+  getWifiScanResults();
+  runFor(1000);
+  CHECK(WiFi.scans == before);
+
+  // Reopened portal: old results kept, a rescan reported before the loop runs
+  beginWifiScanCache();
+  snapshot = getWifiScanResults();
+  CHECK(snapshot.scanning && snapshot.valid && snapshot.stale);
+
+  printf("%s (%d failures)\n", testFailures ? "FAILED" : "PASSED", testFailures);
+  return testFailures ? 1 : 0;
+}
@@ -19,6 +19,8 @@ import uuid
 import re
 import base64
 import io
+import time
+from contextlib import contextmanager
 from datetime import datetime
 import os
 import wave
@@ -101,6 +103,7 @@ class ESP32Session:
     current_audio_session: Optional[str] = None
     last_seq: int = 0
     resume_store: Optional[Any] = None
+    current_utterance_id: Optional[int] = None
 
     def update_activity(self) -> None:
         """Update last activity timestamp."""
@@ -138,6 +141,54 @@ class AudioSession:
     is_complete: bool = False
 
 
+class UtteranceSpanWriter:
+    """
+    Server-side latency spans keyed by the device's utterance_id.
+
+    Appends one JSON line per span ({"utterance_id", "name", "ts_ms",
+    "dur_ms"}, epoch milliseconds) for ESP32_Project/scripts/trace_export.py,
+    which joins them with the device's [TRACE] serial dump (-s option).
+    Disabled unless a path is configured (ESP32_TRACE_FILE).
+    """
+
+    def __init__(self, path: Optional[str]):
+        self.path = path or None
+        self.logger = logging.getLogger(__name__)
+
+    def record(
+        self, utterance_id: Optional[int], name: str, start_ms: float, end_ms: Optional[float] = None
+    ) -> None:
+        """Append one span (instant when end_ms is None)."""
+        if self.path is None or utterance_id is None:
+            return
+        span = {"utterance_id": utterance_id, "name": name, "ts_ms": round(start_ms, 3)}
+        if end_ms is not None:
+            span["dur_ms"] = round(max(0.0, end_ms - start_ms), 3)
+        try:
+            with open(self.path, "a", encoding="utf-8") as f:
+                f.write(json.dumps(span) + "\n")
+        except OSError as e:
+            self.logger.warning(f"Trace span not written: {e}")
+            self.path = None
+
+    @contextmanager
+    def span(self, utterance_id: Optional[int], name: str):
+        """Record the enclosed block as one complete span, also when it raises."""
+        start_ms = time.time() * 1000.0
+        try:
+            yield
+        finally:
+            self.record(utterance_id, name, start_ms, time.time() * 1000.0)
+
+
+def parse_utterance_id(message_data: Dict[str, Any]) -> Optional[int]:
+    """Device correlation id (uint32, 0 = none) from an audio message."""
+    value = message_data.get("utterance_id") if isinstance(message_data, dict) else None
+    if isinstance(value, bool) or not isinstance(value, int) or not 0 < value <= 0xFFFFFFFF:
+        return None
+    return value
+
+
 class ESP32ChatServer:
     """
     Production ESP32 Chat Server.
@@ -194,6 +245,11 @@ class ESP32ChatServer:
             getattr(self.config, "ESP32_AUDIO_MAX_DURATION", 30)
         )  # seconds
 
+        # Utterance latency spans, joined with device traces offline
+        self.trace_spans = UtteranceSpanWriter(
+            getattr(self.config, "ESP32_TRACE_FILE", None) or os.getenv("ESP32_TRACE_FILE")
+        )
+
         # Background tasks (will be started when needed)
         self.cleanup_task: Optional[asyncio.Task] = None
         self._background_tasks_started = False
@@ -492,6 +548,8 @@ class ESP32ChatServer:
 
             self.audio_sessions[audio_session_id] = audio_session
             session.current_audio_session = audio_session_id
+            session.current_utterance_id = parse_utterance_id(message_data)
+            self.trace_spans.record(session.current_utterance_id, "audio_start", time.time() * 1000.0)
 
             # Initialize audio buffer
             if session.session_id not in self.audio_buffers:
@@ -612,6 +670,10 @@ class ESP32ChatServer:
         """Handle audio session end from ESP32."""
         try:
             audio_session_id = message_data.get("audio_session_id")
+            session.current_utterance_id = (
+                parse_utterance_id(message_data) or session.current_utterance_id
+            )
+            self.trace_spans.record(session.current_utterance_id, "audio_end", time.time() * 1000.0)
 
             if audio_session_id and audio_session_id in self.audio_sessions:
                 audio_session = self.audio_sessions[audio_session_id]
@@ -646,6 +708,8 @@ class ESP32ChatServer:
         """
         correlation_id = str(uuid.uuid4())
         start_time = datetime.now()
+        utterance_id = session.current_utterance_id
+        pipeline_start_ms = time.time() * 1000.0
 
         try:
             # Step 1: Combine audio chunks
@@ -728,9 +792,10 @@ class ESP32ChatServer:
                 return
 
             try:
-                stt_result = await self.stt_provider.transcribe(
-                    complete_audio, language="auto"
-                )
+                with self.trace_spans.span(utterance_id, "stt"):
+                    stt_result = await self.stt_provider.transcribe(
+                        complete_audio, language="auto"
+                    )
 
                 # Extract text from result
                 if hasattr(stt_result, "text"):
@@ -761,9 +826,10 @@ class ESP32ChatServer:
             # Step 4: Content safety check
             if self.safety_service:
                 try:
-                    is_safe = await self.safety_service.check_content(
-                        transcribed_text, session.child_age
-                    )
+                    with self.trace_spans.span(utterance_id, "safety"):
+                        is_safe = await self.safety_service.check_content(
+                            transcribed_text, session.child_age
+                        )
 
                     if not is_safe:
                         self.logger.warning(
@@ -793,13 +859,14 @@ class ESP32ChatServer:
                 child_preferences = None  # Could be loaded from database
 
                 # Generate AI response
-                ai_response = await self.ai_service.generate_safe_response(
-                    child_id=UUID(session.child_id),
-                    user_input=transcribed_text,
-                    child_age=session.child_age,
-                    preferences=child_preferences,
-                    conversation_context=None,  # Could include recent conversation
-                )
+                with self.trace_spans.span(utterance_id, "llm"):
+                    ai_response = await self.ai_service.generate_safe_response(
+                        child_id=UUID(session.child_id),
+                        user_input=transcribed_text,
+                        child_age=session.child_age,
+                        preferences=child_preferences,
+                        conversation_context=None,  # Could include recent conversation
+                    )
 
                 if not ai_response or not ai_response.content:
                     await self._send_fallback_response(session, "That's interesting! Tell me more!")
@@ -828,6 +895,7 @@ class ESP32ChatServer:
                 return
 
             try:
+                tts_start_ms = time.time() * 1000.0
                 # Convert response to speech
                 if hasattr(self.tts_service, 'convert_text_to_speech'):
                     # AudioService interface
@@ -907,8 +975,11 @@ class ESP32ChatServer:
                     await self._send_text_response(session, response_text)
                     return
 
+                self.trace_spans.record(utterance_id, "tts", tts_start_ms, time.time() * 1000.0)
+
                 # Step 7: Send audio response to ESP32 (PCM s16le @ 16k)
-                await self._send_audio_response(session, tts_audio, response_text, sample_rate=16000)
+                with self.trace_spans.span(utterance_id, "send"):
+                    await self._send_audio_response(session, tts_audio, response_text, sample_rate=16000)
 
                 processing_time = (datetime.now() - start_time).total_seconds()
 
@@ -948,6 +1019,9 @@ class ESP32ChatServer:
             # Reset current audio session
             session.current_audio_session = None
 
+            self.trace_spans.record(utterance_id, "server", pipeline_start_ms, time.time() * 1000.0)
+            session.current_utterance_id = None
+
     def _generate_mock_audio_placeholder(self) -> bytes:
         """Generate a minimal PCM payload suitable for mock pipelines."""
         # 0.1 seconds of silence @16kHz, 16-bit mono (even length for PCM)